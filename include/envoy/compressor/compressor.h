@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "envoy/buffer/buffer.h"
 
 namespace Envoy {
@@ -26,5 +29,28 @@ public:
   virtual void compress(Buffer::Instance& buffer, State state) PURE;
 };
 
+using CompressorPtr = std::unique_ptr<Compressor>;
+
+/**
+ * Creates compressors for a single content-coding, e.g. "gzip".
+ */
+class CompressorFactory {
+public:
+  virtual ~CompressorFactory() = default;
+
+  /**
+   * @return CompressorPtr a new compressor ready to compress one stream.
+   */
+  virtual CompressorPtr createCompressor() PURE;
+
+  /**
+   * @return const std::string& the content-coding token of the data produced by the compressors,
+   *         as sent in the content-encoding header and matched against accept-encoding values.
+   */
+  virtual const std::string& contentEncoding() const PURE;
+};
+
+using CompressorFactoryPtr = std::unique_ptr<CompressorFactory>;
+
 } // namespace Compressor
 } // namespace Envoy
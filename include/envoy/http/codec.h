@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/common/pure.h"
@@ -10,6 +12,8 @@
 #include "envoy/http/metadata_interface.h"
 #include "envoy/http/protocol.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Http {
 
@@ -250,6 +254,19 @@ struct Http2Settings {
   uint32_t max_inbound_priority_frames_per_stream_{DEFAULT_MAX_INBOUND_PRIORITY_FRAMES_PER_STREAM};
   uint32_t max_inbound_window_update_frames_per_data_frame_sent_{
       DEFAULT_MAX_INBOUND_WINDOW_UPDATE_FRAMES_PER_DATA_FRAME_SENT};
+  // Per direction overrides of hpack_table_size_.
+  absl::optional<uint32_t> encoder_hpack_table_size_;
+  absl::optional<uint32_t> decoder_hpack_table_size_;
+  // Lower case names of headers which are never added to the HPACK dynamic table. Shared by every
+  // connection created with these settings.
+  std::shared_ptr<const LowerCaseStrFlatHashSet> never_index_headers_;
+
+  uint32_t encoderHpackTableSize() const {
+    return encoder_hpack_table_size_.value_or(hpack_table_size_);
+  }
+  uint32_t decoderHpackTableSize() const {
+    return decoder_hpack_table_size_.value_or(hpack_table_size_);
+  }
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
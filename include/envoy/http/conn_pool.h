@@ -98,6 +98,14 @@ public:
    */
   virtual void drainConnections() PURE;
 
+  /**
+   * Establish connections ahead of demand, so that new streams do not have to wait for a
+   * connection handshake. At least one connection is established, and beyond that as many as are
+   * needed to cover the cluster's prefetch ratio. For example, this is used to warm pools for
+   * hosts that have just been added to a cluster.
+   */
+  virtual void prefetchConnections() PURE;
+
   /**
    * Determines whether the connection pool is actively processing any requests.
    * @return true if the connection pool has any pending requests or any active requests.
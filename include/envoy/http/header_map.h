@@ -15,6 +15,7 @@
 #include "common/common/hash.h"
 #include "common/common/macros.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -79,6 +80,37 @@ struct LowerCaseStringHash {
  */
 using LowerCaseStrUnorderedSet = std::unordered_set<LowerCaseString, LowerCaseStringHash>;
 
+/**
+ * Lower case string hasher and comparator which also accept string views of header keys, so that
+ * a header key can be looked up without being copied.
+ */
+struct LowerCaseStringViewHash {
+  using is_transparent = void;
+
+  size_t operator()(const LowerCaseString& value) const { return HashUtil::xxHash64(value.get()); }
+  size_t operator()(absl::string_view value) const { return HashUtil::xxHash64(value); }
+};
+
+struct LowerCaseStringViewEqual {
+  using is_transparent = void;
+
+  bool operator()(const LowerCaseString& lhs, const LowerCaseString& rhs) const {
+    return lhs == rhs;
+  }
+  bool operator()(const LowerCaseString& lhs, absl::string_view rhs) const {
+    return lhs.get() == rhs;
+  }
+  bool operator()(absl::string_view lhs, const LowerCaseString& rhs) const {
+    return lhs == rhs.get();
+  }
+};
+
+/**
+ * Convenient type for a hash set of lower case string which may be looked up by header key.
+ */
+using LowerCaseStrFlatHashSet =
+    absl::flat_hash_set<LowerCaseString, LowerCaseStringViewHash, LowerCaseStringViewEqual>;
+
 /**
  * Convenient type for a vector of lower case string and string pair.
  */
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/api/v2/core/base.pb.h"
@@ -464,6 +465,32 @@ public:
   virtual bool hedgeOnPerTryTimeout() const PURE;
 };
 
+/**
+ * Route level policy for collapsing identical requests which are in flight at the same time into
+ * a single upstream request.
+ */
+class CollapsedForwardingPolicy {
+public:
+  virtual ~CollapsedForwardingPolicy() = default;
+
+  /**
+   * @return bool whether identical requests are collapsed.
+   */
+  virtual bool enabled() const PURE;
+
+  /**
+   * @return the request headers which are part of the key identifying identical requests, in
+   *         addition to the method, :authority and :path.
+   */
+  virtual const std::vector<Http::LowerCaseString>& keyHeaders() const PURE;
+
+  /**
+   * @return uint64_t the maximum bytes of a response body which are buffered for the requests
+   *         arriving after the response started.
+   */
+  virtual uint64_t maxBufferedBytes() const PURE;
+};
+
 class MetadataMatchCriterion {
 public:
   virtual ~MetadataMatchCriterion() = default;
@@ -596,6 +623,12 @@ public:
    */
   virtual const HedgePolicy& hedgePolicy() const PURE;
 
+  /**
+   * @return const CollapsedForwardingPolicy& the collapsed forwarding policy for the route. All
+   *         routes have one even if it does not collapse requests.
+   */
+  virtual const CollapsedForwardingPolicy& collapsedForwardingPolicy() const PURE;
+
   /**
    * @return the priority of the route.
    */
@@ -58,6 +58,12 @@ public:
    */
   virtual unsigned maxProtocolVersion() const PURE;
 
+  /**
+   * @return true if the record layer of established connections should be offloaded to the
+   *         kernel when possible.
+   */
+  virtual bool kernelTlsOffload() const PURE;
+
   /**
    * @return true if the ContextConfig is able to provide secrets to create SSL context,
    * and false if dynamic secrets are expected but are not downloaded from SDS server yet.
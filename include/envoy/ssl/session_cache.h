@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/common/pure.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * A cache of TLS sessions used for client-side session resumption. Sessions are stored under an
+ * opaque key which identifies both the upstream (e.g. the SNI) and every setting of the client
+ * context that affects whether a resumed session may be trusted (e.g. the validation context), so
+ * a single cache can safely be shared by all client contexts in the process.
+ *
+ * Implementations must be thread safe, as the cache is accessed from all workers.
+ */
+class SessionCache {
+public:
+  virtual ~SessionCache() = default;
+
+  /**
+   * Store a session.
+   * @param key supplies the key to store the session under.
+   * @param session supplies the session to store.
+   * @param max_sessions_per_key supplies the maximum number of sessions retained for the key. The
+   *        oldest sessions are evicted first.
+   */
+  virtual void insert(const std::string& key, bssl::UniquePtr<SSL_SESSION> session,
+                      size_t max_sessions_per_key) PURE;
+
+  /**
+   * Look up the most recently stored session for a key. Single-use sessions (TLS 1.3) are removed
+   * from the cache when they are returned.
+   * @param key supplies the key to look up.
+   * @return bssl::UniquePtr<SSL_SESSION> a reference to the session, or nullptr on a miss.
+   */
+  virtual bssl::UniquePtr<SSL_SESSION> lookup(const std::string& key) PURE;
+
+  /**
+   * @return size_t the number of sessions currently stored.
+   */
+  virtual size_t size() const PURE;
+};
+
+using SessionCacheSharedPtr = std::shared_ptr<SessionCache>;
+
+} // namespace Ssl
+} // namespace Envoy
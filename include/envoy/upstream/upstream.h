@@ -596,6 +596,14 @@ public:
  */
 #define ALL_CLUSTER_LOAD_REPORT_STATS(COUNTER) COUNTER(upstream_rq_dropped)
 
+/**
+ * All cluster connection prefetch stats. These are only allocated for clusters with a
+ * prefetch policy so that clusters which do not prefetch do not pay for them.
+ */
+#define ALL_CLUSTER_PREFETCH_STATS(COUNTER)                                                        \
+  COUNTER(upstream_cx_prefetch_total)                                                              \
+  COUNTER(upstream_cx_prefetch_overflow)
+
 /**
  * Cluster circuit breakers stats. Open circuit breaker stats and remaining resource stats
  * can be handled differently by passing in different macros.
@@ -626,6 +634,13 @@ struct ClusterLoadReportStats {
   ALL_CLUSTER_LOAD_REPORT_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * Struct definition for all cluster connection prefetch stats. @see stats_macros.h
+ */
+struct ClusterPrefetchStats {
+  ALL_CLUSTER_PREFETCH_STATS(GENERATE_COUNTER_STRUCT)
+};
+
 /**
  * Struct definition for cluster circuit breakers stats. @see stats_macros.h
  */
@@ -662,6 +677,9 @@ public:
     static const uint64_t USE_DOWNSTREAM_PROTOCOL = 0x2;
     // Whether connections should be immediately closed upon health failure.
     static const uint64_t CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE = 0x4;
+    // Whether HTTP/2 connections are owned by a single worker per host and shared by all workers.
+    // This is used when creating connection pools.
+    static const uint64_t SHARED_HTTP2_CONN_POOL = 0x8;
   };
 
   virtual ~ClusterInfo() = default;
@@ -806,6 +824,25 @@ public:
    */
   virtual ClusterLoadReportStats& loadReportStats() const PURE;
 
+  /**
+   * @return ClusterPrefetchStats* strongly named connection prefetch stats for this cluster, or
+   *         nullptr if the cluster has no prefetch policy.
+   */
+  virtual ClusterPrefetchStats* prefetchStats() const PURE;
+
+  /**
+   * @return float the ratio of connection stream capacity that connection pools keep established
+   *         relative to the number of active and pending requests. A ratio of 1.0 means that
+   *         connections are only established on demand.
+   */
+  virtual float prefetchRatio() const PURE;
+
+  /**
+   * @return bool whether each worker should establish a connection to a host as soon as the host
+   *         is added to the cluster.
+   */
+  virtual bool prefetchOnHostAdd() const PURE;
+
   /**
    * Returns an optional source address for upstream connections to bind to.
    *
@@ -0,0 +1,45 @@
+#include "common/buffer/zero_copy_output_stream_impl.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Buffer {
+
+void ZeroCopyOutputStreamImpl::commit() {
+  if (position_ != 0) {
+    slice_.len_ = position_;
+    buffer_.commit(&slice_, 1);
+  }
+  slice_ = {};
+  position_ = 0;
+}
+
+bool ZeroCopyOutputStreamImpl::Next(void** data, int* size) {
+  commit();
+
+  const uint64_t num_slices = buffer_.reserve(ReservationSize, &slice_, 1);
+  ASSERT(num_slices == 1);
+  // A slice reserved from the space left at the end of the buffer may be larger than requested.
+  slice_.len_ = std::min<uint64_t>(slice_.len_, std::numeric_limits<int>::max());
+
+  *data = slice_.mem_;
+  *size = slice_.len_;
+  position_ = slice_.len_;
+  byte_count_ += slice_.len_;
+  return true;
+}
+
+void ZeroCopyOutputStreamImpl::BackUp(int count) {
+  ASSERT(count >= 0);
+  ASSERT(uint64_t(count) <= position_);
+
+  // The bytes backed up are the last ones returned by Next(), which are not committed yet.
+  position_ -= count;
+  byte_count_ -= count;
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/buffer/buffer.h"
+
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+
+namespace Buffer {
+
+class ZeroCopyOutputStreamImpl : public Protobuf::io::ZeroCopyOutputStream {
+public:
+  // Create output stream appending to the buffer. The data written is committed to the buffer by
+  // commit() or when the stream is destroyed.
+  explicit ZeroCopyOutputStreamImpl(Buffer::Instance& buffer) : buffer_(buffer) {}
+
+  ~ZeroCopyOutputStreamImpl() override { commit(); }
+
+  // Commit the data written so far to the buffer.
+  void commit();
+
+  // Protobuf::io::ZeroCopyOutputStream
+  // See
+  // https://developers.google.com/protocol-buffers/docs/reference/cpp/google.protobuf.io.zero_copy_stream#ZeroCopyOutputStream
+  // for each method details.
+
+  // Next() reserves space at the end of the buffer and returns it as is, so the data is written
+  // in place rather than copied into the buffer.
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  ProtobufTypes::Int64 ByteCount() const override { return byte_count_; }
+
+private:
+  // The size of the space reserved by each Next().
+  static constexpr uint64_t ReservationSize = 16384;
+
+  Buffer::Instance& buffer_;
+  Buffer::RawSlice slice_;
+  // The number of bytes of slice_ written.
+  uint64_t position_{0};
+  uint64_t byte_count_{0};
+};
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+
+/**
+ * A map which evicts its least recently used entries to keep the total weight of its entries
+ * within a maximum. Each entry is given a weight when it is inserted: 1 to bound the number of
+ * entries, or e.g. the bytes it holds to bound their memory. Entries with std::string keys are
+ * looked up by absl::string_view, and indexed by views of the keys they hold rather than copies.
+ * The cache is not thread safe.
+ */
+template <class Key, class Value> class LruCache {
+public:
+  using LookupKey = typename std::conditional<std::is_same<Key, std::string>::value,
+                                              absl::string_view, Key>::type;
+
+  explicit LruCache(uint64_t max_weight) : max_weight_(max_weight) {}
+
+  /**
+   * @param key supplies the key of the entry.
+   * @return Value* the value cached under the key, which becomes the most recently used entry, or
+   *         nullptr. It is valid until the entry is erased or evicted.
+   */
+  Value* lookup(const LookupKey& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value_;
+  }
+
+  /**
+   * Caches a value as the most recently used entry, replacing the entry cached under its key and
+   * evicting the least recently used entries to make room for it. A value which weighs more than
+   * the cache on its own is not cached.
+   * @param key supplies the key of the entry.
+   * @param value supplies the value of the entry.
+   * @param weight supplies the weight of the entry.
+   * @return uint64_t the number of entries evicted.
+   */
+  uint64_t insert(Key key, Value value, uint64_t weight = 1) {
+    erase(LookupKey(key));
+    if (weight > max_weight_) {
+      return 0;
+    }
+    uint64_t evicted = 0;
+    while (weight_ + weight > max_weight_) {
+      eraseEntry(std::prev(entries_.end()));
+      evicted++;
+    }
+    entries_.push_front({std::move(key), std::move(value), weight});
+    index_.emplace(entries_.front().key_, entries_.begin());
+    weight_ += weight;
+    return evicted;
+  }
+
+  /**
+   * Erases the entry cached under a key, if any.
+   * @param key supplies the key of the entry.
+   * @return bool whether an entry was erased.
+   */
+  bool erase(const LookupKey& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    eraseEntry(it->second);
+    return true;
+  }
+
+  /**
+   * @return uint64_t the number of entries cached.
+   */
+  uint64_t size() const { return entries_.size(); }
+
+  /**
+   * @return uint64_t the total weight of the entries cached.
+   */
+  uint64_t weight() const { return weight_; }
+
+private:
+  struct Entry {
+    Key key_;
+    Value value_;
+    uint64_t weight_;
+  };
+  using EntryList = std::list<Entry>;
+
+  void eraseEntry(typename EntryList::iterator entry) {
+    weight_ -= entry->weight_;
+    index_.erase(LookupKey(entry->key_));
+    entries_.erase(entry);
+  }
+
+  const uint64_t max_weight_;
+  uint64_t weight_{};
+  // Most recently used first.
+  EntryList entries_;
+  absl::flat_hash_map<LookupKey, typename EntryList::iterator> index_;
+};
+
+} // namespace Envoy
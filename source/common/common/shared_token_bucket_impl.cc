@@ -0,0 +1,81 @@
+#include "common/common/shared_token_bucket_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+
+namespace {
+
+int64_t tokenInterval(double fill_rate) {
+  const double interval = std::ceil(1e9 / std::abs(fill_rate));
+  // A bucket which fills slower than one token in a century never refills.
+  return static_cast<int64_t>(std::min(interval, 1e9 * 3600 * 24 * 365 * 100));
+}
+
+} // namespace
+
+SharedTokenBucketImpl::SharedTokenBucketImpl(uint64_t max_tokens, TimeSource& time_source,
+                                             double fill_rate)
+    : token_interval_(std::max<int64_t>(tokenInterval(fill_rate), 1)),
+      fill_time_(static_cast<int64_t>(
+          std::min(static_cast<double>(max_tokens) * token_interval_,
+                   static_cast<double>(std::numeric_limits<int64_t>::max() / 4)))),
+      time_source_(time_source), empty_at_(now() - fill_time_) {}
+
+int64_t SharedTokenBucketImpl::now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time_source_.monotonicTime().time_since_epoch())
+      .count();
+}
+
+int64_t SharedTokenBucketImpl::fillStart(int64_t now, int64_t empty_at) const {
+  // Tokens which would not fit in the bucket are not kept.
+  return std::max(empty_at, now - fill_time_);
+}
+
+uint64_t SharedTokenBucketImpl::consume(uint64_t tokens, bool allow_partial) {
+  const int64_t time_now = now();
+  int64_t empty_at = empty_at_.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t fill_start = fillStart(time_now, empty_at);
+    const uint64_t available = std::max<int64_t>(time_now - fill_start, 0) / token_interval_;
+    const uint64_t consumed = allow_partial ? std::min(tokens, available) : tokens;
+    if (consumed == 0 || consumed > available) {
+      return 0;
+    }
+    if (empty_at_.compare_exchange_weak(empty_at, fill_start + consumed * token_interval_,
+                                        std::memory_order_relaxed)) {
+      return consumed;
+    }
+  }
+}
+
+std::chrono::milliseconds SharedTokenBucketImpl::nextTokenAvailable() {
+  const int64_t time_now = now();
+  const int64_t next_token =
+      fillStart(time_now, empty_at_.load(std::memory_order_relaxed)) + token_interval_;
+  if (next_token <= time_now) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::nanoseconds(next_token - time_now + 999999));
+}
+
+void SharedTokenBucketImpl::reset(uint64_t num_tokens) {
+  ASSERT(static_cast<int64_t>(num_tokens) * token_interval_ <= fill_time_);
+  empty_at_.store(now() - static_cast<int64_t>(num_tokens) * token_interval_,
+                  std::memory_order_relaxed);
+}
+
+void SharedTokenBucketImpl::refund(uint64_t tokens) {
+  // A bucket which filled up since the tokens were consumed is past its fill start, so the tokens
+  // which do not fit are dropped by fillStart().
+  empty_at_.fetch_sub(static_cast<int64_t>(tokens) * token_interval_, std::memory_order_relaxed);
+}
+
+} // namespace Envoy
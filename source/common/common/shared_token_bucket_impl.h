@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/time.h"
+#include "envoy/common/token_bucket.h"
+
+namespace Envoy {
+
+/**
+ * A token bucket which can be shared by threads without locking. Instead of a token count and the
+ * time of the last refill, the bucket keeps a single atomic time at which it was (or will be)
+ * empty, from which the tokens available at any time follow. Consuming tokens moves that time
+ * forward with a compare-and-swap, so threads contending on the bucket retry instead of blocking.
+ */
+class SharedTokenBucketImpl : public TokenBucket {
+public:
+  /**
+   * @param max_tokens supplies the maximum number of tokens in the bucket.
+   * @param time_source supplies the time source.
+   * @param fill_rate supplies the number of tokens that will return to the bucket on each second.
+   * The default is 1.
+   */
+  explicit SharedTokenBucketImpl(uint64_t max_tokens, TimeSource& time_source,
+                                 double fill_rate = 1);
+
+  // TokenBucket
+  uint64_t consume(uint64_t tokens, bool allow_partial) override;
+  std::chrono::milliseconds nextTokenAvailable() override;
+  void reset(uint64_t num_tokens) override;
+
+  /**
+   * Returns tokens which were consumed but not used. Tokens which no longer fit in the bucket are
+   * dropped.
+   * @param tokens supplies the number of tokens to return.
+   */
+  void refund(uint64_t tokens);
+
+private:
+  int64_t now() const;
+  // The time from which the tokens available now were filled.
+  int64_t fillStart(int64_t now, int64_t empty_at) const;
+
+  // The time, in nanoseconds, it takes to fill a token.
+  const int64_t token_interval_;
+  // The time it takes to fill the bucket.
+  const int64_t fill_time_;
+  TimeSource& time_source_;
+  std::atomic<int64_t> empty_at_;
+};
+
+using SharedTokenBucketImplPtr = std::unique_ptr<SharedTokenBucketImpl>;
+
+} // namespace Envoy
@@ -34,6 +34,14 @@ void ZlibCompressorImpl::init(CompressionLevel comp_level, CompressionStrategy c
   initialized_ = true;
 }
 
+void ZlibCompressorImpl::setDictionary(absl::string_view dictionary) {
+  ASSERT(initialized_);
+  const int result =
+      deflateSetDictionary(zstream_ptr_.get(), reinterpret_cast<const Bytef*>(dictionary.data()),
+                           dictionary.size());
+  RELEASE_ASSERT(result == Z_OK, "");
+}
+
 uint64_t ZlibCompressorImpl::checksum() { return zstream_ptr_->adler; }
 
 void ZlibCompressorImpl::compress(Buffer::Instance& buffer, State state) {
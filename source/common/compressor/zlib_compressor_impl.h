@@ -2,6 +2,8 @@
 
 #include "envoy/compressor/compressor.h"
 
+#include "absl/strings/string_view.h"
+
 #include "zlib.h"
 
 namespace Envoy {
@@ -64,6 +66,15 @@ public:
   void init(CompressionLevel level, CompressionStrategy strategy, int64_t window_bits,
             uint64_t memory_level);
 
+  /**
+   * Sets a preset dictionary, which holds strings likely to occur in the data, so that even the
+   * first bytes of the data can refer back to them. It must be called after init and before
+   * compressing any data, and only works with the zlib format, i.e. window_bits without the gzip
+   * header value. The decompressor must be given the same dictionary.
+   * @param dictionary the preset dictionary. zlib copies what it needs.
+   */
+  void setDictionary(absl::string_view dictionary);
+
   /**
    * It returns the checksum of all output produced so far. Compressor's checksum at the end of the
    * stream has to match decompressor's checksum produced at the end of the decompression.
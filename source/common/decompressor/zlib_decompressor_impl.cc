@@ -58,6 +58,7 @@ void ZlibDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
 bool ZlibDecompressorImpl::inflateNext() {
   const int result = inflate(zstream_ptr_.get(), Z_NO_FLUSH);
   if (result == Z_STREAM_END) {
+    stream_end_ = true;
     // Z_FINISH informs inflate to not maintain a sliding window if the stream completes, which
     // reduces inflate's memory footprint. Ref: https://www.zlib.net/manual.html.
     inflate(zstream_ptr_.get(), Z_FINISH);
@@ -68,6 +69,20 @@ bool ZlibDecompressorImpl::inflateNext() {
     return false; // This means that zlib needs more input, so stop here.
   }
 
+  if (result == Z_NEED_DICT && !dictionary_.empty()) {
+    // A dictionary with a different identifier fails here, and is reported as a data error below.
+    if (inflateSetDictionary(zstream_ptr_.get(), reinterpret_cast<const Bytef*>(dictionary_.data()),
+                             dictionary_.size()) == Z_OK) {
+      return true;
+    }
+  }
+
+  // Corrupt input comes from the peer, so it must not bring down the process.
+  if (result == Z_DATA_ERROR || result == Z_NEED_DICT) {
+    decompression_error_ = true;
+    return false;
+  }
+
   RELEASE_ASSERT(result == Z_OK, "");
   return true;
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <string>
+
 #include "envoy/decompressor/decompressor.h"
 
+#include "absl/strings/string_view.h"
+
 #include "zlib.h"
 
 namespace Envoy {
@@ -32,6 +36,13 @@ public:
    */
   void init(int64_t window_bits);
 
+  /**
+   * Sets the preset dictionary which the data was compressed with. zlib asks for it when it finds
+   * the dictionary identifier in the header of a zlib format stream.
+   * @param dictionary the preset dictionary.
+   */
+  void setDictionary(absl::string_view dictionary) { dictionary_ = std::string(dictionary); }
+
   /**
    * It returns the checksum of all output produced so far. Decompressor's checksum at the end of
    * the stream has to match compressor's checksum produced at the end of the compression.
@@ -40,6 +51,18 @@ public:
    */
   uint64_t checksum();
 
+  /**
+   * @return bool whether the input seen so far is not a valid compressed stream. Once an error is
+   * found, no more data is decompressed.
+   */
+  bool decompressionError() const { return decompression_error_; }
+
+  /**
+   * @return bool whether the end of the compressed stream has been reached. Input which ends before
+   * it is a truncated stream.
+   */
+  bool streamEnd() const { return stream_end_; }
+
   // Decompressor
   void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
 
@@ -49,6 +72,9 @@ private:
 
   const uint64_t chunk_size_;
   bool initialized_;
+  bool decompression_error_{};
+  bool stream_end_{};
+  std::string dictionary_;
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
@@ -105,6 +105,15 @@ private:
     const envoy::type::FractionalPercent additional_request_chance_;
   };
 
+  struct NullCollapsedForwardingPolicy : public Router::CollapsedForwardingPolicy {
+    // Router::CollapsedForwardingPolicy
+    bool enabled() const override { return false; }
+    const std::vector<Http::LowerCaseString>& keyHeaders() const override { return key_headers_; }
+    uint64_t maxBufferedBytes() const override { return 0; }
+
+    const std::vector<Http::LowerCaseString> key_headers_;
+  };
+
   struct NullRateLimitPolicy : public Router::RateLimitPolicy {
     // Router::RateLimitPolicy
     const std::vector<std::reference_wrapper<const Router::RateLimitPolicyEntry>>&
@@ -218,6 +227,9 @@ private:
     void finalizeResponseHeaders(Http::HeaderMap&, const StreamInfo::StreamInfo&) const override {}
     const HashPolicy* hashPolicy() const override { return hash_policy_.get(); }
     const Router::HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
+    const Router::CollapsedForwardingPolicy& collapsedForwardingPolicy() const override {
+      return collapsed_forwarding_policy_;
+    }
     const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
     Upstream::ResourcePriority priority() const override {
       return Upstream::ResourcePriority::Default;
@@ -269,6 +281,7 @@ private:
     const std::string& routeName() const override { return route_name_; }
     std::unique_ptr<const HashPolicyImpl> hash_policy_;
     static const NullHedgePolicy hedge_policy_;
+    static const NullCollapsedForwardingPolicy collapsed_forwarding_policy_;
     static const NullRateLimitPolicy rate_limit_policy_;
     static const NullRetryPolicy retry_policy_;
     static const NullShadowPolicy shadow_policy_;
@@ -1,5 +1,8 @@
 #include "common/http/conn_pool_base.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Envoy {
 namespace Http {
 ConnPoolImplBase::PendingRequest::PendingRequest(ConnPoolImplBase& parent, StreamDecoder& decoder,
@@ -38,6 +41,36 @@ void ConnPoolImplBase::purgePendingRequests(
   }
 }
 
+void ConnPoolImplBase::tryPrefetch(uint64_t min_capacity) {
+  const float ratio = host_->cluster().prefetchRatio();
+  if (ratio <= 1.0 && min_capacity == 0) {
+    // Without prefetching the pool already establishes one connection per unit of demand.
+    return;
+  }
+
+  const uint64_t demand = pending_requests_.size() + activeStreams();
+  const uint64_t target = std::max(static_cast<uint64_t>(std::ceil(demand * ratio)), min_capacity);
+  Upstream::ClusterPrefetchStats* stats = host_->cluster().prefetchStats();
+  while (streamCapacity() < target) {
+    if (!host_->cluster().resourceManager(priority_).connections().canCreate()) {
+      ENVOY_LOG(debug, "connection overflow, not prefetching");
+      if (stats != nullptr) {
+        stats->upstream_cx_prefetch_overflow_.inc();
+      }
+      return;
+    }
+
+    if (!createPrefetchConnection()) {
+      return;
+    }
+
+    ENVOY_LOG(debug, "prefetched a connection");
+    if (stats != nullptr) {
+      stats->upstream_cx_prefetch_total_.inc();
+    }
+  }
+}
+
 void ConnPoolImplBase::onPendingRequestCancel(PendingRequest& request) {
   ENVOY_LOG(debug, "cancelling pending request");
   if (!pending_requests_to_purge_.empty()) {
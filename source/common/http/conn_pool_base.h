@@ -42,9 +42,25 @@ protected:
   void purgePendingRequests(const Upstream::HostDescriptionConstSharedPtr& host_description,
                             absl::string_view failure_reason);
 
+  // Establishes connections ahead of demand until the stream capacity of the pool covers the
+  // number of active and pending requests scaled by the cluster's prefetch ratio, and is at least
+  // min_capacity. Stops early if the cluster's connection circuit breaker is open.
+  void tryPrefetch(uint64_t min_capacity = 0);
+
   // Must be implemented by sub class. Attempts to drain inactive clients.
   virtual void checkForDrained() PURE;
 
+  // Must be implemented by sub class. Returns the number of streams attached to connections.
+  virtual uint64_t activeStreams() PURE;
+
+  // Must be implemented by sub class. Returns the total number of streams that connected and
+  // connecting clients can carry, including the streams they are already carrying.
+  virtual uint64_t streamCapacity() PURE;
+
+  // Must be implemented by sub class. Creates a new connection that is not yet needed by any
+  // request. Returns false if the pool cannot add capacity by creating a connection.
+  virtual bool createPrefetchConnection() PURE;
+
   const Upstream::HostConstSharedPtr host_;
   const Upstream::ResourcePriority priority_;
   std::list<PendingRequestPtr> pending_requests_;
@@ -1,5 +1,6 @@
 #include "common/http/http1/codec_impl.h"
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -10,6 +11,7 @@
 
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/macros.h"
 #include "common/common/stack_array.h"
 #include "common/common/utility.h"
 #include "common/http/exception.h"
@@ -18,6 +20,8 @@
 #include "common/http/utility.h"
 #include "common/runtime/runtime_impl.h"
 
+#include "absl/strings/str_cat.h"
+
 namespace Envoy {
 namespace Http {
 namespace Http1 {
@@ -29,6 +33,44 @@ const StringUtil::CaseUnorderedSet& caseUnorderdSetContainingUpgradeAndHttp2Sett
                          Http::Headers::get().ConnectionValues.Http2Settings);
 }
 
+// Framing headers added by the codec, serialized in advance.
+constexpr absl::string_view CONTENT_LENGTH_ZERO = "content-length: 0\r\n";
+constexpr absl::string_view TRANSFER_ENCODING_CHUNKED = "transfer-encoding: chunked\r\n";
+
+/**
+ * Pre-serialized status lines, e.g. "HTTP/1.1 200 OK\r\n", for all 3 digit status codes.
+ */
+class StatusLines {
+public:
+  StatusLines() {
+    for (uint64_t code = MinCode; code < MaxCode; code++) {
+      const char* reason = CodeUtility::toString(static_cast<Code>(code));
+      http11_[code - MinCode] = absl::StrCat("HTTP/1.1 ", code, " ", reason, "\r\n");
+      http10_[code - MinCode] = absl::StrCat("HTTP/1.0 ", code, " ", reason, "\r\n");
+    }
+  }
+
+  /**
+   * @return the status line for a status code, or an empty string_view if the code has no
+   *         pre-serialized status line.
+   */
+  absl::string_view get(uint64_t code, bool http10) const {
+    if (code < MinCode || code >= MaxCode) {
+      return {};
+    }
+    return http10 ? http10_[code - MinCode] : http11_[code - MinCode];
+  }
+
+private:
+  static constexpr uint64_t MinCode = 100;
+  static constexpr uint64_t MaxCode = 600;
+
+  std::array<std::string, MaxCode - MinCode> http11_;
+  std::array<std::string, MaxCode - MinCode> http10_;
+};
+
+const StatusLines& statusLines() { CONSTRUCT_ON_FIRST_USE(StatusLines); }
+
 } // namespace
 
 const std::string StreamEncoderImpl::CRLF = "\r\n";
@@ -40,21 +82,21 @@ StreamEncoderImpl::StreamEncoderImpl(ConnectionImpl& connection) : connection_(c
   }
 }
 
-void StreamEncoderImpl::encodeHeader(const char* key, uint32_t key_size, const char* value,
-                                     uint32_t value_size) {
-
-  connection_.reserveBuffer(key_size + value_size + 4);
-  ASSERT(key_size > 0);
-
-  connection_.copyToBuffer(key, key_size);
+void StreamEncoderImpl::encodeHeader(absl::string_view key, absl::string_view value) {
+  ASSERT(!key.empty());
+  connection_.copyToBuffer(key.data(), key.size());
   connection_.addCharToBuffer(':');
   connection_.addCharToBuffer(' ');
-  connection_.copyToBuffer(value, value_size);
+  connection_.copyToBuffer(value.data(), value.size());
   connection_.addCharToBuffer('\r');
   connection_.addCharToBuffer('\n');
 }
-void StreamEncoderImpl::encodeHeader(absl::string_view key, absl::string_view value) {
-  this->encodeHeader(key.data(), key.size(), value.data(), value.size());
+
+uint64_t StreamEncoderImpl::headerBlockSize(const HeaderMap& headers) {
+  // Each header is written as "key: value\r\n". Pseudo-headers are counted although they are
+  // skipped, or written as "host" for :authority, and the block ends with a framing header and a
+  // CRLF.
+  return headers.byteSizeInternal() + 4 * headers.size() + TRANSFER_ENCODING_CHUNKED.size() + 2;
 }
 
 void StreamEncoderImpl::encode100ContinueHeaders(const HeaderMap& headers) {
@@ -116,17 +158,13 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
       // For 204s and 1xx where content length is disallowed, don't append the content length but
       // also don't chunk encode.
       if (is_content_length_allowed_) {
-        encodeHeader(Headers::get().ContentLength.get().c_str(),
-                     Headers::get().ContentLength.get().size(), "0", 1);
+        connection_.copyToBuffer(CONTENT_LENGTH_ZERO.data(), CONTENT_LENGTH_ZERO.size());
       }
       chunk_encoding_ = false;
     } else if (connection_.protocol() == Protocol::Http10) {
       chunk_encoding_ = false;
     } else {
-      encodeHeader(Headers::get().TransferEncoding.get().c_str(),
-                   Headers::get().TransferEncoding.get().size(),
-                   Headers::get().TransferEncodingValues.Chunked.c_str(),
-                   Headers::get().TransferEncodingValues.Chunked.size());
+      connection_.copyToBuffer(TRANSFER_ENCODING_CHUNKED.data(), TRANSFER_ENCODING_CHUNKED.size());
       // We do not apply chunk encoding for HTTP upgrades.
       // If there is a body in a WebSocket Upgrade response, the chunks will be
       // passed through via maybeDirectDispatch so we need to avoid appending
@@ -138,7 +176,6 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
     }
   }
 
-  connection_.reserveBuffer(2);
   connection_.addCharToBuffer('\r');
   connection_.addCharToBuffer('\n');
 
@@ -202,10 +239,6 @@ void ConnectionImpl::addCharToBuffer(char c) {
   *reserved_current_++ = c;
 }
 
-void ConnectionImpl::addIntToBuffer(uint64_t i) {
-  reserved_current_ += StringUtil::itoa(reserved_current_, bufferRemainingSize(), i);
-}
-
 uint64_t ConnectionImpl::bufferRemainingSize() {
   return reserved_iovec_.len_ - (reserved_current_ - static_cast<char*>(reserved_iovec_.mem_));
 }
@@ -247,21 +280,19 @@ void ResponseStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end
   started_response_ = true;
   uint64_t numeric_status = Utility::getResponseStatus(headers);
 
-  connection_.reserveBuffer(4096);
-  if (connection_.protocol() == Protocol::Http10 && connection_.supports_http_10()) {
-    connection_.copyToBuffer(HTTP_10_RESPONSE_PREFIX, sizeof(HTTP_10_RESPONSE_PREFIX) - 1);
-  } else {
-    connection_.copyToBuffer(RESPONSE_PREFIX, sizeof(RESPONSE_PREFIX) - 1);
+  const bool http10 =
+      connection_.protocol() == Protocol::Http10 && connection_.supports_http_10();
+  absl::string_view status_line = statusLines().get(numeric_status, http10);
+  std::string unusual_status_line;
+  if (status_line.empty()) {
+    unusual_status_line =
+        absl::StrCat(http10 ? HTTP_10_RESPONSE_PREFIX : RESPONSE_PREFIX, numeric_status, " ",
+                     CodeUtility::toString(static_cast<Code>(numeric_status)), "\r\n");
+    status_line = unusual_status_line;
   }
-  connection_.addIntToBuffer(numeric_status);
-  connection_.addCharToBuffer(' ');
-
-  const char* status_string = CodeUtility::toString(static_cast<Code>(numeric_status));
-  uint32_t status_string_len = strlen(status_string);
-  connection_.copyToBuffer(status_string, status_string_len);
 
-  connection_.addCharToBuffer('\r');
-  connection_.addCharToBuffer('\n');
+  connection_.reserveBuffer(status_line.size() + headerBlockSize(headers));
+  connection_.copyToBuffer(status_line.data(), status_line.size());
 
   if (numeric_status == 204 || numeric_status < 200) {
     // Per https://tools.ietf.org/html/rfc7230#section-3.3.2
@@ -287,7 +318,8 @@ void RequestStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_
     head_request_ = true;
   }
   connection_.onEncodeHeaders(headers);
-  connection_.reserveBuffer(std::max(4096U, path->value().size() + 4096));
+  connection_.reserveBuffer(method->value().size() + path->value().size() +
+                            sizeof(REQUEST_POSTFIX) + headerBlockSize(headers));
   connection_.copyToBuffer(method->value().getStringView().data(), method->value().size());
   connection_.addCharToBuffer(' ');
   connection_.copyToBuffer(path->value().getStringView().data(), path->value().size());
@@ -318,7 +350,7 @@ http_parser_settings ConnectionImpl::settings_{
       return static_cast<ConnectionImpl*>(parser->data)->onHeadersCompleteBase();
     },
     [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onBody(at, length);
+      static_cast<ConnectionImpl*>(parser->data)->onBodyBase(at, length);
       return 0;
     },
     [](http_parser* parser) -> int {
@@ -346,6 +378,9 @@ ConnectionImpl::ConnectionImpl(Network::Connection& connection, Stats::Scope& st
   output_buffer_.setWatermarks(connection.bufferLimit());
   http_parser_init(&parser_, type);
   parser_.data = this;
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.http1_simd_parser")) {
+    simd_parser_ = std::make_unique<SimdParser>(parser_, settings_, max_headers_kb * 1024);
+  }
 }
 
 void ConnectionImpl::completeLastHeader() {
@@ -374,16 +409,12 @@ bool ConnectionImpl::maybeDirectDispatch(Buffer::Instance& data) {
     return false;
   }
 
-  ssize_t total_parsed = 0;
-  uint64_t num_slices = data.getRawSlices(nullptr, 0);
-  STACK_ARRAY(slices, Buffer::RawSlice, num_slices);
-  data.getRawSlices(slices.begin(), num_slices);
-  for (const Buffer::RawSlice& slice : slices) {
-    total_parsed += slice.len_;
-    onBody(static_cast<const char*>(slice.mem_), slice.len_);
-  }
-  ENVOY_CONN_LOG(trace, "direct-dispatched {} bytes", connection_, total_parsed);
-  data.drain(total_parsed);
+  ENVOY_CONN_LOG(trace, "direct-dispatched {} bytes", connection_, data.length());
+  if (data.length() > 0) {
+    Buffer::OwnedImpl buffer;
+    buffer.move(data);
+    onBody(buffer);
+  }
   return true;
 }
 
@@ -398,11 +429,17 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   http_parser_pause(&parser_, 0);
 
   ssize_t total_parsed = 0;
+  dispatching_buffer_ = &data;
+  dispatching_drained_ = 0;
   if (data.length() > 0) {
     uint64_t num_slices = data.getRawSlices(nullptr, 0);
     STACK_ARRAY(slices, Buffer::RawSlice, num_slices);
     data.getRawSlices(slices.begin(), num_slices);
+    // Moving body data out of the buffer only removes slices which have been parsed already, so
+    // the remaining slices stay valid.
     for (const Buffer::RawSlice& slice : slices) {
+      dispatching_slice_ = static_cast<const char*>(slice.mem_);
+      dispatching_slice_offset_ = total_parsed;
       total_parsed += dispatchSlice(static_cast<const char*>(slice.mem_), slice.len_);
     }
   } else {
@@ -410,7 +447,8 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   }
 
   ENVOY_CONN_LOG(trace, "parsed {} bytes", connection_, total_parsed);
-  data.drain(total_parsed);
+  drainDispatched(total_parsed);
+  dispatching_buffer_ = nullptr;
 
   // If an upgrade has been handled and there is body data or early upgrade
   // payload to send on, send it on.
@@ -418,7 +456,8 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
 }
 
 size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
-  ssize_t rc = http_parser_execute(&parser_, &settings_, slice, len);
+  ssize_t rc = simd_parser_ != nullptr ? simd_parser_->execute(slice, len)
+                                       : http_parser_execute(&parser_, &settings_, slice, len);
   if (HTTP_PARSER_ERRNO(&parser_) != HPE_OK && HTTP_PARSER_ERRNO(&parser_) != HPE_PAUSED) {
     sendProtocolError();
     throw CodecProtocolException("http/1.1 protocol error: " +
@@ -428,6 +467,12 @@ size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
   return rc;
 }
 
+void ConnectionImpl::drainDispatched(uint64_t parsed) {
+  ASSERT(parsed >= dispatching_drained_);
+  dispatching_buffer_->drain(parsed - dispatching_drained_);
+  dispatching_drained_ = parsed;
+}
+
 void ConnectionImpl::onHeaderField(const char* data, size_t length) {
   if (header_parsing_state_ == HeaderParsingState::Done) {
     // Ignore trailers.
@@ -524,6 +569,17 @@ int ConnectionImpl::onHeadersCompleteBase() {
   return handling_upgrade_ ? 2 : rc;
 }
 
+void ConnectionImpl::onBodyBase(const char* data, size_t length) {
+  ASSERT(dispatching_buffer_ != nullptr);
+  // Everything before the body has been parsed, so drain it and move the body to the front of a
+  // new buffer. Only the parts of slices shared with other data are copied.
+  drainDispatched(dispatching_slice_offset_ + (data - dispatching_slice_));
+  Buffer::OwnedImpl buffer;
+  buffer.move(*dispatching_buffer_, length);
+  dispatching_drained_ += length;
+  onBody(buffer);
+}
+
 void ConnectionImpl::onMessageCompleteBase() {
   ENVOY_CONN_LOG(trace, "message complete", connection_);
   if (handling_upgrade_) {
@@ -672,12 +728,11 @@ void ServerConnectionImpl::onUrl(const char* data, size_t length) {
   }
 }
 
-void ServerConnectionImpl::onBody(const char* data, size_t length) {
+void ServerConnectionImpl::onBody(Buffer::Instance& data) {
   ASSERT(!deferred_end_stream_headers_);
   if (active_request_) {
-    ENVOY_CONN_LOG(trace, "body size={}", connection_, length);
-    Buffer::OwnedImpl buffer(data, length);
-    active_request_->request_decoder_->decodeData(buffer, false);
+    ENVOY_CONN_LOG(trace, "body size={}", connection_, data.length());
+    active_request_->request_decoder_->decodeData(data, false);
   }
 }
 
@@ -794,12 +849,10 @@ int ClientConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   return cannotHaveBody() ? 1 : 0;
 }
 
-void ClientConnectionImpl::onBody(const char* data, size_t length) {
+void ClientConnectionImpl::onBody(Buffer::Instance& data) {
   ASSERT(!deferred_end_stream_headers_);
   if (!pending_responses_.empty()) {
-    Buffer::OwnedImpl buffer;
-    buffer.add(data, length);
-    pending_responses_.front().decoder_->decodeData(buffer, false);
+    pending_responses_.front().decoder_->decodeData(data, false);
   }
 }
 
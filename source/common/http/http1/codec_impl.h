@@ -18,6 +18,7 @@
 #include "common/http/codec_helper.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/http1/simd_parser.h"
 
 namespace Envoy {
 namespace Http {
@@ -71,21 +72,20 @@ protected:
   static const std::string CRLF;
   static const std::string LAST_CHUNK;
 
+  /**
+   * @return an upper bound on the size of the header block written by encodeHeaders(), not
+   *         including the start line. Subclasses reserve this plus the size of their start line
+   *         before writing it, so that the whole header block is written into a single slice
+   *         without checking for space as each header is written.
+   */
+  static uint64_t headerBlockSize(const HeaderMap& headers);
+
   ConnectionImpl& connection_;
   void setIsContentLengthAllowed(bool value) { is_content_length_allowed_ = value; }
 
 private:
   /**
-   * Called to encode an individual header.
-   * @param key supplies the header to encode.
-   * @param key_size supplies the byte size of the key.
-   * @param value supplies the value to encode.
-   * @param value_size supplies the byte size of the value.
-   */
-  void encodeHeader(const char* key, uint32_t key_size, const char* value, uint32_t value_size);
-
-  /**
-   * Called to encode an individual header.
+   * Called to encode an individual header into space which was already reserved.
    * @param key supplies the header to encode as a string_view.
    * @param value supplies the value to encode as a string_view.
    */
@@ -166,7 +166,6 @@ public:
   void flushOutput();
 
   void addCharToBuffer(char c);
-  void addIntToBuffer(uint64_t i);
   Buffer::WatermarkBuffer& buffer() { return output_buffer_; }
   uint64_t bufferRemainingSize();
   void copyToBuffer(const char* data, uint64_t length);
@@ -198,6 +197,9 @@ protected:
   Network::Connection& connection_;
   CodecStats stats_;
   http_parser parser_;
+  // Set when the vectorized parser is enabled. It parses on behalf of parser_, which still holds
+  // the parsed message properties.
+  std::unique_ptr<SimdParser> simd_parser_;
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
   bool handling_upgrade_{};
@@ -217,6 +219,13 @@ private:
    */
   size_t dispatchSlice(const char* slice, size_t len);
 
+  /**
+   * Drain the part of the buffer being dispatched which precedes the current parsing position.
+   * @param parsed supplies the number of bytes parsed so far, counted from the start of the
+   *        buffer as it was when dispatch began.
+   */
+  void drainDispatched(uint64_t parsed);
+
   /**
    * Called when a request/response is beginning. A base routine happens first then a virtual
    * dispatch is invoked.
@@ -254,11 +263,14 @@ private:
   virtual int onHeadersComplete(HeaderMapImplPtr&& headers) PURE;
 
   /**
-   * Called when body data is received.
+   * Called when body data is received. The data is a span of the buffer being dispatched, which is
+   * moved out of that buffer rather than copied, so that slices made up only of body data are
+   * passed on without being copied.
    * @param data supplies the start address.
    * @param length supplies the length.
    */
-  virtual void onBody(const char* data, size_t length) PURE;
+  void onBodyBase(const char* data, size_t length);
+  virtual void onBody(Buffer::Instance& data) PURE;
 
   /**
    * Called when the request/response is complete.
@@ -302,6 +314,12 @@ private:
   Protocol protocol_{Protocol::Http11};
   const uint32_t max_headers_kb_;
   const uint32_t max_headers_count_;
+  // The buffer being dispatched, the slice of it being parsed and the offset of that slice in the
+  // buffer, and how much of the buffer has been drained so far.
+  Buffer::Instance* dispatching_buffer_{};
+  const char* dispatching_slice_{};
+  uint64_t dispatching_slice_offset_{};
+  uint64_t dispatching_drained_{};
 
   bool strict_header_validation_;
 };
@@ -346,7 +364,7 @@ private:
   void onMessageBegin() override;
   void onUrl(const char* data, size_t length) override;
   int onHeadersComplete(HeaderMapImplPtr&& headers) override;
-  void onBody(const char* data, size_t length) override;
+  void onBody(Buffer::Instance& data) override;
   void onMessageComplete() override;
   void onResetStream(StreamResetReason reason) override;
   void sendProtocolError() override;
@@ -385,7 +403,7 @@ private:
   void onMessageBegin() override {}
   void onUrl(const char*, size_t) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
   int onHeadersComplete(HeaderMapImplPtr&& headers) override;
-  void onBody(const char* data, size_t length) override;
+  void onBody(Buffer::Instance& data) override;
   void onMessageComplete() override;
   void onResetStream(StreamResetReason reason) override;
   void sendProtocolError() override {}
@@ -1,5 +1,6 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -57,6 +58,12 @@ void ConnPoolImpl::drainConnections() {
   }
 }
 
+void ConnPoolImpl::prefetchConnections() {
+  if (drained_callbacks_.empty()) {
+    tryPrefetch(1);
+  }
+}
+
 void ConnPoolImpl::addDrainedCallback(DrainedCb cb) {
   drained_callbacks_.push_back(cb);
   checkForDrained();
@@ -88,6 +95,18 @@ void ConnPoolImpl::checkForDrained() {
   }
 }
 
+uint64_t ConnPoolImpl::activeStreams() {
+  // Busy clients either carry a stream or are still connecting.
+  return std::count_if(
+      busy_clients_.begin(), busy_clients_.end(),
+      [](const ActiveClientPtr& client) -> bool { return client->stream_wrapper_ != nullptr; });
+}
+
+bool ConnPoolImpl::createPrefetchConnection() {
+  createNewConnection();
+  return true;
+}
+
 void ConnPoolImpl::createNewConnection() {
   ENVOY_LOG(debug, "creating a new connection");
   ActiveClientPtr client(new ActiveClient(*this));
@@ -100,6 +119,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
     ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
     attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+    tryPrefetch();
     return nullptr;
   }
 
@@ -115,7 +135,9 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
       createNewConnection();
     }
 
-    return newPendingRequest(response_decoder, callbacks);
+    ConnectionPool::Cancellable* pending_request = newPendingRequest(response_decoder, callbacks);
+    tryPrefetch();
+    return pending_request;
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
     callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::Overflow, absl::string_view(),
@@ -41,6 +41,7 @@ public:
   Http::Protocol protocol() const override { return Http::Protocol::Http11; }
   void addDrainedCallback(DrainedCb cb) override;
   void drainConnections() override;
+  void prefetchConnections() override;
   bool hasActiveConnections() const override;
   ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) override;
@@ -48,6 +49,9 @@ public:
 
   // ConnPoolImplBase
   void checkForDrained() override;
+  uint64_t activeStreams() override;
+  uint64_t streamCapacity() override { return ready_clients_.size() + busy_clients_.size(); }
+  bool createPrefetchConnection() override;
 
 protected:
   struct ActiveClient;
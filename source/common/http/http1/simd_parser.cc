@@ -0,0 +1,647 @@
+#include "common/http/http1/simd_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// tchar from https://tools.ietf.org/html/rfc7230#section-3.2.6.
+constexpr std::array<bool, 256> TokenChars = []() {
+  std::array<bool, 256> table{};
+  for (int c = '0'; c <= '9'; c++) {
+    table[c] = true;
+  }
+  for (int c = 'a'; c <= 'z'; c++) {
+    table[c] = true;
+    table[c - 'a' + 'A'] = true;
+  }
+  const char* special = "!#$%&'*+-.^_`|~";
+  for (; *special != '\0'; special++) {
+    table[static_cast<uint8_t>(*special)] = true;
+  }
+  return table;
+}();
+
+bool isTokenChar(char c) { return TokenChars[static_cast<uint8_t>(c)]; }
+
+/**
+ * @return the first character in [p, end) which isn't a tchar, or end.
+ */
+const char* findNonTokenChar(const char* p, const char* end) {
+#if defined(__SSE4_2__)
+  // Ranges of characters which aren't tchars, except for '|' and '~' which are included in the
+  // last range to fit in 16 bytes and are checked again below.
+  alignas(16) static const char ranges[16] = {'\x00', ' ',  '"', '"', '(', ')', ',', ',',
+                                              '/',    '/',  ':', '@', '[', ']', '{', '\xff'};
+  const __m128i ranges_vector = _mm_load_si128(reinterpret_cast<const __m128i*>(ranges));
+  while (end - p >= 16) {
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const int index = _mm_cmpestri(ranges_vector, sizeof(ranges), data, 16,
+                                   _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+    if (index == 16) {
+      p += 16;
+      continue;
+    }
+    p += index;
+    if (!isTokenChar(*p)) {
+      return p;
+    }
+    p++;
+  }
+#endif
+  for (; p < end; p++) {
+    if (!isTokenChar(*p)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+/**
+ * @return the first character in [p, end) which is below min, or DEL if stop_at_del is set, or
+ *         end. Comparisons are unsigned so that obs-text is never matched.
+ */
+const char* findCharBelow(const char* p, const char* end, uint8_t min, bool stop_at_del) {
+#if defined(__AVX2__)
+  {
+    const __m256i min_vector = _mm256_set1_epi8(min);
+    // Bytes equal to 0 are below min anyway.
+    const __m256i del_vector = _mm256_set1_epi8(stop_at_del ? 0x7f : 0);
+    for (; end - p >= 32; p += 32) {
+      const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      // There is no unsigned comparison, but data >= min iff max(data, min) == data.
+      const __m256i valid = _mm256_andnot_si256(
+          _mm256_cmpeq_epi8(data, del_vector),
+          _mm256_cmpeq_epi8(_mm256_max_epu8(data, min_vector), data));
+      const uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(valid));
+      if (stop != 0) {
+        return p + __builtin_ctz(stop);
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i min_vector = _mm_set1_epi8(min);
+    const __m128i del_vector = _mm_set1_epi8(stop_at_del ? 0x7f : 0);
+    for (; end - p >= 16; p += 16) {
+      const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      const __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi8(data, del_vector),
+                                             _mm_cmpeq_epi8(_mm_max_epu8(data, min_vector), data));
+      const uint32_t stop = ~static_cast<uint32_t>(_mm_movemask_epi8(valid)) & 0xffff;
+      if (stop != 0) {
+        return p + __builtin_ctz(stop);
+      }
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    const uint8_t c = static_cast<uint8_t>(*p);
+    if (c < min || (stop_at_del && c == 0x7f)) {
+      return p;
+    }
+  }
+  return end;
+}
+
+/**
+ * @return the LF ending the line which starts at p, end if the line isn't complete, or nullptr if
+ *         the line contains a CR which isn't followed by a LF. Other control characters are left
+ *         to the codec, which validates header values itself.
+ */
+const char* findLineFeed(const char* p, const char* end) {
+  // Lines rarely contain control characters other than the CRLF ending them.
+  while ((p = findCharBelow(p, end, ' ', false)) != end) {
+    if (*p == '\n') {
+      return p;
+    }
+    if (*p == '\r') {
+      if (p + 1 == end) {
+        return end;
+      }
+      return p[1] == '\n' ? p + 1 : nullptr;
+    }
+    p++;
+  }
+  return end;
+}
+
+bool parseMethod(absl::string_view token, unsigned int& method) {
+  // The most common methods come first.
+#define METHOD_MATCH(num, name, string)                                                            \
+  if (token == #string) {                                                                          \
+    method = HTTP_##name;                                                                          \
+    return true;                                                                                   \
+  }
+  HTTP_METHOD_MAP(METHOD_MATCH)
+#undef METHOD_MATCH
+  return false;
+}
+
+/**
+ * @return whether the start of a request line may still be a known method, i.e. whether the
+ *         characters before the first space are ones used by method names.
+ */
+bool isMethodPrefix(absl::string_view line) {
+  for (const char c : line) {
+    if (c == ' ') {
+      break;
+    }
+    if ((c < 'A' || c > 'Z') && c != '-') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+/**
+ * @return whether a request target has one of the forms accepted by http_parser: an origin-form
+ *         path, "*", an absolute-form URL or, for CONNECT, an authority.
+ */
+bool isValidUrl(absl::string_view url, unsigned int method) {
+  if (method == HTTP_CONNECT || url[0] == '/' || url[0] == '*') {
+    return true;
+  }
+  size_t i = 0;
+  while (i < url.size() && isAlpha(url[i])) {
+    i++;
+  }
+  return i > 0 && url.substr(i, 3) == "://";
+}
+
+absl::string_view stripWhitespace(absl::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+} // namespace
+
+SimdParser::SimdParser(http_parser& parser, const http_parser_settings& settings,
+                       uint32_t max_line_size)
+    : parser_(parser), settings_(settings), max_line_size_(max_line_size) {}
+
+size_t SimdParser::execute(const char* data, size_t len) {
+  if (paused()) {
+    return 0;
+  }
+
+  if (len == 0) {
+    // The connection was closed.
+    switch (state_) {
+    case State::BodyUntilEof:
+      onMessageComplete();
+      return 0;
+    case State::MessageStart:
+    case State::Dead:
+      return 0;
+    default:
+      setError(HPE_INVALID_EOF_STATE);
+      return 0;
+    }
+  }
+
+  const char* p = data;
+  const char* end = data + len;
+  while (true) {
+    switch (state_) {
+    case State::MessageStart:
+    case State::Dead:
+      // Like http_parser, tolerate empty lines between messages.
+      while (p < end && (*p == '\r' || *p == '\n')) {
+        p++;
+      }
+      if (p == end) {
+        return len;
+      }
+      if (state_ == State::Dead) {
+        setError(HPE_CLOSED_CONNECTION);
+        return p - data;
+      }
+      if (!onMessageBegin()) {
+        return p - data;
+      }
+      break;
+
+    case State::HeadersDone:
+      if (!onHeadersDone()) {
+        return p - data;
+      }
+      break;
+
+    case State::Body:
+    case State::ChunkData:
+      if (remaining_ > 0) {
+        if (p == end) {
+          return len;
+        }
+        const uint64_t size = std::min<uint64_t>(remaining_, end - p);
+        settings_.on_body(&parser_, p, size);
+        p += size;
+        remaining_ -= size;
+        if (paused()) {
+          return p - data;
+        }
+      }
+      if (remaining_ == 0) {
+        if (state_ == State::ChunkData) {
+          state_ = State::ChunkDataEnd;
+        } else if (!onMessageComplete()) {
+          return p - data;
+        }
+      }
+      break;
+
+    case State::BodyUntilEof:
+      if (p == end) {
+        return len;
+      }
+      settings_.on_body(&parser_, p, end - p);
+      return len;
+
+    case State::FirstLine:
+    case State::Headers:
+    case State::ChunkSize:
+    case State::ChunkDataEnd:
+    case State::Trailers: {
+      if (p == end) {
+        return len;
+      }
+      if (!partial_line_.empty() && partial_line_.back() == '\r' && *p != '\n') {
+        setError(HPE_LF_EXPECTED);
+        return p - data;
+      }
+      const char* line_feed = findLineFeed(p, end);
+      if (line_feed == nullptr) {
+        setError(HPE_LF_EXPECTED);
+        return p - data;
+      }
+      if (line_feed == end) {
+        // Keep the start of the line until the rest of it is received.
+        if (partial_line_.size() + (end - p) > max_line_size_) {
+          setError(HPE_HEADER_OVERFLOW);
+          return p - data;
+        }
+        partial_line_.append(p, end - p);
+        if (state_ == State::FirstLine && parser_.type == HTTP_REQUEST &&
+            !isMethodPrefix(partial_line_)) {
+          // Like http_parser, reject a bad method without waiting for the rest of the line.
+          setError(HPE_INVALID_METHOD);
+          return p - data;
+        }
+        return len;
+      }
+
+      absl::string_view line;
+      if (partial_line_.empty()) {
+        line = absl::string_view(p, line_feed - p);
+      } else {
+        partial_line_.append(p, line_feed - p);
+        line = partial_line_;
+      }
+      p = line_feed + 1;
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      } else if (state_ == State::ChunkSize) {
+        // Like http_parser, only header lines may end with a bare LF.
+        setError(HPE_INVALID_CHUNK_SIZE);
+        partial_line_.clear();
+        return p - data;
+      }
+      const bool keep_parsing = onLine(line);
+      partial_line_.clear();
+      if (!keep_parsing) {
+        return p - data;
+      }
+      break;
+    }
+    }
+  }
+}
+
+bool SimdParser::onLine(absl::string_view line) {
+  switch (state_) {
+  case State::FirstLine:
+    state_ = State::Headers;
+    return parser_.type == HTTP_REQUEST ? parseRequestLine(line) : parseStatusLine(line);
+  case State::Headers:
+    if (line.empty()) {
+      return onHeadersComplete();
+    }
+    return parseHeaderLine(line, false);
+  case State::ChunkSize:
+    return parseChunkSize(line);
+  case State::ChunkDataEnd:
+    if (!line.empty()) {
+      return setError(HPE_STRICT);
+    }
+    state_ = State::ChunkSize;
+    return true;
+  case State::Trailers:
+    if (line.empty()) {
+      return onMessageComplete();
+    }
+    return parseHeaderLine(line, true);
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+bool SimdParser::parseRequestLine(absl::string_view line) {
+  const char* end = line.data() + line.size();
+  const char* method_end = findNonTokenChar(line.data(), end);
+  unsigned int method;
+  if (method_end == end || *method_end != ' ' ||
+      !parseMethod(absl::string_view(line.data(), method_end - line.data()), method)) {
+    return setError(HPE_INVALID_METHOD);
+  }
+  parser_.method = method;
+
+  const char* url = method_end + 1;
+  const char* url_end = findCharBelow(url, end, '!', true);
+  if (url_end == url || url_end == end || *url_end != ' ' ||
+      !isValidUrl(absl::string_view(url, url_end - url), method)) {
+    return setError(HPE_INVALID_URL);
+  }
+
+  if (!parseVersion(absl::string_view(url_end + 1, end - url_end - 1))) {
+    return false;
+  }
+  settings_.on_url(&parser_, url, url_end - url);
+  return !paused();
+}
+
+bool SimdParser::parseStatusLine(absl::string_view line) {
+  // HTTP-version SP status-code [ SP reason-phrase ]
+  if (line.size() < 8 || !parseVersion(line.substr(0, 8))) {
+    return setError(HPE_INVALID_VERSION);
+  }
+  if (line.size() < 12 || line[8] != ' ' || !isDigit(line[9]) || !isDigit(line[10]) ||
+      !isDigit(line[11]) || (line.size() > 12 && line[12] != ' ')) {
+    return setError(HPE_INVALID_STATUS);
+  }
+  parser_.status_code = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+  if (settings_.on_status != nullptr) {
+    const absl::string_view reason = line.size() > 12 ? line.substr(13) : absl::string_view();
+    settings_.on_status(&parser_, reason.data(), reason.size());
+  }
+  return !paused();
+}
+
+bool SimdParser::parseVersion(absl::string_view version) {
+  if (version.size() != 8 || !absl::StartsWith(version, "HTTP/") || !isDigit(version[5]) ||
+      version[6] != '.' || !isDigit(version[7])) {
+    return setError(HPE_INVALID_VERSION);
+  }
+  parser_.http_major = version[5] - '0';
+  parser_.http_minor = version[7] - '0';
+  return true;
+}
+
+bool SimdParser::parseHeaderLine(absl::string_view line, bool trailer) {
+  // Obsolete line folding (https://tools.ietf.org/html/rfc7230#section-3.2.4) is rejected, since
+  // lines starting with whitespace don't start with a token.
+  const char* end = line.data() + line.size();
+  const char* name_end = findNonTokenChar(line.data(), end);
+  if (name_end == line.data() || name_end == end || *name_end != ':') {
+    return setError(HPE_INVALID_HEADER_TOKEN);
+  }
+  const absl::string_view name(line.data(), name_end - line.data());
+  // Like http_parser, only leading whitespace is removed from the value.
+  const char* value = name_end + 1;
+  while (value < end && (*value == ' ' || *value == '\t')) {
+    value++;
+  }
+
+  if (!trailer &&
+      !parseFramingHeader(name, stripWhitespace(absl::string_view(value, end - value)))) {
+    return false;
+  }
+  settings_.on_header_field(&parser_, name.data(), name.size());
+  if (paused()) {
+    return false;
+  }
+  // Empty values are reported too, so that the end of each header is always known.
+  settings_.on_header_value(&parser_, value, end - value);
+  return !paused();
+}
+
+bool SimdParser::parseFramingHeader(absl::string_view name, absl::string_view value) {
+  switch (name.size()) {
+  case 7:
+    if (absl::EqualsIgnoreCase(name, "upgrade")) {
+      parser_.flags |= F_UPGRADE;
+    }
+    break;
+  case 10:
+    if (absl::EqualsIgnoreCase(name, "connection")) {
+      for (absl::string_view token : absl::StrSplit(value, ',')) {
+        token = stripWhitespace(token);
+        if (absl::EqualsIgnoreCase(token, "close")) {
+          parser_.flags |= F_CONNECTION_CLOSE;
+        } else if (absl::EqualsIgnoreCase(token, "keep-alive")) {
+          parser_.flags |= F_CONNECTION_KEEP_ALIVE;
+        } else if (absl::EqualsIgnoreCase(token, "upgrade")) {
+          parser_.flags |= F_CONNECTION_UPGRADE;
+        }
+      }
+    }
+    break;
+  case 14:
+    if (absl::EqualsIgnoreCase(name, "content-length")) {
+      if (parser_.flags & F_CONTENTLENGTH) {
+        return setError(HPE_UNEXPECTED_CONTENT_LENGTH);
+      }
+      if (value.empty()) {
+        return setError(HPE_INVALID_CONTENT_LENGTH);
+      }
+      uint64_t content_length = 0;
+      for (const char c : value) {
+        // ULLONG_MAX is reserved to mean that there is no content length.
+        if (!isDigit(c) || content_length > (ULLONG_MAX - 10) / 10) {
+          return setError(HPE_INVALID_CONTENT_LENGTH);
+        }
+        content_length = content_length * 10 + (c - '0');
+      }
+      parser_.flags |= F_CONTENTLENGTH;
+      parser_.content_length = content_length;
+    }
+    break;
+  case 17:
+    // Like http_parser, only a transfer-encoding of exactly "chunked" is recognized.
+    if (absl::EqualsIgnoreCase(name, "transfer-encoding") &&
+        absl::EqualsIgnoreCase(value, "chunked")) {
+      parser_.flags |= F_CHUNKED;
+    }
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+bool SimdParser::parseChunkSize(absl::string_view line) {
+  uint64_t size = 0;
+  size_t i = 0;
+  for (; i < line.size(); i++) {
+    const char c = line[i];
+    uint64_t digit;
+    if (isDigit(c)) {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      break;
+    }
+    if (size > (ULLONG_MAX - 16) / 16) {
+      return setError(HPE_INVALID_CONTENT_LENGTH);
+    }
+    size = size * 16 + digit;
+  }
+  // Chunk extensions are ignored.
+  if (i == 0 || (i < line.size() && line[i] != ';' && line[i] != ' ')) {
+    return setError(HPE_INVALID_CHUNK_SIZE);
+  }
+
+  parser_.content_length = size;
+  if (settings_.on_chunk_header != nullptr) {
+    settings_.on_chunk_header(&parser_);
+  }
+  if (size == 0) {
+    parser_.flags |= F_TRAILING;
+    state_ = State::Trailers;
+  } else {
+    remaining_ = size;
+    state_ = State::ChunkData;
+  }
+  return !paused();
+}
+
+bool SimdParser::onMessageBegin() {
+  parser_.flags = 0;
+  parser_.content_length = ULLONG_MAX;
+  parser_.upgrade = 0;
+  state_ = State::FirstLine;
+  settings_.on_message_begin(&parser_);
+  return !paused();
+}
+
+bool SimdParser::onHeadersComplete() {
+  if ((parser_.flags & F_CHUNKED) && (parser_.flags & F_CONTENTLENGTH)) {
+    return setError(HPE_UNEXPECTED_CONTENT_LENGTH);
+  }
+  parser_.upgrade =
+      (parser_.type == HTTP_REQUEST || parser_.status_code == 101) &&
+      ((parser_.flags & F_UPGRADE) && (parser_.flags & F_CONNECTION_UPGRADE));
+  if (parser_.type == HTTP_REQUEST && parser_.method == HTTP_CONNECT) {
+    parser_.upgrade = 1;
+  }
+
+  switch (settings_.on_headers_complete(&parser_)) {
+  case 0:
+    break;
+  case 1:
+    parser_.flags |= F_SKIPBODY;
+    break;
+  case 2:
+    parser_.upgrade = 1;
+    parser_.flags |= F_SKIPBODY;
+    break;
+  default:
+    return setError(HPE_CB_headers_complete);
+  }
+
+  // The framing of the body is determined once parsing resumes, as the callback may pause it.
+  state_ = State::HeadersDone;
+  return !paused();
+}
+
+bool SimdParser::onHeadersDone() {
+  const bool has_body = (parser_.flags & F_CHUNKED) ||
+                        (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX);
+  if (parser_.upgrade &&
+      (parser_.method == HTTP_CONNECT || (parser_.flags & F_SKIPBODY) || !has_body)) {
+    // The rest of the data is in a different protocol, so stop parsing.
+    onMessageComplete();
+    return false;
+  }
+
+  if (parser_.flags & F_SKIPBODY) {
+    return onMessageComplete();
+  } else if (parser_.flags & F_CHUNKED) {
+    state_ = State::ChunkSize;
+  } else if (parser_.content_length == 0) {
+    return onMessageComplete();
+  } else if (parser_.content_length != ULLONG_MAX) {
+    remaining_ = parser_.content_length;
+    state_ = State::Body;
+  } else if (needsEof()) {
+    state_ = State::BodyUntilEof;
+  } else {
+    return onMessageComplete();
+  }
+  return true;
+}
+
+bool SimdParser::onMessageComplete() {
+  state_ = shouldKeepAlive() ? State::MessageStart : State::Dead;
+  settings_.on_message_complete(&parser_);
+  return !paused();
+}
+
+bool SimdParser::setError(http_errno error) {
+  parser_.http_errno = error;
+  return false;
+}
+
+bool SimdParser::shouldKeepAlive() const {
+  // See http_should_keep_alive().
+  if (parser_.http_major > 0 && parser_.http_minor > 0) {
+    if (parser_.flags & F_CONNECTION_CLOSE) {
+      return false;
+    }
+  } else if (!(parser_.flags & F_CONNECTION_KEEP_ALIVE)) {
+    return false;
+  }
+  return !needsEof();
+}
+
+bool SimdParser::needsEof() const {
+  // See http_message_needs_eof().
+  if (parser_.type == HTTP_REQUEST) {
+    return false;
+  }
+  if (parser_.status_code / 100 == 1 || parser_.status_code == 204 ||
+      parser_.status_code == 304 || (parser_.flags & F_SKIPBODY)) {
+    return false;
+  }
+  return !(parser_.flags & F_CHUNKED) && parser_.content_length == ULLONG_MAX;
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
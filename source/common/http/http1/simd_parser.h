@@ -0,0 +1,91 @@
+#pragma once
+
+#include <http_parser.h>
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * An HTTP/1.x parser which can be used in place of http_parser_execute(). Rather than running a
+ * state machine over every byte, it finds the end of each line of the request/status line and
+ * headers with vector instructions and validates tokens 16 bytes at a time, in the style of
+ * picohttpparser. Bodies are passed through without being scanned.
+ *
+ * The parser reports to the same http_parser_settings callbacks as http_parser, and stores the
+ * parsed message properties (version, method, status code, content length, flags and errno) in
+ * the public fields of the supplied http_parser, so the two can be used interchangeably. It also
+ * honors http_parser_pause() calls made from the callbacks.
+ *
+ * Each header field and value is delivered in a single callback pointing into the data being
+ * parsed. Only lines which are split across calls to execute() are copied into an internal buffer
+ * first.
+ */
+class SimdParser {
+public:
+  /**
+   * @param parser supplies the http_parser whose type and data are used, and whose fields are
+   *        updated as messages are parsed. It must have been initialized with http_parser_init().
+   * @param settings supplies the callbacks.
+   * @param max_line_size supplies the maximum size of a request/status line or header line.
+   */
+  SimdParser(http_parser& parser, const http_parser_settings& settings, uint32_t max_line_size);
+
+  /**
+   * Parse data, with the same semantics as http_parser_execute(). Passing no data signals the end
+   * of the connection.
+   * @return the number of bytes consumed. Fewer than len bytes are consumed if parsing is paused
+   *         or fails, in which case the parser's http_errno is set.
+   */
+  size_t execute(const char* data, size_t len);
+
+private:
+  enum class State {
+    MessageStart,
+    FirstLine,
+    Headers,
+    HeadersDone,
+    Body,
+    BodyUntilEof,
+    ChunkSize,
+    ChunkData,
+    ChunkDataEnd,
+    Trailers,
+    Dead
+  };
+
+  // Each returns false if parsing must stop, i.e. the parser was paused or an error occurred.
+  bool onLine(absl::string_view line);
+  bool parseRequestLine(absl::string_view line);
+  bool parseStatusLine(absl::string_view line);
+  bool parseVersion(absl::string_view version);
+  bool parseHeaderLine(absl::string_view line, bool trailer);
+  bool parseFramingHeader(absl::string_view name, absl::string_view value);
+  bool parseChunkSize(absl::string_view line);
+  bool onHeadersComplete();
+  bool onHeadersDone();
+  bool onMessageBegin();
+  bool onMessageComplete();
+  bool setError(http_errno error);
+  bool paused() const { return HTTP_PARSER_ERRNO(&parser_) != HPE_OK; }
+  bool shouldKeepAlive() const;
+  bool needsEof() const;
+
+  http_parser& parser_;
+  const http_parser_settings& settings_;
+  const uint32_t max_line_size_;
+  State state_{State::MessageStart};
+  // The remaining size of the body or current chunk.
+  uint64_t remaining_{};
+  // A line which was split across calls to execute().
+  std::string partial_line_;
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
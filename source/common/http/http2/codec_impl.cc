@@ -1,5 +1,6 @@
 #include "common/http/http2/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -60,8 +61,9 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
-  uint8_t flags = 0;
+static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header,
+                         bool never_index) {
+  uint8_t flags = never_index ? NGHTTP2_NV_FLAG_NO_INDEX : 0;
   if (header.key().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
   }
@@ -75,16 +77,22 @@ static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& he
                      header_value.size(), flags});
 }
 
-void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
-                                              const HeaderMap& headers) {
-  final_headers.reserve(headers.size());
+const std::vector<nghttp2_nv>&
+ConnectionImpl::StreamImpl::buildHeaders(const HeaderMap& headers) {
+  const uint64_t header_bytes = parent_.tx_header_bytes_;
+  parent_.nv_arena_.clear();
+  parent_.nv_arena_.reserve(headers.size());
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
-        insertHeader(*final_headers, header);
+        ConnectionImpl* parent = static_cast<ConnectionImpl*>(context);
+        const absl::string_view key = header.key().getStringView();
+        insertHeader(parent->nv_arena_, header, parent->neverIndex(key));
+        parent->tx_header_bytes_ += key.size() + header.value().size();
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      &parent_);
+  parent_.stats_.tx_header_bytes_.add(parent_.tx_header_bytes_ - header_bytes);
+  return parent_.nv_arena_;
 }
 
 void ConnectionImpl::StreamImpl::encode100ContinueHeaders(const HeaderMap& headers) {
@@ -93,18 +101,16 @@ void ConnectionImpl::StreamImpl::encode100ContinueHeaders(const HeaderMap& heade
 }
 
 void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
-  std::vector<nghttp2_nv> final_headers;
-
   // This must exist outside of the scope of isUpgrade as the underlying memory is
   // needed until submitHeaders has been called.
   Http::HeaderMapPtr modified_headers;
+  const HeaderMap* headers_to_encode = &headers;
   if (Http::Utility::isUpgrade(headers)) {
     modified_headers = std::make_unique<Http::HeaderMapImpl>(headers);
     transformUpgradeFromH1toH2(*modified_headers);
-    buildHeaders(final_headers, *modified_headers);
-  } else {
-    buildHeaders(final_headers, headers);
+    headers_to_encode = modified_headers.get();
   }
+  const std::vector<nghttp2_nv>& final_headers = buildHeaders(*headers_to_encode);
 
   nghttp2_data_provider provider;
   if (!end_stream) {
@@ -210,10 +216,9 @@ void ConnectionImpl::StreamImpl::saveHeader(HeaderString&& name, HeaderString&&
 }
 
 void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, trailers);
-  int rc =
-      nghttp2_submit_trailer(parent_.session_, stream_id_, &final_headers[0], final_headers.size());
+  const std::vector<nghttp2_nv>& final_headers = buildHeaders(trailers);
+  int rc = nghttp2_submit_trailer(parent_.session_, stream_id_, final_headers.data(),
+                                  final_headers.size());
   ASSERT(rc == 0);
 }
 
@@ -372,12 +377,14 @@ bool checkRuntimeOverride(bool config_value, const char* override_key) {
 ConnectionImpl::ConnectionImpl(Network::Connection& connection, Stats::Scope& stats,
                                const Http2Settings& http2_settings, const uint32_t max_headers_kb,
                                const uint32_t max_headers_count)
-    : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))}, connection_(connection),
+    : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."),
+                                   POOL_HISTOGRAM_PREFIX(stats, "http2."))},
+      connection_(connection),
       max_headers_kb_(max_headers_kb), max_headers_count_(max_headers_count),
       per_stream_buffer_limit_(http2_settings.initial_stream_window_size_),
       stream_error_on_invalid_http_messaging_(checkRuntimeOverride(
           http2_settings.stream_error_on_invalid_http_messaging_, InvalidHttpMessagingOverrideKey)),
-      flood_detected_(false),
+      flood_detected_(false), never_index_headers_(http2_settings.never_index_headers_),
       max_outbound_frames_(
           Runtime::getInteger(MaxOutboundFramesOverrideKey, http2_settings.max_outbound_frames_)),
       frame_buffer_releasor_([this](const Buffer::OwnedBufferFragmentImpl* fragment) {
@@ -399,15 +406,36 @@ ConnectionImpl::ConnectionImpl(Network::Connection& connection, Stats::Scope& st
           http2_settings.max_inbound_window_update_frames_per_data_frame_sent_)),
       dispatching_(false), raised_goaway_(false), pending_deferred_reset_(false) {}
 
-ConnectionImpl::~ConnectionImpl() { nghttp2_session_del(session_); }
+ConnectionImpl::~ConnectionImpl() {
+  // Record the share of header octets left after HPACK compression on this connection.
+  if (tx_header_bytes_ > 0) {
+    stats_.tx_header_compression_percent_.recordValue(tx_header_block_bytes_ * 100 /
+                                                      tx_header_bytes_);
+  }
+  if (rx_header_bytes_ > 0) {
+    stats_.rx_header_compression_percent_.recordValue(rx_header_block_bytes_ * 100 /
+                                                      rx_header_bytes_);
+  }
+  ENVOY_CONN_LOG(debug, "HPACK sent {}/{} and received {}/{} encoded/uncompressed header bytes",
+                 connection_, tx_header_block_bytes_, tx_header_bytes_, rx_header_block_bytes_,
+                 rx_header_bytes_);
+  nghttp2_session_del(session_);
+}
 
 void ConnectionImpl::dispatch(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "dispatching {} bytes", connection_, data.length());
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   STACK_ARRAY(slices, Buffer::RawSlice, num_slices);
   data.getRawSlices(slices.begin(), num_slices);
+  uint64_t total_dispatched = 0;
+  dispatching_buffer_ = &data;
+  dispatching_drained_ = 0;
+  // Moving DATA payloads out of the buffer only removes slices which nghttp2 has processed
+  // already, so the remaining slices stay valid.
   for (const Buffer::RawSlice& slice : slices) {
     dispatching_ = true;
+    dispatching_slice_ = slice;
+    dispatching_slice_offset_ = total_dispatched;
     ssize_t rc =
         nghttp2_session_mem_recv(session_, static_cast<const uint8_t*>(slice.mem_), slice.len_);
     if (rc == NGHTTP2_ERR_FLOODED || flood_detected_) {
@@ -418,25 +446,43 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
       throw CodecProtocolException(fmt::format("{}", nghttp2_strerror(rc)));
     }
 
+    total_dispatched += slice.len_;
     dispatching_ = false;
   }
 
-  ENVOY_CONN_LOG(trace, "dispatched {} bytes", connection_, data.length());
-  data.drain(data.length());
+  ENVOY_CONN_LOG(trace, "dispatched {} bytes", connection_, total_dispatched);
+  drainDispatched(total_dispatched);
+  dispatching_buffer_ = nullptr;
 
   // Decoding incoming frames can generate outbound frames so flush pending.
   sendPendingFrames();
 }
 
+void ConnectionImpl::drainDispatched(uint64_t dispatched) {
+  ASSERT(dispatched >= dispatching_drained_);
+  dispatching_buffer_->drain(dispatched - dispatching_drained_);
+  dispatching_drained_ = dispatched;
+}
+
 ConnectionImpl::StreamImpl* ConnectionImpl::getStream(int32_t stream_id) {
   return static_cast<StreamImpl*>(nghttp2_session_get_stream_user_data(session_, stream_id));
 }
 
 int ConnectionImpl::onData(int32_t stream_id, const uint8_t* data, size_t len) {
   StreamImpl* stream = getStream(stream_id);
+  const uint8_t* slice = static_cast<const uint8_t*>(dispatching_slice_.mem_);
   // If this results in buffering too much data, the watermark buffer will call
   // pendingRecvBufferHighWatermark, resulting in ++read_disable_count_
-  stream->pending_recv_data_.add(data, len);
+  if (dispatching_buffer_ != nullptr && data >= slice &&
+      data + len <= slice + dispatching_slice_.len_) {
+    // Everything in front of the payload has been processed, so drain it and move the payload into
+    // the stream's buffer. Only the parts of slices shared with frame headers are copied.
+    drainDispatched(dispatching_slice_offset_ + (data - slice));
+    stream->pending_recv_data_.move(*dispatching_buffer_, len);
+    dispatching_drained_ += len;
+  } else {
+    stream->pending_recv_data_.add(data, len);
+  }
   // Update the window to the peer unless some consumer of this stream's data has hit a flow control
   // limit and disabled reads on this stream
   if (!stream->buffers_overrun()) {
@@ -476,6 +522,11 @@ int ConnectionImpl::onBeforeFrameReceived(const nghttp2_frame_hd* hd) {
     }
   }
 
+  if (hd->type == NGHTTP2_HEADERS || hd->type == NGHTTP2_CONTINUATION) {
+    rx_header_block_bytes_ += hd->length;
+    stats_.rx_header_block_bytes_.add(hd->length);
+  }
+
   return 0;
 }
 
@@ -623,6 +674,12 @@ int ConnectionImpl::onFrameSend(const nghttp2_frame* frame) {
 
   case NGHTTP2_HEADERS:
   case NGHTTP2_DATA: {
+    if (frame->hd.type == NGHTTP2_HEADERS) {
+      // The length covers the whole header block, including the CONTINUATION frames it was split
+      // into.
+      tx_header_block_bytes_ += frame->hd.length;
+      stats_.tx_header_block_bytes_.add(frame->hd.length);
+    }
     StreamImpl* stream = getStream(frame->hd.stream_id);
     if (stream->headers_) {
       // Verify that the final HeaderMap's byte size is under the limit before sending frames.
@@ -805,8 +862,17 @@ ssize_t ConnectionImpl::packMetadata(int32_t stream_id, uint8_t* buf, size_t len
   return static_cast<ssize_t>(payload_size);
 }
 
+bool ConnectionImpl::neverIndex(absl::string_view key) const {
+  return never_index_headers_ != nullptr &&
+         never_index_headers_->find(key) != never_index_headers_->end();
+}
+
 int ConnectionImpl::saveHeader(const nghttp2_frame* frame, HeaderString&& name,
                                HeaderString&& value) {
+  const uint64_t header_bytes = name.size() + value.size();
+  rx_header_bytes_ += header_bytes;
+  stats_.rx_header_bytes_.add(header_bytes);
+
   StreamImpl* stream = getStream(frame->hd.stream_id);
   if (!stream) {
     // We have seen 1 or 2 crashes where we get a headers callback but there is no associated
@@ -876,7 +942,7 @@ void ConnectionImpl::sendPendingFrames() {
 }
 
 void ConnectionImpl::sendSettings(const Http2Settings& http2_settings, bool disable_push) {
-  ASSERT(http2_settings.hpack_table_size_ <= Http2Settings::MAX_HPACK_TABLE_SIZE);
+  ASSERT(http2_settings.decoderHpackTableSize() <= Http2Settings::MAX_HPACK_TABLE_SIZE);
   ASSERT(Http2Settings::MIN_MAX_CONCURRENT_STREAMS <= http2_settings.max_concurrent_streams_ &&
          http2_settings.max_concurrent_streams_ <= Http2Settings::MAX_MAX_CONCURRENT_STREAMS);
   ASSERT(
@@ -893,10 +959,10 @@ void ConnectionImpl::sendSettings(const Http2Settings& http2_settings, bool disa
     iv.push_back({NGHTTP2_SETTINGS_ENABLE_CONNECT_PROTOCOL, 1});
   }
 
-  if (http2_settings.hpack_table_size_ != NGHTTP2_DEFAULT_HEADER_TABLE_SIZE) {
-    iv.push_back({NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, http2_settings.hpack_table_size_});
+  if (http2_settings.decoderHpackTableSize() != NGHTTP2_DEFAULT_HEADER_TABLE_SIZE) {
+    iv.push_back({NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, http2_settings.decoderHpackTableSize()});
     ENVOY_CONN_LOG(debug, "setting HPACK table size to {}", connection_,
-                   http2_settings.hpack_table_size_);
+                   http2_settings.decoderHpackTableSize());
   }
 
   if (http2_settings.max_concurrent_streams_ != NGHTTP2_INITIAL_MAX_CONCURRENT_STREAMS) {
@@ -1059,8 +1125,9 @@ ConnectionImpl::Http2Options::Http2Options(const Http2Settings& http2_settings)
   // trigger the check within nghttp2, as we check request headers length in codec_impl::saveHeader.
   nghttp2_option_set_max_send_header_block_length(options_, 0x2000000);
 
-  if (http2_settings.hpack_table_size_ != NGHTTP2_DEFAULT_HEADER_TABLE_SIZE) {
-    nghttp2_option_set_max_deflate_dynamic_table_size(options_, http2_settings.hpack_table_size_);
+  if (http2_settings.encoderHpackTableSize() != NGHTTP2_DEFAULT_HEADER_TABLE_SIZE) {
+    nghttp2_option_set_max_deflate_dynamic_table_size(options_,
+                                                      http2_settings.encoderHpackTableSize());
   }
 
   if (http2_settings.allow_metadata_) {
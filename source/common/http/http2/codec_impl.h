@@ -39,7 +39,7 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
 /**
  * All stats for the HTTP/2 codec. @see stats_macros.h
  */
-#define ALL_HTTP2_CODEC_STATS(COUNTER)                                                             \
+#define ALL_HTTP2_CODEC_STATS(COUNTER, HISTOGRAM)                                                  \
   COUNTER(header_overflow)                                                                         \
   COUNTER(headers_cb_no_stream)                                                                    \
   COUNTER(inbound_empty_frames_flood)                                                              \
@@ -47,17 +47,23 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
   COUNTER(inbound_window_update_frames_flood)                                                      \
   COUNTER(outbound_control_flood)                                                                  \
   COUNTER(outbound_flood)                                                                          \
+  COUNTER(rx_header_block_bytes)                                                                   \
+  COUNTER(rx_header_bytes)                                                                         \
   COUNTER(rx_messaging_error)                                                                      \
   COUNTER(rx_reset)                                                                                \
   COUNTER(too_many_header_frames)                                                                  \
   COUNTER(trailers)                                                                                \
-  COUNTER(tx_reset)
+  COUNTER(tx_header_block_bytes)                                                                   \
+  COUNTER(tx_header_bytes)                                                                         \
+  COUNTER(tx_reset)                                                                                \
+  HISTOGRAM(rx_header_compression_percent, Unspecified)                                            \
+  HISTOGRAM(tx_header_compression_percent, Unspecified)
 
 /**
  * Wrapper struct for the HTTP/2 codec stats. @see stats_macros.h
  */
 struct CodecStats {
-  ALL_HTTP2_CODEC_STATS(GENERATE_COUNTER_STRUCT)
+  ALL_HTTP2_CODEC_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
 class Utility {
@@ -152,7 +158,8 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
+    // Fills the connection's nv arena with the headers to submit and returns it.
+    const std::vector<nghttp2_nv>& buildHeaders(const HeaderMap& headers);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
@@ -279,6 +286,13 @@ protected:
 
   ConnectionImpl* base() { return this; }
   StreamImpl* getStream(int32_t stream_id);
+  bool neverIndex(absl::string_view key) const;
+  /**
+   * Drain the part of the buffer being dispatched which nghttp2 has processed.
+   * @param dispatched supplies the number of bytes passed to nghttp2 so far, counted from the start
+   *        of the buffer as it was when dispatch began.
+   */
+  void drainDispatched(uint64_t dispatched);
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
@@ -295,6 +309,23 @@ protected:
   bool allow_metadata_;
   const bool stream_error_on_invalid_http_messaging_;
   bool flood_detected_;
+  // Headers which are sent as never indexed HPACK literals.
+  const std::shared_ptr<const LowerCaseStrFlatHashSet> never_index_headers_;
+  // Reused by every stream of the connection to build the nghttp2_nv array of the headers it
+  // submits. nghttp2 copies the array on submission, so it only has to live until then.
+  std::vector<nghttp2_nv> nv_arena_;
+  // Uncompressed (name and value octets) and HPACK encoded (header block fragment octets) sizes of
+  // the headers sent and received on this connection, used to compute its compression ratio.
+  uint64_t tx_header_bytes_ = 0;
+  uint64_t tx_header_block_bytes_ = 0;
+  uint64_t rx_header_bytes_ = 0;
+  uint64_t rx_header_block_bytes_ = 0;
+  // The buffer being dispatched, the slice of it being processed by nghttp2 and the offset of that
+  // slice in the buffer, and how much of the buffer has been drained so far.
+  Buffer::Instance* dispatching_buffer_{};
+  Buffer::RawSlice dispatching_slice_{};
+  uint64_t dispatching_slice_offset_{};
+  uint64_t dispatching_drained_{};
 
   // Set if the type of frame that is about to be sent is PING or SETTINGS with the ACK flag set, or
   // RST_STREAM.
@@ -42,6 +42,12 @@ void ConnPoolImpl::ConnPoolImpl::drainConnections() {
   }
 }
 
+void ConnPoolImpl::prefetchConnections() {
+  if (drained_callbacks_.empty()) {
+    tryPrefetch(1);
+  }
+}
+
 void ConnPoolImpl::addDrainedCallback(DrainedCb cb) {
   drained_callbacks_.push_back(cb);
   checkForDrained();
@@ -87,6 +93,53 @@ void ConnPoolImpl::checkForDrained() {
   }
 }
 
+uint64_t ConnPoolImpl::activeStreams() {
+  uint64_t active_streams = 0;
+  if (primary_client_) {
+    active_streams += primary_client_->client_->numActiveRequests();
+  }
+
+  if (draining_client_) {
+    active_streams += draining_client_->client_->numActiveRequests();
+  }
+
+  return active_streams;
+}
+
+uint64_t ConnPoolImpl::streamCapacity() {
+  // The draining client can only carry the streams it already has.
+  uint64_t capacity = draining_client_ ? draining_client_->client_->numActiveRequests() : 0;
+  if (primary_client_) {
+    const uint64_t max_streams = maxStreamsPerConnection();
+    capacity += primary_client_->client_->numActiveRequests();
+    if (primary_client_->total_streams_ < max_streams) {
+      capacity += max_streams - primary_client_->total_streams_;
+    }
+  }
+
+  return capacity;
+}
+
+bool ConnPoolImpl::createPrefetchConnection() {
+  // Only one connection accepts new streams at a time, so the only connection that can be
+  // established ahead of demand is the primary one.
+  if (primary_client_) {
+    return false;
+  }
+
+  primary_client_ = std::make_unique<ActiveClient>(*this);
+  return true;
+}
+
+uint64_t ConnPoolImpl::maxStreamsPerConnection() {
+  uint64_t max_streams = host_->cluster().maxRequestsPerConnection();
+  if (max_streams == 0) {
+    max_streams = maxTotalStreams();
+  }
+
+  return max_streams;
+}
+
 void ConnPoolImpl::newClientStream(Http::StreamDecoder& response_decoder,
                                    ConnectionPool::Callbacks& callbacks) {
   if (!host_->cluster().resourceManager(priority_).requests().canCreate()) {
@@ -113,12 +166,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
   ASSERT(drained_callbacks_.empty());
 
   // First see if we need to handle max streams rollover.
-  uint64_t max_streams = host_->cluster().maxRequestsPerConnection();
-  if (max_streams == 0) {
-    max_streams = maxTotalStreams();
-  }
-
-  if (primary_client_ && primary_client_->total_streams_ >= max_streams) {
+  if (primary_client_ && primary_client_->total_streams_ >= maxStreamsPerConnection()) {
     movePrimaryClientToDraining();
   }
 
@@ -143,6 +191,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
   // We already have an active client that's connected to upstream, so attempt to establish a
   // new stream.
   newClientStream(response_decoder, callbacks);
+  tryPrefetch();
   return nullptr;
 }
 
@@ -34,6 +34,7 @@ public:
   Http::Protocol protocol() const override { return Http::Protocol::Http2; }
   void addDrainedCallback(DrainedCb cb) override;
   void drainConnections() override;
+  void prefetchConnections() override;
   bool hasActiveConnections() const override;
   ConnectionPool::Cancellable* newStream(Http::StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) override;
@@ -79,9 +80,13 @@ protected:
 
   // Http::ConnPoolImplBase
   void checkForDrained() override;
+  uint64_t activeStreams() override;
+  uint64_t streamCapacity() override;
+  bool createPrefetchConnection() override;
 
   virtual CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
   virtual uint32_t maxTotalStreams() PURE;
+  uint64_t maxStreamsPerConnection();
   void movePrimaryClientToDraining();
   void onConnectionEvent(ActiveClient& client, Network::ConnectionEvent event);
   void onConnectTimeout(ActiveClient& client);
@@ -0,0 +1,400 @@
+#include "common/http/shared_conn_pool.h"
+
+#include <memory>
+#include <string>
+
+#include "envoy/event/deferred_deletable.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// Holds a strong reference to a stream until the end of the current dispatcher iteration. This
+// allows either half of a stream to drop its reference from within a callback that is still
+// executing against the stream.
+template <class T> struct DeferredRelease : public Event::DeferredDeletable {
+  explicit DeferredRelease(std::shared_ptr<T>&& ptr) : ptr_(std::move(ptr)) {}
+  std::shared_ptr<T> ptr_;
+};
+
+template <class T> void deferredRelease(Event::Dispatcher& dispatcher, std::shared_ptr<T>&& ptr) {
+  if (ptr != nullptr) {
+    dispatcher.deferredDelete(std::make_unique<DeferredRelease<T>>(std::move(ptr)));
+  }
+}
+
+} // namespace
+
+bool SharedConnPoolOwner::post(Event::PostCb cb) {
+  absl::MutexLock lock(&lock_);
+  if (!valid_) {
+    return false;
+  }
+  dispatcher_.post(std::move(cb));
+  return true;
+}
+
+void SharedConnPoolOwner::invalidate() {
+  absl::MutexLock lock(&lock_);
+  valid_ = false;
+}
+
+SharedConnPoolImpl::SharedConnPoolImpl(Event::Dispatcher& dispatcher,
+                                       SharedConnPoolOwnerSharedPtr owner,
+                                       Upstream::HostConstSharedPtr host, Http::Protocol protocol,
+                                       OwnerPoolCb owner_pool_cb)
+    : dispatcher_(dispatcher), owner_(std::move(owner)), host_(std::move(host)),
+      protocol_(protocol), owner_pool_cb_(std::move(owner_pool_cb)) {
+  ASSERT(&dispatcher_ != &owner_->dispatcher());
+}
+
+SharedConnPoolImpl::~SharedConnPoolImpl() {
+  // Any stream still alive at this point is abandoned. Make sure the owner does not keep an
+  // upstream stream open on our behalf. If the owner is gone, so are its upstream streams.
+  for (const ActiveStreamSharedPtr& stream : active_streams_) {
+    stream->parent_ = nullptr;
+    stream->local_done_ = true;
+    stream->cancelled_ = true;
+    stream->postUpstream(
+        [](ActiveStream& stream) { stream.resetUpstream(StreamResetReason::LocalReset); });
+  }
+}
+
+void SharedConnPoolImpl::addDrainedCallback(DrainedCb cb) {
+  drained_callbacks_.push_back(cb);
+  checkForDrained();
+}
+
+void SharedConnPoolImpl::drainConnections() {
+  // This pool owns no connections. The owner worker receives the same host health and membership
+  // updates and drains its own pool.
+}
+
+void SharedConnPoolImpl::prefetchConnections() {
+  // This pool owns no connections. The owner worker prefetches for its own pool when it sees the
+  // same host being added.
+}
+
+ConnectionPool::Cancellable*
+SharedConnPoolImpl::newStream(Http::StreamDecoder& response_decoder,
+                              ConnectionPool::Callbacks& callbacks) {
+  ENVOY_LOG(debug, "handing off new stream to owner worker for host {}",
+            host_->address()->asString());
+  auto stream = std::make_shared<ActiveStream>(*this, response_decoder, callbacks);
+  if (!owner_->post([stream, owner_pool_cb = owner_pool_cb_]() -> void {
+        stream->startUpstream(owner_pool_cb);
+      })) {
+    ENVOY_LOG(debug, "owner worker for host {} is gone", host_->address()->asString());
+    stream->parent_ = nullptr;
+    stream->local_done_ = true;
+    callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure,
+                            absl::string_view(), host_);
+    return nullptr;
+  }
+
+  active_streams_.push_back(stream);
+  stream->entry_ = std::prev(active_streams_.end());
+  return stream.get();
+}
+
+void SharedConnPoolImpl::onStreamDone(ActiveStream& stream) {
+  ASSERT(stream.parent_ == this);
+  stream.parent_ = nullptr;
+  ActiveStreamSharedPtr owned = std::move(*stream.entry_);
+  active_streams_.erase(stream.entry_);
+  deferredRelease(dispatcher_, std::move(owned));
+  checkForDrained();
+}
+
+void SharedConnPoolImpl::checkForDrained() {
+  if (drained_callbacks_.empty() || !active_streams_.empty()) {
+    return;
+  }
+
+  ENVOY_LOG(debug, "invoking drained callbacks");
+  for (const DrainedCb& cb : drained_callbacks_) {
+    cb();
+  }
+}
+
+SharedConnPoolImpl::ActiveStream::ActiveStream(SharedConnPoolImpl& parent,
+                                               StreamDecoder& response_decoder,
+                                               ConnectionPool::Callbacks& callbacks)
+    : parent_(&parent), dispatcher_(parent.dispatcher_), owner_(parent.owner_), host_(parent.host_),
+      response_decoder_(response_decoder), callbacks_(callbacks),
+      stream_info_(parent.protocol_, parent.dispatcher_.timeSource()) {}
+
+void SharedConnPoolImpl::ActiveStream::postUpstream(std::function<void(ActiveStream&)> cb) {
+  owner_->post([self = shared_from_this(), cb]() -> void { cb(*self); });
+}
+
+void SharedConnPoolImpl::ActiveStream::postDownstream(std::function<void(ActiveStream&)> cb) {
+  // The downstream half may be reset, and the stream released by the pool, before the callback
+  // runs, so only a weak reference to the stream is posted.
+  dispatcher_.post([weak_self = std::weak_ptr<ActiveStream>(shared_from_this()), cb]() -> void {
+    ActiveStreamSharedPtr self = weak_self.lock();
+    if (self == nullptr || self->local_done_) {
+      return;
+    }
+    cb(*self);
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::onLocalDone() {
+  local_done_ = true;
+  if (parent_ != nullptr) {
+    parent_->onStreamDone(*this);
+  }
+}
+
+void SharedConnPoolImpl::ActiveStream::maybeLocalDone() {
+  if (local_request_complete_ && local_response_complete_) {
+    onLocalDone();
+  }
+}
+
+void SharedConnPoolImpl::ActiveStream::cancel() {
+  ENVOY_LOG(debug, "cancelling shared pool stream");
+  cancelled_ = true;
+  postUpstream([](ActiveStream& stream) { stream.resetUpstream(StreamResetReason::LocalReset); });
+  onLocalDone();
+}
+
+void SharedConnPoolImpl::ActiveStream::encode100ContinueHeaders(const HeaderMap& headers) {
+  auto headers_copy = std::make_shared<HeaderMapImpl>(headers);
+  postUpstream([headers_copy](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->encode100ContinueHeaders(*headers_copy);
+    }
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::encodeHeaders(const HeaderMap& headers, bool end_stream) {
+  auto headers_copy = std::make_shared<HeaderMapImpl>(headers);
+  postUpstream([headers_copy, end_stream](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->encodeHeaders(*headers_copy, end_stream);
+      stream.onUpstreamEndStream(end_stream, false);
+    }
+  });
+  onLocalRequestEncoded(end_stream);
+}
+
+void SharedConnPoolImpl::ActiveStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  auto data_copy = std::make_shared<Buffer::OwnedImpl>();
+  data_copy->move(data);
+  postUpstream([data_copy, end_stream](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->encodeData(*data_copy, end_stream);
+      stream.onUpstreamEndStream(end_stream, false);
+    }
+  });
+  onLocalRequestEncoded(end_stream);
+}
+
+void SharedConnPoolImpl::ActiveStream::encodeTrailers(const HeaderMap& trailers) {
+  auto trailers_copy = std::make_shared<HeaderMapImpl>(trailers);
+  postUpstream([trailers_copy](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->encodeTrailers(*trailers_copy);
+      stream.onUpstreamEndStream(true, false);
+    }
+  });
+  onLocalRequestEncoded(true);
+}
+
+void SharedConnPoolImpl::ActiveStream::encodeMetadata(
+    const MetadataMapVector& metadata_map_vector) {
+  auto metadata_copy = std::make_shared<MetadataMapVector>();
+  for (const MetadataMapPtr& metadata_map : metadata_map_vector) {
+    metadata_copy->emplace_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  postUpstream([metadata_copy](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->encodeMetadata(*metadata_copy);
+    }
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::onLocalRequestEncoded(bool end_stream) {
+  if (!end_stream) {
+    return;
+  }
+  local_end_stream_ = true;
+  local_request_complete_ = true;
+  maybeLocalDone();
+}
+
+void SharedConnPoolImpl::ActiveStream::resetStream(StreamResetReason reason) {
+  if (local_done_) {
+    return;
+  }
+  cancelled_ = true;
+  postUpstream([reason](ActiveStream& stream) { stream.resetUpstream(reason); });
+  onLocalDone();
+  runResetCallbacks(reason);
+}
+
+void SharedConnPoolImpl::ActiveStream::readDisable(bool disable) {
+  postUpstream([disable](ActiveStream& stream) {
+    if (stream.upstream_encoder_ != nullptr) {
+      stream.upstream_encoder_->getStream().readDisable(disable);
+    }
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::startUpstream(const OwnerPoolCb& owner_pool_cb) {
+  if (cancelled_) {
+    return;
+  }
+
+  ConnectionPool::Instance* pool = owner_pool_cb();
+  if (pool == nullptr) {
+    ENVOY_LOG(debug, "owner worker has no pool for host {}", host_->address()->asString());
+    postDownstream([](ActiveStream& stream) {
+      stream.onLocalDone();
+      stream.callbacks_.onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure,
+                                      absl::string_view(), stream.host_);
+    });
+    return;
+  }
+
+  upstream_self_ = shared_from_this();
+  ConnectionPool::Cancellable* handle = pool->newStream(*this, *this);
+  if (handle != nullptr) {
+    upstream_handle_ = handle;
+  }
+}
+
+void SharedConnPoolImpl::ActiveStream::resetUpstream(StreamResetReason reason) {
+  if (upstream_handle_ != nullptr) {
+    upstream_handle_->cancel();
+    upstream_handle_ = nullptr;
+    releaseUpstream();
+  } else if (upstream_encoder_ != nullptr) {
+    StreamEncoder* encoder = upstream_encoder_;
+    upstream_encoder_ = nullptr;
+    encoder->getStream().removeCallbacks(*this);
+    encoder->getStream().resetStream(reason);
+    releaseUpstream();
+  }
+}
+
+void SharedConnPoolImpl::ActiveStream::onUpstreamEndStream(bool request_end_stream,
+                                                           bool response_end_stream) {
+  upstream_request_complete_ |= request_end_stream;
+  upstream_response_complete_ |= response_end_stream;
+  if (upstream_request_complete_ && upstream_response_complete_ && upstream_encoder_ != nullptr) {
+    upstream_encoder_->getStream().removeCallbacks(*this);
+    upstream_encoder_ = nullptr;
+    releaseUpstream();
+  }
+}
+
+void SharedConnPoolImpl::ActiveStream::releaseUpstream() {
+  deferredRelease(owner_->dispatcher(), std::move(upstream_self_));
+}
+
+void SharedConnPoolImpl::ActiveStream::decode100ContinueHeaders(HeaderMapPtr&& headers) {
+  auto headers_holder = std::make_shared<HeaderMapPtr>(std::move(headers));
+  postDownstream([headers_holder](ActiveStream& stream) {
+    stream.response_decoder_.decode100ContinueHeaders(std::move(*headers_holder));
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers, bool end_stream) {
+  auto headers_holder = std::make_shared<HeaderMapPtr>(std::move(headers));
+  postDownstream([headers_holder, end_stream](ActiveStream& stream) {
+    stream.local_response_complete_ = end_stream;
+    stream.response_decoder_.decodeHeaders(std::move(*headers_holder), end_stream);
+    stream.maybeLocalDone();
+  });
+  onUpstreamEndStream(false, end_stream);
+}
+
+void SharedConnPoolImpl::ActiveStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  auto data_copy = std::make_shared<Buffer::OwnedImpl>();
+  data_copy->move(data);
+  postDownstream([data_copy, end_stream](ActiveStream& stream) {
+    stream.local_response_complete_ = end_stream;
+    stream.response_decoder_.decodeData(*data_copy, end_stream);
+    stream.maybeLocalDone();
+  });
+  onUpstreamEndStream(false, end_stream);
+}
+
+void SharedConnPoolImpl::ActiveStream::decodeTrailers(HeaderMapPtr&& trailers) {
+  auto trailers_holder = std::make_shared<HeaderMapPtr>(std::move(trailers));
+  postDownstream([trailers_holder](ActiveStream& stream) {
+    stream.local_response_complete_ = true;
+    stream.response_decoder_.decodeTrailers(std::move(*trailers_holder));
+    stream.maybeLocalDone();
+  });
+  onUpstreamEndStream(false, true);
+}
+
+void SharedConnPoolImpl::ActiveStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  auto metadata_holder = std::make_shared<MetadataMapPtr>(std::move(metadata_map));
+  postDownstream([metadata_holder](ActiveStream& stream) {
+    stream.response_decoder_.decodeMetadata(std::move(*metadata_holder));
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::onResetStream(StreamResetReason reason,
+                                                     absl::string_view) {
+  upstream_encoder_ = nullptr;
+  releaseUpstream();
+  postDownstream([reason](ActiveStream& stream) {
+    stream.onLocalDone();
+    stream.runResetCallbacks(reason);
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::onAboveWriteBufferHighWatermark() {
+  postDownstream([](ActiveStream& stream) { stream.runHighWatermarkCallbacks(); });
+}
+
+void SharedConnPoolImpl::ActiveStream::onBelowWriteBufferLowWatermark() {
+  postDownstream([](ActiveStream& stream) { stream.runLowWatermarkCallbacks(); });
+}
+
+void SharedConnPoolImpl::ActiveStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                     absl::string_view transport_failure_reason,
+                                                     Upstream::HostDescriptionConstSharedPtr host) {
+  upstream_handle_ = nullptr;
+  releaseUpstream();
+  postDownstream([reason, failure_reason = std::string(transport_failure_reason),
+                  host](ActiveStream& stream) {
+    stream.onLocalDone();
+    stream.callbacks_.onPoolFailure(reason, failure_reason, host);
+  });
+}
+
+void SharedConnPoolImpl::ActiveStream::onPoolReady(StreamEncoder& encoder,
+                                                   Upstream::HostDescriptionConstSharedPtr host,
+                                                   const StreamInfo::StreamInfo&) {
+  upstream_handle_ = nullptr;
+  if (cancelled_) {
+    // The downstream half went away while the owner pool was connecting. The reset posted by
+    // the downstream half will find nothing left to do.
+    encoder.getStream().resetStream(StreamResetReason::LocalReset);
+    releaseUpstream();
+    return;
+  }
+
+  upstream_encoder_ = &encoder;
+  encoder.getStream().addCallbacks(*this);
+  const uint32_t buffer_limit = encoder.getStream().bufferLimit();
+  postDownstream([host, buffer_limit](ActiveStream& stream) {
+    stream.buffer_limit_ = buffer_limit;
+    stream.callbacks_.onPoolReady(stream, host, stream.stream_info_);
+  });
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/logger.h"
+#include "common/http/codec_helper.h"
+#include "common/stream_info/stream_info_impl.h"
+
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * The dispatcher of a worker that owns shared connection pools. The handle is invalidated when the
+ * worker stops owning pools, before its dispatcher is destroyed, so that the pools and streams of
+ * other workers never post to a dispatcher that is gone.
+ */
+class SharedConnPoolOwner {
+public:
+  explicit SharedConnPoolOwner(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+  /**
+   * Posts a callback to the owner dispatcher.
+   * @return false, dropping the callback, if the owner has been invalidated.
+   */
+  bool post(Event::PostCb cb);
+
+  /**
+   * Invalidates the handle. Called on the owner worker when it stops owning pools.
+   */
+  void invalidate();
+
+  /**
+   * @return the owner dispatcher. Only to be used on the owner worker, or for comparisons.
+   */
+  Event::Dispatcher& dispatcher() const { return dispatcher_; }
+
+private:
+  Event::Dispatcher& dispatcher_;
+  absl::Mutex lock_;
+  bool valid_ ABSL_GUARDED_BY(lock_){true};
+};
+
+using SharedConnPoolOwnerSharedPtr = std::shared_ptr<SharedConnPoolOwner>;
+
+/**
+ * A connection pool that does not own any connections. Streams are handed off to a connection
+ * pool owned by another worker (the "owner") by posting to the owner's dispatcher, and all events
+ * for the stream are posted back to the dispatcher of the worker that created the stream. This
+ * trades one dispatcher hop in each direction for a single set of upstream connections per host
+ * instead of one per worker, and is only suitable for multiplexing protocols (HTTP/2).
+ *
+ * Threading: all methods of this class and the "downstream" half of each ActiveStream run on the
+ * local dispatcher. The "upstream" half of each ActiveStream runs on the owner dispatcher. The
+ * two halves only communicate via posted callbacks. Callbacks posted to the owner hold a strong
+ * reference to the stream, and callbacks posted back hold a weak reference and are dropped once the
+ * downstream half is done with the stream.
+ *
+ * Known limitations: upstream flow control is not propagated across the dispatcher hop other than
+ * via readDisable(), and the upstream SSL connection info is not exposed to the requesting worker.
+ */
+class SharedConnPoolImpl : public ConnectionPool::Instance,
+                           protected Logger::Loggable<Logger::Id::pool> {
+public:
+  /**
+   * Returns the pool on the owner worker that streams should be created on. This is only ever
+   * invoked on the owner dispatcher. It may return nullptr if the owner no longer knows about the
+   * host or cluster, in which case the stream fails with a connection failure.
+   */
+  using OwnerPoolCb = std::function<ConnectionPool::Instance*()>;
+
+  SharedConnPoolImpl(Event::Dispatcher& dispatcher, SharedConnPoolOwnerSharedPtr owner,
+                     Upstream::HostConstSharedPtr host, Http::Protocol protocol,
+                     OwnerPoolCb owner_pool_cb);
+  ~SharedConnPoolImpl() override;
+
+  // Http::ConnectionPool::Instance
+  Http::Protocol protocol() const override { return protocol_; }
+  void addDrainedCallback(DrainedCb cb) override;
+  void drainConnections() override;
+  void prefetchConnections() override;
+  bool hasActiveConnections() const override { return !active_streams_.empty(); }
+  ConnectionPool::Cancellable* newStream(Http::StreamDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override;
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+
+private:
+  struct ActiveStream;
+  using ActiveStreamSharedPtr = std::shared_ptr<ActiveStream>;
+
+  struct ActiveStream : public std::enable_shared_from_this<ActiveStream>,
+                        public ConnectionPool::Cancellable,
+                        public StreamEncoder,
+                        public Stream,
+                        public StreamCallbackHelper,
+                        public StreamDecoder,
+                        public StreamCallbacks,
+                        public ConnectionPool::Callbacks {
+    ActiveStream(SharedConnPoolImpl& parent, StreamDecoder& response_decoder,
+                 ConnectionPool::Callbacks& callbacks);
+
+    // Downstream half, local dispatcher only.
+
+    // Http::ConnectionPool::Cancellable
+    void cancel() override;
+
+    // Http::StreamEncoder
+    void encode100ContinueHeaders(const HeaderMap& headers) override;
+    void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
+    void encodeData(Buffer::Instance& data, bool end_stream) override;
+    void encodeTrailers(const HeaderMap& trailers) override;
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+    Stream& getStream() override { return *this; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacks_(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacks_(callbacks); }
+    void resetStream(StreamResetReason reason) override;
+    void readDisable(bool disable) override;
+    uint32_t bufferLimit() override { return buffer_limit_; }
+
+    void postUpstream(std::function<void(ActiveStream&)> cb);
+    void onLocalRequestEncoded(bool end_stream);
+    void onLocalDone();
+    void maybeLocalDone();
+
+    // Upstream half, owner dispatcher only.
+
+    void startUpstream(const OwnerPoolCb& owner_pool_cb);
+    void resetUpstream(StreamResetReason reason);
+    void onUpstreamEndStream(bool request_end_stream, bool response_end_stream);
+    void releaseUpstream();
+
+    // Http::StreamDecoder
+    void decode100ContinueHeaders(HeaderMapPtr&& headers) override;
+    void decodeHeaders(HeaderMapPtr&& headers, bool end_stream) override;
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeTrailers(HeaderMapPtr&& trailers) override;
+    void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason,
+                       absl::string_view transport_failure_reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+    // Http::ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       absl::string_view transport_failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(StreamEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                     const StreamInfo::StreamInfo& info) override;
+
+    void postDownstream(std::function<void(ActiveStream&)> cb);
+
+    // Shared state. Set by the downstream half, read by the upstream half so that work which
+    // is already queued on the owner dispatcher can be short circuited.
+    std::atomic<bool> cancelled_{false};
+
+    // Downstream half state. dispatcher_, owner_ and host_ are immutable and may be read from
+    // either half.
+    SharedConnPoolImpl* parent_;
+    Event::Dispatcher& dispatcher_;
+    const SharedConnPoolOwnerSharedPtr owner_;
+    const Upstream::HostConstSharedPtr host_;
+    StreamDecoder& response_decoder_;
+    ConnectionPool::Callbacks& callbacks_;
+    std::list<ActiveStreamSharedPtr>::iterator entry_;
+    // Stands in for the upstream connection's stream info, which lives on the owner worker.
+    StreamInfo::StreamInfoImpl stream_info_;
+    uint32_t buffer_limit_{};
+    bool ready_{};
+    bool local_request_complete_{};
+    bool local_response_complete_{};
+    bool local_done_{};
+
+    // Upstream half state.
+    ConnectionPool::Cancellable* upstream_handle_{};
+    StreamEncoder* upstream_encoder_{};
+    // Keeps the stream alive while the owner pool or codec holds references to it.
+    ActiveStreamSharedPtr upstream_self_;
+    bool upstream_request_complete_{};
+    bool upstream_response_complete_{};
+  };
+
+  void onStreamDone(ActiveStream& stream);
+  void checkForDrained();
+
+  Event::Dispatcher& dispatcher_;
+  const SharedConnPoolOwnerSharedPtr owner_;
+  const Upstream::HostConstSharedPtr host_;
+  const Http::Protocol protocol_;
+  const OwnerPoolCb owner_pool_cb_;
+  std::list<ActiveStreamSharedPtr> active_streams_;
+  std::list<DrainedCb> drained_callbacks_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -267,6 +267,19 @@ Utility::parseHttp2Settings(const envoy::api::v2::core::Http2ProtocolOptions& co
   ret.allow_connect_ = config.allow_connect();
   ret.allow_metadata_ = config.allow_metadata();
   ret.stream_error_on_invalid_http_messaging_ = config.stream_error_on_invalid_http_messaging();
+  if (config.has_encoder_hpack_table_size()) {
+    ret.encoder_hpack_table_size_ = config.encoder_hpack_table_size().value();
+  }
+  if (config.has_decoder_hpack_table_size()) {
+    ret.decoder_hpack_table_size_ = config.decoder_hpack_table_size().value();
+  }
+  if (!config.never_index_headers().empty()) {
+    auto never_index_headers = std::make_shared<LowerCaseStrFlatHashSet>();
+    for (const std::string& name : config.never_index_headers()) {
+      never_index_headers->emplace(name);
+    }
+    ret.never_index_headers_ = std::move(never_index_headers);
+  }
   return ret;
 }
 
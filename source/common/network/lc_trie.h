@@ -4,12 +4,14 @@
 
 #include <algorithm>
 #include <climits>
+#include <cstring>
 #include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/network/address.h"
 
 #include "common/common/assert.h"
+#include "common/common/macros.h"
 #include "common/network/address_impl.h"
 #include "common/network/cidr_range.h"
 #include "common/network/utility.h"
@@ -28,6 +30,16 @@ namespace LcTrie {
  */
 constexpr size_t MaxLcTrieNodes = (1 << 20);
 
+/**
+ * Size of the cache lines which the trie nodes and leaves are laid out for.
+ */
+constexpr size_t CacheLineSize = 64;
+
+/**
+ * Number of addresses which a batch lookup walks through the trie together.
+ */
+constexpr size_t LookupBatchSize = 8;
+
 /**
  * Level Compressed Trie for associating data with CIDR ranges. Both IPv4 and IPv6 addresses are
  * supported within this class with no calling pattern changes.
@@ -181,12 +193,63 @@ public:
    * version of the ip_address.
    */
   std::vector<T> getData(const Network::Address::InstanceConstSharedPtr& ip_address) const {
-    if (ip_address->ip()->version() == Address::IpVersion::v4) {
-      Ipv4 ip = ntohl(ip_address->ip()->ipv4()->address());
-      return ipv4_trie_->getData(ip);
+    std::vector<T> data;
+    getData(*ip_address, data);
+    return data;
+  }
+
+  /**
+   * Retrieve data associated with the CIDR range that contains `ip_address`, without allocating
+   * when `data` has room for it, e.g. when it is an absl::InlinedVector large enough for the data
+   * of the most nested CIDR ranges.
+   * @param ip_address supplies the IP address.
+   * @param data supplies the container, such as a std::vector or absl::InlinedVector, to which the
+   *             data from the CIDR ranges that contain 'ip_address' is appended.
+   */
+  template <class Container>
+  void getData(const Network::Address::Instance& ip_address, Container& data) const {
+    if (ip_address.ip()->version() == Address::IpVersion::v4) {
+      Ipv4 ip = ntohl(ip_address.ip()->ipv4()->address());
+      ipv4_trie_->appendData(ipv4_trie_->findLeaf(ip), data);
     } else {
-      Ipv6 ip = Utility::Ip6ntohl(ip_address->ip()->ipv6()->address());
-      return ipv6_trie_->getData(ip);
+      Ipv6 ip = Utility::Ip6ntohl(ip_address.ip()->ipv6()->address());
+      ipv6_trie_->appendData(ipv6_trie_->findLeaf(ip), data);
+    }
+  }
+
+  /**
+   * Retrieve data associated with the CIDR ranges that contain each of `ip_addresses`. The
+   * addresses are looked up in groups of LookupBatchSize which walk through the trie together,
+   * prefetching the node that each of them needs next, so that the cache misses of the lookups
+   * overlap rather than follow one another.
+   * @param ip_addresses supplies the IP addresses.
+   * @param data supplies a container for each IP address, to which its data is appended as by
+   *             getData(const Network::Address::Instance&, Container&).
+   */
+  template <class Container>
+  void getData(const std::vector<Network::Address::InstanceConstSharedPtr>& ip_addresses,
+               std::vector<Container>& data) const {
+    ASSERT(data.size() >= ip_addresses.size());
+    for (size_t first = 0; first < ip_addresses.size(); first += LookupBatchSize) {
+      const size_t count = std::min(LookupBatchSize, ip_addresses.size() - first);
+      Ipv4 ipv4_addresses[LookupBatchSize];
+      Ipv6 ipv6_addresses[LookupBatchSize];
+      size_t ipv4_indexes[LookupBatchSize];
+      size_t ipv6_indexes[LookupBatchSize];
+      size_t ipv4_count = 0;
+      size_t ipv6_count = 0;
+      for (size_t i = first; i < first + count; i++) {
+        const Address::Ip& ip = *ip_addresses[i]->ip();
+        if (ip.version() == Address::IpVersion::v4) {
+          ipv4_indexes[ipv4_count] = i;
+          ipv4_addresses[ipv4_count++] = ntohl(ip.ipv4()->address());
+        } else {
+          ipv6_indexes[ipv6_count] = i;
+          ipv6_addresses[ipv6_count++] = Utility::Ip6ntohl(ip.ipv6()->address());
+        }
+      }
+      appendBatchData(*ipv4_trie_, ipv4_addresses, ipv4_indexes, ipv4_count, data);
+      appendBatchData(*ipv6_trie_, ipv6_addresses, ipv6_indexes, ipv6_count, data);
     }
   }
 
@@ -226,6 +289,52 @@ private:
     return input << n >> n;
   }
 
+  /**
+   * Hint the CPU to load the cache line at addr, which is going to be read.
+   */
+  static void prefetch(const void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#else
+    UNREFERENCED_PARAMETER(addr);
+#endif
+  }
+
+  /**
+   * Copy of an array which starts at a cache line boundary, as operator new only guarantees the
+   * alignment of fundamental types. Elements whose size divides the cache line size are then
+   * never split across two cache lines.
+   */
+  template <class Element> class CacheAlignedArray {
+  public:
+    CacheAlignedArray() = default;
+
+    explicit CacheAlignedArray(const std::vector<Element>& elements) : size_(elements.size()) {
+      static_assert(std::is_trivially_copyable<Element>::value,
+                    "elements are copied into raw storage");
+      static_assert(CacheLineSize % sizeof(Element) == 0,
+                    "elements must not be split across cache lines");
+      if (elements.empty()) {
+        return;
+      }
+      size_t space = size_ * sizeof(Element) + CacheLineSize;
+      storage_ = std::make_unique<char[]>(space);
+      void* begin = storage_.get();
+      std::align(CacheLineSize, size_ * sizeof(Element), begin, space);
+      memcpy(begin, elements.data(), size_ * sizeof(Element));
+      begin_ = static_cast<const Element*>(begin);
+    }
+
+    const Element& operator[](size_t i) const { return begin_[i]; }
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+  private:
+    std::unique_ptr<char[]> storage_;
+    const Element* begin_{};
+    size_t size_{};
+  };
+
   // IP addresses are stored in host byte order to simplify
   using Ipv4 = uint32_t;
   using Ipv6 = absl::uint128;
@@ -297,6 +406,23 @@ private:
     DataSet data_;
   };
 
+  /**
+   * A CIDR range at a leaf of the LC trie, with the range [data_begin_, data_end_) of the data
+   * of the trie which applies to it. A leaf is 16 bytes for IPv4 and 32 bytes for IPv6, so that
+   * checking whether it contains an address reads a single cache line.
+   */
+  template <class IpType, uint32_t address_size = CHAR_BIT * sizeof(IpType)> struct Leaf {
+    bool contains(const IpType& address) const {
+      return (extractBits<IpType, address_size>(0, length_, ip_) ==
+              extractBits<IpType, address_size>(0, length_, address));
+    }
+
+    IpType ip_;
+    uint32_t length_;
+    uint32_t data_begin_;
+    uint32_t data_end_;
+  };
+
   /**
    * Binary trie used to simplify the construction of Level Compressed Tries.
    * This data type supports two operations:
@@ -425,12 +551,30 @@ private:
                    uint32_t root_branching_factor);
 
     /**
-     * Retrieve the data associated with the CIDR range that contains `ip_address`.
+     * Find the leaf with the CIDR range that contains `ip_address`.
      * @param  ip_address supplies the IP address in host byte order.
-     * @return a vector of data from the CIDR ranges and IP addresses that encompasses the input.
-     * An empty vector is returned if the LC Trie is empty.
+     * @return the leaf, or nullptr if no CIDR range contains the address or the LC Trie is empty.
+     */
+    const Leaf<IpType>* findLeaf(const IpType& ip_address) const;
+
+    /**
+     * Find the leaves with the CIDR ranges that contain each of `count` addresses, walking the
+     * trie for all of them in lockstep.
+     * @param ip_addresses supplies the IP addresses in host byte order.
+     * @param count supplies the number of addresses, at most LookupBatchSize.
+     * @param leaves supplies the array in which the leaf of each address, or nullptr, is stored.
+     */
+    void findLeaves(const IpType* ip_addresses, size_t count, const Leaf<IpType>** leaves) const;
+
+    /**
+     * Append the data of a leaf found by findLeaf() or findLeaves() to `data`.
      */
-    std::vector<T> getData(const IpType& ip_address) const;
+    template <class Container> void appendData(const Leaf<IpType>* leaf, Container& data) const {
+      if (leaf != nullptr) {
+        data.insert(data.end(), data_.begin() + leaf->data_begin_,
+                    data_.begin() + leaf->data_end_);
+      }
+    }
 
   private:
     /**
@@ -453,7 +597,23 @@ private:
       // The value of next_free_index is the final size of the trie_.
       ASSERT(next_free_index <= trie_.size());
       trie_.resize(next_free_index);
+      nodes_ = CacheAlignedArray<LcNode>(trie_);
+      trie_.clear();
       trie_.shrink_to_fit();
+
+      // Lay out the CIDR ranges and their data for lookups. The data of each range is stored
+      // contiguously so that it is copied out without walking a hash set.
+      std::vector<Leaf<IpType>> leaves;
+      leaves.reserve(ip_prefixes_.size());
+      for (const IpPrefix<IpType>& prefix : ip_prefixes_) {
+        const uint32_t data_begin = data_.size();
+        data_.insert(data_.end(), prefix.data_.begin(), prefix.data_.end());
+        leaves.push_back(
+            {prefix.ip_, prefix.length_, data_begin, static_cast<uint32_t>(data_.size())});
+      }
+      leaves_ = CacheAlignedArray<Leaf<IpType>>(leaves);
+      ip_prefixes_.clear();
+      ip_prefixes_.shrink_to_fit();
     }
 
     // Thin wrapper around computeBranch output to facilitate code readability.
@@ -592,6 +752,17 @@ private:
 
       ComputePair output = computeBranchAndSkip(prefix, first, n);
 
+      // The nodes of an IPv6 trie are packed so that the children of a node, when they fit in a
+      // cache line, do not straddle two of them. IPv6 tries are deeper, so a lookup reads more
+      // nodes, and a straddling block of children makes some of those reads cost two misses.
+      if (address_size > CHAR_BIT * sizeof(Ipv4)) {
+        const uint32_t block_size = 1 << output.branch_;
+        const uint32_t line_offset = next_free_index % NodesPerCacheLine;
+        if (block_size <= NodesPerCacheLine && line_offset + block_size > NodesPerCacheLine) {
+          next_free_index += NodesPerCacheLine - line_offset;
+        }
+      }
+
       uint32_t address = next_free_index;
       trie_[position].branch_ = output.branch_;
       // The skip value is the number of bits between the newly calculated prefix(output.prefix_)
@@ -678,20 +849,43 @@ private:
       uint32_t address_ : 20; // If this 20-bit size changes, please change MaxLcTrieNodes too.
     };
 
+    static constexpr uint32_t NodesPerCacheLine = CacheLineSize / sizeof(LcNode);
+
+    // The CIDR ranges, sorted, while the trie is being built.
+    std::vector<IpPrefix<IpType>> ip_prefixes_;
+
+    // The trie while it is being built.
+    std::vector<LcNode> trie_;
+
     // The CIDR range and data needs to be maintained separately from the LC-Trie. A LC-Trie skips
     // chunks of data while searching for a match. This means that the node found in the LC-Trie
     // is not guaranteed to have the IP address in range. The last step prior to returning
     // associated data is to check the CIDR range pointed to by the node in the LC-Trie has
     // the IP address in range.
-    std::vector<IpPrefix<IpType>> ip_prefixes_;
+    CacheAlignedArray<Leaf<IpType>> leaves_;
+    std::vector<T> data_;
 
     // Main trie search structure.
-    std::vector<LcNode> trie_;
+    CacheAlignedArray<LcNode> nodes_;
 
     const double fill_factor_;
     const uint32_t root_branching_factor_;
   };
 
+  template <class IpType, class Container>
+  static void appendBatchData(const LcTrieInternal<IpType>& trie, const IpType* ip_addresses,
+                              const size_t* indexes, size_t count,
+                              std::vector<Container>& data) {
+    if (count == 0) {
+      return;
+    }
+    const Leaf<IpType>* leaves[LookupBatchSize];
+    trie.findLeaves(ip_addresses, count, leaves);
+    for (size_t i = 0; i < count; i++) {
+      trie.appendData(leaves[i], data[indexes[i]]);
+    }
+  }
+
   std::unique_ptr<LcTrieInternal<Ipv4>> ipv4_trie_;
   std::unique_ptr<LcTrieInternal<Ipv6>> ipv6_trie_;
 };
@@ -707,14 +901,13 @@ LcTrie<T>::LcTrieInternal<IpType, address_size>::LcTrieInternal(std::vector<IpPr
 
 template <class T>
 template <class IpType, uint32_t address_size>
-std::vector<T>
-LcTrie<T>::LcTrieInternal<IpType, address_size>::getData(const IpType& ip_address) const {
-  std::vector<T> return_vector;
-  if (trie_.empty()) {
-    return return_vector;
+const typename LcTrie<T>::template Leaf<IpType>*
+LcTrie<T>::LcTrieInternal<IpType, address_size>::findLeaf(const IpType& ip_address) const {
+  if (nodes_.empty()) {
+    return nullptr;
   }
 
-  LcNode node = trie_[0];
+  LcNode node = nodes_[0];
   uint32_t branch = node.branch_;
   uint32_t position = node.skip_;
   uint32_t address = node.address_;
@@ -723,8 +916,8 @@ LcTrie<T>::LcTrieInternal<IpType, address_size>::getData(const IpType& ip_addres
   while (branch != 0) {
     // branch is at most 2^5-1= 31 bits to extract, so we can safely cast the
     // output of extractBits to uint32_t without any data loss.
-    node = trie_[address + static_cast<uint32_t>(
-                               extractBits<IpType, address_size>(position, branch, ip_address))];
+    node = nodes_[address + static_cast<uint32_t>(
+                                extractBits<IpType, address_size>(position, branch, ip_address))];
     position += branch + node.skip_;
     branch = node.branch_;
     address = node.address_;
@@ -733,11 +926,62 @@ LcTrie<T>::LcTrieInternal<IpType, address_size>::getData(const IpType& ip_addres
   // The path taken through the trie to match the ip_address may have contained skips,
   // so it is necessary to check whether the matched prefix really contains the
   // ip_address.
-  const auto& prefix = ip_prefixes_[address];
-  if (prefix.contains(ip_address)) {
-    return std::vector<T>(prefix.data_.begin(), prefix.data_.end());
+  const Leaf<IpType>& leaf = leaves_[address];
+  return leaf.contains(ip_address) ? &leaf : nullptr;
+}
+
+template <class T>
+template <class IpType, uint32_t address_size>
+void LcTrie<T>::LcTrieInternal<IpType, address_size>::findLeaves(
+    const IpType* ip_addresses, size_t count, const Leaf<IpType>** leaves) const {
+  ASSERT(count <= LookupBatchSize);
+  if (nodes_.empty()) {
+    std::fill(leaves, leaves + count, nullptr);
+    return;
+  }
+
+  // The state of each lookup, as in findLeaf().
+  uint32_t branch[LookupBatchSize];
+  uint32_t position[LookupBatchSize];
+  uint32_t address[LookupBatchSize];
+  const LcNode root = nodes_[0];
+  for (size_t i = 0; i < count; i++) {
+    branch[i] = root.branch_;
+    position[i] = root.skip_;
+    address[i] = root.address_;
+  }
+
+  // Take one step down the trie for each lookup which has not reached a leaf. The next nodes of
+  // all the lookups are prefetched before any of them is read.
+  bool descending = root.branch_ != 0;
+  while (descending) {
+    uint32_t next[LookupBatchSize];
+    for (size_t i = 0; i < count; i++) {
+      if (branch[i] != 0) {
+        next[i] = address[i] + static_cast<uint32_t>(extractBits<IpType, address_size>(
+                                   position[i], branch[i], ip_addresses[i]));
+        prefetch(&nodes_[next[i]]);
+      }
+    }
+    descending = false;
+    for (size_t i = 0; i < count; i++) {
+      if (branch[i] != 0) {
+        const LcNode node = nodes_[next[i]];
+        position[i] += branch[i] + node.skip_;
+        branch[i] = node.branch_;
+        address[i] = node.address_;
+        descending |= branch[i] != 0;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    prefetch(&leaves_[address[i]]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    const Leaf<IpType>& leaf = leaves_[address[i]];
+    leaves[i] = leaf.contains(ip_addresses[i]) ? &leaf : nullptr;
   }
-  return std::vector<T>();
 }
 
 } // namespace LcTrie
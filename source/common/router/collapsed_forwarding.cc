@@ -0,0 +1,190 @@
+#include "common/router/collapsed_forwarding.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+
+namespace Envoy {
+namespace Router {
+
+SINGLETON_MANAGER_REGISTRATION(collapsed_forwarding_slot);
+
+namespace {
+
+// References a part of a response body from the buffer of a collapsed request without copying it.
+class SharedBodyFragment : public Buffer::BufferFragment {
+public:
+  SharedBodyFragment(const std::shared_ptr<const std::string>& data) : data_(data) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return data_->data(); }
+  size_t size() const override { return data_->size(); }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const std::string> data_;
+};
+
+void sendBody(CollapsedRequestCallbacks& request, const std::shared_ptr<const std::string>& data,
+              bool end_stream) {
+  Buffer::OwnedImpl buffer;
+  if (!data->empty()) {
+    buffer.addBufferFragment(*new SharedBodyFragment(data));
+  }
+  request.onCollapsedData(buffer, end_stream);
+}
+
+// Whether a response may be sent to requests other than the one it was received for.
+bool shareable(const Http::HeaderMap& headers) {
+  if (headers.get(Http::Headers::get().SetCookie) != nullptr) {
+    return false;
+  }
+  const Http::HeaderEntry* cache_control = headers.CacheControl();
+  if (cache_control == nullptr) {
+    return true;
+  }
+  for (absl::string_view directive :
+       absl::StrSplit(cache_control->value().getStringView(), ',')) {
+    // A private directive may list the header fields which are private.
+    directive = StringUtil::trim(directive.substr(0, directive.find('=')));
+    if (absl::EqualsIgnoreCase(directive, Http::Headers::get().CacheControlValues.NoStore) ||
+        absl::EqualsIgnoreCase(directive, Http::Headers::get().CacheControlValues.Private)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void CollapsedResponse::addRequest(CollapsedRequestCallbacks& request) {
+  ASSERT(registered_);
+  requests_.push_back(&request);
+  if (headers_ != nullptr) {
+    request.onCollapsedHeaders(*headers_, false);
+    for (const auto& data : body_) {
+      sendBody(request, data, false);
+    }
+  }
+}
+
+void CollapsedResponse::removeRequest(CollapsedRequestCallbacks& request) {
+  requests_.remove(&request);
+}
+
+void CollapsedResponse::encodeHeaders(const Http::HeaderMap& headers, bool end_stream) {
+  if (!shareable(headers)) {
+    for (CollapsedRequestCallbacks* request : complete()) {
+      request->onCollapsedUnshareable();
+    }
+    return;
+  }
+
+  headers_ = std::make_unique<Http::HeaderMapImpl>(headers);
+  if (end_stream) {
+    for (CollapsedRequestCallbacks* request : complete()) {
+      request->onCollapsedHeaders(*headers_, true);
+    }
+    return;
+  }
+  // A request may remove itself while it is called, so the iterator moves on before.
+  for (auto it = requests_.begin(); it != requests_.end();) {
+    CollapsedRequestCallbacks* request = *it++;
+    request->onCollapsedHeaders(*headers_, false);
+  }
+}
+
+void CollapsedResponse::encodeData(const Buffer::Instance& data, bool end_stream) {
+  if (!registered_ && requests_.empty()) {
+    return;
+  }
+  auto copy = std::make_shared<std::string>(data.length(), '\0');
+  data.copyOut(0, data.length(), &(*copy)[0]);
+  const std::shared_ptr<const std::string> shared = std::move(copy);
+
+  if (end_stream) {
+    for (CollapsedRequestCallbacks* request : complete()) {
+      sendBody(*request, shared, true);
+    }
+    return;
+  }
+  if (registered_) {
+    if (body_bytes_ + shared->size() > max_buffered_bytes_) {
+      // The requests collapsed so far are still sent the rest of the body, but the body is no
+      // longer kept for later requests.
+      unregister();
+      body_.clear();
+    } else {
+      body_.push_back(shared);
+      body_bytes_ += shared->size();
+    }
+  }
+  for (auto it = requests_.begin(); it != requests_.end();) {
+    CollapsedRequestCallbacks* request = *it++;
+    sendBody(*request, shared, false);
+  }
+}
+
+void CollapsedResponse::encodeTrailers(const Http::HeaderMap& trailers) {
+  for (CollapsedRequestCallbacks* request : complete()) {
+    request->onCollapsedTrailers(trailers);
+  }
+}
+
+void CollapsedResponse::abort() {
+  const bool response_started = headers_ != nullptr;
+  for (CollapsedRequestCallbacks* request : complete()) {
+    request->onCollapsedAbort(response_started);
+  }
+}
+
+void CollapsedResponse::unregister() {
+  if (registered_) {
+    registered_ = false;
+    registry_.remove(key_);
+  }
+}
+
+std::list<CollapsedRequestCallbacks*> CollapsedResponse::complete() {
+  unregister();
+  body_.clear();
+  std::list<CollapsedRequestCallbacks*> requests;
+  requests.swap(requests_);
+  return requests;
+}
+
+CollapsedResponseSharedPtr CollapsedForwardingRegistry::find(const std::string& key) {
+  auto it = responses_.find(key);
+  return it != responses_.end() ? it->second : nullptr;
+}
+
+CollapsedResponseSharedPtr CollapsedForwardingRegistry::add(const std::string& key,
+                                                            uint64_t max_buffered_bytes) {
+  auto response = std::make_shared<CollapsedResponse>(*this, key, max_buffered_bytes);
+  responses_[key] = response;
+  return response;
+}
+
+void CollapsedForwardingSlot::enable(ThreadLocal::SlotAllocator& tls) {
+  if (slot_ != nullptr) {
+    return;
+  }
+  slot_ = tls.allocateSlot();
+  slot_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CollapsedForwardingRegistry>();
+  });
+}
+
+CollapsedForwardingSlotSharedPtr getCollapsedForwardingSlot(Singleton::Manager& singleton_manager) {
+  return singleton_manager.getTyped<CollapsedForwardingSlot>(
+      SINGLETON_MANAGER_REGISTERED_NAME(collapsed_forwarding_slot),
+      [] { return std::make_shared<CollapsedForwardingSlot>(); });
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+#include "envoy/http/header_map.h"
+#include "envoy/singleton/manager.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Receives the response of the request a request was collapsed into.
+ */
+class CollapsedRequestCallbacks {
+public:
+  virtual ~CollapsedRequestCallbacks() = default;
+
+  /**
+   * Called with the response headers.
+   * @param headers supplies the response headers, which must be copied to be kept.
+   * @param end_stream whether the response has no body or trailers.
+   */
+  virtual void onCollapsedHeaders(const Http::HeaderMap& headers, bool end_stream) PURE;
+
+  /**
+   * Called with a part of the response body.
+   * @param data supplies the body data, which may be moved from.
+   * @param end_stream whether the response has no more body or trailers.
+   */
+  virtual void onCollapsedData(Buffer::Instance& data, bool end_stream) PURE;
+
+  /**
+   * Called with the response trailers, which end the response.
+   * @param trailers supplies the response trailers, which must be copied to be kept.
+   */
+  virtual void onCollapsedTrailers(const Http::HeaderMap& trailers) PURE;
+
+  /**
+   * Called when the request the request was collapsed into failed.
+   * @param response_started whether the response headers have already been received.
+   */
+  virtual void onCollapsedAbort(bool response_started) PURE;
+
+  /**
+   * Called instead of onCollapsedHeaders() when the response of the request the request was
+   * collapsed into can not be shared, as it sets a cookie or is private. The request must be sent
+   * upstream itself.
+   */
+  virtual void onCollapsedUnshareable() PURE;
+};
+
+class CollapsedForwardingRegistry;
+
+/**
+ * The response of an upstream request which identical requests are collapsed into. The request
+ * which was sent upstream passes its response on to the collapsed requests as it receives it, and
+ * keeps it so that requests collapsed after the response started are sent what they missed. Body
+ * data is copied once and shared by all the collapsed requests.
+ */
+class CollapsedResponse {
+public:
+  CollapsedResponse(CollapsedForwardingRegistry& registry, const std::string& key,
+                    uint64_t max_buffered_bytes)
+      : registry_(registry), key_(key), max_buffered_bytes_(max_buffered_bytes) {}
+
+  /**
+   * Collapses a request into the response, and sends it the parts of the response which were
+   * already received.
+   */
+  void addRequest(CollapsedRequestCallbacks& request);
+
+  /**
+   * Removes a request which goes away before its response is complete.
+   */
+  void removeRequest(CollapsedRequestCallbacks& request);
+
+  // Called by the request which was sent upstream, with its response. A response which can not be
+  // shared is not passed on, and the collapsed requests are told to go upstream themselves.
+  void encodeHeaders(const Http::HeaderMap& headers, bool end_stream);
+  void encodeData(const Buffer::Instance& data, bool end_stream);
+  void encodeTrailers(const Http::HeaderMap& trailers);
+  // The request failed, or went away, before its response was complete.
+  void abort();
+
+  /**
+   * @return bool whether requests can still be collapsed into the response.
+   */
+  bool joinable() const { return registered_; }
+
+private:
+  // Stops further requests from being collapsed into the response.
+  void unregister();
+  // Detaches the collapsed requests once the response is complete.
+  std::list<CollapsedRequestCallbacks*> complete();
+
+  CollapsedForwardingRegistry& registry_;
+  const std::string key_;
+  const uint64_t max_buffered_bytes_;
+  bool registered_{true};
+  std::list<CollapsedRequestCallbacks*> requests_;
+  Http::HeaderMapPtr headers_;
+  // The body received so far, as long as it fits in max_buffered_bytes_.
+  std::vector<std::shared_ptr<const std::string>> body_;
+  uint64_t body_bytes_{};
+};
+
+using CollapsedResponseSharedPtr = std::shared_ptr<CollapsedResponse>;
+
+/**
+ * The responses of a worker which requests can be collapsed into, by the key identifying identical
+ * requests.
+ */
+class CollapsedForwardingRegistry : public ThreadLocal::ThreadLocalObject {
+public:
+  /**
+   * @return CollapsedResponseSharedPtr the in flight response which a request with the given key
+   *         can be collapsed into, or nullptr if there is none.
+   */
+  CollapsedResponseSharedPtr find(const std::string& key);
+
+  /**
+   * Registers the response of a request with the given key which is sent upstream.
+   */
+  CollapsedResponseSharedPtr add(const std::string& key, uint64_t max_buffered_bytes);
+
+  void remove(const std::string& key) { responses_.erase(key); }
+
+private:
+  absl::flat_hash_map<std::string, CollapsedResponseSharedPtr> responses_;
+};
+
+/**
+ * The slot of the per worker registries, shared by all the routes and router filters. The slot is
+ * only allocated once a route enables collapsed forwarding.
+ */
+class CollapsedForwardingSlot : public Singleton::Instance {
+public:
+  /**
+   * Allocates the slot if it is not yet. Must be called on the main thread, before the route which
+   * enables collapsed forwarding is used by the workers.
+   */
+  void enable(ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @return CollapsedForwardingRegistry* the registry of the worker, or nullptr if no route
+   *         enabled collapsed forwarding.
+   */
+  CollapsedForwardingRegistry* registry() {
+    return slot_ != nullptr ? &slot_->getTyped<CollapsedForwardingRegistry>() : nullptr;
+  }
+
+private:
+  ThreadLocal::SlotPtr slot_;
+};
+
+using CollapsedForwardingSlotSharedPtr = std::shared_ptr<CollapsedForwardingSlot>;
+
+/**
+ * @return CollapsedForwardingSlotSharedPtr the slot of the per worker registries of the server.
+ */
+CollapsedForwardingSlotSharedPtr getCollapsedForwardingSlot(Singleton::Manager& singleton_manager);
+
+} // namespace Router
+} // namespace Envoy
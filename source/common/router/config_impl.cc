@@ -65,6 +65,23 @@ HedgePolicyImpl::HedgePolicyImpl(const envoy::api::v2::route::HedgePolicy& hedge
 HedgePolicyImpl::HedgePolicyImpl()
     : initial_requests_(1), additional_request_chance_({}), hedge_on_per_try_timeout_(false) {}
 
+CollapsedForwardingPolicyImpl::CollapsedForwardingPolicyImpl(
+    const envoy::api::v2::route::RouteAction& route_config,
+    Server::Configuration::ServerFactoryContext& factory_context)
+    : enabled_(route_config.has_collapsed_forwarding_policy()),
+      max_buffered_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          route_config.collapsed_forwarding_policy(), max_buffered_bytes, 1024 * 1024)) {
+  if (!enabled_) {
+    return;
+  }
+  for (const std::string& header : route_config.collapsed_forwarding_policy().key_headers()) {
+    key_headers_.emplace_back(header);
+  }
+  // The route keeps the slot allocated for as long as it may collapse requests.
+  slot_ = getCollapsedForwardingSlot(factory_context.singletonManager());
+  slot_->enable(factory_context.threadLocal());
+}
+
 RetryPolicyImpl::RetryPolicyImpl(const envoy::api::v2::route::RetryPolicy& retry_policy,
                                  ProtobufMessage::ValidationVisitor& validation_visitor)
     : retriable_headers_(
@@ -264,6 +281,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       prefix_rewrite_redirect_(route.redirect().prefix_rewrite()),
       strip_query_(route.redirect().strip_query()),
       hedge_policy_(buildHedgePolicy(vhost.hedgePolicy(), route.route())),
+      collapsed_forwarding_policy_(route.route(), factory_context),
       retry_policy_(buildRetryPolicy(vhost.retryPolicy(), route.route(), validator)),
       rate_limit_policy_(route.route().rate_limits()), shadow_policy_(route.route()),
       priority_(ConfigUtility::parsePriority(route.route().priority())),
@@ -20,6 +20,7 @@
 #include "common/config/metadata.h"
 #include "common/http/hash_policy.h"
 #include "common/http/header_utility.h"
+#include "common/router/collapsed_forwarding.h"
 #include "common/router/config_utility.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
@@ -314,6 +315,26 @@ private:
   const bool hedge_on_per_try_timeout_;
 };
 
+/**
+ * Implementation of CollapsedForwardingPolicy that reads from the proto route config.
+ */
+class CollapsedForwardingPolicyImpl : public CollapsedForwardingPolicy {
+public:
+  CollapsedForwardingPolicyImpl(const envoy::api::v2::route::RouteAction& route_config,
+                                Server::Configuration::ServerFactoryContext& factory_context);
+
+  // Router::CollapsedForwardingPolicy
+  bool enabled() const override { return enabled_; }
+  const std::vector<Http::LowerCaseString>& keyHeaders() const override { return key_headers_; }
+  uint64_t maxBufferedBytes() const override { return max_buffered_bytes_; }
+
+private:
+  const bool enabled_;
+  std::vector<Http::LowerCaseString> key_headers_;
+  const uint64_t max_buffered_bytes_;
+  CollapsedForwardingSlotSharedPtr slot_;
+};
+
 /**
  * Implementation of Decorator that reads from the proto route decorator.
  */
@@ -398,6 +419,9 @@ public:
   const Http::HashPolicy* hashPolicy() const override { return hash_policy_.get(); }
 
   const HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
+  const CollapsedForwardingPolicy& collapsedForwardingPolicy() const override {
+    return collapsed_forwarding_policy_;
+  }
 
   const MetadataMatchCriteria* metadataMatchCriteria() const override {
     return metadata_match_criteria_.get();
@@ -498,6 +522,9 @@ private:
     const CorsPolicy* corsPolicy() const override { return parent_->corsPolicy(); }
     const Http::HashPolicy* hashPolicy() const override { return parent_->hashPolicy(); }
     const HedgePolicy& hedgePolicy() const override { return parent_->hedgePolicy(); }
+    const CollapsedForwardingPolicy& collapsedForwardingPolicy() const override {
+      return parent_->collapsedForwardingPolicy();
+    }
     Upstream::ResourcePriority priority() const override { return parent_->priority(); }
     const RateLimitPolicy& rateLimitPolicy() const override { return parent_->rateLimitPolicy(); }
     const RetryPolicy& retryPolicy() const override { return parent_->retryPolicy(); }
@@ -657,6 +684,7 @@ private:
   const std::string prefix_rewrite_redirect_;
   const bool strip_query_;
   const HedgePolicyImpl hedge_policy_;
+  const CollapsedForwardingPolicyImpl collapsed_forwarding_policy_;
   const RetryPolicyImpl retry_policy_;
   const RateLimitPolicyImpl rate_limit_policy_;
   const ShadowPolicyImpl shadow_policy_;
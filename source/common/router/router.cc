@@ -1,5 +1,6 @@
 #include "common/router/router.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <memory>
@@ -34,6 +35,8 @@
 
 #include "extensions/filters/http/well_known_names.h"
 
+#include "absl/container/flat_hash_set.h"
+
 namespace Envoy {
 namespace Router {
 namespace {
@@ -90,6 +93,34 @@ bool convertRequestHeadersForInternalRedirect(Http::HeaderMap& downstream_header
   return true;
 }
 
+struct RouteHeadersKey {
+  absl::flat_hash_set<std::string> received_;
+  std::string key_;
+  bool finalized_{};
+};
+
+// Returns the headers of the finalized request which are not in the request as it was received.
+std::string routeHeadersKey(const Http::HeaderMap& received, const Http::HeaderMap& finalized) {
+  const Http::HeaderMap::ConstIterateCb cb =
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+    auto* key = static_cast<RouteHeadersKey*>(context);
+    std::string line =
+        absl::StrCat(header.key().getStringView(), ":", header.value().getStringView(), "\n");
+    if (!key->finalized_) {
+      key->received_.insert(std::move(line));
+    } else if (key->received_.count(line) == 0) {
+      key->key_.append(line);
+    }
+    return Http::HeaderMap::Iterate::Continue;
+  };
+
+  RouteHeadersKey key;
+  received.iterate(cb, &key);
+  key.finalized_ = true;
+  finalized.iterate(cb, &key);
+  return std::move(key.key_);
+}
+
 } // namespace
 
 void FilterUtility::setUpstreamScheme(Http::HeaderMap& headers, bool use_secure_transport) {
@@ -531,8 +562,18 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   // Inject the active span's tracing context into the request headers.
   callbacks_->activeSpan().injectContext(headers);
 
+  // Headers added by the route may differ between otherwise identical requests, e.g. when they
+  // are formatted from the downstream connection, so the ones it changes are part of the collapse
+  // key.
+  Http::HeaderMapPtr unfinalized_headers;
+  if (end_stream && route_entry_->collapsedForwardingPolicy().enabled()) {
+    unfinalized_headers = std::make_unique<Http::HeaderMapImpl>(headers);
+  }
   route_entry_->finalizeRequestHeaders(headers, callbacks_->streamInfo(),
                                        !config_.suppress_envoy_headers_);
+  if (unfinalized_headers != nullptr) {
+    collapse_route_headers_ = routeHeadersKey(*unfinalized_headers, headers);
+  }
   FilterUtility::setUpstreamScheme(
       headers, conn_pool->host()->transportSocketFactory().implementsSecureTransport());
 
@@ -550,6 +591,11 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   // Hang onto the modify_headers function for later use in handling upstream responses.
   modify_headers_ = modify_headers;
 
+  // A request with a body is never collapsed, as the body would have to be compared.
+  if (end_stream && collapseRequest(headers)) {
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
   UpstreamRequestPtr upstream_request = std::make_unique<UpstreamRequest>(*this, *conn_pool);
   upstream_request->moveIntoList(std::move(upstream_request), upstream_requests_);
   upstream_requests_.front()->encodeHeaders(end_stream);
@@ -572,6 +618,154 @@ Http::ConnectionPool::Instance* Filter::getConnPool() {
                                             protocol, this);
 }
 
+bool Filter::collapseRequest(const Http::HeaderMap& headers) {
+  const CollapsedForwardingPolicy& policy = route_entry_->collapsedForwardingPolicy();
+  CollapsedForwardingRegistry* registry = config_.collapsedForwardingRegistry();
+  if (!policy.enabled() || registry == nullptr) {
+    return false;
+  }
+
+  const absl::string_view method = headers.Method()->value().getStringView();
+  if (method != Http::Headers::get().MethodValues.Get &&
+      method != Http::Headers::get().MethodValues.Head) {
+    return false;
+  }
+  // The response to a request with credentials or cookies is only shared with requests which have
+  // the same ones.
+  const auto& key_headers = policy.keyHeaders();
+  if (headers.Authorization() != nullptr &&
+      std::find(key_headers.begin(), key_headers.end(), Http::Headers::get().Authorization) ==
+          key_headers.end()) {
+    return false;
+  }
+  if (headers.get(Http::Headers::get().Cookie) != nullptr &&
+      std::find(key_headers.begin(), key_headers.end(), Http::Headers::get().Cookie) ==
+          key_headers.end()) {
+    return false;
+  }
+
+  std::string key = absl::StrCat(route_entry_->clusterName(), "\n", method, "\n",
+                                 headers.Host()->value().getStringView(),
+                                 headers.Path()->value().getStringView(), "\n");
+  for (const Http::LowerCaseString& name : key_headers) {
+    const Http::HeaderEntry* header = headers.get(name);
+    absl::StrAppend(&key, header != nullptr ? header->value().getStringView() : "", "\n");
+  }
+  key.append(collapse_route_headers_);
+
+  collapsed_response_ = registry->find(key);
+  if (collapsed_response_ == nullptr) {
+    // This request is sent upstream, and the identical requests which follow wait for its
+    // response.
+    collapsed_response_ = registry->add(key, policy.maxBufferedBytes());
+    return false;
+  }
+
+  ENVOY_STREAM_LOG(debug, "router collapsing request into an identical one in flight", *callbacks_);
+  collapsed_ = true;
+  config_.stats_.rq_collapsed_.inc();
+  // A request which is collapsed again keeps the deadline it was first collapsed with.
+  if (timeout_.global_timeout_.count() > 0 && response_timeout_ == nullptr) {
+    response_timeout_ =
+        callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); });
+    response_timeout_->enableTimer(timeout_.global_timeout_);
+  }
+  collapsed_response_->addRequest(*this);
+  return true;
+}
+
+void Filter::resetCollapsedResponse() {
+  if (collapsed_response_ == nullptr) {
+    return;
+  }
+
+  CollapsedResponseSharedPtr collapsed_response = std::move(collapsed_response_);
+  if (collapsed_) {
+    collapsed_response->removeRequest(*this);
+  } else {
+    // The requests collapsed into this one will not get the rest of the response.
+    collapsed_response->abort();
+  }
+}
+
+void Filter::onCollapsedHeaders(const Http::HeaderMap& headers, bool end_stream) {
+  Http::HeaderMapPtr response_headers = std::make_unique<Http::HeaderMapImpl>(headers);
+  for (const auto& header_value : downstream_set_cookies_) {
+    response_headers->addReferenceKey(Http::Headers::get().SetCookie, header_value);
+  }
+  route_entry_->finalizeResponseHeaders(*response_headers, callbacks_->streamInfo());
+
+  downstream_response_started_ = true;
+  if (end_stream) {
+    collapsed_response_.reset();
+    cleanup();
+  }
+
+  callbacks_->streamInfo().setResponseCodeDetails(
+      StreamInfo::ResponseCodeDetails::get().ViaUpstream);
+  callbacks_->encodeHeaders(std::move(response_headers), end_stream);
+}
+
+void Filter::onCollapsedData(Buffer::Instance& data, bool end_stream) {
+  if (end_stream) {
+    collapsed_response_.reset();
+    cleanup();
+  }
+  callbacks_->encodeData(data, end_stream);
+}
+
+void Filter::onCollapsedTrailers(const Http::HeaderMap& trailers) {
+  collapsed_response_.reset();
+  cleanup();
+  callbacks_->encodeTrailers(std::make_unique<Http::HeaderMapImpl>(trailers));
+}
+
+void Filter::onCollapsedAbort(bool response_started) {
+  config_.stats_.rq_collapsed_aborted_.inc();
+  collapsed_response_.reset();
+  collapsed_ = false;
+
+  if (response_started) {
+    // The part of the response which was already sent downstream can not be sent again.
+    cleanup();
+    callbacks_->resetStream();
+    return;
+  }
+
+  // Nothing was sent downstream yet, so the request goes upstream itself, unless another request
+  // collapsed into the same response already did.
+  sendCollapsedRequestUpstream(true);
+}
+
+void Filter::onCollapsedUnshareable() {
+  config_.stats_.rq_collapsed_aborted_.inc();
+  collapsed_response_.reset();
+  collapsed_ = false;
+
+  // The response of an identical request is likely not to be shared either, so the request is not
+  // collapsed again.
+  sendCollapsedRequestUpstream(false);
+}
+
+void Filter::sendCollapsedRequestUpstream(bool collapse) {
+  Http::ConnectionPool::Instance* conn_pool = getConnPool();
+  if (!conn_pool) {
+    sendNoHealthyUpstreamResponse();
+    cleanup();
+    return;
+  }
+  // The response timeout which was started when the request was collapsed keeps running, so that
+  // the request is not given more time than any other.
+  if (collapse && collapseRequest(*downstream_headers_)) {
+    return;
+  }
+
+  UpstreamRequestPtr upstream_request = std::make_unique<UpstreamRequest>(*this, *conn_pool);
+  upstream_request->moveIntoList(std::move(upstream_request), upstream_requests_);
+  upstream_requests_.front()->encodeHeaders(true);
+  onRequestComplete();
+}
+
 void Filter::sendNoHealthyUpstreamResponse() {
   callbacks_->streamInfo().setResponseFlag(StreamInfo::ResponseFlag::NoHealthyUpstream);
   chargeUpstreamCode(Http::Code::ServiceUnavailable, nullptr, false);
@@ -656,6 +850,7 @@ void Filter::cleanup() {
   // list as appropriate.
   ASSERT(upstream_requests_.empty());
 
+  resetCollapsedResponse();
   retry_state_.reset();
   if (response_timeout_) {
     response_timeout_->disableTimer();
@@ -695,7 +890,7 @@ void Filter::onRequestComplete() {
     // seems unnecessary right now.
     maybeDoShadowing();
 
-    if (timeout_.global_timeout_.count() > 0) {
+    if (timeout_.global_timeout_.count() > 0 && response_timeout_ == nullptr) {
       response_timeout_ = dispatcher.createTimer([this]() -> void { onResponseTimeout(); });
       response_timeout_->enableTimer(timeout_.global_timeout_);
     }
@@ -1138,6 +1333,15 @@ void Filter::onUpstreamHeaders(uint64_t response_code, Http::HeaderMapPtr&& head
     handleNon5xxResponseHeaders(grpc_status, upstream_request, end_stream, grpc_to_http_status);
   }
 
+  // The response is passed on to the requests collapsed into this one before it is changed for
+  // this request only.
+  if (collapsed_response_ != nullptr) {
+    collapsed_response_->encodeHeaders(*headers, end_stream);
+    if (end_stream) {
+      collapsed_response_.reset();
+    }
+  }
+
   // Append routing cookies
   for (const auto& header_value : downstream_set_cookies_) {
     headers->addReferenceKey(Http::Headers::get().SetCookie, header_value);
@@ -1171,6 +1375,14 @@ void Filter::onUpstreamData(Buffer::Instance& data, UpstreamRequest& upstream_re
     if (upstream_request.grpc_rq_success_deferred_) {
       upstream_request.upstream_host_->stats().rq_error_.inc();
     }
+  }
+  if (collapsed_response_ != nullptr) {
+    collapsed_response_->encodeData(data, end_stream);
+    if (end_stream) {
+      collapsed_response_.reset();
+    }
+  }
+  if (end_stream) {
     onUpstreamComplete(upstream_request);
   }
 
@@ -1193,6 +1405,10 @@ void Filter::onUpstreamTrailers(Http::HeaderMapPtr&& trailers, UpstreamRequest&
     }
   }
 
+  if (collapsed_response_ != nullptr) {
+    collapsed_response_->encodeTrailers(*trailers);
+    collapsed_response_.reset();
+  }
   onUpstreamComplete(upstream_request);
 
   callbacks_->encodeTrailers(std::move(trailers));
@@ -15,6 +15,7 @@
 #include "envoy/server/filter_config.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/access_log/access_log_impl.h"
@@ -25,6 +26,7 @@
 #include "common/common/logger.h"
 #include "common/config/well_known_names.h"
 #include "common/http/utility.h"
+#include "common/router/collapsed_forwarding.h"
 #include "common/router/config_impl.h"
 #include "common/stats/symbol_table_impl.h"
 #include "common/stream_info/stream_info_impl.h"
@@ -40,6 +42,8 @@ namespace Router {
 #define ALL_ROUTER_STATS(COUNTER)                                                                  \
   COUNTER(no_route)                                                                                \
   COUNTER(no_cluster)                                                                              \
+  COUNTER(rq_collapsed)                                                                            \
+  COUNTER(rq_collapsed_aborted)                                                                    \
   COUNTER(rq_redirect)                                                                             \
   COUNTER(rq_direct_response)                                                                      \
   COUNTER(rq_total)                                                                                \
@@ -197,6 +201,8 @@ public:
     for (const auto& upstream_log : config.upstream_log()) {
       upstream_logs_.push_back(AccessLog::AccessLogFactory::fromProto(upstream_log, context));
     }
+    // The slot is only allocated once a route enables collapsed forwarding.
+    collapsed_forwarding_ = getCollapsedForwardingSlot(context.singletonManager());
   }
   using HeaderVector = std::vector<Http::LowerCaseString>;
   using HeaderVectorPtr = std::unique_ptr<HeaderVector>;
@@ -204,6 +210,22 @@ public:
   ShadowWriter& shadowWriter() { return *shadow_writer_; }
   TimeSource& timeSource() { return time_source_; }
 
+  /**
+   * Allows the requests of routes with a collapsed forwarding policy to be collapsed into the
+   * identical requests in flight on the same worker.
+   */
+  void setCollapsedForwarding(CollapsedForwardingSlotSharedPtr collapsed_forwarding) {
+    collapsed_forwarding_ = std::move(collapsed_forwarding);
+  }
+
+  /**
+   * @return CollapsedForwardingRegistry* the in flight responses of the worker which requests can
+   *         be collapsed into, or nullptr if no route collapses requests.
+   */
+  CollapsedForwardingRegistry* collapsedForwardingRegistry() {
+    return collapsed_forwarding_ != nullptr ? collapsed_forwarding_->registry() : nullptr;
+  }
+
   Stats::Scope& scope_;
   const LocalInfo::LocalInfo& local_info_;
   Upstream::ClusterManager& cm_;
@@ -226,6 +248,7 @@ public:
 private:
   ShadowWriterPtr shadow_writer_;
   TimeSource& time_source_;
+  CollapsedForwardingSlotSharedPtr collapsed_forwarding_;
 };
 
 using FilterConfigSharedPtr = std::shared_ptr<FilterConfig>;
@@ -235,12 +258,13 @@ using FilterConfigSharedPtr = std::shared_ptr<FilterConfig>;
  */
 class Filter : Logger::Loggable<Logger::Id::router>,
                public Http::StreamDecoderFilter,
-               public Upstream::LoadBalancerContextBase {
+               public Upstream::LoadBalancerContextBase,
+               public CollapsedRequestCallbacks {
 public:
   Filter(FilterConfig& config)
       : config_(config), final_upstream_request_(nullptr), downstream_response_started_(false),
         downstream_end_stream_(false), do_shadowing_(false), is_retry_(false),
-        attempting_internal_redirect_with_complete_stream_(false) {}
+        attempting_internal_redirect_with_complete_stream_(false), collapsed_(false) {}
 
   ~Filter() override;
 
@@ -298,6 +322,13 @@ public:
   }
   const Http::HeaderMap* downstreamHeaders() const override { return downstream_headers_; }
 
+  // Router::CollapsedRequestCallbacks
+  void onCollapsedHeaders(const Http::HeaderMap& headers, bool end_stream) override;
+  void onCollapsedData(Buffer::Instance& data, bool end_stream) override;
+  void onCollapsedTrailers(const Http::HeaderMap& trailers) override;
+  void onCollapsedAbort(bool response_started) override;
+  void onCollapsedUnshareable() override;
+
   bool shouldSelectAnotherHost(const Upstream::Host& host) override {
     // We only care about host selection when performing a retry, at which point we consult the
     // RetryState to see if we're configured to avoid certain hosts during retries.
@@ -499,6 +530,14 @@ private:
                           bool dropped);
   void chargeUpstreamAbort(Http::Code code, bool dropped, UpstreamRequest& upstream_request);
   void cleanup();
+  // Collapses the request into an identical request in flight if the route allows it, or
+  // registers the request so that later ones can be collapsed into it. Returns whether the
+  // request was collapsed, and so must not be sent upstream.
+  bool collapseRequest(const Http::HeaderMap& headers);
+  // Sends a request which was collapsed upstream itself, once the response it was collapsed into
+  // failed or could not be shared. The request is collapsed again if allowed.
+  void sendCollapsedRequestUpstream(bool collapse);
+  void resetCollapsedResponse();
   virtual RetryStatePtr createRetryState(const RetryPolicy& policy,
                                          Http::HeaderMap& request_headers,
                                          const Upstream::ClusterInfo& cluster,
@@ -578,6 +617,11 @@ private:
 
   // list of cookies to add to upstream headers
   std::vector<std::string> downstream_set_cookies_;
+  // The response the request was collapsed into, or the response of the request for the requests
+  // collapsed into it.
+  CollapsedResponseSharedPtr collapsed_response_;
+  // The headers added by the route, which are part of the key the request is collapsed by.
+  std::string collapse_route_headers_;
 
   bool downstream_response_started_ : 1;
   bool downstream_end_stream_ : 1;
@@ -585,6 +629,8 @@ private:
   bool is_retry_ : 1;
   bool include_attempt_count_ : 1;
   bool attempting_internal_redirect_with_complete_stream_ : 1;
+  // Whether the request was collapsed into another one instead of being sent upstream.
+  bool collapsed_ : 1;
   uint32_t attempt_count_{1};
   uint32_t pending_retries_{0};
 
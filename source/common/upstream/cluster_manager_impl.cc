@@ -1,5 +1,6 @@
 #include "common/upstream/cluster_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -17,6 +18,7 @@
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/config/new_grpc_mux_impl.h"
 #include "common/config/resources.h"
@@ -298,6 +300,9 @@ ClusterManagerImpl::ClusterManagerImpl(
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return std::make_shared<ThreadLocalClusterManagerImpl>(*this, dispatcher, local_cluster_name);
   });
+  // Shared connection pool owners are selected by hashing over the registered workers, so only
+  // start selecting them once every worker has registered.
+  tls_->runOnAllThreads([]() -> void {}, [this]() -> void { enableSharedConnPoolOwners(); });
 
   // We can now potentially create the CDS API once the backing cluster exists.
   if (dyn_resources.has_cds_config()) {
@@ -878,10 +883,65 @@ ProtobufTypes::MessagePtr ClusterManagerImpl::dumpClusterConfigs() {
   return config_dump;
 }
 
+void ClusterManagerImpl::addSharedConnPoolOwner(Event::Dispatcher& dispatcher) {
+  absl::MutexLock lock(&shared_conn_pool_owners_lock_);
+  // A late worker would change the owner of hosts that other workers already picked.
+  shared_conn_pool_owners_ready_ = false;
+  shared_conn_pool_owners_.push_back(std::make_shared<Http::SharedConnPoolOwner>(dispatcher));
+}
+
+void ClusterManagerImpl::removeSharedConnPoolOwner(Event::Dispatcher& dispatcher) {
+  absl::MutexLock lock(&shared_conn_pool_owners_lock_);
+  // Once a worker goes away the remaining workers no longer agree on owners, so stop selecting
+  // them. Pools already handed to the removed owner fail new streams rather than posting to it.
+  shared_conn_pool_owners_ready_ = false;
+  auto it = std::find_if(shared_conn_pool_owners_.begin(), shared_conn_pool_owners_.end(),
+                         [&dispatcher](const Http::SharedConnPoolOwnerSharedPtr& owner) {
+                           return &owner->dispatcher() == &dispatcher;
+                         });
+  if (it != shared_conn_pool_owners_.end()) {
+    (*it)->invalidate();
+    shared_conn_pool_owners_.erase(it);
+  }
+}
+
+void ClusterManagerImpl::enableSharedConnPoolOwners() {
+  absl::MutexLock lock(&shared_conn_pool_owners_lock_);
+  shared_conn_pool_owners_ready_ = true;
+}
+
+Http::SharedConnPoolOwnerSharedPtr ClusterManagerImpl::sharedConnPoolOwner(const Host& host) {
+  absl::MutexLock lock(&shared_conn_pool_owners_lock_);
+  if (!shared_conn_pool_owners_ready_ || shared_conn_pool_owners_.empty()) {
+    return nullptr;
+  }
+  // Every worker hashes the host the same way over the same set of owners, so all workers agree
+  // on the owner.
+  const uint64_t hash = HashUtil::xxHash64(host.address()->asString());
+  return shared_conn_pool_owners_[hash % shared_conn_pool_owners_.size()];
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::sharedOwnerConnPool(const std::string& cluster, const HostConstSharedPtr& host,
+                                        ResourcePriority priority, Http::Protocol protocol) {
+  // This runs on the owner worker, so this is the owner's thread local cluster manager.
+  ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
+  if (entry == cluster_manager.thread_local_clusters_.end()) {
+    return nullptr;
+  }
+  return entry->second->hostConnPool(host, priority, protocol);
+}
+
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl(
     ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
     const absl::optional<std::string>& local_cluster_name)
     : parent_(parent), thread_local_dispatcher_(dispatcher) {
+  // Workers may own shared connection pools. The main thread never does.
+  if (&dispatcher != &parent_.dispatcher_) {
+    parent_.addSharedConnPoolOwner(dispatcher);
+  }
+
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_name) {
     ENVOY_LOG(debug, "adding TLS local cluster {}", local_cluster_name.value());
@@ -914,6 +974,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   // member update callback registered with the local cluster.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   destroying_ = true;
+  parent_.removeSharedConnPoolOwner(thread_local_dispatcher_);
   host_http_conn_pool_map_.clear();
   host_tcp_conn_pool_map_.clear();
   ASSERT(host_tcp_conn_map_.empty());
@@ -1070,6 +1131,16 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::updateClusterMembership(
     ENVOY_LOG(debug, "re-creating local LB for TLS cluster {}", name);
     cluster_entry->lb_ = cluster_entry->lb_factory_->create();
   }
+
+  // Warm connections to new hosts on workers only, as the main thread rarely proxies requests.
+  if (cluster_entry->cluster_info_->prefetchOnHostAdd() &&
+      &config.thread_local_dispatcher_ != &config.parent_.dispatcher_) {
+    for (const HostSharedPtr& host : hosts_added) {
+      if (host->health() != Host::Health::Unhealthy) {
+        cluster_entry->prefetchConnPool(host);
+      }
+    }
+  }
 }
 
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
@@ -1235,12 +1306,28 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
     have_transport_socket_options = true;
   }
 
+  // Connections are only shared across workers when nothing about the stream would make the
+  // connection specific to it.
+  const bool shared = protocol == Http::Protocol::Http2 &&
+                      (cluster_info_->features() & ClusterInfo::Features::SHARED_HTTP2_CONN_POOL) &&
+                      upstream_options->empty() && !have_transport_socket_options;
+
   ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
 
   // Note: to simplify this, we assume that the factory is only called in the scope of this
   // function. Otherwise, we'd need to capture a few of these variables by value.
   ConnPoolsContainer::ConnPools::OptPoolRef pool =
-      container.pools_->getPool(priority, hash_key, [&]() {
+      container.pools_->getPool(priority, hash_key, [&]() -> Http::ConnectionPool::InstancePtr {
+        Http::SharedConnPoolOwnerSharedPtr owner =
+            shared ? parent_.parent_.sharedConnPoolOwner(*host) : nullptr;
+        if (owner != nullptr && &owner->dispatcher() != &parent_.thread_local_dispatcher_) {
+          return std::make_unique<Http::SharedConnPoolImpl>(
+              parent_.thread_local_dispatcher_, std::move(owner), host, protocol,
+              [&cluster_manager = parent_.parent_, cluster_name = cluster_info_->name(), host,
+               priority, protocol]() {
+                return cluster_manager.sharedOwnerConnPool(cluster_name, host, priority, protocol);
+              });
+        }
         return parent_.parent_.factory_.allocateConnPool(
             parent_.thread_local_dispatcher_, host, priority, protocol,
             !upstream_options->empty() ? upstream_options : nullptr,
@@ -1254,6 +1341,67 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
   }
 }
 
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::hostConnPool(
+    const HostConstSharedPtr& host, ResourcePriority priority, Http::Protocol protocol) {
+  ConnPoolsContainer* container = parent_.getHttpConnPoolsContainer(host);
+  if (container == nullptr) {
+    // The requesting worker may not have processed a membership update that this worker already
+    // has. Do not create pools for hosts that have been removed, as nothing would drain them.
+    if (!hasHost(host)) {
+      return nullptr;
+    }
+    container = parent_.getHttpConnPoolsContainer(host, true);
+  }
+
+  const std::vector<uint8_t> hash_key = {uint8_t(protocol)};
+  ConnPoolsContainer::ConnPools::OptPoolRef pool =
+      container->pools_->getPool(priority, hash_key, [&]() {
+        return parent_.parent_.factory_.allocateConnPool(parent_.thread_local_dispatcher_, host,
+                                                         priority, protocol, nullptr, nullptr);
+      });
+
+  if (pool.has_value()) {
+    return &(pool.value().get());
+  } else {
+    return nullptr;
+  }
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::prefetchConnPool(
+    const HostConstSharedPtr& host) {
+  if (cluster_info_->features() & ClusterInfo::Features::USE_DOWNSTREAM_PROTOCOL) {
+    // The protocol, and therefore the pool, is only known once a request arrives.
+    return;
+  }
+
+  const Http::Protocol protocol = cluster_info_->upstreamHttpProtocol(absl::nullopt);
+  if (protocol == Http::Protocol::Http2 &&
+      (cluster_info_->features() & ClusterInfo::Features::SHARED_HTTP2_CONN_POOL)) {
+    // Only the worker that owns the shared connections to the host connects to it.
+    Http::SharedConnPoolOwnerSharedPtr owner = parent_.parent_.sharedConnPoolOwner(*host);
+    if (owner != nullptr && &owner->dispatcher() != &parent_.thread_local_dispatcher_) {
+      return;
+    }
+  }
+
+  Http::ConnectionPool::Instance* pool = hostConnPool(host, ResourcePriority::Default, protocol);
+  if (pool != nullptr) {
+    pool->prefetchConnections();
+  }
+}
+
+bool ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::hasHost(
+    const HostConstSharedPtr& host) const {
+  for (const auto& host_set : priority_set_.hostSetsPerPriority()) {
+    const HostVector& hosts = host_set->hosts();
+    if (std::find(hosts.begin(), hosts.end(), host) != hosts.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Tcp::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::tcpConnPool(
     ResourcePriority priority, LoadBalancerContext* context) {
@@ -24,10 +24,13 @@
 #include "common/config/grpc_mux_impl.h"
 #include "common/config/subscription_factory_impl.h"
 #include "common/http/async_client_impl.h"
+#include "common/http/shared_conn_pool.h"
 #include "common/upstream/load_stats_reporter.h"
 #include "common/upstream/priority_conn_pool_map.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -309,6 +312,16 @@ private:
       Tcp::ConnectionPool::Instance* tcpConnPool(ResourcePriority priority,
                                                  LoadBalancerContext* context);
 
+      // Returns the pool for streams without connection specific options to the given host on
+      // this worker, creating it if needed. This is also the pool that owns shared upstream
+      // connections. Returns nullptr if the host is no longer a member of the cluster.
+      Http::ConnectionPool::Instance* hostConnPool(const HostConstSharedPtr& host,
+                                                   ResourcePriority priority,
+                                                   Http::Protocol protocol);
+      bool hasHost(const HostConstSharedPtr& host) const;
+      // Establishes connections to a newly added host ahead of demand.
+      void prefetchConnPool(const HostConstSharedPtr& host);
+
       // Upstream::ThreadLocalCluster
       const PrioritySet& prioritySet() override { return priority_set_; }
       ClusterInfoConstSharedPtr info() override { return cluster_info_; }
@@ -452,6 +465,10 @@ private:
   void onClusterInit(Cluster& cluster);
   void postThreadLocalHealthFailure(const HostSharedPtr& host);
   void updateClusterCounts();
+  Http::ConnectionPool::Instance* sharedOwnerConnPool(const std::string& cluster,
+                                                      const HostConstSharedPtr& host,
+                                                      ResourcePriority priority,
+                                                      Http::Protocol protocol);
 
   ClusterManagerFactory& factory_;
   Runtime::Loader& runtime_;
@@ -460,6 +477,11 @@ private:
   Runtime::RandomGenerator& random_;
 
 protected:
+  void addSharedConnPoolOwner(Event::Dispatcher& dispatcher);
+  void removeSharedConnPoolOwner(Event::Dispatcher& dispatcher);
+  void enableSharedConnPoolOwners();
+  Http::SharedConnPoolOwnerSharedPtr sharedConnPoolOwner(const Host& host);
+
   ClusterMap active_clusters_;
 
 private:
@@ -481,6 +503,14 @@ private:
   Event::Dispatcher& dispatcher_;
   Http::Context& http_context_;
   Config::SubscriptionFactoryImpl subscription_factory_;
+  // Workers that may own upstream connections for clusters that share HTTP/2 connection pools
+  // across workers. Populated as each worker creates its thread local cluster manager. Owners are
+  // only selected once every worker has registered, and until a worker goes away, so that all
+  // workers agree on the owner of a host.
+  absl::Mutex shared_conn_pool_owners_lock_;
+  std::vector<Http::SharedConnPoolOwnerSharedPtr>
+      shared_conn_pool_owners_ ABSL_GUARDED_BY(shared_conn_pool_owners_lock_);
+  bool shared_conn_pool_owners_ready_ ABSL_GUARDED_BY(shared_conn_pool_owners_lock_){};
 };
 
 } // namespace Upstream
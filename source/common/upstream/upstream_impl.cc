@@ -71,6 +71,9 @@ uint64_t parseFeatures(const envoy::api::v2::Cluster& config) {
   if (config.close_connections_on_host_health_failure()) {
     features |= ClusterInfoImpl::Features::CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE;
   }
+  if (config.share_http2_connections_across_workers()) {
+    features |= ClusterInfoImpl::Features::SHARED_HTTP2_CONN_POOL;
+  }
   return features;
 }
 
@@ -581,6 +584,10 @@ ClusterLoadReportStats ClusterInfoImpl::generateLoadReportStats(Stats::Scope& sc
   return {ALL_CLUSTER_LOAD_REPORT_STATS(POOL_COUNTER(scope))};
 }
 
+ClusterPrefetchStats ClusterInfoImpl::generatePrefetchStats(Stats::Scope& scope) {
+  return {ALL_CLUSTER_PREFETCH_STATS(POOL_COUNTER(scope))};
+}
+
 // Implements the FactoryContext interface required by network filters.
 class FactoryContextImpl : public Server::Configuration::CommonFactoryContext {
 public:
@@ -654,6 +661,13 @@ ClusterInfoImpl::ClusterInfoImpl(
       drain_connections_on_host_removal_(config.drain_connections_on_host_removal()),
       warm_hosts_(!config.health_checks().empty() &&
                   common_lb_config_.ignore_new_hosts_until_first_hc()),
+      prefetch_ratio_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.prefetch_policy(), prefetch_ratio, 1.0)),
+      prefetch_on_host_add_(config.prefetch_policy().prefetch_on_host_add()),
+      prefetch_stats_(config.has_prefetch_policy()
+                          ? std::make_unique<ClusterPrefetchStats>(
+                                generatePrefetchStats(*stats_scope_))
+                          : nullptr),
       cluster_type_(config.has_cluster_type()
                         ? absl::make_optional<envoy::api::v2::Cluster::CustomClusterType>(
                               config.cluster_type())
@@ -512,6 +512,7 @@ public:
 
   static ClusterStats generateStats(Stats::Scope& scope);
   static ClusterLoadReportStats generateLoadReportStats(Stats::Scope& scope);
+  static ClusterPrefetchStats generatePrefetchStats(Stats::Scope& scope);
   static ClusterCircuitBreakersStats generateCircuitBreakersStats(Stats::Scope& scope,
                                                                   const std::string& stat_prefix,
                                                                   bool track_remaining);
@@ -558,6 +559,9 @@ public:
   ClusterStats& stats() const override { return stats_; }
   Stats::Scope& statsScope() const override { return *stats_scope_; }
   ClusterLoadReportStats& loadReportStats() const override { return load_report_stats_; }
+  ClusterPrefetchStats* prefetchStats() const override { return prefetch_stats_.get(); }
+  float prefetchRatio() const override { return prefetch_ratio_; }
+  bool prefetchOnHostAdd() const override { return prefetch_on_host_add_; }
   const Network::Address::InstanceConstSharedPtr& sourceAddress() const override {
     return source_address_;
   };
@@ -622,6 +626,9 @@ private:
   const Network::ConnectionSocket::OptionsSharedPtr cluster_socket_options_;
   const bool drain_connections_on_host_removal_;
   const bool warm_hosts_;
+  const float prefetch_ratio_;
+  const bool prefetch_on_host_add_;
+  const std::unique_ptr<ClusterPrefetchStats> prefetch_stats_;
   absl::optional<std::string> eds_service_name_;
   const absl::optional<envoy::api::v2::Cluster::CustomClusterType> cluster_type_;
   const std::unique_ptr<Server::Configuration::CommonFactoryContext> factory_context_;
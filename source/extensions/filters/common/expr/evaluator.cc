@@ -1,7 +1,12 @@
 #include "extensions/filters/common/expr/evaluator.h"
 
+#include <algorithm>
+
 #include "envoy/common/exception.h"
 
+#include "common/common/assert.h"
+
+#include "absl/strings/str_cat.h"
 #include "eval/public/builtin_func_registrar.h"
 #include "eval/public/cel_expr_builder_factory.h"
 
@@ -11,6 +16,287 @@ namespace Filters {
 namespace Common {
 namespace Expr {
 
+namespace {
+
+using Activation = google::api::expr::runtime::Activation;
+using CelMap = google::api::expr::runtime::CelMap;
+using SyntaxExpr = google::api::expr::v1alpha1::Expr;
+
+// Name of the CEL index operator, as in request.headers['x-foo'].
+constexpr absl::string_view IndexFunction = "_[_]";
+
+// Intermediate results of typical conditions fit into this many bytes.
+constexpr size_t ArenaInitialBlockSize = 2048;
+
+uint32_t rootBit(Root root) { return 1u << static_cast<uint32_t>(root); }
+
+constexpr uint32_t AllRoots = ~0u;
+
+absl::optional<Root> parseRoot(absl::string_view name) {
+  if (name == Request) {
+    return Root::Request;
+  } else if (name == Response) {
+    return Root::Response;
+  } else if (name == Metadata) {
+    return Root::Metadata;
+  } else if (name == Connection) {
+    return Root::Connection;
+  } else if (name == Upstream) {
+    return Root::Upstream;
+  } else if (name == Source) {
+    return Root::Source;
+  } else if (name == Destination) {
+    return Root::Destination;
+  }
+  return {};
+}
+
+// Values of the top-level symbols for one evaluation.
+class Wrappers {
+public:
+  Wrappers(const StreamInfo::StreamInfo& info, const Http::HeaderMap* request_headers,
+           const Http::HeaderMap* response_headers, const Http::HeaderMap* response_trailers)
+      : info_(info), request_headers_(request_headers), response_headers_(response_headers),
+        response_trailers_(response_trailers), request_(request_headers, info),
+        response_(response_headers, response_trailers, info), connection_(info), upstream_(info),
+        source_(info, false), destination_(info, true) {}
+
+  // Inserts the top-level symbols whose bits are set in the roots mask.
+  void insert(Activation& activation, Protobuf::Arena* arena, uint32_t roots) const {
+    if (roots & rootBit(Root::Request)) {
+      activation.InsertValue(Request, CelValue::CreateMap(&request_));
+    }
+    if (roots & rootBit(Root::Response)) {
+      activation.InsertValue(Response, CelValue::CreateMap(&response_));
+    }
+    if (roots & rootBit(Root::Metadata)) {
+      activation.InsertValue(Metadata, CelValue::CreateMessage(&info_.dynamicMetadata(), arena));
+    }
+    if (roots & rootBit(Root::Connection)) {
+      activation.InsertValue(Connection, CelValue::CreateMap(&connection_));
+    }
+    if (roots & rootBit(Root::Upstream)) {
+      activation.InsertValue(Upstream, CelValue::CreateMap(&upstream_));
+    }
+    if (roots & rootBit(Root::Source)) {
+      activation.InsertValue(Source, CelValue::CreateMap(&source_));
+    }
+    if (roots & rootBit(Root::Destination)) {
+      activation.InsertValue(Destination, CelValue::CreateMap(&destination_));
+    }
+  }
+
+  absl::optional<CelValue> resolve(const CompiledAttribute& attribute) const {
+    switch (attribute.kind_) {
+    case CompiledAttribute::Kind::Property:
+      return map(attribute.root_)[CelValue::CreateString(attribute.field_)];
+    case CompiledAttribute::Kind::Header:
+      return header(attribute.root_ == Root::Request ? request_headers_ : response_headers_,
+                    attribute.header_);
+    case CompiledAttribute::Kind::Trailer:
+      return header(response_trailers_, attribute.header_);
+    }
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+
+private:
+  static absl::optional<CelValue> header(const Http::HeaderMap* headers,
+                                         const Http::LowerCaseString& name) {
+    if (headers == nullptr) {
+      return {};
+    }
+    const Http::HeaderEntry* entry = headers->get(name);
+    if (entry == nullptr) {
+      return {};
+    }
+    return CelValue::CreateString(entry->value().getStringView());
+  }
+
+  const CelMap& map(Root root) const {
+    switch (root) {
+    case Root::Request:
+      return request_;
+    case Root::Response:
+      return response_;
+    case Root::Connection:
+      return connection_;
+    case Root::Upstream:
+      return upstream_;
+    case Root::Source:
+      return source_;
+    case Root::Destination:
+      return destination_;
+    case Root::Metadata:
+      break;
+    }
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+
+  const StreamInfo::StreamInfo& info_;
+  const Http::HeaderMap* request_headers_;
+  const Http::HeaderMap* response_headers_;
+  const Http::HeaderMap* response_trailers_;
+  const RequestWrapper request_;
+  const ResponseWrapper response_;
+  const ConnectionWrapper connection_;
+  const UpstreamWrapper upstream_;
+  const PeerWrapper source_;
+  const PeerWrapper destination_;
+};
+
+absl::optional<CelValue> evaluateActivation(const Expression& expr, const Activation& activation,
+                                            Protobuf::Arena* arena) {
+  auto eval_status = expr.Evaluate(activation, arena);
+  if (!eval_status.ok()) {
+    return {};
+  }
+
+  return eval_status.ValueOrDie();
+}
+
+// Replaces the attribute paths of an expression with identifiers.
+class AttributeCompiler {
+public:
+  AttributeCompiler(std::vector<CompiledAttribute>& attributes, uint32_t& roots)
+      : attributes_(attributes), roots_(roots) {}
+
+  void rewrite(SyntaxExpr& expr) {
+    const absl::optional<size_t> index = attribute(expr);
+    if (index.has_value()) {
+      expr.mutable_ident_expr()->set_name(attributes_[index.value()].identifier_);
+      return;
+    }
+
+    switch (expr.expr_kind_case()) {
+    case SyntaxExpr::kIdentExpr: {
+      const absl::optional<Root> root = rootIdentifier(expr);
+      if (root.has_value()) {
+        roots_ |= rootBit(root.value());
+      }
+      break;
+    }
+    case SyntaxExpr::kSelectExpr:
+      rewrite(*expr.mutable_select_expr()->mutable_operand());
+      break;
+    case SyntaxExpr::kCallExpr: {
+      auto* call = expr.mutable_call_expr();
+      if (call->has_target()) {
+        rewrite(*call->mutable_target());
+      }
+      for (auto& arg : *call->mutable_args()) {
+        rewrite(arg);
+      }
+      break;
+    }
+    case SyntaxExpr::kListExpr:
+      for (auto& element : *expr.mutable_list_expr()->mutable_elements()) {
+        rewrite(element);
+      }
+      break;
+    case SyntaxExpr::kStructExpr:
+      for (auto& entry : *expr.mutable_struct_expr()->mutable_entries()) {
+        if (entry.has_map_key()) {
+          rewrite(*entry.mutable_map_key());
+        }
+        rewrite(*entry.mutable_value());
+      }
+      break;
+    case SyntaxExpr::kComprehensionExpr: {
+      auto* comprehension = expr.mutable_comprehension_expr();
+      rewrite(*comprehension->mutable_iter_range());
+      rewrite(*comprehension->mutable_accu_init());
+      // The loop variables may shadow the top-level symbols.
+      scope_.push_back(comprehension->iter_var());
+      scope_.push_back(comprehension->accu_var());
+      rewrite(*comprehension->mutable_loop_condition());
+      rewrite(*comprehension->mutable_loop_step());
+      rewrite(*comprehension->mutable_result());
+      scope_.resize(scope_.size() - 2);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+private:
+  // Returns the index of the attribute if the expression is a select or an index of an attribute
+  // path.
+  absl::optional<size_t> attribute(const SyntaxExpr& expr) {
+    const SyntaxExpr* operand;
+    absl::string_view field;
+    if (expr.has_select_expr() && !expr.select_expr().test_only()) {
+      operand = &expr.select_expr().operand();
+      field = expr.select_expr().field();
+    } else if (expr.has_call_expr() && expr.call_expr().function() == IndexFunction &&
+               !expr.call_expr().has_target() && expr.call_expr().args_size() == 2 &&
+               expr.call_expr().args(1).const_expr().constant_kind_case() ==
+                   google::api::expr::v1alpha1::Constant::kStringValue) {
+      operand = &expr.call_expr().args(0);
+      field = expr.call_expr().args(1).const_expr().string_value();
+    } else {
+      return {};
+    }
+
+    const absl::optional<Root> root = rootIdentifier(*operand);
+    if (root.has_value()) {
+      // Metadata is a message, and headers and trailers are maps, which stay in the expression.
+      if (root.value() == Root::Metadata || field == Headers || field == Trailers) {
+        return {};
+      }
+      return add(CompiledAttribute::Kind::Property, root.value(), field);
+    }
+
+    if (operand->has_select_expr() && !operand->select_expr().test_only()) {
+      const absl::optional<Root> map_root = rootIdentifier(operand->select_expr().operand());
+      const absl::string_view map = operand->select_expr().field();
+      if (map_root == Root::Request && map == Headers) {
+        return add(CompiledAttribute::Kind::Header, Root::Request, field);
+      } else if (map_root == Root::Response && map == Headers) {
+        return add(CompiledAttribute::Kind::Header, Root::Response, field);
+      } else if (map_root == Root::Response && map == Trailers) {
+        return add(CompiledAttribute::Kind::Trailer, Root::Response, field);
+      }
+    }
+    return {};
+  }
+
+  // Returns the top-level symbol an identifier refers to, unless a loop variable shadows it.
+  absl::optional<Root> rootIdentifier(const SyntaxExpr& expr) const {
+    if (!expr.has_ident_expr()) {
+      return {};
+    }
+    const std::string& name = expr.ident_expr().name();
+    if (std::find(scope_.begin(), scope_.end(), name) != scope_.end()) {
+      return {};
+    }
+    return parseRoot(name);
+  }
+
+  size_t add(CompiledAttribute::Kind kind, Root root, absl::string_view field) {
+    const bool header = kind != CompiledAttribute::Kind::Property;
+    Http::LowerCaseString header_name(header ? std::string(field) : std::string());
+    for (size_t i = 0; i < attributes_.size(); i++) {
+      const CompiledAttribute& attribute = attributes_[i];
+      if (attribute.kind_ == kind && attribute.root_ == root &&
+          (header ? attribute.header_.get() == header_name.get() : attribute.field_ == field)) {
+        return i;
+      }
+    }
+    // '$' is not allowed in CEL identifiers, so these never clash with the names of the
+    // expression.
+    attributes_.push_back({kind, root, std::string(field), std::move(header_name),
+                           absl::StrCat("$", attributes_.size())});
+    return attributes_.size() - 1;
+  }
+
+  std::vector<CompiledAttribute>& attributes_;
+  uint32_t& roots_;
+  std::vector<std::string> scope_;
+};
+
+} // namespace
+
 BuilderPtr createBuilder(Protobuf::Arena* arena) {
   google::api::expr::runtime::InterpreterOptions options;
 
@@ -47,27 +333,10 @@ absl::optional<CelValue> evaluate(const Expression& expr, Protobuf::Arena* arena
                                   const Http::HeaderMap* request_headers,
                                   const Http::HeaderMap* response_headers,
                                   const Http::HeaderMap* response_trailers) {
-  google::api::expr::runtime::Activation activation;
-  const RequestWrapper request(request_headers, info);
-  const ResponseWrapper response(response_headers, response_trailers, info);
-  const ConnectionWrapper connection(info);
-  const UpstreamWrapper upstream(info);
-  const PeerWrapper source(info, false);
-  const PeerWrapper destination(info, true);
-  activation.InsertValue(Request, CelValue::CreateMap(&request));
-  activation.InsertValue(Response, CelValue::CreateMap(&response));
-  activation.InsertValue(Metadata, CelValue::CreateMessage(&info.dynamicMetadata(), arena));
-  activation.InsertValue(Connection, CelValue::CreateMap(&connection));
-  activation.InsertValue(Upstream, CelValue::CreateMap(&upstream));
-  activation.InsertValue(Source, CelValue::CreateMap(&source));
-  activation.InsertValue(Destination, CelValue::CreateMap(&destination));
-
-  auto eval_status = expr.Evaluate(activation, arena);
-  if (!eval_status.ok()) {
-    return {};
-  }
-
-  return eval_status.ValueOrDie();
+  Activation activation;
+  const Wrappers wrappers(info, request_headers, response_headers, response_trailers);
+  wrappers.insert(activation, arena, AllRoots);
+  return evaluateActivation(expr, activation, arena);
 }
 
 bool matches(const Expression& expr, const StreamInfo::StreamInfo& info,
@@ -81,6 +350,47 @@ bool matches(const Expression& expr, const StreamInfo::StreamInfo& info,
   return result.IsBool() ? result.BoolOrDie() : false;
 }
 
+CompiledExpression::CompiledExpression(Builder& builder,
+                                       const google::api::expr::v1alpha1::Expr& expr)
+    : expr_(expr) {
+  AttributeCompiler(attributes_, roots_).rewrite(expr_);
+  expression_ = createExpression(builder, expr_);
+}
+
+absl::optional<CelValue>
+CompiledExpression::evaluate(Protobuf::Arena* arena, const StreamInfo::StreamInfo& info,
+                             const Http::HeaderMap* request_headers,
+                             const Http::HeaderMap* response_headers,
+                             const Http::HeaderMap* response_trailers) const {
+  Activation activation;
+  const Wrappers wrappers(info, request_headers, response_headers, response_trailers);
+  wrappers.insert(activation, arena, roots_);
+  for (const CompiledAttribute& attribute : attributes_) {
+    // A missing value leaves the identifier unbound, which evaluates to an error like a missing
+    // key of the original map.
+    const absl::optional<CelValue> value = wrappers.resolve(attribute);
+    if (value.has_value()) {
+      activation.InsertValue(attribute.identifier_, value.value());
+    }
+  }
+  return evaluateActivation(*expression_, activation, arena);
+}
+
+bool CompiledExpression::matches(const StreamInfo::StreamInfo& info,
+                                 const Http::HeaderMap& headers) const {
+  alignas(8) char initial_block[ArenaInitialBlockSize];
+  Protobuf::ArenaOptions options;
+  options.initial_block = initial_block;
+  options.initial_block_size = sizeof(initial_block);
+  Protobuf::Arena arena(options);
+  auto eval_status = evaluate(&arena, info, &headers, nullptr, nullptr);
+  if (!eval_status.has_value()) {
+    return false;
+  }
+  auto result = eval_status.value();
+  return result.IsBool() ? result.BoolOrDie() : false;
+}
+
 } // namespace Expr
 } // namespace Common
 } // namespace Filters
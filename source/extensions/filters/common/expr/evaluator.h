@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "envoy/stream_info/stream_info.h"
 
 #include "common/http/headers.h"
@@ -43,6 +46,57 @@ absl::optional<CelValue> evaluate(const Expression& expr, Protobuf::Arena* arena
 bool matches(const Expression& expr, const StreamInfo::StreamInfo& info,
              const Http::HeaderMap& headers);
 
+// Top-level symbols of the activation.
+enum class Root { Request, Response, Metadata, Connection, Upstream, Source, Destination };
+
+// An attribute path of an expression, such as request.path or request.headers['x-foo'], which is
+// resolved once per evaluation without going through the CEL select and index steps.
+struct CompiledAttribute {
+  enum class Kind { Property, Header, Trailer };
+
+  Kind kind_;
+  Root root_;
+  // Property name for Property, header name for Header and Trailer.
+  std::string field_;
+  // Lower cased header name, prepared at load time for Header and Trailer.
+  Http::LowerCaseString header_;
+  // Identifier which replaces the attribute path in the expression.
+  std::string identifier_;
+};
+
+/**
+ * An expression whose attribute paths are resolved at load time. Occurrences of the same attribute
+ * share one identifier, so that a header is looked up at most once per evaluation, and the
+ * top-level symbols which are no longer referenced are left out of the activation.
+ */
+class CompiledExpression {
+public:
+  // Throws an exception if fails to construct a runtime expression.
+  CompiledExpression(Builder& builder, const google::api::expr::v1alpha1::Expr& expr);
+
+  // Same as Expr::evaluate() for the original expression.
+  absl::optional<CelValue> evaluate(Protobuf::Arena* arena, const StreamInfo::StreamInfo& info,
+                                    const Http::HeaderMap* request_headers,
+                                    const Http::HeaderMap* response_headers,
+                                    const Http::HeaderMap* response_trailers) const;
+
+  // Same as Expr::matches() for the original expression. Intermediate results are kept in an
+  // arena whose initial block is on the stack, so that typical evaluations do not allocate it.
+  bool matches(const StreamInfo::StreamInfo& info, const Http::HeaderMap& headers) const;
+
+  const std::vector<CompiledAttribute>& attributes() const { return attributes_; }
+
+private:
+  // The rewritten expression. The runtime expression refers to it, so it is declared first.
+  google::api::expr::v1alpha1::Expr expr_;
+  std::vector<CompiledAttribute> attributes_;
+  // Bit mask of the top-level symbols referenced by the rewritten expression.
+  uint32_t roots_{};
+  ExpressionPtr expression_;
+};
+
+using CompiledExpressionPtr = std::unique_ptr<CompiledExpression>;
+
 } // namespace Expr
 } // namespace Common
 } // namespace Filters
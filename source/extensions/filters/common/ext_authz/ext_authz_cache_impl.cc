@@ -0,0 +1,204 @@
+#include "extensions/filters/common/ext_authz/ext_authz_cache_impl.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+#include "common/protobuf/utility.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace ExtAuthz {
+
+namespace {
+
+// The default number of decisions cached by each worker.
+constexpr uint32_t DefaultMaxEntries = 10000;
+
+std::vector<std::string>
+lowerCaseHeaders(const Protobuf::RepeatedPtrField<std::string>& headers) {
+  std::vector<std::string> lower_case;
+  for (const std::string& header : headers) {
+    lower_case.push_back(absl::AsciiStrToLower(header));
+  }
+  return lower_case;
+}
+
+} // namespace
+
+ResponseSharedPtr DecisionLruCache::lookup(absl::string_view key, MonotonicTime now) {
+  const Decision* decision = decisions_.lookup(key);
+  if (decision == nullptr) {
+    return nullptr;
+  }
+  if (now >= decision->expiry_) {
+    decisions_.erase(key);
+    return nullptr;
+  }
+  return decision->response_;
+}
+
+void DecisionLruCache::insert(const std::string& key, ResponseSharedPtr response,
+                              MonotonicTime expiry) {
+  decisions_.insert(key, {std::move(response), expiry});
+}
+
+DecisionCacheConfig::DecisionCacheConfig(
+    const envoy::config::filter::http::ext_authz::v2::DecisionCache& config,
+    ThreadLocal::SlotAllocator& tls, TimeSource& time_source, const std::string& stats_prefix,
+    Stats::Scope& scope)
+    : key_headers_(lowerCaseHeaders(config.key_headers())), path_segments_(config.path_segments()),
+      strip_query_(config.strip_query()),
+      ttl_(DurationUtil::durationToMilliseconds(config.ttl())),
+      cache_denied_(config.cache_denied()), time_source_(time_source), slot_(tls.allocateSlot()),
+      stats_({ALL_DECISION_CACHE_STATS(
+          POOL_COUNTER_PREFIX(scope, absl::StrCat(stats_prefix, "ext_authz.cache.")))}) {
+  const uint32_t max_entries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_entries,
+                                                               DefaultMaxEntries);
+  slot_->set([max_entries](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<DecisionCache>(max_entries);
+  });
+  if (config.shared()) {
+    shared_cache_ = std::make_unique<SharedDecisionCache>(max_entries);
+  }
+}
+
+std::string DecisionCacheConfig::key(const envoy::service::auth::v2::CheckRequest& request) const {
+  const auto& http = request.attributes().request().http();
+
+  absl::string_view path = http.path();
+  if (strip_query_ || path_segments_ > 0) {
+    path = path.substr(0, path.find('?'));
+  }
+  if (path_segments_ > 0) {
+    size_t end = 0;
+    for (uint32_t i = 0; i < path_segments_ && end != absl::string_view::npos; i++) {
+      end = path.find('/', end + 1);
+    }
+    path = path.substr(0, end);
+  }
+
+  // The principal of the peer is always part of the key, as the decisions of any authorization
+  // service depend on it.
+  std::string key = absl::StrCat(request.attributes().source().principal(), "\n", http.method(),
+                                 "\n", http.host(), "\n", path, "\n");
+  for (const std::string& header : key_headers_) {
+    const auto it = http.headers().find(header);
+    if (it != http.headers().end()) {
+      absl::StrAppend(&key, "=", it->second);
+    }
+    key.push_back('\n');
+  }
+
+  // The context extensions are in a map without a defined order.
+  const auto& context_extensions = request.attributes().context_extensions();
+  std::vector<std::pair<absl::string_view, absl::string_view>> extensions(
+      context_extensions.begin(), context_extensions.end());
+  std::sort(extensions.begin(), extensions.end());
+  for (const auto& extension : extensions) {
+    absl::StrAppend(&key, extension.first, "=", extension.second, "\n");
+  }
+  return key;
+}
+
+bool DecisionCacheConfig::cacheable(const Response& response) const {
+  switch (response.status) {
+  case CheckStatus::OK:
+    return true;
+  case CheckStatus::Denied:
+    return cache_denied_;
+  case CheckStatus::Error:
+    return false;
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+void CachingClientImpl::cancel() {
+  ASSERT(callbacks_ != nullptr);
+  callbacks_ = nullptr;
+  auto& in_flight = config_->workerCache().inFlight();
+  auto it = in_flight.find(key_);
+  ASSERT(it != in_flight.end());
+  const bool calling = it->second.front() == this;
+  it->second.remove(this);
+  if (!calling) {
+    return;
+  }
+  client_->cancel();
+  if (it->second.empty()) {
+    in_flight.erase(it);
+  } else {
+    // The next check coalesced into this one calls the authorization service instead.
+    it->second.front()->startCheck();
+  }
+}
+
+void CachingClientImpl::check(RequestCallbacks& callbacks,
+                              const envoy::service::auth::v2::CheckRequest& request,
+                              Tracing::Span& parent_span) {
+  ASSERT(callbacks_ == nullptr);
+  key_ = config_->key(request);
+  DecisionCache& cache = config_->workerCache();
+  const MonotonicTime now = config_->timeSource().monotonicTime();
+  ResponseSharedPtr cached = cache.decisions().lookup(key_, now);
+  if (cached == nullptr && config_->sharedCache() != nullptr) {
+    cached = config_->sharedCache()->lookup(key_, now);
+  }
+  if (cached != nullptr) {
+    config_->stats().hit_.inc();
+    callbacks.onComplete(std::make_unique<Response>(*cached));
+    return;
+  }
+
+  callbacks_ = &callbacks;
+  request_ = &request;
+  parent_span_ = &parent_span;
+  std::list<CachingClientImpl*>& checks = cache.inFlight()[key_];
+  checks.push_back(this);
+  if (checks.size() > 1) {
+    config_->stats().coalesced_.inc();
+    return;
+  }
+  config_->stats().miss_.inc();
+  startCheck();
+}
+
+void CachingClientImpl::startCheck() { client_->check(*this, *request_, *parent_span_); }
+
+void CachingClientImpl::onComplete(ResponsePtr&& response) {
+  const ResponseSharedPtr decision = std::move(response);
+  DecisionCache& cache = config_->workerCache();
+  if (config_->cacheable(*decision)) {
+    const MonotonicTime expiry = config_->timeSource().monotonicTime() + config_->ttl();
+    cache.decisions().insert(key_, decision, expiry);
+    if (config_->sharedCache() != nullptr) {
+      config_->sharedCache()->insert(key_, decision, expiry);
+    }
+  }
+
+  // This check is the first one of those it completes.
+  std::list<CachingClientImpl*> checks;
+  auto it = cache.inFlight().find(key_);
+  ASSERT(it != cache.inFlight().end());
+  checks.swap(it->second);
+  cache.inFlight().erase(it);
+  for (CachingClientImpl* check : checks) {
+    check->complete(std::make_unique<Response>(*decision));
+  }
+}
+
+void CachingClientImpl::complete(ResponsePtr&& response) {
+  RequestCallbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->onComplete(std::move(response));
+}
+
+} // namespace ExtAuthz
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/ext_authz/v2/ext_authz.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/lru_cache.h"
+#include "common/common/thread.h"
+
+#include "extensions/filters/common/ext_authz/ext_authz.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace ExtAuthz {
+
+/**
+ * All ext_authz decision cache stats. @see stats_macros.h
+ */
+#define ALL_DECISION_CACHE_STATS(COUNTER)                                                          \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(coalesced)
+
+/**
+ * Struct definition for all ext_authz decision cache stats. @see stats_macros.h
+ */
+struct DecisionCacheStats {
+  ALL_DECISION_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+using ResponseSharedPtr = std::shared_ptr<const Response>;
+
+/**
+ * An LRU cache of the decisions of the authorization service, which expire after a TTL.
+ */
+class DecisionLruCache {
+public:
+  DecisionLruCache(uint64_t max_entries) : decisions_(max_entries) {}
+
+  /**
+   * @return ResponseSharedPtr the decision cached under the key, which becomes the most recently
+   *         used one, or nullptr if there is none which has not expired.
+   */
+  ResponseSharedPtr lookup(absl::string_view key, MonotonicTime now);
+
+  /**
+   * Caches a decision, evicting the least recently used one if the cache is full.
+   */
+  void insert(const std::string& key, ResponseSharedPtr response, MonotonicTime expiry);
+
+  uint64_t size() const { return decisions_.size(); }
+
+private:
+  struct Decision {
+    ResponseSharedPtr response_;
+    MonotonicTime expiry_;
+  };
+
+  LruCache<std::string, Decision> decisions_;
+};
+
+/**
+ * The decisions cached for all the workers, which are guarded by a lock.
+ */
+class SharedDecisionCache {
+public:
+  SharedDecisionCache(uint64_t max_entries) : decisions_(max_entries) {}
+
+  ResponseSharedPtr lookup(absl::string_view key, MonotonicTime now) {
+    Thread::LockGuard lock(lock_);
+    return decisions_.lookup(key, now);
+  }
+
+  void insert(const std::string& key, ResponseSharedPtr response, MonotonicTime expiry) {
+    Thread::LockGuard lock(lock_);
+    decisions_.insert(key, std::move(response), expiry);
+  }
+
+private:
+  Thread::MutexBasicLockable lock_;
+  DecisionLruCache decisions_ ABSL_GUARDED_BY(lock_);
+};
+
+class CachingClientImpl;
+
+/**
+ * The decisions cached by a worker, and the checks it has in flight, which identical checks are
+ * coalesced into.
+ */
+class DecisionCache : public ThreadLocal::ThreadLocalObject {
+public:
+  DecisionCache(uint64_t max_entries) : decisions_(max_entries) {}
+
+  DecisionLruCache& decisions() { return decisions_; }
+
+  /**
+   * The clients waiting for the check with a key, by the key. The first client is the one calling
+   * the authorization service.
+   */
+  absl::flat_hash_map<std::string, std::list<CachingClientImpl*>>& inFlight() {
+    return in_flight_;
+  }
+
+private:
+  DecisionLruCache decisions_;
+  absl::flat_hash_map<std::string, std::list<CachingClientImpl*>> in_flight_;
+};
+
+/**
+ * Configuration of the decision cache of an ext_authz filter.
+ */
+class DecisionCacheConfig {
+public:
+  DecisionCacheConfig(const envoy::config::filter::http::ext_authz::v2::DecisionCache& config,
+                      ThreadLocal::SlotAllocator& tls, TimeSource& time_source,
+                      const std::string& stats_prefix, Stats::Scope& scope);
+
+  /**
+   * @return std::string the key of the decision of a check request.
+   */
+  std::string key(const envoy::service::auth::v2::CheckRequest& request) const;
+
+  /**
+   * @return bool whether a decision may be cached.
+   */
+  bool cacheable(const Response& response) const;
+
+  DecisionCache& workerCache() { return slot_->getTyped<DecisionCache>(); }
+  // nullptr unless the decisions are shared by the workers.
+  SharedDecisionCache* sharedCache() { return shared_cache_.get(); }
+  TimeSource& timeSource() { return time_source_; }
+  std::chrono::milliseconds ttl() const { return ttl_; }
+  DecisionCacheStats& stats() { return stats_; }
+
+private:
+  const std::vector<std::string> key_headers_;
+  const uint32_t path_segments_;
+  const bool strip_query_;
+  const std::chrono::milliseconds ttl_;
+  const bool cache_denied_;
+  TimeSource& time_source_;
+  ThreadLocal::SlotPtr slot_;
+  std::unique_ptr<SharedDecisionCache> shared_cache_;
+  DecisionCacheStats stats_;
+};
+
+using DecisionCacheConfigSharedPtr = std::shared_ptr<DecisionCacheConfig>;
+
+/**
+ * An authorization client which answers checks from the decision cache, and coalesces checks with
+ * the same key in flight on the worker, calling the authorization service once for all of them.
+ */
+class CachingClientImpl : public Client, public RequestCallbacks {
+public:
+  CachingClientImpl(ClientPtr&& client, DecisionCacheConfigSharedPtr config)
+      : client_(std::move(client)), config_(std::move(config)) {}
+
+  // ExtAuthz::Client
+  void cancel() override;
+  void check(RequestCallbacks& callbacks, const envoy::service::auth::v2::CheckRequest& request,
+             Tracing::Span& parent_span) override;
+
+  // ExtAuthz::RequestCallbacks
+  void onComplete(ResponsePtr&& response) override;
+
+private:
+  // Calls the authorization service for the checks with the key.
+  void startCheck();
+  void complete(ResponsePtr&& response);
+
+  ClientPtr client_;
+  DecisionCacheConfigSharedPtr config_;
+  std::string key_;
+  RequestCallbacks* callbacks_{};
+  const envoy::service::auth::v2::CheckRequest* request_{};
+  Tracing::Span* parent_span_{};
+};
+
+} // namespace ExtAuthz
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
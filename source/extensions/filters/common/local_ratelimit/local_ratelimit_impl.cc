@@ -0,0 +1,24 @@
+#include "extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
+
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+
+SharedTokenBucketImplPtr createTokenBucket(const envoy::type::TokenBucket& config,
+                                           TimeSource& time_source) {
+  const double tokens_per_fill = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, tokens_per_fill, 1);
+  const double fill_interval_seconds =
+      config.fill_interval().seconds() + config.fill_interval().nanos() / 1e9;
+  return std::make_unique<SharedTokenBucketImpl>(config.max_tokens(), time_source,
+                                                 tokens_per_fill / fill_interval_seconds);
+}
+
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
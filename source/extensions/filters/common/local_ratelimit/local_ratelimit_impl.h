@@ -0,0 +1,25 @@
+#pragma once
+
+#include "envoy/common/time.h"
+#include "envoy/type/token_bucket.pb.h"
+
+#include "common/common/shared_token_bucket_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+
+/**
+ * Creates the token bucket with the given configuration. The bucket is safe to share between
+ * workers.
+ */
+SharedTokenBucketImplPtr createTokenBucket(const envoy::type::TokenBucket& config,
+                                           TimeSource& time_source);
+
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
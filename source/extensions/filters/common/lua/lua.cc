@@ -12,8 +12,17 @@ namespace Filters {
 namespace Common {
 namespace Lua {
 
-Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state)
-    : coroutine_state_(new_thread_state, false) {}
+namespace {
+
+// Upper bound of the coroutines pooled per worker. The pool only grows up to the number of scripts
+// running concurrently on the worker, this bounds it after a burst.
+constexpr size_t MaxPooledCoroutines = 1024;
+
+} // namespace
+
+Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state,
+                     TimeSource& time_source)
+    : coroutine_state_(new_thread_state, false), time_source_(time_source) {}
 
 void Coroutine::start(int function_ref, int num_args, const std::function<void()>& yield_callback) {
   ASSERT(state_ == State::NotStarted);
@@ -30,7 +39,9 @@ void Coroutine::start(int function_ref, int num_args, const std::function<void()
 
 void Coroutine::resume(int num_args, const std::function<void()>& yield_callback) {
   ASSERT(state_ == State::Yielded);
+  const MonotonicTime start_time = time_source_.monotonicTime();
   int rc = lua_resume(coroutine_state_.get(), num_args);
+  run_time_ += time_source_.monotonicTime() - start_time;
 
   if (0 == rc) {
     state_ = State::Finished;
@@ -41,13 +52,22 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
     yield_callback();
   } else {
     state_ = State::Finished;
+    failed_ = true;
     const char* error = lua_tostring(coroutine_state_.get(), -1);
     throw LuaException(error);
   }
 }
 
-ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls)
-    : tls_slot_(tls.allocateSlot()) {
+void Coroutine::recycle() {
+  ASSERT(reusable());
+  lua_settop(coroutine_state_.get(), 0);
+  state_ = State::NotStarted;
+  run_time_ = std::chrono::nanoseconds::zero();
+}
+
+ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls,
+                                   TimeSource& time_source)
+    : tls_slot_(tls.allocateSlot()), time_source_(time_source) {
 
   // First verify that the supplied code can be parsed.
   CSmartPtr<lua_State, lua_close> state(lua_open());
@@ -86,8 +106,40 @@ uint64_t ThreadLocalState::registerGlobal(const std::string& global) {
 }
 
 CoroutinePtr ThreadLocalState::createCoroutine() {
-  lua_State* state = tls_slot_->getTyped<LuaThreadLocal>().state_.get();
-  return std::make_unique<Coroutine>(std::make_pair(lua_newthread(state), state));
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  if (!tls.coroutine_pool_.empty()) {
+    CoroutinePtr coroutine = std::move(tls.coroutine_pool_.back());
+    tls.coroutine_pool_.pop_back();
+    return coroutine;
+  }
+
+  lua_State* state = tls.state_.get();
+  return std::make_unique<Coroutine>(std::make_pair(lua_newthread(state), state), time_source_);
+}
+
+void ThreadLocalState::releaseCoroutine(CoroutinePtr&& coroutine) {
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  if (!coroutine->reusable() || tls.coroutine_pool_.size() >= MaxPooledCoroutines) {
+    coroutine.reset();
+    return;
+  }
+
+  coroutine->recycle();
+  tls.coroutine_pool_.push_back(std::move(coroutine));
+}
+
+bool ThreadLocalState::runtimeGCStep() {
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  lua_State* state = tls.state_.get();
+  if (!tls.gc_cycle_running_ && bytesUsed(state) < tls.gc_pause_bytes_) {
+    return false;
+  }
+
+  tls.gc_cycle_running_ = lua_gc(state, LUA_GCSTEP, 0) == 0;
+  if (!tls.gc_cycle_running_) {
+    tls.gc_pause_bytes_ = 2 * bytesUsed(state);
+  }
+  return true;
 }
 
 ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code) : state_(lua_open()) {
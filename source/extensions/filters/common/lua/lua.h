@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "envoy/common/exception.h"
+#include "envoy/common/time.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/assert.h"
@@ -324,10 +325,15 @@ class Coroutine : Logger::Loggable<Logger::Id::lua> {
 public:
   enum class State { NotStarted, Yielded, Finished };
 
-  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state);
+  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state, TimeSource& time_source);
   lua_State* luaState() { return coroutine_state_.get(); }
   State state() { return state_; }
 
+  /**
+   * @return the time spent running the coroutine in start() and resume() since it was started.
+   */
+  std::chrono::nanoseconds runTime() const { return run_time_; }
+
   /**
    * Start a coroutine.
    * @param function_ref supplies the previously registered function to call. Registered with
@@ -347,8 +353,25 @@ public:
   void resume(int num_args, const std::function<void()>& yield_callback);
 
 private:
+  friend class ThreadLocalState;
+
+  /**
+   * @return whether the coroutine can be started again. Only coroutines which returned without
+   *         an error can be, as yielded coroutines still hold the frames of the script and
+   *         coroutines which raised an error are dead.
+   */
+  bool reusable() const { return state_ == State::Finished && !failed_; }
+
+  /**
+   * Clear the results of the previous run so that the coroutine can be started again.
+   */
+  void recycle();
+
   LuaRef<lua_State> coroutine_state_;
+  TimeSource& time_source_;
   State state_{State::NotStarted};
+  bool failed_{};
+  std::chrono::nanoseconds run_time_{};
 };
 
 using CoroutinePtr = std::unique_ptr<Coroutine>;
@@ -360,13 +383,23 @@ using CoroutinePtr = std::unique_ptr<Coroutine>;
  */
 class ThreadLocalState : Logger::Loggable<Logger::Id::lua> {
 public:
-  ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls);
+  ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls,
+                   TimeSource& time_source);
 
   /**
-   * @return CoroutinePtr a new coroutine.
+   * @return CoroutinePtr a new coroutine. A coroutine previously returned to the worker's pool via
+   *         releaseCoroutine() is reused if there is one.
    */
   CoroutinePtr createCoroutine();
 
+  /**
+   * Return a coroutine to the worker's pool so that a later createCoroutine() on the same worker
+   * can reuse its Lua thread instead of allocating a new one. Coroutines which can not be started
+   * again, and coroutines released while the pool is full, are destroyed.
+   * @param coroutine supplies the coroutine to release.
+   */
+  void releaseCoroutine(CoroutinePtr&& coroutine);
+
   /**
    * @return a global reference previously registered via registerGlobal(). This may return
    *         LUA_REFNIL if there was no such global.
@@ -394,10 +427,7 @@ public:
    * Return the number of bytes used by the runtime.
    */
   uint64_t runtimeBytesUsed() {
-    uint64_t bytes_used =
-        lua_gc(tls_slot_->getTyped<LuaThreadLocal>().state_.get(), LUA_GCCOUNT, 0) * 1024;
-    bytes_used += lua_gc(tls_slot_->getTyped<LuaThreadLocal>().state_.get(), LUA_GCCOUNTB, 0);
-    return bytes_used;
+    return bytesUsed(tls_slot_->getTyped<LuaThreadLocal>().state_.get());
   }
 
   /**
@@ -405,15 +435,33 @@ public:
    */
   void runtimeGC() { lua_gc(tls_slot_->getTyped<LuaThreadLocal>().state_.get(), LUA_GCCOLLECT, 0); }
 
+  /**
+   * Run one incremental GC step on the worker's state, so that collection makes progress between
+   * requests rather than inside scripts. Once a step finishes a cycle, no further steps are run
+   * until the heap doubles, like the pause of the automatic collector.
+   * @return whether a step was run.
+   */
+  bool runtimeGCStep();
+
 private:
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
     LuaThreadLocal(const std::string& code);
 
     CSmartPtr<lua_State, lua_close> state_;
     std::vector<int> global_slots_;
+    // Declared after state_ as the pooled coroutines unref their threads when destroyed.
+    std::vector<CoroutinePtr> coroutine_pool_;
+    bool gc_cycle_running_{};
+    uint64_t gc_pause_bytes_{};
   };
 
+  static uint64_t bytesUsed(lua_State* state) {
+    return static_cast<uint64_t>(lua_gc(state, LUA_GCCOUNT, 0)) * 1024 +
+           lua_gc(state, LUA_GCCOUNTB, 0);
+  }
+
   ThreadLocal::SlotPtr tls_slot_;
+  TimeSource& time_source_;
   uint64_t current_global_slot_{};
 };
 
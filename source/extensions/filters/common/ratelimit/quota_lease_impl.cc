@@ -0,0 +1,175 @@
+#include "extensions/filters/common/ratelimit/quota_lease_impl.h"
+
+#include "common/common/assert.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RateLimit {
+
+namespace {
+
+// Expired leases are only dropped once there are this many, as they are replaced when the same
+// requests come again.
+constexpr size_t MaxLeases = 4096;
+
+} // namespace
+
+bool QuotaLeaseCache::tryConsume(const std::string& key) {
+  auto it = leases_.find(key);
+  if (it == leases_.end()) {
+    return false;
+  }
+  if (it->second.remaining_ == 0 || time_source_.monotonicTime() >= it->second.expiry_) {
+    leases_.erase(it);
+    return false;
+  }
+  it->second.remaining_--;
+  return true;
+}
+
+void QuotaLeaseCache::lease(const std::string& key, uint32_t requests,
+                            std::chrono::milliseconds duration) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (leases_.size() >= MaxLeases) {
+    for (auto it = leases_.begin(); it != leases_.end();) {
+      if (it->second.remaining_ == 0 || now >= it->second.expiry_) {
+        leases_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  Lease& lease = leases_[key];
+  if (now >= lease.expiry_) {
+    lease.remaining_ = 0;
+  }
+  lease.remaining_ += requests;
+  lease.expiry_ = now + duration;
+}
+
+bool QuotaLeaseCache::startCall(const std::string& key, QuotaLeaseClientImpl& client) {
+  auto it = calls_.find(key);
+  if (it == calls_.end()) {
+    calls_.emplace(key, std::list<QuotaLeaseClientImpl*>());
+    return true;
+  }
+  it->second.push_back(&client);
+  return false;
+}
+
+void QuotaLeaseCache::leaveCall(const std::string& key, QuotaLeaseClientImpl& client) {
+  auto it = calls_.find(key);
+  ASSERT(it != calls_.end());
+  it->second.remove(&client);
+}
+
+std::list<QuotaLeaseClientImpl*> QuotaLeaseCache::finishCall(const std::string& key) {
+  std::list<QuotaLeaseClientImpl*> clients;
+  auto it = calls_.find(key);
+  ASSERT(it != calls_.end());
+  clients.swap(it->second);
+  calls_.erase(it);
+  return clients;
+}
+
+std::string
+QuotaLeaseCache::leaseKey(const std::string& domain,
+                          const std::vector<Envoy::RateLimit::Descriptor>& descriptors) {
+  std::string key = domain;
+  for (const Envoy::RateLimit::Descriptor& descriptor : descriptors) {
+    key.push_back('\n');
+    for (const Envoy::RateLimit::DescriptorEntry& entry : descriptor.entries_) {
+      absl::StrAppend(&key, entry.key_, "=", entry.value_, ";");
+    }
+  }
+  return key;
+}
+
+void QuotaLeaseClientImpl::cancel() {
+  ASSERT(callbacks_ != nullptr);
+  callbacks_ = nullptr;
+  if (waiting_) {
+    waiting_ = false;
+    cache_.leaveCall(key_, *this);
+    return;
+  }
+  client_->cancel();
+  // One of the clients which waited for this call makes another one.
+  for (QuotaLeaseClientImpl* client : cache_.finishCall(key_)) {
+    client->onCallComplete(absl::nullopt);
+  }
+}
+
+void QuotaLeaseClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
+                                 const std::vector<Envoy::RateLimit::Descriptor>& descriptors,
+                                 Tracing::Span& parent_span) {
+  ASSERT(callbacks_ == nullptr);
+  key_ = QuotaLeaseCache::leaseKey(domain, descriptors);
+  if (cache_.tryConsume(key_)) {
+    callbacks.complete(LimitStatus::OK, nullptr, nullptr);
+    return;
+  }
+
+  callbacks_ = &callbacks;
+  if (cache_.startCall(key_, *this)) {
+    client_->limit(*this, domain, descriptors, parent_span);
+    return;
+  }
+  waiting_ = true;
+  domain_ = domain;
+  descriptors_ = descriptors;
+  parent_span_ = &parent_span;
+}
+
+void QuotaLeaseClientImpl::callService() {
+  if (cache_.startCall(key_, *this)) {
+    client_->limit(*this, domain_, descriptors_, *parent_span_);
+  } else {
+    waiting_ = true;
+  }
+}
+
+void QuotaLeaseClientImpl::onCallComplete(absl::optional<LimitStatus> status) {
+  waiting_ = false;
+  if (status.has_value() && status.value() != LimitStatus::OK) {
+    // The service did not lease the requests, so the waiting ones get the same answer.
+    RequestCallbacks* callbacks = callbacks_;
+    callbacks_ = nullptr;
+    callbacks->complete(status.value(), nullptr, nullptr);
+    return;
+  }
+  if (status.has_value() && cache_.tryConsume(key_)) {
+    RequestCallbacks* callbacks = callbacks_;
+    callbacks_ = nullptr;
+    callbacks->complete(LimitStatus::OK, nullptr, nullptr);
+    return;
+  }
+  // The call was cancelled, or its lease was used up by the clients which waited before this one.
+  callService();
+}
+
+void QuotaLeaseClientImpl::complete(LimitStatus status,
+                                    Http::HeaderMapPtr&& response_headers_to_add,
+                                    Http::HeaderMapPtr&& request_headers_to_add) {
+  if (status == LimitStatus::OK) {
+    // This request takes one of the leased requests.
+    cache_.lease(key_, hits_ - 1, duration_);
+  }
+  RequestCallbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  for (QuotaLeaseClientImpl* client : cache_.finishCall(key_)) {
+    client->onCallComplete(status);
+  }
+  callbacks->complete(status, std::move(response_headers_to_add),
+                      std::move(request_headers_to_add));
+}
+
+} // namespace RateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
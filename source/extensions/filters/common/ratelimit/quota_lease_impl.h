@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "extensions/filters/common/ratelimit/ratelimit.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RateLimit {
+
+class QuotaLeaseClientImpl;
+
+/**
+ * The requests a worker leased from the rate limit service, by the domain and descriptors of the
+ * requests they were leased for, and the calls to the service in flight to lease more.
+ */
+class QuotaLeaseCache : public ThreadLocal::ThreadLocalObject {
+public:
+  QuotaLeaseCache(TimeSource& time_source) : time_source_(time_source) {}
+
+  /**
+   * Takes a request from the lease of the given key.
+   * @return bool whether there was a leased request left which had not expired.
+   */
+  bool tryConsume(const std::string& key);
+
+  /**
+   * Records the lease of requests for the given key. The requests are added to those left from
+   * the previous lease, and all of them can be used until the new lease expires.
+   * @param requests supplies the number of requests leased.
+   * @param duration supplies how long the leased requests can be used for.
+   */
+  void lease(const std::string& key, uint32_t requests, std::chrono::milliseconds duration);
+
+  /**
+   * Records a call to the rate limit service to lease requests for the given key, unless one is
+   * already in flight, in which case the client waits for it.
+   * @return bool whether the client must call the service.
+   */
+  bool startCall(const std::string& key, QuotaLeaseClientImpl& client);
+
+  /**
+   * Stops a client from waiting for the call in flight for the given key.
+   */
+  void leaveCall(const std::string& key, QuotaLeaseClientImpl& client);
+
+  /**
+   * Records the end of the call in flight for the given key.
+   * @return the clients which waited for the call.
+   */
+  std::list<QuotaLeaseClientImpl*> finishCall(const std::string& key);
+
+  /**
+   * @return std::string the key of the lease of requests with the given domain and descriptors.
+   */
+  static std::string leaseKey(const std::string& domain,
+                              const std::vector<Envoy::RateLimit::Descriptor>& descriptors);
+
+private:
+  struct Lease {
+    uint32_t remaining_{};
+    MonotonicTime expiry_{};
+  };
+
+  TimeSource& time_source_;
+  absl::flat_hash_map<std::string, Lease> leases_;
+  // The clients waiting for the call in flight, by the key of the call.
+  absl::flat_hash_map<std::string, std::list<QuotaLeaseClientImpl*>> calls_;
+};
+
+/**
+ * A rate limit client which leases quota from the rate limit service in chunks. The client it
+ * wraps counts each call for a number of hits, and the requests which were allowed by that call are
+ * kept in a per worker cache. The following limit() calls with the same domain and descriptors are
+ * allowed from the cache, without calling the service, until the leased requests are used up or
+ * the lease expires. Only one call for the same domain and descriptors is in flight on a worker at
+ * a time, and the clients which need one meanwhile wait for its lease.
+ */
+class QuotaLeaseClientImpl : public Client, public RequestCallbacks {
+public:
+  /**
+   * @param client supplies the client calling the rate limit service, which must count each call
+   *        for the given number of hits.
+   * @param hits supplies the number of requests leased by each call to the service.
+   * @param duration supplies how long the leased requests can be used for.
+   */
+  QuotaLeaseClientImpl(ClientPtr&& client, QuotaLeaseCache& cache, uint32_t hits,
+                       std::chrono::milliseconds duration)
+      : client_(std::move(client)), cache_(cache), hits_(hits), duration_(duration) {}
+
+  // Filters::Common::RateLimit::Client
+  void cancel() override;
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Envoy::RateLimit::Descriptor>& descriptors,
+             Tracing::Span& parent_span) override;
+
+  // Filters::Common::RateLimit::RequestCallbacks
+  void complete(LimitStatus status, Http::HeaderMapPtr&& response_headers_to_add,
+                Http::HeaderMapPtr&& request_headers_to_add) override;
+
+private:
+  // Calls the service, or waits for the call in flight.
+  void callService();
+  // Called when the call the client waited for completes, or is cancelled.
+  void onCallComplete(absl::optional<LimitStatus> status);
+
+  ClientPtr client_;
+  QuotaLeaseCache& cache_;
+  const uint32_t hits_;
+  const std::chrono::milliseconds duration_;
+  std::string key_;
+  RequestCallbacks* callbacks_{};
+  // What the client calls the service with, kept while it waits for the call of another client in
+  // case that one is cancelled.
+  std::string domain_;
+  std::vector<Envoy::RateLimit::Descriptor> descriptors_;
+  Tracing::Span* parent_span_{};
+  bool waiting_{};
+};
+
+} // namespace RateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
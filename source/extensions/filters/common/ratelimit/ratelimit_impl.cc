@@ -19,10 +19,11 @@ namespace Common {
 namespace RateLimit {
 
 GrpcClientImpl::GrpcClientImpl(Grpc::RawAsyncClientPtr&& async_client,
-                               const absl::optional<std::chrono::milliseconds>& timeout)
+                               const absl::optional<std::chrono::milliseconds>& timeout,
+                               uint32_t hits_addend)
     : service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
           "envoy.service.ratelimit.v2.RateLimitService.ShouldRateLimit")),
-      async_client_(std::move(async_client)), timeout_(timeout) {}
+      async_client_(std::move(async_client)), timeout_(timeout), hits_addend_(hits_addend) {}
 
 GrpcClientImpl::~GrpcClientImpl() { ASSERT(!callbacks_); }
 
@@ -55,6 +56,7 @@ void GrpcClientImpl::limit(RequestCallbacks& callbacks, const std::string& domai
 
   envoy::service::ratelimit::v2::RateLimitRequest request;
   createRequest(request, domain, descriptors);
+  request.set_hits_addend(hits_addend_);
 
   request_ = async_client_->send(service_method_, request, *this, parent_span,
                                  Http::AsyncClient::RequestOptions().setTimeout(timeout_));
@@ -100,14 +102,14 @@ void GrpcClientImpl::onFailure(Grpc::Status::GrpcStatus status, const std::strin
 
 ClientPtr rateLimitClient(Server::Configuration::FactoryContext& context,
                           const envoy::api::v2::core::GrpcService& grpc_service,
-                          const std::chrono::milliseconds timeout) {
+                          const std::chrono::milliseconds timeout, uint32_t hits_addend) {
   // TODO(ramaraochavali): register client to singleton when GrpcClientImpl supports concurrent
   // requests.
   const auto async_client_factory =
       context.clusterManager().grpcAsyncClientManager().factoryForGrpcService(
           grpc_service, context.scope(), true);
   return std::make_unique<Filters::Common::RateLimit::GrpcClientImpl>(
-      async_client_factory->create(), timeout);
+      async_client_factory->create(), timeout, hits_addend);
 }
 
 } // namespace RateLimit
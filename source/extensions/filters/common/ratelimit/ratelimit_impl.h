@@ -46,7 +46,8 @@ class GrpcClientImpl : public Client,
                        public Logger::Loggable<Logger::Id::config> {
 public:
   GrpcClientImpl(Grpc::RawAsyncClientPtr&& async_client,
-                 const absl::optional<std::chrono::milliseconds>& timeout);
+                 const absl::optional<std::chrono::milliseconds>& timeout,
+                 uint32_t hits_addend = 0);
   ~GrpcClientImpl() override;
 
   static void createRequest(envoy::service::ratelimit::v2::RateLimitRequest& request,
@@ -73,15 +74,18 @@ private:
       async_client_;
   Grpc::AsyncRequest* request_{};
   absl::optional<std::chrono::milliseconds> timeout_;
+  // The number of hits each limit() call counts for, where 0 is the service's default of 1.
+  const uint32_t hits_addend_;
   RequestCallbacks* callbacks_{};
 };
 
 /**
  * Builds the rate limit client.
+ * @param hits_addend supplies the number of hits each limit() call counts for, or 0 for one.
  */
 ClientPtr rateLimitClient(Server::Configuration::FactoryContext& context,
                           const envoy::api::v2::core::GrpcService& grpc_service,
-                          const std::chrono::milliseconds timeout);
+                          const std::chrono::milliseconds timeout, uint32_t hits_addend = 0);
 
 } // namespace RateLimit
 } // namespace Common
@@ -20,9 +20,16 @@ RoleBasedAccessControlEngineImpl::RoleBasedAccessControlEngineImpl(
     }
   }
 
+  std::map<std::string, const envoy::config::rbac::v2::Policy*> sorted_policies;
   for (const auto& policy : rules.policies()) {
-    policies_.emplace(policy.first, std::make_unique<PolicyMatcher>(policy.second, builder_.get()));
+    sorted_policies.emplace(policy.first, &policy.second);
   }
+  for (const auto& policy : sorted_policies) {
+    index_.add(policies_.size(), *policy.second);
+    policies_.emplace_back(policy.first,
+                           std::make_unique<PolicyMatcher>(*policy.second, builder_.get()));
+  }
+  index_.compile();
 }
 
 bool RoleBasedAccessControlEngineImpl::allowed(const Network::Connection& connection,
@@ -31,7 +38,20 @@ bool RoleBasedAccessControlEngineImpl::allowed(const Network::Connection& connec
                                                std::string* effective_policy_id) const {
   bool matched = false;
 
-  for (const auto& policy : policies_) {
+  PolicyPositions candidates;
+  index_.candidates(connection, headers, candidates);
+  const std::vector<uint32_t>& unindexed = index_.unindexed();
+
+  // Both the indexed candidates and the unindexed policies are in order, so that the first policy
+  // which matches is the same as without the index.
+  auto candidate = candidates.begin();
+  auto other = unindexed.begin();
+  while (candidate != candidates.end() || other != unindexed.end()) {
+    const uint32_t position = other == unindexed.end() ||
+                                      (candidate != candidates.end() && *candidate < *other)
+                                  ? *candidate++
+                                  : *other++;
+    const auto& policy = policies_[position];
     if (policy.second->matches(connection, headers, info)) {
       matched = true;
       if (effective_policy_id != nullptr) {
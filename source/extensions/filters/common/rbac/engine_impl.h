@@ -4,6 +4,7 @@
 
 #include "extensions/filters/common/rbac/engine.h"
 #include "extensions/filters/common/rbac/matchers.h"
+#include "extensions/filters/common/rbac/policy_index.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -24,7 +25,10 @@ public:
 private:
   const bool allowed_if_matched_;
 
-  std::map<std::string, std::unique_ptr<PolicyMatcher>> policies_;
+  // The policies are evaluated in the order of their names, and the policy index narrows them down
+  // to the ones which may match a request.
+  std::vector<std::pair<std::string, std::unique_ptr<PolicyMatcher>>> policies_;
+  PolicyIndex index_;
 
   Protobuf::Arena constant_arena_;
   Expr::BuilderPtr builder_;
@@ -140,22 +140,21 @@ bool AuthenticatedMatcher::matches(const Network::Connection& connection,
     return true;
   }
 
-  const auto uriSans = ssl->uriSanPeerCertificate();
-  std::string principal;
+  return matcher_.value().match(principalName(*ssl));
+}
+
+std::string AuthenticatedMatcher::principalName(const Ssl::ConnectionInfo& ssl) {
   // If set, The URI SAN  or DNS SAN in that order is used as Principal, otherwise the subject field
   // is used.
+  const auto uriSans = ssl.uriSanPeerCertificate();
   if (!uriSans.empty()) {
-    principal = uriSans[0];
-  } else {
-    const auto dnsSans = ssl->dnsSansPeerCertificate();
-    if (!dnsSans.empty()) {
-      principal = dnsSans[0];
-    } else {
-      principal = ssl->subjectPeerCertificate();
-    }
+    return uriSans[0];
   }
-
-  return matcher_.value().match(principal);
+  const auto dnsSans = ssl.dnsSansPeerCertificate();
+  if (!dnsSans.empty()) {
+    return dnsSans[0];
+  }
+  return ssl.subjectPeerCertificate();
 }
 
 bool MetadataMatcher::matches(const Network::Connection&, const Envoy::Http::HeaderMap&,
@@ -168,7 +167,7 @@ bool PolicyMatcher::matches(const Network::Connection& connection,
                             const StreamInfo::StreamInfo& info) const {
   return permissions_.matches(connection, headers, info) &&
          principals_.matches(connection, headers, info) &&
-         (expr_ == nullptr ? true : Expr::matches(*expr_, info, headers));
+         (expr_ == nullptr ? true : expr_->matches(info, headers));
 }
 
 bool RequestedServerNameMatcher::matches(const Network::Connection& connection,
@@ -172,6 +172,11 @@ public:
   bool matches(const Network::Connection& connection, const Envoy::Http::HeaderMap& headers,
                const StreamInfo::StreamInfo&) const override;
 
+  /**
+   * @return the principal name of an authenticated connection.
+   */
+  static std::string principalName(const Ssl::ConnectionInfo& ssl);
+
 private:
   const absl::optional<Matchers::StringMatcherImpl> matcher_;
 };
@@ -184,10 +189,9 @@ private:
 class PolicyMatcher : public Matcher, NonCopyable {
 public:
   PolicyMatcher(const envoy::config::rbac::v2::Policy& policy, Expr::Builder* builder)
-      : permissions_(policy.permissions()), principals_(policy.principals()),
-        condition_(policy.condition()) {
+      : permissions_(policy.permissions()), principals_(policy.principals()) {
     if (policy.has_condition()) {
-      expr_ = Expr::createExpression(*builder, condition_);
+      expr_ = std::make_unique<Expr::CompiledExpression>(*builder, policy.condition());
     }
   }
 
@@ -198,8 +202,7 @@ private:
   const OrMatcher permissions_;
   const OrMatcher principals_;
 
-  const google::api::expr::v1alpha1::Expr condition_;
-  Expr::ExpressionPtr expr_;
+  Expr::CompiledExpressionPtr expr_;
 };
 
 class MetadataMatcher : public Matcher {
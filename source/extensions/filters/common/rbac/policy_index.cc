@@ -0,0 +1,278 @@
+#include "extensions/filters/common/rbac/policy_index.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+#include "extensions/filters/common/rbac/matchers.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+void PolicyIndex::add(uint32_t position, const envoy::config::rbac::v2::Policy& policy) {
+  ASSERT(policies_.empty() || policies_.back().position_ < position);
+  policies_.push_back({position, anyKeys(policy.permissions()), anyKeys(policy.principals())});
+}
+
+void PolicyIndex::compile() {
+  // A key shared by many policies, such as a method which all of them allow, narrows the policies
+  // down less than a key only a few of them have.
+  absl::flat_hash_map<std::string, uint32_t> key_policies;
+  for (const PendingPolicy& policy : policies_) {
+    for (const absl::optional<Keys>* keys : {&policy.permission_keys_, &policy.principal_keys_}) {
+      if (keys->has_value()) {
+        for (const Key& key : keys->value()) {
+          key_policies[keyId(key)]++;
+        }
+      }
+    }
+  }
+  const auto cost = [&key_policies](const absl::optional<Keys>& keys) {
+    uint64_t policies = 0;
+    for (const Key& key : keys.value()) {
+      policies += key_policies[keyId(key)];
+    }
+    return policies;
+  };
+
+  std::vector<std::pair<uint32_t, std::vector<Network::Address::CidrRange>>> destination_ranges;
+  std::vector<std::pair<uint32_t, std::vector<Network::Address::CidrRange>>> source_ranges;
+  for (const PendingPolicy& policy : policies_) {
+    const absl::optional<Keys>* keys = &policy.permission_keys_;
+    if (policy.principal_keys_.has_value() &&
+        (!keys->has_value() || cost(policy.principal_keys_) < cost(*keys))) {
+      keys = &policy.principal_keys_;
+    }
+    if (!keys->has_value()) {
+      unindexed_.push_back(policy.position_);
+      continue;
+    }
+
+    for (const Key& key : keys->value()) {
+      switch (key.type_) {
+      case KeyType::Header: {
+        auto it = std::find_if(headers_.begin(), headers_.end(), [&key](const auto& header) {
+          return header.first.get() == key.name_;
+        });
+        if (it == headers_.end()) {
+          headers_.emplace_back(Envoy::Http::LowerCaseString(key.name_),
+                                absl::flat_hash_map<std::string, Positions>());
+          it = std::prev(headers_.end());
+        }
+        addPosition(it->second[key.value_], policy.position_);
+        break;
+      }
+      case KeyType::RequestedServerName:
+        addPosition(server_names_[key.value_], policy.position_);
+        break;
+      case KeyType::Principal:
+        addPosition(principals_[key.value_], policy.position_);
+        break;
+      case KeyType::DestinationPort:
+        addPosition(ports_[key.port_], policy.position_);
+        break;
+      case KeyType::DestinationIp:
+        destination_ranges.push_back({policy.position_, {key.range_}});
+        break;
+      case KeyType::SourceIp:
+        source_ranges.push_back({policy.position_, {key.range_}});
+        break;
+      }
+    }
+  }
+  policies_.clear();
+
+  if (!destination_ranges.empty()) {
+    destination_ips_ = std::make_unique<IpTrie>(destination_ranges);
+  }
+  if (!source_ranges.empty()) {
+    source_ips_ = std::make_unique<IpTrie>(source_ranges);
+  }
+}
+
+void PolicyIndex::candidates(const Network::Connection& connection,
+                             const Envoy::Http::HeaderMap& headers,
+                             PolicyPositions& positions) const {
+  for (const auto& header : headers_) {
+    const Envoy::Http::HeaderEntry* entry = headers.get(header.first);
+    if (entry != nullptr) {
+      auto it = header.second.find(entry->value().getStringView());
+      if (it != header.second.end()) {
+        positions.insert(positions.end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+  if (!server_names_.empty()) {
+    lookup(server_names_, connection.requestedServerName(), positions);
+  }
+  if (!principals_.empty() && connection.ssl() != nullptr) {
+    lookup(principals_, AuthenticatedMatcher::principalName(*connection.ssl()), positions);
+  }
+  if (!ports_.empty()) {
+    const Network::Address::Ip* ip = connection.localAddress()->ip();
+    if (ip != nullptr) {
+      auto it = ports_.find(ip->port());
+      if (it != ports_.end()) {
+        positions.insert(positions.end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+  if (destination_ips_ != nullptr) {
+    lookup(*destination_ips_, connection.localAddress(), positions);
+  }
+  if (source_ips_ != nullptr) {
+    lookup(*source_ips_, connection.remoteAddress(), positions);
+  }
+
+  // A policy may match a request by several keys.
+  std::sort(positions.begin(), positions.end());
+  positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+}
+
+absl::optional<PolicyIndex::Keys>
+PolicyIndex::keys(const envoy::config::rbac::v2::Permission& permission) {
+  switch (permission.rule_case()) {
+  case envoy::config::rbac::v2::Permission::RuleCase::kAndRules:
+    return allKeys(permission.and_rules().rules());
+  case envoy::config::rbac::v2::Permission::RuleCase::kOrRules:
+    return anyKeys(permission.or_rules().rules());
+  case envoy::config::rbac::v2::Permission::RuleCase::kHeader:
+    return headerKeys(permission.header());
+  case envoy::config::rbac::v2::Permission::RuleCase::kDestinationIp:
+    return ipKeys(KeyType::DestinationIp, permission.destination_ip());
+  case envoy::config::rbac::v2::Permission::RuleCase::kDestinationPort: {
+    Key key{KeyType::DestinationPort};
+    key.port_ = permission.destination_port();
+    return Keys{key};
+  }
+  case envoy::config::rbac::v2::Permission::RuleCase::kRequestedServerName:
+    return stringKeys(KeyType::RequestedServerName, permission.requested_server_name());
+  default:
+    return absl::nullopt;
+  }
+}
+
+absl::optional<PolicyIndex::Keys>
+PolicyIndex::keys(const envoy::config::rbac::v2::Principal& principal) {
+  switch (principal.identifier_case()) {
+  case envoy::config::rbac::v2::Principal::IdentifierCase::kAndIds:
+    return allKeys(principal.and_ids().ids());
+  case envoy::config::rbac::v2::Principal::IdentifierCase::kOrIds:
+    return anyKeys(principal.or_ids().ids());
+  case envoy::config::rbac::v2::Principal::IdentifierCase::kAuthenticated:
+    // Any authenticated principal matches when there is no principal name.
+    if (!principal.authenticated().has_principal_name()) {
+      return absl::nullopt;
+    }
+    return stringKeys(KeyType::Principal, principal.authenticated().principal_name());
+  case envoy::config::rbac::v2::Principal::IdentifierCase::kSourceIp:
+    return ipKeys(KeyType::SourceIp, principal.source_ip());
+  case envoy::config::rbac::v2::Principal::IdentifierCase::kHeader:
+    return headerKeys(principal.header());
+  default:
+    return absl::nullopt;
+  }
+}
+
+template <class T>
+absl::optional<PolicyIndex::Keys> PolicyIndex::anyKeys(const Protobuf::RepeatedPtrField<T>& ids) {
+  // Every alternative has to be indexable, otherwise a request matching none of the keys may still
+  // match.
+  Keys any_keys;
+  for (const auto& id : ids) {
+    absl::optional<Keys> id_keys = keys(id);
+    if (!id_keys.has_value()) {
+      return absl::nullopt;
+    }
+    std::move(id_keys->begin(), id_keys->end(), std::back_inserter(any_keys));
+  }
+  return any_keys;
+}
+
+template <class T>
+absl::optional<PolicyIndex::Keys> PolicyIndex::allKeys(const Protobuf::RepeatedPtrField<T>& ids) {
+  // The keys of any one of the conjuncts have to match.
+  absl::optional<Keys> all_keys;
+  for (const auto& id : ids) {
+    absl::optional<Keys> id_keys = keys(id);
+    if (id_keys.has_value() && (!all_keys.has_value() || id_keys->size() < all_keys->size())) {
+      all_keys.swap(id_keys);
+    }
+  }
+  return all_keys;
+}
+
+absl::optional<PolicyIndex::Keys>
+PolicyIndex::headerKeys(const envoy::api::v2::route::HeaderMatcher& header) {
+  // An empty exact match value matches any value.
+  if (header.header_match_specifier_case() !=
+          envoy::api::v2::route::HeaderMatcher::kExactMatch ||
+      header.exact_match().empty() || header.invert_match()) {
+    return absl::nullopt;
+  }
+  Key key{KeyType::Header};
+  key.name_ = Envoy::Http::LowerCaseString(header.name()).get();
+  key.value_ = header.exact_match();
+  return Keys{key};
+}
+
+absl::optional<PolicyIndex::Keys>
+PolicyIndex::stringKeys(KeyType type, const envoy::type::matcher::StringMatcher& matcher) {
+  if (matcher.match_pattern_case() != envoy::type::matcher::StringMatcher::kExact) {
+    return absl::nullopt;
+  }
+  Key key{type};
+  key.value_ = matcher.exact();
+  return Keys{key};
+}
+
+absl::optional<PolicyIndex::Keys>
+PolicyIndex::ipKeys(KeyType type, const envoy::api::v2::core::CidrRange& range) {
+  Key key{type};
+  key.range_ = Network::Address::CidrRange::create(range);
+  // An invalid range matches nothing, which is left to the matcher.
+  if (!key.range_.isValid()) {
+    return absl::nullopt;
+  }
+  return Keys{key};
+}
+
+std::string PolicyIndex::keyId(const Key& key) {
+  return absl::StrCat(static_cast<int>(key.type_), "\n", key.name_, "\n", key.value_, "\n",
+                      key.port_, "\n", key.range_.asString());
+}
+
+void PolicyIndex::addPosition(Positions& positions, uint32_t position) {
+  // A policy may have the same key more than once.
+  if (positions.empty() || positions.back() != position) {
+    positions.push_back(position);
+  }
+}
+
+void PolicyIndex::lookup(const absl::flat_hash_map<std::string, Positions>& map,
+                         absl::string_view value, PolicyPositions& positions) {
+  auto it = map.find(value);
+  if (it != map.end()) {
+    positions.insert(positions.end(), it->second.begin(), it->second.end());
+  }
+}
+
+void PolicyIndex::lookup(const IpTrie& trie,
+                         const Network::Address::InstanceConstSharedPtr& address,
+                         PolicyPositions& positions) {
+  if (address->type() != Network::Address::Type::Ip) {
+    return;
+  }
+  trie.getData(*address, positions);
+}
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/config/rbac/v2/rbac.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/network/connection.h"
+
+#include "common/network/cidr_range.h"
+#include "common/network/lc_trie.h"
+#include "common/protobuf/protobuf.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+using PolicyPositions = absl::InlinedVector<uint32_t, 16>;
+
+/**
+ * An index over the leaf matchers of a set of policies which a request has to match for a policy
+ * to match it: exact header values, exact requested server names, exact authenticated principals,
+ * destination ports and source or destination IP ranges. A policy is indexed by the leaves of
+ * either its permissions or its principals, when every one of them has such a leaf, picking the
+ * side whose leaves are shared by fewer policies. The index narrows the policies which have to be
+ * evaluated for a request down to the indexed policies whose leaves match it, and the policies
+ * which can not be indexed.
+ */
+class PolicyIndex {
+public:
+  /**
+   * Adds a policy to be indexed.
+   * @param position supplies the position of the policy, which is reported for candidate requests.
+   *                 Policies must be added by increasing position.
+   * @param policy supplies the policy config.
+   */
+  void add(uint32_t position, const envoy::config::rbac::v2::Policy& policy);
+
+  /**
+   * Builds the index once all the policies are added.
+   */
+  void compile();
+
+  /**
+   * Finds the indexed policies whose leaves match a request.
+   * @param connection supplies the downstream connection.
+   * @param headers supplies the request headers.
+   * @param positions is filled with the positions of the matching policies, in increasing order.
+   */
+  void candidates(const Network::Connection& connection, const Envoy::Http::HeaderMap& headers,
+                  PolicyPositions& positions) const;
+
+  /**
+   * @return the positions of the policies which could not be indexed and are always candidates,
+   *         in increasing order.
+   */
+  const std::vector<uint32_t>& unindexed() const { return unindexed_; }
+
+private:
+  enum class KeyType {
+    Header,
+    RequestedServerName,
+    Principal,
+    DestinationPort,
+    DestinationIp,
+    SourceIp
+  };
+
+  // A leaf a request has to match.
+  struct Key {
+    KeyType type_;
+    // The header name, for headers.
+    std::string name_;
+    // The header value, requested server name or principal.
+    std::string value_;
+    uint32_t port_{};
+    Network::Address::CidrRange range_;
+  };
+
+  using Keys = std::vector<Key>;
+  using Positions = std::vector<uint32_t>;
+  using IpTrie = Network::LcTrie::LcTrie<uint32_t>;
+
+  // A policy which was added, and the keys of its permissions and principals.
+  struct PendingPolicy {
+    uint32_t position_;
+    absl::optional<Keys> permission_keys_;
+    absl::optional<Keys> principal_keys_;
+  };
+
+  // The keys of which a request has to match at least one to match the permission or principal,
+  // or nullopt if there are none.
+  static absl::optional<Keys> keys(const envoy::config::rbac::v2::Permission& permission);
+  static absl::optional<Keys> keys(const envoy::config::rbac::v2::Principal& principal);
+  template <class T> static absl::optional<Keys> anyKeys(const Protobuf::RepeatedPtrField<T>& ids);
+  template <class T> static absl::optional<Keys> allKeys(const Protobuf::RepeatedPtrField<T>& ids);
+  static absl::optional<Keys> headerKeys(const envoy::api::v2::route::HeaderMatcher& header);
+  static absl::optional<Keys> stringKeys(KeyType type,
+                                         const envoy::type::matcher::StringMatcher& matcher);
+  static absl::optional<Keys> ipKeys(KeyType type, const envoy::api::v2::core::CidrRange& range);
+
+  // Identifies equal keys.
+  static std::string keyId(const Key& key);
+  static void addPosition(Positions& positions, uint32_t position);
+  static void lookup(const absl::flat_hash_map<std::string, Positions>& map,
+                     absl::string_view value, PolicyPositions& positions);
+  static void lookup(const IpTrie& trie, const Network::Address::InstanceConstSharedPtr& address,
+                     PolicyPositions& positions);
+
+  std::vector<PendingPolicy> policies_;
+  std::vector<std::pair<Envoy::Http::LowerCaseString, absl::flat_hash_map<std::string, Positions>>>
+      headers_;
+  absl::flat_hash_map<std::string, Positions> server_names_;
+  absl::flat_hash_map<std::string, Positions> principals_;
+  absl::flat_hash_map<uint32_t, Positions> ports_;
+  std::unique_ptr<IpTrie> destination_ips_;
+  std::unique_ptr<IpTrie> source_ips_;
+  std::vector<uint32_t> unindexed_;
+};
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,329 @@
+#include "extensions/filters/http/cache/cache_filter.h"
+
+#include "envoy/http/codes.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/enum_to_int.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/filters/http/cache/cache_utility.h"
+#include "extensions/filters/http/cache/file_http_cache.h"
+#include "extensions/filters/http/cache/in_memory_http_cache.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+namespace {
+
+// Default maximum bytes of the responses in memory.
+const uint64_t DefaultInMemoryMaxBytes = 64 * 1024 * 1024;
+
+// Default number of shards of the responses in memory.
+const uint32_t DefaultInMemoryShards = 16;
+
+// Default size of the file of responses.
+const uint64_t DefaultFileMaxBytes = 64 * 1024 * 1024;
+
+// Default maximum size of a cached body.
+const uint64_t DefaultMaxBodyBytes = 1024 * 1024;
+
+// References the body of a cached response from a buffer without copying it. The response
+// outlives its eviction from the cache for as long as the buffer references it.
+class CachedBodyFragment : public Buffer::BufferFragment {
+public:
+  CachedBodyFragment(const CachedResponseSharedPtr& response) : response_(response) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return response_->body().data(); }
+  size_t size() const override { return response_->body().size(); }
+  void done() override { delete this; }
+
+private:
+  const CachedResponseSharedPtr response_;
+};
+
+// Replaces the headers of a map by those of another map which have the same name, and adds the
+// others.
+void overwriteHeaders(Http::HeaderMap& headers, const Http::HeaderMap& source) {
+  source.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+        static_cast<Http::HeaderMap*>(context)->remove(
+            Http::LowerCaseString(std::string(header.key().getStringView())));
+        return Http::HeaderMap::Iterate::Continue;
+      },
+      &headers);
+  source.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+        static_cast<Http::HeaderMap*>(context)->addCopy(
+            Http::LowerCaseString(std::string(header.key().getStringView())),
+            std::string(header.value().getStringView()));
+        return Http::HeaderMap::Iterate::Continue;
+      },
+      &headers);
+}
+
+void setAge(Http::HeaderMap& headers, const CachedResponse& response, SystemTime now) {
+  headers.remove(CacheHeaders::get().Age);
+  headers.addCopy(CacheHeaders::get().Age, Utility::age(response, now).count());
+}
+
+} // namespace
+
+CacheFilterConfig::CacheFilterConfig(
+    const envoy::config::filter::http::cache::v2alpha::Cache& cache,
+    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source,
+    ThreadLocal::SlotAllocator& tls)
+    : CacheFilterConfig(cache, createStore(cache), stats_prefix, scope, time_source, tls) {}
+
+CacheFilterConfig::CacheFilterConfig(
+    const envoy::config::filter::http::cache::v2alpha::Cache& cache, HttpCacheSharedPtr store,
+    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source,
+    ThreadLocal::SlotAllocator& tls)
+    : store_(std::move(store)), stats_(generateStats(stats_prefix + "cache.", scope)),
+      time_source_(time_source),
+      max_body_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache, max_body_bytes, DefaultMaxBodyBytes)) {
+  if (PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache, coalesce_requests, true)) {
+    inflight_slot_ = tls.allocateSlot();
+    inflight_slot_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return std::make_shared<InflightRequests>();
+    });
+  }
+}
+
+HttpCacheSharedPtr
+CacheFilterConfig::createStore(const envoy::config::filter::http::cache::v2alpha::Cache& cache) {
+  switch (cache.store_case()) {
+  case envoy::config::filter::http::cache::v2alpha::Cache::kInMemory:
+    return std::make_shared<InMemoryHttpCache>(
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache.in_memory(), max_bytes, DefaultInMemoryMaxBytes),
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache.in_memory(), shards, DefaultInMemoryShards));
+  case envoy::config::filter::http::cache::v2alpha::Cache::kFile:
+    return std::make_shared<FileHttpCache>(
+        cache.file().path(),
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache.file(), max_bytes, DefaultFileMaxBytes));
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+void CacheFilter::onDestroy() {
+  if (waiting_) {
+    waiting_ = false;
+    auto& waiters = config_->inflightRequests().waiters_;
+    auto it = waiters.find(key_);
+    if (it != waiters.end()) {
+      it->second.remove(this);
+    }
+  }
+  completeFetch(nullptr);
+}
+
+Http::FilterHeadersStatus CacheFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  // Only GET requests without a body are cached.
+  if (!end_stream || headers.Method() == nullptr || headers.Host() == nullptr ||
+      headers.Path() == nullptr ||
+      headers.Method()->value().getStringView() != Http::Headers::get().MethodValues.Get) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  const Utility::RequestCacheControl cache_control = Utility::requestCacheControl(headers);
+  // A shared cache must not serve responses to authorized requests to others (RFC7234-3.2).
+  if (cache_control.no_store_ || headers.Authorization() != nullptr) {
+    config_->stats().bypass_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  request_headers_ = &headers;
+  key_ = absl::StrCat(headers.Host()->value().getStringView(),
+                      headers.Path()->value().getStringView());
+  const CachedResponseSharedPtr cached = config_->store().lookup(key_, headers);
+  if (cached != nullptr) {
+    if (!cache_control.must_validate_ &&
+        Utility::isFresh(*cached, config_->timeSource().systemTime())) {
+      config_->stats().hit_.inc();
+      serve(cached);
+      return Http::FilterHeadersStatus::StopIteration;
+    }
+    // The client's own conditional requests are passed through as they are.
+    if (Utility::hasValidators(*cached->headers_) &&
+        headers.get(CacheHeaders::get().IfNoneMatch) == nullptr &&
+        headers.get(CacheHeaders::get().IfModifiedSince) == nullptr) {
+      validating_ = cached;
+      if (cached->headers_->Etag() != nullptr) {
+        headers.addCopy(CacheHeaders::get().IfNoneMatch,
+                        std::string(cached->headers_->Etag()->value().getStringView()));
+      }
+      if (cached->headers_->LastModified() != nullptr) {
+        headers.addCopy(CacheHeaders::get().IfModifiedSince,
+                        std::string(cached->headers_->LastModified()->value().getStringView()));
+      }
+    }
+  }
+  config_->stats().miss_.inc();
+
+  if (config_->coalesceRequests()) {
+    auto& waiters = config_->inflightRequests().waiters_;
+    auto it = waiters.find(key_);
+    if (it != waiters.end()) {
+      config_->stats().coalesced_.inc();
+      it->second.push_back(this);
+      waiting_ = true;
+      return Http::FilterHeadersStatus::StopIteration;
+    }
+    waiters.emplace(key_, std::list<CacheFilter*>());
+    fetching_ = true;
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  if (request_headers_ == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  if (validating_ != nullptr && Http::Utility::getResponseStatus(headers) ==
+                                    enumToInt(Http::Code::NotModified)) {
+    serveValidated(headers, end_stream);
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  if (Utility::isCacheableResponse(headers)) {
+    response_ = std::make_shared<CachedResponse>();
+    response_->headers_ = std::make_unique<Http::HeaderMapImpl>(headers);
+    response_->vary_key_ = Utility::varyKey(headers, *request_headers_);
+    response_->response_time_ = config_->timeSource().systemTime();
+    if (end_stream) {
+      insert();
+    }
+  } else {
+    completeFetch(nullptr);
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (validated_ != nullptr) {
+    // A 304 response has no body of its own.
+    data.drain(data.length());
+    if (end_stream) {
+      data.addBufferFragment(*new CachedBodyFragment(validated_));
+    }
+    return Http::FilterDataStatus::Continue;
+  }
+
+  if (response_ != nullptr) {
+    if (response_->body_.size() + data.length() > config_->maxBodyBytes()) {
+      response_ = nullptr;
+      completeFetch(nullptr);
+      return Http::FilterDataStatus::Continue;
+    }
+    const uint64_t offset = response_->body_.size();
+    response_->body_.resize(offset + data.length());
+    data.copyOut(0, data.length(), &response_->body_[offset]);
+    if (end_stream) {
+      insert();
+    }
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterTrailersStatus CacheFilter::encodeTrailers(Http::HeaderMap&) {
+  // Trailers are not cached, so neither are the responses which have them.
+  if (response_ != nullptr) {
+    response_ = nullptr;
+    completeFetch(nullptr);
+  }
+  return Http::FilterTrailersStatus::Continue;
+}
+
+void CacheFilter::serve(const CachedResponseSharedPtr& response) {
+  auto headers = std::make_unique<Http::HeaderMapImpl>(*response->headers_);
+  setAge(*headers, *response, config_->timeSource().systemTime());
+  config_->stats().bytes_served_.add(response->body().size());
+  if (response->body().empty()) {
+    decoder_callbacks_->encodeHeaders(std::move(headers), true);
+    return;
+  }
+  decoder_callbacks_->encodeHeaders(std::move(headers), false);
+  Buffer::OwnedImpl body;
+  body.addBufferFragment(*new CachedBodyFragment(response));
+  decoder_callbacks_->encodeData(body, true);
+}
+
+void CacheFilter::serveValidated(Http::HeaderMap& headers, bool end_stream) {
+  config_->stats().validated_.inc();
+  // The cached response is freshened with the headers of the 304 response (RFC7234-4.3.4).
+  auto response = std::make_shared<CachedResponse>();
+  response->headers_ = std::make_unique<Http::HeaderMapImpl>(*validating_->headers_);
+  headers.remove(Http::Headers::get().Status);
+  headers.removeContentLength();
+  overwriteHeaders(*response->headers_, headers);
+  // The cookies of the 304 response are only passed on to this request.
+  response->headers_->remove(Http::Headers::get().SetCookie);
+  // The body is shared with the stale response rather than copied.
+  response->body_view_ = validating_->body();
+  response->body_owner_ = validating_;
+  response->vary_key_ = validating_->vary_key_;
+  response->response_time_ = config_->timeSource().systemTime();
+  config_->store().insert(key_, response);
+  config_->stats().insert_.inc();
+
+  overwriteHeaders(headers, *response->headers_);
+  setAge(headers, *response, response->response_time_);
+  config_->stats().bytes_served_.add(response->body().size());
+  if (!response->body().empty()) {
+    if (end_stream) {
+      Buffer::OwnedImpl body;
+      body.addBufferFragment(*new CachedBodyFragment(response));
+      encoder_callbacks_->addEncodedData(body, false);
+    } else {
+      validated_ = response;
+    }
+  }
+  completeFetch(response);
+}
+
+void CacheFilter::insert() {
+  config_->store().insert(key_, response_);
+  config_->stats().insert_.inc();
+  const CachedResponseSharedPtr response = std::move(response_);
+  completeFetch(response);
+}
+
+void CacheFilter::completeFetch(const CachedResponseSharedPtr& response) {
+  if (!fetching_) {
+    return;
+  }
+  fetching_ = false;
+  // The waiting requests are detached first, since they may complete and be destroyed here.
+  auto& waiters = config_->inflightRequests().waiters_;
+  auto it = waiters.find(key_);
+  ASSERT(it != waiters.end());
+  std::list<CacheFilter*> requests = std::move(it->second);
+  waiters.erase(it);
+  for (CacheFilter* request : requests) {
+    request->onFetchComplete(response);
+  }
+}
+
+void CacheFilter::onFetchComplete(const CachedResponseSharedPtr& response) {
+  waiting_ = false;
+  if (response != nullptr && Utility::varyMatches(*response, *request_headers_) &&
+      Utility::isFresh(*response, config_->timeSource().systemTime())) {
+    serve(response);
+  } else {
+    decoder_callbacks_->continueDecoding();
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
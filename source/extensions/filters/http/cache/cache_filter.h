@@ -0,0 +1,150 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/cache/v2alpha/cache.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "extensions/filters/http/cache/http_cache.h"
+#include "extensions/filters/http/common/pass_through_filter.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All cache filter stats. @see stats_macros.h
+ * "hit" and "miss" count the cacheable requests, so the hit
+ * ratio is hit / (hit + miss). Requests which are coalesced
+ * or revalidated count as misses. "bytes_served" counts the
+ * body bytes served from the cache.
+ */
+// clang-format off
+#define ALL_CACHE_STATS(COUNTER) \
+  COUNTER(hit)                   \
+  COUNTER(miss)                  \
+  COUNTER(validated)             \
+  COUNTER(coalesced)             \
+  COUNTER(insert)                \
+  COUNTER(bypass)                \
+  COUNTER(bytes_served)          \
+// clang-format on
+
+/**
+ * Struct definition for cache stats. @see stats_macros.h
+ */
+struct CacheStats {
+  ALL_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+class CacheFilter;
+
+/**
+ * The requests of a worker which wait for another request for the same key to fetch the response
+ * from the upstream.
+ */
+struct InflightRequests : public ThreadLocal::ThreadLocalObject {
+  // The requests waiting for each key. A key is present while a request fetches it.
+  absl::flat_hash_map<std::string, std::list<CacheFilter*>> waiters_;
+};
+
+/**
+ * Configuration for the cache filter.
+ */
+class CacheFilterConfig {
+public:
+  CacheFilterConfig(const envoy::config::filter::http::cache::v2alpha::Cache& cache,
+                    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source,
+                    ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * Uses the given store rather than the one of the configuration.
+   */
+  CacheFilterConfig(const envoy::config::filter::http::cache::v2alpha::Cache& cache,
+                    HttpCacheSharedPtr store, const std::string& stats_prefix, Stats::Scope& scope,
+                    TimeSource& time_source, ThreadLocal::SlotAllocator& tls);
+
+  HttpCache& store() { return *store_; }
+  CacheStats& stats() { return stats_; }
+  TimeSource& timeSource() { return time_source_; }
+  uint64_t maxBodyBytes() const { return max_body_bytes_; }
+  bool coalesceRequests() const { return inflight_slot_ != nullptr; }
+  InflightRequests& inflightRequests() { return inflight_slot_->getTyped<InflightRequests>(); }
+
+private:
+  static HttpCacheSharedPtr
+  createStore(const envoy::config::filter::http::cache::v2alpha::Cache& cache);
+
+  static CacheStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return CacheStats{ALL_CACHE_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  const HttpCacheSharedPtr store_;
+  CacheStats stats_;
+  TimeSource& time_source_;
+  const uint64_t max_body_bytes_;
+  ThreadLocal::SlotPtr inflight_slot_;
+};
+using CacheFilterConfigSharedPtr = std::shared_ptr<CacheFilterConfig>;
+
+/**
+ * A filter which serves GET requests from a cache of responses, following the caching rules of
+ * RFC7234 for shared caches. Stale responses with validators are revalidated with a conditional
+ * request, and concurrent requests for a response which is not cached wait for the first of them
+ * to fetch it.
+ */
+class CacheFilter : public Http::PassThroughFilter {
+public:
+  CacheFilter(const CacheFilterConfigSharedPtr& config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap& trailers) override;
+
+private:
+  // Sends a cached response to the client.
+  void serve(const CachedResponseSharedPtr& response);
+  // Replaces a 304 response to a conditional request by the cached response it validated.
+  void serveValidated(Http::HeaderMap& headers, bool end_stream);
+  void insert();
+  // Hands the fetched response, or nullptr if it was not cached, to the waiting requests.
+  void completeFetch(const CachedResponseSharedPtr& response);
+  // Called on a waiting request when the response has been fetched.
+  void onFetchComplete(const CachedResponseSharedPtr& response);
+
+  CacheFilterConfigSharedPtr config_;
+  // The request headers of cacheable requests.
+  const Http::HeaderMap* request_headers_{};
+  std::string key_;
+  // The cached response which is being revalidated with a conditional request.
+  CachedResponseSharedPtr validating_;
+  // The response which is being stored, while its body is received.
+  std::shared_ptr<CachedResponse> response_;
+  // The body of the cached response which replaces the body of a 304 response.
+  CachedResponseSharedPtr validated_;
+  // Whether this request fetches the response for the requests waiting for it.
+  bool fetching_{};
+  // Whether this request waits for another request to fetch the response.
+  bool waiting_{};
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,233 @@
+#include "extensions/filters/http/cache/cache_utility.h"
+
+#include <algorithm>
+
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace Utility {
+
+namespace {
+
+// The cache-control directives of a response which the cache uses.
+struct ResponseCacheControl {
+  bool no_store_{};
+  bool no_cache_{};
+  bool private_{};
+  absl::optional<std::chrono::seconds> max_age_;
+  absl::optional<std::chrono::seconds> s_maxage_;
+};
+
+// Returns the delta-seconds argument of a directive such as "max-age=60", or nothing if it is
+// malformed.
+absl::optional<std::chrono::seconds> deltaSeconds(absl::string_view directive) {
+  uint64_t seconds;
+  if (directive.find('=') == absl::string_view::npos ||
+      !absl::SimpleAtoi(StringUtil::trim(StringUtil::cropLeft(directive, "=")), &seconds)) {
+    return absl::nullopt;
+  }
+  return std::chrono::seconds(seconds);
+}
+
+absl::string_view directiveName(absl::string_view directive) {
+  return StringUtil::trim(StringUtil::cropRight(directive, "="));
+}
+
+ResponseCacheControl responseCacheControl(const Http::HeaderMap& headers) {
+  ResponseCacheControl cache_control;
+  const Http::HeaderEntry* header = headers.CacheControl();
+  if (header == nullptr) {
+    return cache_control;
+  }
+  for (const absl::string_view directive :
+       StringUtil::splitToken(header->value().getStringView(), ",")) {
+    const absl::string_view name = directiveName(directive);
+    if (StringUtil::caseCompare(name, CacheHeaders::get().NoStore)) {
+      cache_control.no_store_ = true;
+    } else if (StringUtil::caseCompare(name, CacheHeaders::get().NoCache)) {
+      cache_control.no_cache_ = true;
+    } else if (StringUtil::caseCompare(name, CacheHeaders::get().Private)) {
+      cache_control.private_ = true;
+    } else if (StringUtil::caseCompare(name, CacheHeaders::get().MaxAge)) {
+      cache_control.max_age_ = deltaSeconds(directive);
+    } else if (StringUtil::caseCompare(name, CacheHeaders::get().SMaxAge)) {
+      cache_control.s_maxage_ = deltaSeconds(directive);
+    }
+  }
+  return cache_control;
+}
+
+// Returns how long a response is fresh for after it was generated (RFC7234-4.2.1), or nothing if
+// the response does not say.
+absl::optional<std::chrono::seconds> freshnessLifetime(const Http::HeaderMap& headers,
+                                                       const ResponseCacheControl& cache_control,
+                                                       SystemTime response_time) {
+  // A shared cache prefers s-maxage.
+  if (cache_control.s_maxage_.has_value()) {
+    return cache_control.s_maxage_;
+  }
+  if (cache_control.max_age_.has_value()) {
+    return cache_control.max_age_;
+  }
+  const Http::HeaderEntry* expires_header = headers.get(CacheHeaders::get().Expires);
+  if (expires_header == nullptr) {
+    return absl::nullopt;
+  }
+  // An invalid date, such as "0", means the response has already expired.
+  const absl::optional<SystemTime> expires =
+      parseHttpDate(expires_header->value().getStringView());
+  absl::optional<SystemTime> date;
+  if (headers.Date() != nullptr) {
+    date = parseHttpDate(headers.Date()->value().getStringView());
+  }
+  if (!expires.has_value() || expires.value() <= date.value_or(response_time)) {
+    return std::chrono::seconds(0);
+  }
+  return std::chrono::duration_cast<std::chrono::seconds>(expires.value() -
+                                                          date.value_or(response_time));
+}
+
+bool isCacheableStatus(uint64_t status) {
+  // The status codes which are cacheable by default (RFC7231-6.1).
+  switch (status) {
+  case 200:
+  case 203:
+  case 204:
+  case 300:
+  case 301:
+  case 404:
+  case 405:
+  case 410:
+  case 414:
+  case 501:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+RequestCacheControl requestCacheControl(const Http::HeaderMap& headers) {
+  RequestCacheControl cache_control;
+  const Http::HeaderEntry* header = headers.CacheControl();
+  if (header != nullptr) {
+    for (const absl::string_view directive :
+         StringUtil::splitToken(header->value().getStringView(), ",")) {
+      const absl::string_view name = directiveName(directive);
+      if (StringUtil::caseCompare(name, CacheHeaders::get().NoStore)) {
+        cache_control.no_store_ = true;
+      } else if (StringUtil::caseCompare(name, CacheHeaders::get().NoCache)) {
+        cache_control.must_validate_ = true;
+      } else if (StringUtil::caseCompare(name, CacheHeaders::get().MaxAge)) {
+        const absl::optional<std::chrono::seconds> max_age = deltaSeconds(directive);
+        cache_control.must_validate_ |= max_age.has_value() && max_age.value().count() == 0;
+      }
+    }
+  } else {
+    // Pragma is only used when there is no cache-control header (RFC7234-5.4).
+    const Http::HeaderEntry* pragma = headers.get(CacheHeaders::get().Pragma);
+    cache_control.must_validate_ =
+        pragma != nullptr && StringUtil::caseFindToken(pragma->value().getStringView(), ",",
+                                                       CacheHeaders::get().NoCache);
+  }
+  return cache_control;
+}
+
+bool isCacheableResponse(const Http::HeaderMap& headers) {
+  if (!isCacheableStatus(Http::Utility::getResponseStatus(headers))) {
+    return false;
+  }
+  const ResponseCacheControl cache_control = responseCacheControl(headers);
+  if (cache_control.no_store_ || cache_control.private_) {
+    return false;
+  }
+  // A cookie set for one client must not be replayed to the others.
+  if (headers.get(Http::Headers::get().SetCookie) != nullptr) {
+    return false;
+  }
+  if (headers.Vary() != nullptr &&
+      StringUtil::findToken(headers.Vary()->value().getStringView(), ",",
+                            CacheHeaders::get().VaryWildcard)) {
+    return false;
+  }
+  return cache_control.s_maxage_.has_value() || cache_control.max_age_.has_value() ||
+         headers.get(CacheHeaders::get().Expires) != nullptr || hasValidators(headers);
+}
+
+bool hasValidators(const Http::HeaderMap& headers) {
+  return headers.Etag() != nullptr || headers.LastModified() != nullptr;
+}
+
+bool isFresh(const CachedResponse& response, SystemTime now) {
+  const ResponseCacheControl cache_control = responseCacheControl(*response.headers_);
+  if (cache_control.no_cache_) {
+    return false;
+  }
+  const absl::optional<std::chrono::seconds> lifetime =
+      freshnessLifetime(*response.headers_, cache_control, response.response_time_);
+  return lifetime.has_value() && age(response, now) < lifetime.value();
+}
+
+std::chrono::seconds age(const CachedResponse& response, SystemTime now) {
+  uint64_t initial_age = 0;
+  const Http::HeaderEntry* age_header = response.headers_->get(CacheHeaders::get().Age);
+  if (age_header != nullptr) {
+    // A malformed age counts as zero.
+    absl::SimpleAtoi(age_header->value().getStringView(), &initial_age);
+  }
+  const auto resident_time =
+      std::chrono::duration_cast<std::chrono::seconds>(now - response.response_time_);
+  return std::chrono::seconds(initial_age) + std::max(resident_time, std::chrono::seconds(0));
+}
+
+std::string varyKey(const Http::HeaderMap& response_headers,
+                    const Http::HeaderMap& request_headers) {
+  std::string key;
+  const Http::HeaderEntry* vary = response_headers.Vary();
+  if (vary == nullptr) {
+    return key;
+  }
+  for (const absl::string_view name : StringUtil::splitToken(vary->value().getStringView(), ",")) {
+    const Http::HeaderEntry* header =
+        request_headers.get(Http::LowerCaseString(std::string(StringUtil::trim(name))));
+    if (header != nullptr) {
+      absl::string_view separator;
+      for (const absl::string_view element :
+           StringUtil::splitToken(header->value().getStringView(), ",", false)) {
+        absl::StrAppend(&key, separator, StringUtil::trim(element));
+        separator = ",";
+      }
+    }
+    key.push_back('\n');
+  }
+  return key;
+}
+
+bool varyMatches(const CachedResponse& response, const Http::HeaderMap& request_headers) {
+  return response.vary_key_ == varyKey(*response.headers_, request_headers);
+}
+
+absl::optional<SystemTime> parseHttpDate(absl::string_view value) {
+  absl::Time time;
+  std::string error;
+  if (!absl::ParseTime("%a, %d %b %Y %H:%M:%S GMT", std::string(value), &time, &error)) {
+    return absl::nullopt;
+  }
+  return absl::ToChronoTime(time);
+}
+
+} // namespace Utility
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+#include "common/singleton/const_singleton.h"
+
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * Headers and cache-control directives used by the cache filter (RFC7234).
+ */
+class CacheHeaderValues {
+public:
+  const Http::LowerCaseString Age{"age"};
+  const Http::LowerCaseString Expires{"expires"};
+  const Http::LowerCaseString IfModifiedSince{"if-modified-since"};
+  const Http::LowerCaseString IfNoneMatch{"if-none-match"};
+  const Http::LowerCaseString Pragma{"pragma"};
+
+  const std::string MaxAge{"max-age"};
+  const std::string NoCache{"no-cache"};
+  const std::string NoStore{"no-store"};
+  const std::string Private{"private"};
+  const std::string SMaxAge{"s-maxage"};
+  const std::string VaryWildcard{"*"};
+};
+
+using CacheHeaders = ConstSingleton<CacheHeaderValues>;
+
+namespace Utility {
+
+/**
+ * The cache-control directives of a request.
+ */
+struct RequestCacheControl {
+  // The response must be neither served from nor stored in the cache.
+  bool no_store_{};
+  // A cached response must be revalidated with the upstream before it is served.
+  bool must_validate_{};
+};
+
+/**
+ * @param headers supplies the request headers.
+ * @return RequestCacheControl the cache-control directives of the request, including the
+ *         HTTP/1.0 "pragma: no-cache".
+ */
+RequestCacheControl requestCacheControl(const Http::HeaderMap& headers);
+
+/**
+ * @param headers supplies the response headers.
+ * @return bool whether a shared cache may store the response. It must have a cacheable status,
+ *         must not be marked no-store or private, must not set a cookie, must not vary on "*", and
+ *         must either say how long it is fresh or have a validator.
+ */
+bool isCacheableResponse(const Http::HeaderMap& headers);
+
+/**
+ * @param headers supplies the response headers.
+ * @return bool whether the response has an etag or last-modified validator.
+ */
+bool hasValidators(const Http::HeaderMap& headers);
+
+/**
+ * @param response supplies a cached response.
+ * @param now supplies the current time.
+ * @return bool whether the response may be served without revalidating it. Responses which are
+ *         marked no-cache are never fresh.
+ */
+bool isFresh(const CachedResponse& response, SystemTime now);
+
+/**
+ * @param response supplies a cached response.
+ * @param now supplies the current time.
+ * @return std::chrono::seconds the age of the response, including its age when it was received.
+ */
+std::chrono::seconds age(const CachedResponse& response, SystemTime now);
+
+/**
+ * @param response_headers supplies the response headers.
+ * @param request_headers supplies the request headers.
+ * @return std::string the values of the request headers named by the vary header of the response,
+ *         each followed by a newline. The values are normalized: the whitespace around the
+ *         elements of a list is removed.
+ */
+std::string varyKey(const Http::HeaderMap& response_headers,
+                    const Http::HeaderMap& request_headers);
+
+/**
+ * @param response supplies a cached response.
+ * @param request_headers supplies the request headers.
+ * @return bool whether the response is the variant selected by the request headers.
+ */
+bool varyMatches(const CachedResponse& response, const Http::HeaderMap& request_headers);
+
+/**
+ * @param value supplies the value of an HTTP date header, in the IMF-fixdate format.
+ * @return the time, or nothing if the value is not a date.
+ */
+absl::optional<SystemTime> parseHttpDate(absl::string_view value);
+
+} // namespace Utility
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
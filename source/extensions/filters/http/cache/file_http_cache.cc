@@ -0,0 +1,426 @@
+#include "extensions/filters/http/cache/file_http_cache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "envoy/common/exception.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/common/hash.h"
+#include "common/http/header_map_impl.h"
+
+#include "extensions/filters/http/cache/cache_utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+namespace {
+
+// "envoyhc" and the version of the file format.
+const uint64_t FileMagic = 0x656e766f79686302;
+
+// The number of shards of the index of a mapping.
+const uint32_t IndexShards = 16;
+
+// The number of attempts to append a record. The file may be replaced, by this process or another
+// one, between finding the current file and locking it.
+const uint32_t InsertAttempts = 3;
+
+uint64_t align(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+// Holds flock() on a file for its scope. Locking is retried when interrupted by a signal, and any
+// other failure leaves the file unlocked.
+class FileLock {
+public:
+  FileLock(int fd, int operation) : fd_(fd) {
+    int rc;
+    do {
+      rc = ::flock(fd_, operation);
+    } while (rc == -1 && errno == EINTR);
+    locked_ = rc == 0;
+  }
+  ~FileLock() {
+    if (locked_) {
+      ::flock(fd_, LOCK_UN);
+    }
+  }
+
+  bool locked() const { return locked_; }
+
+private:
+  const int fd_;
+  bool locked_;
+};
+
+void appendString(std::string& output, absl::string_view value) {
+  const uint32_t size = value.size();
+  output.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  output.append(value.data(), value.size());
+}
+
+// Reads a string written by appendString(), or returns false if it does not fit in the input.
+bool readString(absl::string_view& input, absl::string_view& value) {
+  uint32_t size;
+  if (input.size() < sizeof(size)) {
+    return false;
+  }
+  memcpy(&size, input.data(), sizeof(size));
+  input.remove_prefix(sizeof(size));
+  if (input.size() < size) {
+    return false;
+  }
+  value = input.substr(0, size);
+  input.remove_prefix(size);
+  return true;
+}
+
+std::string serializeHeaders(const Http::HeaderMap& headers) {
+  std::string output;
+  headers.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+        std::string& output = *static_cast<std::string*>(context);
+        appendString(output, header.key().getStringView());
+        appendString(output, header.value().getStringView());
+        return Http::HeaderMap::Iterate::Continue;
+      },
+      &output);
+  return output;
+}
+
+int openFile(const std::string& path, std::string& error) {
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    error = fmt::format("cannot open cache file {}: {}", path, strerror(errno));
+  }
+  return fd;
+}
+
+Http::HeaderMapPtr parseHeaders(absl::string_view input) {
+  auto headers = std::make_unique<Http::HeaderMapImpl>();
+  absl::string_view key;
+  absl::string_view value;
+  while (readString(input, key) && readString(input, value)) {
+    headers->addCopy(Http::LowerCaseString(std::string(key)), std::string(value));
+  }
+  return headers;
+}
+
+} // namespace
+
+FileHttpCache::FileHttpCache(const std::string& path, uint64_t size) : path_(path), size_(size) {
+  std::string error;
+  MappingSharedPtr mapping = openMapping(path_, error);
+  if (mapping == nullptr) {
+    throw EnvoyException(error);
+  }
+  absl::MutexLock lock(&mapping_mutex_);
+  mapping_ = std::move(mapping);
+}
+
+FileHttpCache::MappingSharedPtr FileHttpCache::openMapping(const std::string& path,
+                                                           std::string& error) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  int fd = openFile(path, error);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (os_sys_calls.stat(path.c_str(), &file_stat).rc_ == 0 && file_stat.st_size != 0 &&
+      static_cast<uint64_t>(file_stat.st_size) != size_) {
+    // Another process may still map the file with its old size, so it gets a new file rather than
+    // having the file truncated under it.
+    ::unlink(path.c_str());
+    os_sys_calls.close(fd);
+    fd = openFile(path, error);
+    if (fd == -1) {
+      return nullptr;
+    }
+  }
+
+  uint8_t* data = mapFile(path, fd, error);
+  if (data == nullptr) {
+    os_sys_calls.close(fd);
+    return nullptr;
+  }
+  return std::make_shared<Mapping>(fd, data, size_);
+}
+
+uint8_t* FileHttpCache::mapFile(const std::string& path, int fd, std::string& error) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  FileLock lock(fd, LOCK_EX);
+  if (!lock.locked()) {
+    error = fmt::format("cannot lock cache file {}: {}", path, strerror(errno));
+    return nullptr;
+  }
+  struct stat file_stat;
+  const Api::SysCallIntResult stat_result = os_sys_calls.stat(path.c_str(), &file_stat);
+  if (stat_result.rc_ == -1) {
+    error = fmt::format("cannot stat cache file {}: {}", path, strerror(stat_result.errno_));
+    return nullptr;
+  }
+  if (static_cast<uint64_t>(file_stat.st_size) != size_) {
+    const Api::SysCallIntResult truncate_result = os_sys_calls.ftruncate(fd, size_);
+    if (truncate_result.rc_ == -1) {
+      error =
+          fmt::format("cannot resize cache file {}: {}", path, strerror(truncate_result.errno_));
+      return nullptr;
+    }
+  }
+
+  const Api::SysCallPtrResult mmap_result =
+      os_sys_calls.mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mmap_result.rc_ == MAP_FAILED) {
+    error = fmt::format("cannot map cache file {}: {}", path, strerror(mmap_result.errno_));
+    return nullptr;
+  }
+  uint8_t* data = static_cast<uint8_t*>(mmap_result.rc_);
+
+  // A new file is all zeros, so it is initialized here too.
+  FileHeader& header = *reinterpret_cast<FileHeader*>(data);
+  const uint64_t end = header.end_.load(std::memory_order_acquire);
+  if (header.magic_ != FileMagic || header.size_ != size_ || end < sizeof(FileHeader) ||
+      end > size_) {
+    header.size_ = size_;
+    header.replaced_.store(0, std::memory_order_relaxed);
+    header.end_.store(sizeof(FileHeader), std::memory_order_release);
+    header.magic_ = FileMagic;
+  }
+  return data;
+}
+
+FileHttpCache::MappingSharedPtr FileHttpCache::currentMapping() {
+  MappingSharedPtr mapping;
+  {
+    absl::ReaderMutexLock lock(&mapping_mutex_);
+    mapping = mapping_;
+  }
+  if (mapping->header().replaced_.load(std::memory_order_acquire) == 0) {
+    return mapping;
+  }
+
+  absl::MutexLock lock(&mapping_mutex_);
+  if (mapping_ == mapping) {
+    // If the new file can not be mapped, the responses of the replaced one are still served.
+    std::string error;
+    MappingSharedPtr new_mapping = openMapping(path_, error);
+    if (new_mapping != nullptr) {
+      mapping_ = std::move(new_mapping);
+    }
+  }
+  return mapping_;
+}
+
+bool FileHttpCache::replaceFile(Mapping& mapping) {
+  // The new file is created next to the old one, and moved in place once it is initialized, so
+  // that other processes never map a file which is not initialized.
+  const std::string new_path = path_ + ".new";
+  ::unlink(new_path.c_str());
+  std::string error;
+  MappingSharedPtr new_mapping = openMapping(new_path, error);
+  if (new_mapping == nullptr) {
+    return false;
+  }
+  if (::rename(new_path.c_str(), path_.c_str()) == -1) {
+    ::unlink(new_path.c_str());
+    return false;
+  }
+  mapping.header().replaced_.store(1, std::memory_order_release);
+
+  absl::MutexLock lock(&mapping_mutex_);
+  mapping_ = std::move(new_mapping);
+  return true;
+}
+
+CachedResponseSharedPtr FileHttpCache::lookup(absl::string_view key,
+                                              const Http::HeaderMap& request_headers) {
+  const MappingSharedPtr mapping = currentMapping();
+  mapping->refreshIndex();
+  for (const uint64_t offset : mapping->offsets(key)) {
+    CachedResponseSharedPtr response = readRecord(mapping, offset);
+    if (Utility::varyMatches(*response, request_headers)) {
+      return response;
+    }
+  }
+  return nullptr;
+}
+
+void FileHttpCache::insert(absl::string_view key, const CachedResponseSharedPtr& response) {
+  const std::string headers = serializeHeaders(*response->headers_);
+  const uint64_t record_size = align(sizeof(RecordHeader) + key.size() +
+                                     response->vary_key_.size() + headers.size() +
+                                     response->body().size());
+  if (record_size > size_ - sizeof(FileHeader)) {
+    return;
+  }
+
+  absl::MutexLock lock(&insert_mutex_);
+  for (uint32_t attempt = 0; attempt < InsertAttempts; attempt++) {
+    const MappingSharedPtr mapping = currentMapping();
+    FileLock file_lock(mapping->fd(), LOCK_EX);
+    if (!file_lock.locked()) {
+      // The response is not cached.
+      return;
+    }
+    if (mapping->header().replaced_.load(std::memory_order_acquire) != 0) {
+      continue;
+    }
+    if (mapping->header().end_.load(std::memory_order_relaxed) + record_size > size_) {
+      if (!replaceFile(*mapping)) {
+        return;
+      }
+      continue;
+    }
+    mapping->append(key, *response, headers, record_size);
+    return;
+  }
+}
+
+CachedResponseSharedPtr FileHttpCache::readRecord(const MappingSharedPtr& mapping,
+                                                  uint64_t offset) {
+  RecordHeader record;
+  memcpy(&record, mapping->data() + offset, sizeof(record));
+  const char* input = reinterpret_cast<const char*>(mapping->data() + offset + sizeof(record));
+  input += record.key_size_;
+
+  auto response = std::make_shared<CachedResponse>();
+  response->vary_key_.assign(input, record.vary_key_size_);
+  input += record.vary_key_size_;
+  response->headers_ = parseHeaders(absl::string_view(input, record.headers_size_));
+  input += record.headers_size_;
+  // Records are never overwritten, so the body is served from the mapping.
+  response->body_view_ = absl::string_view(input, record.body_size_);
+  response->body_owner_ = mapping;
+  response->response_time_ =
+      SystemTime(std::chrono::duration_cast<SystemTime::duration>(
+          std::chrono::microseconds(record.response_time_us_)));
+  return response;
+}
+
+FileHttpCache::Mapping::Mapping(int fd, uint8_t* data, uint64_t size)
+    : fd_(fd), data_(data), size_(size), indexed_end_(sizeof(FileHeader)) {
+  for (uint32_t i = 0; i < IndexShards; i++) {
+    shards_.push_back(std::make_unique<IndexShard>());
+  }
+}
+
+FileHttpCache::Mapping::~Mapping() {
+  ::munmap(data_, size_);
+  Api::OsSysCallsSingleton::get().close(fd_);
+}
+
+void FileHttpCache::Mapping::refreshIndex() {
+  const uint64_t end = header().end_.load(std::memory_order_acquire);
+  if (indexed_end_.load(std::memory_order_acquire) >= end) {
+    return;
+  }
+
+  absl::MutexLock lock(&refresh_mutex_);
+  uint64_t offset = indexed_end_.load(std::memory_order_relaxed);
+  while (offset < end) {
+    const uint64_t record_size = recordSize(offset, end);
+    if (record_size == 0) {
+      // A corrupt log is not read any further.
+      offset = end;
+      break;
+    }
+    const absl::string_view key = recordKey(offset);
+    const absl::string_view vary_key = recordVaryKey(offset);
+    IndexShard& shard = this->shard(key);
+    absl::MutexLock shard_lock(&shard.mutex_);
+    std::vector<uint64_t>& offsets = shard.offsets_[std::string(key)];
+    offsets.erase(std::remove_if(offsets.begin(), offsets.end(),
+                                 [this, vary_key](uint64_t variant) {
+                                   return recordVaryKey(variant) == vary_key;
+                                 }),
+                  offsets.end());
+    if (offsets.size() >= MaxVariantsPerKey) {
+      offsets.erase(offsets.begin());
+    }
+    offsets.push_back(offset);
+    offset += record_size;
+  }
+  indexed_end_.store(offset, std::memory_order_release);
+}
+
+std::vector<uint64_t> FileHttpCache::Mapping::offsets(absl::string_view key) {
+  IndexShard& shard = this->shard(key);
+  absl::ReaderMutexLock lock(&shard.mutex_);
+  auto it = shard.offsets_.find(key);
+  if (it == shard.offsets_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+uint64_t FileHttpCache::Mapping::recordSize(uint64_t offset, uint64_t end) const {
+  if (offset + sizeof(RecordHeader) > end) {
+    return 0;
+  }
+  RecordHeader record;
+  memcpy(&record, data_ + offset, sizeof(record));
+  if (record.body_size_ > end - offset) {
+    return 0;
+  }
+  const uint64_t record_size = align(sizeof(RecordHeader) + record.key_size_ +
+                                     record.vary_key_size_ + record.headers_size_ +
+                                     record.body_size_);
+  return record_size <= end - offset ? record_size : 0;
+}
+
+absl::string_view FileHttpCache::Mapping::recordKey(uint64_t offset) const {
+  RecordHeader record;
+  memcpy(&record, data_ + offset, sizeof(record));
+  return absl::string_view(reinterpret_cast<const char*>(data_ + offset + sizeof(record)),
+                           record.key_size_);
+}
+
+absl::string_view FileHttpCache::Mapping::recordVaryKey(uint64_t offset) const {
+  RecordHeader record;
+  memcpy(&record, data_ + offset, sizeof(record));
+  return absl::string_view(
+      reinterpret_cast<const char*>(data_ + offset + sizeof(record) + record.key_size_),
+      record.vary_key_size_);
+}
+
+void FileHttpCache::Mapping::append(absl::string_view key, const CachedResponse& response,
+                                    absl::string_view headers, uint64_t record_size) {
+  const uint64_t offset = header().end_.load(std::memory_order_relaxed);
+  RecordHeader record;
+  record.key_size_ = key.size();
+  record.vary_key_size_ = response.vary_key_.size();
+  record.headers_size_ = headers.size();
+  record.padding_ = 0;
+  record.body_size_ = response.body().size();
+  record.response_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 response.response_time_.time_since_epoch())
+                                 .count();
+  uint8_t* output = data_ + offset;
+  memcpy(output, &record, sizeof(record));
+  output += sizeof(record);
+  for (absl::string_view part :
+       {key, absl::string_view(response.vary_key_), headers, response.body()}) {
+    memcpy(output, part.data(), part.size());
+    output += part.size();
+  }
+  // Lookups only read the record once the end of the log is past it.
+  header().end_.store(offset + record_size, std::memory_order_release);
+}
+
+FileHttpCache::IndexShard& FileHttpCache::Mapping::shard(absl::string_view key) {
+  return *shards_[HashUtil::xxHash64(key) % shards_.size()];
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * A store which keeps the cached responses in a memory mapped file, so that they survive a hot
+ * restart. The file is an append only log of responses. When a response does not fit at its end,
+ * the file is replaced by a new empty one, and the processes which map the old file move to the
+ * new one. Records are never overwritten, so responses are served straight from the mapping, which
+ * stays mapped for as long as a response references it.
+ *
+ * Every process which maps the file keeps an index of the responses in the log, sharded by key,
+ * which it brings up to date with the responses other processes appended before using it. Lookups
+ * do not lock the file: appends are serialized with flock(), and publish a record by advancing the
+ * end of the log after the record is written.
+ */
+class FileHttpCache : public HttpCache {
+public:
+  /**
+   * Maps the file, creating it if it does not exist or has another size or format.
+   * @param path the path of the file.
+   * @param size the size of the file.
+   * @throw EnvoyException if the file can not be created or mapped.
+   */
+  FileHttpCache(const std::string& path, uint64_t size);
+
+  // HttpCache
+  CachedResponseSharedPtr lookup(absl::string_view key,
+                                 const Http::HeaderMap& request_headers) override;
+  void insert(absl::string_view key, const CachedResponseSharedPtr& response) override;
+
+private:
+  // The start of the file. The records follow it.
+  struct FileHeader {
+    uint64_t magic_;
+    uint64_t size_;
+    // Set once the file is full and has been replaced by a new one.
+    std::atomic<uint64_t> replaced_;
+    // The offset past the last record.
+    std::atomic<uint64_t> end_;
+  };
+
+  // The start of a record. The key, vary key, headers and body follow it, and the record is padded
+  // to a multiple of 8 bytes.
+  struct RecordHeader {
+    uint32_t key_size_;
+    uint32_t vary_key_size_;
+    uint32_t headers_size_;
+    uint32_t padding_;
+    uint64_t body_size_;
+    int64_t response_time_us_;
+  };
+
+  // A shard of the index of a mapping.
+  struct IndexShard {
+    absl::Mutex mutex_;
+    // The offsets of the variants of the response cached under each key, least recently stored
+    // first.
+    absl::flat_hash_map<std::string, std::vector<uint64_t>> offsets_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  // A mapping of the file, and the index of its records in this process.
+  class Mapping {
+  public:
+    Mapping(int fd, uint8_t* data, uint64_t size);
+    ~Mapping();
+
+    int fd() const { return fd_; }
+    const uint8_t* data() const { return data_; }
+    FileHeader& header() const { return *reinterpret_cast<FileHeader*>(data_); }
+    // Brings the index up to date with the records appended to the log.
+    void refreshIndex();
+    // Returns the offsets of the variants cached under a key.
+    std::vector<uint64_t> offsets(absl::string_view key);
+    // Returns the size of the record at an offset, or 0 if it is not a valid record.
+    uint64_t recordSize(uint64_t offset, uint64_t end) const;
+    absl::string_view recordKey(uint64_t offset) const;
+    absl::string_view recordVaryKey(uint64_t offset) const;
+    // Appends a record. The file must be locked, and the record must fit.
+    void append(absl::string_view key, const CachedResponse& response, absl::string_view headers,
+                uint64_t record_size);
+
+  private:
+    IndexShard& shard(absl::string_view key);
+
+    const int fd_;
+    uint8_t* const data_;
+    const uint64_t size_;
+    std::vector<std::unique_ptr<IndexShard>> shards_;
+    absl::Mutex refresh_mutex_;
+    // The offset past the last record in the index.
+    std::atomic<uint64_t> indexed_end_;
+  };
+  using MappingSharedPtr = std::shared_ptr<Mapping>;
+
+  // Reads the response of a record. Its body references the mapping.
+  static CachedResponseSharedPtr readRecord(const MappingSharedPtr& mapping, uint64_t offset);
+
+  // Maps the file at a path, creating it if it does not exist or has another size or format.
+  // Returns nullptr and sets the error on failure.
+  MappingSharedPtr openMapping(const std::string& path, std::string& error);
+  // Locks, sizes, maps and initializes an open file. Returns nullptr and sets the error on failure.
+  uint8_t* mapFile(const std::string& path, int fd, std::string& error);
+  // Returns the mapping of the current file, moving to a new one if the file has been replaced.
+  MappingSharedPtr currentMapping();
+  // Replaces the file by a new empty one. The file must be locked. Returns false on failure.
+  bool replaceFile(Mapping& mapping);
+
+  const std::string path_;
+  const uint64_t size_;
+  absl::Mutex mapping_mutex_;
+  MappingSharedPtr mapping_ ABSL_GUARDED_BY(mapping_mutex_);
+  // Serializes the appends of this process, since flock() does not exclude the threads of the
+  // process which share the file descriptor.
+  absl::Mutex insert_mutex_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
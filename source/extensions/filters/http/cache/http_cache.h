@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/common/pure.h"
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * A cached response. It is immutable once it is stored, so that it can be served by any number of
+ * streams on any worker while the store evicts or replaces it.
+ */
+struct CachedResponse {
+  absl::string_view body() const {
+    return body_owner_ != nullptr ? body_view_ : absl::string_view(body_);
+  }
+
+  Http::HeaderMapPtr headers_;
+  // The body, when the response holds it.
+  std::string body_;
+  // Otherwise the body is held by another object, such as the mapping of a file or another
+  // response, which body_owner_ keeps alive for as long as the response is.
+  absl::string_view body_view_;
+  std::shared_ptr<const void> body_owner_;
+  // The normalized values of the request headers named by the vary header of the response, each
+  // followed by a newline. A response is only served to requests with the same values.
+  std::string vary_key_;
+  // When the response was received from the upstream or last revalidated.
+  SystemTime response_time_;
+};
+using CachedResponseSharedPtr = std::shared_ptr<const CachedResponse>;
+
+// The maximum number of variants of a response which are cached under a key. The least recently
+// stored variant is dropped for a new one.
+const uint32_t MaxVariantsPerKey = 8;
+
+/**
+ * A store of cached responses. A key may have several variants of a response which differ in their
+ * vary key. Stores are shared by all the workers, so they must be thread safe.
+ */
+class HttpCache {
+public:
+  virtual ~HttpCache() = default;
+
+  /**
+   * @param key supplies the cache key of the request.
+   * @param request_headers supplies the request headers, which select the variant of the response.
+   * @return CachedResponseSharedPtr the variant cached under the key which matches the request, or
+   *         nullptr.
+   */
+  virtual CachedResponseSharedPtr lookup(absl::string_view key,
+                                         const Http::HeaderMap& request_headers) PURE;
+
+  /**
+   * Caches a response, replacing the variant cached under the same key with the same vary key, if
+   * any. The store may evict other responses to make room for it, or not cache it at all.
+   * @param key supplies the cache key of the request.
+   * @param response supplies the response.
+   */
+  virtual void insert(absl::string_view key, const CachedResponseSharedPtr& response) PURE;
+};
+using HttpCacheSharedPtr = std::shared_ptr<HttpCache>;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,102 @@
+#include "extensions/filters/http/cache/in_memory_http_cache.h"
+
+#include <algorithm>
+
+#include "common/common/hash.h"
+#include "common/common/lock_guard.h"
+
+#include "extensions/filters/http/cache/cache_utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+namespace {
+
+uint64_t responseBytes(const CachedResponse& response) {
+  return response.headers_->byteSizeInternal() + response.body().size() +
+         response.vary_key_.size();
+}
+
+} // namespace
+
+InMemoryHttpCache::InMemoryHttpCache(uint64_t max_bytes, uint32_t shards)
+    : max_shard_bytes_(max_bytes / shards) {
+  for (uint32_t i = 0; i < shards; i++) {
+    shards_.push_back(std::make_unique<Shard>(max_shard_bytes_));
+  }
+}
+
+CachedResponseSharedPtr InMemoryHttpCache::lookup(absl::string_view key,
+                                                  const Http::HeaderMap& request_headers) {
+  Variants variants;
+  {
+    Shard& shard = this->shard(key);
+    Thread::LockGuard lock(shard.mutex_);
+    const Variants* entry = shard.entries_.lookup(key);
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    variants = *entry;
+  }
+  // The variants are matched outside of the lock, since that reads the request headers.
+  for (const CachedResponseSharedPtr& variant : variants) {
+    if (Utility::varyMatches(*variant, request_headers)) {
+      return variant;
+    }
+  }
+  return nullptr;
+}
+
+void InMemoryHttpCache::insert(absl::string_view key, const CachedResponseSharedPtr& response) {
+  Shard& shard = this->shard(key);
+  Thread::LockGuard lock(shard.mutex_);
+  Variants variants;
+  Variants* entry = shard.entries_.lookup(key);
+  if (entry != nullptr) {
+    variants = std::move(*entry);
+    shard.entries_.erase(key);
+  }
+  variants.erase(std::remove_if(variants.begin(), variants.end(),
+                                [&response](const CachedResponseSharedPtr& variant) {
+                                  return variant->vary_key_ == response->vary_key_;
+                                }),
+                 variants.end());
+  if (variants.size() >= MaxVariantsPerKey) {
+    variants.erase(variants.begin());
+  }
+  variants.push_back(response);
+
+  uint64_t bytes = key.size();
+  for (const CachedResponseSharedPtr& variant : variants) {
+    bytes += responseBytes(*variant);
+  }
+  // The oldest variants are dropped until the entry fits in the shard.
+  while (bytes > max_shard_bytes_ && !variants.empty()) {
+    bytes -= responseBytes(*variants.front());
+    variants.erase(variants.begin());
+  }
+  if (variants.empty()) {
+    return;
+  }
+  shard.entries_.insert(std::string(key), std::move(variants), bytes);
+}
+
+uint64_t InMemoryHttpCache::bytes() {
+  uint64_t bytes = 0;
+  for (auto& shard : shards_) {
+    Thread::LockGuard lock(shard->mutex_);
+    bytes += shard->entries_.weight();
+  }
+  return bytes;
+}
+
+InMemoryHttpCache::Shard& InMemoryHttpCache::shard(absl::string_view key) {
+  return *shards_[HashUtil::xxHash64(key) % shards_.size()];
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
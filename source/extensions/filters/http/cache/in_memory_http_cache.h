@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/lru_cache.h"
+#include "common/common/thread.h"
+
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * A store which keeps the cached responses in memory. The keys are spread among shards by their
+ * hash, and each shard is an LRU cache with its own lock, so that the workers rarely contend on a
+ * lock. Responses are shared rather than copied, so the locks are only held to update the index.
+ */
+class InMemoryHttpCache : public HttpCache {
+public:
+  /**
+   * @param max_bytes the maximum bytes of the keys, headers and bodies cached, spread evenly among
+   *        the shards.
+   * @param shards the number of shards.
+   */
+  InMemoryHttpCache(uint64_t max_bytes, uint32_t shards);
+
+  // HttpCache
+  CachedResponseSharedPtr lookup(absl::string_view key,
+                                 const Http::HeaderMap& request_headers) override;
+  void insert(absl::string_view key, const CachedResponseSharedPtr& response) override;
+
+  /**
+   * @return uint64_t the bytes of the responses cached by all the shards.
+   */
+  uint64_t bytes();
+
+private:
+  // The variants of the response cached under a key, least recently stored first.
+  using Variants = std::vector<CachedResponseSharedPtr>;
+
+  struct Shard {
+    Shard(uint64_t max_bytes) : entries_(max_bytes) {}
+
+    Thread::MutexBasicLockable mutex_;
+    // Weighed by the bytes of their keys and variants.
+    LruCache<std::string, Variants> entries_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  Shard& shard(absl::string_view key);
+
+  const uint64_t max_shard_bytes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
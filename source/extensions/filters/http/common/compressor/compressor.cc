@@ -0,0 +1,419 @@
+#include "extensions/filters/http/common/compressor/compressor.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
+#include "common/common/macros.h"
+#include "common/crypto/utility.h"
+#include "common/http/headers.h"
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+namespace {
+
+// Minimum length of an upstream response that allows compression.
+const uint64_t MinimumContentLength = 30;
+
+// Default content types will be used if any is provided by the user.
+const std::vector<std::string>& defaultContentEncoding() {
+  CONSTRUCT_ON_FIRST_USE(std::vector<std::string>,
+                         {"text/html", "text/plain", "text/css", "application/javascript",
+                          "application/json", "image/svg+xml", "text/xml",
+                          "application/xhtml+xml"});
+}
+
+// Returns the q-value of an accept-encoding element such as "gzip;q=0.5". The q-value defaults to
+// 1 when it is absent or malformed, so that sloppy clients keep getting compressed responses.
+float qValue(absl::string_view element) {
+  const absl::string_view::size_type pos = element.find(';');
+  if (pos == absl::string_view::npos) {
+    return 1;
+  }
+  const absl::string_view param = element.substr(pos + 1);
+  if (!StringUtil::caseCompare(StringUtil::trim(StringUtil::cropRight(param, "=")), "q")) {
+    return 1;
+  }
+  double q_value;
+  if (!absl::SimpleAtod(StringUtil::trim(StringUtil::cropLeft(param, "=")), &q_value) ||
+      !(q_value >= 0)) {
+    return 1;
+  }
+  return q_value < 1 ? q_value : 1;
+}
+
+bool isStrongEtag(absl::string_view value) {
+  return value.length() > 2 && !((value[0] == 'w' || value[0] == 'W') && value[1] == '/');
+}
+
+// References a cached body from a buffer without copying it. The body outlives its eviction from
+// the cache for as long as the buffer references it.
+class CachedBodyFragment : public Buffer::BufferFragment {
+public:
+  CachedBodyFragment(const CompressedBodySharedPtr& body) : body_(body) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return body_->data(); }
+  size_t size() const override { return body_->size(); }
+  void done() override { delete this; }
+
+private:
+  const CompressedBodySharedPtr body_;
+};
+
+} // namespace
+
+CompressorFilterConfig::CompressorFilterConfig(
+    const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+    const std::string& runtime_enabled_key, Protobuf::uint32 content_length,
+    const Protobuf::RepeatedPtrField<std::string>& content_types, bool disable_on_etag_header,
+    bool remove_accept_encoding_header)
+    : stats_prefix_(stats_prefix), scope_(scope), runtime_enabled_key_(runtime_enabled_key),
+      content_length_(contentLengthUint(content_length)),
+      content_type_values_(contentTypeSet(content_types)),
+      disable_on_etag_header_(disable_on_etag_header),
+      remove_accept_encoding_header_(remove_accept_encoding_header),
+      stats_(generateStats(stats_prefix, scope)), runtime_(runtime) {}
+
+void CompressorFilterConfig::addCompressorFactory(
+    Envoy::Compressor::CompressorFactoryPtr&& factory) {
+  Stats::Counter& header_counter =
+      scope_.counter(absl::StrCat(stats_prefix_, "header_", factory->contentEncoding()));
+  encodings_.push_back({std::move(factory), header_counter});
+}
+
+void CompressorFilterConfig::enableCache(ThreadLocal::SlotAllocator& tls, uint64_t max_bytes,
+                                         uint64_t max_entry_bytes) {
+  max_cache_entry_bytes_ = max_entry_bytes;
+  cache_slot_ = tls.allocateSlot();
+  cache_slot_->set([max_bytes](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CompressedResponseCache>(max_bytes);
+  });
+}
+
+StringUtil::CaseUnorderedSet
+CompressorFilterConfig::contentTypeSet(const Protobuf::RepeatedPtrField<std::string>& types) {
+  return types.empty() ? StringUtil::CaseUnorderedSet(defaultContentEncoding().begin(),
+                                                      defaultContentEncoding().end())
+                       : StringUtil::CaseUnorderedSet(types.cbegin(), types.cend());
+}
+
+uint64_t CompressorFilterConfig::contentLengthUint(Protobuf::uint32 length) {
+  return length >= MinimumContentLength ? length : MinimumContentLength;
+}
+
+CompressorFilter::CompressorFilter(const CompressorFilterConfigSharedPtr& config)
+    : skip_compression_{true}, config_(config) {}
+
+Http::FilterHeadersStatus CompressorFilter::decodeHeaders(Http::HeaderMap& headers, bool) {
+  if (config_->runtime().snapshot().featureEnabled(config_->runtimeEnabledKey(), 100) &&
+      isAcceptEncodingAllowed(headers)) {
+    skip_compression_ = false;
+    if (config_->removeAcceptEncodingHeader()) {
+      headers.removeAcceptEncoding();
+    }
+    if (config_->cacheEnabled() && headers.Host() && headers.Path()) {
+      request_url_ = absl::StrCat(headers.Host()->value().getStringView(),
+                                  headers.Path()->value().getStringView());
+    }
+  } else {
+    config_->stats().not_compressed_.inc();
+  }
+
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterHeadersStatus CompressorFilter::encodeHeaders(Http::HeaderMap& headers,
+                                                          bool end_stream) {
+  if (!end_stream && !skip_compression_ && isMinimumContentLength(headers) &&
+      isContentTypeAllowed(headers) && !hasCacheControlNoTransform(headers) &&
+      isEtagAllowed(headers) && isTransferEncodingAllowed(headers) && !headers.ContentEncoding()) {
+    if (config_->cacheEnabled()) {
+      prepareCache(headers);
+    }
+    sanitizeEtagHeader(headers);
+    insertVaryHeader(headers);
+    headers.removeContentLength();
+    headers.insertContentEncoding().value(encoding_->contentEncoding());
+    config_->stats().compressed_.inc();
+  } else if (!skip_compression_) {
+    skip_compression_ = true;
+    config_->stats().not_compressed_.inc();
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus CompressorFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (skip_compression_) {
+    return Http::FilterDataStatus::Continue;
+  }
+
+  config_->stats().total_uncompressed_bytes_.add(data.length());
+  // The body is replaced by the cached one, or buffered to be looked up by its hash, once it is
+  // complete.
+  if (!end_stream && (cached_body_ || hash_body_)) {
+    if (hash_body_) {
+      body_.move(data);
+    } else {
+      data.drain(data.length());
+    }
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+  compressData(data, end_stream);
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterTrailersStatus CompressorFilter::encodeTrailers(Http::HeaderMap&) {
+  if (!skip_compression_) {
+    Buffer::OwnedImpl buffer;
+    compressData(buffer, true);
+    encoder_callbacks_->addEncodedData(buffer, true);
+  }
+  return Http::FilterTrailersStatus::Continue;
+}
+
+void CompressorFilter::prepareCache(const Http::HeaderMap& headers) {
+  const Http::HeaderEntry* etag = headers.Etag();
+  if (etag && !request_url_.empty() && isStrongEtag(etag->value().getStringView())) {
+    cache_key_ = absl::StrCat(encoding_->contentEncoding(), "\n", request_url_, "\n",
+                              etag->value().getStringView());
+    cached_body_ = config_->cache().lookup(cache_key_);
+    if (cached_body_) {
+      config_->stats().cache_hit_.inc();
+    } else {
+      config_->stats().cache_miss_.inc();
+    }
+    return;
+  }
+
+  const Http::HeaderEntry* content_length = headers.ContentLength();
+  uint64_t length;
+  hash_body_ = content_length &&
+               absl::SimpleAtoi(content_length->value().getStringView(), &length) &&
+               length <= config_->maxCacheEntryBytes();
+}
+
+void CompressorFilter::compressData(Buffer::Instance& data, bool end_stream) {
+  if (hash_body_) {
+    hash_body_ = false;
+    body_.move(data);
+    data.move(body_);
+    cache_key_ = absl::StrCat(encoding_->contentEncoding(), "\n",
+                              Hex::encode(Envoy::Common::Crypto::Utility::getSha256Digest(data)));
+    cached_body_ = config_->cache().lookup(cache_key_);
+    if (cached_body_) {
+      config_->stats().cache_hit_.inc();
+    } else {
+      config_->stats().cache_miss_.inc();
+    }
+  }
+
+  if (cached_body_) {
+    data.drain(data.length());
+    data.addBufferFragment(*new CachedBodyFragment(cached_body_));
+    config_->stats().total_compressed_bytes_.add(data.length());
+    cached_body_ = nullptr;
+    return;
+  }
+
+  if (!compressor_) {
+    compressor_ = encoding_->createCompressor();
+  }
+  compressor_->compress(data, end_stream ? Envoy::Compressor::State::Finish
+                                         : Envoy::Compressor::State::Flush);
+  config_->stats().total_compressed_bytes_.add(data.length());
+  if (!cache_key_.empty()) {
+    cacheCompressedData(data, end_stream);
+  }
+}
+
+void CompressorFilter::cacheCompressedData(const Buffer::Instance& data, bool end_stream) {
+  if (compressed_body_.size() + data.length() > config_->maxCacheEntryBytes()) {
+    // Too large to be cached.
+    cache_key_.clear();
+    compressed_body_.clear();
+    return;
+  }
+
+  const uint64_t offset = compressed_body_.size();
+  compressed_body_.resize(offset + data.length());
+  data.copyOut(0, data.length(), &compressed_body_[offset]);
+  if (end_stream) {
+    const uint64_t evicted = config_->cache().insert(
+        std::move(cache_key_), std::make_shared<const std::string>(std::move(compressed_body_)));
+    config_->stats().cache_evicted_.add(evicted);
+    cache_key_.clear();
+  }
+}
+
+bool CompressorFilter::hasCacheControlNoTransform(Http::HeaderMap& headers) const {
+  const Http::HeaderEntry* cache_control = headers.CacheControl();
+  if (cache_control) {
+    return StringUtil::caseFindToken(cache_control->value().getStringView(), ",",
+                                     Http::Headers::get().CacheControlValues.NoTransform);
+  }
+
+  return false;
+}
+
+// The configured coding with the highest q-value wins, and codings registered first win ties
+// (RFC7231-5.3.4). A coding which is not named takes the q-value of the wildcard, and a q-value
+// of zero means "not acceptable". The response is left as is when identity is preferred over
+// every configured coding.
+bool CompressorFilter::isAcceptEncodingAllowed(Http::HeaderMap& headers) {
+  const Http::HeaderEntry* accept_encoding = headers.AcceptEncoding();
+  if (!accept_encoding) {
+    config_->stats().no_accept_header_.inc();
+    return false;
+  }
+
+  const auto& encodings = config_->encodings();
+  // The q-values of the configured codings which the header names, or -1.
+  absl::InlinedVector<float, 4> q_values(encodings.size(), -1);
+  float wildcard_q_value = -1;
+  float identity_q_value = -1;
+  for (const auto element : StringUtil::splitToken(accept_encoding->value().getStringView(), ",",
+                                                   false /* keep_empty */)) {
+    const absl::string_view coding = StringUtil::trim(StringUtil::cropRight(element, ";"));
+    if (coding == Http::Headers::get().AcceptEncodingValues.Wildcard) {
+      wildcard_q_value = qValue(element);
+    } else if (StringUtil::caseCompare(coding,
+                                       Http::Headers::get().AcceptEncodingValues.Identity)) {
+      identity_q_value = qValue(element);
+    } else {
+      for (size_t i = 0; i < encodings.size(); i++) {
+        if (StringUtil::caseCompare(coding, encodings[i].factory_->contentEncoding())) {
+          q_values[i] = qValue(element);
+          break;
+        }
+      }
+    }
+  }
+
+  size_t chosen = encodings.size();
+  float chosen_q_value = 0;
+  for (size_t i = 0; i < encodings.size(); i++) {
+    const float q_value = q_values[i] >= 0 ? q_values[i] : wildcard_q_value;
+    if (q_value > chosen_q_value) {
+      chosen = i;
+      chosen_q_value = q_value;
+    }
+  }
+
+  // If identity is preferred, the data should not be transformed.
+  // https://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.5.
+  if (identity_q_value >= 0 && (chosen == encodings.size() || identity_q_value > chosen_q_value)) {
+    config_->stats().header_identity_.inc();
+    return false;
+  }
+  if (chosen == encodings.size()) {
+    config_->stats().header_not_valid_.inc();
+    return false;
+  }
+
+  if (q_values[chosen] >= 0) {
+    encodings[chosen].header_counter_.inc();
+  } else {
+    config_->stats().header_wildcard_.inc();
+  }
+  encoding_ = encodings[chosen].factory_.get();
+  return true;
+}
+
+bool CompressorFilter::isContentTypeAllowed(Http::HeaderMap& headers) const {
+  const Http::HeaderEntry* content_type = headers.ContentType();
+  if (content_type && !config_->contentTypeValues().empty()) {
+    const absl::string_view value =
+        StringUtil::trim(StringUtil::cropRight(content_type->value().getStringView(), ";"));
+    return config_->contentTypeValues().find(value) != config_->contentTypeValues().end();
+  }
+
+  return true;
+}
+
+bool CompressorFilter::isEtagAllowed(Http::HeaderMap& headers) const {
+  const bool is_etag_allowed = !(config_->disableOnEtagHeader() && headers.Etag());
+  if (!is_etag_allowed) {
+    config_->stats().not_compressed_etag_.inc();
+  }
+  return is_etag_allowed;
+}
+
+bool CompressorFilter::isMinimumContentLength(Http::HeaderMap& headers) const {
+  const Http::HeaderEntry* content_length = headers.ContentLength();
+  if (content_length) {
+    uint64_t length;
+    const bool is_minimum_content_length =
+        absl::SimpleAtoi(content_length->value().getStringView(), &length) &&
+        length >= config_->minimumLength();
+    if (!is_minimum_content_length) {
+      config_->stats().content_length_too_small_.inc();
+    }
+    return is_minimum_content_length;
+  }
+
+  const Http::HeaderEntry* transfer_encoding = headers.TransferEncoding();
+  return (transfer_encoding &&
+          StringUtil::caseFindToken(transfer_encoding->value().getStringView(), ",",
+                                    Http::Headers::get().TransferEncodingValues.Chunked));
+}
+
+bool CompressorFilter::isTransferEncodingAllowed(Http::HeaderMap& headers) const {
+  const Http::HeaderEntry* transfer_encoding = headers.TransferEncoding();
+  if (transfer_encoding) {
+    for (auto header_value :
+         // TODO(gsagula): add Http::HeaderMap::string_view() so string length doesn't need to be
+         // computed twice. Find all other sites where this can be improved.
+         StringUtil::splitToken(transfer_encoding->value().getStringView(), ",", true)) {
+      const auto trimmed_value = StringUtil::trim(header_value);
+      if (StringUtil::caseCompare(trimmed_value,
+                                  Http::Headers::get().TransferEncodingValues.Gzip) ||
+          StringUtil::caseCompare(trimmed_value,
+                                  Http::Headers::get().TransferEncodingValues.Deflate)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void CompressorFilter::insertVaryHeader(Http::HeaderMap& headers) {
+  const Http::HeaderEntry* vary = headers.Vary();
+  if (vary) {
+    if (!StringUtil::findToken(vary->value().getStringView(), ",",
+                               Http::Headers::get().VaryValues.AcceptEncoding, true)) {
+      std::string new_header;
+      absl::StrAppend(&new_header, vary->value().getStringView(), ", ",
+                      Http::Headers::get().VaryValues.AcceptEncoding);
+      headers.insertVary().value(new_header);
+    }
+  } else {
+    headers.insertVary().value(Http::Headers::get().VaryValues.AcceptEncoding);
+  }
+}
+
+// TODO(gsagula): It seems that every proxy has a different opinion how to handle Etag. Some
+// discussions around this topic have been going on for over a decade, e.g.,
+// https://bz.apache.org/bugzilla/show_bug.cgi?id=45023
+// This design attempts to stay more on the safe side by preserving weak etags and removing
+// the strong ones when disable_on_etag_header is false. Envoy does NOT re-write entity tags.
+void CompressorFilter::sanitizeEtagHeader(Http::HeaderMap& headers) {
+  const Http::HeaderEntry* etag = headers.Etag();
+  if (etag && isStrongEtag(etag->value().getStringView())) {
+    headers.removeEtag();
+  }
+}
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/compressor/compressor.h"
+#include "envoy/http/filter.h"
+#include "envoy/http/header_map.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/protobuf/protobuf.h"
+
+#include "extensions/filters/http/common/compressor/response_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+/**
+ * All compressor filter stats. @see stats_macros.h
+ * "total_uncompressed_bytes" only includes bytes
+ * from requests that were marked for compression.
+ * If the request was not marked for compression,
+ * the filter increments "not_compressed", but does
+ * not add to "total_uncompressed_bytes". This way,
+ * the user can measure the memory performance of the
+ * compression.
+ * Each configured content-coding additionally gets a
+ * "header_<coding>" counter, e.g. "header_gzip", which
+ * is incremented when the coding was chosen because the
+ * accept-encoding header named it explicitly.
+ * The "cache_" counters are only incremented when the
+ * cache of compressed bodies is enabled.
+ */
+// clang-format off
+#define ALL_COMPRESSOR_STATS(COUNTER) \
+  COUNTER(compressed)                 \
+  COUNTER(not_compressed)             \
+  COUNTER(no_accept_header)           \
+  COUNTER(header_identity)            \
+  COUNTER(header_wildcard)            \
+  COUNTER(header_not_valid)           \
+  COUNTER(total_uncompressed_bytes)   \
+  COUNTER(total_compressed_bytes)     \
+  COUNTER(content_length_too_small)   \
+  COUNTER(not_compressed_etag)        \
+  COUNTER(cache_hit)                  \
+  COUNTER(cache_miss)                 \
+  COUNTER(cache_evicted)              \
+// clang-format on
+
+/**
+ * Struct definition for compressor stats. @see stats_macros.h
+ */
+struct CompressorStats {
+  ALL_COMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration shared by the filters which compress responses on client request. The content
+ * codings are registered by the concrete filter with addCompressorFactory(), in the order of
+ * server preference.
+ *
+ * Only the gzip filter registers a coding today. Brotli and zstd codings are still open work: they
+ * need their libraries added to bazel/repository_locations.bzl, and then plug in here as
+ * CompressorFactory implementations without changes to the negotiation.
+ */
+class CompressorFilterConfig {
+public:
+  virtual ~CompressorFilterConfig() = default;
+
+  /**
+   * A content-coding the filter can respond with.
+   */
+  struct Encoding {
+    Envoy::Compressor::CompressorFactoryPtr factory_;
+    // Incremented when the accept-encoding header names this coding and it is chosen.
+    Stats::Counter& header_counter_;
+  };
+
+  Runtime::Loader& runtime() { return runtime_; }
+  const std::string& runtimeEnabledKey() const { return runtime_enabled_key_; }
+  CompressorStats& stats() { return stats_; }
+  const std::vector<Encoding>& encodings() const { return encodings_; }
+  const StringUtil::CaseUnorderedSet& contentTypeValues() const { return content_type_values_; }
+  bool disableOnEtagHeader() const { return disable_on_etag_header_; }
+  bool removeAcceptEncodingHeader() const { return remove_accept_encoding_header_; }
+  uint64_t minimumLength() const { return content_length_; }
+  bool cacheEnabled() const { return cache_slot_ != nullptr; }
+  CompressedResponseCache& cache() { return cache_slot_->getTyped<CompressedResponseCache>(); }
+  uint64_t maxCacheEntryBytes() const { return max_cache_entry_bytes_; }
+
+protected:
+  /**
+   * @param stats_prefix the prefix of all the filter stats, including the trailing dot.
+   * @param runtime_enabled_key the runtime feature key which gates the filter.
+   * @param content_length the minimum response length worth compressing. Values below the
+   *        hard minimum are raised to it.
+   * @param content_types the response content types to compress. A default set of text types is
+   *        used if none is given.
+   */
+  CompressorFilterConfig(const std::string& stats_prefix, Stats::Scope& scope,
+                         Runtime::Loader& runtime, const std::string& runtime_enabled_key,
+                         Protobuf::uint32 content_length,
+                         const Protobuf::RepeatedPtrField<std::string>& content_types,
+                         bool disable_on_etag_header, bool remove_accept_encoding_header);
+
+  /**
+   * Registers a content-coding. Codings registered first are preferred when the client accepts
+   * several of them with the same q-value.
+   */
+  void addCompressorFactory(Envoy::Compressor::CompressorFactoryPtr&& factory);
+
+  /**
+   * Enables caching compressed response bodies, so that responses which are served repeatedly
+   * are only compressed once per worker. Responses with a strong etag are cached by their URL and
+   * etag. Other responses are cached by a hash of their body, which is buffered for this, so only
+   * responses with a content-length of at most max_entry_bytes are cached that way.
+   * @param max_bytes the maximum bytes of the bodies each worker caches.
+   * @param max_entry_bytes the maximum size of a cached body, before and after compression.
+   */
+  void enableCache(ThreadLocal::SlotAllocator& tls, uint64_t max_bytes, uint64_t max_entry_bytes);
+
+private:
+  static StringUtil::CaseUnorderedSet
+  contentTypeSet(const Protobuf::RepeatedPtrField<std::string>& types);
+  static uint64_t contentLengthUint(Protobuf::uint32 length);
+
+  static CompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return CompressorStats{ALL_COMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  const std::string stats_prefix_;
+  Stats::Scope& scope_;
+  const std::string runtime_enabled_key_;
+  const uint64_t content_length_;
+  const StringUtil::CaseUnorderedSet content_type_values_;
+  const bool disable_on_etag_header_;
+  const bool remove_accept_encoding_header_;
+  CompressorStats stats_;
+  Runtime::Loader& runtime_;
+  std::vector<Encoding> encodings_;
+  ThreadLocal::SlotPtr cache_slot_;
+  uint64_t max_cache_entry_bytes_{};
+};
+using CompressorFilterConfigSharedPtr = std::shared_ptr<CompressorFilterConfig>;
+
+/**
+ * A filter that compresses data dispatched from the upstream upon client request. The content
+ * coding is negotiated from the q-values of the accept-encoding header among the codings of the
+ * configuration.
+ */
+class CompressorFilter : public Http::StreamFilter {
+public:
+  CompressorFilter(const CompressorFilterConfigSharedPtr& config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override{};
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  };
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& buffer, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override;
+  Http::FilterMetadataStatus encodeMetadata(Http::MetadataMap&) override {
+    return Http::FilterMetadataStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+protected:
+  // TODO(gsagula): This is here temporarily and just to facilitate testing. Ideally all
+  // the logic in these member functions would be available in another class.
+  bool hasCacheControlNoTransform(Http::HeaderMap& headers) const;
+  // Chooses the content-coding of the response, and returns whether there is one.
+  bool isAcceptEncodingAllowed(Http::HeaderMap& headers);
+  bool isContentTypeAllowed(Http::HeaderMap& headers) const;
+  bool isEtagAllowed(Http::HeaderMap& headers) const;
+  bool isMinimumContentLength(Http::HeaderMap& headers) const;
+  bool isTransferEncodingAllowed(Http::HeaderMap& headers) const;
+
+  void sanitizeEtagHeader(Http::HeaderMap& headers);
+  void insertVaryHeader(Http::HeaderMap& headers);
+
+private:
+  // Looks up the body of a response with a strong etag in the cache, or prepares caching it by
+  // the hash of its body.
+  void prepareCache(const Http::HeaderMap& headers);
+  // Compresses the next data of the body, or replaces the body with the cached one.
+  void compressData(Buffer::Instance& data, bool end_stream);
+  void cacheCompressedData(const Buffer::Instance& data, bool end_stream);
+
+  bool skip_compression_;
+  // The coding chosen from the accept-encoding header, if any.
+  Envoy::Compressor::CompressorFactory* encoding_{};
+  Envoy::Compressor::CompressorPtr compressor_;
+  CompressorFilterConfigSharedPtr config_;
+  // The URL of the request, which caches responses with an etag.
+  std::string request_url_;
+  // The key the compressed body is cached under, if it is cached.
+  std::string cache_key_;
+  // Whether the body is buffered to look it up in the cache by its hash.
+  bool hash_body_{};
+  Buffer::OwnedImpl body_;
+  // The compressed body found in the cache.
+  CompressedBodySharedPtr cached_body_;
+  // The compressed body to be cached.
+  std::string compressed_body_;
+
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
+  Http::StreamEncoderFilterCallbacks* encoder_callbacks_{nullptr};
+};
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,23 @@
+#include "extensions/filters/http/common/compressor/response_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+CompressedBodySharedPtr CompressedResponseCache::lookup(absl::string_view key) {
+  const CompressedBodySharedPtr* body = bodies_.lookup(key);
+  return body != nullptr ? *body : nullptr;
+}
+
+uint64_t CompressedResponseCache::insert(std::string&& key, CompressedBodySharedPtr body) {
+  const uint64_t bytes = key.size() + body->size();
+  return bodies_.insert(std::move(key), std::move(body), bytes);
+}
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/lru_cache.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+
+using CompressedBodySharedPtr = std::shared_ptr<const std::string>;
+
+/**
+ * An LRU cache of compressed response bodies. Each worker has its own, so that it is used without
+ * locking, and its memory is bounded by the sizes of the keys and bodies it holds.
+ */
+class CompressedResponseCache : public ThreadLocal::ThreadLocalObject {
+public:
+  CompressedResponseCache(uint64_t max_bytes) : bodies_(max_bytes) {}
+
+  /**
+   * @param key supplies the key of the body.
+   * @return CompressedBodySharedPtr the body cached under the key, which becomes the most recently
+   *         used one, or nullptr. The body stays valid if it is evicted while in use.
+   */
+  CompressedBodySharedPtr lookup(absl::string_view key);
+
+  /**
+   * Caches a body, evicting the least recently used bodies to make room for it. Bodies which do
+   * not fit in the cache on their own are not cached.
+   * @param key supplies the key of the body.
+   * @param body supplies the compressed body.
+   * @return uint64_t the number of bodies evicted.
+   */
+  uint64_t insert(std::string&& key, CompressedBodySharedPtr body);
+
+  /**
+   * @return uint64_t the bytes of the keys and bodies cached.
+   */
+  uint64_t bytes() const { return bodies_.weight(); }
+
+  /**
+   * @return uint64_t the number of bodies cached.
+   */
+  uint64_t size() const { return bodies_.size(); }
+
+private:
+  // Weighed by the bytes of their keys and bodies.
+  LruCache<std::string, CompressedBodySharedPtr> bodies_;
+};
+
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "envoy/config/filter/http/decompressor/v2alpha/decompressor.pb.h"
+#include "envoy/config/filter/http/decompressor/v2alpha/decompressor.pb.validate.h"
+
+#include "extensions/filters/http/common/factory_base.h"
+#include "extensions/filters/http/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+/**
+ * Config registration for the decompressor filter. @see NamedHttpFilterConfigFactory.
+ */
+class DecompressorFilterFactory
+    : public Common::FactoryBase<envoy::config::filter::http::decompressor::v2alpha::Decompressor> {
+public:
+  DecompressorFilterFactory() : FactoryBase(HttpFilterNames::get().Decompressor) {}
+
+private:
+  Http::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoy::config::filter::http::decompressor::v2alpha::Decompressor& config,
+      const std::string& stats_prefix, Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,381 @@
+#include "extensions/filters/http/decompressor/decompressor_filter.h"
+
+#include <algorithm>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/protobuf/utility.h"
+#include "common/singleton/const_singleton.h"
+
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+struct RcDetailsValues {
+  const std::string DecompressionError = "decompressor_decompression_error";
+  const std::string RatioExceeded = "decompressor_ratio_exceeded";
+};
+using RcDetails = ConstSingleton<RcDetailsValues>;
+
+namespace {
+
+// Default and maximum decompression window size.
+const uint64_t DefaultWindowBits = 15;
+
+// When summed to window bits, this makes the decompressor expect a gzip header and trailer.
+const uint64_t GzipHeaderValue = 16;
+
+// Default size of the buffers which decompressed data is written to.
+const uint64_t DefaultChunkSize = 4096;
+
+// Default maximum ratio of the decompressed size of a body to its compressed size.
+const uint64_t DefaultMaxDecompressionRatio = 100;
+
+} // namespace
+
+DecompressorFilterConfig::DecompressorFilterConfig(
+    const envoy::config::filter::http::decompressor::v2alpha::Decompressor& decompressor,
+    const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime)
+    : window_bits_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(decompressor, window_bits, DefaultWindowBits) |
+                   GzipHeaderValue),
+      chunk_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(decompressor, chunk_size, DefaultChunkSize)),
+      max_decompression_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          decompressor, max_decompression_ratio, DefaultMaxDecompressionRatio)),
+      decompress_requests_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(decompressor, decompress_requests, true)),
+      decompress_responses_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(decompressor, decompress_responses, false)),
+      stats_(generateStats(stats_prefix + "decompressor.", scope)), runtime_(runtime) {}
+
+std::unique_ptr<Envoy::Decompressor::ZlibDecompressorImpl>
+DecompressorFilterConfig::makeDecompressor() const {
+  auto decompressor = std::make_unique<Envoy::Decompressor::ZlibDecompressorImpl>(chunk_size_);
+  decompressor->init(window_bits_);
+  return decompressor;
+}
+
+BodyDecompressor::BodyDecompressor(DecompressorFilterConfig& config)
+    : config_(config), decompressor_(config.makeDecompressor()) {}
+
+BodyDecompressor::Result BodyDecompressor::decompress(Buffer::Instance& data,
+                                                      uint64_t output_limit, bool end_of_body) {
+  // The compressed data is fed to the decompressor in chunk sized steps, and the ratio and the
+  // output limit are checked after each of them. A deflate stream expands at most ~1000 times, so
+  // this bounds the memory a single step can allocate, however large the slices read from the peer
+  // are.
+  input_.move(data);
+  Buffer::OwnedImpl input;
+  while (input_.length() > 0 && (output_limit == 0 || data.length() < output_limit)) {
+    input.move(input_, std::min(input_.length(), config_.chunkSize()));
+    const uint64_t output_length = data.length();
+    decompressor_->decompress(input, data);
+    compressed_bytes_ += input.length();
+    decompressed_bytes_ += data.length() - output_length;
+    config_.stats().total_compressed_bytes_.add(input.length());
+    config_.stats().total_decompressed_bytes_.add(data.length() - output_length);
+    input.drain(input.length());
+
+    if (decompressor_->decompressionError()) {
+      config_.stats().decompression_error_.inc();
+      return Result::DecompressionError;
+    }
+    if (decompressed_bytes_ > config_.chunkSize() &&
+        decompressed_bytes_ > compressed_bytes_ * config_.maxDecompressionRatio()) {
+      config_.stats().ratio_exceeded_.inc();
+      return Result::RatioExceeded;
+    }
+  }
+  if (end_of_body && input_.length() == 0 && !decompressor_->streamEnd()) {
+    config_.stats().truncated_.inc();
+    return Result::Truncated;
+  }
+  return Result::Ok;
+}
+
+StreamDecompressor::StreamDecompressor(DecompressorFilterConfig& config,
+                                       Event::Dispatcher& dispatcher)
+    : decompressor_(config), dispatcher_(dispatcher) {}
+
+Http::FilterDataStatus StreamDecompressor::onData(Buffer::Instance& data, bool end_stream) {
+  if (failed_) {
+    data.drain(data.length());
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+  if (draining_) {
+    // The data is passed on after the data which is still held back.
+    decompressor_.addInput(data);
+    end_stream_ = end_stream;
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  const BodyDecompressor::Result result =
+      decompressor_.decompress(data, bufferLimit(), end_stream);
+  if (result != BodyDecompressor::Result::Ok) {
+    data.drain(data.length());
+    fail(result);
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+  if (!decompressor_.hasInput()) {
+    return Http::FilterDataStatus::Continue;
+  }
+
+  // The data decompressed so far is past the buffer limit. It is held back, and passed on with the
+  // rest of the frame by drain() once the dispatcher gets around to it.
+  output_.move(data);
+  end_stream_ = end_stream;
+  draining_ = true;
+  onAboveWriteBufferHighWatermark();
+  if (!drain_timer_) {
+    drain_timer_ = dispatcher_.createTimer([this]() -> void { drain(); });
+  }
+  drain_timer_->enableTimer(std::chrono::milliseconds(0));
+  return Http::FilterDataStatus::StopIterationNoBuffer;
+}
+
+Http::FilterTrailersStatus StreamDecompressor::onTrailers() {
+  if (failed_) {
+    return Http::FilterTrailersStatus::StopIteration;
+  }
+  if (draining_) {
+    trailers_held_ = true;
+    return Http::FilterTrailersStatus::StopIteration;
+  }
+
+  Buffer::OwnedImpl data;
+  const BodyDecompressor::Result result = decompressor_.decompress(data, 0, true);
+  if (result != BodyDecompressor::Result::Ok) {
+    fail(result);
+    return Http::FilterTrailersStatus::StopIteration;
+  }
+  return Http::FilterTrailersStatus::Continue;
+}
+
+void StreamDecompressor::drain() {
+  Buffer::OwnedImpl data;
+  data.move(output_);
+  injectData(data, false);
+
+  const BodyDecompressor::Result result =
+      decompressor_.decompress(output_, bufferLimit(), end_stream_ || trailers_held_);
+  if (result != BodyDecompressor::Result::Ok) {
+    fail(result);
+    return;
+  }
+  if (decompressor_.hasInput()) {
+    drain_timer_->enableTimer(std::chrono::milliseconds(0));
+    return;
+  }
+
+  draining_ = false;
+  onBelowWriteBufferLowWatermark();
+  if (output_.length() > 0 || end_stream_) {
+    data.move(output_);
+    injectData(data, end_stream_);
+  }
+  if (trailers_held_) {
+    continueIteration();
+  }
+}
+
+void StreamDecompressor::fail(BodyDecompressor::Result result) {
+  failed_ = true;
+  output_.drain(output_.length());
+  if (draining_) {
+    draining_ = false;
+    onBelowWriteBufferLowWatermark();
+  }
+  onFailure(result);
+}
+
+namespace {
+
+class RequestDecompressor : public StreamDecompressor {
+public:
+  RequestDecompressor(DecompressorFilterConfig& config,
+                      Http::StreamDecoderFilterCallbacks& callbacks)
+      : StreamDecompressor(config, callbacks.dispatcher()), callbacks_(callbacks) {}
+
+protected:
+  // StreamDecompressor
+  void injectData(Buffer::Instance& data, bool end_stream) override {
+    callbacks_.injectDecodedDataToFilterChain(data, end_stream);
+  }
+  void continueIteration() override { callbacks_.continueDecoding(); }
+  uint32_t bufferLimit() override { return callbacks_.decoderBufferLimit(); }
+  void onAboveWriteBufferHighWatermark() override {
+    callbacks_.onDecoderFilterAboveWriteBufferHighWatermark();
+  }
+  void onBelowWriteBufferLowWatermark() override {
+    callbacks_.onDecoderFilterBelowWriteBufferLowWatermark();
+  }
+  void onFailure(BodyDecompressor::Result result) override {
+    switch (result) {
+    case BodyDecompressor::Result::DecompressionError:
+      callbacks_.sendLocalReply(Http::Code::BadRequest, "Invalid gzip encoded body", nullptr,
+                                absl::nullopt, RcDetails::get().DecompressionError);
+      break;
+    case BodyDecompressor::Result::RatioExceeded:
+      callbacks_.sendLocalReply(Http::Code::PayloadTooLarge, "Decompression ratio exceeded",
+                                nullptr, absl::nullopt, RcDetails::get().RatioExceeded);
+      break;
+    default:
+      // Part of the body may have been passed on already, so the stream can only be reset.
+      callbacks_.resetStream();
+      break;
+    }
+  }
+
+private:
+  Http::StreamDecoderFilterCallbacks& callbacks_;
+};
+
+class ResponseDecompressor : public StreamDecompressor {
+public:
+  ResponseDecompressor(DecompressorFilterConfig& config,
+                       Http::StreamEncoderFilterCallbacks& callbacks)
+      : StreamDecompressor(config, callbacks.dispatcher()), callbacks_(callbacks) {}
+
+protected:
+  // StreamDecompressor
+  void injectData(Buffer::Instance& data, bool end_stream) override {
+    callbacks_.injectEncodedDataToFilterChain(data, end_stream);
+  }
+  void continueIteration() override { callbacks_.continueEncoding(); }
+  uint32_t bufferLimit() override { return callbacks_.encoderBufferLimit(); }
+  void onAboveWriteBufferHighWatermark() override {
+    callbacks_.onEncoderFilterAboveWriteBufferHighWatermark();
+  }
+  void onBelowWriteBufferLowWatermark() override {
+    callbacks_.onEncoderFilterBelowWriteBufferLowWatermark();
+  }
+  void onFailure(BodyDecompressor::Result) override {
+    // The response headers have been sent on, so the stream can only be reset.
+    callbacks_.resetStream();
+  }
+
+private:
+  Http::StreamEncoderFilterCallbacks& callbacks_;
+};
+
+} // namespace
+
+DecompressorFilter::DecompressorFilter(const DecompressorFilterConfigSharedPtr& config)
+    : config_(config) {}
+
+void DecompressorFilter::onDestroy() {
+  // Stops the decompression of bodies which are still held back.
+  request_decompressor_.reset();
+  response_decompressor_.reset();
+}
+
+Http::FilterHeadersStatus DecompressorFilter::decodeHeaders(Http::HeaderMap& headers,
+                                                            bool end_stream) {
+  enabled_ = config_->runtime().snapshot().featureEnabled("decompressor.filter_enabled", 100);
+  if (!enabled_) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  if (config_->decompressResponses()) {
+    accepts_gzip_ = acceptsGzip(headers);
+  }
+  if (!end_stream && config_->decompressRequests() && isGzipEncoded(headers)) {
+    removeEncodingHeaders(headers);
+    request_decompressor_ = std::make_unique<RequestDecompressor>(*config_, *decoder_callbacks_);
+    config_->stats().request_decompressed_.inc();
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus DecompressorFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (!request_decompressor_) {
+    return Http::FilterDataStatus::Continue;
+  }
+  return request_decompressor_->onData(data, end_stream);
+}
+
+Http::FilterTrailersStatus DecompressorFilter::decodeTrailers(Http::HeaderMap&) {
+  if (!request_decompressor_) {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  return request_decompressor_->onTrailers();
+}
+
+Http::FilterHeadersStatus DecompressorFilter::encodeHeaders(Http::HeaderMap& headers,
+                                                            bool end_stream) {
+  if (!end_stream && enabled_ && config_->decompressResponses() && !accepts_gzip_ &&
+      isGzipEncoded(headers)) {
+    removeEncodingHeaders(headers);
+    response_decompressor_ = std::make_unique<ResponseDecompressor>(*config_, *encoder_callbacks_);
+    config_->stats().response_decompressed_.inc();
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus DecompressorFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!response_decompressor_) {
+    return Http::FilterDataStatus::Continue;
+  }
+  return response_decompressor_->onData(data, end_stream);
+}
+
+Http::FilterTrailersStatus DecompressorFilter::encodeTrailers(Http::HeaderMap&) {
+  if (!response_decompressor_) {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  return response_decompressor_->onTrailers();
+}
+
+bool DecompressorFilter::isGzipEncoded(const Http::HeaderMap& headers) {
+  const Http::HeaderEntry* content_encoding = headers.ContentEncoding();
+  return content_encoding != nullptr &&
+         StringUtil::caseCompare(StringUtil::trim(content_encoding->value().getStringView()),
+                                 Http::Headers::get().ContentEncodingValues.Gzip);
+}
+
+bool DecompressorFilter::acceptsGzip(const Http::HeaderMap& headers) {
+  const Http::HeaderEntry* accept_encoding = headers.AcceptEncoding();
+  if (accept_encoding == nullptr) {
+    return false;
+  }
+  // An explicit gzip element takes precedence over the wildcard.
+  bool wildcard = false;
+  for (const auto element : StringUtil::splitToken(accept_encoding->value().getStringView(), ",",
+                                                   false /* keep_empty */)) {
+    const absl::string_view coding = StringUtil::trim(StringUtil::cropRight(element, ";"));
+    if (StringUtil::caseCompare(coding, Http::Headers::get().AcceptEncodingValues.Gzip)) {
+      return isAcceptable(element);
+    }
+    if (coding == Http::Headers::get().AcceptEncodingValues.Wildcard) {
+      wildcard = isAcceptable(element);
+    }
+  }
+  return wildcard;
+}
+
+bool DecompressorFilter::isAcceptable(absl::string_view element) {
+  const absl::string_view::size_type pos = element.find(';');
+  if (pos == absl::string_view::npos) {
+    return true;
+  }
+  // The coding is acceptable unless its q-value is zero.
+  const absl::string_view param = element.substr(pos + 1);
+  double q_value;
+  return !StringUtil::caseCompare(StringUtil::trim(StringUtil::cropRight(param, "=")), "q") ||
+         !absl::SimpleAtod(StringUtil::trim(StringUtil::cropLeft(param, "=")), &q_value) ||
+         q_value > 0;
+}
+
+void DecompressorFilter::removeEncodingHeaders(Http::HeaderMap& headers) {
+  headers.removeContentEncoding();
+  // The length of the decompressed body is not known up front.
+  headers.removeContentLength();
+}
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/config/filter/http/decompressor/v2alpha/decompressor.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/decompressor/zlib_decompressor_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+/**
+ * All decompressor filter stats. @see stats_macros.h
+ * "total_compressed_bytes" and "total_decompressed_bytes"
+ * count the bytes of the bodies of both directions which
+ * were decompressed, before and after decompression.
+ */
+// clang-format off
+#define ALL_DECOMPRESSOR_STATS(COUNTER)  \
+  COUNTER(request_decompressed)          \
+  COUNTER(response_decompressed)         \
+  COUNTER(total_compressed_bytes)        \
+  COUNTER(total_decompressed_bytes)      \
+  COUNTER(decompression_error)           \
+  COUNTER(ratio_exceeded)                \
+  COUNTER(truncated)                     \
+// clang-format on
+
+/**
+ * Struct definition for decompressor stats. @see stats_macros.h
+ */
+struct DecompressorStats {
+  ALL_DECOMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the decompressor filter.
+ */
+class DecompressorFilterConfig {
+public:
+  DecompressorFilterConfig(
+      const envoy::config::filter::http::decompressor::v2alpha::Decompressor& decompressor,
+      const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime);
+
+  /**
+   * @return a decompressor of gzip encoded data.
+   */
+  std::unique_ptr<Envoy::Decompressor::ZlibDecompressorImpl> makeDecompressor() const;
+
+  Runtime::Loader& runtime() { return runtime_; }
+  DecompressorStats& stats() { return stats_; }
+  uint64_t windowBits() const { return window_bits_; }
+  uint64_t chunkSize() const { return chunk_size_; }
+  uint64_t maxDecompressionRatio() const { return max_decompression_ratio_; }
+  bool decompressRequests() const { return decompress_requests_; }
+  bool decompressResponses() const { return decompress_responses_; }
+
+private:
+  static DecompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return DecompressorStats{ALL_DECOMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  const uint64_t window_bits_;
+  const uint64_t chunk_size_;
+  const uint64_t max_decompression_ratio_;
+  const bool decompress_requests_;
+  const bool decompress_responses_;
+  DecompressorStats stats_;
+  Runtime::Loader& runtime_;
+};
+using DecompressorFilterConfigSharedPtr = std::shared_ptr<DecompressorFilterConfig>;
+
+/**
+ * Decompresses one gzip encoded body as it streams through the filter, enforcing the
+ * decompression ratio limit of the configuration.
+ */
+class BodyDecompressor {
+public:
+  enum class Result { Ok, DecompressionError, RatioExceeded, Truncated };
+
+  BodyDecompressor(DecompressorFilterConfig& config);
+
+  /**
+   * Replaces the compressed data in a buffer with the data it decompresses to. Decompression stops
+   * once the decompressed data reaches a limit, and the compressed data left over is decompressed
+   * by the next calls.
+   * @param data supplies the next compressed bytes of the body.
+   * @param output_limit supplies the bytes after which decompression stops, or 0 for no limit.
+   * @param end_of_body supplies whether the body has ended.
+   * @return Result whether the body may be decompressed further.
+   */
+  Result decompress(Buffer::Instance& data, uint64_t output_limit, bool end_of_body);
+
+  /**
+   * Adds compressed bytes of the body to be decompressed by the next calls to decompress().
+   * @param data supplies the next compressed bytes of the body.
+   */
+  void addInput(Buffer::Instance& data) { input_.move(data); }
+
+  /**
+   * @return bool whether compressed bytes are left to be decompressed.
+   */
+  bool hasInput() const { return input_.length() > 0; }
+
+private:
+  DecompressorFilterConfig& config_;
+  std::unique_ptr<Envoy::Decompressor::ZlibDecompressorImpl> decompressor_;
+  Buffer::OwnedImpl input_;
+  uint64_t compressed_bytes_{};
+  uint64_t decompressed_bytes_{};
+};
+
+/**
+ * Decompresses the body of one direction of a stream. The data decompressed from one data frame is
+ * passed on as long as it stays within the buffer limit of the stream. Past the limit, reading from
+ * the peer is disabled through the watermark callbacks, and the rest of the frame is decompressed
+ * and passed on in buffer limit sized steps, one per dispatcher iteration.
+ */
+class StreamDecompressor {
+public:
+  StreamDecompressor(DecompressorFilterConfig& config, Event::Dispatcher& dispatcher);
+  virtual ~StreamDecompressor() = default;
+
+  /**
+   * Called with the next data frame of the body, from the data callback of the filter.
+   * @return Http::FilterDataStatus Continue if the data has been replaced by the data it
+   *         decompresses to, or StopIterationNoBuffer if it has been taken over.
+   */
+  Http::FilterDataStatus onData(Buffer::Instance& data, bool end_stream);
+
+  /**
+   * Called with the trailers which end the body, from the trailers callback of the filter.
+   * @return Http::FilterTrailersStatus StopIteration if the trailers are held back until the
+   *         decompressed data has been passed on.
+   */
+  Http::FilterTrailersStatus onTrailers();
+
+protected:
+  // Passes on decompressed data outside of the filter callbacks.
+  virtual void injectData(Buffer::Instance& data, bool end_stream) PURE;
+  // Passes on the trailers held back.
+  virtual void continueIteration() PURE;
+  virtual uint32_t bufferLimit() PURE;
+  virtual void onAboveWriteBufferHighWatermark() PURE;
+  virtual void onBelowWriteBufferLowWatermark() PURE;
+  // Called once when the body cannot be decompressed.
+  virtual void onFailure(BodyDecompressor::Result result) PURE;
+
+private:
+  void drain();
+  void fail(BodyDecompressor::Result result);
+
+  BodyDecompressor decompressor_;
+  Event::Dispatcher& dispatcher_;
+  Event::TimerPtr drain_timer_;
+  // The data decompressed by the last step, which is passed on by the next drain().
+  Buffer::OwnedImpl output_;
+  bool draining_{};
+  bool end_stream_{};
+  bool trailers_held_{};
+  // Set once the body could not be decompressed, after which the rest of it is dropped.
+  bool failed_{};
+};
+using StreamDecompressorPtr = std::unique_ptr<StreamDecompressor>;
+
+/**
+ * A filter that decompresses gzip encoded request bodies, and optionally response bodies for
+ * clients which do not accept gzip. Bodies are decompressed incrementally as they stream through
+ * the filter, and the decompressed data is bounded by the buffer limits of the stream.
+ */
+class DecompressorFilter : public Http::StreamFilter {
+public:
+  DecompressorFilter(const DecompressorFilterConfigSharedPtr& config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override;
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override;
+  Http::FilterMetadataStatus encodeMetadata(Http::MetadataMap&) override {
+    return Http::FilterMetadataStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  // Whether the body is gzip encoded, and does not have any other content-coding applied.
+  static bool isGzipEncoded(const Http::HeaderMap& headers);
+  // Whether the request accepts a gzip encoded response.
+  static bool acceptsGzip(const Http::HeaderMap& headers);
+  // Whether an accept-encoding element does not have a q-value of zero.
+  static bool isAcceptable(absl::string_view element);
+  // Prepares the headers of a body which will be decompressed.
+  static void removeEncodingHeaders(Http::HeaderMap& headers);
+
+  DecompressorFilterConfigSharedPtr config_;
+  StreamDecompressorPtr request_decompressor_;
+  StreamDecompressorPtr response_decompressor_;
+  bool enabled_{};
+  bool accepts_gzip_{};
+
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
+};
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
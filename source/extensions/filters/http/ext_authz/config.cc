@@ -8,6 +8,7 @@
 
 #include "common/protobuf/utility.h"
 
+#include "extensions/filters/common/ext_authz/ext_authz_cache_impl.h"
 #include "extensions/filters/common/ext_authz/ext_authz_grpc_impl.h"
 #include "extensions/filters/common/ext_authz/ext_authz_http_impl.h"
 #include "extensions/filters/http/ext_authz/ext_authz.h"
@@ -17,11 +18,35 @@ namespace Extensions {
 namespace HttpFilters {
 namespace ExtAuthz {
 
+namespace {
+
+// Wraps the client of a filter with the decision cache, if there is one.
+Filters::Common::ExtAuthz::ClientPtr
+cachingClient(Filters::Common::ExtAuthz::ClientPtr&& client,
+              const Filters::Common::ExtAuthz::DecisionCacheConfigSharedPtr& cache_config) {
+  if (cache_config == nullptr) {
+    return std::move(client);
+  }
+  return std::make_unique<Filters::Common::ExtAuthz::CachingClientImpl>(std::move(client),
+                                                                        cache_config);
+}
+
+} // namespace
+
 Http::FilterFactoryCb ExtAuthzFilterConfig::createFilterFactoryFromProtoTyped(
-    const envoy::config::filter::http::ext_authz::v2::ExtAuthz& proto_config, const std::string&,
-    Server::Configuration::FactoryContext& context) {
+    const envoy::config::filter::http::ext_authz::v2::ExtAuthz& proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
   const auto filter_config = std::make_shared<FilterConfig>(
       proto_config, context.localInfo(), context.scope(), context.runtime(), context.httpContext());
+  Filters::Common::ExtAuthz::DecisionCacheConfigSharedPtr cache_config;
+  if (proto_config.has_decision_cache()) {
+    if (proto_config.has_with_request_body()) {
+      throw EnvoyException("ext_authz: decision_cache can not be used with with_request_body");
+    }
+    cache_config = std::make_shared<Filters::Common::ExtAuthz::DecisionCacheConfig>(
+        proto_config.decision_cache(), context.threadLocal(), context.timeSource(), stats_prefix,
+        context.scope());
+  }
   Http::FilterFactoryCb callback;
 
   if (proto_config.has_http_service()) {
@@ -31,27 +56,30 @@ Http::FilterFactoryCb ExtAuthzFilterConfig::createFilterFactoryFromProtoTyped(
     const auto client_config =
         std::make_shared<Extensions::Filters::Common::ExtAuthz::ClientConfig>(
             proto_config, timeout_ms, proto_config.http_service().path_prefix());
-    callback = [filter_config, client_config,
+    callback = [filter_config, client_config, cache_config,
                 &context](Http::FilterChainFactoryCallbacks& callbacks) {
-      auto client = std::make_unique<Extensions::Filters::Common::ExtAuthz::RawHttpClientImpl>(
-          context.clusterManager(), client_config, context.timeSource());
-      callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{
-          std::make_shared<Filter>(filter_config, std::move(client))});
+      Filters::Common::ExtAuthz::ClientPtr client =
+          std::make_unique<Extensions::Filters::Common::ExtAuthz::RawHttpClientImpl>(
+              context.clusterManager(), client_config, context.timeSource());
+      callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{std::make_shared<Filter>(
+          filter_config, cachingClient(std::move(client), cache_config))});
     };
   } else {
     // gRPC client.
     const uint32_t timeout_ms =
         PROTOBUF_GET_MS_OR_DEFAULT(proto_config.grpc_service(), timeout, DefaultTimeout);
-    callback = [grpc_service = proto_config.grpc_service(), &context, filter_config, timeout_ms,
+    callback = [grpc_service = proto_config.grpc_service(), &context, filter_config, cache_config,
+                timeout_ms,
                 use_alpha =
                     proto_config.use_alpha()](Http::FilterChainFactoryCallbacks& callbacks) {
       const auto async_client_factory =
           context.clusterManager().grpcAsyncClientManager().factoryForGrpcService(
               grpc_service, context.scope(), true);
-      auto client = std::make_unique<Filters::Common::ExtAuthz::GrpcClientImpl>(
-          async_client_factory->create(), std::chrono::milliseconds(timeout_ms), use_alpha);
-      callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{
-          std::make_shared<Filter>(filter_config, std::move(client))});
+      Filters::Common::ExtAuthz::ClientPtr client =
+          std::make_unique<Filters::Common::ExtAuthz::GrpcClientImpl>(
+              async_client_factory->create(), std::chrono::milliseconds(timeout_ms), use_alpha);
+      callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{std::make_shared<Filter>(
+          filter_config, cachingClient(std::move(client), cache_config))});
     };
   }
 
@@ -1,16 +1,19 @@
 #include "extensions/filters/http/grpc_json_transcoder/json_transcoder_filter.h"
 
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "envoy/common/exception.h"
 #include "envoy/http/filter.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/buffer/zero_copy_output_stream_impl.h"
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/grpc/common.h"
+#include "common/http/codes.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
 #include "common/protobuf/protobuf.h"
@@ -19,9 +22,8 @@
 #include "google/api/annotations.pb.h"
 #include "google/api/http.pb.h"
 #include "google/api/httpbody.pb.h"
-#include "grpc_transcoding/json_request_translator.h"
+#include "google/protobuf/type.pb.h"
 #include "grpc_transcoding/path_matcher_utility.h"
-#include "grpc_transcoding/response_to_json_translator.h"
 
 using Envoy::Protobuf::FileDescriptorSet;
 using Envoy::Protobuf::io::ZeroCopyInputStream;
@@ -32,9 +34,6 @@ using google::grpc::transcoding::JsonRequestTranslator;
 using google::grpc::transcoding::PathMatcherBuilder;
 using google::grpc::transcoding::PathMatcherUtility;
 using google::grpc::transcoding::RequestInfo;
-using google::grpc::transcoding::ResponseToJsonTranslator;
-using google::grpc::transcoding::Transcoder;
-using google::grpc::transcoding::TranscoderInputStream;
 
 namespace Envoy {
 namespace Extensions {
@@ -48,6 +47,8 @@ struct RcDetailsValues {
   // The gRPC json transcoder filter failed to transcode when processing the request body.
   // This will generally be accompanied by details about the transcoder failure.
   const std::string GrpcTranscodeFailed = "grpc_json_transcode_failure";
+  // The JSON of a request message exceeded the buffer limit before it could be transcoded.
+  const std::string GrpcTranscodeRequestTooLarge = "grpc_json_transcode_request_too_large";
 };
 using RcDetails = ConstSingleton<RcDetailsValues>;
 
@@ -57,37 +58,73 @@ const Http::LowerCaseString& trailerHeader() {
   CONSTRUCT_ON_FIRST_USE(Http::LowerCaseString, "trailer");
 }
 
-// Transcoder:
-// https://github.com/grpc-ecosystem/grpc-httpjson-transcoding/blob/master/src/include/grpc_transcoding/transcoder.h
-// implementation based on JsonRequestTranslator & ResponseToJsonTranslator
-class TranscoderImpl : public Transcoder {
+// A TypeResolver which resolves the types reachable from the methods of the configured services
+// from a cache filled when the configuration is loaded. The JSON translators resolve the types
+// they print or parse on every request, which otherwise converts the descriptors of the types each
+// time. Other types, such as the details of a google.rpc.Status, are resolved from the descriptor
+// pool. The cache is not modified once the configuration is loaded, so it is shared by the workers.
+class CachingTypeResolver : public Protobuf::util::TypeResolver {
 public:
+  CachingTypeResolver(Protobuf::util::TypeResolver* resolver) : resolver_(resolver) {}
+
   /**
-   * Construct a transcoder implementation
-   * @param request_translator a JsonRequestTranslator that does the request translation
-   * @param response_translator a ResponseToJsonTranslator that does the response translation
+   * Cache a message type and the types of its fields, recursively.
    */
-  TranscoderImpl(std::unique_ptr<JsonRequestTranslator> request_translator,
-                 std::unique_ptr<ResponseToJsonTranslator> response_translator)
-      : request_translator_(std::move(request_translator)),
-        response_translator_(std::move(response_translator)),
-        request_stream_(request_translator_->Output().CreateInputStream()),
-        response_stream_(response_translator_->CreateInputStream()) {}
+  void addMessageType(const Protobuf::Descriptor& descriptor) {
+    const std::string type_url = Grpc::Common::typeUrl(descriptor.full_name());
+    if (message_types_.find(type_url) != message_types_.end()) {
+      return;
+    }
+    if (!resolver_->ResolveMessageType(type_url, &message_types_[type_url]).ok()) {
+      message_types_.erase(type_url);
+      return;
+    }
+    for (int i = 0; i < descriptor.field_count(); ++i) {
+      const Protobuf::FieldDescriptor* field = descriptor.field(i);
+      if (field->message_type() != nullptr) {
+        addMessageType(*field->message_type());
+      } else if (field->enum_type() != nullptr) {
+        addEnumType(*field->enum_type());
+      }
+    }
+  }
 
-  // Transcoder
-  ::google::grpc::transcoding::TranscoderInputStream* RequestOutput() override {
-    return request_stream_.get();
+  const std::unordered_map<std::string, ProtobufWkt::Type>& messageTypes() const {
+    return message_types_;
   }
-  ProtobufUtil::Status RequestStatus() override { return request_translator_->Output().Status(); }
 
-  ZeroCopyInputStream* ResponseOutput() override { return response_stream_.get(); }
-  ProtobufUtil::Status ResponseStatus() override { return response_translator_->Status(); }
+  // Protobuf::util::TypeResolver
+  Status ResolveMessageType(const std::string& type_url, ProtobufWkt::Type* type) override {
+    const auto it = message_types_.find(type_url);
+    if (it == message_types_.end()) {
+      return resolver_->ResolveMessageType(type_url, type);
+    }
+    *type = it->second;
+    return Status();
+  }
+  Status ResolveEnumType(const std::string& type_url, ProtobufWkt::Enum* enum_type) override {
+    const auto it = enum_types_.find(type_url);
+    if (it == enum_types_.end()) {
+      return resolver_->ResolveEnumType(type_url, enum_type);
+    }
+    *enum_type = it->second;
+    return Status();
+  }
 
 private:
-  std::unique_ptr<JsonRequestTranslator> request_translator_;
-  std::unique_ptr<ResponseToJsonTranslator> response_translator_;
-  std::unique_ptr<TranscoderInputStream> request_stream_;
-  std::unique_ptr<TranscoderInputStream> response_stream_;
+  void addEnumType(const Protobuf::EnumDescriptor& descriptor) {
+    const std::string type_url = Grpc::Common::typeUrl(descriptor.full_name());
+    if (enum_types_.find(type_url) != enum_types_.end()) {
+      return;
+    }
+    if (!resolver_->ResolveEnumType(type_url, &enum_types_[type_url]).ok()) {
+      enum_types_.erase(type_url);
+    }
+  }
+
+  std::unique_ptr<Protobuf::util::TypeResolver> resolver_;
+  std::unordered_map<std::string, ProtobufWkt::Type> message_types_;
+  std::unordered_map<std::string, ProtobufWkt::Enum> enum_types_;
 };
 
 } // namespace
@@ -123,7 +160,12 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     addBuiltinSymbolDescriptor("google.rpc.Status");
   }
 
-  PathMatcherBuilder<const Protobuf::MethodDescriptor*> pmb;
+  auto type_resolver =
+      std::make_unique<CachingTypeResolver>(Protobuf::util::NewTypeResolverForDescriptorPool(
+          Grpc::Common::typeUrlPrefix(), &descriptor_pool_));
+  std::vector<MethodInfoSharedPtr> method_infos;
+
+  PathMatcherBuilder<MethodInfoSharedPtr> pmb;
   std::unordered_set<std::string> ignored_query_parameters;
   for (const auto& query_param : proto_config.ignored_query_parameters()) {
     ignored_query_parameters.insert(query_param);
@@ -138,6 +180,15 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     for (int i = 0; i < service->method_count(); ++i) {
       auto method = service->method(i);
 
+      auto method_info = std::make_shared<MethodInfo>();
+      method_info->descriptor_ = method;
+      method_info->response_type_url_ = Grpc::Common::typeUrl(method->output_type()->full_name());
+      method_info->response_type_is_http_body_ =
+          method->output_type()->full_name() == google::api::HttpBody::descriptor()->full_name();
+      type_resolver->addMessageType(*method->input_type());
+      type_resolver->addMessageType(*method->output_type());
+      method_infos.push_back(method_info);
+
       HttpRule http_rule;
       if (method->options().HasExtension(google::api::http)) {
         http_rule = method->options().GetExtension(google::api::http);
@@ -148,7 +199,7 @@ JsonTranscoderConfig::JsonTranscoderConfig(
       }
 
       if (!PathMatcherUtility::RegisterByHttpRule(pmb, http_rule, ignored_query_parameters,
-                                                  method)) {
+                                                  method_info)) {
         throw EnvoyException("transcoding_filter: Cannot register '" + method->full_name() +
                              "' to path matcher");
       }
@@ -157,9 +208,21 @@ JsonTranscoderConfig::JsonTranscoderConfig(
 
   path_matcher_ = pmb.Build();
 
-  type_helper_ = std::make_unique<google::grpc::transcoding::TypeHelper>(
-      Protobuf::util::NewTypeResolverForDescriptorPool(Grpc::Common::typeUrlPrefix(),
-                                                       &descriptor_pool_));
+  // The type helper takes ownership of the resolver, whose cache is complete by now.
+  const CachingTypeResolver& cached_types = *type_resolver;
+  type_helper_ = std::make_unique<google::grpc::transcoding::TypeHelper>(type_resolver.release());
+
+  // The type info caches the types it resolves, along with the indexes of their fields, as they
+  // are first looked up. Look up the cached types now, so that it is only read by the workers.
+  for (const auto& type : cached_types.messageTypes()) {
+    const ProtobufWkt::Type* resolved = type_helper_->Info()->GetTypeByTypeUrl(type.first);
+    if (resolved != nullptr) {
+      type_helper_->Info()->FindField(resolved, "");
+    }
+  }
+  for (auto& method_info : method_infos) {
+    resolveRequestType(*method_info);
+  }
 
   const auto& print_config = proto_config.print_options();
   print_options_.add_whitespace = print_config.add_whitespace();
@@ -169,6 +232,9 @@ JsonTranscoderConfig::JsonTranscoderConfig(
 
   match_incoming_request_route_ = proto_config.match_incoming_request_route();
   ignore_unknown_query_parameters_ = proto_config.ignore_unknown_query_parameters();
+  max_request_body_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, max_request_body_size, 0);
+  max_response_body_size_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, max_response_body_size, 0);
 }
 
 void JsonTranscoderConfig::addFileDescriptor(const Protobuf::FileDescriptorProto& file) {
@@ -199,10 +265,10 @@ bool JsonTranscoderConfig::matchIncomingRequestInfo() const {
 
 bool JsonTranscoderConfig::convertGrpcStatus() const { return convert_grpc_status_; }
 
-ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
-    const Http::HeaderMap& headers, ZeroCopyInputStream& request_input,
-    google::grpc::transcoding::TranscoderInputStream& response_input,
-    std::unique_ptr<Transcoder>& transcoder, const Protobuf::MethodDescriptor*& method_descriptor) {
+ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(const Http::HeaderMap& headers,
+                                                            ZeroCopyInputStream& request_input,
+                                                            RequestTranscoderPtr& transcoder,
+                                                            MethodInfoSharedPtr& method_info) {
   if (Grpc::Common::hasGrpcContentType(headers)) {
     return ProtobufUtil::Status(Code::INVALID_ARGUMENT,
                                 "Request headers has application/grpc content-type");
@@ -219,20 +285,22 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 
   struct RequestInfo request_info;
   std::vector<VariableBinding> variable_bindings;
-  method_descriptor =
+  method_info =
       path_matcher_->Lookup(method, path, args, &variable_bindings, &request_info.body_field_path);
-  if (!method_descriptor) {
+  if (!method_info) {
     return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve " + path + " to a method");
   }
 
-  auto status = methodToRequestInfo(method_descriptor, &request_info);
-  if (!status.ok()) {
-    return status;
+  request_info.message_type = method_info->request_type_;
+  if (request_info.message_type == nullptr) {
+    return ProtobufUtil::Status(Code::NOT_FOUND,
+                                "Could not resolve type: " +
+                                    method_info->descriptor_->input_type()->full_name());
   }
 
   for (const auto& binding : variable_bindings) {
     google::grpc::transcoding::RequestWeaver::BindingInfo resolved_binding;
-    status = type_helper_->ResolveFieldPath(*request_info.message_type, binding.field_path,
+    auto status = type_helper_->ResolveFieldPath(*request_info.message_type, binding.field_path,
                                             &resolved_binding.field_path);
     if (!status.ok()) {
       if (ignore_unknown_query_parameters_) {
@@ -248,31 +316,19 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 
   std::unique_ptr<JsonRequestTranslator> request_translator{
       new JsonRequestTranslator(type_helper_->Resolver(), &request_input, request_info,
-                                method_descriptor->client_streaming(), true)};
-
-  const auto response_type_url =
-      Grpc::Common::typeUrl(method_descriptor->output_type()->full_name());
-  std::unique_ptr<ResponseToJsonTranslator> response_translator{new ResponseToJsonTranslator(
-      type_helper_->Resolver(), response_type_url, method_descriptor->server_streaming(),
-      &response_input, print_options_)};
+                                method_info->descriptor_->client_streaming(), true)};
 
-  transcoder = std::make_unique<TranscoderImpl>(std::move(request_translator),
-                                                std::move(response_translator));
+  transcoder = std::make_unique<RequestTranscoder>(std::move(request_translator));
   return ProtobufUtil::Status();
 }
 
-ProtobufUtil::Status
-JsonTranscoderConfig::methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                          google::grpc::transcoding::RequestInfo* info) {
-  auto request_type_url = Grpc::Common::typeUrl(method->input_type()->full_name());
-  info->message_type = type_helper_->Info()->GetTypeByTypeUrl(request_type_url);
-  if (info->message_type == nullptr) {
-    ENVOY_LOG(debug, "Cannot resolve input-type: {}", method->input_type()->full_name());
-    return ProtobufUtil::Status(Code::NOT_FOUND,
-                                "Could not resolve type: " + method->input_type()->full_name());
+void JsonTranscoderConfig::resolveRequestType(MethodInfo& method_info) {
+  const auto* input_type = method_info.descriptor_->input_type();
+  method_info.request_type_ =
+      type_helper_->Info()->GetTypeByTypeUrl(Grpc::Common::typeUrl(input_type->full_name()));
+  if (method_info.request_type_ == nullptr) {
+    ENVOY_LOG(debug, "Cannot resolve input-type: {}", input_type->full_name());
   }
-
-  return ProtobufUtil::Status();
 }
 
 ProtobufUtil::Status
@@ -283,24 +339,34 @@ JsonTranscoderConfig::translateProtoMessageToJson(const Protobuf::Message& messa
       message.SerializeAsString(), json_out, print_options_);
 }
 
+ProtobufUtil::Status JsonTranscoderConfig::translateResponseMessage(const MethodInfo& method_info,
+                                                                    Buffer::InstancePtr&& message,
+                                                                    Buffer::Instance& json_out) {
+  Buffer::ZeroCopyInputStreamImpl message_stream(std::move(message));
+  Buffer::ZeroCopyOutputStreamImpl json_stream(json_out);
+  return ProtobufUtil::BinaryToJsonStream(type_helper_->Resolver(), method_info.response_type_url_,
+                                          &message_stream, &json_stream, print_options_);
+}
+
 JsonTranscoderFilter::JsonTranscoderFilter(JsonTranscoderConfig& config) : config_(config) {}
 
 Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& headers,
                                                               bool end_stream) {
-  const auto status =
-      config_.createTranscoder(headers, request_in_, response_in_, transcoder_, method_);
+  const auto status = config_.createTranscoder(headers, request_in_, transcoder_, method_);
 
   if (!status.ok()) {
     // If transcoder couldn't be created, it might be a normal gRPC request, so the filter will
     // just pass-through the request to upstream.
     return Http::FilterHeadersStatus::Continue;
   }
-  has_http_body_output_ = !method_->server_streaming() && hasHttpBodyAsOutputType();
+  has_http_body_output_ =
+      !method_->descriptor_->server_streaming() && method_->response_type_is_http_body_;
 
   headers.removeContentLength();
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Grpc);
   headers.insertEnvoyOriginalPath().value(*headers.Path());
-  headers.insertPath().value("/" + method_->service()->full_name() + "/" + method_->name());
+  headers.insertPath().value("/" + method_->descriptor_->service()->full_name() + "/" +
+                             method_->descriptor_->name());
   headers.insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
   headers.insertTE().value().setReference(Http::Headers::get().TEValues.Trailers);
 
@@ -311,7 +377,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& h
   if (end_stream) {
     request_in_.finish();
 
-    const auto& request_status = transcoder_->RequestStatus();
+    const auto& request_status = transcoder_->status();
     if (!request_status.ok()) {
       ENVOY_LOG(debug, "Transcoding request error {}", request_status.ToString());
       error_ = true;
@@ -327,7 +393,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& h
     }
 
     Buffer::OwnedImpl data;
-    readToBuffer(*transcoder_->RequestOutput(), data);
+    readToBuffer(transcoder_->output(), data);
 
     if (data.length() > 0) {
       decoder_callbacks_->addDecodedData(data, true);
@@ -343,15 +409,16 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
     return Http::FilterDataStatus::Continue;
   }
 
+  const uint64_t received = data.length();
   request_in_.move(data);
 
   if (end_stream) {
     request_in_.finish();
   }
 
-  readToBuffer(*transcoder_->RequestOutput(), data);
+  readToBuffer(transcoder_->output(), data);
 
-  const auto& request_status = transcoder_->RequestStatus();
+  const auto& request_status = transcoder_->status();
 
   if (!request_status.ok()) {
     ENVOY_LOG(debug, "Transcoding request error {}", request_status.ToString());
@@ -366,6 +433,21 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
 
     return Http::FilterDataStatus::StopIterationNoBuffer;
   }
+
+  // The request translator holds the JSON of a message until the message is complete. It is not
+  // bounded by the buffer limit, which request messages routinely exceed, but by its own limit.
+  request_bytes_pending_ = data.length() > 0 ? 0 : request_bytes_pending_ + received;
+  const uint32_t limit = config_.maxRequestBodySize();
+  if (limit > 0 && request_bytes_pending_ > limit) {
+    ENVOY_LOG(debug, "Transcoding request error: request message exceeds limit {}", limit);
+    error_ = true;
+    decoder_callbacks_->sendLocalReply(Http::Code::PayloadTooLarge,
+                                       Http::CodeUtility::toString(Http::Code::PayloadTooLarge),
+                                       nullptr, absl::nullopt,
+                                       RcDetails::get().GrpcTranscodeRequestTooLarge);
+
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
   return Http::FilterDataStatus::Continue;
 }
 
@@ -379,7 +461,7 @@ Http::FilterTrailersStatus JsonTranscoderFilter::decodeTrailers(Http::HeaderMap&
   request_in_.finish();
 
   Buffer::OwnedImpl data;
-  readToBuffer(*transcoder_->RequestOutput(), data);
+  readToBuffer(transcoder_->output(), data);
 
   if (data.length()) {
     decoder_callbacks_->addDecodedData(data, true);
@@ -406,7 +488,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::encodeHeaders(Http::HeaderMap& h
 
   if (end_stream) {
 
-    if (method_->server_streaming()) {
+    if (method_->descriptor_->server_streaming()) {
       // When there is no body in a streaming response, a empty JSON array is
       // returned by default. Set the content type correctly.
       headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Json);
@@ -420,7 +502,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::encodeHeaders(Http::HeaderMap& h
   }
 
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Json);
-  if (!method_->server_streaming()) {
+  if (!method_->descriptor_->server_streaming()) {
     return Http::FilterHeadersStatus::StopIteration;
   }
 
@@ -440,19 +522,18 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
 
-  response_in_.move(data);
+  if (!translateResponse(data)) {
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
 
   if (end_stream) {
-    response_in_.finish();
+    finishResponse(data);
   }
 
-  readToBuffer(*transcoder_->ResponseOutput(), data);
-
-  if (!method_->server_streaming() && !end_stream) {
+  if (!method_->descriptor_->server_streaming() && !end_stream) {
     // Buffer until the response is complete.
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
-  // TODO(lizan): Check ResponseStatus
 
   return Http::FilterDataStatus::Continue;
 }
@@ -462,8 +543,6 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
     return Http::FilterTrailersStatus::Continue;
   }
 
-  response_in_.finish();
-
   const absl::optional<Grpc::Status::GrpcStatus> grpc_status =
       Grpc::Common::getGrpcStatus(trailers);
   if (grpc_status && maybeConvertGrpcStatus(*grpc_status, trailers)) {
@@ -471,13 +550,13 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
   }
 
   Buffer::OwnedImpl data;
-  readToBuffer(*transcoder_->ResponseOutput(), data);
+  finishResponse(data);
 
   if (data.length()) {
     encoder_callbacks_->addEncodedData(data, true);
   }
 
-  if (method_->server_streaming()) {
+  if (method_->descriptor_->server_streaming()) {
     // For streaming case, the headers are already sent, so just continue here.
     return Http::FilterTrailersStatus::Continue;
   }
@@ -518,7 +597,6 @@ void JsonTranscoderFilter::setEncoderFilterCallbacks(
   encoder_callbacks_ = &callbacks;
 }
 
-// TODO(lizan): Incorporate watermarks to bound buffer sizes
 bool JsonTranscoderFilter::readToBuffer(Protobuf::io::ZeroCopyInputStream& stream,
                                         Buffer::Instance& data) {
   const void* out;
@@ -533,6 +611,62 @@ bool JsonTranscoderFilter::readToBuffer(Protobuf::io::ZeroCopyInputStream& strea
   return false;
 }
 
+bool JsonTranscoderFilter::translateResponse(Buffer::Instance& data) {
+  std::vector<Grpc::Frame> frames;
+  if (response_error_ || !decoder_.decode(data, frames)) {
+    if (!response_error_) {
+      ENVOY_LOG(debug, "Transcoding response error: invalid gRPC frame");
+      response_error_ = true;
+    }
+    data.drain(data.length());
+    return true;
+  }
+
+  // A message is translated once it is complete, so the message being decoded is bounded by the
+  // response limit. The length decoded so far is a lower bound of the length in the frame header,
+  // so a message over the limit is rejected before its data arrives.
+  const uint32_t limit = config_.maxResponseBodySize();
+  if (limit > 0 && decoder_.length() > limit) {
+    ENVOY_LOG(debug, "Transcoding response error: response message exceeds limit {}", limit);
+    error_ = true;
+    encoder_callbacks_->resetStream();
+    return false;
+  }
+
+  // Each message is printed to the response as it is decoded. The messages of a server streaming
+  // method are the elements of a JSON array, which is written incrementally.
+  const bool streaming = method_->descriptor_->server_streaming();
+  for (auto& frame : frames) {
+    if (streaming) {
+      data.add(response_messages_ == 0 ? "[" : ",");
+    }
+    response_messages_++;
+
+    Buffer::InstancePtr message =
+        frame.data_ ? std::move(frame.data_) : std::make_unique<Buffer::OwnedImpl>();
+    const auto status = config_.translateResponseMessage(*method_, std::move(message), data);
+    if (!status.ok()) {
+      ENVOY_LOG(debug, "Transcoding response error {}", status.ToString());
+      response_error_ = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+void JsonTranscoderFilter::finishResponse(Buffer::Instance& data) {
+  if (response_error_) {
+    return;
+  }
+  if (decoder_.hasBufferedData()) {
+    ENVOY_LOG(debug, "Transcoding response error: incomplete gRPC frame");
+    return;
+  }
+  if (method_->descriptor_->server_streaming()) {
+    data.add(response_messages_ == 0 ? "[]" : "]");
+  }
+}
+
 void JsonTranscoderFilter::buildResponseFromHttpBodyOutput(Http::HeaderMap& response_headers,
                                                            Buffer::Instance& data) {
   std::vector<Grpc::Frame> frames;
@@ -619,10 +753,6 @@ bool JsonTranscoderFilter::maybeConvertGrpcStatus(Grpc::Status::GrpcStatus grpc_
   return true;
 }
 
-bool JsonTranscoderFilter::hasHttpBodyAsOutputType() {
-  return method_->output_type()->full_name() == google::api::HttpBody::descriptor()->full_name();
-}
-
 } // namespace GrpcJsonTranscoder
 } // namespace HttpFilters
 } // namespace Extensions
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "envoy/api/api.h"
 #include "envoy/buffer/buffer.h"
 #include "envoy/config/filter/http/transcoder/v2/transcoder.pb.h"
@@ -13,9 +15,10 @@
 
 #include "extensions/filters/http/grpc_json_transcoder/transcoder_input_stream_impl.h"
 
+#include "grpc_transcoding/json_request_translator.h"
 #include "grpc_transcoding/path_matcher.h"
 #include "grpc_transcoding/request_message_translator.h"
-#include "grpc_transcoding/transcoder.h"
+#include "grpc_transcoding/transcoder_input_stream.h"
 #include "grpc_transcoding/type_helper.h"
 
 namespace Envoy {
@@ -40,6 +43,47 @@ struct VariableBinding {
   std::string value;
 };
 
+/**
+ * A method of the configured services, along with what transcoding it needs resolved once when the
+ * configuration is loaded rather than on every request.
+ */
+struct MethodInfo {
+  const Protobuf::MethodDescriptor* descriptor_ = nullptr;
+  // The type of the request message, used to resolve the variable bindings of the request.
+  const ProtobufWkt::Type* request_type_ = nullptr;
+  std::string response_type_url_;
+  bool response_type_is_http_body_ = false;
+};
+using MethodInfoSharedPtr = std::shared_ptr<MethodInfo>;
+
+/**
+ * Translates the JSON request body of a method into gRPC messages. Responses are translated by the
+ * filter one gRPC message at a time, with JsonTranscoderConfig::translateResponseMessage().
+ */
+class RequestTranscoder {
+public:
+  RequestTranscoder(
+      std::unique_ptr<google::grpc::transcoding::JsonRequestTranslator> request_translator)
+      : request_translator_(std::move(request_translator)),
+        output_(request_translator_->Output().CreateInputStream()) {}
+
+  /**
+   * @return the stream of the gRPC frames of the request messages translated so far.
+   */
+  google::grpc::transcoding::TranscoderInputStream& output() { return *output_; }
+
+  /**
+   * @return the status of the translation, which is an error once the request body is invalid.
+   */
+  ProtobufUtil::Status status() { return request_translator_->Output().Status(); }
+
+private:
+  std::unique_ptr<google::grpc::transcoding::JsonRequestTranslator> request_translator_;
+  std::unique_ptr<google::grpc::transcoding::TranscoderInputStream> output_;
+};
+
+using RequestTranscoderPtr = std::unique_ptr<RequestTranscoder>;
+
 /**
  * Global configuration for the gRPC JSON transcoder filter. Factory for the Transcoder interface.
  */
@@ -54,19 +98,28 @@ public:
       Api::Api& api);
 
   /**
-   * Create an instance of Transcoder interface based on incoming request
+   * Create a RequestTranscoder based on incoming request
    * @param headers headers received from decoder
    * @param request_input a ZeroCopyInputStream reading from downstream request body
-   * @param response_input a TranscoderInputStream reading from upstream response body
-   * @param transcoder output parameter for the instance of Transcoder interface
-   * @param method_descriptor output parameter for the method looked up from config
-   * @return status whether the Transcoder instance are successfully created or not
+   * @param transcoder output parameter for the RequestTranscoder of the request
+   * @param method_info output parameter for the method looked up from config
+   * @return status whether the RequestTranscoder is successfully created or not
+   */
+  ProtobufUtil::Status createTranscoder(const Http::HeaderMap& headers,
+                                        Protobuf::io::ZeroCopyInputStream& request_input,
+                                        RequestTranscoderPtr& transcoder,
+                                        MethodInfoSharedPtr& method_info);
+
+  /**
+   * Converts a response message of a method to JSON, which is appended to a buffer as it is
+   * printed rather than through an intermediate string.
+   * @param method_info supplies the method.
+   * @param message supplies the serialized response message.
+   * @param json_out supplies the buffer to append the JSON to.
    */
-  ProtobufUtil::Status
-  createTranscoder(const Http::HeaderMap& headers, Protobuf::io::ZeroCopyInputStream& request_input,
-                   google::grpc::transcoding::TranscoderInputStream& response_input,
-                   std::unique_ptr<google::grpc::transcoding::Transcoder>& transcoder,
-                   const Protobuf::MethodDescriptor*& method_descriptor);
+  ProtobufUtil::Status translateResponseMessage(const MethodInfo& method_info,
+                                                Buffer::InstancePtr&& message,
+                                                Buffer::Instance& json_out);
 
   /**
    * Converts an arbitrary protobuf message to JSON.
@@ -87,25 +140,36 @@ public:
    */
   bool convertGrpcStatus() const;
 
-private:
   /**
-   * Convert method descriptor to RequestInfo that needed for transcoding library
+   * @return the maximum size of the JSON of a request message held by the filter, or 0 if it is
+   *         not limited.
+   */
+  uint32_t maxRequestBodySize() const { return max_request_body_size_; }
+
+  /**
+   * @return the maximum size of a response message held by the filter, or 0 if it is not limited.
    */
-  ProtobufUtil::Status methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                           google::grpc::transcoding::RequestInfo* info);
+  uint32_t maxResponseBodySize() const { return max_response_body_size_; }
 
 private:
+  /**
+   * Resolve the request type of a method, once the type helper is created.
+   */
+  void resolveRequestType(MethodInfo& method_info);
+
   void addFileDescriptor(const Protobuf::FileDescriptorProto& file);
   void addBuiltinSymbolDescriptor(const std::string& symbol_name);
 
   Protobuf::DescriptorPool descriptor_pool_;
-  google::grpc::transcoding::PathMatcherPtr<const Protobuf::MethodDescriptor*> path_matcher_;
+  google::grpc::transcoding::PathMatcherPtr<MethodInfoSharedPtr> path_matcher_;
   std::unique_ptr<google::grpc::transcoding::TypeHelper> type_helper_;
   Protobuf::util::JsonPrintOptions print_options_;
 
   bool match_incoming_request_route_{false};
   bool ignore_unknown_query_parameters_{false};
   bool convert_grpc_status_{false};
+  uint32_t max_request_body_size_{0};
+  uint32_t max_response_body_size_{0};
 };
 
 using JsonTranscoderConfigSharedPtr = std::shared_ptr<JsonTranscoderConfig>;
@@ -140,21 +204,25 @@ public:
 
 private:
   bool readToBuffer(Protobuf::io::ZeroCopyInputStream& stream, Buffer::Instance& data);
+  bool translateResponse(Buffer::Instance& data);
+  void finishResponse(Buffer::Instance& data);
   void buildResponseFromHttpBodyOutput(Http::HeaderMap& response_headers, Buffer::Instance& data);
   bool maybeConvertGrpcStatus(Grpc::Status::GrpcStatus grpc_status, Http::HeaderMap& trailers);
-  bool hasHttpBodyAsOutputType();
 
   JsonTranscoderConfig& config_;
-  std::unique_ptr<google::grpc::transcoding::Transcoder> transcoder_;
+  RequestTranscoderPtr transcoder_;
   TranscoderInputStreamImpl request_in_;
-  TranscoderInputStreamImpl response_in_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{nullptr};
-  const Protobuf::MethodDescriptor* method_{nullptr};
+  MethodInfoSharedPtr method_;
   Http::HeaderMap* response_headers_{nullptr};
   Grpc::Decoder decoder_;
+  // The bytes of the request body received since the request translator last output a message.
+  uint64_t request_bytes_pending_{0};
+  uint64_t response_messages_{0};
 
   bool error_{false};
+  bool response_error_{false};
   bool has_http_body_output_{false};
   bool has_body_{false};
 };
@@ -16,8 +16,14 @@ Http::FilterFactoryCb IpTaggingFilterFactory::createFilterFactoryFromProtoTyped(
     const envoy::config::filter::http::ip_tagging::v2::IPTagging& proto_config,
     const std::string& stat_prefix, Server::Configuration::FactoryContext& context) {
 
-  IpTaggingFilterConfigSharedPtr config(
-      new IpTaggingFilterConfig(proto_config, stat_prefix, context.scope(), context.runtime()));
+  IpTagFileProviderPtr tag_file;
+  if (!proto_config.ip_tags_path().empty()) {
+    tag_file = std::make_unique<IpTagFileProvider>(proto_config.ip_tags_path(),
+                                                   stat_prefix + "ip_tagging.", context.scope(),
+                                                   context.dispatcher(), context.threadLocal());
+  }
+  IpTaggingFilterConfigSharedPtr config(new IpTaggingFilterConfig(
+      proto_config, stat_prefix, context.scope(), context.runtime(), std::move(tag_file)));
 
   return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamDecoderFilter(std::make_shared<IpTaggingFilter>(config));
@@ -0,0 +1,552 @@
+#include "extensions/filters/http/ip_tagging/ip_tag_file.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <limits>
+
+#include "envoy/common/exception.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/assert.h"
+#include "common/network/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace IpTagging {
+
+namespace {
+
+// "IPTAGS01" in host byte order. A file written on a host with another byte order has the bytes of
+// the magic reversed and is rejected.
+constexpr uint64_t FileMagic = 0x3130534741545049;
+constexpr uint32_t FileVersion = 1;
+
+// The ranges of each IP version are indexed by the top RootBits bits of the address.
+constexpr uint32_t RootBits = 16;
+constexpr uint32_t RootSize = 1 << RootBits;
+
+// The sections of the file are aligned so that absl::uint128 arrays can be used in place.
+constexpr uint64_t SectionAlignment = 16;
+
+using Ipv4 = uint32_t;
+using Ipv6 = absl::uint128;
+
+/**
+ * Interns the sets of tag IDs which apply to the ranges. The empty set is IpTagFile::NoTags.
+ */
+class TagSetInterner {
+public:
+  TagSetInterner() : sets_(1) { ids_.emplace(std::vector<uint32_t>(), IpTagFile::NoTags); }
+
+  /**
+   * @return the ID of the union of a tag set and a tag.
+   */
+  uint32_t add(uint32_t tag_set, uint32_t tag) {
+    const uint64_t key = (static_cast<uint64_t>(tag_set) << 32) | tag;
+    auto it = unions_.find(key);
+    if (it != unions_.end()) {
+      return it->second;
+    }
+    std::vector<uint32_t> tags = sets_[tag_set];
+    auto position = std::lower_bound(tags.begin(), tags.end(), tag);
+    if (position == tags.end() || *position != tag) {
+      tags.insert(position, tag);
+    }
+    auto inserted = ids_.emplace(tags, sets_.size());
+    if (inserted.second) {
+      sets_.push_back(std::move(tags));
+    }
+    unions_.emplace(key, inserted.first->second);
+    return inserted.first->second;
+  }
+
+  const std::vector<std::vector<uint32_t>>& sets() const { return sets_; }
+
+private:
+  std::vector<std::vector<uint32_t>> sets_;
+  absl::flat_hash_map<std::vector<uint32_t>, uint32_t> ids_;
+  absl::flat_hash_map<uint64_t, uint32_t> unions_;
+};
+
+/**
+ * Turns the possibly nested prefixes of an IP version into the sorted disjoint ranges of the file.
+ */
+template <class IpType> class RangeBuilder {
+public:
+  static constexpr uint32_t AddressSize = CHAR_BIT * sizeof(IpType);
+
+  void add(IpType ip, uint32_t length, uint32_t tag) {
+    const IpType mask = length == 0 ? IpType(0) : ~IpType(0) << (AddressSize - length);
+    prefixes_.push_back({ip & mask, (ip & mask) | ~mask, length, tag});
+  }
+
+  void build(TagSetInterner& tag_sets) {
+    // Wider prefixes sort before the prefixes nested in them.
+    std::sort(prefixes_.begin(), prefixes_.end(), [](const Prefix& a, const Prefix& b) {
+      return a.start_ < b.start_ || (a.start_ == b.start_ && a.length_ < b.length_);
+    });
+
+    // The prefixes which contain the current position, innermost last. As CIDR ranges are either
+    // nested or disjoint, each prefix is nested in all of them until they are closed.
+    std::vector<Open> open;
+    emit(IpType(0), IpTagFile::NoTags);
+    for (const Prefix& prefix : prefixes_) {
+      while (!open.empty() && open.back().last_ < prefix.start_) {
+        const IpType next = open.back().last_ + 1;
+        open.pop_back();
+        emit(next, open.empty() ? IpTagFile::NoTags : open.back().tag_set_);
+      }
+      if (!open.empty() && open.back().start_ == prefix.start_ &&
+          open.back().length_ == prefix.length_) {
+        open.back().tag_set_ = tag_sets.add(open.back().tag_set_, prefix.tag_);
+      } else {
+        const uint32_t parent = open.empty() ? IpTagFile::NoTags : open.back().tag_set_;
+        open.push_back(
+            {prefix.start_, prefix.last_, prefix.length_, tag_sets.add(parent, prefix.tag_)});
+      }
+      emit(prefix.start_, open.back().tag_set_);
+    }
+    while (!open.empty()) {
+      const IpType last = open.back().last_;
+      open.pop_back();
+      if (last != ~IpType(0)) {
+        emit(last + 1, open.empty() ? IpTagFile::NoTags : open.back().tag_set_);
+      }
+    }
+    prefixes_.clear();
+    prefixes_.shrink_to_fit();
+
+    // root_[i] is the range which contains the first address of the i-th block of addresses.
+    root_.resize(RootSize + 1);
+    size_t range = 0;
+    for (uint32_t i = 0; i < RootSize; i++) {
+      const IpType block_start = IpType(i) << (AddressSize - RootBits);
+      while (range + 1 < starts_.size() && starts_[range + 1] <= block_start) {
+        range++;
+      }
+      root_[i] = range;
+    }
+    root_[RootSize] = starts_.size() - 1;
+  }
+
+  const std::vector<uint32_t>& root() const { return root_; }
+  const std::vector<IpType>& starts() const { return starts_; }
+  const std::vector<uint32_t>& tagSets() const { return tag_sets_; }
+
+private:
+  struct Prefix {
+    IpType start_;
+    IpType last_;
+    uint32_t length_;
+    uint32_t tag_;
+  };
+
+  struct Open {
+    IpType start_;
+    IpType last_;
+    uint32_t length_;
+    uint32_t tag_set_;
+  };
+
+  // Start a range with the given tag set at 'start', merging it into the previous range if they
+  // have the same tags.
+  void emit(IpType start, uint32_t tag_set) {
+    if (!starts_.empty() && starts_.back() == start) {
+      starts_.pop_back();
+      tag_sets_.pop_back();
+    }
+    if (!tag_sets_.empty() && tag_sets_.back() == tag_set) {
+      return;
+    }
+    starts_.push_back(start);
+    tag_sets_.push_back(tag_set);
+  }
+
+  std::vector<Prefix> prefixes_;
+  std::vector<IpType> starts_;
+  std::vector<uint32_t> tag_sets_;
+  std::vector<uint32_t> root_;
+};
+
+/**
+ * Appends the aligned sections of the file.
+ */
+class FileWriter {
+public:
+  template <class T> uint64_t append(const std::vector<T>& values) {
+    return append(values.data(), values.size() * sizeof(T));
+  }
+
+  uint64_t append(const void* data, uint64_t size) {
+    output_.resize((output_.size() + SectionAlignment - 1) / SectionAlignment * SectionAlignment);
+    const uint64_t offset = output_.size();
+    output_.append(static_cast<const char*>(data), size);
+    return offset;
+  }
+
+  std::string& output() { return output_; }
+
+private:
+  std::string output_;
+};
+
+uint32_t checkedSize(uint64_t size) {
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw EnvoyException("IP tag set is too large");
+  }
+  return static_cast<uint32_t>(size);
+}
+
+} // namespace
+
+constexpr uint32_t IpTagFile::NoTags;
+
+struct IpTagFile::Header {
+  uint64_t magic_;
+  uint32_t version_;
+  uint32_t tag_count_;
+  uint32_t tag_set_count_;
+  uint32_t ipv4_range_count_;
+  uint32_t ipv6_range_count_;
+  uint32_t strings_size_;
+  uint64_t size_;
+  uint64_t tag_set_tag_count_;
+  // The offsets of the sections:
+  // uint32_t[tag_count_ + 1], the offsets of the tags in the strings.
+  uint64_t tag_offsets_;
+  // uint32_t[tag_set_count_ + 1], the offsets of the tags of each tag set in tag_set_tags_.
+  uint64_t tag_set_tag_offsets_;
+  // uint32_t[tag_set_tag_count_], the tag IDs of the tag sets.
+  uint64_t tag_set_tags_;
+  // uint32_t[tag_set_count_ + 1], the offsets of the values of the tag sets in the strings.
+  uint64_t tag_set_value_offsets_;
+  // char[strings_size_]
+  uint64_t strings_;
+  // uint32_t[RootSize + 1], IpType[range count] and uint32_t[range count] for each IP version.
+  uint64_t ipv4_root_;
+  uint64_t ipv4_starts_;
+  uint64_t ipv4_tag_sets_;
+  uint64_t ipv6_root_;
+  uint64_t ipv6_starts_;
+  uint64_t ipv6_tag_sets_;
+};
+
+template <class IpType> struct IpTagFile::Ranges {
+  const uint32_t* root_;
+  const IpType* starts_;
+  const uint32_t* tag_sets_;
+  uint32_t count_;
+};
+
+std::string IpTagFile::build(
+    const std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>& data) {
+  std::vector<std::string> tags;
+  absl::flat_hash_map<std::string, uint32_t> tag_ids;
+  RangeBuilder<Ipv4> ipv4;
+  RangeBuilder<Ipv6> ipv6;
+  for (const auto& tag_data : data) {
+    const uint32_t tag = tag_ids.emplace(tag_data.first, tags.size()).first->second;
+    if (tag == tags.size()) {
+      tags.push_back(tag_data.first);
+    }
+    for (const Network::Address::CidrRange& cidr_range : tag_data.second) {
+      if (cidr_range.ip()->version() == Network::Address::IpVersion::v4) {
+        ipv4.add(ntohl(cidr_range.ip()->ipv4()->address()), cidr_range.length(), tag);
+      } else {
+        ipv6.add(Network::Utility::Ip6ntohl(cidr_range.ip()->ipv6()->address()),
+                 cidr_range.length(), tag);
+      }
+    }
+  }
+  TagSetInterner tag_sets;
+  ipv4.build(tag_sets);
+  ipv6.build(tag_sets);
+
+  std::string strings;
+  std::vector<uint32_t> tag_offsets;
+  for (const std::string& tag : tags) {
+    tag_offsets.push_back(checkedSize(strings.size()));
+    strings.append(tag);
+  }
+  tag_offsets.push_back(checkedSize(strings.size()));
+  std::vector<uint32_t> tag_set_tag_offsets;
+  std::vector<uint32_t> tag_set_tags;
+  std::vector<uint32_t> tag_set_value_offsets;
+  for (const std::vector<uint32_t>& tag_set : tag_sets.sets()) {
+    tag_set_tag_offsets.push_back(checkedSize(tag_set_tags.size()));
+    tag_set_tags.insert(tag_set_tags.end(), tag_set.begin(), tag_set.end());
+    tag_set_value_offsets.push_back(checkedSize(strings.size()));
+    for (uint32_t tag : tag_set) {
+      if (tag != tag_set.front()) {
+        strings.push_back(',');
+      }
+      strings.append(tags[tag]);
+    }
+  }
+  tag_set_tag_offsets.push_back(checkedSize(tag_set_tags.size()));
+  tag_set_value_offsets.push_back(checkedSize(strings.size()));
+
+  Header header{};
+  FileWriter writer;
+  writer.append(&header, sizeof(header));
+  header.magic_ = FileMagic;
+  header.version_ = FileVersion;
+  header.tag_count_ = checkedSize(tags.size());
+  header.tag_set_count_ = checkedSize(tag_sets.sets().size());
+  header.ipv4_range_count_ = checkedSize(ipv4.starts().size());
+  header.ipv6_range_count_ = checkedSize(ipv6.starts().size());
+  header.strings_size_ = checkedSize(strings.size());
+  header.tag_set_tag_count_ = tag_set_tags.size();
+  header.tag_offsets_ = writer.append(tag_offsets);
+  header.tag_set_tag_offsets_ = writer.append(tag_set_tag_offsets);
+  header.tag_set_tags_ = writer.append(tag_set_tags);
+  header.tag_set_value_offsets_ = writer.append(tag_set_value_offsets);
+  header.strings_ = writer.append(strings.data(), strings.size());
+  header.ipv4_root_ = writer.append(ipv4.root());
+  header.ipv4_starts_ = writer.append(ipv4.starts());
+  header.ipv4_tag_sets_ = writer.append(ipv4.tagSets());
+  header.ipv6_root_ = writer.append(ipv6.root());
+  header.ipv6_starts_ = writer.append(ipv6.starts());
+  header.ipv6_tag_sets_ = writer.append(ipv6.tagSets());
+  header.size_ = writer.output().size();
+  memcpy(&writer.output()[0], &header, sizeof(header));
+  return std::move(writer.output());
+}
+
+IpTagFileConstSharedPtr IpTagFile::load(const std::string& path) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw EnvoyException(fmt::format("cannot open IP tag file {}: {}", path, strerror(errno)));
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) == -1 || static_cast<uint64_t>(file_stat.st_size) < sizeof(Header)) {
+    os_sys_calls.close(fd);
+    throw EnvoyException(fmt::format("invalid IP tag file {}", path));
+  }
+  const uint64_t size = file_stat.st_size;
+  const Api::SysCallPtrResult mmap_result =
+      os_sys_calls.mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed, and after it is replaced.
+  os_sys_calls.close(fd);
+  if (mmap_result.rc_ == MAP_FAILED) {
+    throw EnvoyException(
+        fmt::format("cannot map IP tag file {}: {}", path, strerror(mmap_result.errno_)));
+  }
+  IpTagFileConstSharedPtr file(
+      new IpTagFile(static_cast<const char*>(mmap_result.rc_), size, true, ""));
+  try {
+    file->validate();
+  } catch (const EnvoyException& e) {
+    throw EnvoyException(fmt::format("invalid IP tag file {}: {}", path, e.what()));
+  }
+  return file;
+}
+
+IpTagFileConstSharedPtr IpTagFile::fromString(std::string contents) {
+  if (contents.size() < sizeof(Header)) {
+    throw EnvoyException("invalid IP tag file");
+  }
+  const uint64_t size = contents.size();
+  IpTagFileConstSharedPtr file(new IpTagFile(nullptr, size, false, std::move(contents)));
+  file->validate();
+  return file;
+}
+
+IpTagFile::IpTagFile(const char* data, uint64_t size, bool mapped, std::string contents)
+    : contents_(std::move(contents)), data_(mapped ? data : contents_.data()), size_(size),
+      mapped_(mapped) {}
+
+IpTagFile::~IpTagFile() {
+  if (mapped_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+const IpTagFile::Header& IpTagFile::header() const {
+  return *reinterpret_cast<const Header*>(data_);
+}
+
+void IpTagFile::validate() const {
+  // The sections are used in place, so the contents must be aligned as they are in the file.
+  if (reinterpret_cast<uintptr_t>(data_) % SectionAlignment != 0) {
+    throw EnvoyException("misaligned contents");
+  }
+  const Header& header = this->header();
+  if (header.magic_ != FileMagic || header.version_ != FileVersion || header.size_ != size_) {
+    throw EnvoyException("bad header");
+  }
+
+  auto check_section = [this](uint64_t offset, uint64_t count, uint64_t element_size) {
+    if (offset % SectionAlignment != 0 || offset > size_ ||
+        count > (size_ - offset) / element_size) {
+      throw EnvoyException("section out of bounds");
+    }
+  };
+  auto check_offsets = [](const uint32_t* offsets, uint64_t count, uint64_t limit) {
+    for (uint64_t i = 0; i < count; i++) {
+      if (offsets[i] > offsets[i + 1]) {
+        throw EnvoyException("bad offsets");
+      }
+    }
+    if (offsets[count] > limit) {
+      throw EnvoyException("bad offsets");
+    }
+  };
+
+  check_section(header.tag_offsets_, header.tag_count_ + uint64_t(1), sizeof(uint32_t));
+  check_section(header.tag_set_tag_offsets_, header.tag_set_count_ + uint64_t(1), sizeof(uint32_t));
+  check_section(header.tag_set_tags_, header.tag_set_tag_count_, sizeof(uint32_t));
+  check_section(header.tag_set_value_offsets_, header.tag_set_count_ + uint64_t(1),
+                sizeof(uint32_t));
+  check_section(header.strings_, header.strings_size_, 1);
+  if (header.tag_set_count_ == 0) {
+    throw EnvoyException("no tag sets");
+  }
+  check_offsets(array<uint32_t>(header.tag_offsets_), header.tag_count_, header.strings_size_);
+  check_offsets(array<uint32_t>(header.tag_set_tag_offsets_), header.tag_set_count_,
+                header.tag_set_tag_count_);
+  check_offsets(array<uint32_t>(header.tag_set_value_offsets_), header.tag_set_count_,
+                header.strings_size_);
+  const uint32_t* tag_set_tags = array<uint32_t>(header.tag_set_tags_);
+  for (uint64_t i = 0; i < header.tag_set_tag_count_; i++) {
+    if (tag_set_tags[i] >= header.tag_count_) {
+      throw EnvoyException("bad tag set");
+    }
+  }
+
+  auto check_ranges = [&](auto ranges, uint64_t root, uint64_t starts, uint64_t tag_sets) {
+    using IpType = typename std::remove_const<
+        typename std::remove_pointer<decltype(ranges.starts_)>::type>::type;
+    check_section(root, RootSize + 1, sizeof(uint32_t));
+    check_section(starts, ranges.count_, sizeof(IpType));
+    check_section(tag_sets, ranges.count_, sizeof(uint32_t));
+    ranges = IpTagFile::Ranges<IpType>{array<uint32_t>(root), array<IpType>(starts),
+                                       array<uint32_t>(tag_sets), ranges.count_};
+    if (ranges.count_ == 0 || ranges.starts_[0] != IpType(0)) {
+      throw EnvoyException("bad ranges");
+    }
+    for (uint32_t i = 0; i < ranges.count_; i++) {
+      if ((i > 0 && ranges.starts_[i - 1] >= ranges.starts_[i]) ||
+          ranges.tag_sets_[i] >= header.tag_set_count_) {
+        throw EnvoyException("bad ranges");
+      }
+    }
+    for (uint32_t i = 0; i <= RootSize; i++) {
+      if (ranges.root_[i] >= ranges.count_ || (i > 0 && ranges.root_[i - 1] > ranges.root_[i]) ||
+          (i < RootSize && ranges.starts_[ranges.root_[i]] >
+                               (IpType(i) << (CHAR_BIT * sizeof(IpType) - RootBits)))) {
+        throw EnvoyException("bad root");
+      }
+    }
+  };
+  check_ranges(Ranges<Ipv4>{nullptr, nullptr, nullptr, header.ipv4_range_count_},
+               header.ipv4_root_, header.ipv4_starts_, header.ipv4_tag_sets_);
+  check_ranges(Ranges<Ipv6>{nullptr, nullptr, nullptr, header.ipv6_range_count_},
+               header.ipv6_root_, header.ipv6_starts_, header.ipv6_tag_sets_);
+}
+
+template <class IpType> IpTagFile::Ranges<IpType> IpTagFile::ranges(bool ipv6) const {
+  const Header& header = this->header();
+  if (ipv6) {
+    return {array<uint32_t>(header.ipv6_root_), array<IpType>(header.ipv6_starts_),
+            array<uint32_t>(header.ipv6_tag_sets_), header.ipv6_range_count_};
+  }
+  return {array<uint32_t>(header.ipv4_root_), array<IpType>(header.ipv4_starts_),
+          array<uint32_t>(header.ipv4_tag_sets_), header.ipv4_range_count_};
+}
+
+template <class IpType>
+uint32_t IpTagFile::lookup(const Ranges<IpType>& ranges, IpType address) const {
+  const uint32_t block =
+      static_cast<uint32_t>(address >> (CHAR_BIT * sizeof(IpType) - RootBits));
+  // The range of the address is at or after the range of the first address of its block, and at
+  // or before the range of the first address of the next block.
+  const IpType* first = ranges.starts_ + ranges.root_[block];
+  const IpType* last = ranges.starts_ + ranges.root_[block + 1] + 1;
+  const IpType* range = std::upper_bound(first, last, address) - 1;
+  return ranges.tag_sets_[range - ranges.starts_];
+}
+
+uint32_t IpTagFile::lookup(const Network::Address::Instance& address) const {
+  if (address.ip() == nullptr) {
+    return NoTags;
+  }
+  if (address.ip()->version() == Network::Address::IpVersion::v4) {
+    return lookup(ranges<Ipv4>(false), Ipv4(ntohl(address.ip()->ipv4()->address())));
+  }
+  return lookup(ranges<Ipv6>(true), Network::Utility::Ip6ntohl(address.ip()->ipv6()->address()));
+}
+
+absl::string_view IpTagFile::tagSetValue(uint32_t tag_set) const {
+  ASSERT(tag_set < tagSetCount());
+  const uint32_t* offsets = array<uint32_t>(header().tag_set_value_offsets_);
+  return {data_ + header().strings_ + offsets[tag_set], offsets[tag_set + 1] - offsets[tag_set]};
+}
+
+std::pair<const uint32_t*, const uint32_t*> IpTagFile::tagSetTags(uint32_t tag_set) const {
+  ASSERT(tag_set < tagSetCount());
+  const uint32_t* offsets = array<uint32_t>(header().tag_set_tag_offsets_);
+  const uint32_t* tags = array<uint32_t>(header().tag_set_tags_);
+  return {tags + offsets[tag_set], tags + offsets[tag_set + 1]};
+}
+
+absl::string_view IpTagFile::tag(uint32_t id) const {
+  ASSERT(id < tagCount());
+  const uint32_t* offsets = array<uint32_t>(header().tag_offsets_);
+  return {data_ + header().strings_ + offsets[id], offsets[id + 1] - offsets[id]};
+}
+
+uint32_t IpTagFile::tagCount() const { return header().tag_count_; }
+
+uint32_t IpTagFile::tagSetCount() const { return header().tag_set_count_; }
+
+uint32_t IpTagFile::rangeCount() const {
+  return header().ipv4_range_count_ + header().ipv6_range_count_;
+}
+
+IpTagFileProvider::IpTagFileProvider(const std::string& path, const std::string& stat_prefix,
+                                     Stats::Scope& scope, Event::Dispatcher& dispatcher,
+                                     ThreadLocal::SlotAllocator& tls)
+    : path_(path), stats_{ALL_IP_TAG_FILE_STATS(POOL_COUNTER_PREFIX(scope, stat_prefix),
+                                                POOL_GAUGE_PREFIX(scope, stat_prefix))},
+      tls_slot_(tls.allocateSlot()), watcher_(dispatcher.createFilesystemWatcher()) {
+  // The configuration is rejected if the initial file is invalid.
+  set(IpTagFile::load(path_));
+  watcher_->addWatch(path_, Filesystem::Watcher::Events::MovedTo, [this](uint32_t) { reload(); });
+}
+
+void IpTagFileProvider::set(IpTagFileConstSharedPtr file) {
+  stats_.ranges_.set(file->rangeCount());
+  stats_.tag_sets_.set(file->tagSetCount());
+  tls_slot_->set([file](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalFile>(file);
+  });
+}
+
+void IpTagFileProvider::reload() {
+  IpTagFileConstSharedPtr file;
+  try {
+    file = IpTagFile::load(path_);
+  } catch (const EnvoyException& e) {
+    ENVOY_LOG(warn, "keeping the previous IP tags: {}", e.what());
+    stats_.reload_failed_.inc();
+    return;
+  }
+  set(std::move(file));
+  stats_.reload_success_.inc();
+}
+
+} // namespace IpTagging
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
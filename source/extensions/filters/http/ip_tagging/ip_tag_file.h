@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/filesystem/watcher.h"
+#include "envoy/network/address.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+#include "common/network/cidr_range.h"
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace IpTagging {
+
+/**
+ * An immutable set of IP tags in a compact binary format, which is looked up in place, so that a
+ * file holding millions of prefixes is memory mapped rather than parsed into a trie.
+ *
+ * Tags are interned as integer IDs, and so are the sets of tags which apply to an address. Each IP
+ * version has a sorted array of disjoint address ranges, which cover the whole address space and
+ * each have the ID of the set of the tags of all the prefixes which contain the range. A root table
+ * indexed by the top 16 bits of the address, as the root branching factor of an LC trie, gives the
+ * ranges to binary search for an address.
+ *
+ * The file is written by build() in host byte order, and is only loaded by hosts with the same
+ * byte order.
+ */
+class IpTagFile {
+public:
+  // The ID of the empty tag set.
+  static constexpr uint32_t NoTags = 0;
+
+  /**
+   * Map and validate a file written by build(). Throws EnvoyException if the file is invalid.
+   */
+  static std::shared_ptr<const IpTagFile> load(const std::string& path);
+
+  /**
+   * Validate the contents of a file written by build(). Throws EnvoyException if it is invalid.
+   */
+  static std::shared_ptr<const IpTagFile> fromString(std::string contents);
+
+  /**
+   * Write the binary format of a tag set. Throws EnvoyException if the tag set is too large.
+   * @param data supplies the tags and their CIDR ranges, as for Network::LcTrie::LcTrie.
+   */
+  static std::string
+  build(const std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>& data);
+
+  ~IpTagFile();
+
+  /**
+   * @return the ID of the set of tags of the address, or NoTags.
+   */
+  uint32_t lookup(const Network::Address::Instance& address) const;
+
+  /**
+   * @return the tags of a tag set joined by commas, as for the x-envoy-ip-tags header.
+   */
+  absl::string_view tagSetValue(uint32_t tag_set) const;
+
+  /**
+   * @return the IDs of the tags of a tag set.
+   */
+  std::pair<const uint32_t*, const uint32_t*> tagSetTags(uint32_t tag_set) const;
+
+  absl::string_view tag(uint32_t id) const;
+  uint32_t tagCount() const;
+  uint32_t tagSetCount() const;
+  uint32_t rangeCount() const;
+
+  /**
+   * @return the size of the file.
+   */
+  uint64_t size() const { return size_; }
+
+private:
+  struct Header;
+  template <class IpType> struct Ranges;
+
+  IpTagFile(const char* data, uint64_t size, bool mapped, std::string contents);
+  const Header& header() const;
+  void validate() const;
+  template <class IpType> Ranges<IpType> ranges(bool ipv6) const;
+  template <class IpType> uint32_t lookup(const Ranges<IpType>& ranges, IpType address) const;
+  template <class T> const T* array(uint64_t offset) const {
+    return reinterpret_cast<const T*>(data_ + offset);
+  }
+
+  // The contents of a file which was not mapped.
+  const std::string contents_;
+  const char* const data_;
+  const uint64_t size_;
+  const bool mapped_;
+};
+
+using IpTagFileConstSharedPtr = std::shared_ptr<const IpTagFile>;
+
+/**
+ * All stats for an IP tag file. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_IP_TAG_FILE_STATS(COUNTER, GAUGE)                                                      \
+  COUNTER(reload_success)                                                                          \
+  COUNTER(reload_failed)                                                                           \
+  GAUGE(ranges, NeverImport)                                                                       \
+  GAUGE(tag_sets, NeverImport)
+// clang-format on
+
+/**
+ * Struct definition for all IP tag file stats. @see stats_macros.h
+ */
+struct IpTagFileStats {
+  ALL_IP_TAG_FILE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Loads an IP tag file and gives each worker the tag file, which is swapped for a new one when a
+ * new file is moved into the path. Workers keep using the previous file, as a whole, until the new
+ * one has been loaded and validated, and it is unmapped when the last request using it is done.
+ */
+class IpTagFileProvider : Logger::Loggable<Logger::Id::filter> {
+public:
+  IpTagFileProvider(const std::string& path, const std::string& stat_prefix, Stats::Scope& scope,
+                    Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @return the tag file of the current worker.
+   */
+  const IpTagFileConstSharedPtr& file() const {
+    return tls_slot_->getTyped<ThreadLocalFile>().file_;
+  }
+
+private:
+  struct ThreadLocalFile : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalFile(IpTagFileConstSharedPtr file) : file_(std::move(file)) {}
+
+    const IpTagFileConstSharedPtr file_;
+  };
+
+  void set(IpTagFileConstSharedPtr file);
+  void reload();
+
+  const std::string path_;
+  IpTagFileStats stats_;
+  ThreadLocal::SlotPtr tls_slot_;
+  Filesystem::WatcherPtr watcher_;
+};
+
+using IpTagFileProviderPtr = std::unique_ptr<IpTagFileProvider>;
+
+} // namespace IpTagging
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
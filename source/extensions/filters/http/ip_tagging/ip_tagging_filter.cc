@@ -3,6 +3,7 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 
+#include "absl/container/inlined_vector.h"
 #include "absl/strings/str_join.h"
 
 namespace Envoy {
@@ -12,20 +13,20 @@ namespace IpTagging {
 
 IpTaggingFilterConfig::IpTaggingFilterConfig(
     const envoy::config::filter::http::ip_tagging::v2::IPTagging& config,
-    const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime)
+    const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+    IpTagFileProviderPtr tag_file)
     : request_type_(requestTypeEnum(config.request_type())), scope_(scope), runtime_(runtime),
       stat_name_set_(scope.symbolTable().makeSet("IpTagging")),
       stats_prefix_(stat_name_set_->add(stat_prefix + "ip_tagging")),
       hit_(stat_name_set_->add("hit")), no_hit_(stat_name_set_->add("no_hit")),
-      total_(stat_name_set_->add("total")) {
-
-  // Once loading IP tags from a file system is supported, the restriction on the size
-  // of the set should be removed and observability into what tags are loaded needs
-  // to be implemented.
-  // TODO(ccaraman): Remove size check once file system support is implemented.
-  // Work is tracked by issue https://github.com/envoyproxy/envoy/issues/2695.
-  if (config.ip_tags().empty()) {
-    throw EnvoyException("HTTP IP Tagging Filter requires ip_tags to be specified.");
+      total_(stat_name_set_->add("total")), tag_file_(std::move(tag_file)) {
+
+  if (config.ip_tags().empty() == (tag_file_ == nullptr)) {
+    throw EnvoyException(
+        "HTTP IP Tagging Filter requires either ip_tags or ip_tags_path to be specified.");
+  }
+  if (tag_file_ != nullptr) {
+    return;
   }
 
   std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> tag_data;
@@ -73,8 +74,14 @@ Http::FilterHeadersStatus IpTaggingFilter::decodeHeaders(Http::HeaderMap& header
     return Http::FilterHeadersStatus::Continue;
   }
 
-  std::vector<std::string> tags =
-      config_->trie().getData(callbacks_->streamInfo().downstreamRemoteAddress());
+  if (config_->tagFile() != nullptr) {
+    decodeTagFile(headers);
+    config_->incTotal();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  absl::InlinedVector<std::string, 4> tags;
+  config_->trie().getData(*callbacks_->streamInfo().downstreamRemoteAddress(), tags);
 
   if (!tags.empty()) {
     const std::string tags_join = absl::StrJoin(tags, ",");
@@ -97,6 +104,20 @@ Http::FilterHeadersStatus IpTaggingFilter::decodeHeaders(Http::HeaderMap& header
   return Http::FilterHeadersStatus::Continue;
 }
 
+void IpTaggingFilter::decodeTagFile(Http::HeaderMap& headers) {
+  const IpTagFile& file = *config_->tagFile()->file();
+  const uint32_t tag_set = file.lookup(*callbacks_->streamInfo().downstreamRemoteAddress());
+  if (tag_set == IpTagFile::NoTags) {
+    config_->incNoHit();
+    return;
+  }
+  Http::HeaderMapImpl::appendToHeader(headers.insertEnvoyIpTags().value(),
+                                      file.tagSetValue(tag_set));
+  callbacks_->clearRouteCache();
+  // A tag file may hold any number of tags, so only the hits of all the tags are counted.
+  config_->incHit("");
+}
+
 Http::FilterDataStatus IpTaggingFilter::decodeData(Buffer::Instance&, bool) {
   return Http::FilterDataStatus::Continue;
 }
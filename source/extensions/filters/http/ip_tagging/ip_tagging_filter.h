@@ -16,6 +16,8 @@
 #include "common/network/lc_trie.h"
 #include "common/stats/symbol_table_impl.h"
 
+#include "extensions/filters/http/ip_tagging/ip_tag_file.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace HttpFilters {
@@ -33,12 +35,14 @@ class IpTaggingFilterConfig {
 public:
   IpTaggingFilterConfig(const envoy::config::filter::http::ip_tagging::v2::IPTagging& config,
                         const std::string& stat_prefix, Stats::Scope& scope,
-                        Runtime::Loader& runtime);
+                        Runtime::Loader& runtime, IpTagFileProviderPtr tag_file = nullptr);
 
   Runtime::Loader& runtime() { return runtime_; }
   Stats::Scope& scope() { return scope_; }
   FilterRequestType requestType() const { return request_type_; }
   const Network::LcTrie::LcTrie<std::string>& trie() const { return *trie_; }
+  // The provider of the tags loaded from ip_tags_path, or nullptr if they are in ip_tags.
+  const IpTagFileProvider* tagFile() const { return tag_file_.get(); }
 
   void incHit(absl::string_view tag) { incCounter(hit_, tag); }
   void incNoHit() { incCounter(no_hit_); }
@@ -70,6 +74,7 @@ private:
   const Stats::StatName no_hit_;
   const Stats::StatName total_;
   std::unique_ptr<Network::LcTrie::LcTrie<std::string>> trie_;
+  const IpTagFileProviderPtr tag_file_;
 };
 
 using IpTaggingFilterConfigSharedPtr = std::shared_ptr<IpTaggingFilterConfig>;
@@ -93,6 +98,8 @@ public:
   void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override;
 
 private:
+  void decodeTagFile(Http::HeaderMap& headers);
+
   IpTaggingFilterConfigSharedPtr config_;
   Http::StreamDecoderFilterCallbacks* callbacks_{};
 };
@@ -30,9 +30,10 @@ class AuthenticatorImpl : public Logger::Loggable<Logger::Id::jwt>,
 public:
   AuthenticatorImpl(const CheckAudience* check_audience,
                     const absl::optional<std::string>& provider, bool allow_failed,
-                    JwksCache& jwks_cache, Upstream::ClusterManager& cluster_manager,
+                    JwksCache& jwks_cache, TokenCache* token_cache,
+                    Upstream::ClusterManager& cluster_manager,
                     CreateJwksFetcherCb create_jwks_fetcher_cb, TimeSource& time_source)
-      : jwks_cache_(jwks_cache), cm_(cluster_manager),
+      : jwks_cache_(jwks_cache), token_cache_(token_cache), cm_(cluster_manager),
         create_jwks_fetcher_cb_(create_jwks_fetcher_cb), check_audience_(check_audience),
         provider_(provider), is_allow_failed_(allow_failed), time_source_(time_source) {}
 
@@ -50,6 +51,9 @@ private:
   // Verify with a specific public key.
   void verifyKey();
 
+  // Forward the payload of a verified token.
+  void handleVerifiedJwt();
+
   // Calls the callback with status.
   void doneWithStatus(const Status& status);
 
@@ -59,6 +63,8 @@ private:
 
   // The jwks cache object.
   JwksCache& jwks_cache_;
+  // The cache of verified tokens, if any.
+  TokenCache* token_cache_;
   // the cluster manager object.
   Upstream::ClusterManager& cm_;
 
@@ -72,7 +78,10 @@ private:
   std::vector<JwtLocationConstPtr> tokens_;
   JwtLocationConstPtr curr_token_;
   // The JWT object.
-  std::unique_ptr<::google::jwt_verify::Jwt> jwt_;
+  JwtConstSharedPtr jwt_;
+  // The JWKS the token was verified with, if it was found in the token cache.
+  const JwksCache::JwksData* cached_jwks_data_{};
+  uint64_t cached_jwks_version_{};
   // The JWKS data object
   JwksCache::JwksData* jwks_data_{};
 
@@ -111,11 +120,32 @@ void AuthenticatorImpl::startVerify() {
   ASSERT(!tokens_.empty());
   curr_token_ = std::move(tokens_.back());
   tokens_.pop_back();
-  jwt_ = std::make_unique<::google::jwt_verify::Jwt>();
-  const Status status = jwt_->parseFromString(curr_token_->token());
-  if (status != Status::Ok) {
-    doneWithStatus(status);
-    return;
+
+  // TODO(qiwzhang): Cross-platform-wise the below unix_timestamp code is wrong as the
+  // epoch is not guaranteed to be defined as the unix epoch. We should use
+  // the abseil time functionality instead or use the jwt_verify_lib to check
+  // the validity of a JWT.
+  const uint64_t unix_timestamp =
+      std::chrono::duration_cast<std::chrono::seconds>(timeSource().systemTime().time_since_epoch())
+          .count();
+
+  // A cached token was parsed when it was verified.
+  const TokenCache::Entry* cached =
+      token_cache_ != nullptr ? token_cache_->lookup(curr_token_->token(), unix_timestamp)
+                              : nullptr;
+  if (cached != nullptr) {
+    jwt_ = cached->jwt_;
+    cached_jwks_data_ = cached->jwks_data_;
+    cached_jwks_version_ = cached->jwks_version_;
+  } else {
+    auto jwt = std::make_shared<::google::jwt_verify::Jwt>();
+    const Status status = jwt->parseFromString(curr_token_->token());
+    if (status != Status::Ok) {
+      doneWithStatus(status);
+      return;
+    }
+    jwt_ = std::move(jwt);
+    cached_jwks_data_ = nullptr;
   }
 
   ENVOY_LOG(debug, "Verifying JWT token of issuer {}", jwt_->iss_);
@@ -125,14 +155,6 @@ void AuthenticatorImpl::startVerify() {
     return;
   }
 
-  // TODO(qiwzhang): Cross-platform-wise the below unix_timestamp code is wrong as the
-  // epoch is not guaranteed to be defined as the unix epoch. We should use
-  // the abseil time functionality instead or use the jwt_verify_lib to check
-  // the validity of a JWT.
-  // Check "exp" claim.
-  const uint64_t unix_timestamp =
-      std::chrono::duration_cast<std::chrono::seconds>(timeSource().systemTime().time_since_epoch())
-          .count();
   // If the nbf claim does *not* appear in the JWT, then the nbf field is defaulted
   // to 0.
   if (jwt_->nbf_ > unix_timestamp) {
@@ -162,6 +184,12 @@ void AuthenticatorImpl::startVerify() {
 
   auto jwks_obj = jwks_data_->getJwksObj();
   if (jwks_obj != nullptr && !jwks_data_->isExpired()) {
+    // The signature of a cached token need not be verified again with the same JWKS.
+    if (cached_jwks_data_ == jwks_data_ && cached_jwks_version_ == jwks_data_->version()) {
+      token_cache_->stats().hit_.inc();
+      handleVerifiedJwt();
+      return;
+    }
     // TODO(qiwzhang): It would seem there's a window of error whereby if the JWT issuer
     // has started signing with a new key that's not in our cache, then the
     // verification will fail even though the JWT is valid. A simple fix
@@ -209,12 +237,21 @@ void AuthenticatorImpl::onDestroy() {
 
 // Verify with a specific public key.
 void AuthenticatorImpl::verifyKey() {
+  if (token_cache_ != nullptr) {
+    token_cache_->stats().miss_.inc();
+  }
   const Status status = ::google::jwt_verify::verifyJwt(*jwt_, *jwks_data_->getJwksObj());
   if (status != Status::Ok) {
     doneWithStatus(status);
     return;
   }
+  if (token_cache_ != nullptr) {
+    token_cache_->insert(curr_token_->token(), jwt_, *jwks_data_);
+  }
+  handleVerifiedJwt();
+}
 
+void AuthenticatorImpl::handleVerifiedJwt() {
   // Forward the payload
   const auto& provider = jwks_data_->getJwtProvider();
   if (!provider.forward_payload_header().empty()) {
@@ -252,11 +289,13 @@ void AuthenticatorImpl::doneWithStatus(const Status& status) {
 AuthenticatorPtr Authenticator::create(const CheckAudience* check_audience,
                                        const absl::optional<std::string>& provider,
                                        bool allow_failed, JwksCache& jwks_cache,
+                                       TokenCache* token_cache,
                                        Upstream::ClusterManager& cluster_manager,
                                        CreateJwksFetcherCb create_jwks_fetcher_cb,
                                        TimeSource& time_source) {
   return std::make_unique<AuthenticatorImpl>(check_audience, provider, allow_failed, jwks_cache,
-                                             cluster_manager, create_jwks_fetcher_cb, time_source);
+                                             token_cache, cluster_manager, create_jwks_fetcher_cb,
+                                             time_source);
 }
 
 } // namespace JwtAuthn
@@ -5,6 +5,7 @@
 #include "extensions/filters/http/common/jwks_fetcher.h"
 #include "extensions/filters/http/jwt_authn/extractor.h"
 #include "extensions/filters/http/jwt_authn/jwks_cache.h"
+#include "extensions/filters/http/jwt_authn/token_cache.h"
 
 #include "jwt_verify_lib/check_audience.h"
 #include "jwt_verify_lib/status.h"
@@ -41,10 +42,11 @@ public:
   // Called when the object is about to be destroyed.
   virtual void onDestroy() PURE;
 
-  // Authenticator factory function.
+  // Authenticator factory function. The token cache is nullptr if tokens are not cached.
   static AuthenticatorPtr create(const ::google::jwt_verify::CheckAudience* check_audience,
                                  const absl::optional<std::string>& provider, bool allow_failed,
-                                 JwksCache& jwks_cache, Upstream::ClusterManager& cluster_manager,
+                                 JwksCache& jwks_cache, TokenCache* token_cache,
+                                 Upstream::ClusterManager& cluster_manager,
                                  CreateJwksFetcherCb create_jwks_fetcher_cb,
                                  TimeSource& time_source);
 };
@@ -7,7 +7,10 @@
 #include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/protobuf/utility.h"
+
 #include "extensions/filters/http/jwt_authn/matcher.h"
+#include "extensions/filters/http/jwt_authn/token_cache.h"
 #include "extensions/filters/http/jwt_authn/verifier.h"
 
 #include "absl/container/flat_hash_map.h"
@@ -17,26 +20,40 @@ namespace Extensions {
 namespace HttpFilters {
 namespace JwtAuthn {
 
+// The default number of verified tokens cached by each worker.
+constexpr uint32_t DefaultTokenCacheMaxEntries = 100;
+
 /**
  * Making cache as a thread local object, its read/write operations don't need to be protected.
- * Now it only has jwks_cache, but in the future, it will have token cache: to cache the tokens
- * with their verification results.
+ * It has the jwks_cache, and the token cache, if configured, to cache the tokens verified with
+ * the Jwks of the jwks_cache.
  */
 class ThreadLocalCache : public ThreadLocal::ThreadLocalObject {
 public:
   // Load the config from envoy config.
   ThreadLocalCache(
       const ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication& config,
-      TimeSource& time_source, Api::Api& api) {
+      TimeSource& time_source, Api::Api& api, TokenCacheStats& token_cache_stats) {
     jwks_cache_ = JwksCache::create(config, time_source, api);
+    if (config.has_token_cache()) {
+      token_cache_ = std::make_unique<TokenCache>(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.token_cache(), max_entries,
+                                          DefaultTokenCacheMaxEntries),
+          token_cache_stats);
+    }
   }
 
   // Get the JwksCache object.
   JwksCache& getJwksCache() { return *jwks_cache_; }
 
+  // Get the TokenCache object, or nullptr if tokens are not cached.
+  TokenCache* getTokenCache() { return token_cache_.get(); }
+
 private:
   // The JwksCache object.
   JwksCachePtr jwks_cache_;
+  // The TokenCache object.
+  TokenCachePtr token_cache_;
 };
 
 /**
@@ -67,11 +84,13 @@ public:
                const std::string& stats_prefix, Server::Configuration::FactoryContext& context)
       : proto_config_(std::move(proto_config)),
         stats_(generateStats(stats_prefix, context.scope())),
+        token_cache_stats_(generateTokenCacheStats(stats_prefix, context.scope())),
         tls_(context.threadLocal().allocateSlot()), cm_(context.clusterManager()),
         time_source_(context.dispatcher().timeSource()), api_(context.api()) {
     ENVOY_LOG(info, "Loaded JwtAuthConfig: {}", proto_config_.DebugString());
     tls_->set([this](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-      return std::make_shared<ThreadLocalCache>(proto_config_, time_source_, api_);
+      return std::make_shared<ThreadLocalCache>(proto_config_, time_source_, api_,
+                                                token_cache_stats_);
     });
     extractor_ = Extractor::create(proto_config_);
 
@@ -127,7 +146,8 @@ public:
                           const absl::optional<std::string>& provider,
                           bool allow_failed) const override {
     return Authenticator::create(check_audience, provider, allow_failed, getCache().getJwksCache(),
-                                 cm(), Common::JwksFetcher::create, timeSource());
+                                 getCache().getTokenCache(), cm(), Common::JwksFetcher::create,
+                                 timeSource());
   }
 
 private:
@@ -136,6 +156,11 @@ private:
     return {ALL_JWT_AUTHN_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
   }
 
+  TokenCacheStats generateTokenCacheStats(const std::string& prefix, Stats::Scope& scope) {
+    const std::string final_prefix = prefix + "jwt_authn.token_cache.";
+    return {ALL_JWT_AUTHN_TOKEN_CACHE_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+  }
+
   struct MatcherVerifierPair {
     MatcherVerifierPair(MatcherConstPtr matcher, VerifierConstPtr verifier)
         : matcher_(std::move(matcher)), verifier_(std::move(verifier)) {}
@@ -147,6 +172,8 @@ private:
   ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication proto_config_;
   // The stats for the filter.
   JwtAuthnFilterStats stats_;
+  // The stats for the token caches of the workers.
+  TokenCacheStats token_cache_stats_;
   // Thread local slot to store per-thread auth store
   ThreadLocal::SlotPtr tls_;
   // the cluster manager object.
@@ -58,6 +58,8 @@ public:
 
   bool isExpired() const override { return time_source_.monotonicTime() >= expiration_time_; }
 
+  uint64_t version() const override { return version_; }
+
   const ::google::jwt_verify::Jwks* setRemoteJwks(::google::jwt_verify::JwksPtr&& jwks) override {
     return setKey(std::move(jwks), getRemoteJwksExpirationTime());
   }
@@ -79,6 +81,7 @@ private:
                                            MonotonicTime expire) {
     jwks_obj_ = std::move(jwks);
     expiration_time_ = expire;
+    version_++;
     return jwks_obj_.get();
   }
 
@@ -91,6 +94,8 @@ private:
   TimeSource& time_source_;
   // The pubkey expiration time.
   MonotonicTime expiration_time_;
+  // The version of jwks_obj_.
+  uint64_t version_{};
 };
 
 class JwksCacheImpl : public JwksCache {
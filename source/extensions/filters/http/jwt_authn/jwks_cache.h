@@ -55,6 +55,10 @@ public:
     // Return true if jwks object is expired.
     virtual bool isExpired() const PURE;
 
+    // Get the version of the Jwks object, which changes whenever it is set, so that the results of
+    // verifying tokens with a Jwks object are not used with the next one.
+    virtual uint64_t version() const PURE;
+
     // Set a remote Jwks.
     virtual const ::google::jwt_verify::Jwks*
     setRemoteJwks(::google::jwt_verify::JwksPtr&& jwks) PURE;
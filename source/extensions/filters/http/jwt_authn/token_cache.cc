@@ -0,0 +1,34 @@
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+const TokenCache::Entry* TokenCache::lookup(absl::string_view token, uint64_t now) {
+  const uint64_t hash = HashUtil::xxHash64(token);
+  const Entry* entry = entries_.lookup(hash);
+  if (entry == nullptr || entry->token_ != token) {
+    return nullptr;
+  }
+  // If the exp claim does *not* appear in the JWT then the exp field is defaulted to 0.
+  const ::google::jwt_verify::Jwt& jwt = *entry->jwt_;
+  if (jwt.exp_ > 0 && jwt.exp_ < now) {
+    entries_.erase(hash);
+    return nullptr;
+  }
+  return entry;
+}
+
+void TokenCache::insert(absl::string_view token, JwtConstSharedPtr jwt,
+                        const JwksCache::JwksData& jwks_data) {
+  entries_.insert(HashUtil::xxHash64(token),
+                  {std::string(token), std::move(jwt), &jwks_data, jwks_data.version()});
+}
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
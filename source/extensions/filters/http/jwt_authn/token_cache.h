@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/lru_cache.h"
+
+#include "extensions/filters/http/jwt_authn/jwks_cache.h"
+
+#include "absl/strings/string_view.h"
+#include "jwt_verify_lib/jwt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+/**
+ * All stats for the JWT token cache. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_JWT_AUTHN_TOKEN_CACHE_STATS(COUNTER)                                                   \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)
+// clang-format on
+
+/**
+ * Struct definition for all JWT token cache stats. @see stats_macros.h
+ */
+struct TokenCacheStats {
+  ALL_JWT_AUTHN_TOKEN_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+using JwtConstSharedPtr = std::shared_ptr<const ::google::jwt_verify::Jwt>;
+
+class TokenCache;
+using TokenCachePtr = std::unique_ptr<TokenCache>;
+
+/**
+ * An LRU cache of the tokens a worker has verified, keyed by a hash of the token. A token is
+ * cached parsed, along with the version of the JWKS which its signature was verified with, so that
+ * it is neither parsed nor verified again while the JWKS of its provider stays the same. The
+ * claims of a cached token, such as its expiration and audiences, are still checked on every use.
+ */
+class TokenCache {
+public:
+  struct Entry {
+    // The full token, as tokens with the same hash may differ.
+    std::string token_;
+    JwtConstSharedPtr jwt_;
+    // The JWKS the signature was verified with.
+    const JwksCache::JwksData* jwks_data_;
+    uint64_t jwks_version_;
+  };
+
+  TokenCache(uint32_t max_entries, TokenCacheStats& stats) : entries_(max_entries), stats_(stats) {}
+
+  /**
+   * @param token supplies the token.
+   * @param now supplies the current time in seconds since the epoch.
+   * @return the entry of the token, which becomes the most recently used one, or nullptr if the
+   *         token is not cached or it has expired. The entry is valid until the next insert().
+   */
+  const Entry* lookup(absl::string_view token, uint64_t now);
+
+  /**
+   * Caches a token whose signature has been verified with the current JWKS of a provider, evicting
+   * the least recently used token if the cache is full.
+   */
+  void insert(absl::string_view token, JwtConstSharedPtr jwt,
+              const JwksCache::JwksData& jwks_data);
+
+  uint64_t size() const { return entries_.size(); }
+  TokenCacheStats& stats() { return stats_; }
+
+private:
+  // Keyed by the hashes of the tokens.
+  LruCache<uint64_t, Entry> entries_;
+  TokenCacheStats& stats_;
+};
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
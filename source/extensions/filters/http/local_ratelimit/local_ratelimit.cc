@@ -0,0 +1,159 @@
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+#include "envoy/http/codes.h"
+
+#include "common/common/fmt.h"
+#include "common/http/headers.h"
+
+#include "extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
+
+#include "absl/container/inlined_vector.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+struct RcDetailsValues {
+  // This request went above the configured limits for the local rate limit filter.
+  const std::string RateLimited = "local_rate_limited";
+};
+using RcDetails = ConstSingleton<RcDetailsValues>;
+
+FilterConfig::FilterConfig(
+    const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& config,
+    const LocalInfo::LocalInfo& local_info, Runtime::Loader& runtime,
+    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source)
+    : local_info_(local_info), runtime_(runtime), stage_(config.stage()),
+      stats_(generateStats(fmt::format("{}local_rate_limit.{}.", stats_prefix,
+                                       config.stat_prefix()),
+                           scope)) {
+  if (config.has_token_bucket()) {
+    token_bucket_ =
+        Filters::Common::LocalRateLimit::createTokenBucket(config.token_bucket(), time_source);
+  }
+  for (const auto& descriptor_config : config.descriptors()) {
+    RateLimit::Descriptor descriptor;
+    for (const auto& entry : descriptor_config.entries()) {
+      descriptor.entries_.push_back({entry.key(), entry.value()});
+    }
+    const bool inserted =
+        descriptor_buckets_
+            .emplace(descriptorKey(descriptor),
+                     Filters::Common::LocalRateLimit::createTokenBucket(
+                         descriptor_config.token_bucket(), time_source))
+            .second;
+    if (!inserted) {
+      throw EnvoyException("local rate limit: duplicate descriptor");
+    }
+  }
+}
+
+LocalRateLimitStats FilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+}
+
+std::string FilterConfig::descriptorKey(const RateLimit::Descriptor& descriptor) {
+  std::string key;
+  for (const RateLimit::DescriptorEntry& entry : descriptor.entries_) {
+    key.append(entry.key_);
+    key.push_back('\0');
+    key.append(entry.value_);
+    key.push_back('\0');
+  }
+  return key;
+}
+
+bool FilterConfig::requestAllowed(const std::vector<RateLimit::Descriptor>& descriptors) const {
+  // The buckets are shared by the workers, so they can not all be checked before consuming.
+  // Instead, the tokens taken before a bucket is found empty are given back.
+  absl::InlinedVector<SharedTokenBucketImpl*, 4> consumed;
+  const auto refund = [&consumed]() {
+    for (SharedTokenBucketImpl* bucket : consumed) {
+      bucket->refund(1);
+    }
+  };
+  for (const RateLimit::Descriptor& descriptor : descriptors) {
+    auto it = descriptor_buckets_.find(descriptorKey(descriptor));
+    if (it == descriptor_buckets_.end()) {
+      continue;
+    }
+    if (it->second->consume(1, false) == 0) {
+      refund();
+      return false;
+    }
+    consumed.push_back(it->second.get());
+  }
+  if (token_bucket_ != nullptr && token_bucket_->consume(1, false) == 0) {
+    refund();
+    return false;
+  }
+  return true;
+}
+
+Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool) {
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.http_filter_enabled", 100)) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  std::vector<RateLimit::Descriptor> descriptors;
+  if (config_->hasDescriptors()) {
+    Router::RouteConstSharedPtr route = decoder_callbacks_->route();
+    if (route && route->routeEntry()) {
+      const Router::RouteEntry& route_entry = *route->routeEntry();
+      populateRateLimitDescriptors(route_entry.rateLimitPolicy(), descriptors, route_entry,
+                                   headers);
+      if (route_entry.includeVirtualHostRateLimits()) {
+        populateRateLimitDescriptors(route_entry.virtualHost().rateLimitPolicy(), descriptors,
+                                     route_entry, headers);
+      }
+    }
+  }
+
+  if (config_->requestAllowed(descriptors)) {
+    config_->stats().ok_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().rate_limited_.inc();
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.http_filter_enforcing",
+                                                    100)) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  decoder_callbacks_->sendLocalReply(
+      Http::Code::TooManyRequests, "",
+      [](Http::HeaderMap& headers) {
+        headers.insertEnvoyRateLimited().value(Http::Headers::get().EnvoyRateLimitedValues.True);
+      },
+      absl::nullopt, RcDetails::get().RateLimited);
+  decoder_callbacks_->streamInfo().setResponseFlag(StreamInfo::ResponseFlag::RateLimited);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+void Filter::populateRateLimitDescriptors(const Router::RateLimitPolicy& rate_limit_policy,
+                                          std::vector<RateLimit::Descriptor>& descriptors,
+                                          const Router::RouteEntry& route_entry,
+                                          const Http::HeaderMap& headers) const {
+  for (const Router::RateLimitPolicyEntry& rate_limit :
+       rate_limit_policy.getApplicableRateLimit(config_->stage())) {
+    const std::string& disable_key = rate_limit.disableKey();
+    if (!disable_key.empty() &&
+        !config_->runtime().snapshot().featureEnabled(
+            fmt::format("local_ratelimit.{}.http_filter_enabled", disable_key), 100)) {
+      continue;
+    }
+    rate_limit.populateDescriptors(route_entry, descriptors, config_->localInfo().clusterName(),
+                                   headers,
+                                   *decoder_callbacks_->streamInfo().downstreamRemoteAddress());
+  }
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/local_rate_limit/v2alpha/local_rate_limit.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/router/router.h"
+#include "envoy/router/router_ratelimit.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/shared_token_bucket_impl.h"
+
+#include "extensions/filters/http/common/pass_through_filter.h"
+
+#include "absl/container/flat_hash_map.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * All local rate limit stats. @see stats_macros.h
+ */
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                        \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+
+/**
+ * Struct definition for all local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Global configuration for the HTTP local rate limit filter. The token buckets are shared by the
+ * filters of all the workers.
+ */
+class FilterConfig {
+public:
+  FilterConfig(const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& config,
+               const LocalInfo::LocalInfo& local_info, Runtime::Loader& runtime,
+               const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source);
+
+  /**
+   * Takes a token from the bucket of each of the given descriptors which has one, and from the
+   * bucket of all the requests. Tokens are only taken when all the buckets have one.
+   * @return bool whether the request is within the limits.
+   */
+  bool requestAllowed(const std::vector<RateLimit::Descriptor>& descriptors) const;
+
+  const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
+  Runtime::Loader& runtime() { return runtime_; }
+  uint64_t stage() const { return stage_; }
+  LocalRateLimitStats& stats() { return stats_; }
+
+  /**
+   * @return bool whether any descriptor has a token bucket, so descriptors need to be populated.
+   */
+  bool hasDescriptors() const { return !descriptor_buckets_.empty(); }
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+  static std::string descriptorKey(const RateLimit::Descriptor& descriptor);
+
+  const LocalInfo::LocalInfo& local_info_;
+  Runtime::Loader& runtime_;
+  const uint64_t stage_;
+  LocalRateLimitStats stats_;
+  SharedTokenBucketImplPtr token_bucket_;
+  absl::flat_hash_map<std::string, SharedTokenBucketImplPtr> descriptor_buckets_;
+};
+
+using FilterConfigSharedPtr = std::shared_ptr<FilterConfig>;
+
+/**
+ * HTTP local rate limit filter. Requests are limited with token buckets in the proxy, without
+ * calling the global rate limit service, so the limits apply to each proxy separately.
+ */
+class Filter : public Http::PassThroughDecoderFilter {
+public:
+  Filter(FilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+
+private:
+  void populateRateLimitDescriptors(const Router::RateLimitPolicy& rate_limit_policy,
+                                    std::vector<RateLimit::Descriptor>& descriptors,
+                                    const Router::RouteEntry& route_entry,
+                                    const Http::HeaderMap& headers) const;
+
+  FilterConfigSharedPtr config_;
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
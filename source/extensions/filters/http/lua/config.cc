@@ -13,10 +13,15 @@ namespace HttpFilters {
 namespace Lua {
 
 Http::FilterFactoryCb LuaFilterConfig::createFilterFactoryFromProtoTyped(
-    const envoy::config::filter::http::lua::v2::Lua& proto_config, const std::string&,
+    const envoy::config::filter::http::lua::v2::Lua& proto_config, const std::string& stats_prefix,
     Server::Configuration::FactoryContext& context) {
-  FilterConfigConstSharedPtr filter_config(new FilterConfig{
-      proto_config.inline_code(), context.threadLocal(), context.clusterManager()});
+  const std::string prefix =
+      proto_config.stat_prefix().empty()
+          ? fmt::format("{}lua.", stats_prefix)
+          : fmt::format("{}lua.{}.", stats_prefix, proto_config.stat_prefix());
+  FilterConfigConstSharedPtr filter_config(
+      new FilterConfig{proto_config.inline_code(), context.threadLocal(), context.clusterManager(),
+                       prefix, context.scope(), context.timeSource()});
   return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamFilter(std::make_shared<Filter>(filter_config));
   };
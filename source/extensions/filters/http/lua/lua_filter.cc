@@ -483,8 +483,11 @@ int StreamHandleWrapper::luaImportPublicKey(lua_State* state) {
 }
 
 FilterConfig::FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocator& tls,
-                           Upstream::ClusterManager& cluster_manager)
-    : cluster_manager_(cluster_manager), lua_state_(lua_code, tls) {
+                           Upstream::ClusterManager& cluster_manager,
+                           const std::string& stats_prefix, Stats::Scope& scope,
+                           TimeSource& time_source)
+    : cluster_manager_(cluster_manager), time_source_(time_source),
+      stats_(generateStats(stats_prefix, scope)), lua_state_(lua_code, tls, time_source) {
   lua_state_.registerType<Filters::Common::Lua::BufferWrapper>();
   lua_state_.registerType<Filters::Common::Lua::MetadataMapWrapper>();
   lua_state_.registerType<Filters::Common::Lua::MetadataMapIterator>();
@@ -509,6 +512,38 @@ FilterConfig::FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocat
   }
 }
 
+void FilterConfig::runtimeGCStep() {
+  const MonotonicTime start_time = time_source_.monotonicTime();
+  if (lua_state_.runtimeGCStep()) {
+    stats_.gc_pause_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                                        time_source_.monotonicTime() - start_time)
+                                        .count());
+  }
+}
+
+Filter::~Filter() {
+  // The stream handles refer to the coroutines, so they are released first. The filter is
+  // deferred deleted, so no script is running at this point.
+  request_stream_wrapper_.reset();
+  response_stream_wrapper_.reset();
+  const bool ran_script = request_coroutine_ != nullptr || response_coroutine_ != nullptr;
+  releaseCoroutine(request_coroutine_, config_->stats().request_script_time_us_);
+  releaseCoroutine(response_coroutine_, config_->stats().response_script_time_us_);
+  if (ran_script) {
+    config_->runtimeGCStep();
+  }
+}
+
+void Filter::releaseCoroutine(Filters::Common::Lua::CoroutinePtr& coroutine,
+                              Stats::Histogram& run_time) {
+  if (coroutine == nullptr) {
+    return;
+  }
+  run_time.recordValue(
+      std::chrono::duration_cast<std::chrono::microseconds>(coroutine->runTime()).count());
+  config_->releaseCoroutine(std::move(coroutine));
+}
+
 void Filter::onDestroy() {
   destroyed_ = true;
   if (request_stream_wrapper_.get()) {
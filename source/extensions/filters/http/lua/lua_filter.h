@@ -1,6 +1,9 @@
 #pragma once
 
+#include "envoy/common/time.h"
 #include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/crypto/utility.h"
@@ -287,22 +290,56 @@ private:
   Http::AsyncClient::Request* http_request_{};
 };
 
+/**
+ * All Lua filter stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LUA_FILTER_STATS(HISTOGRAM)                                                            \
+  HISTOGRAM(request_script_time_us, Microseconds)                                                  \
+  HISTOGRAM(response_script_time_us, Microseconds)                                                 \
+  HISTOGRAM(gc_pause_us, Microseconds)
+// clang-format on
+
+/**
+ * Struct definition for all Lua filter stats. @see stats_macros.h
+ */
+struct LuaFilterStats {
+  ALL_LUA_FILTER_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
 /**
  * Global configuration for the filter.
  */
 class FilterConfig : Logger::Loggable<Logger::Id::lua> {
 public:
   FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocator& tls,
-               Upstream::ClusterManager& cluster_manager);
+               Upstream::ClusterManager& cluster_manager, const std::string& stats_prefix,
+               Stats::Scope& scope, TimeSource& time_source);
   Filters::Common::Lua::CoroutinePtr createCoroutine() { return lua_state_.createCoroutine(); }
+  void releaseCoroutine(Filters::Common::Lua::CoroutinePtr&& coroutine) {
+    lua_state_.releaseCoroutine(std::move(coroutine));
+  }
   int requestFunctionRef() { return lua_state_.getGlobalRef(request_function_slot_); }
   int responseFunctionRef() { return lua_state_.getGlobalRef(response_function_slot_); }
   uint64_t runtimeBytesUsed() { return lua_state_.runtimeBytesUsed(); }
   void runtimeGC() { return lua_state_.runtimeGC(); }
 
+  /**
+   * Run an incremental GC step on the worker's state and record its duration.
+   */
+  void runtimeGCStep();
+
+  LuaFilterStats& stats() { return stats_; }
+
   Upstream::ClusterManager& cluster_manager_;
 
 private:
+  static LuaFilterStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return LuaFilterStats{ALL_LUA_FILTER_STATS(POOL_HISTOGRAM_PREFIX(scope, prefix))};
+  }
+
+  TimeSource& time_source_;
+  LuaFilterStats stats_;
   Filters::Common::Lua::ThreadLocalState lua_state_;
   uint64_t request_function_slot_;
   uint64_t response_function_slot_;
@@ -310,14 +347,13 @@ private:
 
 using FilterConfigConstSharedPtr = std::shared_ptr<FilterConfig>;
 
-// TODO(mattklein123): Filter stats.
-
 /**
  * The HTTP Lua filter. Allows scripts to run in both the request an response flow.
  */
 class Filter : public Http::StreamFilter, Logger::Loggable<Logger::Id::lua> {
 public:
   Filter(FilterConfigConstSharedPtr config) : config_(config) {}
+  ~Filter() override;
 
   Upstream::ClusterManager& clusterManager() { return config_->cluster_manager_; }
   void scriptError(const Filters::Common::Lua::LuaException& e);
@@ -411,6 +447,7 @@ private:
                                       Http::HeaderMap& headers, bool end_stream);
   Http::FilterDataStatus doData(StreamHandleRef& handle, Buffer::Instance& data, bool end_stream);
   Http::FilterTrailersStatus doTrailers(StreamHandleRef& handle, Http::HeaderMap& trailers);
+  void releaseCoroutine(Filters::Common::Lua::CoroutinePtr& coroutine, Stats::Histogram& run_time);
 
   FilterConfigConstSharedPtr config_;
   DecoderCallbacks decoder_callbacks_{*this};
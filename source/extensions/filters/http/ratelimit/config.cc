@@ -9,6 +9,7 @@
 #include "common/config/filter_json.h"
 #include "common/protobuf/utility.h"
 
+#include "extensions/filters/common/ratelimit/quota_lease_impl.h"
 #include "extensions/filters/common/ratelimit/ratelimit_impl.h"
 #include "extensions/filters/http/ratelimit/ratelimit.h"
 
@@ -27,11 +28,31 @@ Http::FilterFactoryCb RateLimitFilterConfig::createFilterFactoryFromProtoTyped(
   const std::chrono::milliseconds timeout =
       std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(proto_config, timeout, 20));
 
-  return [proto_config, &context, timeout,
-          filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+  if (!proto_config.has_quota_lease()) {
+    return [proto_config, &context, timeout,
+            filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+      callbacks.addStreamFilter(std::make_shared<Filter>(
+          filter_config, Filters::Common::RateLimit::rateLimitClient(
+                             context, proto_config.rate_limit_service().grpc_service(), timeout)));
+    };
+  }
+
+  // The leased requests are kept per worker, so that they are used without locking.
+  const uint32_t hits = proto_config.quota_lease().hits();
+  const std::chrono::milliseconds duration(
+      DurationUtil::durationToMilliseconds(proto_config.quota_lease().duration()));
+  std::shared_ptr<ThreadLocal::Slot> slot = context.threadLocal().allocateSlot();
+  slot->set([&context](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<Filters::Common::RateLimit::QuotaLeaseCache>(context.timeSource());
+  });
+  return [proto_config, &context, timeout, filter_config, hits, duration,
+          slot](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamFilter(std::make_shared<Filter>(
-        filter_config, Filters::Common::RateLimit::rateLimitClient(
-                           context, proto_config.rate_limit_service().grpc_service(), timeout)));
+        filter_config,
+        std::make_unique<Filters::Common::RateLimit::QuotaLeaseClientImpl>(
+            Filters::Common::RateLimit::rateLimitClient(
+                context, proto_config.rate_limit_service().grpc_service(), timeout, hits),
+            slot->getTyped<Filters::Common::RateLimit::QuotaLeaseCache>(), hits, duration)));
   };
 }
 
@@ -60,6 +60,12 @@ public:
   const std::string OriginalSrc = "envoy.filters.http.original_src";
   // Dynamic forward proxy filter
   const std::string DynamicForwardProxy = "envoy.filters.http.dynamic_forward_proxy";
+  // Decompressor filter
+  const std::string Decompressor = "envoy.filters.http.decompressor";
+  // Cache filter
+  const std::string Cache = "envoy.filters.http.cache";
+  // Local rate limit filter
+  const std::string LocalRateLimit = "envoy.filters.http.local_ratelimit";
 
   // Converts names from v1 to v2
   const Config::V1Converter v1_converter_;
@@ -0,0 +1,31 @@
+#include "extensions/filters/network/local_ratelimit/config.h"
+
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/network/local_ratelimit/local_ratelimit.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+Network::FilterFactoryCb LocalRateLimitConfigFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  ConfigSharedPtr config = std::make_shared<Config>(proto_config, context.runtime(),
+                                                    context.scope(), context.timeSource());
+  return [config](Network::FilterManager& filter_manager) -> void {
+    filter_manager.addReadFilter(std::make_shared<Filter>(config));
+  };
+}
+
+/**
+ * Static registration for the local rate limit filter. @see RegisterFactory.
+ */
+REGISTER_FACTORY(LocalRateLimitConfigFactory,
+                 Server::Configuration::NamedNetworkFilterConfigFactory);
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,46 @@
+#include "extensions/filters/network/local_ratelimit/local_ratelimit.h"
+
+#include "envoy/network/connection.h"
+
+#include "common/common/fmt.h"
+
+#include "extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+Config::Config(
+    const envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit& proto_config,
+    Runtime::Loader& runtime, Stats::Scope& scope, TimeSource& time_source)
+    : runtime_(runtime),
+      stats_(generateStats(fmt::format("local_ratelimit.{}.", proto_config.stat_prefix()), scope)),
+      token_bucket_(Filters::Common::LocalRateLimit::createTokenBucket(proto_config.token_bucket(),
+                                                                      time_source)) {}
+
+LocalRateLimitStats Config::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+}
+
+Network::FilterStatus Filter::onNewConnection() {
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.tcp_filter_enabled", 100)) {
+    return Network::FilterStatus::Continue;
+  }
+
+  if (!config_->canCreateConnection()) {
+    config_->stats().rate_limited_.inc();
+    if (config_->runtime().snapshot().featureEnabled("local_ratelimit.tcp_filter_enforcing",
+                                                     100)) {
+      read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+      return Network::FilterStatus::StopIteration;
+    }
+  }
+
+  return Network::FilterStatus::Continue;
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/common/token_bucket.h"
+#include "envoy/config/filter/network/local_rate_limit/v2alpha/local_rate_limit.pb.h"
+#include "envoy/network/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * All local rate limit stats. @see stats_macros.h
+ */
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER) COUNTER(rate_limited)
+
+/**
+ * Struct definition for all local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Global configuration for the network local rate limit filter. The token bucket is shared by the
+ * filters of all the workers.
+ */
+class Config {
+public:
+  Config(
+      const envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit& proto_config,
+      Runtime::Loader& runtime, Stats::Scope& scope, TimeSource& time_source);
+
+  /**
+   * Takes a token from the bucket for a new connection.
+   * @return bool whether the connection is within the limit.
+   */
+  bool canCreateConnection() { return token_bucket_->consume(1, false) != 0; }
+
+  Runtime::Loader& runtime() { return runtime_; }
+  LocalRateLimitStats& stats() { return stats_; }
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  Runtime::Loader& runtime_;
+  LocalRateLimitStats stats_;
+  TokenBucketPtr token_bucket_;
+};
+
+using ConfigSharedPtr = std::shared_ptr<Config>;
+
+/**
+ * Network local rate limit filter. New connections take a token from a bucket in the proxy, and
+ * are closed before any further filters are called when there is none.
+ */
+class Filter : public Network::ReadFilter {
+public:
+  Filter(ConfigSharedPtr config) : config_(config) {}
+
+  // Network::ReadFilter
+  Network::FilterStatus onData(Buffer::Instance&, bool) override {
+    return Network::FilterStatus::Continue;
+  }
+  Network::FilterStatus onNewConnection() override;
+  void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override {
+    read_callbacks_ = &callbacks;
+  }
+
+private:
+  ConfigSharedPtr config_;
+  Network::ReadFilterCallbacks* read_callbacks_{};
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
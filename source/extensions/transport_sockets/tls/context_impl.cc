@@ -14,10 +14,12 @@
 #include "common/common/base64.h"
 #include "common/common/fmt.h"
 #include "common/common/hex.h"
+#include "common/common/macros.h"
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/protobuf/utility.h"
 
+#include "extensions/transport_sockets/tls/session_cache_impl.h"
 #include "extensions/transport_sockets/tls/utility.h"
 
 #include "openssl/evp.h"
@@ -52,6 +54,7 @@ ContextImpl::ContextImpl(Stats::Scope& scope, const Envoy::Ssl::ContextConfig& c
                          TimeSource& time_source)
     : scope_(scope), stats_(generateStats(scope)), time_source_(time_source),
       tls_max_version_(config.maxProtocolVersion()),
+      kernel_tls_offload_(config.kernelTlsOffload()),
       stat_name_set_(scope.symbolTable().makeSet("TransportSockets::Tls")),
       unknown_ssl_cipher_(stat_name_set_->add("unknown_ssl_cipher")),
       unknown_ssl_curve_(stat_name_set_->add("unknown_ssl_curve")),
@@ -747,11 +750,15 @@ Envoy::Ssl::CertificateDetailsPtr ContextImpl::certificateDetails(X509* cert,
 
 ClientContextImpl::ClientContextImpl(Stats::Scope& scope,
                                      const Envoy::Ssl::ClientContextConfig& config,
-                                     TimeSource& time_source)
+                                     TimeSource& time_source,
+                                     Envoy::Ssl::SessionCacheSharedPtr session_cache)
     : ContextImpl(scope, config, time_source),
       server_name_indication_(config.serverNameIndication()),
       allow_renegotiation_(config.allowRenegotiation()),
-      max_session_keys_(config.maxSessionKeys()) {
+      max_session_keys_(config.maxSessionKeys()),
+      session_cache_(session_cache != nullptr ? std::move(session_cache)
+                                              : std::make_shared<SessionCacheImpl>(1)),
+      session_cache_key_prefix_(generateSessionCacheKeyPrefix(config)) {
   // This should be guaranteed during configuration ingestion for client contexts.
   ASSERT(tls_contexts_.size() == 1);
   if (!parsed_alpn_protocols_.empty()) {
@@ -780,7 +787,7 @@ ClientContextImpl::ClientContextImpl(Stats::Scope& scope,
               static_cast<ContextImpl*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
           ClientContextImpl* client_context_impl = dynamic_cast<ClientContextImpl*>(context_impl);
           RELEASE_ASSERT(client_context_impl != nullptr, ""); // for Coverity
-          return client_context_impl->newSessionKey(session);
+          return client_context_impl->newSessionKey(ssl, session);
         });
   }
 }
@@ -817,50 +824,111 @@ bssl::UniquePtr<SSL> ClientContextImpl::newSsl(const Network::TransportSocketOpt
   }
 
   if (max_session_keys_ > 0) {
-    if (session_keys_single_use_) {
-      // Stored single-use session keys, use write/write locks.
-      absl::WriterMutexLock l(&session_keys_mu_);
-      if (!session_keys_.empty()) {
-        // Use the most recently stored session key, since it has the highest
-        // probability of still being recognized/accepted by the server.
-        SSL_SESSION* session = session_keys_.front().get();
-        SSL_set_session(ssl_con.get(), session);
-        // Remove single-use session key (TLS 1.3) after first use.
-        if (SSL_SESSION_should_be_single_use(session)) {
-          session_keys_.pop_front();
-        }
-      }
+    // The key is attached to the connection so that a session issued by the server is stored
+    // under the same key it was looked up with, see newSessionKey().
+    auto session_cache_key =
+        std::make_unique<std::string>(sessionCacheKey(server_name_indication, options));
+    bssl::UniquePtr<SSL_SESSION> session = session_cache_->lookup(*session_cache_key);
+    if (session != nullptr) {
+      stats_.session_cache_hit_.inc();
+      int rc = SSL_set_session(ssl_con.get(), session.get());
+      RELEASE_ASSERT(rc == 1, "");
     } else {
-      // Never stored single-use session keys, use read/write locks.
-      absl::ReaderMutexLock l(&session_keys_mu_);
-      if (!session_keys_.empty()) {
-        // Use the most recently stored session key, since it has the highest
-        // probability of still being recognized/accepted by the server.
-        SSL_SESSION* session = session_keys_.front().get();
-        SSL_set_session(ssl_con.get(), session);
-      }
+      stats_.session_cache_miss_.inc();
     }
+    int rc = SSL_set_ex_data(ssl_con.get(), sessionCacheKeyIndex(), session_cache_key.release());
+    RELEASE_ASSERT(rc == 1, "");
   }
 
   return ssl_con;
 }
 
-int ClientContextImpl::newSessionKey(SSL_SESSION* session) {
-  // In case we ever store single-use session key (TLS 1.3),
-  // we need to switch to using write/write locks.
-  if (SSL_SESSION_should_be_single_use(session)) {
-    session_keys_single_use_ = true;
+int ClientContextImpl::newSessionKey(SSL* ssl, SSL_SESSION* session) {
+  const std::string* session_cache_key =
+      static_cast<const std::string*>(SSL_get_ex_data(ssl, sessionCacheKeyIndex()));
+  if (session_cache_key == nullptr) {
+    return 0; // Tell BoringSSL that we didn't take ownership of the session.
   }
-  absl::WriterMutexLock l(&session_keys_mu_);
-  // Evict oldest entries.
-  while (session_keys_.size() >= max_session_keys_) {
-    session_keys_.pop_back();
-  }
-  // Add new session key at the front of the queue, so that it's used first.
-  session_keys_.push_front(bssl::UniquePtr<SSL_SESSION>(session));
+  session_cache_->insert(*session_cache_key, bssl::UniquePtr<SSL_SESSION>(session),
+                         max_session_keys_);
   return 1; // Tell BoringSSL that we took ownership of the session.
 }
 
+int ClientContextImpl::sessionCacheKeyIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                     [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+                                       delete static_cast<std::string*>(ptr);
+                                     });
+    RELEASE_ASSERT(index >= 0, "");
+    return index;
+  }());
+}
+
+std::string
+ClientContextImpl::sessionCacheKey(const std::string& server_name_indication,
+                                   const Network::TransportSocketOptions* options) const {
+  // The subject alt names to verify can be overridden per connection, in which case sessions
+  // must not be shared with connections that verified the server against a different list.
+  if (options && !options->verifySubjectAltNameListOverride().empty()) {
+    return absl::StrCat(session_cache_key_prefix_, ":", server_name_indication, ":",
+                        absl::StrJoin(options->verifySubjectAltNameListOverride(), ","));
+  }
+  return absl::StrCat(session_cache_key_prefix_, ":", server_name_indication);
+}
+
+std::string ClientContextImpl::generateSessionCacheKeyPrefix(
+    const Envoy::Ssl::ClientContextConfig& config) {
+  EVP_MD_CTX md;
+  int rc = EVP_DigestInit(&md, EVP_sha256());
+  RELEASE_ASSERT(rc == 1, "");
+
+  // Each value is prefixed with its length, so that adjacent values can't be confused.
+  const auto digest_update = [&md](absl::string_view value) {
+    const uint64_t length = value.size();
+    int update_rc = EVP_DigestUpdate(&md, &length, sizeof(length));
+    RELEASE_ASSERT(update_rc == 1, "");
+    update_rc = EVP_DigestUpdate(&md, value.data(), value.size());
+    RELEASE_ASSERT(update_rc == 1, "");
+  };
+
+  // Hash all the settings that affect how the server is validated, and which identity and
+  // parameters are presented to it. Contexts with the same hash share sessions, which allows
+  // resumption to continue across context updates (e.g. via SDS) that don't change any of these.
+  digest_update(config.serverNameIndication());
+  digest_update(config.alpnProtocols());
+  digest_update(config.cipherSuites());
+  digest_update(config.ecdhCurves());
+  digest_update(config.signingAlgorithmsForTest());
+  digest_update(absl::StrCat(config.minProtocolVersion(), ":", config.maxProtocolVersion(), ":",
+                             config.maxSessionKeys(), ":", config.allowRenegotiation()));
+  for (const auto& tls_certificate : config.tlsCertificates()) {
+    digest_update(tls_certificate.get().certificateChain());
+  }
+  const Envoy::Ssl::CertificateValidationContextConfig* validation_context =
+      config.certificateValidationContext();
+  if (validation_context != nullptr) {
+    digest_update(validation_context->caCert());
+    digest_update(validation_context->certificateRevocationList());
+    for (const auto& name : validation_context->verifySubjectAltNameList()) {
+      digest_update(name);
+    }
+    for (const auto& hash : validation_context->verifyCertificateHashList()) {
+      digest_update(hash);
+    }
+    for (const auto& hash : validation_context->verifyCertificateSpkiList()) {
+      digest_update(hash);
+    }
+    digest_update(validation_context->allowExpiredCertificate() ? "1" : "0");
+  }
+
+  uint8_t hash_buffer[EVP_MAX_MD_SIZE];
+  unsigned hash_length = 0;
+  rc = EVP_DigestFinal(&md, hash_buffer, &hash_length);
+  RELEASE_ASSERT(rc == 1 && hash_length == SHA256_DIGEST_LENGTH, "");
+  return Hex::encode(hash_buffer, hash_length);
+}
+
 uint16_t ClientContextImpl::parseSigningAlgorithmsForTest(const std::string& sigalgs) {
   // This is used only when testing RSA/ECDSA certificate selection, so only the signing algorithms
   // used in tests are supported here.
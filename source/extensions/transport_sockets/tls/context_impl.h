@@ -1,6 +1,5 @@
 #pragma once
 
-#include <deque>
 #include <functional>
 #include <string>
 #include <vector>
@@ -9,6 +8,7 @@
 #include "envoy/ssl/context.h"
 #include "envoy/ssl/context_config.h"
 #include "envoy/ssl/private_key/private_key.h"
+#include "envoy/ssl/session_cache.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
 
@@ -16,7 +16,6 @@
 
 #include "extensions/transport_sockets/tls/context_manager_impl.h"
 
-#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "openssl/ssl.h"
 
@@ -34,11 +33,15 @@ namespace Tls {
   COUNTER(connection_error)                                                                        \
   COUNTER(handshake)                                                                               \
   COUNTER(session_reused)                                                                          \
+  COUNTER(session_cache_hit)                                                                       \
+  COUNTER(session_cache_miss)                                                                      \
   COUNTER(no_certificate)                                                                          \
   COUNTER(fail_verify_no_cert)                                                                     \
   COUNTER(fail_verify_error)                                                                       \
   COUNTER(fail_verify_san)                                                                         \
-  COUNTER(fail_verify_cert_hash)
+  COUNTER(fail_verify_cert_hash)                                                                   \
+  COUNTER(kernel_tls_tx_offload)                                                                   \
+  COUNTER(kernel_tls_rx_offload)
 // clang-format on
 
 /**
@@ -77,6 +80,12 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return true if the record layer of established connections should be offloaded to the
+   *         kernel when possible.
+   */
+  bool kernelTlsOffload() const { return kernel_tls_offload_; }
+
   // Ssl::Context
   size_t daysUntilFirstCertExpires() const override;
   Envoy::Ssl::CertificateDetailsPtr getCaCertInformation() const override;
@@ -171,6 +180,7 @@ protected:
   std::string cert_chain_file_path_;
   TimeSource& time_source_;
   const unsigned tls_max_version_;
+  const bool kernel_tls_offload_;
   mutable Stats::StatNameSetPtr stat_name_set_;
   const Stats::StatName unknown_ssl_cipher_;
   const Stats::StatName unknown_ssl_curve_;
@@ -186,21 +196,32 @@ using ContextImplSharedPtr = std::shared_ptr<ContextImpl>;
 
 class ClientContextImpl : public ContextImpl, public Envoy::Ssl::ClientContext {
 public:
+  /**
+   * @param session_cache supplies the cache to store sessions in for resumption. Contexts
+   *        sharing a cache resume each other's sessions if their configurations match. If
+   *        nullptr, the context uses a cache of its own.
+   */
   ClientContextImpl(Stats::Scope& scope, const Envoy::Ssl::ClientContextConfig& config,
-                    TimeSource& time_source);
+                    TimeSource& time_source,
+                    Envoy::Ssl::SessionCacheSharedPtr session_cache = nullptr);
 
   bssl::UniquePtr<SSL> newSsl(const Network::TransportSocketOptions* options) override;
 
 private:
-  int newSessionKey(SSL_SESSION* session);
+  int newSessionKey(SSL* ssl, SSL_SESSION* session);
   uint16_t parseSigningAlgorithmsForTest(const std::string& sigalgs);
+  std::string sessionCacheKey(const std::string& server_name_indication,
+                              const Network::TransportSocketOptions* options) const;
+
+  // The SSL ex_data index used to store the session cache key of a connection.
+  static int sessionCacheKeyIndex();
+  static std::string generateSessionCacheKeyPrefix(const Envoy::Ssl::ClientContextConfig& config);
 
   const std::string server_name_indication_;
   const bool allow_renegotiation_;
   const size_t max_session_keys_;
-  absl::Mutex session_keys_mu_;
-  std::deque<bssl::UniquePtr<SSL_SESSION>> session_keys_ ABSL_GUARDED_BY(session_keys_mu_);
-  bool session_keys_single_use_{false};
+  const Envoy::Ssl::SessionCacheSharedPtr session_cache_;
+  const std::string session_cache_key_prefix_;
 };
 
 class ServerContextImpl : public ContextImpl, public Envoy::Ssl::ServerContext {
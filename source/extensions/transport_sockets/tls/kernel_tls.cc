@@ -0,0 +1,189 @@
+#include "extensions/transport_sockets/tls/kernel_tls.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/api/os_sys_calls_impl.h"
+
+#include "openssl/mem.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+// RX offload and record types were added after TX offload, only use kernel headers with both.
+#if defined(TLS_RX) && defined(TLS_GET_RECORD_TYPE)
+#define ENVOY_KERNEL_TLS
+#endif
+#endif
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace KernelTls {
+
+#ifdef ENVOY_KERNEL_TLS
+
+namespace {
+
+// Not defined by older libc headers.
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+// The fixed part of the AES-GCM nonce, which is the same size for both key sizes.
+constexpr size_t SaltSize = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+
+using SetCryptoInfo = bool (*)(int fd, int direction, const uint8_t* key, const uint8_t* salt,
+                               uint64_t sequence);
+
+template <class CryptoInfo, uint16_t CipherType>
+bool setCryptoInfo(int fd, int direction, const uint8_t* key, const uint8_t* salt,
+                   uint64_t sequence) {
+  CryptoInfo info;
+  memset(&info, 0, sizeof(info));
+  static_assert(sizeof(info.salt) == SaltSize, "unexpected AES-GCM salt size");
+  static_assert(sizeof(info.rec_seq) == sizeof(uint64_t), "unexpected record sequence size");
+  static_assert(sizeof(info.iv) == sizeof(info.rec_seq), "unexpected AES-GCM IV size");
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = CipherType;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, salt, sizeof(info.salt));
+  for (size_t i = 0; i < sizeof(info.rec_seq); i++) {
+    info.rec_seq[sizeof(info.rec_seq) - 1 - i] = static_cast<uint8_t>(sequence >> (8 * i));
+  }
+  // BoringSSL uses the record sequence number as the explicit part of the AES-GCM nonce, and so
+  // does the kernel once it is given the initial one.
+  memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+
+  const Api::SysCallIntResult result =
+      Api::OsSysCallsSingleton::get().setsockopt(fd, SOL_TLS, direction, &info, sizeof(info));
+  OPENSSL_cleanse(&info, sizeof(info));
+  return result.rc_ == 0;
+}
+
+} // namespace
+
+bool supported() { return true; }
+
+Offload enable(SSL* ssl, int fd) {
+  Offload offload;
+  if (SSL_version(ssl) != TLS1_2_VERSION) {
+    return offload;
+  }
+
+  size_t key_size;
+  SetCryptoInfo set_crypto_info;
+  switch (SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl))) {
+  case NID_aes_128_gcm:
+    key_size = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+    set_crypto_info = setCryptoInfo<tls12_crypto_info_aes_gcm_128, TLS_CIPHER_AES_GCM_128>;
+    break;
+#ifdef TLS_CIPHER_AES_GCM_256
+  case NID_aes_256_gcm:
+    key_size = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+    set_crypto_info = setCryptoInfo<tls12_crypto_info_aes_gcm_256, TLS_CIPHER_AES_GCM_256>;
+    break;
+#endif
+  default:
+    return offload;
+  }
+
+  // AEAD cipher suites have no MAC keys, so the key block is made of the client and server write
+  // keys followed by their fixed IVs.
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl));
+  if (key_block.size() != 2 * (key_size + SaltSize) ||
+      !SSL_generate_key_block(ssl, key_block.data(), key_block.size())) {
+    return offload;
+  }
+  const uint8_t* client_key = key_block.data();
+  const uint8_t* server_key = client_key + key_size;
+  const uint8_t* client_salt = server_key + key_size;
+  const uint8_t* server_salt = client_salt + SaltSize;
+  const bool is_server = SSL_is_server(ssl);
+
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  static const char ulp[] = "tls";
+  if (os_sys_calls.setsockopt(fd, IPPROTO_TCP, TCP_ULP, ulp, sizeof(ulp)).rc_ == 0) {
+    offload.tx_ = set_crypto_info(fd, TLS_TX, is_server ? server_key : client_key,
+                                  is_server ? server_salt : client_salt,
+                                  SSL_get_write_sequence(ssl));
+    if (!SSL_has_pending(ssl)) {
+      offload.rx_ = set_crypto_info(fd, TLS_RX, is_server ? client_key : server_key,
+                                    is_server ? client_salt : server_salt,
+                                    SSL_get_read_sequence(ssl));
+    }
+  }
+  OPENSSL_cleanse(key_block.data(), key_block.size());
+  return offload;
+}
+
+bool sendCloseNotify(int fd) {
+  uint8_t alert[] = {SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY};
+  iovec iov{alert, sizeof(alert)};
+  alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(uint8_t))];
+  memset(control, 0, sizeof(control));
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+
+  return Api::OsSysCallsSingleton::get().sendmsg(fd, &message, 0).rc_ ==
+         static_cast<ssize_t>(sizeof(alert));
+}
+
+bool readCloseNotify(int fd) {
+  uint8_t record[2];
+  iovec iov{record, sizeof(record)};
+  alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(uint8_t))];
+  memset(control, 0, sizeof(control));
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  const Api::SysCallSizeResult result = Api::OsSysCallsSingleton::get().recvmsg(fd, &message, 0);
+  if (result.rc_ != static_cast<ssize_t>(sizeof(record))) {
+    return false;
+  }
+  const cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  return cmsg != nullptr && cmsg->cmsg_level == SOL_TLS &&
+         cmsg->cmsg_type == TLS_GET_RECORD_TYPE && *CMSG_DATA(cmsg) == SSL3_RT_ALERT &&
+         record[1] == SSL_AD_CLOSE_NOTIFY;
+}
+
+#else
+
+bool supported() { return false; }
+
+Offload enable(SSL*, int) { return {}; }
+
+bool sendCloseNotify(int) { return false; }
+
+bool readCloseNotify(int) { return false; }
+
+#endif
+
+} // namespace KernelTls
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
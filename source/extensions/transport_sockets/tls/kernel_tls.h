@@ -0,0 +1,54 @@
+#pragma once
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace KernelTls {
+
+/**
+ * The directions of a connection whose record layer is handled by the kernel.
+ */
+struct Offload {
+  bool tx_{};
+  bool rx_{};
+};
+
+/**
+ * @return true if Envoy was built with kernel TLS support. Whether the running kernel supports it
+ *         is only known once offload is attempted.
+ */
+bool supported();
+
+/**
+ * Hands the traffic keys of an established connection to the kernel, so that records are
+ * encrypted and decrypted by the kernel rather than by BoringSSL. Only TLS 1.2 connections using
+ * AES-GCM are offloaded. RX is only offloaded if BoringSSL has no buffered data, since the kernel
+ * can't decrypt records which were already read from the socket.
+ * @param ssl supplies the connection, which must have completed its handshake.
+ * @param fd supplies the socket of the connection.
+ * @return the directions which were offloaded. Directions which weren't offloaded, e.g. because
+ *         the kernel lacks support, must keep using BoringSSL.
+ */
+Offload enable(SSL* ssl, int fd);
+
+/**
+ * Sends a close_notify alert on a socket whose TX is offloaded.
+ * @return true if the alert was written to the socket.
+ */
+bool sendCloseNotify(int fd);
+
+/**
+ * Reads a record other than application data from a socket whose RX is offloaded. Reading such a
+ * record without asking for its type fails with EIO.
+ * @return true if the record is a close_notify alert.
+ */
+bool readCloseNotify(int fd);
+
+} // namespace KernelTls
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,386 @@
+#include "extensions/transport_sockets/tls/private_key/thread_pool_provider.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+
+#include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+#include "common/common/macros.h"
+#include "common/config/datasource.h"
+#include "common/config/utility.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/transport_sockets/well_known_names.h"
+
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+#include "openssl/rsa.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+namespace {
+
+ThreadPoolPrivateKeyConnection* getConnection(SSL* ssl, int index) {
+  return static_cast<ThreadPoolPrivateKeyConnection*>(SSL_get_ex_data(ssl, index));
+}
+
+ssl_private_key_result_t sign(SSL* ssl, int index, uint8_t* out, size_t* out_len, size_t max_out,
+                              uint16_t signature_algorithm, const uint8_t* in, size_t in_len) {
+  ThreadPoolPrivateKeyConnection* connection = getConnection(ssl, index);
+  if (connection == nullptr) {
+    return ssl_private_key_failure;
+  }
+  return connection->start(PrivateKeyOperation::Type::Sign, signature_algorithm, out, out_len,
+                           max_out, in, in_len);
+}
+
+ssl_private_key_result_t complete(SSL* ssl, int index, uint8_t* out, size_t* out_len,
+                                  size_t max_out) {
+  ThreadPoolPrivateKeyConnection* connection = getConnection(ssl, index);
+  if (connection == nullptr) {
+    return ssl_private_key_failure;
+  }
+  return connection->complete(out, out_len, max_out);
+}
+
+ssl_private_key_result_t rsaSign(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out,
+                                 uint16_t signature_algorithm, const uint8_t* in, size_t in_len) {
+  return sign(ssl, ThreadPoolPrivateKeyMethodProvider::rsaConnectionIndex(), out, out_len, max_out,
+              signature_algorithm, in, in_len);
+}
+
+ssl_private_key_result_t rsaDecrypt(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out,
+                                    const uint8_t* in, size_t in_len) {
+  ThreadPoolPrivateKeyConnection* connection =
+      getConnection(ssl, ThreadPoolPrivateKeyMethodProvider::rsaConnectionIndex());
+  if (connection == nullptr) {
+    return ssl_private_key_failure;
+  }
+  return connection->start(PrivateKeyOperation::Type::Decrypt, 0, out, out_len, max_out, in,
+                           in_len);
+}
+
+ssl_private_key_result_t rsaComplete(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out) {
+  return complete(ssl, ThreadPoolPrivateKeyMethodProvider::rsaConnectionIndex(), out, out_len,
+                  max_out);
+}
+
+ssl_private_key_result_t ecdsaSign(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out,
+                                   uint16_t signature_algorithm, const uint8_t* in, size_t in_len) {
+  return sign(ssl, ThreadPoolPrivateKeyMethodProvider::ecdsaConnectionIndex(), out, out_len,
+              max_out, signature_algorithm, in, in_len);
+}
+
+ssl_private_key_result_t ecdsaDecrypt(SSL*, uint8_t*, size_t*, size_t, const uint8_t*, size_t) {
+  // Decryption is only used by RSA key exchange.
+  return ssl_private_key_failure;
+}
+
+ssl_private_key_result_t ecdsaComplete(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out) {
+  return complete(ssl, ThreadPoolPrivateKeyMethodProvider::ecdsaConnectionIndex(), out, out_len,
+                  max_out);
+}
+
+bool signWithKey(EVP_PKEY* pkey, uint16_t signature_algorithm, const std::vector<uint8_t>& in,
+                 std::vector<uint8_t>& out) {
+  if (SSL_get_signature_algorithm_key_type(signature_algorithm) != EVP_PKEY_id(pkey)) {
+    return false;
+  }
+
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pctx;
+  if (!EVP_DigestSignInit(ctx.get(), &pctx, SSL_get_signature_algorithm_digest(signature_algorithm),
+                          nullptr, pkey)) {
+    return false;
+  }
+  if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm) &&
+      (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) ||
+       !EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1 /* salt length is the digest length */))) {
+    return false;
+  }
+
+  size_t out_len = out.size();
+  if (!EVP_DigestSign(ctx.get(), out.data(), &out_len, in.data(), in.size())) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+bool decryptWithKey(EVP_PKEY* pkey, const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+  RSA* rsa = EVP_PKEY_get0_RSA(pkey);
+  if (rsa == nullptr) {
+    return false;
+  }
+
+  size_t out_len;
+  if (!RSA_decrypt(rsa, &out_len, out.data(), out.size(), in.data(), in.size(), RSA_NO_PADDING)) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+int createIndex() {
+  int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  RELEASE_ASSERT(index >= 0, "Failed to get SSL user data index.");
+  return index;
+}
+
+} // namespace
+
+ThreadPoolPrivateKeyConnection::~ThreadPoolPrivateKeyConnection() { detachOperation(); }
+
+void ThreadPoolPrivateKeyConnection::detachOperation() {
+  if (operation_ != nullptr) {
+    Thread::LockGuard lock(operation_->lock_);
+    operation_->connection_ = nullptr;
+  }
+  operation_.reset();
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyConnection::start(PrivateKeyOperation::Type type,
+                                                                uint16_t signature_algorithm,
+                                                                uint8_t* out, size_t* out_len,
+                                                                size_t max_out, const uint8_t* in,
+                                                                size_t in_len) {
+  ASSERT(operation_ == nullptr);
+  operation_done_ = false;
+  operation_ = std::make_shared<PrivateKeyOperation>(type, signature_algorithm, in, in_len,
+                                                     max_out, *this, dispatcher_);
+  if (provider_.enqueue(operation_)) {
+    return ssl_private_key_retry;
+  }
+
+  // The pool is saturated. Adding to the queue would only add latency to every handshake waiting
+  // on it, so perform the operation on this thread instead.
+  provider_.stats().queue_overflow_.inc();
+  provider_.performOperation(*operation_);
+  operation_done_ = true;
+  return complete(out, out_len, max_out);
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyConnection::complete(uint8_t* out, size_t* out_len,
+                                                                   size_t max_out) {
+  if (operation_ == nullptr) {
+    return ssl_private_key_failure;
+  }
+  if (!operation_done_) {
+    // The operation didn't finish yet, retry.
+    return ssl_private_key_retry;
+  }
+
+  PrivateKeyOperationSharedPtr operation = operation_;
+  detachOperation();
+  if (!operation->success_ || operation->output_.size() > max_out) {
+    provider_.stats().failed_.inc();
+    return ssl_private_key_failure;
+  }
+  std::copy(operation->output_.begin(), operation->output_.end(), out);
+  *out_len = operation->output_.size();
+  return ssl_private_key_success;
+}
+
+void ThreadPoolPrivateKeyConnection::onOperationComplete() {
+  ASSERT(operation_ != nullptr);
+  provider_.stats().operation_time_us_.recordValue(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          dispatcher_.timeSource().monotonicTime() - operation_->start_time_)
+          .count());
+  operation_done_ = true;
+  cb_.onPrivateKeyMethodComplete();
+}
+
+ThreadPoolPrivateKeyMethodProvider::ThreadPoolPrivateKeyMethodProvider(
+    const envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool& config,
+    Server::Configuration::TransportSocketFactoryContext& factory_context)
+    : stats_(generateStats(factory_context.statsScope())),
+      max_queued_operations_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_queued_operations, 1024)) {
+  const std::string private_key =
+      Config::DataSource::read(config.private_key(), false, factory_context.api());
+  bssl::UniquePtr<BIO> bio(
+      BIO_new_mem_buf(const_cast<char*>(private_key.data()), private_key.size()));
+  pkey_.reset(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  if (pkey_ == nullptr) {
+    throw EnvoyException("Failed to load private key for the thread pool private key provider");
+  }
+
+  method_ = std::make_shared<SSL_PRIVATE_KEY_METHOD>();
+  switch (EVP_PKEY_id(pkey_.get())) {
+  case EVP_PKEY_RSA:
+    method_->sign = rsaSign;
+    method_->decrypt = rsaDecrypt;
+    method_->complete = rsaComplete;
+    break;
+  case EVP_PKEY_EC:
+    method_->sign = ecdsaSign;
+    method_->decrypt = ecdsaDecrypt;
+    method_->complete = ecdsaComplete;
+    break;
+  default:
+    throw EnvoyException("The thread pool private key provider only supports RSA and ECDSA keys");
+  }
+
+  const uint32_t num_threads = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, num_threads, 1);
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(
+        factory_context.api().threadFactory().createThread([this]() -> void { threadRoutine(); }));
+  }
+}
+
+ThreadPoolPrivateKeyMethodProvider::~ThreadPoolPrivateKeyMethodProvider() {
+  {
+    Thread::LockGuard lock(lock_);
+    shutdown_ = true;
+  }
+  queue_not_empty_.notifyAll();
+  for (auto& thread : threads_) {
+    thread->join();
+  }
+  // Operations still queued belong to connections that have already gone away.
+  stats_.queue_depth_.sub(queue_.size());
+}
+
+ThreadPoolPrivateKeyProviderStats
+ThreadPoolPrivateKeyMethodProvider::generateStats(Stats::Scope& scope) {
+  const std::string prefix("private_key_provider.thread_pool.");
+  return {ALL_THREAD_POOL_PRIVATE_KEY_PROVIDER_STATS(POOL_COUNTER_PREFIX(scope, prefix),
+                                                     POOL_GAUGE_PREFIX(scope, prefix),
+                                                     POOL_HISTOGRAM_PREFIX(scope, prefix))};
+}
+
+int ThreadPoolPrivateKeyMethodProvider::rsaConnectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, createIndex());
+}
+
+int ThreadPoolPrivateKeyMethodProvider::ecdsaConnectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, createIndex());
+}
+
+int ThreadPoolPrivateKeyMethodProvider::connectionIndex() const {
+  // A context has at most one certificate per key type, so each key type has its own index for
+  // the case where an RSA and an ECDSA certificate are used with the same SSL object.
+  return EVP_PKEY_id(pkey_.get()) == EVP_PKEY_RSA ? rsaConnectionIndex() : ecdsaConnectionIndex();
+}
+
+void ThreadPoolPrivateKeyMethodProvider::registerPrivateKeyMethod(
+    SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& cb, Event::Dispatcher& dispatcher) {
+  const int index = connectionIndex();
+  if (SSL_get_ex_data(ssl, index) != nullptr) {
+    throw EnvoyException(
+        "Can't distinguish between two registered providers for the same SSL object.");
+  }
+  SSL_set_ex_data(ssl, index, new ThreadPoolPrivateKeyConnection(*this, cb, dispatcher));
+}
+
+void ThreadPoolPrivateKeyMethodProvider::unregisterPrivateKeyMethod(SSL* ssl) {
+  const int index = connectionIndex();
+  ThreadPoolPrivateKeyConnection* connection = getConnection(ssl, index);
+  SSL_set_ex_data(ssl, index, nullptr);
+  delete connection;
+}
+
+bool ThreadPoolPrivateKeyMethodProvider::checkFips() {
+  if (EVP_PKEY_id(pkey_.get()) == EVP_PKEY_RSA) {
+    const RSA* rsa = EVP_PKEY_get0_RSA(pkey_.get());
+    return rsa != nullptr && RSA_check_fips(const_cast<RSA*>(rsa));
+  }
+  const EC_KEY* ec_key = EVP_PKEY_get0_EC_KEY(pkey_.get());
+  return ec_key != nullptr && EC_KEY_check_fips(ec_key);
+}
+
+void ThreadPoolPrivateKeyMethodProvider::performOperation(PrivateKeyOperation& operation) const {
+  operation.output_.resize(operation.max_out_);
+  operation.success_ =
+      operation.type_ == PrivateKeyOperation::Type::Sign
+          ? signWithKey(pkey_.get(), operation.signature_algorithm_, operation.input_,
+                        operation.output_)
+          : decryptWithKey(pkey_.get(), operation.input_, operation.output_);
+}
+
+bool ThreadPoolPrivateKeyMethodProvider::enqueue(PrivateKeyOperationSharedPtr operation) {
+  {
+    Thread::LockGuard lock(lock_);
+    if (queue_.size() >= max_queued_operations_) {
+      return false;
+    }
+    queue_.push_back(std::move(operation));
+  }
+  stats_.offloaded_.inc();
+  stats_.queue_depth_.inc();
+  queue_not_empty_.notifyOne();
+  return true;
+}
+
+void ThreadPoolPrivateKeyMethodProvider::threadRoutine() {
+  while (true) {
+    PrivateKeyOperationSharedPtr operation;
+    {
+      Thread::LockGuard lock(lock_);
+      while (queue_.empty() && !shutdown_) {
+        queue_not_empty_.wait(lock_);
+      }
+      if (shutdown_) {
+        return;
+      }
+      operation = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    stats_.queue_depth_.dec();
+
+    {
+      // Skip operations whose connection has already gone away.
+      Thread::LockGuard lock(operation->lock_);
+      if (operation->connection_ == nullptr) {
+        continue;
+      }
+    }
+
+    performOperation(*operation);
+
+    Thread::LockGuard lock(operation->lock_);
+    if (operation->connection_ != nullptr) {
+      operation->dispatcher_.post([operation]() -> void {
+        // Both the completion and the connection going away run on the dispatcher thread, so
+        // the connection can't be cleared concurrently.
+        ThreadPoolPrivateKeyConnection* connection;
+        {
+          Thread::LockGuard lock(operation->lock_);
+          connection = operation->connection_;
+        }
+        if (connection != nullptr) {
+          connection->onOperationComplete();
+        }
+      });
+    }
+  }
+}
+
+Ssl::PrivateKeyMethodProviderSharedPtr
+ThreadPoolPrivateKeyMethodFactory::createPrivateKeyMethodProviderInstance(
+    const envoy::api::v2::auth::PrivateKeyProvider& config,
+    Server::Configuration::TransportSocketFactoryContext& factory_context) {
+  envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool thread_pool_config;
+  Config::Utility::translateOpaqueConfig(config.typed_config(), config.config(),
+                                         factory_context.messageValidationVisitor(),
+                                         thread_pool_config);
+  MessageUtil::validate(thread_pool_config, factory_context.messageValidationVisitor());
+  return std::make_shared<ThreadPoolPrivateKeyMethodProvider>(thread_pool_config, factory_context);
+}
+
+std::string ThreadPoolPrivateKeyMethodFactory::name() const {
+  return PrivateKeyMethodProviderNames::get().ThreadPool;
+}
+
+REGISTER_FACTORY(ThreadPoolPrivateKeyMethodFactory, Ssl::PrivateKeyMethodProviderInstanceFactory);
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
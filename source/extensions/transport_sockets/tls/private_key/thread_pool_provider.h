@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/config/private_key_provider/thread_pool/v2alpha/thread_pool.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/server/transport_socket_config.h"
+#include "envoy/ssl/private_key/private_key.h"
+#include "envoy/ssl/private_key/private_key_config.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread/thread.h"
+
+#include "common/common/logger.h"
+#include "common/common/thread.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+// clang-format off
+#define ALL_THREAD_POOL_PRIVATE_KEY_PROVIDER_STATS(COUNTER, GAUGE, HISTOGRAM)                      \
+  COUNTER(offloaded)                                                                               \
+  COUNTER(queue_overflow)                                                                          \
+  COUNTER(failed)                                                                                  \
+  GAUGE(queue_depth, NeverImport)                                                                  \
+  HISTOGRAM(operation_time_us, Microseconds)
+// clang-format on
+
+/**
+ * Wrapper struct for thread pool private key provider stats. @see stats_macros.h
+ */
+struct ThreadPoolPrivateKeyProviderStats {
+  ALL_THREAD_POOL_PRIVATE_KEY_PROVIDER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT,
+                                             GENERATE_HISTOGRAM_STRUCT)
+};
+
+class ThreadPoolPrivateKeyConnection;
+class ThreadPoolPrivateKeyMethodProvider;
+
+/**
+ * A private key operation performed on the thread pool. The operation is shared between the pool
+ * thread performing it and the connection that started it. The connection may go away while the
+ * operation is queued or running, in which case the result is discarded.
+ */
+struct PrivateKeyOperation {
+  enum class Type { Sign, Decrypt };
+
+  PrivateKeyOperation(Type type, uint16_t signature_algorithm, const uint8_t* in, size_t in_len,
+                      size_t max_out, ThreadPoolPrivateKeyConnection& connection,
+                      Event::Dispatcher& dispatcher)
+      : type_(type), signature_algorithm_(signature_algorithm), input_(in, in + in_len),
+        max_out_(max_out), dispatcher_(dispatcher),
+        start_time_(dispatcher.timeSource().monotonicTime()), connection_(&connection) {}
+
+  const Type type_;
+  const uint16_t signature_algorithm_;
+  const std::vector<uint8_t> input_;
+  const size_t max_out_;
+  Event::Dispatcher& dispatcher_;
+  const MonotonicTime start_time_;
+
+  // Written by the pool thread before the completion is posted to the dispatcher.
+  std::vector<uint8_t> output_;
+  bool success_{};
+
+  // Cleared on the dispatcher thread when the connection goes away. The pool thread only posts
+  // the completion while holding the lock and the connection is still set, so nothing is posted
+  // to the dispatcher after the connection is unregistered.
+  Thread::MutexBasicLockable lock_;
+  ThreadPoolPrivateKeyConnection* connection_ ABSL_GUARDED_BY(lock_);
+};
+
+using PrivateKeyOperationSharedPtr = std::shared_ptr<PrivateKeyOperation>;
+
+/**
+ * Per-connection state of the thread pool private key provider, stored in the SSL object.
+ */
+class ThreadPoolPrivateKeyConnection {
+public:
+  ThreadPoolPrivateKeyConnection(ThreadPoolPrivateKeyMethodProvider& provider,
+                                 Ssl::PrivateKeyConnectionCallbacks& cb,
+                                 Event::Dispatcher& dispatcher)
+      : provider_(provider), cb_(cb), dispatcher_(dispatcher) {}
+  ~ThreadPoolPrivateKeyConnection();
+
+  ssl_private_key_result_t start(PrivateKeyOperation::Type type, uint16_t signature_algorithm,
+                                 uint8_t* out, size_t* out_len, size_t max_out, const uint8_t* in,
+                                 size_t in_len);
+  ssl_private_key_result_t complete(uint8_t* out, size_t* out_len, size_t max_out);
+
+  // Called on the dispatcher thread once the pool has finished the operation.
+  void onOperationComplete();
+
+private:
+  void detachOperation();
+
+  ThreadPoolPrivateKeyMethodProvider& provider_;
+  Ssl::PrivateKeyConnectionCallbacks& cb_;
+  Event::Dispatcher& dispatcher_;
+  PrivateKeyOperationSharedPtr operation_;
+  bool operation_done_{};
+};
+
+/**
+ * A private key method provider which performs signing and decryption on a bounded pool of
+ * threads. Handshakes waiting for an operation are resumed via a post to the dispatcher of the
+ * connection. If the queue of the pool is full, operations are performed synchronously.
+ */
+class ThreadPoolPrivateKeyMethodProvider : public virtual Ssl::PrivateKeyMethodProvider,
+                                           Logger::Loggable<Logger::Id::connection> {
+public:
+  ThreadPoolPrivateKeyMethodProvider(
+      const envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool& config,
+      Server::Configuration::TransportSocketFactoryContext& factory_context);
+  ~ThreadPoolPrivateKeyMethodProvider() override;
+
+  // Ssl::PrivateKeyMethodProvider
+  void registerPrivateKeyMethod(SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& cb,
+                                Event::Dispatcher& dispatcher) override;
+  void unregisterPrivateKeyMethod(SSL* ssl) override;
+  bool checkFips() override;
+  Ssl::BoringSslPrivateKeyMethodSharedPtr getBoringSslPrivateKeyMethod() override {
+    return method_;
+  }
+
+  /**
+   * Perform an operation in the calling thread.
+   */
+  void performOperation(PrivateKeyOperation& operation) const;
+
+  /**
+   * Queue an operation to the thread pool.
+   * @return false if the queue is full, in which case the operation isn't queued.
+   */
+  bool enqueue(PrivateKeyOperationSharedPtr operation);
+
+  ThreadPoolPrivateKeyProviderStats& stats() { return stats_; }
+
+  static int rsaConnectionIndex();
+  static int ecdsaConnectionIndex();
+
+private:
+  static ThreadPoolPrivateKeyProviderStats generateStats(Stats::Scope& scope);
+  int connectionIndex() const;
+  void threadRoutine();
+
+  bssl::UniquePtr<EVP_PKEY> pkey_;
+  Ssl::BoringSslPrivateKeyMethodSharedPtr method_;
+  ThreadPoolPrivateKeyProviderStats stats_;
+  const uint32_t max_queued_operations_;
+
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar queue_not_empty_;
+  std::list<PrivateKeyOperationSharedPtr> queue_ ABSL_GUARDED_BY(lock_);
+  bool shutdown_ ABSL_GUARDED_BY(lock_){};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+class ThreadPoolPrivateKeyMethodFactory : public Ssl::PrivateKeyMethodProviderInstanceFactory {
+public:
+  // Ssl::PrivateKeyMethodProviderInstanceFactory
+  Ssl::PrivateKeyMethodProviderSharedPtr createPrivateKeyMethodProviderInstance(
+      const envoy::api::v2::auth::PrivateKeyProvider& config,
+      Server::Configuration::TransportSocketFactoryContext& factory_context) override;
+  std::string name() const override;
+};
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
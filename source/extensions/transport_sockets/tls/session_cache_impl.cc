@@ -0,0 +1,106 @@
+#include "extensions/transport_sockets/tls/session_cache_impl.h"
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+SessionCacheImpl::SessionCacheImpl(uint32_t num_shards, uint32_t max_keys_per_shard)
+    : max_keys_per_shard_(max_keys_per_shard) {
+  ASSERT(num_shards > 0);
+  ASSERT(max_keys_per_shard > 0);
+  shards_.reserve(num_shards);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.emplace_back(std::make_unique<Shard>());
+  }
+}
+
+SessionCacheImpl::Shard& SessionCacheImpl::shardForKey(const std::string& key) {
+  return *shards_[HashUtil::xxHash64(key) % shards_.size()];
+}
+
+void SessionCacheImpl::eraseEntry(Shard& shard,
+                                  absl::flat_hash_map<std::string, Entry>::iterator it) {
+  size_ -= it->second.sessions_.size();
+  shard.keys_.erase(it->second.key_);
+  shard.entries_.erase(it);
+}
+
+void SessionCacheImpl::insert(const std::string& key, bssl::UniquePtr<SSL_SESSION> session,
+                              size_t max_sessions_per_key) {
+  if (max_sessions_per_key == 0) {
+    return;
+  }
+
+  Shard& shard = shardForKey(key);
+  absl::WriterMutexLock lock(&shard.mu_);
+  auto it = shard.entries_.find(key);
+  if (it == shard.entries_.end()) {
+    if (shard.keys_.size() >= max_keys_per_shard_) {
+      eraseEntry(shard, shard.entries_.find(shard.keys_.back()));
+    }
+    shard.keys_.push_front(key);
+    it = shard.entries_.emplace(key, Entry{}).first;
+  } else {
+    shard.keys_.splice(shard.keys_.begin(), shard.keys_, it->second.key_);
+  }
+  it->second.key_ = shard.keys_.begin();
+
+  std::deque<bssl::UniquePtr<SSL_SESSION>>& sessions = it->second.sessions_;
+  // Evict oldest entries.
+  while (sessions.size() >= max_sessions_per_key) {
+    sessions.pop_back();
+    size_--;
+  }
+  // Add the new session at the front of the queue, so that it's used first.
+  sessions.push_front(std::move(session));
+  size_++;
+}
+
+bssl::UniquePtr<SSL_SESSION> SessionCacheImpl::lookup(const std::string& key) {
+  Shard& shard = shardForKey(key);
+  {
+    absl::ReaderMutexLock lock(&shard.mu_);
+    auto it = shard.entries_.find(key);
+    if (it == shard.entries_.end()) {
+      return nullptr;
+    }
+    // Use the most recently stored session, since it has the highest probability of still being
+    // recognized/accepted by the server.
+    SSL_SESSION* session = it->second.sessions_.front().get();
+    if (!SSL_SESSION_should_be_single_use(session)) {
+      SSL_SESSION_up_ref(session);
+      return bssl::UniquePtr<SSL_SESSION>(session);
+    }
+  }
+
+  // Single-use sessions (TLS 1.3) are removed after first use, which needs the writer lock. The
+  // entry may have changed while the lock was released, so look it up again.
+  absl::WriterMutexLock lock(&shard.mu_);
+  auto it = shard.entries_.find(key);
+  if (it == shard.entries_.end()) {
+    return nullptr;
+  }
+  std::deque<bssl::UniquePtr<SSL_SESSION>>& sessions = it->second.sessions_;
+  bssl::UniquePtr<SSL_SESSION> session;
+  if (SSL_SESSION_should_be_single_use(sessions.front().get())) {
+    session = std::move(sessions.front());
+    sessions.pop_front();
+    size_--;
+    if (sessions.empty()) {
+      eraseEntry(shard, it);
+    }
+  } else {
+    SSL_SESSION_up_ref(sessions.front().get());
+    session.reset(sessions.front().get());
+  }
+  return session;
+}
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
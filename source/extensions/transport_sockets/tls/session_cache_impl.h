@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/ssl/session_cache.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+/**
+ * In-memory session cache. Keys are spread over a fixed number of shards, each protected by its
+ * own reader/writer lock, so that handshakes on different workers to different upstreams don't
+ * contend. Lookups of multi-use sessions (TLS 1.2) only take the shard's reader lock.
+ *
+ * Each shard retains at most max_keys_per_shard keys; when that is exceeded the key which was
+ * least recently inserted into is evicted along with all of its sessions.
+ */
+class SessionCacheImpl : public Envoy::Ssl::SessionCache {
+public:
+  static constexpr uint32_t DEFAULT_SHARDS = 16;
+  static constexpr uint32_t DEFAULT_MAX_KEYS_PER_SHARD = 1024;
+
+  SessionCacheImpl(uint32_t num_shards = DEFAULT_SHARDS,
+                   uint32_t max_keys_per_shard = DEFAULT_MAX_KEYS_PER_SHARD);
+
+  // Ssl::SessionCache
+  void insert(const std::string& key, bssl::UniquePtr<SSL_SESSION> session,
+              size_t max_sessions_per_key) override;
+  bssl::UniquePtr<SSL_SESSION> lookup(const std::string& key) override;
+  size_t size() const override { return size_.load(); }
+
+private:
+  struct Entry {
+    // Most recently stored session first.
+    std::deque<bssl::UniquePtr<SSL_SESSION>> sessions_;
+    std::list<std::string>::iterator key_;
+  };
+
+  struct Shard {
+    absl::Mutex mu_;
+    // Keys ordered by most recent insertion first, used for eviction.
+    std::list<std::string> keys_ ABSL_GUARDED_BY(mu_);
+    absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  };
+
+  Shard& shardForKey(const std::string& key);
+  void eraseEntry(Shard& shard, absl::flat_hash_map<std::string, Entry>::iterator it)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mu_);
+
+  const uint32_t max_keys_per_shard_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> size_{0};
+};
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
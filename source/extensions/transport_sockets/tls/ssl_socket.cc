@@ -105,6 +105,10 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     }
   }
 
+  if (kernel_tls_.rx_) {
+    return kernelTlsRead(read_buffer);
+  }
+
   bool keep_reading = true;
   bool end_stream = false;
   PostIoAction action = PostIoAction::KeepOpen;
@@ -176,6 +180,9 @@ PostIoAction SslSocket::doHandshake() {
     ENVOY_CONN_LOG(debug, "handshake complete", callbacks_->connection());
     state_ = SocketState::HandshakeComplete;
     ctx_->logHandshake(ssl_);
+    if (ctx_->kernelTlsOffload()) {
+      enableKernelTls();
+    }
     callbacks_->raiseEvent(Network::ConnectionEvent::Connected);
 
     // It's possible that we closed during the handshake callback.
@@ -202,6 +209,83 @@ PostIoAction SslSocket::doHandshake() {
   }
 }
 
+void SslSocket::enableKernelTls() {
+  kernel_tls_ = KernelTls::enable(ssl_, callbacks_->ioHandle().fd());
+  ENVOY_CONN_LOG(debug, "kernel TLS offload: tx={} rx={}", callbacks_->connection(),
+                 kernel_tls_.tx_, kernel_tls_.rx_);
+  if (kernel_tls_.tx_) {
+    ctx_->stats().kernel_tls_tx_offload_.inc();
+  }
+  if (kernel_tls_.rx_) {
+    ctx_->stats().kernel_tls_rx_offload_.inc();
+  }
+}
+
+Network::IoResult SslSocket::kernelTlsRead(Buffer::Instance& read_buffer) {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  bool end_stream = false;
+  do {
+    // 16K read is arbitrary, see doRead().
+    Api::IoCallUint64Result result = read_buffer.read(callbacks_->ioHandle(), 16384);
+
+    if (result.ok()) {
+      ENVOY_CONN_LOG(trace, "kernel TLS read returns: {}", callbacks_->connection(), result.rc_);
+      if (result.rc_ == 0) {
+        // Remote close without close_notify.
+        end_stream = true;
+        break;
+      }
+      bytes_read += result.rc_;
+      if (callbacks_->shouldDrainReadBuffer()) {
+        callbacks_->setReadBufferReady();
+        break;
+      }
+    } else {
+      ENVOY_CONN_LOG(trace, "kernel TLS read error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      if (result.err_->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+        // Records other than application data can only be read along with their type. The only
+        // one expected once the handshake is complete is the close_notify alert.
+        if (KernelTls::readCloseNotify(callbacks_->ioHandle().fd())) {
+          end_stream = true;
+        } else {
+          action = PostIoAction::Close;
+        }
+      }
+      break;
+    }
+  } while (true);
+
+  return {action, bytes_read, end_stream};
+}
+
+Network::IoResult SslSocket::kernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream) {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_written = 0;
+  while (write_buffer.length() > 0) {
+    Api::IoCallUint64Result result = write_buffer.write(callbacks_->ioHandle());
+
+    if (result.ok()) {
+      ENVOY_CONN_LOG(trace, "kernel TLS write returns: {}", callbacks_->connection(), result.rc_);
+      bytes_written += result.rc_;
+    } else {
+      ENVOY_CONN_LOG(trace, "kernel TLS write error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      if (result.err_->getErrorCode() != Api::IoError::IoErrorCode::Again) {
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+  }
+
+  if (write_buffer.length() == 0 && end_stream) {
+    shutdownSsl();
+  }
+
+  return {action, bytes_written, false};
+}
+
 void SslSocket::drainErrorQueue() {
   bool saw_error = false;
   bool saw_counted_error = false;
@@ -238,6 +322,10 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
     }
   }
 
+  if (kernel_tls_.tx_) {
+    return kernelTlsWrite(write_buffer, end_stream);
+  }
+
   uint64_t bytes_to_write;
   if (bytes_to_retry_) {
     bytes_to_write = bytes_to_retry_;
@@ -294,9 +382,16 @@ void SslSocket::shutdownSsl() {
   ASSERT(state_ != SocketState::PreHandshake);
   if (state_ != SocketState::ShutdownSent &&
       callbacks_->connection().state() != Network::Connection::State::Closed) {
-    int rc = SSL_shutdown(ssl_);
-    ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", callbacks_->connection(), rc);
-    drainErrorQueue();
+    if (kernel_tls_.tx_) {
+      // BoringSSL no longer owns the write side of the connection, so the alert is sent by the
+      // kernel.
+      const bool sent = KernelTls::sendCloseNotify(callbacks_->ioHandle().fd());
+      ENVOY_CONN_LOG(debug, "kernel TLS shutdown: sent={}", callbacks_->connection(), sent);
+    } else {
+      int rc = SSL_shutdown(ssl_);
+      ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", callbacks_->connection(), rc);
+      drainErrorQueue();
+    }
     state_ = SocketState::ShutdownSent;
   }
 }
@@ -13,6 +13,7 @@
 #include "common/common/logger.h"
 
 #include "extensions/transport_sockets/tls/context_impl.h"
+#include "extensions/transport_sockets/tls/kernel_tls.h"
 #include "extensions/transport_sockets/tls/utility.h"
 
 #include "absl/synchronization/mutex.h"
@@ -115,6 +116,10 @@ private:
   ReadResult sslReadIntoSlice(Buffer::RawSlice& slice);
 
   Network::PostIoAction doHandshake();
+  void enableKernelTls();
+  // Reads and writes of the directions offloaded to the kernel, which bypass BoringSSL.
+  Network::IoResult kernelTlsRead(Buffer::Instance& read_buffer);
+  Network::IoResult kernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream);
   void drainErrorQueue();
   void shutdownSsl();
   bool isThreadSafe() const {
@@ -127,6 +132,7 @@ private:
   uint64_t bytes_to_retry_{};
   std::string failure_reason_;
   SocketState state_;
+  KernelTls::Offload kernel_tls_;
 
   SSL* ssl_;
   Ssl::ConnectionInfoConstSharedPtr info_;
@@ -36,6 +36,16 @@ public:
 // TODO(lizan): Find a better place to have this singleton.
 using TransportProtocolNames = ConstSingleton<TransportProtocolNameValues>;
 
+/**
+ * Well-known TLS private key method provider names.
+ */
+class PrivateKeyMethodProviderNameValues {
+public:
+  const std::string ThreadPool = "envoy.tls.private_key_providers.thread_pool";
+};
+
+using PrivateKeyMethodProviderNames = ConstSingleton<PrivateKeyMethodProviderNameValues>;
+
 } // namespace TransportSockets
 } // namespace Extensions
 } // namespace Envoy
@@ -0,0 +1,91 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/buffer/zero_copy_output_stream_impl.h"
+
+#include "test/common/buffer/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+class ZeroCopyOutputStreamTest : public BufferImplementationParamTest {
+public:
+  ZeroCopyOutputStreamTest() {
+    buffer_.add("abcd");
+    verifyImplementation(buffer_);
+  }
+
+  Buffer::OwnedImpl buffer_;
+
+  void* data_;
+  int size_;
+};
+
+INSTANTIATE_TEST_SUITE_P(ZeroCopyOutputStreamTest, ZeroCopyOutputStreamTest,
+                         testing::ValuesIn({BufferImplementation::Old, BufferImplementation::New}));
+
+TEST_P(ZeroCopyOutputStreamTest, NextAndCommit) {
+  ZeroCopyOutputStreamImpl stream(buffer_);
+  EXPECT_TRUE(stream.Next(&data_, &size_));
+  EXPECT_LE(4, size_);
+  memcpy(data_, "efgh", 4);
+  stream.BackUp(size_ - 4);
+
+  // Nothing is appended to the buffer until the data is committed.
+  EXPECT_EQ("abcd", buffer_.toString());
+  stream.commit();
+  EXPECT_EQ("abcdefgh", buffer_.toString());
+  EXPECT_EQ(4, stream.ByteCount());
+}
+
+TEST_P(ZeroCopyOutputStreamTest, CommitOnNext) {
+  ZeroCopyOutputStreamImpl stream(buffer_);
+  EXPECT_TRUE(stream.Next(&data_, &size_));
+  memset(data_, 'x', size_);
+  const int first_size = size_;
+
+  EXPECT_TRUE(stream.Next(&data_, &size_));
+  EXPECT_EQ(4 + first_size, buffer_.length());
+  memcpy(data_, "y", 1);
+  stream.BackUp(size_ - 1);
+  EXPECT_EQ(first_size + 1, stream.ByteCount());
+}
+
+TEST_P(ZeroCopyOutputStreamTest, CommitOnDestruction) {
+  {
+    ZeroCopyOutputStreamImpl stream(buffer_);
+    EXPECT_TRUE(stream.Next(&data_, &size_));
+    memcpy(data_, "efgh", 4);
+    stream.BackUp(size_ - 4);
+  }
+  EXPECT_EQ("abcdefgh", buffer_.toString());
+}
+
+TEST_P(ZeroCopyOutputStreamTest, BackUpFull) {
+  {
+    ZeroCopyOutputStreamImpl stream(buffer_);
+    EXPECT_TRUE(stream.Next(&data_, &size_));
+    stream.BackUp(size_);
+    EXPECT_EQ(0, stream.ByteCount());
+  }
+  EXPECT_EQ("abcd", buffer_.toString());
+}
+
+TEST_P(ZeroCopyOutputStreamTest, SerializeMessage) {
+  ProtobufWkt::StringValue message;
+  message.set_value(std::string(100000, 'a'));
+  {
+    ZeroCopyOutputStreamImpl stream(buffer_);
+    EXPECT_TRUE(message.SerializeToZeroCopyStream(&stream));
+  }
+  buffer_.drain(4);
+
+  ProtobufWkt::StringValue parsed;
+  EXPECT_TRUE(parsed.ParseFromString(buffer_.toString()));
+  EXPECT_EQ(message.value(), parsed.value());
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
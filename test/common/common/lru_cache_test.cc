@@ -0,0 +1,76 @@
+#include <string>
+
+#include "common/common/lru_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+TEST(LruCacheTest, Lookup) {
+  LruCache<std::string, int> cache(10);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  EXPECT_EQ(0, cache.insert("a", 1));
+  ASSERT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(1, *cache.lookup("a"));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(1, cache.weight());
+}
+
+TEST(LruCacheTest, Replace) {
+  LruCache<std::string, int> cache(10);
+  cache.insert("a", 1, 4);
+  cache.insert("a", 2, 3);
+  EXPECT_EQ(2, *cache.lookup("a"));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(3, cache.weight());
+}
+
+TEST(LruCacheTest, EvictLeastRecentlyUsed) {
+  LruCache<std::string, int> cache(3);
+  cache.insert("a", 1);
+  cache.insert("b", 2);
+  cache.insert("c", 3);
+  // "a" becomes the most recently used entry, so "b" is evicted.
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(1, cache.insert("d", 4));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_NE(nullptr, cache.lookup("c"));
+  EXPECT_NE(nullptr, cache.lookup("d"));
+  EXPECT_EQ(3, cache.size());
+}
+
+TEST(LruCacheTest, EvictByWeight) {
+  LruCache<std::string, int> cache(10);
+  cache.insert("a", 1, 4);
+  cache.insert("b", 2, 4);
+  EXPECT_EQ(2, cache.insert("c", 3, 8));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(8, cache.weight());
+}
+
+TEST(LruCacheTest, TooHeavy) {
+  LruCache<std::string, int> cache(10);
+  cache.insert("a", 1, 4);
+  EXPECT_EQ(0, cache.insert("b", 2, 11));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  // Replacing an entry by a value which does not fit erases it.
+  cache.insert("a", 3, 11);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  EXPECT_EQ(0, cache.weight());
+}
+
+TEST(LruCacheTest, Erase) {
+  LruCache<uint64_t, std::string> cache(10);
+  cache.insert(1, "a");
+  EXPECT_TRUE(cache.erase(1));
+  EXPECT_FALSE(cache.erase(1));
+  EXPECT_EQ(nullptr, cache.lookup(1));
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, cache.weight());
+}
+
+} // namespace
+} // namespace Envoy
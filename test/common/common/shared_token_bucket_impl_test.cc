@@ -0,0 +1,125 @@
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "common/common/shared_token_bucket_impl.h"
+
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+class SharedTokenBucketImplTest : public testing::Test {
+protected:
+  Event::SimulatedTimeSystem time_system_;
+};
+
+TEST_F(SharedTokenBucketImplTest, Initialization) {
+  SharedTokenBucketImpl token_bucket{1, time_system_, -1.0};
+
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+}
+
+TEST_F(SharedTokenBucketImplTest, MaxBucketSize) {
+  SharedTokenBucketImpl token_bucket{3, time_system_, 1};
+
+  EXPECT_EQ(3, token_bucket.consume(3, false));
+  time_system_.setMonotonicTime(std::chrono::seconds(10));
+  EXPECT_EQ(0, token_bucket.consume(4, false));
+  EXPECT_EQ(3, token_bucket.consume(3, false));
+}
+
+TEST_F(SharedTokenBucketImplTest, Consume) {
+  SharedTokenBucketImpl token_bucket{10, time_system_, 1};
+
+  EXPECT_EQ(0, token_bucket.consume(20, false));
+  EXPECT_EQ(9, token_bucket.consume(9, false));
+
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+
+  time_system_.sleep(std::chrono::milliseconds(999));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+
+  time_system_.sleep(std::chrono::milliseconds(5000));
+  EXPECT_EQ(0, token_bucket.consume(6, false));
+
+  time_system_.sleep(std::chrono::milliseconds(1));
+  EXPECT_EQ(6, token_bucket.consume(6, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+}
+
+TEST_F(SharedTokenBucketImplTest, Refill) {
+  SharedTokenBucketImpl token_bucket{1, time_system_, 0.5};
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+
+  time_system_.sleep(std::chrono::milliseconds(500));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  time_system_.sleep(std::chrono::milliseconds(1000));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  time_system_.sleep(std::chrono::milliseconds(500));
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+}
+
+TEST_F(SharedTokenBucketImplTest, NextTokenAvailable) {
+  SharedTokenBucketImpl token_bucket{10, time_system_, 5};
+  EXPECT_EQ(9, token_bucket.consume(9, false));
+  EXPECT_EQ(std::chrono::milliseconds(0), token_bucket.nextTokenAvailable());
+  EXPECT_EQ(1, token_bucket.consume(1, false));
+  EXPECT_EQ(0, token_bucket.consume(1, false));
+  EXPECT_EQ(std::chrono::milliseconds(200), token_bucket.nextTokenAvailable());
+  time_system_.sleep(std::chrono::milliseconds(150));
+  EXPECT_EQ(std::chrono::milliseconds(50), token_bucket.nextTokenAvailable());
+}
+
+TEST_F(SharedTokenBucketImplTest, PartialConsumption) {
+  SharedTokenBucketImpl token_bucket{16, time_system_, 16};
+  EXPECT_EQ(16, token_bucket.consume(18, true));
+  EXPECT_EQ(std::chrono::milliseconds(63), token_bucket.nextTokenAvailable());
+  time_system_.sleep(std::chrono::milliseconds(62));
+  EXPECT_EQ(0, token_bucket.consume(1, true));
+  time_system_.sleep(std::chrono::milliseconds(1));
+  EXPECT_EQ(1, token_bucket.consume(2, true));
+}
+
+TEST_F(SharedTokenBucketImplTest, Reset) {
+  SharedTokenBucketImpl token_bucket{16, time_system_, 16};
+  token_bucket.reset(1);
+  EXPECT_EQ(1, token_bucket.consume(2, true));
+  EXPECT_EQ(0, token_bucket.consume(1, true));
+}
+
+TEST_F(SharedTokenBucketImplTest, Refund) {
+  SharedTokenBucketImpl token_bucket{2, time_system_, 1};
+  EXPECT_EQ(2, token_bucket.consume(2, false));
+  token_bucket.refund(1);
+  EXPECT_EQ(1, token_bucket.consume(2, true));
+
+  // Tokens which no longer fit in the bucket are dropped.
+  token_bucket.refund(1);
+  time_system_.sleep(std::chrono::seconds(2));
+  EXPECT_EQ(2, token_bucket.consume(3, true));
+}
+
+// Threads consuming from the same bucket never get more tokens than it holds between them.
+TEST_F(SharedTokenBucketImplTest, ConcurrentConsume) {
+  constexpr uint64_t ThreadCount = 8;
+  SharedTokenBucketImpl token_bucket{10000, time_system_, 1};
+  std::atomic<uint64_t> consumed{0};
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint64_t i = 0; i < ThreadCount; i++) {
+    threads.push_back(Thread::threadFactoryForTest().createThread([&token_bucket, &consumed]() {
+      while (token_bucket.consume(1, false) == 1) {
+        consumed++;
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  EXPECT_EQ(10000, consumed);
+}
+
+} // namespace Envoy
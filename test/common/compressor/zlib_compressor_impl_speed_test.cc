@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zlib_compressor_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Compressor {
+
+// Size of each corpus.
+static constexpr uint64_t CorpusSize = 256 * 1024;
+// Size of the body chunks handed to the compressor, as the compression filters get them from the
+// upstream connection.
+static constexpr uint64_t ChunkSize = 16 * 1024;
+
+// A fixed sequence of pseudo-random numbers, so that every run compresses the same corpus.
+class CorpusRandom {
+public:
+  uint32_t next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<uint32_t>(state_ >> 33);
+  }
+
+private:
+  uint64_t state_{1};
+};
+
+// The body of an API response: an array of JSON objects with repeated keys and varied values.
+static std::string jsonCorpus() {
+  static const char* const Names[] = {"alice", "bob", "carol", "dave", "erin", "frank"};
+  CorpusRandom random;
+  std::string corpus = "[";
+  while (corpus.size() < CorpusSize) {
+    absl::StrAppend(&corpus, R"({"id":)", random.next(), R"(,"name":")", Names[random.next() % 6],
+                    R"(","email":")", Names[random.next() % 6], random.next() % 1000,
+                    R"(@example.com","active":)", random.next() % 2 == 0 ? "true" : "false",
+                    R"(,"score":)", random.next() % 10000 / 100.0, R"(,"tags":["tag)",
+                    random.next() % 50, R"(","tag)", random.next() % 50, R"("]},)");
+  }
+  corpus.back() = ']';
+  return corpus;
+}
+
+// A web page: markup with repeated structure around varied text.
+static std::string htmlCorpus() {
+  static const char* const Words[] = {"envoy", "proxy",  "service", "mesh",    "cluster",
+                                      "route", "filter", "listener", "upstream", "stream"};
+  CorpusRandom random;
+  std::string corpus = "<!DOCTYPE html><html><head><title>Example</title></head><body>";
+  while (corpus.size() < CorpusSize) {
+    absl::StrAppend(&corpus, "<div class=\"item item-", random.next() % 8, "\"><a href=\"/items/",
+                    random.next(), "\">", Words[random.next() % 10], "</a><p>");
+    for (uint32_t i = 0; i < 12; i++) {
+      absl::StrAppend(&corpus, Words[random.next() % 10], " ");
+    }
+    absl::StrAppend(&corpus, "</p></div>\n");
+  }
+  absl::StrAppend(&corpus, "</body></html>");
+  return corpus;
+}
+
+// Already compressed content, such as images, which does not compress further.
+static std::string randomCorpus() {
+  CorpusRandom random;
+  std::string corpus(CorpusSize, 0);
+  for (char& c : corpus) {
+    c = static_cast<char>(random.next());
+  }
+  return corpus;
+}
+
+static const std::string& corpus(int64_t index) {
+  static const std::string* const Corpora[] = {new std::string(jsonCorpus()),
+                                               new std::string(htmlCorpus()),
+                                               new std::string(randomCorpus())};
+  return *Corpora[index];
+}
+
+// Compress a corpus in body sized chunks, the way the gzip filter does, with the compression
+// level and strategy given by the second and third Args of the BENCHMARK(...) macro call below.
+static void ZlibCompressCorpus(benchmark::State& state) {
+  const std::string& data = corpus(state.range(0));
+  const auto level = static_cast<ZlibCompressorImpl::CompressionLevel>(state.range(1));
+  const auto strategy = static_cast<ZlibCompressorImpl::CompressionStrategy>(state.range(2));
+  uint64_t compressed_bytes = 0;
+  for (auto _ : state) {
+    ZlibCompressorImpl compressor;
+    // Window bits and memory level of the gzip filter defaults.
+    compressor.init(level, strategy, 28, 5);
+    for (uint64_t offset = 0; offset < data.size(); offset += ChunkSize) {
+      const bool last = offset + ChunkSize >= data.size();
+      Buffer::OwnedImpl buffer(data.data() + offset, std::min<uint64_t>(ChunkSize, data.size() - offset));
+      compressor.compress(buffer, last ? State::Finish : State::Flush);
+      compressed_bytes += buffer.length();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+  state.counters["ratio"] =
+      static_cast<double>(state.iterations() * data.size()) / compressed_bytes;
+}
+
+// Corpora: 0 is JSON, 1 is HTML and 2 is incompressible.
+static void corpusArgs(benchmark::internal::Benchmark* benchmark) {
+  const int64_t levels[] = {static_cast<int64_t>(ZlibCompressorImpl::CompressionLevel::Speed),
+                            static_cast<int64_t>(ZlibCompressorImpl::CompressionLevel::Standard),
+                            static_cast<int64_t>(ZlibCompressorImpl::CompressionLevel::Best)};
+  const int64_t strategies[] = {
+      static_cast<int64_t>(ZlibCompressorImpl::CompressionStrategy::Standard),
+      static_cast<int64_t>(ZlibCompressorImpl::CompressionStrategy::Filtered),
+      static_cast<int64_t>(ZlibCompressorImpl::CompressionStrategy::Huffman),
+      static_cast<int64_t>(ZlibCompressorImpl::CompressionStrategy::Rle)};
+  for (int64_t index = 0; index < 3; index++) {
+    for (int64_t level : levels) {
+      for (int64_t strategy : strategies) {
+        benchmark->Args({index, level, strategy});
+      }
+    }
+  }
+}
+BENCHMARK(ZlibCompressCorpus)->Apply(corpusArgs)->Unit(benchmark::kMicrosecond);
+
+} // namespace Compressor
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
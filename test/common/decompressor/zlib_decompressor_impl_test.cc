@@ -79,6 +79,25 @@ TEST_F(ZlibDecompressorImplDeathTest, DecompressorDeathTest) {
   EXPECT_DEATH_LOG_TO_STDERR(unitializedDecompressorTestHelper(), "assert failure: result == Z_OK");
 }
 
+// Exercises decompression of data which is not a valid compressed stream.
+TEST_F(ZlibDecompressorImplTest, DecompressCorruptData) {
+  Buffer::OwnedImpl input_buffer("this is not a gzip stream");
+  Buffer::OwnedImpl output_buffer;
+
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+  EXPECT_FALSE(decompressor.decompressionError());
+
+  decompressor.decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor.decompressionError());
+  EXPECT_EQ(0, output_buffer.length());
+
+  // Further data is not decompressed either.
+  decompressor.decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor.decompressionError());
+  EXPECT_EQ(0, output_buffer.length());
+}
+
 // Exercises decompressor's checksum by calling it before init or decompress.
 TEST_F(ZlibDecompressorImplTest, CallingChecksum) {
   Buffer::OwnedImpl compressor_buffer;
@@ -258,6 +277,69 @@ TEST_F(ZlibDecompressorImplTest, CompressDecompressOfMultipleSlices) {
   EXPECT_EQ(original_text, decompressed_text);
 }
 
+// Exercises a preset dictionary, which only the zlib format carries. The decompressor fails without
+// the dictionary.
+TEST_F(ZlibDecompressorImplTest, CompressDecompressWithDictionary) {
+  const std::string dictionary = R"({"id":,"name":"","email":"@example.com"})";
+  const std::string original_text = R"({"id":1,"name":"alice","email":"alice@example.com"})";
+  const int64_t zlib_window_bits = 15;
+
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                  Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                  zlib_window_bits, memory_level);
+  compressor.setDictionary(dictionary);
+  Buffer::OwnedImpl buffer(original_text);
+  compressor.compress(buffer, Compressor::State::Finish);
+  const std::string compressed_text = buffer.toString();
+
+  {
+    ZlibDecompressorImpl decompressor;
+    decompressor.init(zlib_window_bits);
+    decompressor.setDictionary(dictionary);
+    Buffer::OwnedImpl input(compressed_text);
+    Buffer::OwnedImpl output;
+    decompressor.decompress(input, output);
+    EXPECT_FALSE(decompressor.decompressionError());
+    EXPECT_EQ(original_text, output.toString());
+  }
+
+  {
+    ZlibDecompressorImpl decompressor;
+    decompressor.init(zlib_window_bits);
+    Buffer::OwnedImpl input(compressed_text);
+    Buffer::OwnedImpl output;
+    decompressor.decompress(input, output);
+    EXPECT_TRUE(decompressor.decompressionError());
+    EXPECT_EQ(0, output.length());
+  }
+}
+
+// The end of the stream is only reached once the whole stream has been decompressed.
+TEST_F(ZlibDecompressorImplTest, StreamEnd) {
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                  Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                  gzip_window_bits, memory_level);
+  Buffer::OwnedImpl buffer;
+  TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size);
+  compressor.compress(buffer, Compressor::State::Finish);
+  const std::string compressed_text = buffer.toString();
+
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+  Buffer::OwnedImpl input(compressed_text.substr(0, compressed_text.size() - 4));
+  Buffer::OwnedImpl output;
+  decompressor.decompress(input, output);
+  EXPECT_FALSE(decompressor.decompressionError());
+  EXPECT_FALSE(decompressor.streamEnd());
+
+  Buffer::OwnedImpl rest(compressed_text.substr(compressed_text.size() - 4));
+  decompressor.decompress(rest, output);
+  EXPECT_FALSE(decompressor.decompressionError());
+  EXPECT_TRUE(decompressor.streamEnd());
+}
+
 } // namespace
 } // namespace Decompressor
 } // namespace Envoy
@@ -0,0 +1,230 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http1/codec_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+// Size of the body proxied by each iteration.
+static constexpr uint64_t BodySize = 100 * 1024 * 1024;
+// Size of each read from the downstream socket.
+static constexpr uint64_t ReadSize = 16 * 1024;
+// Size of each chunk of a chunked body.
+static constexpr uint64_t ChunkSize = 1024 * 1024;
+
+/**
+ * Counts the body bytes which are delivered in slices read from the socket, and those which were
+ * copied into other slices by the codec.
+ */
+class BodyCounter : public StreamDecoder, public ServerConnectionCallbacks {
+public:
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool) override {}
+  void decodeData(Buffer::Instance& data, bool) override {
+    const uint64_t num_slices = data.getRawSlices(nullptr, 0);
+    std::vector<Buffer::RawSlice> slices(num_slices);
+    data.getRawSlices(slices.data(), num_slices);
+    for (const Buffer::RawSlice& slice : slices) {
+      const char* mem = static_cast<const char*>(slice.mem_);
+      if (mem >= read_start_ && mem < read_end_) {
+        moved_bytes_ += slice.len_;
+      } else {
+        copied_bytes_ += slice.len_;
+      }
+    }
+    // The upstream connection writes and drains the body.
+    data.drain(data.length());
+  }
+  void decodeTrailers(HeaderMapPtr&&) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder&, bool) override { return *this; }
+  void onGoAway() override {}
+
+  const char* read_start_{};
+  const char* read_end_{};
+  uint64_t moved_bytes_{};
+  uint64_t copied_bytes_{};
+};
+
+/**
+ * The bytes of a request sent over the wire, made up of pieces which are repeated rather than
+ * held in memory at once.
+ */
+class Wire {
+public:
+  void add(absl::string_view piece) { pieces_.push_back(piece); }
+
+  // Copy the next bytes of the request into a read buffer, as a socket read would.
+  uint64_t read(char* out, uint64_t size) {
+    uint64_t copied = 0;
+    while (copied < size && index_ < pieces_.size()) {
+      const absl::string_view piece = pieces_[index_].substr(offset_);
+      const uint64_t length = std::min<uint64_t>(piece.size(), size - copied);
+      memcpy(out + copied, piece.data(), length);
+      copied += length;
+      offset_ += length;
+      if (offset_ == pieces_[index_].size()) {
+        index_++;
+        offset_ = 0;
+      }
+    }
+    return copied;
+  }
+
+private:
+  std::vector<absl::string_view> pieces_;
+  size_t index_{};
+  size_t offset_{};
+};
+
+// Dispatch a request to a server codec in socket sized reads.
+static void proxyRequest(Wire& wire, BodyCounter& counter) {
+  Stats::IsolatedStoreImpl store;
+  NiceMock<Network::MockConnection> connection;
+  ServerConnectionImpl codec(connection, store, counter, Http1Settings(), 60, 100);
+  while (true) {
+    Buffer::OwnedImpl read;
+    Buffer::RawSlice slice;
+    read.reserve(ReadSize, &slice, 1);
+    slice.len_ = wire.read(static_cast<char*>(slice.mem_), ReadSize);
+    if (slice.len_ == 0) {
+      break;
+    }
+    read.commit(&slice, 1);
+    counter.read_start_ = static_cast<const char*>(slice.mem_);
+    counter.read_end_ = counter.read_start_ + slice.len_;
+    codec.dispatch(read);
+  }
+}
+
+static void reportCopies(benchmark::State& state, const BodyCounter& counter) {
+  state.SetBytesProcessed(state.iterations() * BodySize);
+  state.counters["copies_per_byte"] = static_cast<double>(counter.copied_bytes_) /
+                                      (counter.copied_bytes_ + counter.moved_bytes_);
+}
+
+// Proxy a 100MB body with a content-length.
+static void Http1ProxyContentLengthBody(benchmark::State& state) {
+  const std::string headers = absl::StrCat("POST /upload HTTP/1.1\r\ncontent-length: ", BodySize,
+                                           "\r\n\r\n");
+  const std::string chunk(ChunkSize, 'a');
+  BodyCounter counter;
+  for (auto _ : state) {
+    Wire wire;
+    wire.add(headers);
+    for (uint64_t i = 0; i < BodySize / ChunkSize; i++) {
+      wire.add(chunk);
+    }
+    proxyRequest(wire, counter);
+  }
+  reportCopies(state, counter);
+}
+BENCHMARK(Http1ProxyContentLengthBody)->Unit(benchmark::kMillisecond);
+
+// Proxy a 100MB body in 1MB chunks.
+static void Http1ProxyChunkedBody(benchmark::State& state) {
+  const std::string headers = "POST /upload HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n";
+  const std::string chunk = absl::StrCat(absl::Hex(ChunkSize), "\r\n", std::string(ChunkSize, 'a'),
+                                         "\r\n");
+  BodyCounter counter;
+  for (auto _ : state) {
+    Wire wire;
+    wire.add(headers);
+    for (uint64_t i = 0; i < BodySize / ChunkSize; i++) {
+      wire.add(chunk);
+    }
+    wire.add("0\r\n\r\n");
+    proxyRequest(wire, counter);
+  }
+  reportCopies(state, counter);
+}
+BENCHMARK(Http1ProxyChunkedBody)->Unit(benchmark::kMillisecond);
+
+/**
+ * Decodes requests and keeps the encoder of the latest one, so that a response can be encoded.
+ */
+class ResponseEncoderCapture : public StreamDecoder, public ServerConnectionCallbacks {
+public:
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool) override {}
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(HeaderMapPtr&&) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder& response_encoder, bool) override {
+    response_encoder_ = &response_encoder;
+    return *this;
+  }
+  void onGoAway() override {}
+
+  StreamEncoder* response_encoder_{};
+};
+
+// Encode the headers of a typical response to each request of a connection.
+static void Http1EncodeResponseHeaders(benchmark::State& state) {
+  Stats::IsolatedStoreImpl store;
+  NiceMock<Network::MockConnection> connection;
+  uint64_t bytes_written = 0;
+  ON_CALL(connection, write(_, _))
+      .WillByDefault(Invoke([&bytes_written](Buffer::Instance& data, bool) -> void {
+        bytes_written += data.length();
+        data.drain(data.length());
+      }));
+  ResponseEncoderCapture capture;
+  ServerConnectionImpl codec(connection, store, capture, Http1Settings(), 60, 100);
+  const TestHeaderMapImpl response_headers{{":status", "200"},
+                                           {"content-type", "application/json"},
+                                           {"content-length", "1024"},
+                                           {"date", "Mon, 01 Jul 2019 00:00:00 GMT"},
+                                           {"server", "envoy"},
+                                           {"cache-control", "private, max-age=0"},
+                                           {"x-envoy-upstream-service-time", "12"},
+                                           {"vary", "Accept-Encoding"}};
+  const std::string request = "GET / HTTP/1.1\r\nhost: www.example.com\r\n\r\n";
+  const std::string body(1024, 'a');
+  for (auto _ : state) {
+    Buffer::OwnedImpl buffer(request);
+    codec.dispatch(buffer);
+    capture.response_encoder_->encodeHeaders(response_headers, false);
+    Buffer::OwnedImpl data(body);
+    capture.response_encoder_->encodeData(data, true);
+  }
+  state.SetBytesProcessed(bytes_written);
+}
+BENCHMARK(Http1EncodeResponseHeaders);
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -882,6 +882,84 @@ TEST_F(Http1ConnPoolImplTest, PendingRequestIsConsideredActive) {
   EXPECT_EQ(1U, cluster_->stats_.upstream_cx_destroy_remote_.value());
 }
 
+// Test that the prefetch ratio establishes connections ahead of demand.
+TEST_F(Http1ConnPoolImplTest, PrefetchRatio) {
+  cluster_->resetResourceManager(3, 1024, 1024, 1, 1);
+  cluster_->prefetch_ratio_ = 1.5;
+
+  // The first request needs one connection, and the ratio asks for a second one.
+  {
+    InSequence s;
+    conn_pool_.expectClientCreate();
+    conn_pool_.expectClientCreate();
+  }
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(1U, cluster_->prefetch_stats_.upstream_cx_prefetch_total_.value());
+
+  // The first connection serves the request and the prefetched one becomes ready.
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connect_timer_, disableTimer());
+  r1.expectNewStream();
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  r1.startRequest();
+  EXPECT_CALL(*conn_pool_.test_clients_[1].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // The second request uses the prefetched connection, and the ratio asks for a third one.
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_EQ(3U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(2U, cluster_->prefetch_stats_.upstream_cx_prefetch_total_.value());
+  EXPECT_EQ(0U, cluster_->prefetch_stats_.upstream_cx_prefetch_overflow_.value());
+
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(3);
+  conn_pool_.drainConnections();
+  conn_pool_.test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+// Test that prefetching stops at the connection circuit breaker.
+TEST_F(Http1ConnPoolImplTest, PrefetchOverflow) {
+  cluster_->prefetch_ratio_ = 2;
+
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(0U, cluster_->prefetch_stats_.upstream_cx_prefetch_total_.value());
+  EXPECT_EQ(1U, cluster_->prefetch_stats_.upstream_cx_prefetch_overflow_.value());
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  r1.handle_->cancel();
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+// Test that prefetchConnections() warms an idle pool with a single connection.
+TEST_F(Http1ConnPoolImplTest, PrefetchConnections) {
+  conn_pool_.expectClientCreate();
+  conn_pool_.prefetchConnections();
+  EXPECT_EQ(1U, cluster_->prefetch_stats_.upstream_cx_prefetch_total_.value());
+
+  // The pool already has a connection, so prefetching again does nothing.
+  conn_pool_.prefetchConnections();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_total_.value());
+
+  // The first request uses the prefetched connection without waiting for a new one.
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::Immediate);
+  r1.startRequest();
+  r1.completeResponse(false);
+
+  conn_pool_.drainConnections();
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  dispatcher_.clearDeferredDeleteList();
+}
+
 } // namespace
 } // namespace Http1
 } // namespace Http
@@ -0,0 +1,118 @@
+#include <http_parser.h>
+
+#include <string>
+
+#include "common/http/http1/simd_parser.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+static int onData(http_parser*, const char*, size_t) { return 0; }
+static int onEvent(http_parser*) { return 0; }
+
+static http_parser_settings noopSettings() {
+  http_parser_settings settings;
+  http_parser_settings_init(&settings);
+  settings.on_message_begin = onEvent;
+  settings.on_url = onData;
+  settings.on_status = onData;
+  settings.on_header_field = onData;
+  settings.on_header_value = onData;
+  settings.on_headers_complete = onEvent;
+  settings.on_body = onData;
+  settings.on_message_complete = onEvent;
+  settings.on_chunk_header = onEvent;
+  settings.on_chunk_complete = onEvent;
+  return settings;
+}
+
+/**
+ * A request with the headers a browser typically sends. The numeric Arg passed by the
+ * BENCHMARK(...) macro call below indicates how many of them are pipelined in one buffer.
+ */
+static std::string browserRequests(int64_t count) {
+  std::string requests;
+  for (int64_t i = 0; i < count; i++) {
+    requests +=
+        "GET /static/js/main.0123456789abcdef.js?v=20190701 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+        "Chrome/75.0.3770.142 Safari/537.36\r\n"
+        "Accept: */*\r\n"
+        "Referer: https://www.example.com/index.html\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "Cookie: _ga=GA1.2.1234567890.1234567890; _gid=GA1.2.1234567890.1234567890; "
+        "session=0123456789abcdef0123456789abcdef\r\n"
+        "\r\n";
+  }
+  return requests;
+}
+
+static std::string chunkedRequest() {
+  std::string request = "POST /upload HTTP/1.1\r\nHost: www.example.com\r\n"
+                        "Content-Type: application/octet-stream\r\n"
+                        "Transfer-Encoding: chunked\r\n\r\n";
+  for (int i = 0; i < 16; i++) {
+    request += "400\r\n" + std::string(1024, 'a') + "\r\n";
+  }
+  request += "0\r\n\r\n";
+  return request;
+}
+
+// Parse with http_parser.
+static void parseHttpParser(benchmark::State& state, const std::string& data) {
+  const http_parser_settings settings = noopSettings();
+  for (auto _ : state) {
+    http_parser parser;
+    http_parser_init(&parser, HTTP_REQUEST);
+    benchmark::DoNotOptimize(http_parser_execute(&parser, &settings, data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// Parse with SimdParser.
+static void parseSimd(benchmark::State& state, const std::string& data) {
+  const http_parser_settings settings = noopSettings();
+  for (auto _ : state) {
+    http_parser parser;
+    http_parser_init(&parser, HTTP_REQUEST);
+    SimdParser simd_parser(parser, settings, 60 * 1024);
+    benchmark::DoNotOptimize(simd_parser.execute(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void HttpParserRequests(benchmark::State& state) {
+  parseHttpParser(state, browserRequests(state.range(0)));
+}
+BENCHMARK(HttpParserRequests)->Arg(1)->Arg(16);
+
+static void SimdParserRequests(benchmark::State& state) {
+  parseSimd(state, browserRequests(state.range(0)));
+}
+BENCHMARK(SimdParserRequests)->Arg(1)->Arg(16);
+
+static void HttpParserChunked(benchmark::State& state) { parseHttpParser(state, chunkedRequest()); }
+BENCHMARK(HttpParserChunked);
+
+static void SimdParserChunked(benchmark::State& state) { parseSimd(state, chunkedRequest()); }
+BENCHMARK(SimdParserChunked);
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/http2/codec_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+// Size of the gRPC messages streamed by each iteration.
+static constexpr uint64_t MessageSize = 1024 * 1024;
+// Number of gRPC messages streamed by each iteration.
+static constexpr uint64_t MessageCount = 100;
+// Size of each read from the downstream socket.
+static constexpr uint64_t ReadSize = 16 * 1024;
+// Number of reads whose memory is kept before it is reused. Body data is consumed as soon as it is
+// decoded, so this only has to cover the reads making up a couple of DATA frames.
+static constexpr uint64_t ReadCount = 64;
+
+/**
+ * Counts the body bytes which are delivered in slices read from the socket, and those which were
+ * copied into other slices by the codec.
+ */
+class BodyCounter : public StreamDecoder, public ServerConnectionCallbacks {
+public:
+  BodyCounter() : reads_(ReadSize * ReadCount) {}
+
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool) override {}
+  void decodeData(Buffer::Instance& data, bool) override {
+    const uint64_t num_slices = data.getRawSlices(nullptr, 0);
+    std::vector<Buffer::RawSlice> slices(num_slices);
+    data.getRawSlices(slices.data(), num_slices);
+    for (const Buffer::RawSlice& slice : slices) {
+      const char* mem = static_cast<const char*>(slice.mem_);
+      if (mem >= reads_.data() && mem < reads_.data() + reads_.size()) {
+        moved_bytes_ += slice.len_;
+      } else {
+        copied_bytes_ += slice.len_;
+      }
+    }
+    // The upstream connection writes and drains the body.
+    data.drain(data.length());
+  }
+  void decodeTrailers(HeaderMapPtr&&) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder&, bool) override { return *this; }
+  void onGoAway() override {}
+
+  // Memory which socket reads are done into, in turn.
+  std::vector<char> reads_;
+  uint64_t moved_bytes_{};
+  uint64_t copied_bytes_{};
+};
+
+/**
+ * Ignores responses and connection events on the client side.
+ */
+class NullResponseDecoder : public StreamDecoder, public ConnectionCallbacks {
+public:
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool) override {}
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(HeaderMapPtr&&) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+
+  // Http::ConnectionCallbacks
+  void onGoAway() override {}
+};
+
+// Stream gRPC messages from a client codec to a server codec, which reads them in socket sized
+// reads.
+static void streamMessages(BodyCounter& counter) {
+  Stats::IsolatedStoreImpl store;
+  NiceMock<Network::MockConnection> client_connection;
+  NiceMock<Network::MockConnection> server_connection;
+  NullResponseDecoder response_decoder;
+  ClientConnectionImpl client(client_connection, response_decoder, store, Http2Settings(), 60,
+                              100);
+  ServerConnectionImpl server(server_connection, counter, store, Http2Settings(), 60, 100);
+
+  Buffer::OwnedImpl wire;
+  ON_CALL(client_connection, write(_, _))
+      .WillByDefault(Invoke([&wire](Buffer::Instance& data, bool) -> void { wire.move(data); }));
+  ON_CALL(server_connection, write(_, _))
+      .WillByDefault(Invoke([&client](Buffer::Instance& data, bool) -> void {
+        static_cast<ConnectionImpl&>(client).dispatch(data);
+      }));
+
+  uint64_t read_index = 0;
+  auto read_wire = [&]() -> void {
+    while (wire.length() > 0) {
+      char* mem = counter.reads_.data() + (read_index++ % ReadCount) * ReadSize;
+      const uint64_t length = std::min(wire.length(), ReadSize);
+      wire.copyOut(0, length, mem);
+      wire.drain(length);
+      auto* fragment = new Buffer::BufferFragmentImpl(
+          mem, length, [](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+            delete fragment;
+          });
+      Buffer::OwnedImpl read;
+      read.addBufferFragment(*fragment);
+      static_cast<ConnectionImpl&>(server).dispatch(read);
+    }
+  };
+
+  StreamEncoder& request_encoder = client.newStream(response_decoder);
+  const TestHeaderMapImpl request_headers{{":method", "POST"},
+                                          {":path", "/helloworld.Greeter/SayHello"},
+                                          {":scheme", "http"},
+                                          {":authority", "host"},
+                                          {"content-type", "application/grpc"},
+                                          {"te", "trailers"}};
+  request_encoder.encodeHeaders(request_headers, false);
+  // A length-prefixed gRPC message.
+  std::string message(5 + MessageSize, 'a');
+  message[0] = 0;
+  for (int i = 0; i < 4; i++) {
+    message[1 + i] = static_cast<char>((MessageSize >> (8 * (3 - i))) & 0xff);
+  }
+  for (uint64_t i = 0; i < MessageCount; i++) {
+    Buffer::OwnedImpl data(message);
+    request_encoder.encodeData(data, i == MessageCount - 1);
+    read_wire();
+  }
+}
+
+// Stream 100 1MB gRPC messages on one stream.
+static void Http2StreamGrpcMessages(benchmark::State& state) {
+  BodyCounter counter;
+  for (auto _ : state) {
+    streamMessages(counter);
+  }
+  state.SetBytesProcessed(state.iterations() * MessageCount * (5 + MessageSize));
+  state.counters["copies_per_byte"] = static_cast<double>(counter.copied_bytes_) /
+                                      (counter.copied_bytes_ + counter.moved_bytes_);
+}
+BENCHMARK(Http2StreamGrpcMessages)->Unit(benchmark::kMillisecond);
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
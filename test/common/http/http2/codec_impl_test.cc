@@ -1259,6 +1259,130 @@ TEST_P(Http2CodecImplTestAll, TestCodecHeaderCompression) {
   }
 }
 
+// Verify that a DATA payload which ends a read slice is moved to the stream without being copied.
+TEST_P(Http2CodecImplTest, DataSlicesMoved) {
+  initialize();
+
+  Buffer::OwnedImpl wire;
+  ON_CALL(client_connection_, write(_, _))
+      .WillByDefault(Invoke([&wire](Buffer::Instance& data, bool) -> void { wire.move(data); }));
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  request_encoder_->encodeHeaders(request_headers, false);
+  Buffer::OwnedImpl body(std::string(1024, 'a'));
+  request_encoder_->encodeData(body, true);
+
+  // Everything the client sent is read into a single slice, which ends with the DATA payload.
+  Buffer::OwnedImpl read;
+  read.appendSliceForTest(wire.toString());
+  Buffer::RawSlice read_slice;
+  ASSERT_EQ(1U, read.getRawSlices(&read_slice, 1));
+
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(request_decoder_, decodeData(_, true))
+      .WillOnce(Invoke([&read_slice](Buffer::Instance& data, bool) -> void {
+        Buffer::RawSlice slice;
+        ASSERT_EQ(1U, data.getRawSlices(&slice, 1));
+        EXPECT_EQ(static_cast<const char*>(read_slice.mem_) + read_slice.len_ - 1024, slice.mem_);
+        EXPECT_EQ(1024U, slice.len_);
+      }));
+  static_cast<ConnectionImpl&>(*server_).dispatch(read);
+  EXPECT_EQ(0U, read.length());
+}
+
+// Verify that the encoder table size only limits the dynamic table of the sending side.
+TEST_P(Http2CodecImplTest, EncoderHpackTableSize) {
+  client_http2settings_.encoder_hpack_table_size_ = 0;
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"compression", "test"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true));
+  response_encoder_->encodeHeaders(response_headers, true);
+
+  EXPECT_EQ(0, nghttp2_session_get_hd_deflate_dynamic_table_size(client_->session()));
+  EXPECT_NE(0, nghttp2_session_get_hd_deflate_dynamic_table_size(server_->session()));
+}
+
+// Verify that the decoder table size is advertised to the peer, which limits its encoder.
+TEST_P(Http2CodecImplTest, DecoderHpackTableSize) {
+  server_http2settings_.decoder_hpack_table_size_ = 0;
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"compression", "test"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true));
+  response_encoder_->encodeHeaders(response_headers, true);
+
+  EXPECT_EQ(0, nghttp2_session_get_hd_deflate_dynamic_table_size(client_->session()));
+  EXPECT_EQ(0, nghttp2_session_get_hd_inflate_dynamic_table_size(server_->session()));
+  EXPECT_NE(0, nghttp2_session_get_hd_deflate_dynamic_table_size(server_->session()));
+}
+
+// Verify that never indexed headers are proxied but not added to the dynamic table.
+TEST_P(Http2CodecImplTest, NeverIndexHeaders) {
+  client_http2settings_.never_index_headers_ = std::make_shared<const LowerCaseStrFlatHashSet>(
+      LowerCaseStrFlatHashSet{LowerCaseString("x-request-id")});
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+  const size_t table_size = nghttp2_session_get_hd_deflate_dynamic_table_size(client_->session());
+
+  request_encoder_ = &client_->newStream(response_decoder_);
+  request_headers.addCopy("x-request-id", "5f4d9d6a-0b1c-4a3e-9c2d-7e6f5a4b3c2d");
+  EXPECT_CALL(request_decoder_, decodeHeaders_(HeaderMapEqual(&request_headers), true));
+  request_encoder_->encodeHeaders(request_headers, true);
+  EXPECT_EQ(table_size, nghttp2_session_get_hd_deflate_dynamic_table_size(client_->session()));
+  EXPECT_EQ(table_size, nghttp2_session_get_hd_inflate_dynamic_table_size(server_->session()));
+
+  request_encoder_ = &client_->newStream(response_decoder_);
+  request_headers.addCopy("x-other", "value");
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+  EXPECT_LT(table_size, nghttp2_session_get_hd_deflate_dynamic_table_size(client_->session()));
+}
+
+// Verify that the uncompressed and encoded sizes of headers are tracked in both directions.
+TEST_P(Http2CodecImplTest, HeaderCompressionStats) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, false));
+  request_encoder_->encodeHeaders(request_headers, false);
+  const uint64_t request_bytes = request_headers.byteSize().value();
+  EXPECT_EQ(request_bytes, stats_store_.counter("http2.tx_header_bytes").value());
+  EXPECT_EQ(request_bytes, stats_store_.counter("http2.rx_header_bytes").value());
+
+  TestHeaderMapImpl request_trailers{{"trailing", "header"}};
+  EXPECT_CALL(request_decoder_, decodeTrailers_(_));
+  request_encoder_->encodeTrailers(request_trailers);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true));
+  response_encoder_->encodeHeaders(response_headers, true);
+
+  const uint64_t header_bytes = request_bytes + request_trailers.byteSize().value() +
+                                response_headers.byteSize().value();
+  EXPECT_EQ(header_bytes, stats_store_.counter("http2.tx_header_bytes").value());
+  EXPECT_EQ(header_bytes, stats_store_.counter("http2.rx_header_bytes").value());
+  const uint64_t header_block_bytes = stats_store_.counter("http2.tx_header_block_bytes").value();
+  EXPECT_LT(0, header_block_bytes);
+  EXPECT_GT(header_bytes, header_block_bytes);
+  EXPECT_EQ(header_block_bytes, stats_store_.counter("http2.rx_header_block_bytes").value());
+}
+
 // Verify that codec detects PING flood
 TEST_P(Http2CodecImplTest, PingFlood) {
   initialize();
@@ -767,6 +767,25 @@ TEST_F(Http2ConnPoolImplTest, DrainedConnectionsNotActive) {
 
   closeClient(0);
 }
+
+// Show that prefetching establishes the primary connection ahead of the first request.
+TEST_F(Http2ConnPoolImplTest, PrefetchConnections) {
+  expectClientCreate();
+  pool_.prefetchConnections();
+  EXPECT_EQ(1U, cluster_->prefetch_stats_.upstream_cx_prefetch_total_.value());
+  EXPECT_FALSE(pool_.hasActiveConnections());
+
+  // The primary connection can carry the stream, so prefetching again does nothing.
+  pool_.prefetchConnections();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_total_.value());
+
+  EXPECT_CALL(*test_clients_[0].connect_timer_, disableTimer());
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // The first request does not have to wait for a connection.
+  ActiveTestRequest r1(*this, 0, true);
+  completeRequestCloseUpstream(0, r1);
+}
 } // namespace Http2
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,267 @@
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/shared_conn_pool.h"
+
+#include "test/common/http/common.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+class SharedConnPoolImplTest : public testing::Test {
+public:
+  SharedConnPoolImplTest()
+      : host_(Upstream::makeTestHost(cluster_, "tcp://127.0.0.1:80")),
+        pool_(std::make_unique<SharedConnPoolImpl>(
+            dispatcher_, owner_, host_, Protocol::Http2,
+            [this]() -> ConnectionPool::Instance* { return owner_pool_; })) {
+    ON_CALL(upstream_encoder_, getStream()).WillByDefault(ReturnRef(upstream_encoder_.stream_));
+  }
+
+  // Creates a stream on the shared pool and captures the callbacks handed to the owner pool.
+  ConnectionPool::Cancellable* newStream(ConnectionPool::Cancellable* owner_handle = nullptr) {
+    EXPECT_CALL(owner_pool_mock_, newStream(_, _))
+        .WillOnce(Invoke([this, owner_handle](StreamDecoder& decoder,
+                                              ConnectionPool::Callbacks& callbacks)
+                             -> ConnectionPool::Cancellable* {
+          upstream_decoder_ = &decoder;
+          upstream_callbacks_ = &callbacks;
+          return owner_handle;
+        }));
+    ConnectionPool::Cancellable* handle = pool_->newStream(response_decoder_, callbacks_);
+    EXPECT_NE(nullptr, handle);
+    EXPECT_TRUE(pool_->hasActiveConnections());
+    return handle;
+  }
+
+  void poolReady() {
+    EXPECT_CALL(upstream_encoder_.stream_, addCallbacks(_))
+        .WillOnce(Invoke(
+            [&](StreamCallbacks& callbacks) -> void { upstream_stream_callbacks_ = &callbacks; }));
+    EXPECT_CALL(callbacks_.pool_ready_, ready());
+    upstream_callbacks_->onPoolReady(upstream_encoder_, host_, stream_info_);
+    ASSERT_NE(nullptr, callbacks_.outer_encoder_);
+  }
+
+  std::shared_ptr<NiceMock<Upstream::MockClusterInfo>> cluster_{
+      new NiceMock<Upstream::MockClusterInfo>()};
+  Upstream::HostSharedPtr host_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Event::MockDispatcher> owner_dispatcher_;
+  SharedConnPoolOwnerSharedPtr owner_{std::make_shared<SharedConnPoolOwner>(owner_dispatcher_)};
+  NiceMock<ConnectionPool::MockInstance> owner_pool_mock_;
+  ConnectionPool::Instance* owner_pool_{&owner_pool_mock_};
+  std::unique_ptr<SharedConnPoolImpl> pool_;
+  NiceMock<MockStreamDecoder> response_decoder_;
+  ConnPoolCallbacks callbacks_;
+  NiceMock<MockStreamEncoder> upstream_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  StreamDecoder* upstream_decoder_{};
+  ConnectionPool::Callbacks* upstream_callbacks_{};
+  StreamCallbacks* upstream_stream_callbacks_{};
+};
+
+// A full request/response is forwarded between the local worker and the owner.
+TEST_F(SharedConnPoolImplTest, RequestResponse) {
+  newStream();
+  poolReady();
+
+  TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/"}};
+  EXPECT_CALL(upstream_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  callbacks_.outer_encoder_->encodeHeaders(request_headers, false);
+
+  Buffer::OwnedImpl request_body("hello");
+  EXPECT_CALL(upstream_encoder_, encodeData(BufferStringEqual("hello"), true));
+  callbacks_.outer_encoder_->encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  upstream_decoder_->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                   false);
+  EXPECT_TRUE(pool_->hasActiveConnections());
+
+  Buffer::OwnedImpl response_body("world");
+  EXPECT_CALL(response_decoder_, decodeData(BufferStringEqual("world"), false));
+  upstream_decoder_->decodeData(response_body, false);
+
+  EXPECT_CALL(upstream_encoder_.stream_, removeCallbacks(_));
+  EXPECT_CALL(response_decoder_, decodeTrailers_(_));
+  upstream_decoder_->decodeTrailers(HeaderMapPtr{new TestHeaderMapImpl{{"grpc-status", "0"}}});
+  EXPECT_FALSE(pool_->hasActiveConnections());
+
+  ReadyWatcher drained;
+  EXPECT_CALL(drained, ready());
+  pool_->addDrainedCallback([&]() -> void { drained.ready(); });
+}
+
+// Cancelling before the owner pool is ready cancels the owner's pending request.
+TEST_F(SharedConnPoolImplTest, CancelPending) {
+  ConnectionPool::MockCancellable owner_handle;
+  ConnectionPool::Cancellable* handle = newStream(&owner_handle);
+
+  EXPECT_CALL(owner_handle, cancel());
+  handle->cancel();
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// A stream cancelled before the owner picks it up never reaches the owner pool.
+TEST_F(SharedConnPoolImplTest, CancelBeforeHandoff) {
+  // Hold back everything posted to the owner until the local stream is cancelled.
+  std::vector<Event::PostCb> owner_posts;
+  ON_CALL(owner_dispatcher_, post(_))
+      .WillByDefault(Invoke([&](Event::PostCb cb) -> void { owner_posts.push_back(cb); }));
+
+  ConnectionPool::Cancellable* handle = pool_->newStream(response_decoder_, callbacks_);
+  handle->cancel();
+  EXPECT_FALSE(pool_->hasActiveConnections());
+
+  // The queued stream start is dropped entirely.
+  EXPECT_CALL(owner_pool_mock_, newStream(_, _)).Times(0);
+  for (auto& cb : owner_posts) {
+    cb();
+  }
+}
+
+// A pool failure on the owner is reported to the local callbacks.
+TEST_F(SharedConnPoolImplTest, OwnerPoolFailure) {
+  newStream();
+
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  upstream_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure,
+                                     "connect failed", host_);
+  EXPECT_EQ(host_, callbacks_.host_);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// If the owner has no pool for the host the stream fails.
+TEST_F(SharedConnPoolImplTest, NoOwnerPool) {
+  owner_pool_ = nullptr;
+
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  pool_->newStream(response_decoder_, callbacks_);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// Once the owner is gone new streams fail without posting to it.
+TEST_F(SharedConnPoolImplTest, OwnerGone) {
+  owner_->invalidate();
+
+  EXPECT_CALL(owner_dispatcher_, post(_)).Times(0);
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  EXPECT_EQ(nullptr, pool_->newStream(response_decoder_, callbacks_));
+  EXPECT_EQ(host_, callbacks_.host_);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// A remote reset on the owner is delivered to the local stream callbacks.
+TEST_F(SharedConnPoolImplTest, UpstreamReset) {
+  newStream();
+  poolReady();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks_.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset, _));
+  upstream_stream_callbacks_->onResetStream(StreamResetReason::RemoteReset, "");
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// A local reset resets the upstream stream on the owner.
+TEST_F(SharedConnPoolImplTest, LocalReset) {
+  newStream();
+  poolReady();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks_.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(upstream_encoder_.stream_, removeCallbacks(_));
+  EXPECT_CALL(upstream_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset, _));
+  callbacks_.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+}
+
+// Events posted back by the owner after a local reset are dropped.
+TEST_F(SharedConnPoolImplTest, LocalResetDropsPostedEvents) {
+  newStream();
+  poolReady();
+
+  // Hold back everything posted to the local worker until the local stream is reset.
+  std::vector<Event::PostCb> local_posts;
+  ON_CALL(dispatcher_, post(_))
+      .WillByDefault(Invoke([&](Event::PostCb cb) -> void { local_posts.push_back(cb); }));
+  upstream_decoder_->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                   false);
+  Buffer::OwnedImpl response_body("world");
+  upstream_decoder_->decodeData(response_body, false);
+
+  EXPECT_CALL(upstream_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  callbacks_.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_FALSE(pool_->hasActiveConnections());
+
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(response_decoder_, decodeData(_, _)).Times(0);
+  pool_.reset();
+  for (auto& cb : local_posts) {
+    cb();
+  }
+}
+
+// Watermark events on the owner's stream are forwarded to the local stream callbacks.
+TEST_F(SharedConnPoolImplTest, Watermarks) {
+  newStream();
+  poolReady();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks_.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  upstream_stream_callbacks_->onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  upstream_stream_callbacks_->onBelowWriteBufferLowWatermark();
+
+  EXPECT_CALL(upstream_encoder_.stream_, readDisable(true));
+  callbacks_.outer_encoder_->getStream().readDisable(true);
+}
+
+// Destroying the pool with an active stream resets the stream on the owner.
+TEST_F(SharedConnPoolImplTest, DestroyWithActiveStream) {
+  newStream();
+  poolReady();
+
+  EXPECT_CALL(upstream_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  pool_.reset();
+}
+
+// Destroying the pool after the owner is gone does not post to the owner.
+TEST_F(SharedConnPoolImplTest, DestroyAfterOwnerGone) {
+  newStream();
+  poolReady();
+  owner_->invalidate();
+
+  EXPECT_CALL(owner_dispatcher_, post(_)).Times(0);
+  EXPECT_CALL(upstream_encoder_.stream_, resetStream(_)).Times(0);
+  pool_.reset();
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
@@ -288,6 +288,25 @@ initial_connection_window_size: 65535
     EXPECT_EQ(2U, http2_settings.max_concurrent_streams_);
     EXPECT_EQ(65535U, http2_settings.initial_stream_window_size_);
     EXPECT_EQ(65535U, http2_settings.initial_connection_window_size_);
+    EXPECT_EQ(1U, http2_settings.encoderHpackTableSize());
+    EXPECT_EQ(1U, http2_settings.decoderHpackTableSize());
+  }
+
+  {
+    const std::string yaml = R"EOF(
+hpack_table_size: 1
+encoder_hpack_table_size: 2
+decoder_hpack_table_size: 3
+never_index_headers: ["X-Request-Id", "traceparent"]
+    )EOF";
+    auto http2_settings = parseHttp2SettingsFromV2Yaml(yaml);
+    EXPECT_EQ(1U, http2_settings.hpack_table_size_);
+    EXPECT_EQ(2U, http2_settings.encoderHpackTableSize());
+    EXPECT_EQ(3U, http2_settings.decoderHpackTableSize());
+    ASSERT_NE(nullptr, http2_settings.never_index_headers_);
+    EXPECT_EQ(2, http2_settings.never_index_headers_->size());
+    EXPECT_EQ(1, http2_settings.never_index_headers_->count(absl::string_view("x-request-id")));
+    EXPECT_EQ(1, http2_settings.never_index_headers_->count(absl::string_view("traceparent")));
   }
 }
 
@@ -1,6 +1,13 @@
+#include <map>
+#include <random>
+
+#include "common/memory/stats.h"
 #include "common/network/lc_trie.h"
 #include "common/network/utility.h"
 
+#include "extensions/filters/http/ip_tagging/ip_tag_file.h"
+
+#include "absl/container/inlined_vector.h"
 #include "benchmark/benchmark.h"
 
 namespace {
@@ -95,6 +102,178 @@ static void BM_LcTrieLookupMinimal(benchmark::State& state) {
 
 BENCHMARK(BM_LcTrieLookupMinimal);
 
+// The prefixes of a geo or ASN dataset: mostly /24s, and wider prefixes which may contain them,
+// spread over the IPv4 address space and a tenth of them in 2000::/3, with 50,000 tags.
+static const std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>&
+largeTagData(size_t prefix_count) {
+  static std::map<size_t,
+                  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>>
+      tag_data;
+  auto& data = tag_data[prefix_count];
+  if (!data.empty()) {
+    return data;
+  }
+  const uint32_t tag_count = 50000;
+  std::mt19937 random(prefix_count);
+  for (uint32_t i = 0; i < tag_count; i++) {
+    data.emplace_back(fmt::format("AS{}", i), std::vector<Network::Address::CidrRange>());
+  }
+  for (size_t i = 0; i < prefix_count; i++) {
+    const uint32_t length = std::vector<uint32_t>{24, 24, 24, 24, 24, 22, 20, 32}[random() % 8];
+    std::string address;
+    if (i % 10 == 0) {
+      address = fmt::format("{:x}:{:x}:{:x}::", 0x2000 | (random() & 0x1fff), random() & 0xffff,
+                            random() & 0xffff);
+    } else {
+      const uint32_t ip = random();
+      address =
+          fmt::format("{}.{}.{}.{}", ip >> 24, (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff);
+    }
+    data[random() % tag_count].second.push_back(Network::Address::CidrRange::create(
+        address, i % 10 == 0 ? length + 24 : length));
+  }
+  return data;
+}
+
+static const std::vector<Network::Address::InstanceConstSharedPtr>& largeAddresses() {
+  static std::vector<Network::Address::InstanceConstSharedPtr> addresses;
+  if (addresses.empty()) {
+    std::mt19937 random(1);
+    for (size_t i = 0; i < 4096; i++) {
+      const uint32_t ip = random();
+      addresses.push_back(Network::Utility::parseInternetAddress(fmt::format(
+          "{}.{}.{}.{}", ip >> 24, (ip >> 16) & 0xff, (ip >> 8) & 0xff, ip & 0xff)));
+    }
+  }
+  return addresses;
+}
+
+// The largest LC trie is limited to 2^20 nodes, so it is measured at a fraction of the scale of
+// the tag file.
+static void BM_LcTrieConstructLarge(benchmark::State& state) {
+  const auto& data = largeTagData(state.range(0));
+  std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> trie;
+  uint64_t memory = 0;
+  for (auto _ : state) {
+    trie.reset();
+    const uint64_t start = Memory::Stats::totalCurrentlyAllocated();
+    trie = std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(data);
+    memory = Memory::Stats::totalCurrentlyAllocated() - start;
+  }
+  state.counters["memory"] = memory;
+}
+
+BENCHMARK(BM_LcTrieConstructLarge)->Arg(1 << 17)->Unit(benchmark::kMillisecond);
+
+static void BM_LcTrieLookupLarge(benchmark::State& state) {
+  const auto& addresses = largeAddresses();
+  Envoy::Network::LcTrie::LcTrie<std::string> trie(largeTagData(state.range(0)));
+  size_t i = 0;
+  size_t output_tags = 0;
+  for (auto _ : state) {
+    output_tags += trie.getData(addresses[i++ % addresses.size()]).size();
+  }
+  benchmark::DoNotOptimize(output_tags);
+}
+
+BENCHMARK(BM_LcTrieLookupLarge)->Arg(1 << 17);
+
+// The tags appended to a reused inline buffer, as the IP tagging filter and RBAC look them up.
+static void BM_LcTrieLookupLargeInlined(benchmark::State& state) {
+  const auto& addresses = largeAddresses();
+  Envoy::Network::LcTrie::LcTrie<std::string> trie(largeTagData(state.range(0)));
+  absl::InlinedVector<std::string, 4> tags;
+  size_t i = 0;
+  size_t output_tags = 0;
+  for (auto _ : state) {
+    tags.clear();
+    trie.getData(*addresses[i++ % addresses.size()], tags);
+    output_tags += tags.size();
+  }
+  benchmark::DoNotOptimize(output_tags);
+}
+
+BENCHMARK(BM_LcTrieLookupLargeInlined)->Arg(1 << 17);
+
+// The addresses looked up as batches, which overlap the cache misses of the addresses of a batch.
+// The items processed are addresses, as for the lookups of the other benchmarks.
+static void BM_LcTrieLookupLargeBatch(benchmark::State& state) {
+  const auto& all_addresses = largeAddresses();
+  Envoy::Network::LcTrie::LcTrie<std::string> trie(largeTagData(state.range(0)));
+  const size_t batch_size = state.range(1);
+  std::vector<std::vector<Network::Address::InstanceConstSharedPtr>> batches;
+  for (size_t i = 0; i + batch_size <= all_addresses.size(); i += batch_size) {
+    batches.emplace_back(all_addresses.begin() + i, all_addresses.begin() + i + batch_size);
+  }
+  std::vector<absl::InlinedVector<std::string, 4>> tags(batch_size);
+  size_t i = 0;
+  size_t output_tags = 0;
+  for (auto _ : state) {
+    for (auto& address_tags : tags) {
+      address_tags.clear();
+    }
+    trie.getData(batches[i++ % batches.size()], tags);
+    output_tags += tags[0].size();
+  }
+  benchmark::DoNotOptimize(output_tags);
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(BM_LcTrieLookupLargeBatch)->Args({1 << 17, 8})->Args({1 << 17, 64});
+
+// IPv6 addresses in 2000::/3, where the prefixes of the large tag data are.
+static void BM_LcTrieLookupLargeIpv6(benchmark::State& state) {
+  std::vector<Network::Address::InstanceConstSharedPtr> addresses;
+  std::mt19937 random(1);
+  for (size_t i = 0; i < 4096; i++) {
+    addresses.push_back(Network::Utility::parseInternetAddress(
+        fmt::format("{:x}:{:x}:{:x}::1", 0x2000 | (random() & 0x1fff), random() & 0xffff,
+                    random() & 0xffff)));
+  }
+  Envoy::Network::LcTrie::LcTrie<std::string> trie(largeTagData(state.range(0)));
+  absl::InlinedVector<std::string, 4> tags;
+  size_t i = 0;
+  size_t output_tags = 0;
+  for (auto _ : state) {
+    tags.clear();
+    trie.getData(*addresses[i++ % addresses.size()], tags);
+    output_tags += tags.size();
+  }
+  benchmark::DoNotOptimize(output_tags);
+}
+
+BENCHMARK(BM_LcTrieLookupLargeIpv6)->Arg(1 << 17);
+
+// The memory of the tag file is its size, as it is used in place.
+static void BM_IpTagFileBuild(benchmark::State& state) {
+  const auto& data = largeTagData(state.range(0));
+  Extensions::HttpFilters::IpTagging::IpTagFileConstSharedPtr file;
+  for (auto _ : state) {
+    file = Extensions::HttpFilters::IpTagging::IpTagFile::fromString(
+        Extensions::HttpFilters::IpTagging::IpTagFile::build(data));
+  }
+  state.counters["memory"] = file->size();
+  state.counters["ranges"] = file->rangeCount();
+  state.counters["tag_sets"] = file->tagSetCount();
+}
+
+BENCHMARK(BM_IpTagFileBuild)->Arg(1 << 17)->Arg(3000000)->Unit(benchmark::kMillisecond);
+
+static void BM_IpTagFileLookup(benchmark::State& state) {
+  const auto& addresses = largeAddresses();
+  Extensions::HttpFilters::IpTagging::IpTagFileConstSharedPtr file =
+      Extensions::HttpFilters::IpTagging::IpTagFile::fromString(
+          Extensions::HttpFilters::IpTagging::IpTagFile::build(largeTagData(state.range(0))));
+  size_t i = 0;
+  size_t output_size = 0;
+  for (auto _ : state) {
+    output_size += file->tagSetValue(file->lookup(*addresses[i++ % addresses.size()])).size();
+  }
+  benchmark::DoNotOptimize(output_size);
+}
+
+BENCHMARK(BM_IpTagFileLookup)->Arg(1 << 17)->Arg(3000000);
+
 } // namespace Envoy
 
 // Boilerplate main(), which discovers benchmarks in the same file and runs them.
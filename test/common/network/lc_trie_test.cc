@@ -7,6 +7,7 @@
 
 #include "test/test_common/utility.h"
 
+#include "absl/container/inlined_vector.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -37,12 +38,35 @@ public:
 
   void expectIPAndTags(
       const std::vector<std::pair<std::string, std::vector<std::string>>>& test_output) {
+    std::vector<Address::InstanceConstSharedPtr> addresses;
+    std::vector<std::vector<std::string>> expected_tags;
     for (const auto& kv : test_output) {
       std::vector<std::string> expected(kv.second);
       std::sort(expected.begin(), expected.end());
-      std::vector<std::string> actual(trie_->getData(Utility::parseInternetAddress(kv.first)));
+      const Address::InstanceConstSharedPtr address = Utility::parseInternetAddress(kv.first);
+      std::vector<std::string> actual(trie_->getData(address));
       std::sort(actual.begin(), actual.end());
       EXPECT_EQ(expected, actual);
+
+      // The data is appended to the buffer, which only allocates past its inline capacity.
+      absl::InlinedVector<std::string, 1> buffer{"existing"};
+      trie_->getData(*address, buffer);
+      std::vector<std::string> appended(buffer.begin() + 1, buffer.end());
+      std::sort(appended.begin(), appended.end());
+      EXPECT_EQ("existing", buffer.front());
+      EXPECT_EQ(expected, appended);
+
+      addresses.push_back(address);
+      expected_tags.push_back(expected);
+    }
+
+    // Looking up all the addresses as a batch, which walks through the trie in groups, gives the
+    // same data for each address.
+    std::vector<std::vector<std::string>> batch(addresses.size());
+    trie_->getData(addresses, batch);
+    for (size_t i = 0; i < addresses.size(); i++) {
+      std::sort(batch[i].begin(), batch[i].end());
+      EXPECT_EQ(expected_tags[i], batch[i]) << test_output[i].first;
     }
   }
 
@@ -234,6 +258,27 @@ TEST_F(LcTrieTest, CatchAllIPv6Prefix) {
   expectIPAndTags(test_case);
 }
 
+// Enough IPv6 prefixes for the children of the nodes to be packed into cache lines, with nested
+// prefixes and more addresses than a lookup batch.
+TEST_F(LcTrieTest, IPv6ManyPrefixes) {
+  std::vector<std::vector<std::string>> cidr_range_strings;
+  std::vector<std::pair<std::string, std::vector<std::string>>> test_case;
+  for (uint32_t i = 0; i < 100; i++) {
+    cidr_range_strings.push_back({fmt::format("2001:db8:{:x}::/{}", i * 37, 48 + i % 3)});
+    test_case.push_back({fmt::format("2001:db8:{:x}::1", i * 37), {fmt::format("tag_{}", i)}});
+  }
+  cidr_range_strings.push_back({"2001:db8::/32"}); // tag_100
+  for (auto& tags : test_case) {
+    tags.second.push_back("tag_100");
+  }
+  setup(cidr_range_strings);
+
+  test_case.push_back({"2001:db8:1::", {"tag_100"}});
+  test_case.push_back({"2001:db9::", {}});
+  test_case.push_back({"1.2.3.4", {}});
+  expectIPAndTags(test_case);
+}
+
 TEST_F(LcTrieTest, BothIpvVersions) {
   std::vector<std::vector<std::string>> cidr_range_strings = {
       {"2406:da00:2000::/40", "::1/128"},                            // tag_0
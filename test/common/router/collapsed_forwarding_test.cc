@@ -0,0 +1,218 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/router/collapsed_forwarding.h"
+
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+class MockCollapsedRequestCallbacks : public CollapsedRequestCallbacks {
+public:
+  MOCK_METHOD2(onCollapsedHeaders, void(const Http::HeaderMap& headers, bool end_stream));
+  MOCK_METHOD2(onCollapsedData, void(Buffer::Instance& data, bool end_stream));
+  MOCK_METHOD1(onCollapsedTrailers, void(const Http::HeaderMap& trailers));
+  MOCK_METHOD1(onCollapsedAbort, void(bool response_started));
+  MOCK_METHOD0(onCollapsedUnshareable, void());
+};
+
+class CollapsedForwardingTest : public testing::Test {
+public:
+  CollapsedForwardingTest() : response_(registry_.add("key", 8)) {}
+
+  CollapsedForwardingRegistry registry_;
+  CollapsedResponseSharedPtr response_;
+  Http::TestHeaderMapImpl response_headers_{{":status", "200"}};
+};
+
+TEST_F(CollapsedForwardingTest, Registry) {
+  EXPECT_EQ(response_, registry_.find("key"));
+  EXPECT_EQ(nullptr, registry_.find("other"));
+  EXPECT_TRUE(response_->joinable());
+
+  response_->encodeHeaders(response_headers_, true);
+  EXPECT_EQ(nullptr, registry_.find("key"));
+  EXPECT_FALSE(response_->joinable());
+}
+
+TEST_F(CollapsedForwardingTest, FanOut) {
+  MockCollapsedRequestCallbacks request1;
+  MockCollapsedRequestCallbacks request2;
+  response_->addRequest(request1);
+  response_->addRequest(request2);
+
+  EXPECT_CALL(request1, onCollapsedHeaders(HeaderMapEqualRef(&response_headers_), false));
+  EXPECT_CALL(request2, onCollapsedHeaders(HeaderMapEqualRef(&response_headers_), false));
+  response_->encodeHeaders(response_headers_, false);
+
+  EXPECT_CALL(request1, onCollapsedData(BufferStringEqual("hello"), false));
+  EXPECT_CALL(request2, onCollapsedData(BufferStringEqual("hello"), false));
+  Buffer::OwnedImpl data("hello");
+  response_->encodeData(data, false);
+  EXPECT_EQ(5, data.length());
+
+  Http::TestHeaderMapImpl trailers{{"foo", "bar"}};
+  EXPECT_CALL(request1, onCollapsedTrailers(HeaderMapEqualRef(&trailers)));
+  EXPECT_CALL(request2, onCollapsedTrailers(HeaderMapEqualRef(&trailers)));
+  response_->encodeTrailers(trailers);
+  EXPECT_EQ(nullptr, registry_.find("key"));
+}
+
+// A request collapsed after the response started is sent what it missed.
+TEST_F(CollapsedForwardingTest, LateRequest) {
+  MockCollapsedRequestCallbacks request1;
+  response_->addRequest(request1);
+  EXPECT_CALL(request1, onCollapsedHeaders(_, false));
+  response_->encodeHeaders(response_headers_, false);
+  EXPECT_CALL(request1, onCollapsedData(_, false)).Times(2);
+  Buffer::OwnedImpl data1("abc");
+  response_->encodeData(data1, false);
+  Buffer::OwnedImpl data2("def");
+  response_->encodeData(data2, false);
+
+  MockCollapsedRequestCallbacks request2;
+  {
+    InSequence s;
+    EXPECT_CALL(request2, onCollapsedHeaders(HeaderMapEqualRef(&response_headers_), false));
+    EXPECT_CALL(request2, onCollapsedData(BufferStringEqual("abc"), false));
+    EXPECT_CALL(request2, onCollapsedData(BufferStringEqual("def"), false));
+  }
+  response_->addRequest(request2);
+
+  EXPECT_CALL(request1, onCollapsedData(BufferStringEqual("g"), true));
+  EXPECT_CALL(request2, onCollapsedData(BufferStringEqual("g"), true));
+  Buffer::OwnedImpl data3("g");
+  response_->encodeData(data3, true);
+}
+
+// Once the body no longer fits in the buffer, requests are no longer collapsed into the response,
+// but the ones already collapsed get the whole of it.
+TEST_F(CollapsedForwardingTest, BodyOverflow) {
+  MockCollapsedRequestCallbacks request;
+  response_->addRequest(request);
+  EXPECT_CALL(request, onCollapsedHeaders(_, false));
+  response_->encodeHeaders(response_headers_, false);
+
+  EXPECT_CALL(request, onCollapsedData(BufferStringEqual("12345"), false));
+  Buffer::OwnedImpl data1("12345");
+  response_->encodeData(data1, false);
+  EXPECT_TRUE(response_->joinable());
+
+  EXPECT_CALL(request, onCollapsedData(BufferStringEqual("6789"), false));
+  Buffer::OwnedImpl data2("6789");
+  response_->encodeData(data2, false);
+  EXPECT_FALSE(response_->joinable());
+  EXPECT_EQ(nullptr, registry_.find("key"));
+
+  // A new response can be registered with the same key.
+  CollapsedResponseSharedPtr next = registry_.add("key", 8);
+  EXPECT_EQ(next, registry_.find("key"));
+
+  EXPECT_CALL(request, onCollapsedData(BufferStringEqual(""), true));
+  Buffer::OwnedImpl empty;
+  response_->encodeData(empty, true);
+  EXPECT_EQ(next, registry_.find("key"));
+}
+
+TEST_F(CollapsedForwardingTest, RemoveRequest) {
+  MockCollapsedRequestCallbacks request1;
+  MockCollapsedRequestCallbacks request2;
+  response_->addRequest(request1);
+  response_->addRequest(request2);
+  response_->removeRequest(request1);
+
+  EXPECT_CALL(request1, onCollapsedHeaders(_, _)).Times(0);
+  EXPECT_CALL(request2, onCollapsedHeaders(_, true));
+  response_->encodeHeaders(response_headers_, true);
+}
+
+// A request may go away while it is sent the response.
+TEST_F(CollapsedForwardingTest, RemoveRequestWhileCalled) {
+  MockCollapsedRequestCallbacks request1;
+  MockCollapsedRequestCallbacks request2;
+  response_->addRequest(request1);
+  response_->addRequest(request2);
+
+  EXPECT_CALL(request1, onCollapsedHeaders(_, false))
+      .WillOnce(Invoke([this, &request1](const Http::HeaderMap&, bool) {
+        response_->removeRequest(request1);
+      }));
+  EXPECT_CALL(request2, onCollapsedHeaders(_, false));
+  response_->encodeHeaders(response_headers_, false);
+
+  EXPECT_CALL(request2, onCollapsedData(_, true));
+  Buffer::OwnedImpl data("a");
+  response_->encodeData(data, true);
+}
+
+TEST_F(CollapsedForwardingTest, Abort) {
+  MockCollapsedRequestCallbacks request;
+  response_->addRequest(request);
+
+  // The request may register a new response with the same key when it is told.
+  EXPECT_CALL(request, onCollapsedAbort(false)).WillOnce(Invoke([this](bool) {
+    EXPECT_EQ(nullptr, registry_.find("key"));
+    registry_.add("key", 8);
+  }));
+  response_->abort();
+  EXPECT_NE(nullptr, registry_.find("key"));
+  EXPECT_NE(response_, registry_.find("key"));
+}
+
+TEST_F(CollapsedForwardingTest, AbortAfterHeaders) {
+  MockCollapsedRequestCallbacks request;
+  response_->addRequest(request);
+  EXPECT_CALL(request, onCollapsedHeaders(_, false));
+  response_->encodeHeaders(response_headers_, false);
+
+  EXPECT_CALL(request, onCollapsedAbort(true));
+  response_->abort();
+}
+
+// A response which sets a cookie or is private is not passed on, and the requests collapsed into it
+// are told to go upstream themselves.
+TEST_F(CollapsedForwardingTest, Unshareable) {
+  const std::vector<Http::TestHeaderMapImpl> unshareable_headers{
+      {{":status", "200"}, {"set-cookie", "a=b"}},
+      {{":status", "200"}, {"cache-control", "Private=\"x-user\""}},
+      {{":status", "200"}, {"cache-control", "max-age=60, no-store"}}};
+  for (const auto& headers : unshareable_headers) {
+    CollapsedResponseSharedPtr response = registry_.add("unshareable", 8);
+    MockCollapsedRequestCallbacks request;
+    response->addRequest(request);
+
+    EXPECT_CALL(request, onCollapsedHeaders(_, _)).Times(0);
+    EXPECT_CALL(request, onCollapsedUnshareable());
+    response->encodeHeaders(headers, false);
+    EXPECT_EQ(nullptr, registry_.find("unshareable"));
+
+    EXPECT_CALL(request, onCollapsedData(_, _)).Times(0);
+    Buffer::OwnedImpl data("a");
+    response->encodeData(data, true);
+  }
+}
+
+TEST_F(CollapsedForwardingTest, Shareable) {
+  MockCollapsedRequestCallbacks request;
+  response_->addRequest(request);
+  Http::TestHeaderMapImpl headers{{":status", "200"}, {"cache-control", "public, max-age=60"}};
+  EXPECT_CALL(request, onCollapsedHeaders(_, true));
+  response_->encodeHeaders(headers, true);
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
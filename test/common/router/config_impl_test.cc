@@ -3226,6 +3226,53 @@ virtual_hosts:
   EXPECT_EQ(0, percent.numerator());
 }
 
+TEST_F(RouteMatcherTest, CollapsedForwarding) {
+  const std::string yaml = R"EOF(
+name: CollapsedForwarding
+virtual_hosts:
+- domains: [www.lyft.com]
+  name: www
+  routes:
+  - match: {prefix: /foo}
+    route:
+      cluster: www
+      collapsed_forwarding_policy:
+        key_headers: [Accept-Encoding, authorization]
+        max_buffered_bytes: 4096
+  - match: {prefix: /bar}
+    route:
+      cluster: www
+      collapsed_forwarding_policy: {}
+  - match: {prefix: /}
+    route: {cluster: www}
+  )EOF";
+
+  TestConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context_, true);
+
+  const CollapsedForwardingPolicy& foo_policy =
+      config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)
+          ->routeEntry()
+          ->collapsedForwardingPolicy();
+  EXPECT_TRUE(foo_policy.enabled());
+  ASSERT_EQ(2, foo_policy.keyHeaders().size());
+  EXPECT_EQ("accept-encoding", foo_policy.keyHeaders()[0].get());
+  EXPECT_EQ("authorization", foo_policy.keyHeaders()[1].get());
+  EXPECT_EQ(4096, foo_policy.maxBufferedBytes());
+
+  const CollapsedForwardingPolicy& bar_policy =
+      config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)
+          ->routeEntry()
+          ->collapsedForwardingPolicy();
+  EXPECT_TRUE(bar_policy.enabled());
+  EXPECT_TRUE(bar_policy.keyHeaders().empty());
+  EXPECT_EQ(1024 * 1024, bar_policy.maxBufferedBytes());
+
+  EXPECT_FALSE(config.route(genHeaders("www.lyft.com", "/", "GET"), 0)
+                   ->routeEntry()
+                   ->collapsedForwardingPolicy()
+                   .enabled());
+}
+
 TEST_F(RouteMatcherTest, TestBadDefaultConfig) {
   const std::string yaml = R"EOF(
 virtual_hosts:
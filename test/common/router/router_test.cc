@@ -17,12 +17,14 @@
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/router/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/ssl/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/environment.h"
@@ -104,6 +106,13 @@ public:
     EXPECT_CALL(callbacks_.dispatcher_, setTrackedObject(_)).Times(AnyNumber());
   }
 
+  void enableCollapsedForwarding() {
+    auto collapsed_forwarding = std::make_shared<CollapsedForwardingSlot>();
+    collapsed_forwarding->enable(tls_);
+    config_.setCollapsedForwarding(collapsed_forwarding);
+    callbacks_.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  }
+
   void expectResponseTimerCreate() {
     response_timeout_ = new Event::MockTimer(&callbacks_.dispatcher_);
     EXPECT_CALL(*response_timeout_, enableTimer(_, _));
@@ -245,6 +254,7 @@ public:
   NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks_;
   MockShadowWriter* shadow_writer_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   FilterConfig config_;
   TestFilter router_;
   Event::MockTimer* response_timeout_{};
@@ -1073,6 +1083,294 @@ TEST_F(RouterTest, ResetDuringEncodeHeaders) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
 }
 
+// Identical requests in flight on a worker are collapsed into a single upstream request, whose
+// response is sent to all of them.
+TEST_F(RouterTest, CollapsedForwarding) {
+  enableCollapsedForwarding();
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower.decodeHeaders(follower_headers, true));
+  EXPECT_EQ(1U, stats_store_.counter("test.rq_collapsed").value());
+
+  // A request for another path is sent upstream.
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> other_callbacks;
+  other_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  TestFilter other(config_);
+  other.setDecoderFilterCallbacks(other_callbacks);
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  Http::TestHeaderMapImpl other_headers;
+  HttpTestUtility::addDefaultHeaders(other_headers);
+  other_headers.insertPath().value(std::string("/other"));
+  other.decodeHeaders(other_headers, true);
+  EXPECT_EQ(1U, stats_store_.counter("test.rq_collapsed").value());
+  EXPECT_CALL(cancellable_, cancel());
+  other.onDestroy();
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(follower_callbacks, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_EQ("200", headers.Status()->value().getStringView());
+      }));
+  response_decoder->decodeHeaders(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}, false);
+
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("hello"), true));
+  EXPECT_CALL(follower_callbacks, encodeData(BufferStringEqual("hello"), true));
+  Buffer::OwnedImpl data("hello");
+  response_decoder->decodeData(data, true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+  follower.onDestroy();
+}
+
+// When the request which was sent upstream fails before its response started, the requests
+// collapsed into it are sent upstream themselves.
+TEST_F(RouterTest, CollapsedForwardingUpstreamReset) {
+  enableCollapsedForwarding();
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower.decodeHeaders(follower_headers, true);
+
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  EXPECT_CALL(follower_callbacks, encodeHeaders_(_, _)).Times(0);
+  encoder.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+  EXPECT_EQ(1U, stats_store_.counter("test.rq_collapsed_aborted").value());
+
+  EXPECT_CALL(cancellable_, cancel());
+  follower.onDestroy();
+}
+
+// A request which is sent upstream itself once the request it was collapsed into failed keeps the
+// response timeout it was collapsed with.
+TEST_F(RouterTest, CollapsedForwardingUpstreamResetKeepsTimeout) {
+  enableCollapsedForwarding();
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Event::MockTimer* follower_timeout = new Event::MockTimer(&follower_callbacks.dispatcher_);
+  EXPECT_CALL(*follower_timeout, enableTimer(_, _));
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower.decodeHeaders(follower_headers, true);
+
+  EXPECT_CALL(follower_callbacks.dispatcher_, createTimer_(_)).Times(0);
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  encoder.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+
+  EXPECT_CALL(cancellable_, cancel());
+  EXPECT_CALL(follower_callbacks, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_EQ("504", headers.Status()->value().getStringView());
+      }));
+  follower_timeout->invokeCallback();
+  follower.onDestroy();
+}
+
+// Requests are only collapsed when the headers their route adds are the same.
+TEST_F(RouterTest, CollapsedForwardingRouteHeaders) {
+  enableCollapsedForwarding();
+  auto add_client = [](const std::string& client) {
+    return [client](Http::HeaderMap& headers, const StreamInfo::StreamInfo&, bool) -> void {
+      headers.addCopy(Http::LowerCaseString("x-client"), client);
+    };
+  };
+
+  EXPECT_CALL(callbacks_.route_->route_entry_, finalizeRequestHeaders(_, _, _))
+      .WillOnce(Invoke(add_client("a")));
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  expectResponseTimerCreate();
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> other_callbacks;
+  other_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  EXPECT_CALL(other_callbacks.route_->route_entry_, finalizeRequestHeaders(_, _, _))
+      .WillOnce(Invoke(add_client("b")));
+  TestFilter other(config_);
+  other.setDecoderFilterCallbacks(other_callbacks);
+  Http::ConnectionPool::MockCancellable other_cancellable;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&other_cancellable));
+  Http::TestHeaderMapImpl other_headers;
+  HttpTestUtility::addDefaultHeaders(other_headers);
+  other.decodeHeaders(other_headers, true);
+  EXPECT_EQ(0U, stats_store_.counter("test.rq_collapsed").value());
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  EXPECT_CALL(follower_callbacks.route_->route_entry_, finalizeRequestHeaders(_, _, _))
+      .WillOnce(Invoke(add_client("a")));
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Http::TestHeaderMapImpl follower_headers;
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower.decodeHeaders(follower_headers, true);
+  EXPECT_EQ(1U, stats_store_.counter("test.rq_collapsed").value());
+
+  follower.onDestroy();
+  EXPECT_CALL(other_cancellable, cancel());
+  other.onDestroy();
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
+// A request with a cookie is only collapsed when the cookie is part of the key.
+TEST_F(RouterTest, CollapsedForwardingCookie) {
+  enableCollapsedForwarding();
+
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  expectResponseTimerCreate();
+  Http::TestHeaderMapImpl headers{{"cookie", "a=b"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Http::ConnectionPool::MockCancellable follower_cancellable;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&follower_cancellable));
+  Http::TestHeaderMapImpl follower_headers{{"cookie", "a=b"}};
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower.decodeHeaders(follower_headers, true);
+  EXPECT_EQ(0U, stats_store_.counter("test.rq_collapsed").value());
+
+  EXPECT_CALL(follower_cancellable, cancel());
+  follower.onDestroy();
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
+TEST_F(RouterTest, CollapsedForwardingCookieKeyHeader) {
+  enableCollapsedForwarding();
+  callbacks_.route_->route_entry_.collapsed_forwarding_policy_.key_headers_.emplace_back("cookie");
+
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  expectResponseTimerCreate();
+  Http::TestHeaderMapImpl headers{{"cookie", "a=b"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+  follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.key_headers_.emplace_back(
+      "cookie");
+  TestFilter follower(config_);
+  follower.setDecoderFilterCallbacks(follower_callbacks);
+  Http::TestHeaderMapImpl follower_headers{{"cookie", "a=b"}};
+  HttpTestUtility::addDefaultHeaders(follower_headers);
+  follower.decodeHeaders(follower_headers, true);
+  EXPECT_EQ(1U, stats_store_.counter("test.rq_collapsed").value());
+
+  follower.onDestroy();
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
+// A response which sets a cookie or is private is not sent to the requests collapsed into it,
+// which are sent upstream themselves.
+TEST_F(RouterTest, CollapsedForwardingUnshareableResponse) {
+  enableCollapsedForwarding();
+  const std::vector<std::pair<std::string, std::string>> unshareable_headers{
+      {"set-cookie", "a=b"}, {"cache-control", "max-age=10, private"}, {"cache-control", "no-store"}};
+  for (const auto& unshareable_header : unshareable_headers) {
+    NiceMock<Http::MockStreamDecoderFilterCallbacks> leader_callbacks;
+    leader_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+    TestFilter leader(config_);
+    leader.setDecoderFilterCallbacks(leader_callbacks);
+
+    NiceMock<Http::MockStreamEncoder> encoder;
+    Http::StreamDecoder* response_decoder = nullptr;
+    EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+        .WillOnce(
+            Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                       -> Http::ConnectionPool::Cancellable* {
+              response_decoder = &decoder;
+              callbacks.onPoolReady(encoder, cm_.conn_pool_.host_, upstream_stream_info_);
+              return nullptr;
+            }));
+    Http::TestHeaderMapImpl headers;
+    HttpTestUtility::addDefaultHeaders(headers);
+    leader.decodeHeaders(headers, true);
+
+    NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_callbacks;
+    follower_callbacks.route_->route_entry_.collapsed_forwarding_policy_.enabled_ = true;
+    TestFilter follower(config_);
+    follower.setDecoderFilterCallbacks(follower_callbacks);
+    Http::TestHeaderMapImpl follower_headers;
+    HttpTestUtility::addDefaultHeaders(follower_headers);
+    follower.decodeHeaders(follower_headers, true);
+
+    Http::ConnectionPool::MockCancellable follower_cancellable;
+    EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&follower_cancellable));
+    EXPECT_CALL(follower_callbacks, encodeHeaders_(_, _)).Times(0);
+    EXPECT_CALL(leader_callbacks, encodeHeaders_(_, true));
+    response_decoder->decodeHeaders(
+        Http::HeaderMapPtr{new Http::TestHeaderMapImpl{
+            {":status", "200"}, {unshareable_header.first, unshareable_header.second}}},
+        true);
+
+    EXPECT_CALL(follower_cancellable, cancel());
+    follower.onDestroy();
+    leader.onDestroy();
+  }
+  EXPECT_EQ(3U, stats_store_.counter("test.rq_collapsed").value());
+  EXPECT_EQ(3U, stats_store_.counter("test.rq_collapsed_aborted").value());
+}
+
 TEST_F(RouterTest, UpstreamTimeout) {
   NiceMock<Http::MockStreamEncoder> encoder;
   Http::StreamDecoder* response_decoder = nullptr;
@@ -22,6 +22,7 @@
 
 #include "extensions/transport_sockets/tls/context_manager_impl.h"
 
+#include "test/common/http/common.h"
 #include "test/common/upstream/utility.h"
 #include "test/integration/clusters/custom_static_cluster.h"
 #include "test/mocks/access_log/mocks.h"
@@ -160,7 +161,11 @@ public:
 // clusters, which is necessary in order to call updateHosts on the priority set.
 class TestClusterManagerImpl : public ClusterManagerImpl {
 public:
+  using ClusterManagerImpl::addSharedConnPoolOwner;
   using ClusterManagerImpl::ClusterManagerImpl;
+  using ClusterManagerImpl::enableSharedConnPoolOwners;
+  using ClusterManagerImpl::removeSharedConnPoolOwner;
+  using ClusterManagerImpl::sharedConnPoolOwner;
 
   TestClusterManagerImpl(const envoy::config::bootstrap::v2::Bootstrap& bootstrap,
                          ClusterManagerFactory& factory, Stats::Store& stats,
@@ -2828,6 +2833,121 @@ TEST_F(ClusterManagerImplTest, UpstreamSocketOptionsNullIsOkay) {
   EXPECT_NE(nullptr, cp);
 }
 
+// Verify that connection pools are warmed for hosts added to a cluster with a prefetch policy.
+TEST_F(ClusterManagerImplTest, PrefetchOnHostAdd) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      prefetch_policy:
+        prefetch_on_host_add: true
+      hosts:
+      - socket_address:
+          address: "127.0.0.1"
+          port_value: 11001
+  )EOF";
+
+  Http::ConnectionPool::MockInstance* to_create = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_, _, _)).WillOnce(Return(to_create));
+  EXPECT_CALL(*to_create, prefetchConnections());
+  create(parseBootstrapFromV2Yaml(yaml));
+
+  // Requests use the pool that was warmed.
+  EXPECT_EQ(to_create,
+            cluster_manager_->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                     Http::Protocol::Http11, nullptr));
+}
+
+const std::string SharedHttp2ClusterYaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      http2_protocol_options: {}
+      share_http2_connections_across_workers: true
+      hosts:
+      - socket_address:
+          address: "127.0.0.1"
+          port_value: 11002
+  )EOF";
+
+// Shared connection pool owners are only selected once every worker has created its thread local
+// cluster manager.
+TEST_F(ClusterManagerImplTest, SharedConnPoolOwnerSelectedOnceWorkersRegistered) {
+  std::vector<Event::PostCb> all_threads_complete_cbs;
+  ON_CALL(factory_.tls_, runOnAllThreads(_, _))
+      .WillByDefault(Invoke([&](Event::PostCb cb, Event::PostCb all_threads_complete_cb) -> void {
+        cb();
+        all_threads_complete_cbs.push_back(all_threads_complete_cb);
+      }));
+  create(parseBootstrapFromV2Yaml(SharedHttp2ClusterYaml));
+
+  const HostSharedPtr host =
+      cluster_manager_->get("cluster_1")->prioritySet().hostSetsPerPriority()[0]->hosts()[0];
+  EXPECT_EQ(nullptr, cluster_manager_->sharedConnPoolOwner(*host));
+
+  for (auto& cb : all_threads_complete_cbs) {
+    cb();
+  }
+  Http::SharedConnPoolOwnerSharedPtr owner = cluster_manager_->sharedConnPoolOwner(*host);
+  ASSERT_NE(nullptr, owner);
+  EXPECT_EQ(&factory_.tls_.dispatcher_, &owner->dispatcher());
+
+  // A worker registering late stops owner selection until all workers agree again.
+  NiceMock<Event::MockDispatcher> late_dispatcher;
+  cluster_manager_->addSharedConnPoolOwner(late_dispatcher);
+  EXPECT_EQ(nullptr, cluster_manager_->sharedConnPoolOwner(*host));
+  cluster_manager_->removeSharedConnPoolOwner(late_dispatcher);
+}
+
+// Once the owner of a host goes away, the pools handed to it by other workers stop posting to it.
+TEST_F(ClusterManagerImplTest, SharedConnPoolOwnerRemoved) {
+  create(parseBootstrapFromV2Yaml(SharedHttp2ClusterYaml));
+
+  // With the thread local cluster manager's worker and this one, 127.0.0.1:11002 hashes to this
+  // one.
+  NiceMock<Event::MockDispatcher> owner_dispatcher;
+  std::vector<Event::PostCb> owner_posts;
+  ON_CALL(owner_dispatcher, post(_))
+      .WillByDefault(Invoke([&](Event::PostCb cb) -> void { owner_posts.push_back(cb); }));
+  cluster_manager_->addSharedConnPoolOwner(owner_dispatcher);
+  cluster_manager_->enableSharedConnPoolOwners();
+
+  const HostSharedPtr host =
+      cluster_manager_->get("cluster_1")->prioritySet().hostSetsPerPriority()[0]->hosts()[0];
+  Http::SharedConnPoolOwnerSharedPtr owner = cluster_manager_->sharedConnPoolOwner(*host);
+  ASSERT_NE(nullptr, owner);
+  EXPECT_EQ(&owner_dispatcher, &owner->dispatcher());
+
+  // The local worker hands its streams to the owner rather than allocating its own pool.
+  EXPECT_CALL(factory_, allocateConnPool_(_, _, _)).Times(0);
+  Http::ConnectionPool::Instance* cp = cluster_manager_->httpConnPoolForCluster(
+      "cluster_1", ResourcePriority::Default, Http::Protocol::Http2, nullptr);
+  ASSERT_NE(nullptr, cp);
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::ConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, cp->newStream(decoder, callbacks));
+  EXPECT_EQ(1, owner_posts.size());
+
+  cluster_manager_->removeSharedConnPoolOwner(owner_dispatcher);
+  EXPECT_EQ(nullptr, cluster_manager_->sharedConnPoolOwner(*host));
+  EXPECT_FALSE(owner->post([]() -> void {}));
+
+  // New streams on the existing pool fail, and tearing it down with an active stream does not post
+  // to the removed owner.
+  EXPECT_CALL(owner_dispatcher, post(_)).Times(0);
+  NiceMock<Http::MockStreamDecoder> decoder2;
+  Http::ConnPoolCallbacks callbacks2;
+  EXPECT_CALL(callbacks2.pool_failure_, ready());
+  EXPECT_EQ(nullptr, cp->newStream(decoder2, callbacks2));
+  cluster_manager_.reset();
+}
+
 class TestUpstreamNetworkFilter : public Network::WriteFilter {
 public:
   Network::FilterStatus onWrite(Buffer::Instance&, bool) override {
@@ -1930,6 +1930,38 @@ TEST_F(ClusterInfoImplTest, Metadata) {
   EXPECT_EQ(LoadBalancerType::Maglev, cluster->info()->lbType());
 }
 
+// Prefetch settings and stats are only present with a prefetch policy.
+TEST_F(ClusterInfoImplTest, PrefetchPolicy) {
+  const std::string default_yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+  )EOF";
+  auto cluster = makeCluster(default_yaml);
+  EXPECT_EQ(1.0, cluster->info()->prefetchRatio());
+  EXPECT_FALSE(cluster->info()->prefetchOnHostAdd());
+  EXPECT_EQ(nullptr, cluster->info()->prefetchStats());
+
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    prefetch_policy:
+      prefetch_ratio: 1.5
+      prefetch_on_host_add: true
+  )EOF";
+  cluster = makeCluster(yaml);
+  EXPECT_EQ(1.5, cluster->info()->prefetchRatio());
+  EXPECT_TRUE(cluster->info()->prefetchOnHostAdd());
+  ASSERT_NE(nullptr, cluster->info()->prefetchStats());
+  cluster->info()->prefetchStats()->upstream_cx_prefetch_total_.inc();
+  EXPECT_EQ(1U, stats_.counter("cluster.name.upstream_cx_prefetch_total").value());
+}
+
 // Eds service_name is populated.
 TEST_F(ClusterInfoImplTest, EdsServiceNamePopulation) {
   const std::string yaml = R"EOF(
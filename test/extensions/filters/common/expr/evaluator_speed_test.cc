@@ -0,0 +1,128 @@
+#include <memory>
+#include <string>
+
+#include "extensions/filters/common/expr/evaluator.h"
+
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace Expr {
+
+// request.headers['x-tenant'] == 'a' && request.method == 'GET' &&
+//     (request.headers['x-tenant'] != 'b' || request.path == '/')
+static const std::string ConditionYaml = R"EOF(
+call_expr:
+  function: _&&_
+  args:
+  - call_expr:
+      function: _&&_
+      args:
+      - call_expr:
+          function: _==_
+          args:
+          - call_expr:
+              function: _[_]
+              args:
+              - select_expr:
+                  operand:
+                    ident_expr:
+                      name: request
+                  field: headers
+              - const_expr:
+                  string_value: x-tenant
+          - const_expr:
+              string_value: a
+      - call_expr:
+          function: _==_
+          args:
+          - select_expr:
+              operand:
+                ident_expr:
+                  name: request
+              field: method
+          - const_expr:
+              string_value: GET
+  - call_expr:
+      function: _||_
+      args:
+      - call_expr:
+          function: _!=_
+          args:
+          - call_expr:
+              function: _[_]
+              args:
+              - select_expr:
+                  operand:
+                    ident_expr:
+                      name: request
+                  field: headers
+              - const_expr:
+                  string_value: x-tenant
+          - const_expr:
+              string_value: b
+      - call_expr:
+          function: _==_
+          args:
+          - select_expr:
+              operand:
+                ident_expr:
+                  name: request
+              field: path
+          - const_expr:
+              string_value: /
+)EOF";
+
+// Evaluates the condition against a request with a typical number of headers. The Arg of the
+// BENCHMARK(...) macro call below is whether the expression is compiled.
+static void EvaluatorMatches(benchmark::State& state) {
+  Protobuf::Arena constant_arena;
+  BuilderPtr builder = createBuilder(&constant_arena);
+  const auto condition = TestUtility::parseYaml<google::api::expr::v1alpha1::Expr>(ConditionYaml);
+  ExpressionPtr expression = createExpression(*builder, condition);
+  CompiledExpression compiled(*builder, condition);
+
+  Http::TestHeaderMapImpl headers{{":method", "GET"},
+                                  {":path", "/"},
+                                  {":authority", "example.com"},
+                                  {"user-agent", "curl/7.64.1"},
+                                  {"accept", "*/*"},
+                                  {"x-forwarded-proto", "https"},
+                                  {"x-request-id", "3e2f7b30-8f6e-4b1d-a8a3-6d2a7e4b3c1f"},
+                                  {"x-tenant", "a"}};
+  NiceMock<StreamInfo::MockStreamInfo> info;
+
+  if (state.range(0) != 0) {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(compiled.matches(info, headers));
+    }
+  } else {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(matches(*expression, info, headers));
+    }
+  }
+}
+BENCHMARK(EvaluatorMatches)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace Expr
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,254 @@
+#include "extensions/filters/common/expr/evaluator.h"
+
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace Expr {
+namespace {
+
+class CompiledExpressionTest : public testing::Test {
+public:
+  CompiledExpressionTest() : builder_(createBuilder(nullptr)) {}
+
+  CompiledExpressionPtr compile(const std::string& yaml) {
+    expr_ = TestUtility::parseYaml<google::api::expr::v1alpha1::Expr>(yaml);
+    expression_ = createExpression(*builder_, expr_);
+    return std::make_unique<CompiledExpression>(*builder_, expr_);
+  }
+
+  // Checks that the compiled expression matches exactly when the original one does.
+  bool matches(const CompiledExpression& compiled) {
+    const bool result = compiled.matches(info_, headers_);
+    EXPECT_EQ(Expr::matches(*expression_, info_, headers_), result);
+    return result;
+  }
+
+  BuilderPtr builder_;
+  google::api::expr::v1alpha1::Expr expr_;
+  ExpressionPtr expression_;
+  NiceMock<StreamInfo::MockStreamInfo> info_;
+  Http::TestHeaderMapImpl headers_;
+};
+
+TEST_F(CompiledExpressionTest, RequestHeader) {
+  auto compiled = compile(R"EOF(
+    call_expr:
+      function: _==_
+      args:
+      - call_expr:
+          function: _[_]
+          args:
+          - select_expr:
+              operand:
+                ident_expr:
+                  name: request
+              field: headers
+          - const_expr:
+              string_value: X-Foo
+      - const_expr:
+          string_value: bar
+  )EOF");
+
+  ASSERT_EQ(1, compiled->attributes().size());
+  EXPECT_EQ(CompiledAttribute::Kind::Header, compiled->attributes()[0].kind_);
+  EXPECT_EQ(Root::Request, compiled->attributes()[0].root_);
+  EXPECT_EQ("x-foo", compiled->attributes()[0].header_.get());
+
+  EXPECT_FALSE(matches(*compiled));
+  headers_.addCopy("x-foo", "baz");
+  EXPECT_FALSE(matches(*compiled));
+  headers_.setCopy(Http::LowerCaseString("x-foo"), "bar");
+  EXPECT_TRUE(matches(*compiled));
+}
+
+TEST_F(CompiledExpressionTest, SharedAttributes) {
+  // request.headers.x-foo == 'bar' || request.headers['x-foo'] == request.path
+  auto compiled = compile(R"EOF(
+    call_expr:
+      function: _||_
+      args:
+      - call_expr:
+          function: _==_
+          args:
+          - select_expr:
+              operand:
+                select_expr:
+                  operand:
+                    ident_expr:
+                      name: request
+                  field: headers
+              field: x-foo
+          - const_expr:
+              string_value: bar
+      - call_expr:
+          function: _==_
+          args:
+          - call_expr:
+              function: _[_]
+              args:
+              - select_expr:
+                  operand:
+                    ident_expr:
+                      name: request
+                  field: headers
+              - const_expr:
+                  string_value: x-foo
+          - select_expr:
+              operand:
+                ident_expr:
+                  name: request
+              field: path
+  )EOF");
+
+  ASSERT_EQ(2, compiled->attributes().size());
+  EXPECT_EQ(CompiledAttribute::Kind::Header, compiled->attributes()[0].kind_);
+  EXPECT_EQ(CompiledAttribute::Kind::Property, compiled->attributes()[1].kind_);
+  EXPECT_EQ("path", compiled->attributes()[1].field_);
+
+  headers_.addCopy(":path", "/foo");
+  EXPECT_FALSE(matches(*compiled));
+  headers_.addCopy("x-foo", "/foo");
+  EXPECT_TRUE(matches(*compiled));
+}
+
+TEST_F(CompiledExpressionTest, ConnectionProperty) {
+  auto compiled = compile(R"EOF(
+    call_expr:
+      function: _==_
+      args:
+      - select_expr:
+          operand:
+            ident_expr:
+              name: connection
+          field: requested_server_name
+      - const_expr:
+          string_value: example.com
+  )EOF");
+
+  ASSERT_EQ(1, compiled->attributes().size());
+  EXPECT_EQ(Root::Connection, compiled->attributes()[0].root_);
+
+  const std::string server_name = "example.com";
+  EXPECT_CALL(info_, requestedServerName()).WillRepeatedly(ReturnRef(server_name));
+  EXPECT_TRUE(matches(*compiled));
+}
+
+TEST_F(CompiledExpressionTest, MissingProperty) {
+  auto compiled = compile(R"EOF(
+    call_expr:
+      function: _[_]
+      args:
+      - select_expr:
+          operand:
+            ident_expr:
+              name: request
+          field: undefined
+      - const_expr:
+          string_value: foo
+  )EOF");
+
+  ASSERT_EQ(1, compiled->attributes().size());
+  EXPECT_FALSE(matches(*compiled));
+}
+
+TEST_F(CompiledExpressionTest, TestOnlySelectIsNotCompiled) {
+  // has(request.headers.x-foo)
+  auto compiled = compile(R"EOF(
+    select_expr:
+      operand:
+        select_expr:
+          operand:
+            ident_expr:
+              name: request
+          field: headers
+      field: x-foo
+      test_only: true
+  )EOF");
+
+  EXPECT_EQ(0, compiled->attributes().size());
+}
+
+TEST_F(CompiledExpressionTest, ShadowedRootIsNotCompiled) {
+  // [1].exists(request, request.path == 1)
+  auto compiled = compile(R"EOF(
+    comprehension_expr:
+      iter_var: request
+      iter_range:
+        list_expr:
+          elements:
+          - const_expr:
+              int64_value: 1
+      accu_var: __result__
+      accu_init:
+        const_expr:
+          bool_value: false
+      loop_condition:
+        const_expr:
+          bool_value: true
+      loop_step:
+        select_expr:
+          operand:
+            ident_expr:
+              name: request
+          field: path
+      result:
+        ident_expr:
+          name: __result__
+  )EOF");
+
+  EXPECT_EQ(0, compiled->attributes().size());
+}
+
+TEST_F(CompiledExpressionTest, MetadataIsNotCompiled) {
+  auto compiled = compile(R"EOF(
+    select_expr:
+      operand:
+        ident_expr:
+          name: metadata
+      field: filter_metadata
+  )EOF");
+
+  EXPECT_EQ(0, compiled->attributes().size());
+}
+
+TEST_F(CompiledExpressionTest, ResponseTrailer) {
+  auto compiled = compile(R"EOF(
+    call_expr:
+      function: _[_]
+      args:
+      - select_expr:
+          operand:
+            ident_expr:
+              name: response
+          field: trailers
+      - const_expr:
+          string_value: grpc-status
+  )EOF");
+
+  ASSERT_EQ(1, compiled->attributes().size());
+  EXPECT_EQ(CompiledAttribute::Kind::Trailer, compiled->attributes()[0].kind_);
+
+  Protobuf::Arena arena;
+  Http::TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  auto value = compiled->evaluate(&arena, info_, &headers_, nullptr, &trailers);
+  ASSERT_TRUE(value.has_value());
+  ASSERT_TRUE(value.value().IsString());
+  EXPECT_EQ("0", value.value().StringOrDie().value());
+}
+
+} // namespace
+} // namespace Expr
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
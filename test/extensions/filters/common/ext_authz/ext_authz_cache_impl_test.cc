@@ -0,0 +1,307 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/stats/isolated_store_impl.h"
+#include "common/tracing/http_tracer_impl.h"
+
+#include "extensions/filters/common/ext_authz/ext_authz_cache_impl.h"
+
+#include "test/extensions/filters/common/ext_authz/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace ExtAuthz {
+namespace {
+
+envoy::service::auth::v2::CheckRequest checkRequest(const std::string& path,
+                                                    const std::string& user) {
+  envoy::service::auth::v2::CheckRequest request;
+  auto* http = request.mutable_attributes()->mutable_request()->mutable_http();
+  http->set_method("GET");
+  http->set_host("example.com");
+  http->set_path(path);
+  (*http->mutable_headers())["x-user"] = user;
+  (*http->mutable_headers())["x-request-id"] = path + user;
+  return request;
+}
+
+ResponsePtr response(CheckStatus status) {
+  auto response = std::make_unique<Response>();
+  response->status = status;
+  response->headers_to_add.emplace_back(Http::LowerCaseString{"x-principal"}, "alice");
+  return response;
+}
+
+class DecisionCacheTest : public testing::Test {
+public:
+  void setUpTest(const std::string& yaml) {
+    envoy::config::filter::http::ext_authz::v2::DecisionCache proto_config;
+    TestUtility::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<DecisionCacheConfig>(proto_config, tls_, time_system_, "test.",
+                                                    stats_store_);
+  }
+
+  // A caching client with a mock client, which saves the callbacks it is called with.
+  struct TestClient {
+    TestClient(DecisionCacheConfigSharedPtr config)
+        : inner_(new NiceMock<MockClient>()), client_(ClientPtr{inner_}, config) {
+      ON_CALL(*inner_, check(_, _, _))
+          .WillByDefault(Invoke(
+              [this](RequestCallbacks& callbacks, const envoy::service::auth::v2::CheckRequest&,
+                     Tracing::Span&) { inner_callbacks_ = &callbacks; }));
+    }
+
+    NiceMock<MockClient>* inner_;
+    CachingClientImpl client_;
+    RequestCallbacks* inner_callbacks_{};
+    NiceMock<MockRequestCallbacks> callbacks_;
+  };
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("test.ext_authz.cache." + name).value();
+  }
+
+  const std::string config_yaml_ = R"EOF(
+  key_headers: [X-User]
+  ttl: 10s
+  )EOF";
+
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl stats_store_;
+  DecisionCacheConfigSharedPtr config_;
+};
+
+TEST_F(DecisionCacheTest, Key) {
+  setUpTest(config_yaml_);
+  EXPECT_NE(config_->key(checkRequest("/a?x=1", "alice")),
+            config_->key(checkRequest("/a", "alice")));
+  EXPECT_NE(config_->key(checkRequest("/a", "alice")), config_->key(checkRequest("/a", "bob")));
+  EXPECT_NE(config_->key(checkRequest("/a", "alice")), config_->key(checkRequest("/b", "alice")));
+
+  envoy::service::auth::v2::CheckRequest request = checkRequest("/a", "alice");
+  (*request.mutable_attributes()->mutable_context_extensions())["route"] = "r1";
+  EXPECT_NE(config_->key(checkRequest("/a", "alice")), config_->key(request));
+}
+
+TEST_F(DecisionCacheTest, KeyStripQuery) {
+  setUpTest(R"EOF(
+  ttl: 10s
+  strip_query: true
+  )EOF");
+  EXPECT_EQ(config_->key(checkRequest("/a?x=1", "")), config_->key(checkRequest("/a", "")));
+  EXPECT_NE(config_->key(checkRequest("/a?x=1", "")), config_->key(checkRequest("/b?x=1", "")));
+}
+
+// Checks of different peers never share a decision.
+TEST_F(DecisionCacheTest, KeyPrincipal) {
+  setUpTest(config_yaml_);
+  envoy::service::auth::v2::CheckRequest alice = checkRequest("/a", "");
+  alice.mutable_attributes()->mutable_source()->set_principal("spiffe://example.com/alice");
+  envoy::service::auth::v2::CheckRequest bob = checkRequest("/a", "");
+  bob.mutable_attributes()->mutable_source()->set_principal("spiffe://example.com/bob");
+  EXPECT_NE(config_->key(alice), config_->key(bob));
+
+  TestClient alice_client(config_);
+  alice_client.client_.check(alice_client.callbacks_, alice, Tracing::NullSpan::instance());
+  EXPECT_CALL(alice_client.callbacks_, onComplete_(_));
+  alice_client.inner_callbacks_->onComplete(response(CheckStatus::OK));
+
+  TestClient bob_client(config_);
+  EXPECT_CALL(*bob_client.inner_, check(_, _, _));
+  bob_client.client_.check(bob_client.callbacks_, bob, Tracing::NullSpan::instance());
+  EXPECT_CALL(bob_client.callbacks_, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::Denied, response->status);
+  }));
+  bob_client.inner_callbacks_->onComplete(response(CheckStatus::Denied));
+  EXPECT_EQ(2U, counter("miss"));
+  EXPECT_EQ(0U, counter("hit"));
+}
+
+TEST_F(DecisionCacheTest, KeyPathSegments) {
+  setUpTest(R"EOF(
+  ttl: 10s
+  path_segments: 2
+  )EOF");
+  EXPECT_EQ(config_->key(checkRequest("/api/v1/users", "")),
+            config_->key(checkRequest("/api/v1/groups?limit=10", "")));
+  EXPECT_EQ(config_->key(checkRequest("/api/v1", "")), config_->key(checkRequest("/api/v1/", "")));
+  EXPECT_NE(config_->key(checkRequest("/api/v1/users", "")),
+            config_->key(checkRequest("/api/v2/users", "")));
+  EXPECT_NE(config_->key(checkRequest("/api", "")), config_->key(checkRequest("/api/v1", "")));
+}
+
+TEST_F(DecisionCacheTest, HitUntilExpired) {
+  setUpTest(config_yaml_);
+  const auto request = checkRequest("/a", "alice");
+
+  TestClient first(config_);
+  EXPECT_CALL(*first.inner_, check(_, _, _));
+  first.client_.check(first.callbacks_, request, Tracing::NullSpan::instance());
+  EXPECT_CALL(first.callbacks_, onComplete_(_));
+  first.inner_callbacks_->onComplete(response(CheckStatus::OK));
+
+  TestClient second(config_);
+  EXPECT_CALL(*second.inner_, check(_, _, _)).Times(0);
+  EXPECT_CALL(second.callbacks_, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::OK, response->status);
+    ASSERT_EQ(1, response->headers_to_add.size());
+    EXPECT_EQ("alice", response->headers_to_add[0].second);
+  }));
+  second.client_.check(second.callbacks_, request, Tracing::NullSpan::instance());
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(1U, counter("hit"));
+
+  time_system_.sleep(std::chrono::seconds(10));
+  TestClient third(config_);
+  EXPECT_CALL(*third.inner_, check(_, _, _));
+  third.client_.check(third.callbacks_, request, Tracing::NullSpan::instance());
+  EXPECT_EQ(2U, counter("miss"));
+  EXPECT_CALL(*third.inner_, cancel());
+  third.client_.cancel();
+}
+
+TEST_F(DecisionCacheTest, DeniedAndErrorNotCached) {
+  setUpTest(config_yaml_);
+  const auto request = checkRequest("/a", "alice");
+
+  for (CheckStatus status : {CheckStatus::Denied, CheckStatus::Error}) {
+    TestClient client(config_);
+    EXPECT_CALL(*client.inner_, check(_, _, _));
+    client.client_.check(client.callbacks_, request, Tracing::NullSpan::instance());
+    client.inner_callbacks_->onComplete(response(status));
+  }
+  EXPECT_EQ(2U, counter("miss"));
+  EXPECT_EQ(0U, counter("hit"));
+}
+
+TEST_F(DecisionCacheTest, DeniedCached) {
+  setUpTest(R"EOF(
+  ttl: 10s
+  cache_denied: true
+  )EOF");
+  const auto request = checkRequest("/a", "alice");
+
+  TestClient first(config_);
+  first.client_.check(first.callbacks_, request, Tracing::NullSpan::instance());
+  first.inner_callbacks_->onComplete(response(CheckStatus::Denied));
+
+  TestClient second(config_);
+  EXPECT_CALL(*second.inner_, check(_, _, _)).Times(0);
+  EXPECT_CALL(second.callbacks_, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::Denied, response->status);
+  }));
+  second.client_.check(second.callbacks_, request, Tracing::NullSpan::instance());
+}
+
+TEST_F(DecisionCacheTest, LeastRecentlyUsedEvicted) {
+  setUpTest(R"EOF(
+  ttl: 10s
+  max_entries: 2
+  key_headers: [x-user]
+  )EOF");
+
+  for (const char* user : {"a", "b", "a", "c"}) {
+    TestClient client(config_);
+    client.client_.check(client.callbacks_, checkRequest("/", user),
+                         Tracing::NullSpan::instance());
+    if (client.inner_callbacks_ != nullptr) {
+      client.inner_callbacks_->onComplete(response(CheckStatus::OK));
+    }
+  }
+  EXPECT_EQ(3U, counter("miss"));
+  EXPECT_EQ(1U, counter("hit"));
+
+  TestClient client(config_);
+  EXPECT_CALL(*client.inner_, check(_, _, _)).Times(0);
+  client.client_.check(client.callbacks_, checkRequest("/", "a"), Tracing::NullSpan::instance());
+  EXPECT_EQ(2U, counter("hit"));
+}
+
+TEST_F(DecisionCacheTest, Coalesced) {
+  setUpTest(config_yaml_);
+  const auto request = checkRequest("/a", "alice");
+
+  TestClient first(config_);
+  TestClient second(config_);
+  TestClient third(config_);
+  EXPECT_CALL(*first.inner_, check(_, _, _));
+  EXPECT_CALL(*second.inner_, check(_, _, _)).Times(0);
+  EXPECT_CALL(*third.inner_, check(_, _, _)).Times(0);
+  first.client_.check(first.callbacks_, request, Tracing::NullSpan::instance());
+  second.client_.check(second.callbacks_, request, Tracing::NullSpan::instance());
+  third.client_.check(third.callbacks_, request, Tracing::NullSpan::instance());
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(2U, counter("coalesced"));
+
+  // A coalesced check goes away before the decision.
+  third.client_.cancel();
+
+  EXPECT_CALL(first.callbacks_, onComplete_(_));
+  EXPECT_CALL(second.callbacks_, onComplete_(_)).WillOnce(Invoke([](ResponsePtr& response) {
+    EXPECT_EQ(CheckStatus::OK, response->status);
+  }));
+  EXPECT_CALL(third.callbacks_, onComplete_(_)).Times(0);
+  first.inner_callbacks_->onComplete(response(CheckStatus::OK));
+}
+
+// When the check calling the authorization service goes away, a coalesced one calls it instead.
+TEST_F(DecisionCacheTest, CoalescedLeaderCancelled) {
+  setUpTest(config_yaml_);
+  const auto request = checkRequest("/a", "alice");
+
+  TestClient first(config_);
+  TestClient second(config_);
+  first.client_.check(first.callbacks_, request, Tracing::NullSpan::instance());
+  second.client_.check(second.callbacks_, request, Tracing::NullSpan::instance());
+
+  EXPECT_CALL(*first.inner_, cancel());
+  EXPECT_CALL(*second.inner_, check(_, _, _));
+  first.client_.cancel();
+
+  EXPECT_CALL(first.callbacks_, onComplete_(_)).Times(0);
+  EXPECT_CALL(second.callbacks_, onComplete_(_));
+  second.inner_callbacks_->onComplete(response(CheckStatus::Error));
+
+  // Errors are passed on, but not cached.
+  TestClient third(config_);
+  EXPECT_CALL(*third.inner_, check(_, _, _));
+  third.client_.check(third.callbacks_, request, Tracing::NullSpan::instance());
+  third.client_.cancel();
+}
+
+TEST_F(DecisionCacheTest, Shared) {
+  setUpTest(R"EOF(
+  ttl: 10s
+  shared: true
+  )EOF");
+  const auto request = checkRequest("/a", "alice");
+
+  TestClient first(config_);
+  first.client_.check(first.callbacks_, request, Tracing::NullSpan::instance());
+  first.inner_callbacks_->onComplete(response(CheckStatus::OK));
+
+  ASSERT_NE(nullptr, config_->sharedCache());
+  EXPECT_NE(nullptr,
+            config_->sharedCache()->lookup(config_->key(request), time_system_.monotonicTime()));
+}
+
+} // namespace
+} // namespace ExtAuthz
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -4,6 +4,7 @@
 
 #include "test/mocks/common.h"
 #include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -41,11 +42,12 @@ public:
   LuaTest() : yield_callback_([this]() { on_yield_.ready(); }) {}
 
   void setup(const std::string& code) {
-    state_ = std::make_unique<ThreadLocalState>(code, tls_);
+    state_ = std::make_unique<ThreadLocalState>(code, tls_, time_system_);
     state_->registerType<TestObject>();
   }
 
   NiceMock<ThreadLocal::MockInstance> tls_;
+  Event::GlobalTimeSystem time_system_;
   std::unique_ptr<ThreadLocalState> state_;
   std::function<void()> yield_callback_;
   ReadyWatcher on_yield_;
@@ -157,6 +159,55 @@ TEST_F(LuaTest, MarkDead) {
   lua_gc(cr1->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// Finished coroutines are reused by the next createCoroutine() on the worker, others are not.
+TEST_F(LuaTest, CoroutinePool) {
+  const std::string SCRIPT{R"EOF(
+    function callMe()
+      return "done"
+    end
+
+    function fail()
+      error("failed")
+    end
+
+    function yieldMe()
+      coroutine.yield()
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  const int call_me = state_->getGlobalRef(state_->registerGlobal("callMe"));
+  const int fail = state_->getGlobalRef(state_->registerGlobal("fail"));
+  const int yield_me = state_->getGlobalRef(state_->registerGlobal("yieldMe"));
+
+  CoroutinePtr cr1(state_->createCoroutine());
+  lua_State* finished_state = cr1->luaState();
+  cr1->start(call_me, 0, yield_callback_);
+  EXPECT_EQ(cr1->state(), Coroutine::State::Finished);
+  state_->releaseCoroutine(std::move(cr1));
+
+  // The pooled coroutine is started again from a clean stack.
+  CoroutinePtr cr2(state_->createCoroutine());
+  EXPECT_EQ(finished_state, cr2->luaState());
+  EXPECT_EQ(cr2->state(), Coroutine::State::NotStarted);
+  EXPECT_EQ(0, lua_gettop(cr2->luaState()));
+  EXPECT_THROW_WITH_MESSAGE(cr2->start(fail, 0, yield_callback_), LuaException,
+                            "[string \"...\"]:7: failed");
+  lua_State* failed_state = cr2->luaState();
+  state_->releaseCoroutine(std::move(cr2));
+
+  CoroutinePtr cr3(state_->createCoroutine());
+  EXPECT_NE(failed_state, cr3->luaState());
+  EXPECT_CALL(on_yield_, ready());
+  cr3->start(yield_me, 0, yield_callback_);
+  EXPECT_EQ(cr3->state(), Coroutine::State::Yielded);
+  lua_State* yielded_state = cr3->luaState();
+  state_->releaseCoroutine(std::move(cr3));
+
+  CoroutinePtr cr4(state_->createCoroutine());
+  EXPECT_NE(yielded_state, cr4->luaState());
+}
+
 } // namespace
 } // namespace Lua
 } // namespace Common
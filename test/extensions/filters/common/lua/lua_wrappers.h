@@ -3,6 +3,7 @@
 #include "extensions/filters/common/lua/lua.h"
 
 #include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/test_time.h"
 
 #include "gmock/gmock.h"
 
@@ -18,7 +19,7 @@ template <class T> class LuaWrappersTestBase : public testing::Test {
 public:
   virtual void setup(const std::string& code) {
     coroutine_.reset();
-    state_.reset(new ThreadLocalState(code, tls_));
+    state_.reset(new ThreadLocalState(code, tls_, time_system_));
     state_->registerType<T>();
     coroutine_ = state_->createCoroutine();
     lua_pushlightuserdata(coroutine_->luaState(), this);
@@ -41,6 +42,7 @@ public:
   MOCK_METHOD1(testPrint, void(const std::string&));
 
   NiceMock<ThreadLocal::MockInstance> tls_;
+  Event::GlobalTimeSystem time_system_;
   std::unique_ptr<ThreadLocalState> state_;
   std::function<void()> yield_callback_;
   CoroutinePtr coroutine_;
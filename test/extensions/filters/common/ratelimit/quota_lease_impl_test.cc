@@ -0,0 +1,226 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/tracing/http_tracer_impl.h"
+
+#include "extensions/filters/common/ratelimit/quota_lease_impl.h"
+
+#include "test/extensions/filters/common/ratelimit/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RateLimit {
+namespace {
+
+class MockRequestCallbacks : public RequestCallbacks {
+public:
+  void complete(LimitStatus status, Http::HeaderMapPtr&&, Http::HeaderMapPtr&&) override {
+    complete_(status);
+  }
+
+  MOCK_METHOD1(complete_, void(LimitStatus status));
+};
+
+class QuotaLeaseClientTest : public testing::Test {
+public:
+  QuotaLeaseClientTest()
+      : cache_(time_system_), inner_client_(new MockClient()),
+        client_(ClientPtr{inner_client_}, cache_, 3, std::chrono::milliseconds(1000)) {}
+
+  // Calls the client, which calls the rate limit service, and answers the call.
+  void limitFromService(LimitStatus status) {
+    RequestCallbacks* inner_callbacks{};
+    EXPECT_CALL(*inner_client_, limit(_, "foo", _, _))
+        .WillOnce(Invoke([&inner_callbacks](RequestCallbacks& callbacks, const std::string&,
+                                            const std::vector<Envoy::RateLimit::Descriptor>&,
+                                            Tracing::Span&) { inner_callbacks = &callbacks; }));
+    client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+    EXPECT_CALL(callbacks_, complete_(status));
+    inner_callbacks->complete(status, nullptr, nullptr);
+  }
+
+  // Calls the client, which answers from the leased requests.
+  void limitFromLease() {
+    EXPECT_CALL(*inner_client_, limit(_, _, _, _)).Times(0);
+    EXPECT_CALL(callbacks_, complete_(LimitStatus::OK));
+    client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  QuotaLeaseCache cache_;
+  MockClient* inner_client_;
+  QuotaLeaseClientImpl client_;
+  MockRequestCallbacks callbacks_;
+};
+
+TEST_F(QuotaLeaseClientTest, LeaseUsedUp) {
+  limitFromService(LimitStatus::OK);
+  limitFromLease();
+  limitFromLease();
+  limitFromService(LimitStatus::OK);
+}
+
+TEST_F(QuotaLeaseClientTest, LeaseExpires) {
+  limitFromService(LimitStatus::OK);
+  limitFromLease();
+  time_system_.sleep(std::chrono::milliseconds(1000));
+  limitFromService(LimitStatus::OK);
+}
+
+TEST_F(QuotaLeaseClientTest, NoLeaseWhenOverLimit) {
+  limitFromService(LimitStatus::OverLimit);
+  limitFromService(LimitStatus::Error);
+  limitFromService(LimitStatus::OK);
+  limitFromLease();
+}
+
+// Leases are kept per domain and descriptors.
+TEST_F(QuotaLeaseClientTest, DifferentDescriptors) {
+  limitFromService(LimitStatus::OK);
+
+  EXPECT_CALL(*inner_client_, limit(_, "foo", _, _));
+  client_.limit(callbacks_, "foo", {{{{"foo", "baz"}}}}, Tracing::NullSpan::instance());
+  EXPECT_CALL(*inner_client_, cancel());
+  client_.cancel();
+
+  EXPECT_CALL(*inner_client_, limit(_, "bar", _, _));
+  client_.limit(callbacks_, "bar", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+  EXPECT_CALL(*inner_client_, cancel());
+  client_.cancel();
+
+  limitFromLease();
+}
+
+// A client which needs a lease while a call for the same one is in flight waits for its lease.
+TEST_F(QuotaLeaseClientTest, CallsCoalesced) {
+  RequestCallbacks* inner_callbacks{};
+  EXPECT_CALL(*inner_client_, limit(_, "foo", _, _))
+      .WillOnce(Invoke([&inner_callbacks](RequestCallbacks& callbacks, const std::string&,
+                                          const std::vector<Envoy::RateLimit::Descriptor>&,
+                                          Tracing::Span&) { inner_callbacks = &callbacks; }));
+  client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+
+  MockClient* waiting_inner_client = new MockClient();
+  QuotaLeaseClientImpl waiting_client(ClientPtr{waiting_inner_client}, cache_, 3,
+                                      std::chrono::milliseconds(1000));
+  MockRequestCallbacks waiting_callbacks;
+  EXPECT_CALL(*waiting_inner_client, limit(_, _, _, _)).Times(0);
+  waiting_client.limit(waiting_callbacks, "foo", {{{{"foo", "bar"}}}},
+                       Tracing::NullSpan::instance());
+
+  EXPECT_CALL(waiting_callbacks, complete_(LimitStatus::OK));
+  EXPECT_CALL(callbacks_, complete_(LimitStatus::OK));
+  inner_callbacks->complete(LimitStatus::OK, nullptr, nullptr);
+
+  // Of the 3 leased requests, one is left.
+  limitFromLease();
+  limitFromService(LimitStatus::OK);
+}
+
+TEST_F(QuotaLeaseClientTest, WaitingClientOverLimit) {
+  RequestCallbacks* inner_callbacks{};
+  EXPECT_CALL(*inner_client_, limit(_, "foo", _, _))
+      .WillOnce(Invoke([&inner_callbacks](RequestCallbacks& callbacks, const std::string&,
+                                          const std::vector<Envoy::RateLimit::Descriptor>&,
+                                          Tracing::Span&) { inner_callbacks = &callbacks; }));
+  client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+
+  QuotaLeaseClientImpl waiting_client(ClientPtr{new MockClient()}, cache_, 3,
+                                      std::chrono::milliseconds(1000));
+  MockRequestCallbacks waiting_callbacks;
+  waiting_client.limit(waiting_callbacks, "foo", {{{{"foo", "bar"}}}},
+                       Tracing::NullSpan::instance());
+
+  EXPECT_CALL(waiting_callbacks, complete_(LimitStatus::OverLimit));
+  EXPECT_CALL(callbacks_, complete_(LimitStatus::OverLimit));
+  inner_callbacks->complete(LimitStatus::OverLimit, nullptr, nullptr);
+}
+
+// When the call in flight is cancelled, a client which waited for it makes its own.
+TEST_F(QuotaLeaseClientTest, CallCancelled) {
+  EXPECT_CALL(*inner_client_, limit(_, "foo", _, _));
+  client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+
+  MockClient* waiting_inner_client = new MockClient();
+  QuotaLeaseClientImpl waiting_client(ClientPtr{waiting_inner_client}, cache_, 3,
+                                      std::chrono::milliseconds(1000));
+  MockRequestCallbacks waiting_callbacks;
+  waiting_client.limit(waiting_callbacks, "foo", {{{{"foo", "bar"}}}},
+                       Tracing::NullSpan::instance());
+
+  EXPECT_CALL(*inner_client_, cancel());
+  EXPECT_CALL(*waiting_inner_client, limit(_, "foo", _, _));
+  client_.cancel();
+
+  EXPECT_CALL(*waiting_inner_client, cancel());
+  waiting_client.cancel();
+  limitFromService(LimitStatus::OK);
+}
+
+TEST_F(QuotaLeaseClientTest, WaitingClientCancelled) {
+  RequestCallbacks* inner_callbacks{};
+  EXPECT_CALL(*inner_client_, limit(_, "foo", _, _))
+      .WillOnce(Invoke([&inner_callbacks](RequestCallbacks& callbacks, const std::string&,
+                                          const std::vector<Envoy::RateLimit::Descriptor>&,
+                                          Tracing::Span&) { inner_callbacks = &callbacks; }));
+  client_.limit(callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+
+  MockClient* waiting_inner_client = new MockClient();
+  QuotaLeaseClientImpl waiting_client(ClientPtr{waiting_inner_client}, cache_, 3,
+                                      std::chrono::milliseconds(1000));
+  MockRequestCallbacks waiting_callbacks;
+  waiting_client.limit(waiting_callbacks, "foo", {{{{"foo", "bar"}}}},
+                       Tracing::NullSpan::instance());
+  EXPECT_CALL(*waiting_inner_client, cancel()).Times(0);
+  waiting_client.cancel();
+
+  EXPECT_CALL(waiting_callbacks, complete_(_)).Times(0);
+  EXPECT_CALL(callbacks_, complete_(LimitStatus::OK));
+  inner_callbacks->complete(LimitStatus::OK, nullptr, nullptr);
+  limitFromLease();
+  limitFromLease();
+}
+
+// A new lease adds to the requests left from the previous one.
+TEST(QuotaLeaseCacheTest, LeaseAdds) {
+  Event::SimulatedTimeSystem time_system;
+  QuotaLeaseCache cache(time_system);
+  cache.lease("key", 1, std::chrono::milliseconds(1000));
+  cache.lease("key", 2, std::chrono::milliseconds(1000));
+  EXPECT_TRUE(cache.tryConsume("key"));
+  EXPECT_TRUE(cache.tryConsume("key"));
+  EXPECT_TRUE(cache.tryConsume("key"));
+  EXPECT_FALSE(cache.tryConsume("key"));
+
+  // The requests left from an expired lease are not added.
+  cache.lease("key", 1, std::chrono::milliseconds(1000));
+  time_system.sleep(std::chrono::milliseconds(1000));
+  cache.lease("key", 1, std::chrono::milliseconds(1000));
+  EXPECT_TRUE(cache.tryConsume("key"));
+  EXPECT_FALSE(cache.tryConsume("key"));
+}
+
+TEST(QuotaLeaseCacheTest, LeaseKey) {
+  EXPECT_EQ(QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}, {"c", "d"}}}}),
+            QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}, {"c", "d"}}}}));
+  EXPECT_NE(QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}, {"c", "d"}}}}),
+            QuotaLeaseCache::leaseKey("foo", {{{{"a", "b"}}}, {{{"c", "d"}}}}));
+}
+
+} // namespace
+} // namespace RateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -135,6 +135,24 @@ TEST_F(RateLimitGrpcClientTest, Cancel) {
   client_.cancel();
 }
 
+TEST_F(RateLimitGrpcClientTest, HitsAddend) {
+  Grpc::MockAsyncClient* async_client = new Grpc::MockAsyncClient();
+  GrpcClientImpl client(Grpc::RawAsyncClientPtr{async_client},
+                        absl::optional<std::chrono::milliseconds>(), 10);
+
+  envoy::service::ratelimit::v2::RateLimitRequest request;
+  GrpcClientImpl::createRequest(request, "foo", {{{{"foo", "bar"}}}});
+  request.set_hits_addend(10);
+  EXPECT_CALL(*async_client, sendRaw(_, _, Grpc::ProtoBufferEq(request), _, _, _))
+      .WillOnce(Return(&async_request_));
+  client.limit(request_callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+
+  EXPECT_CALL(request_callbacks_, complete_(LimitStatus::OK, _, _));
+  auto response = std::make_unique<envoy::service::ratelimit::v2::RateLimitResponse>();
+  response->set_overall_code(envoy::service::ratelimit::v2::RateLimitResponse_Code_OK);
+  client.onSuccess(std::move(response), span_);
+}
+
 } // namespace
 } // namespace RateLimit
 } // namespace Common
@@ -0,0 +1,99 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/network/utility.h"
+
+#include "extensions/filters/common/rbac/engine_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+
+static std::string principalName(int64_t service_account) {
+  return absl::StrCat("spiffe://cluster.local/ns/default/sa/sa-", service_account);
+}
+
+// Builds one policy per service account, which allows it to GET paths. Exact principal names are
+// indexed, suffixes are not.
+static envoy::config::rbac::v2::RBAC rbacConfig(int64_t policies, bool indexable) {
+  envoy::config::rbac::v2::RBAC rbac;
+  rbac.set_action(envoy::config::rbac::v2::RBAC_Action::RBAC_Action_ALLOW);
+  for (int64_t i = 0; i < policies; i++) {
+    envoy::config::rbac::v2::Policy policy;
+    auto* header = policy.add_permissions()->mutable_header();
+    header->set_name(":method");
+    header->set_exact_match("GET");
+    auto* principal_name =
+        policy.add_principals()->mutable_authenticated()->mutable_principal_name();
+    if (indexable) {
+      principal_name->set_exact(principalName(i));
+    } else {
+      principal_name->set_suffix(absl::StrCat("/sa/sa-", i));
+    }
+    (*rbac.mutable_policies())[absl::StrCat("policy-", i)] = policy;
+  }
+  return rbac;
+}
+
+// Checks a request of the service account whose policy is in the middle. The first Arg of the
+// BENCHMARK(...) macro call below is the number of policies, and the second one is whether their
+// principals can be indexed.
+static void EngineAllowed(benchmark::State& state) {
+  const int64_t policies = state.range(0);
+  RoleBasedAccessControlEngineImpl engine(rbacConfig(policies, state.range(1) != 0));
+
+  NiceMock<Envoy::Network::MockConnection> connection;
+  connection.local_address_ =
+      Envoy::Network::Utility::parseInternetAddress("10.0.0.1", 443, false);
+  auto ssl = std::make_shared<NiceMock<Ssl::MockConnectionInfo>>();
+  const std::vector<std::string> sans{principalName(policies / 2)};
+  ON_CALL(*ssl, uriSanPeerCertificate()).WillByDefault(Return(sans));
+  ON_CALL(testing::Const(connection), ssl()).WillByDefault(Return(ssl));
+  Envoy::Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}};
+  NiceMock<StreamInfo::MockStreamInfo> info;
+
+  for (auto _ : state) {
+    std::string effective_policy_id;
+    benchmark::DoNotOptimize(engine.allowed(connection, headers, info, &effective_policy_id));
+  }
+}
+BENCHMARK(EngineAllowed)
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({100, 0})
+    ->Args({100, 1})
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({5000, 0})
+    ->Args({5000, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -52,11 +52,11 @@ TEST(RoleBasedAccessControlEngineImpl, AllowedWhitelist) {
   Envoy::Network::MockConnection conn;
   Envoy::Network::Address::InstanceConstSharedPtr addr =
       Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 123, false);
-  EXPECT_CALL(conn, localAddress()).WillOnce(ReturnRef(addr));
+  EXPECT_CALL(conn, localAddress()).WillRepeatedly(ReturnRef(addr));
   checkEngine(engine, true, conn);
 
   addr = Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 456, false);
-  EXPECT_CALL(conn, localAddress()).WillOnce(ReturnRef(addr));
+  EXPECT_CALL(conn, localAddress()).WillRepeatedly(ReturnRef(addr));
   checkEngine(engine, false, conn);
 }
 
@@ -73,11 +73,11 @@ TEST(RoleBasedAccessControlEngineImpl, DeniedBlacklist) {
   Envoy::Network::MockConnection conn;
   Envoy::Network::Address::InstanceConstSharedPtr addr =
       Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 123, false);
-  EXPECT_CALL(conn, localAddress()).WillOnce(ReturnRef(addr));
+  EXPECT_CALL(conn, localAddress()).WillRepeatedly(ReturnRef(addr));
   checkEngine(engine, false, conn);
 
   addr = Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 456, false);
-  EXPECT_CALL(conn, localAddress()).WillOnce(ReturnRef(addr));
+  EXPECT_CALL(conn, localAddress()).WillRepeatedly(ReturnRef(addr));
   checkEngine(engine, true, conn);
 }
 
@@ -258,7 +258,38 @@ TEST(RoleBasedAccessControlEngineImpl, ConjunctiveCondition) {
   Envoy::Network::MockConnection conn;
   Envoy::Network::Address::InstanceConstSharedPtr addr =
       Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 123, false);
-  EXPECT_CALL(conn, localAddress()).WillOnce(ReturnRef(addr));
+  EXPECT_CALL(conn, localAddress()).WillRepeatedly(ReturnRef(addr));
+  checkEngine(engine, false, conn);
+}
+
+// The first policy by name which matches is reported, whether it is indexed or not.
+TEST(RoleBasedAccessControlEngineImpl, IndexedPolicyOrder) {
+  envoy::config::rbac::v2::RBAC rbac;
+  rbac.set_action(envoy::config::rbac::v2::RBAC_Action::RBAC_Action_ALLOW);
+  envoy::config::rbac::v2::Policy indexed;
+  indexed.add_permissions()->set_destination_port(123);
+  indexed.add_principals()->set_any(true);
+  envoy::config::rbac::v2::Policy unindexed;
+  unindexed.add_permissions()->set_any(true);
+  unindexed.add_principals()->mutable_header()->set_name("x-user");
+  (*rbac.mutable_policies())["a"] = indexed;
+  (*rbac.mutable_policies())["b"] = unindexed;
+  (*rbac.mutable_policies())["c"] = indexed;
+  RBAC::RoleBasedAccessControlEngineImpl engine(rbac);
+
+  NiceMock<Envoy::Network::MockConnection> conn;
+  conn.local_address_ = Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 123, false);
+  Envoy::Http::TestHeaderMapImpl headers{{"x-user", "foo"}};
+  std::string effective_policy_id;
+  checkEngine(engine, true, conn, headers, envoy::api::v2::core::Metadata(),
+              &effective_policy_id);
+  EXPECT_EQ("a", effective_policy_id);
+
+  conn.local_address_ = Envoy::Network::Utility::parseInternetAddress("1.2.3.4", 456, false);
+  checkEngine(engine, true, conn, headers, envoy::api::v2::core::Metadata(),
+              &effective_policy_id);
+  EXPECT_EQ("b", effective_policy_id);
+
   checkEngine(engine, false, conn);
 }
 
@@ -0,0 +1,208 @@
+#include "common/http/header_map_impl.h"
+#include "common/network/utility.h"
+
+#include "extensions/filters/common/rbac/policy_index.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Const;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace RBAC {
+namespace {
+
+class PolicyIndexTest : public testing::Test {
+public:
+  PolicyIndexTest() {
+    connection_.local_address_ =
+        Envoy::Network::Utility::parseInternetAddress("10.0.0.1", 443, false);
+    connection_.remote_address_ =
+        Envoy::Network::Utility::parseInternetAddress("192.168.1.5", 1234, false);
+  }
+
+  void add(const std::string& yaml) {
+    index_.add(positions_++, TestUtility::parseYaml<envoy::config::rbac::v2::Policy>(yaml));
+  }
+
+  std::vector<uint32_t> candidates() {
+    PolicyPositions positions;
+    index_.candidates(connection_, headers_, positions);
+    return std::vector<uint32_t>(positions.begin(), positions.end());
+  }
+
+  PolicyIndex index_;
+  uint32_t positions_{};
+  NiceMock<Envoy::Network::MockConnection> connection_;
+  Envoy::Http::TestHeaderMapImpl headers_;
+};
+
+TEST_F(PolicyIndexTest, Headers) {
+  add(R"EOF(
+permissions:
+- header: { name: ":path", exact_match: "/a" }
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- header: { name: ":path", exact_match: "/b" }
+- header: { name: "X-Tenant", exact_match: "t1" }
+principals:
+- any: true
+)EOF");
+  // Neither an empty exact match nor an inverted one can be indexed.
+  add(R"EOF(
+permissions:
+- header: { name: ":path", exact_match: "" }
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- header: { name: ":path", exact_match: "/a", invert_match: true }
+principals:
+- any: true
+)EOF");
+  index_.compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{2, 3}), index_.unindexed());
+  EXPECT_EQ((std::vector<uint32_t>{}), candidates());
+  headers_.addCopy(":path", "/a");
+  EXPECT_EQ((std::vector<uint32_t>{0}), candidates());
+  headers_.addCopy("x-tenant", "t1");
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), candidates());
+}
+
+TEST_F(PolicyIndexTest, Connection) {
+  add(R"EOF(
+permissions:
+- destination_port: 443
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- destination_ip: { address_prefix: "10.0.0.0", prefix_len: 8 }
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- any: true
+principals:
+- source_ip: { address_prefix: "192.168.2.0", prefix_len: 24 }
+)EOF");
+  add(R"EOF(
+permissions:
+- requested_server_name: { exact: "example.com" }
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- requested_server_name: { prefix: "example" }
+principals:
+- any: true
+)EOF");
+  index_.compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{4}), index_.unindexed());
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), candidates());
+  connection_.remote_address_ =
+      Envoy::Network::Utility::parseInternetAddress("192.168.2.7", 1234, false);
+  ON_CALL(connection_, requestedServerName()).WillByDefault(Return("example.com"));
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 3}), candidates());
+}
+
+TEST_F(PolicyIndexTest, Principals) {
+  add(R"EOF(
+permissions:
+- any: true
+principals:
+- authenticated: { principal_name: { exact: "spiffe://cluster.local/ns/a/sa/a" } }
+)EOF");
+  add(R"EOF(
+permissions:
+- any: true
+principals:
+- authenticated: { principal_name: { exact: "spiffe://cluster.local/ns/b/sa/b" } }
+)EOF");
+  // Any authenticated connection matches.
+  add(R"EOF(
+permissions:
+- any: true
+principals:
+- authenticated: {}
+)EOF");
+  index_.compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{2}), index_.unindexed());
+  EXPECT_EQ((std::vector<uint32_t>{}), candidates());
+
+  auto ssl = std::make_shared<Ssl::MockConnectionInfo>();
+  const std::vector<std::string> sans{"spiffe://cluster.local/ns/b/sa/b"};
+  EXPECT_CALL(*ssl, uriSanPeerCertificate()).WillRepeatedly(Return(sans));
+  EXPECT_CALL(Const(connection_), ssl()).WillRepeatedly(Return(ssl));
+  EXPECT_EQ((std::vector<uint32_t>{1}), candidates());
+}
+
+// A conjunction is indexed by one of its indexable parts, and a disjunction only if all its parts
+// are indexable.
+TEST_F(PolicyIndexTest, Sets) {
+  add(R"EOF(
+permissions:
+- and_rules:
+    rules:
+    - metadata: { filter: "f", path: [ { key: "k" } ], value: { string_match: { exact: "v" } } }
+    - destination_port: 443
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- or_rules:
+    rules:
+    - destination_port: 80
+    - header: { name: "x-tenant", exact_match: "t1" }
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- or_rules:
+    rules:
+    - destination_port: 80
+    - any: true
+principals:
+- any: true
+)EOF");
+  add(R"EOF(
+permissions:
+- not_rule: { destination_port: 443 }
+principals:
+- any: true
+)EOF");
+  index_.compile();
+
+  EXPECT_EQ((std::vector<uint32_t>{2, 3}), index_.unindexed());
+  EXPECT_EQ((std::vector<uint32_t>{0}), candidates());
+  headers_.addCopy("x-tenant", "t1");
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), candidates());
+}
+
+} // namespace
+} // namespace RBAC
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
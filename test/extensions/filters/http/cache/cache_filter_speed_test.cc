@@ -0,0 +1,175 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/cache/cache_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+// Number of distinct paths requested, which all fit in the cache.
+static constexpr uint64_t PathCount = 500;
+
+/**
+ * A local upstream which answers the requests the cache filter passes on, along with the
+ * downstream of the requests, and counts what it sees.
+ */
+class LocalUpstream {
+public:
+  LocalUpstream(const std::string& config_yaml, uint64_t body_size)
+      : body_(body_size, 'a'), tls_(std::make_unique<NiceMock<ThreadLocal::MockInstance>>()) {
+    envoy::config::filter::http::cache::v2alpha::Cache cache;
+    TestUtility::loadFromYaml(config_yaml, cache);
+    config_ = std::make_shared<CacheFilterConfig>(cache, "", stats_, time_system_, *tls_);
+    ON_CALL(decoder_callbacks_, encodeData(testing::_, testing::_))
+        .WillByDefault(testing::Invoke([this](Buffer::Instance& data, bool) {
+          served_bytes_ += data.length();
+        }));
+  }
+
+  /**
+   * Sends a request through a new cache filter, and the response of the upstream if the filter
+   * passes the request on.
+   */
+  void request(uint64_t path) {
+    CacheFilter filter(config_);
+    filter.setDecoderFilterCallbacks(decoder_callbacks_);
+    filter.setEncoderFilterCallbacks(encoder_callbacks_);
+    Http::TestHeaderMapImpl headers{
+        {":method", "GET"}, {":authority", "host"}, {":path", absl::StrCat("/", path)}};
+    if (filter.decodeHeaders(headers, true) == Http::FilterHeadersStatus::Continue) {
+      respond(filter);
+    }
+    filter.onDestroy();
+  }
+
+  /**
+   * Sends concurrent requests for the same path, which are answered once they have all been
+   * received.
+   */
+  void concurrentRequests(uint64_t path, uint64_t count) {
+    std::vector<std::unique_ptr<CacheFilter>> filters;
+    std::vector<Http::TestHeaderMapImpl> headers(
+        count, {{":method", "GET"}, {":authority", "host"}, {":path", absl::StrCat("/", path)}});
+    std::vector<CacheFilter*> passed_on;
+    for (uint64_t i = 0; i < count; i++) {
+      filters.push_back(std::make_unique<CacheFilter>(config_));
+      filters.back()->setDecoderFilterCallbacks(decoder_callbacks_);
+      filters.back()->setEncoderFilterCallbacks(encoder_callbacks_);
+      if (filters.back()->decodeHeaders(headers[i], true) == Http::FilterHeadersStatus::Continue) {
+        passed_on.push_back(filters.back().get());
+      }
+    }
+    for (CacheFilter* filter : passed_on) {
+      respond(*filter);
+    }
+    for (auto& filter : filters) {
+      filter->onDestroy();
+    }
+  }
+
+  Stats::IsolatedStoreImpl stats_;
+  uint64_t upstream_requests_{};
+  uint64_t served_bytes_{};
+
+private:
+  void respond(CacheFilter& filter) {
+    upstream_requests_++;
+    Http::TestHeaderMapImpl headers{{":status", "200"}, {"cache-control", "max-age=3600"}};
+    filter.encodeHeaders(headers, false);
+    Buffer::OwnedImpl data(body_);
+    filter.encodeData(data, true);
+    served_bytes_ += data.length();
+  }
+
+  const std::string body_;
+  Event::SimulatedTimeSystem time_system_;
+  std::unique_ptr<NiceMock<ThreadLocal::MockInstance>> tls_;
+  CacheFilterConfigSharedPtr config_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+static std::string storeConfig(int64_t store) {
+  if (store == 0) {
+    return "{ in_memory: {} }";
+  }
+  return absl::StrCat("{ file: { path: \"",
+                      TestEnvironment::temporaryPath("cache_filter_speed_test"), "\" } }");
+}
+
+// Requests PathCount paths round robin, so that all but the first requests of each path are
+// served from the cache. The first Arg of the BENCHMARK(...) macro call below is the store, 0 for
+// the in-memory one and 1 for the file, and the second one is the size of the bodies.
+static void CacheFilterRequests(benchmark::State& state) {
+  ::unlink(TestEnvironment::temporaryPath("cache_filter_speed_test").c_str());
+  LocalUpstream upstream(storeConfig(state.range(0)), state.range(1));
+  uint64_t path = 0;
+  for (auto _ : state) {
+    upstream.request(path++ % PathCount);
+  }
+  state.SetBytesProcessed(upstream.served_bytes_);
+  const uint64_t hits = upstream.stats_.counter("cache.hit").value();
+  state.counters["hit_ratio"] =
+      static_cast<double>(hits) / (hits + upstream.stats_.counter("cache.miss").value());
+  state.counters["upstream_requests"] = upstream.upstream_requests_;
+}
+BENCHMARK(CacheFilterRequests)
+    ->Args({0, 1024})
+    ->Args({0, 64 * 1024})
+    ->Args({1, 1024})
+    ->Args({1, 64 * 1024})
+    ->Unit(benchmark::kMicrosecond);
+
+// Sends bursts of concurrent requests for paths which are not cached yet. The first Arg of the
+// BENCHMARK(...) macro call below is whether the requests are coalesced, and the second one is the
+// number of concurrent requests.
+static void CacheFilterConcurrentMisses(benchmark::State& state) {
+  LocalUpstream upstream(absl::StrCat("{ in_memory: {}, coalesce_requests: ",
+                                      state.range(0) != 0 ? "true" : "false", " }"),
+                         16 * 1024);
+  uint64_t path = 0;
+  for (auto _ : state) {
+    upstream.concurrentRequests(path++, state.range(1));
+  }
+  state.SetBytesProcessed(upstream.served_bytes_);
+  state.counters["upstream_requests"] = upstream.upstream_requests_;
+  state.counters["coalesced"] = upstream.stats_.counter("cache.coalesced").value();
+}
+BENCHMARK(CacheFilterConcurrentMisses)
+    ->Args({0, 10})
+    ->Args({0, 100})
+    ->Args({1, 10})
+    ->Args({1, 100})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
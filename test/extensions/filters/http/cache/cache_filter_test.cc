@@ -0,0 +1,329 @@
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/cache/cache_filter.h"
+#include "extensions/filters/http/cache/in_memory_http_cache.h"
+
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+// A request going through its own cache filter.
+struct TestRequest {
+  TestRequest(const CacheFilterConfigSharedPtr& config, Http::TestHeaderMapImpl&& headers)
+      : filter_(config), headers_(std::move(headers)) {
+    filter_.setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_.setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  CacheFilter filter_;
+  Http::TestHeaderMapImpl headers_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+class CacheFilterTest : public testing::Test {
+protected:
+  CacheFilterTest() : store_(std::make_shared<InMemoryHttpCache>(1024 * 1024, 4)) {
+    time_system_.setSystemTime(std::chrono::hours(24 * 365 * 30));
+    setUpConfig("{ in_memory: {} }");
+  }
+
+  void setUpConfig(const std::string& yaml) {
+    envoy::config::filter::http::cache::v2alpha::Cache cache;
+    TestUtility::loadFromYaml(yaml, cache);
+    config_ = std::make_shared<CacheFilterConfig>(cache, store_, "test.", stats_, time_system_,
+                                                  tls_);
+  }
+
+  std::unique_ptr<TestRequest> request(Http::TestHeaderMapImpl&& extra_headers = {}) {
+    Http::TestHeaderMapImpl headers{{":method", "GET"}, {":authority", "host"}, {":path", "/a"}};
+    extra_headers.iterate(
+        [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+          static_cast<Http::HeaderMap*>(context)->addCopy(
+              Http::LowerCaseString(std::string(header.key().getStringView())),
+              std::string(header.value().getStringView()));
+          return Http::HeaderMap::Iterate::Continue;
+        },
+        &headers);
+    return std::make_unique<TestRequest>(config_, std::move(headers));
+  }
+
+  // Sends a request which is not served from the cache, and the given response to it.
+  void fetch(TestRequest& request, Http::TestHeaderMapImpl&& response_headers,
+             const std::string& body) {
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+              request.filter_.decodeHeaders(request.headers_, true));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+              request.filter_.encodeHeaders(response_headers, false));
+    Buffer::OwnedImpl data(body);
+    EXPECT_EQ(Http::FilterDataStatus::Continue, request.filter_.encodeData(data, true));
+    EXPECT_EQ(body, data.toString());
+    request.filter_.onDestroy();
+  }
+
+  // Expects a request to be served from the cache with the given body and age.
+  void expectServed(TestRequest& request, const std::string& body, const std::string& age) {
+    EXPECT_CALL(request.decoder_callbacks_, encodeHeaders_(_, false))
+        .WillOnce(Invoke([age](Http::HeaderMap& headers, bool) {
+          EXPECT_EQ("200", headers.Status()->value().getStringView());
+          EXPECT_EQ(age, headers.get(Http::LowerCaseString("age"))->value().getStringView());
+        }));
+    EXPECT_CALL(request.decoder_callbacks_, encodeData(BufferStringEqual(body), true));
+  }
+
+  uint64_t counter(const std::string& name) { return stats_.counter("test.cache." + name).value(); }
+
+  Stats::IsolatedStoreImpl stats_;
+  Event::SimulatedTimeSystem time_system_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  std::shared_ptr<InMemoryHttpCache> store_;
+  CacheFilterConfigSharedPtr config_;
+};
+
+TEST_F(CacheFilterTest, MissThenHit) {
+  auto first = request();
+  fetch(*first, {{":status", "200"}, {"cache-control", "max-age=60"}}, "hello");
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(1U, counter("insert"));
+
+  time_system_.sleep(std::chrono::seconds(10));
+  auto second = request();
+  expectServed(*second, "hello", "10");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            second->filter_.decodeHeaders(second->headers_, true));
+  second->filter_.onDestroy();
+  EXPECT_EQ(1U, counter("hit"));
+  EXPECT_EQ(5U, counter("bytes_served"));
+
+  // Once the response is stale, and it can not be revalidated, the request goes to the upstream.
+  time_system_.sleep(std::chrono::seconds(60));
+  auto third = request();
+  EXPECT_CALL(third->decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  fetch(*third, {{":status", "200"}, {"cache-control", "max-age=60"}}, "world");
+  EXPECT_EQ(2U, counter("miss"));
+  EXPECT_EQ("world", store_->lookup("host/a", Http::TestHeaderMapImpl{})->body());
+}
+
+TEST_F(CacheFilterTest, NotCached) {
+  auto no_store = request({{"cache-control", "no-store"}});
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            no_store->filter_.decodeHeaders(no_store->headers_, true));
+  auto authorized = request({{"authorization", "Bearer x"}});
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            authorized->filter_.decodeHeaders(authorized->headers_, true));
+  EXPECT_EQ(2U, counter("bypass"));
+
+  Http::TestHeaderMapImpl post{{":method", "POST"}, {":authority", "host"}, {":path", "/a"}};
+  auto post_request = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, post_request->filter_.decodeHeaders(post, true));
+  EXPECT_EQ(0U, counter("miss"));
+
+  auto uncacheable = request();
+  fetch(*uncacheable, {{":status", "200"}, {"cache-control", "private, max-age=60"}}, "hello");
+  EXPECT_EQ(nullptr, store_->lookup("host/a", Http::TestHeaderMapImpl{}));
+  auto cookie = request();
+  fetch(*cookie, {{":status", "200"}, {"cache-control", "max-age=60"}, {"set-cookie", "id=1"}},
+        "hello");
+  EXPECT_EQ(nullptr, store_->lookup("host/a", Http::TestHeaderMapImpl{}));
+
+  // A body larger than max_body_bytes is not cached.
+  setUpConfig("{ in_memory: {}, max_body_bytes: 4 }");
+  auto large = request();
+  fetch(*large, {{":status", "200"}, {"cache-control", "max-age=60"}}, "hello");
+  EXPECT_EQ(nullptr, store_->lookup("host/a", Http::TestHeaderMapImpl{}));
+  EXPECT_EQ(0U, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, Vary) {
+  auto gzip = request({{"accept-encoding", "gzip"}});
+  fetch(*gzip, {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "accept-encoding"}},
+        "gzipped");
+
+  auto identity = request();
+  fetch(*identity,
+        {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "accept-encoding"}},
+        "plain");
+  EXPECT_EQ(2U, counter("miss"));
+
+  // Both variants are cached, and the values of the request headers are normalized.
+  auto gzip_again = request({{"accept-encoding", " gzip "}});
+  expectServed(*gzip_again, "gzipped", "0");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            gzip_again->filter_.decodeHeaders(gzip_again->headers_, true));
+  gzip_again->filter_.onDestroy();
+  auto identity_again = request();
+  expectServed(*identity_again, "plain", "0");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            identity_again->filter_.decodeHeaders(identity_again->headers_, true));
+  EXPECT_EQ(2U, counter("hit"));
+  EXPECT_EQ(2U, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, Revalidate) {
+  auto first = request();
+  fetch(*first, {{":status", "200"}, {"cache-control", "max-age=10"}, {"etag", "\"v1\""}},
+        "hello");
+
+  time_system_.sleep(std::chrono::seconds(20));
+  auto second = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.decodeHeaders(second->headers_, true));
+  EXPECT_EQ("\"v1\"", second->headers_.get_("if-none-match"));
+
+  // The 304 response is replaced by the cached one, freshened with the new headers.
+  Http::TestHeaderMapImpl not_modified{{":status", "304"},
+                                       {"cache-control", "max-age=30"},
+                                       {"etag", "\"v1\""},
+                                       {"set-cookie", "id=2"}};
+  Buffer::OwnedImpl body;
+  EXPECT_CALL(second->encoder_callbacks_, addEncodedData(_, false))
+      .WillOnce(Invoke([&body](Buffer::Instance& data, bool) { body.move(data); }));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.encodeHeaders(not_modified, true));
+  second->filter_.onDestroy();
+  EXPECT_EQ("200", not_modified.get_(":status"));
+  EXPECT_EQ("max-age=30", not_modified.get_("cache-control"));
+  EXPECT_EQ("0", not_modified.get_("age"));
+  // The cookie is passed on to this request, but not stored.
+  EXPECT_EQ("id=2", not_modified.get_("set-cookie"));
+  EXPECT_EQ(nullptr, store_->lookup("host/a", Http::TestHeaderMapImpl{})
+                         ->headers_->get(Http::Headers::get().SetCookie));
+  EXPECT_EQ("hello", body.toString());
+  EXPECT_EQ(1U, counter("validated"));
+  EXPECT_EQ(5U, counter("bytes_served"));
+
+  time_system_.sleep(std::chrono::seconds(20));
+  auto third = request();
+  expectServed(*third, "hello", "20");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            third->filter_.decodeHeaders(third->headers_, true));
+}
+
+TEST_F(CacheFilterTest, RevalidateWithBody) {
+  auto first = request();
+  fetch(*first, {{":status", "200"}, {"cache-control", "no-cache"}, {"etag", "\"v1\""}}, "hello");
+
+  auto second = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.decodeHeaders(second->headers_, true));
+  Http::TestHeaderMapImpl not_modified{{":status", "304"}, {"etag", "\"v1\""}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.encodeHeaders(not_modified, false));
+  // Any body of the 304 response is replaced by the cached one.
+  Buffer::OwnedImpl data("ignored");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, second->filter_.encodeData(data, true));
+  EXPECT_EQ("hello", data.toString());
+}
+
+TEST_F(CacheFilterTest, RevalidateChanged) {
+  auto first = request();
+  fetch(*first, {{":status", "200"}, {"last-modified", "Sun, 06 Nov 1994 08:49:37 GMT"}},
+        "hello");
+
+  auto second = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.decodeHeaders(second->headers_, true));
+  EXPECT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", second->headers_.get_("if-modified-since"));
+  Http::TestHeaderMapImpl changed{{":status", "200"}, {"cache-control", "max-age=60"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, second->filter_.encodeHeaders(changed, false));
+  Buffer::OwnedImpl data("world");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, second->filter_.encodeData(data, true));
+  EXPECT_EQ("world", data.toString());
+  EXPECT_EQ(0U, counter("validated"));
+  EXPECT_EQ("world", store_->lookup("host/a", Http::TestHeaderMapImpl{})->body());
+}
+
+TEST_F(CacheFilterTest, CoalesceRequests) {
+  auto leader = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.decodeHeaders(leader->headers_, true));
+  auto follower1 = request();
+  auto follower2 = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower1->filter_.decodeHeaders(follower1->headers_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower2->filter_.decodeHeaders(follower2->headers_, true));
+  EXPECT_EQ(2U, counter("coalesced"));
+
+  // A follower which goes away is no longer served.
+  follower2->filter_.onDestroy();
+  EXPECT_CALL(follower2->decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+
+  expectServed(*follower1, "hello", "0");
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"cache-control", "max-age=60"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.encodeHeaders(response_headers, false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, leader->filter_.encodeData(data, true));
+  leader->filter_.onDestroy();
+  follower1->filter_.onDestroy();
+  EXPECT_EQ(3U, counter("miss"));
+  EXPECT_EQ(1U, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, CoalescedRequestsContinueWithoutResponse) {
+  auto leader = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.decodeHeaders(leader->headers_, true));
+  auto follower = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            follower->filter_.decodeHeaders(follower->headers_, true));
+
+  // The leader goes away before its response is cached, so the follower goes to the upstream.
+  EXPECT_CALL(follower->decoder_callbacks_, continueDecoding());
+  leader->filter_.onDestroy();
+
+  // The next request fetches the response again.
+  auto next = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, next->filter_.decodeHeaders(next->headers_, true));
+  follower->filter_.onDestroy();
+  next->filter_.onDestroy();
+}
+
+TEST_F(CacheFilterTest, NoCoalescing) {
+  setUpConfig("{ in_memory: {}, coalesce_requests: false }");
+  auto first = request();
+  auto second = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            first->filter_.decodeHeaders(first->headers_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            second->filter_.decodeHeaders(second->headers_, true));
+  EXPECT_EQ(0U, counter("coalesced"));
+}
+
+TEST_F(CacheFilterTest, Trailers) {
+  auto first = request();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            first->filter_.decodeHeaders(first->headers_, true));
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"cache-control", "max-age=60"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            first->filter_.encodeHeaders(response_headers, false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, first->filter_.encodeData(data, false));
+  Http::TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, first->filter_.encodeTrailers(trailers));
+  EXPECT_EQ(nullptr, store_->lookup("host/a", Http::TestHeaderMapImpl{}));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
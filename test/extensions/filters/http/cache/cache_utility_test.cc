@@ -0,0 +1,145 @@
+#include "common/http/header_map_impl.h"
+
+#include "extensions/filters/http/cache/cache_utility.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+CachedResponse cachedResponse(Http::TestHeaderMapImpl&& headers, SystemTime response_time) {
+  CachedResponse response;
+  response.headers_ = std::make_unique<Http::TestHeaderMapImpl>(headers);
+  response.response_time_ = response_time;
+  return response;
+}
+
+TEST(CacheUtilityTest, RequestCacheControl) {
+  EXPECT_FALSE(Utility::requestCacheControl(Http::TestHeaderMapImpl{}).must_validate_);
+  EXPECT_TRUE(
+      Utility::requestCacheControl(Http::TestHeaderMapImpl{{"cache-control", "no-store"}})
+          .no_store_);
+  EXPECT_TRUE(
+      Utility::requestCacheControl(Http::TestHeaderMapImpl{{"cache-control", "No-Cache"}})
+          .must_validate_);
+  EXPECT_TRUE(
+      Utility::requestCacheControl(Http::TestHeaderMapImpl{{"cache-control", "x, max-age=0"}})
+          .must_validate_);
+  EXPECT_FALSE(
+      Utility::requestCacheControl(Http::TestHeaderMapImpl{{"cache-control", "max-age=10"}})
+          .must_validate_);
+  EXPECT_TRUE(Utility::requestCacheControl(Http::TestHeaderMapImpl{{"pragma", "no-cache"}})
+                  .must_validate_);
+  // Pragma is ignored when there is a cache-control header.
+  EXPECT_FALSE(Utility::requestCacheControl(
+                   Http::TestHeaderMapImpl{{"pragma", "no-cache"}, {"cache-control", "max-age=1"}})
+                   .must_validate_);
+}
+
+TEST(CacheUtilityTest, IsCacheableResponse) {
+  EXPECT_TRUE(Utility::isCacheableResponse(
+      Http::TestHeaderMapImpl{{":status", "200"}, {"cache-control", "public, max-age=60"}}));
+  EXPECT_TRUE(Utility::isCacheableResponse(
+      Http::TestHeaderMapImpl{{":status", "404"}, {"expires", "Thu, 01 Jan 2037 00:00:00 GMT"}}));
+  EXPECT_TRUE(
+      Utility::isCacheableResponse(Http::TestHeaderMapImpl{{":status", "200"}, {"etag", "\"a\""}}));
+  // Nothing says how long the response is fresh for, and it can not be revalidated.
+  EXPECT_FALSE(Utility::isCacheableResponse(Http::TestHeaderMapImpl{{":status", "200"}}));
+  EXPECT_FALSE(Utility::isCacheableResponse(
+      Http::TestHeaderMapImpl{{":status", "500"}, {"cache-control", "max-age=60"}}));
+  EXPECT_FALSE(Utility::isCacheableResponse(
+      Http::TestHeaderMapImpl{{":status", "200"}, {"cache-control", "no-store, max-age=60"}}));
+  EXPECT_FALSE(Utility::isCacheableResponse(
+      Http::TestHeaderMapImpl{{":status", "200"}, {"cache-control", "private, max-age=60"}}));
+  EXPECT_FALSE(Utility::isCacheableResponse(Http::TestHeaderMapImpl{
+      {":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "accept, *"}}));
+  EXPECT_FALSE(Utility::isCacheableResponse(Http::TestHeaderMapImpl{
+      {":status", "200"}, {"cache-control", "public, max-age=60"}, {"set-cookie", "id=1"}}));
+}
+
+TEST(CacheUtilityTest, Freshness) {
+  const SystemTime now = SystemTime(std::chrono::hours(24 * 365 * 30));
+  const SystemTime received = now - std::chrono::seconds(30);
+
+  EXPECT_TRUE(Utility::isFresh(
+      cachedResponse({{":status", "200"}, {"cache-control", "max-age=60"}}, received), now));
+  EXPECT_FALSE(Utility::isFresh(
+      cachedResponse({{":status", "200"}, {"cache-control", "max-age=20"}}, received), now));
+  // s-maxage takes precedence for a shared cache.
+  EXPECT_FALSE(Utility::isFresh(
+      cachedResponse({{":status", "200"}, {"cache-control", "max-age=60, s-maxage=20"}}, received),
+      now));
+  // The age the response had when it was received counts.
+  EXPECT_FALSE(Utility::isFresh(
+      cachedResponse({{":status", "200"}, {"cache-control", "max-age=60"}, {"age", "40"}},
+                     received),
+      now));
+  EXPECT_EQ(std::chrono::seconds(70),
+            Utility::age(cachedResponse({{":status", "200"}, {"age", "40"}}, received), now));
+  EXPECT_FALSE(Utility::isFresh(
+      cachedResponse({{":status", "200"}, {"cache-control", "no-cache, max-age=60"}}, received),
+      now));
+  EXPECT_FALSE(Utility::isFresh(cachedResponse({{":status", "200"}, {"etag", "\"a\""}}, received),
+                                now));
+}
+
+TEST(CacheUtilityTest, FreshnessFromExpires) {
+  const SystemTime date = Utility::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT").value();
+  Http::TestHeaderMapImpl headers{{":status", "200"},
+                                  {"date", "Sun, 06 Nov 1994 08:49:37 GMT"},
+                                  {"expires", "Sun, 06 Nov 1994 08:50:37 GMT"}};
+  EXPECT_TRUE(
+      Utility::isFresh(cachedResponse(std::move(headers), date), date + std::chrono::seconds(59)));
+  EXPECT_FALSE(Utility::isFresh(
+      cachedResponse({{":status", "200"},
+                      {"date", "Sun, 06 Nov 1994 08:49:37 GMT"},
+                      {"expires", "Sun, 06 Nov 1994 08:50:37 GMT"}},
+                     date),
+      date + std::chrono::seconds(60)));
+  // An invalid date means the response has already expired.
+  EXPECT_FALSE(
+      Utility::isFresh(cachedResponse({{":status", "200"}, {"expires", "0"}}, date), date));
+}
+
+TEST(CacheUtilityTest, ParseHttpDate) {
+  const absl::optional<SystemTime> time = Utility::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT");
+  ASSERT_TRUE(time.has_value());
+  EXPECT_EQ(784111777, std::chrono::duration_cast<std::chrono::seconds>(
+                           time.value().time_since_epoch())
+                           .count());
+  EXPECT_FALSE(Utility::parseHttpDate("yesterday").has_value());
+}
+
+TEST(CacheUtilityTest, VaryKey) {
+  Http::TestHeaderMapImpl request{{"accept-encoding", "gzip"}, {"accept-language", "en"}};
+  EXPECT_EQ("", Utility::varyKey(Http::TestHeaderMapImpl{{":status", "200"}}, request));
+  EXPECT_EQ("gzip\nen\n\n",
+            Utility::varyKey(Http::TestHeaderMapImpl{
+                                 {"vary", "Accept-Encoding, accept-language, user-agent"}},
+                             request));
+}
+
+TEST(CacheUtilityTest, VaryMatches) {
+  CachedResponse response;
+  response.headers_ = std::make_unique<Http::TestHeaderMapImpl>(
+      Http::TestHeaderMapImpl{{":status", "200"}, {"vary", "accept-encoding"}});
+  response.vary_key_ =
+      Utility::varyKey(*response.headers_, Http::TestHeaderMapImpl{{"accept-encoding", "gzip,br"}});
+  EXPECT_EQ("gzip,br\n", response.vary_key_);
+
+  EXPECT_TRUE(
+      Utility::varyMatches(response, Http::TestHeaderMapImpl{{"accept-encoding", " gzip , br"}}));
+  EXPECT_FALSE(Utility::varyMatches(response, Http::TestHeaderMapImpl{{"accept-encoding", "br"}}));
+  EXPECT_FALSE(Utility::varyMatches(response, Http::TestHeaderMapImpl{}));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
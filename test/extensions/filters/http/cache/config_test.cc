@@ -0,0 +1,63 @@
+#include "envoy/config/filter/http/cache/v2alpha/cache.pb.validate.h"
+
+#include "extensions/filters/http/cache/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+TEST(CacheFilterFactoryTest, InMemory) {
+  envoy::config::filter::http::cache::v2alpha::Cache config;
+  TestUtility::loadFromYaml("{ in_memory: { max_bytes: 1048576, shards: 4 } }", config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  CacheFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(CacheFilterFactoryTest, File) {
+  envoy::config::filter::http::cache::v2alpha::Cache config;
+  TestUtility::loadFromYaml(
+      absl::StrCat("{ file: { path: \"", TestEnvironment::temporaryPath("cache_config_test"),
+                   "\", max_bytes: 65536 }, coalesce_requests: false }"),
+      config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  CacheFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(CacheFilterFactoryTest, Validation) {
+  envoy::config::filter::http::cache::v2alpha::Cache config;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  CacheFilterFactory factory;
+  // A store is required.
+  EXPECT_THROW(factory.createFilterFactoryFromProto(config, "stats", context),
+               ProtoValidationException);
+  TestUtility::loadFromYaml("{ in_memory: { shards: 0 } }", config);
+  EXPECT_THROW(factory.createFilterFactoryFromProto(config, "stats", context),
+               ProtoValidationException);
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
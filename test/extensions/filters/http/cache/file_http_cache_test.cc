@@ -0,0 +1,156 @@
+#include "envoy/common/exception.h"
+
+#include "common/http/header_map_impl.h"
+
+#include "extensions/filters/http/cache/file_http_cache.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+class FileHttpCacheTest : public testing::Test {
+protected:
+  FileHttpCacheTest() : path_(TestEnvironment::temporaryPath("file_http_cache_test")) {
+    ::unlink(path_.c_str());
+  }
+  ~FileHttpCacheTest() override {
+    ::unlink(path_.c_str());
+    ::unlink((path_ + ".new").c_str());
+  }
+
+  static CachedResponseSharedPtr makeResponse(const std::string& body,
+                                              const std::string& encoding = "gzip") {
+    auto response = std::make_shared<CachedResponse>();
+    response->headers_ = std::make_unique<Http::TestHeaderMapImpl>(Http::TestHeaderMapImpl{
+        {":status", "200"}, {"etag", "\"v1\""}, {"vary", "accept-encoding"}});
+    response->body_ = body;
+    response->vary_key_ = encoding + "\n";
+    response->response_time_ = SystemTime(std::chrono::seconds(1234567));
+    return response;
+  }
+
+  const std::string path_;
+  const Http::TestHeaderMapImpl gzip_{{"accept-encoding", "gzip"}};
+};
+
+TEST_F(FileHttpCacheTest, LookupAndInsert) {
+  FileHttpCache cache(path_, 65536);
+  EXPECT_EQ(nullptr, cache.lookup("a", gzip_));
+
+  cache.insert("a", makeResponse("body a"));
+  const CachedResponseSharedPtr response = cache.lookup("a", gzip_);
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ("body a", response->body());
+  EXPECT_EQ("gzip\n", response->vary_key_);
+  EXPECT_EQ(SystemTime(std::chrono::seconds(1234567)), response->response_time_);
+  EXPECT_EQ(Http::TestHeaderMapImpl(
+                {{":status", "200"}, {"etag", "\"v1\""}, {"vary", "accept-encoding"}}),
+            *response->headers_);
+
+  // A newer response replaces the older one.
+  cache.insert("a", makeResponse("BODY A"));
+  EXPECT_EQ("BODY A", cache.lookup("a", gzip_)->body());
+}
+
+// The responses are shared with the other instances mapping the file, such as the ones of a
+// hot restarted process, and survive the instance which cached them.
+TEST_F(FileHttpCacheTest, SharedBetweenInstances) {
+  auto first = std::make_unique<FileHttpCache>(path_, 65536);
+  FileHttpCache second(path_, 65536);
+
+  first->insert("a", makeResponse("body a"));
+  ASSERT_NE(nullptr, second.lookup("a", gzip_));
+  EXPECT_EQ("body a", second.lookup("a", gzip_)->body());
+  second.insert("b", makeResponse("body b"));
+  EXPECT_EQ("body b", first->lookup("b", gzip_)->body());
+
+  first.reset();
+  FileHttpCache third(path_, 65536);
+  EXPECT_EQ("body a", third.lookup("a", gzip_)->body());
+  EXPECT_EQ("body b", third.lookup("b", gzip_)->body());
+}
+
+TEST_F(FileHttpCacheTest, ReplacedWhenFull) {
+  FileHttpCache cache(path_, 65536);
+  FileHttpCache other(path_, 65536);
+  cache.insert("a", makeResponse(std::string(40000, 'a')));
+  EXPECT_NE(nullptr, other.lookup("a", gzip_));
+
+  // There is no room left for "b", so the file is replaced before "b" is written.
+  cache.insert("b", makeResponse(std::string(40000, 'b')));
+  EXPECT_EQ(nullptr, cache.lookup("a", gzip_));
+  EXPECT_NE(nullptr, cache.lookup("b", gzip_));
+  EXPECT_EQ(nullptr, other.lookup("a", gzip_));
+  EXPECT_EQ(std::string(40000, 'b'), other.lookup("b", gzip_)->body());
+
+  // A response which does not fit in the file is not cached.
+  cache.insert("c", makeResponse(std::string(65536, 'c')));
+  EXPECT_EQ(nullptr, cache.lookup("c", gzip_));
+  EXPECT_NE(nullptr, cache.lookup("b", gzip_));
+}
+
+// The variants of a response are cached side by side, and replaced by the variant with the same
+// vary key.
+TEST_F(FileHttpCacheTest, Variants) {
+  FileHttpCache cache(path_, 65536);
+  const Http::TestHeaderMapImpl br{{"accept-encoding", "br"}};
+  cache.insert("a", makeResponse("gzip", "gzip"));
+  cache.insert("a", makeResponse("br", "br"));
+  EXPECT_EQ("gzip", cache.lookup("a", gzip_)->body());
+  EXPECT_EQ("br", cache.lookup("a", br)->body());
+  EXPECT_EQ(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+
+  cache.insert("a", makeResponse("GZIP", "gzip"));
+  EXPECT_EQ("GZIP", cache.lookup("a", gzip_)->body());
+  EXPECT_EQ("br", cache.lookup("a", br)->body());
+
+  // Another instance indexes the same variants.
+  FileHttpCache other(path_, 65536);
+  EXPECT_EQ("GZIP", other.lookup("a", gzip_)->body());
+  EXPECT_EQ("br", other.lookup("a", br)->body());
+}
+
+// The body of a response is served from the mapping of the file, which stays valid after the file
+// is replaced.
+TEST_F(FileHttpCacheTest, BodyOutlivesReplacedFile) {
+  FileHttpCache cache(path_, 65536);
+  cache.insert("a", makeResponse(std::string(40000, 'a')));
+  const CachedResponseSharedPtr response = cache.lookup("a", gzip_);
+  ASSERT_NE(nullptr, response);
+  EXPECT_TRUE(response->body_.empty());
+  EXPECT_NE(nullptr, response->body_owner_);
+
+  cache.insert("b", makeResponse(std::string(40000, 'b')));
+  EXPECT_EQ(nullptr, cache.lookup("a", gzip_));
+  EXPECT_EQ(std::string(40000, 'a'), response->body());
+}
+
+TEST_F(FileHttpCacheTest, Resized) {
+  {
+    FileHttpCache cache(path_, 65536);
+    cache.insert("a", makeResponse("body a"));
+  }
+  // A file of another size is replaced by an empty one.
+  FileHttpCache cache(path_, 2 * 65536);
+  EXPECT_EQ(nullptr, cache.lookup("a", gzip_));
+  cache.insert("a", makeResponse("body a"));
+  EXPECT_EQ("body a", cache.lookup("a", gzip_)->body());
+}
+
+TEST_F(FileHttpCacheTest, BadPath) {
+  EXPECT_THROW_WITH_REGEX(FileHttpCache("/nonexistent/dir/cache", 65536), EnvoyException,
+                          "cannot open cache file /nonexistent/dir/cache");
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,109 @@
+#include "common/http/header_map_impl.h"
+
+#include "extensions/filters/http/cache/in_memory_http_cache.h"
+
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+CachedResponseSharedPtr makeResponse(const std::string& body) {
+  auto response = std::make_shared<CachedResponse>();
+  response->headers_ = std::make_unique<Http::TestHeaderMapImpl>(
+      Http::TestHeaderMapImpl{{":status", "200"}, {"cache-control", "max-age=60"}});
+  response->body_ = body;
+  return response;
+}
+
+// Makes a variant of a response which varies on accept-encoding.
+CachedResponseSharedPtr makeResponse(const std::string& body, const std::string& encoding) {
+  auto response = std::make_shared<CachedResponse>();
+  response->headers_ = std::make_unique<Http::TestHeaderMapImpl>(Http::TestHeaderMapImpl{
+      {":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "accept-encoding"}});
+  response->body_ = body;
+  response->vary_key_ = encoding + "\n";
+  return response;
+}
+
+TEST(InMemoryHttpCacheTest, LookupAndInsert) {
+  InMemoryHttpCache cache(1024 * 1024, 4);
+  EXPECT_EQ(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+
+  cache.insert("a", makeResponse("body a"));
+  cache.insert("b", makeResponse("body b"));
+  ASSERT_NE(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+  EXPECT_EQ("body a", cache.lookup("a", Http::TestHeaderMapImpl{})->body());
+  EXPECT_EQ("body b", cache.lookup("b", Http::TestHeaderMapImpl{})->body());
+
+  // Inserting a key again replaces its response.
+  const uint64_t bytes = cache.bytes();
+  cache.insert("a", makeResponse("BODY A"));
+  EXPECT_EQ("BODY A", cache.lookup("a", Http::TestHeaderMapImpl{})->body());
+  EXPECT_EQ(bytes, cache.bytes());
+}
+
+// The variants of a response are cached side by side, and replaced by the variant with the same
+// vary key.
+TEST(InMemoryHttpCacheTest, Variants) {
+  InMemoryHttpCache cache(1024 * 1024, 1);
+  const Http::TestHeaderMapImpl gzip{{"accept-encoding", "gzip"}};
+  const Http::TestHeaderMapImpl br{{"accept-encoding", "br"}};
+  cache.insert("a", makeResponse("gzip", "gzip"));
+  cache.insert("a", makeResponse("br", "br"));
+  EXPECT_EQ("gzip", cache.lookup("a", gzip)->body());
+  EXPECT_EQ("br", cache.lookup("a", br)->body());
+  EXPECT_EQ(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+
+  cache.insert("a", makeResponse("GZIP", "gzip"));
+  EXPECT_EQ("GZIP", cache.lookup("a", gzip)->body());
+  EXPECT_EQ("br", cache.lookup("a", br)->body());
+
+  // The least recently stored variants are dropped beyond MaxVariantsPerKey.
+  for (uint32_t i = 0; i < MaxVariantsPerKey; i++) {
+    cache.insert("a", makeResponse("other", absl::StrCat("coding", i)));
+  }
+  EXPECT_EQ(nullptr, cache.lookup("a", gzip));
+  EXPECT_EQ(nullptr, cache.lookup("a", br));
+  EXPECT_NE(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{{"accept-encoding", "coding0"}}));
+}
+
+TEST(InMemoryHttpCacheTest, EvictLeastRecentlyUsed) {
+  const uint64_t entry_bytes = 1 + makeResponse("")->headers_->byteSizeInternal() + 100;
+  InMemoryHttpCache cache(2 * entry_bytes, 1);
+
+  cache.insert("a", makeResponse(std::string(100, 'a')));
+  cache.insert("b", makeResponse(std::string(100, 'b')));
+  EXPECT_EQ(2 * entry_bytes, cache.bytes());
+
+  // "a" is used more recently than "b", so "b" is evicted.
+  EXPECT_NE(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+  cache.insert("c", makeResponse(std::string(100, 'c')));
+  EXPECT_NE(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+  EXPECT_EQ(nullptr, cache.lookup("b", Http::TestHeaderMapImpl{}));
+  EXPECT_NE(nullptr, cache.lookup("c", Http::TestHeaderMapImpl{}));
+  EXPECT_EQ(2 * entry_bytes, cache.bytes());
+}
+
+TEST(InMemoryHttpCacheTest, TooLarge) {
+  InMemoryHttpCache cache(200, 1);
+  cache.insert("a", makeResponse("a"));
+  ASSERT_NE(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+
+  // A response larger than the shard is not cached, and it removes the response it replaces.
+  cache.insert("a", makeResponse(std::string(200, 'a')));
+  EXPECT_EQ(nullptr, cache.lookup("a", Http::TestHeaderMapImpl{}));
+  EXPECT_EQ(0, cache.bytes());
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,146 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/common/compressor/compressor.h"
+
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+namespace {
+
+/**
+ * Prefixes the data of each call with the content-coding, so that tests can tell which coding
+ * compressed a response.
+ */
+class TestCompressor : public Envoy::Compressor::Compressor {
+public:
+  TestCompressor(const std::string& encoding) : encoding_(encoding) {}
+
+  // Compressor::Compressor
+  void compress(Buffer::Instance& buffer, Envoy::Compressor::State) override {
+    buffer.prepend(encoding_ + ":");
+  }
+
+private:
+  const std::string encoding_;
+};
+
+class TestCompressorFactory : public Envoy::Compressor::CompressorFactory {
+public:
+  TestCompressorFactory(const std::string& encoding) : encoding_(encoding) {}
+
+  // Compressor::CompressorFactory
+  Envoy::Compressor::CompressorPtr createCompressor() override {
+    return std::make_unique<TestCompressor>(encoding_);
+  }
+  const std::string& contentEncoding() const override { return encoding_; }
+
+private:
+  const std::string encoding_;
+};
+
+// Offers "br" in preference to "gzip".
+class TestCompressorFilterConfig : public CompressorFilterConfig {
+public:
+  TestCompressorFilterConfig(Stats::Scope& scope, Runtime::Loader& runtime)
+      : CompressorFilterConfig("test.", scope, runtime, "test.filter_enabled", 0,
+                               Protobuf::RepeatedPtrField<std::string>(), false, false) {
+    addCompressorFactory(std::make_unique<TestCompressorFactory>("br"));
+    addCompressorFactory(std::make_unique<TestCompressorFactory>("gzip"));
+  }
+};
+
+class CompressorFilterTest : public testing::Test {
+protected:
+  CompressorFilterTest()
+      : config_(std::make_shared<TestCompressorFilterConfig>(stats_, runtime_)),
+        filter_(config_) {
+    ON_CALL(runtime_.snapshot_, featureEnabled("test.filter_enabled", 100))
+        .WillByDefault(Return(true));
+  }
+
+  // Returns the content-encoding of the response to a request with the given accept-encoding.
+  std::string negotiate(const std::string& accept_encoding) {
+    Http::TestHeaderMapImpl request_headers{{":method", "get"},
+                                            {"accept-encoding", accept_encoding}};
+    filter_.decodeHeaders(request_headers, true);
+    Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-length", "256"}};
+    filter_.encodeHeaders(response_headers, false);
+    Buffer::OwnedImpl data("data");
+    filter_.encodeData(data, true);
+    const std::string encoding = response_headers.get_("content-encoding");
+    EXPECT_EQ(encoding.empty() ? "data" : encoding + ":data", data.toString());
+    return encoding;
+  }
+
+  Stats::IsolatedStoreImpl stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  CompressorFilterConfigSharedPtr config_;
+  CompressorFilter filter_;
+};
+
+// The coding with the highest q-value is used.
+TEST_F(CompressorFilterTest, HighestQValue) {
+  EXPECT_EQ("gzip", negotiate("br;q=0.5, gzip;q=0.8"));
+  EXPECT_EQ(1, stats_.counter("test.header_gzip").value());
+  EXPECT_EQ(0, stats_.counter("test.header_br").value());
+}
+
+// Codings with the same q-value are chosen in the order of server preference.
+TEST_F(CompressorFilterTest, ServerPreferenceOnTies) {
+  EXPECT_EQ("br", negotiate("gzip, deflate, br"));
+  EXPECT_EQ(1, stats_.counter("test.header_br").value());
+}
+
+// Coding names and q parameters are case-insensitive.
+TEST_F(CompressorFilterTest, CaseInsensitive) {
+  EXPECT_EQ("gzip", negotiate("BR;Q=0.1, GZip"));
+  EXPECT_EQ(1, stats_.counter("test.header_gzip").value());
+}
+
+// The wildcard applies to the codings which are not named.
+TEST_F(CompressorFilterTest, Wildcard) {
+  EXPECT_EQ("gzip", negotiate("br;q=0, *"));
+  EXPECT_EQ(1, stats_.counter("test.header_wildcard").value());
+}
+
+// A malformed q-value is treated as 1.
+TEST_F(CompressorFilterTest, MalformedQValue) {
+  EXPECT_EQ("gzip", negotiate("br;q=0.5, gzip;q=high"));
+}
+
+// Identity wins when it is preferred over every configured coding.
+TEST_F(CompressorFilterTest, IdentityPreferred) {
+  EXPECT_EQ("", negotiate("identity;q=0.9, gzip;q=0.5, br;q=0.5"));
+  EXPECT_EQ(1, stats_.counter("test.header_identity").value());
+  EXPECT_EQ(1, stats_.counter("test.not_compressed").value());
+}
+
+// Identity does not win ties against configured codings.
+TEST_F(CompressorFilterTest, IdentityTie) {
+  EXPECT_EQ("br", negotiate("identity, br"));
+  EXPECT_EQ(0, stats_.counter("test.header_identity").value());
+}
+
+// None of the codings is acceptable.
+TEST_F(CompressorFilterTest, NotAcceptable) {
+  EXPECT_EQ("", negotiate("deflate, gzip;q=0, br;q=0.000"));
+  EXPECT_EQ(1, stats_.counter("test.header_not_valid").value());
+}
+
+} // namespace
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,70 @@
+#include "extensions/filters/http/common/compressor/response_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Common {
+namespace Compressors {
+namespace {
+
+CompressedBodySharedPtr body(const std::string& value) {
+  return std::make_shared<const std::string>(value);
+}
+
+TEST(CompressedResponseCacheTest, LookupAndInsert) {
+  CompressedResponseCache cache(100);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+
+  EXPECT_EQ(0, cache.insert("a", body("0123456789")));
+  ASSERT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ("0123456789", *cache.lookup("a"));
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(11U, cache.bytes());
+
+  // Inserting a key again replaces its body.
+  EXPECT_EQ(0, cache.insert("a", body("01234")));
+  EXPECT_EQ("01234", *cache.lookup("a"));
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(6U, cache.bytes());
+}
+
+// The least recently used bodies are evicted first.
+TEST(CompressedResponseCacheTest, EvictLeastRecentlyUsed) {
+  CompressedResponseCache cache(30);
+  EXPECT_EQ(0, cache.insert("a", body("012345678")));
+  EXPECT_EQ(0, cache.insert("b", body("012345678")));
+  EXPECT_EQ(0, cache.insert("c", body("012345678")));
+  EXPECT_EQ(30U, cache.bytes());
+
+  CompressedBodySharedPtr a = cache.lookup("a");
+  EXPECT_EQ(2, cache.insert("d", body("0123456789012345678")));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_EQ(nullptr, cache.lookup("c"));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_NE(nullptr, cache.lookup("d"));
+  EXPECT_EQ(30U, cache.bytes());
+
+  // Evicted bodies stay valid while they are used.
+  EXPECT_EQ(1, cache.insert("e", body("012345678")));
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  EXPECT_EQ("012345678", *a);
+}
+
+// Bodies larger than the cache are not cached, and do not evict others.
+TEST(CompressedResponseCacheTest, BodyLargerThanCache) {
+  CompressedResponseCache cache(10);
+  EXPECT_EQ(0, cache.insert("a", body("01234")));
+  EXPECT_EQ(0, cache.insert("b", body("0123456789")));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(6U, cache.bytes());
+}
+
+} // namespace
+} // namespace Compressors
+} // namespace Common
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
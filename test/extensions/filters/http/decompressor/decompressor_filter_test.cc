@@ -0,0 +1,309 @@
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/decompressor/decompressor_filter.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+namespace {
+
+class DecompressorFilterTest : public testing::Test {
+protected:
+  DecompressorFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("decompressor.filter_enabled", 100))
+        .WillByDefault(Return(true));
+    setUpFilter("{}");
+  }
+
+  void setUpFilter(const std::string& yaml) {
+    envoy::config::filter::http::decompressor::v2alpha::Decompressor decompressor;
+    TestUtility::loadFromYaml(yaml, decompressor);
+    config_ = std::make_shared<DecompressorFilterConfig>(decompressor, "test.", stats_, runtime_);
+    filter_ = std::make_unique<DecompressorFilter>(config_);
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  static std::string gzip(const std::string& data) {
+    Compressor::ZlibCompressorImpl compressor;
+    compressor.init(Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                    Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 31, 8);
+    Buffer::OwnedImpl buffer(data);
+    compressor.compress(buffer, Compressor::State::Finish);
+    return buffer.toString();
+  }
+
+  // Feeds a body to decodeData() in pieces, and returns the data passed on.
+  std::string decodeBody(const std::string& body, size_t piece_size) {
+    std::string decoded;
+    for (size_t offset = 0; offset < body.size(); offset += piece_size) {
+      Buffer::OwnedImpl data(body.substr(offset, piece_size));
+      EXPECT_EQ(Http::FilterDataStatus::Continue,
+                filter_->decodeData(data, offset + piece_size >= body.size()));
+      decoded += data.toString();
+    }
+    return decoded;
+  }
+
+  static std::string jsonBody(int entries) {
+    std::string body;
+    for (int i = 0; i < entries; i++) {
+      body += "{\"id\":" + std::to_string(i) + ",\"name\":\"envoy\"},";
+    }
+    return body;
+  }
+
+  Stats::IsolatedStoreImpl stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  DecompressorFilterConfigSharedPtr config_;
+  std::unique_ptr<DecompressorFilter> filter_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+TEST_F(DecompressorFilterTest, DefaultConfigValues) {
+  EXPECT_EQ(31, config_->windowBits());
+  EXPECT_EQ(4096, config_->chunkSize());
+  EXPECT_EQ(100, config_->maxDecompressionRatio());
+  EXPECT_TRUE(config_->decompressRequests());
+  EXPECT_FALSE(config_->decompressResponses());
+}
+
+// A gzip encoded request body is decompressed incrementally.
+TEST_F(DecompressorFilterTest, DecompressRequest) {
+  const std::string body = jsonBody(1000);
+  const std::string compressed = gzip(body);
+
+  Http::TestHeaderMapImpl headers{{":method", "post"},
+                                  {"content-encoding", "gzip"},
+                                  {"content-length", std::to_string(compressed.size())}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_FALSE(headers.has("content-encoding"));
+  EXPECT_FALSE(headers.has("content-length"));
+
+  EXPECT_EQ(body, decodeBody(compressed, 100));
+  EXPECT_EQ(1, stats_.counter("test.decompressor.request_decompressed").value());
+  EXPECT_EQ(compressed.size(), stats_.counter("test.decompressor.total_compressed_bytes").value());
+  EXPECT_EQ(body.size(), stats_.counter("test.decompressor.total_decompressed_bytes").value());
+}
+
+// A frame which decompresses past the buffer limit is passed on in steps, with reading from the
+// client disabled until the last one.
+TEST_F(DecompressorFilterTest, RequestPastBufferLimit) {
+  const uint32_t buffer_limit = 16 * 1024;
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(buffer_limit));
+  const std::string body = jsonBody(20000);
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  std::string decoded;
+  bool end_stream = false;
+  EXPECT_CALL(decoder_callbacks_, injectDecodedDataToFilterChain(_, _))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data, bool end) -> void {
+        // A step decompresses at most a chunk past the limit.
+        EXPECT_GE(buffer_limit + 4096 * config_->maxDecompressionRatio(), data.length());
+        decoded += data.toString();
+        data.drain(data.length());
+        end_stream = end;
+      }));
+  auto* drain_timer = new NiceMock<Event::MockTimer>(&decoder_callbacks_.dispatcher_);
+  EXPECT_CALL(decoder_callbacks_, onDecoderFilterAboveWriteBufferHighWatermark());
+  Buffer::OwnedImpl data(gzip(body));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+  EXPECT_EQ(0, data.length());
+
+  EXPECT_CALL(decoder_callbacks_, onDecoderFilterBelowWriteBufferLowWatermark());
+  int steps = 0;
+  while (drain_timer->enabled_) {
+    drain_timer->invokeCallback();
+    steps++;
+  }
+  EXPECT_LT(1, steps);
+  EXPECT_EQ(body, decoded);
+  EXPECT_TRUE(end_stream);
+}
+
+// Trailers which arrive while the body is passed on in steps are held back until the last one.
+TEST_F(DecompressorFilterTest, RequestTrailersPastBufferLimit) {
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(16 * 1024));
+  const std::string body = jsonBody(20000);
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  std::string decoded;
+  EXPECT_CALL(decoder_callbacks_, injectDecodedDataToFilterChain(_, false))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data, bool) -> void {
+        decoded += data.toString();
+        data.drain(data.length());
+      }));
+  auto* drain_timer = new NiceMock<Event::MockTimer>(&decoder_callbacks_.dispatcher_);
+  Buffer::OwnedImpl data(gzip(body));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+  Http::TestHeaderMapImpl trailers{{"x-trailer", "1"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_->decodeTrailers(trailers));
+
+  EXPECT_CALL(decoder_callbacks_, continueDecoding()).Times(0);
+  drain_timer->invokeCallback();
+  EXPECT_CALL(decoder_callbacks_, continueDecoding());
+  while (drain_timer->enabled_) {
+    drain_timer->invokeCallback();
+  }
+  EXPECT_EQ(body, decoded);
+}
+
+// A body which ends before the end of its gzip stream resets the stream.
+TEST_F(DecompressorFilterTest, TruncatedRequestBody) {
+  const std::string compressed = gzip(jsonBody(100));
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data(compressed.substr(0, compressed.size() - 4));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data, false));
+  EXPECT_CALL(decoder_callbacks_, resetStream());
+  Buffer::OwnedImpl empty;
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(empty, true));
+  EXPECT_EQ(1, stats_.counter("test.decompressor.truncated").value());
+}
+
+// Bodies which are not gzip encoded, or have other codings applied, are passed on as is.
+TEST_F(DecompressorFilterTest, RequestNotGzipEncoded) {
+  for (const std::string encoding : {"", "br", "gzip, br"}) {
+    Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-length", "4"}};
+    if (!encoding.empty()) {
+      headers.addCopy("content-encoding", encoding);
+    }
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+    EXPECT_EQ("4", headers.get_("content-length"));
+    EXPECT_EQ("data", decodeBody("data", 4));
+  }
+  EXPECT_EQ(0, stats_.counter("test.decompressor.request_decompressed").value());
+}
+
+TEST_F(DecompressorFilterTest, RuntimeDisabled) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("decompressor.filter_enabled", 100))
+      .WillOnce(Return(false));
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ("gzip", headers.get_("content-encoding"));
+}
+
+// A body which is not valid gzip gets a 400, and the rest of it is dropped.
+TEST_F(DecompressorFilterTest, InvalidRequestBody) {
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(Http::Code::BadRequest, _, _, _, _));
+  Buffer::OwnedImpl data("this is not gzip");
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+  EXPECT_EQ(0, data.length());
+  Buffer::OwnedImpl more_data("more");
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(more_data, true));
+  EXPECT_EQ(0, more_data.length());
+  EXPECT_EQ(1, stats_.counter("test.decompressor.decompression_error").value());
+}
+
+// A body which decompresses beyond the maximum ratio gets a 413.
+TEST_F(DecompressorFilterTest, RequestRatioExceeded) {
+  const std::string compressed = gzip(std::string(1024 * 1024, 'a'));
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(Http::Code::PayloadTooLarge, _, _, _, _));
+  Buffer::OwnedImpl data(compressed);
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+  EXPECT_EQ(1, stats_.counter("test.decompressor.ratio_exceeded").value());
+}
+
+// The same body is accepted with a higher ratio limit.
+TEST_F(DecompressorFilterTest, RequestRatioWithinLimit) {
+  setUpFilter("max_decompression_ratio: 2000");
+  const std::string body(1024 * 1024, 'a');
+  Http::TestHeaderMapImpl headers{{":method", "post"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(body, decodeBody(gzip(body), 1024 * 1024));
+}
+
+// Responses are decompressed for clients which do not accept gzip.
+TEST_F(DecompressorFilterTest, DecompressResponse) {
+  setUpFilter("decompress_responses: true");
+  const std::string body(4096, 'a');
+
+  Http::TestHeaderMapImpl request_headers{{":method", "get"}, {"accept-encoding", "gzip;q=0"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_FALSE(response_headers.has("content-encoding"));
+
+  Buffer::OwnedImpl data(gzip(body));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, true));
+  EXPECT_EQ(body, data.toString());
+  EXPECT_EQ(1, stats_.counter("test.decompressor.response_decompressed").value());
+}
+
+// Responses are passed on as is for clients which accept gzip.
+TEST_F(DecompressorFilterTest, ResponseGzipAccepted) {
+  setUpFilter("decompress_responses: true");
+  for (const std::string accept_encoding : {"gzip", "br, GZIP;q=0.5", "*", "gzip;q=0, *"}) {
+    Http::TestHeaderMapImpl request_headers{{":method", "get"},
+                                            {"accept-encoding", accept_encoding}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+    Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-encoding", "gzip"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+              filter_->encodeHeaders(response_headers, false));
+    if (accept_encoding == "gzip;q=0, *") {
+      EXPECT_FALSE(response_headers.has("content-encoding"));
+    } else {
+      EXPECT_EQ("gzip", response_headers.get_("content-encoding"));
+    }
+  }
+}
+
+// A response which is not valid gzip resets the stream.
+TEST_F(DecompressorFilterTest, InvalidResponseBody) {
+  setUpFilter("decompress_responses: true");
+  Http::TestHeaderMapImpl request_headers{{":method", "get"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+
+  EXPECT_CALL(encoder_callbacks_, resetStream());
+  Buffer::OwnedImpl data("this is not gzip");
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->encodeData(data, true));
+}
+
+// A response whose gzip stream is cut short by its trailers resets the stream.
+TEST_F(DecompressorFilterTest, TruncatedResponseBody) {
+  setUpFilter("decompress_responses: true");
+  const std::string compressed = gzip(jsonBody(100));
+  Http::TestHeaderMapImpl request_headers{{":method", "get"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+
+  Buffer::OwnedImpl data(compressed.substr(0, compressed.size() / 2));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, false));
+  EXPECT_CALL(encoder_callbacks_, resetStream());
+  Http::TestHeaderMapImpl trailers{{"x-trailer", "1"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_->encodeTrailers(trailers));
+  EXPECT_EQ(1, stats_.counter("test.decompressor.truncated").value());
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_set>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/grpc/common.h"
+#include "common/http/header_map_impl.h"
+
+#include "extensions/filters/http/grpc_json_transcoder/json_transcoder_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/proto/bookstore.pb.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace GrpcJsonTranscoder {
+
+// The payloads are sent in chunks of the size of the reads of a connection.
+static constexpr uint64_t ChunkSize = 16384;
+static constexpr uint64_t QuoteSize = 1024;
+
+// The configuration of the bookstore service, with a descriptor set built from the descriptors
+// compiled in, so that the benchmark does not depend on its runfiles.
+static envoy::config::filter::http::transcoder::v2::GrpcJsonTranscoder bookstoreConfig() {
+  Protobuf::FileDescriptorSet descriptor_set;
+  std::unordered_set<std::string> added;
+  std::function<void(const Protobuf::FileDescriptor*)> add_file =
+      [&](const Protobuf::FileDescriptor* file) {
+        if (!added.insert(file->name()).second) {
+          return;
+        }
+        for (int i = 0; i < file->dependency_count(); ++i) {
+          add_file(file->dependency(i));
+        }
+        file->CopyTo(descriptor_set.add_file());
+      };
+  add_file(bookstore::Book::descriptor()->file());
+
+  envoy::config::filter::http::transcoder::v2::GrpcJsonTranscoder proto_config;
+  proto_config.set_proto_descriptor_bin(descriptor_set.SerializeAsString());
+  proto_config.add_services("bookstore.Bookstore");
+  return proto_config;
+}
+
+// A book whose quotes add up to the size of the payload.
+static bookstore::Book largeBook(uint64_t payload_size) {
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("War and Peace");
+  for (uint64_t size = 0; size < payload_size; size += QuoteSize) {
+    book.add_quotes(std::string(QuoteSize, 'a'));
+  }
+  return book;
+}
+
+// Moves the payload through a filter callback in chunks, returning the size of the output.
+static uint64_t sendChunks(const std::string& payload,
+                           const std::function<void(Buffer::Instance&, bool)>& send) {
+  uint64_t output_size = 0;
+  for (uint64_t offset = 0; offset < payload.size(); offset += ChunkSize) {
+    Buffer::OwnedImpl chunk(payload.data() + offset, std::min(ChunkSize, payload.size() - offset));
+    send(chunk, offset + ChunkSize >= payload.size());
+    output_size += chunk.length();
+  }
+  return output_size;
+}
+
+// Transcodes the JSON of a request message of the size in MB given by the Arg of the
+// BENCHMARK(...) macro call below.
+static void BM_TranscodeUnaryRequest(benchmark::State& state) {
+  Api::ApiPtr api = Api::createApiForTest();
+  JsonTranscoderConfig config(bookstoreConfig(), *api);
+  std::string payload;
+  Protobuf::util::MessageToJsonString(largeBook(state.range(0) << 20), &payload);
+
+  uint64_t output_size = 0;
+  for (auto _ : state) {
+    testing::NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+    JsonTranscoderFilter filter(config);
+    filter.setDecoderFilterCallbacks(decoder_callbacks);
+    Http::TestHeaderMapImpl headers{
+        {"content-type", "application/json"}, {":method", "PUT"}, {":path", "/shelves/1/books"}};
+    filter.decodeHeaders(headers, false);
+    output_size = sendChunks(payload, [&filter](Buffer::Instance& chunk, bool end_stream) {
+      filter.decodeData(chunk, end_stream);
+    });
+  }
+  if (output_size == 0) {
+    state.SkipWithError("the request was not transcoded");
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_TranscodeUnaryRequest)->Arg(10)->Unit(benchmark::kMillisecond);
+
+// Transcodes a response message of the size in MB given by the Arg of the BENCHMARK(...) macro
+// call below.
+static void BM_TranscodeUnaryResponse(benchmark::State& state) {
+  Api::ApiPtr api = Api::createApiForTest();
+  JsonTranscoderConfig config(bookstoreConfig(), *api);
+  const std::string payload =
+      Grpc::Common::serializeToGrpcFrame(largeBook(state.range(0) << 20))->toString();
+
+  uint64_t output_size = 0;
+  for (auto _ : state) {
+    testing::NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+    testing::NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks;
+    JsonTranscoderFilter filter(config);
+    filter.setDecoderFilterCallbacks(decoder_callbacks);
+    filter.setEncoderFilterCallbacks(encoder_callbacks);
+    Http::TestHeaderMapImpl request_headers{{":method", "PUT"}, {":path", "/shelves/1/books"}};
+    filter.decodeHeaders(request_headers, true);
+    Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                             {":status", "200"}};
+    filter.encodeHeaders(response_headers, false);
+    output_size = sendChunks(payload, [&filter](Buffer::Instance& chunk, bool end_stream) {
+      filter.encodeData(chunk, end_stream);
+    });
+  }
+  if (output_size == 0) {
+    state.SkipWithError("the response was not transcoded");
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_TranscodeUnaryResponse)->Arg(10)->Unit(benchmark::kMillisecond);
+
+// Transcodes a server streaming response of 1KB messages, which add up to the size in MB given by
+// the Arg of the BENCHMARK(...) macro call below, into a JSON array.
+static void BM_TranscodeServerStreamingResponse(benchmark::State& state) {
+  Api::ApiPtr api = Api::createApiForTest();
+  JsonTranscoderConfig config(bookstoreConfig(), *api);
+  std::string payload;
+  bookstore::Book book;
+  book.set_title(std::string(QuoteSize, 'a'));
+  for (uint64_t size = 0; size < static_cast<uint64_t>(state.range(0) << 20); size += QuoteSize) {
+    book.set_id(size / QuoteSize);
+    payload += Grpc::Common::serializeToGrpcFrame(book)->toString();
+  }
+
+  uint64_t output_size = 0;
+  for (auto _ : state) {
+    testing::NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+    testing::NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks;
+    JsonTranscoderFilter filter(config);
+    filter.setDecoderFilterCallbacks(decoder_callbacks);
+    filter.setEncoderFilterCallbacks(encoder_callbacks);
+    Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/shelves/1/books"}};
+    filter.decodeHeaders(request_headers, true);
+    Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                             {":status", "200"}};
+    filter.encodeHeaders(response_headers, false);
+    output_size = sendChunks(payload, [&filter](Buffer::Instance& chunk, bool end_stream) {
+      filter.encodeData(chunk, end_stream);
+    });
+  }
+  if (output_size == 0) {
+    state.SkipWithError("the response was not transcoded");
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_TranscodeServerStreamingResponse)->Arg(10)->Unit(benchmark::kMillisecond);
+
+} // namespace GrpcJsonTranscoder
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
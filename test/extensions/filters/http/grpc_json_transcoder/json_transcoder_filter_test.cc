@@ -23,14 +23,11 @@ using testing::_;
 using testing::Invoke;
 using testing::NiceMock;
 
-using Envoy::Protobuf::MethodDescriptor;
-
 using Envoy::Protobuf::FileDescriptorProto;
 using Envoy::Protobuf::FileDescriptorSet;
 using Envoy::Protobuf::util::MessageDifferencer;
 using Envoy::ProtobufUtil::error::Code;
 using google::api::HttpRule;
-using google::grpc::transcoding::Transcoder;
 
 namespace Envoy {
 namespace Extensions {
@@ -191,15 +188,14 @@ TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoder) {
 
   Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/shelves"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
-  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_descriptor->full_name());
+  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_info->descriptor_->full_name());
 }
 
 TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoderAutoMap) {
@@ -212,15 +208,14 @@ TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoderAutoMap) {
   Http::TestHeaderMapImpl headers{{":method", "POST"},
                                   {":path", "/bookstore.Bookstore/DeleteShelf"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
-  EXPECT_EQ("bookstore.Bookstore.DeleteShelf", method_descriptor->full_name());
+  EXPECT_EQ("bookstore.Bookstore.DeleteShelf", method_info->descriptor_->full_name());
 }
 
 TEST_F(GrpcJsonTranscoderConfigTest, InvalidQueryParameter) {
@@ -231,11 +226,10 @@ TEST_F(GrpcJsonTranscoderConfigTest, InvalidQueryParameter) {
 
   Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/shelves?foo=bar"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_EQ(Code::INVALID_ARGUMENT, status.error_code());
   EXPECT_EQ("Could not find field \"foo\" in the type \"google.protobuf.Empty\".",
@@ -251,11 +245,10 @@ TEST_F(GrpcJsonTranscoderConfigTest, UnknownQueryParameterIsIgnored) {
 
   Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/shelves?foo=bar"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
@@ -270,15 +263,14 @@ TEST_F(GrpcJsonTranscoderConfigTest, IgnoredQueryParameter) {
 
   Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/shelves?key=API_KEY"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
-  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_descriptor->full_name());
+  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_info->descriptor_->full_name());
 }
 
 TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
@@ -292,11 +284,10 @@ TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
 
   Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/book/1"}};
 
-  TranscoderInputStreamImpl request_in, response_in;
-  std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  const auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  TranscoderInputStreamImpl request_in;
+  RequestTranscoderPtr transcoder;
+  MethodInfoSharedPtr method_info;
+  const auto status = config.createTranscoder(headers, request_in, transcoder, method_info);
 
   EXPECT_EQ(Code::INVALID_ARGUMENT, status.error_code());
   EXPECT_EQ("Could not find field \"b\" in the type \"bookstore.GetBookRequest\".",
@@ -739,6 +730,171 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryWithHttpBodyAsOutputAndSpli
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.decodeTrailers(response_trailers));
 }
 
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingOverBufferLimits) {
+  // The messages are not bounded by the buffer limits, which they routinely exceed.
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(testing::Return(10));
+  ON_CALL(encoder_callbacks_, encoderBufferLimit()).WillByDefault(testing::Return(10));
+
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl request_data_first_part{"{\"theme\": "};
+  EXPECT_EQ(Http::FilterDataStatus::Continue,
+            filter_.decodeData(request_data_first_part, false));
+  EXPECT_EQ(0, request_data_first_part.length());
+
+  EXPECT_CALL(decoder_callbacks_, sendLocalReply(_, _, _, _, _)).Times(0);
+  Buffer::OwnedImpl request_data_second_part{"\"Children\"}"};
+  EXPECT_EQ(Http::FilterDataStatus::Continue,
+            filter_.decodeData(request_data_second_part, true));
+
+  Grpc::Decoder decoder;
+  std::vector<Grpc::Frame> frames;
+  decoder.decode(request_data_second_part, frames);
+  ASSERT_EQ(1, frames.size());
+
+  bookstore::CreateShelfRequest expected_request;
+  expected_request.mutable_shelf()->set_theme("Children");
+  bookstore::CreateShelfRequest request;
+  request.ParseFromString(frames[0].data_->toString());
+  EXPECT_TRUE(MessageDifferencer::Equals(expected_request, request));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_.encodeHeaders(response_headers, false));
+
+  bookstore::Shelf response;
+  response.set_id(20);
+  response.set_theme("Science Fiction");
+  auto response_data = Grpc::Common::serializeToGrpcFrame(response);
+
+  EXPECT_CALL(encoder_callbacks_, resetStream()).Times(0);
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer,
+            filter_.encodeData(*response_data, false));
+  EXPECT_EQ(R"({"id":"20","theme":"Science Fiction"})", response_data->toString());
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingServerStreamingGet) {
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/shelves/1/books"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+  EXPECT_EQ("/bookstore.Bookstore/ListBooks", request_headers.get_(":path"));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+  EXPECT_EQ("application/json", response_headers.get_("content-type"));
+
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("Kids");
+  Buffer::OwnedImpl response_data;
+  response_data.move(*Grpc::Common::serializeToGrpcFrame(book));
+  book.set_id(2);
+  response_data.move(*Grpc::Common::serializeToGrpcFrame(book));
+
+  // The messages are streamed as the elements of a JSON array as they arrive.
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(response_data, false));
+  EXPECT_EQ(R"([{"id":"1","title":"Kids"},{"id":"2","title":"Kids"})", response_data.toString());
+
+  book.set_id(3);
+  auto last_response_data = Grpc::Common::serializeToGrpcFrame(book);
+  Buffer::OwnedImpl last_response_data_first_part;
+  last_response_data_first_part.move(*last_response_data, last_response_data->length() / 2);
+  EXPECT_EQ(Http::FilterDataStatus::Continue,
+            filter_.encodeData(last_response_data_first_part, false));
+  EXPECT_EQ(0, last_response_data_first_part.length());
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(*last_response_data, false));
+  EXPECT_EQ(R"(,{"id":"3","title":"Kids"})", last_response_data->toString());
+
+  // The array is closed by the trailers.
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) { EXPECT_EQ("]", data.toString()); }));
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "0"}, {"grpc-message", ""}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.encodeTrailers(response_trailers));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingServerStreamingEmpty) {
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/shelves/1/books"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+
+  Buffer::OwnedImpl response_data;
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(response_data, true));
+  EXPECT_EQ("[]", response_data.toString());
+}
+
+class GrpcJsonTranscoderFilterMaxBodySizeTest : public GrpcJsonTranscoderFilterTest {
+public:
+  GrpcJsonTranscoderFilterMaxBodySizeTest() : GrpcJsonTranscoderFilterTest(makeProtoConfig()) {}
+
+private:
+  const envoy::config::filter::http::transcoder::v2::GrpcJsonTranscoder makeProtoConfig() {
+    auto proto_config = bookstoreProtoConfig();
+    proto_config.mutable_max_request_body_size()->set_value(10);
+    proto_config.mutable_max_response_body_size()->set_value(10);
+    return proto_config;
+  }
+};
+
+TEST_F(GrpcJsonTranscoderFilterMaxBodySizeTest, TranscodingUnaryRequestTooLarge) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl request_data_first_part{"{\"theme\": "};
+  EXPECT_EQ(Http::FilterDataStatus::Continue,
+            filter_.decodeData(request_data_first_part, false));
+  EXPECT_EQ(0, request_data_first_part.length());
+
+  // The JSON of the request message is held by the filter until the message is complete, so the
+  // request is rejected once it exceeds the limit.
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool end_stream) {
+        EXPECT_EQ("413", headers.Status()->value().getStringView());
+        EXPECT_FALSE(end_stream);
+      }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+
+  Buffer::OwnedImpl request_data_second_part{"\"Children\""};
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.decodeData(request_data_second_part, false));
+  EXPECT_EQ(decoder_callbacks_.details_, "grpc_json_transcode_request_too_large");
+}
+
+TEST_F(GrpcJsonTranscoderFilterMaxBodySizeTest, TranscodingUnaryResponseTooLarge) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_.encodeHeaders(response_headers, false));
+
+  bookstore::Shelf response;
+  response.set_id(20);
+  response.set_theme("Science Fiction");
+  auto response_data = Grpc::Common::serializeToGrpcFrame(response);
+
+  // The frame header of the response message is enough to reject it.
+  Buffer::OwnedImpl response_data_header;
+  response_data_header.move(*response_data, 5);
+
+  EXPECT_CALL(encoder_callbacks_, resetStream());
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.encodeData(response_data_header, false));
+}
+
 class GrpcJsonTranscoderFilterConvertGrpcStatusTest : public GrpcJsonTranscoderFilterTest {
 public:
   GrpcJsonTranscoderFilterConvertGrpcStatusTest()
@@ -11,6 +11,7 @@
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
@@ -24,7 +25,7 @@ namespace Gzip {
 
 class GzipFilterTest : public testing::Test {
 protected:
-  GzipFilterTest() {
+  GzipFilterTest() : api_(Api::createApiForTest()) {
     ON_CALL(runtime_.snapshot_, featureEnabled("gzip.filter_enabled", 100))
         .WillByDefault(Return(true));
   }
@@ -66,11 +67,41 @@ protected:
     Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
     envoy::config::filter::http::gzip::v2::Gzip gzip;
     TestUtility::loadFromJson(json, gzip);
-    config_.reset(new GzipFilterConfig(gzip, "test.", stats_, runtime_));
+    config_.reset(new GzipFilterConfig(gzip, "test.", stats_, runtime_, tls_, *api_));
+    resetFilter();
+  }
+
+  void resetFilter() {
     filter_ = std::make_unique<GzipFilter>(config_);
     filter_->setEncoderFilterCallbacks(encoder_callbacks_);
   }
 
+  // Sends a response to a request for /index.html through a new filter, in chunks of 128 bytes,
+  // and returns the compressed body.
+  std::string doCachedResponse(Http::TestHeaderMapImpl&& headers, const std::string& body) {
+    resetFilter();
+    doRequest({{":method", "get"},
+               {":authority", "example.com"},
+               {":path", "/index.html"},
+               {"accept-encoding", "gzip"}},
+              false);
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ(Http::Headers::get().ContentEncodingValues.Gzip, headers.get_("content-encoding"));
+    std::string compressed;
+    for (uint64_t offset = 0; offset < body.size(); offset += 128) {
+      const bool end_stream = offset + 128 >= body.size();
+      Buffer::OwnedImpl data(body.substr(offset, 128));
+      const Http::FilterDataStatus status = filter_->encodeData(data, end_stream);
+      if (status == Http::FilterDataStatus::Continue) {
+        compressed += data.toString();
+      } else {
+        EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, status);
+        EXPECT_EQ(0, data.length());
+      }
+    }
+    return compressed;
+  }
+
   void verifyCompressedData(const uint32_t content_length) {
     // This makes sure we have a finished buffer before sending it to the client.
     expectValidFinishedBuffer(content_length);
@@ -183,6 +214,8 @@ protected:
   std::string expected_str_;
   Stats::IsolatedStoreImpl stats_;
   NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Api::ApiPtr api_;
   NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
 };
 
@@ -790,6 +823,98 @@ TEST_F(GzipFilterTest, RemoveAcceptEncodingHeader) {
   }
 }
 
+// Responses with a strong etag are compressed once and then served from the cache.
+TEST_F(GzipFilterTest, CacheByEtag) {
+  setUpFilter(R"EOF({"cache": {}})EOF");
+  feedBuffer(1024);
+  const std::string body = data_.toString();
+
+  const std::string compressed =
+      doCachedResponse({{"content-length", "1024"}, {"etag", "\"v1\""}}, body);
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_miss").value());
+  EXPECT_EQ(1U, config_->cache().size());
+
+  Http::TestHeaderMapImpl headers{{"content-length", "1024"}, {"etag", "\"v1\""}};
+  EXPECT_EQ(compressed, doCachedResponse(std::move(headers), body));
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_hit").value());
+
+  // A new version of the response is compressed again.
+  EXPECT_EQ(compressed, doCachedResponse({{"content-length", "1024"}, {"etag", "\"v2\""}}, body));
+  EXPECT_EQ(2, stats_.counter("test.gzip.cache_miss").value());
+
+  Buffer::OwnedImpl cached(compressed);
+  decompressor_.decompress(cached, decompressed_data_);
+  EXPECT_EQ(body, decompressed_data_.toString());
+}
+
+// Responses without an etag are cached by the hash of their body.
+TEST_F(GzipFilterTest, CacheByBodyHash) {
+  setUpFilter(R"EOF({"cache": {"max_entry_bytes": 2048}})EOF");
+  feedBuffer(1024);
+  const std::string body = data_.toString();
+
+  const std::string compressed = doCachedResponse({{"content-length", "1024"}}, body);
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_miss").value());
+  EXPECT_EQ(compressed, doCachedResponse({{"content-length", "1024"}}, body));
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_hit").value());
+
+  // Weak etags do not identify the compressed body.
+  EXPECT_EQ(compressed,
+            doCachedResponse({{"content-length", "1024"}, {"etag", "W/\"v1\""}}, body));
+  EXPECT_EQ(2, stats_.counter("test.gzip.cache_hit").value());
+
+  // Larger responses are neither buffered nor cached.
+  doCachedResponse({{"content-length", "4096"}}, body + body + body + body);
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_miss").value());
+  EXPECT_EQ(1U, config_->cache().size());
+}
+
+// The least recently used bodies are evicted when the cache is full.
+TEST_F(GzipFilterTest, CacheEviction) {
+  setUpFilter(R"EOF({"cache": {"max_bytes": 1024}})EOF");
+  feedBuffer(1024);
+  const std::string body = data_.toString();
+
+  doCachedResponse({{"content-length", "1024"}, {"etag", "\"v1\""}}, body);
+  doCachedResponse({{"content-length", "1024"}, {"etag", "\"v2\""}}, body);
+  EXPECT_EQ(1, stats_.counter("test.gzip.cache_evicted").value());
+  EXPECT_EQ(1U, config_->cache().size());
+  EXPECT_LE(config_->cache().bytes(), 1024);
+}
+
+// Clients which accept the dictionary coding get responses compressed with the preset dictionary.
+TEST_F(GzipFilterTest, PresetDictionary) {
+  const std::string dictionary = "{id:,name:,email:@example.com,active:true}";
+  setUpFilter(fmt::format(
+      R"EOF({{"dictionary": {{"content_encoding": "deflate-dict",
+                              "dictionary": {{"inline_string": "{}"}}}}}})EOF",
+      dictionary));
+  const std::string body = "{id:1,name:alice,email:alice@example.com,active:true}";
+
+  doRequest({{":method", "get"}, {"accept-encoding", "gzip, deflate-dict"}}, false);
+  Http::TestHeaderMapImpl headers{{"content-length", std::to_string(body.size())}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ("deflate-dict", headers.get_("content-encoding"));
+  Buffer::OwnedImpl data(body);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, true));
+  EXPECT_EQ(1, stats_.counter("test.gzip.header_deflate-dict").value());
+
+  Decompressor::ZlibDecompressorImpl decompressor;
+  decompressor.init(15);
+  decompressor.setDictionary(dictionary);
+  Buffer::OwnedImpl decompressed;
+  decompressor.decompress(data, decompressed);
+  EXPECT_FALSE(decompressor.decompressionError());
+  EXPECT_EQ(body, decompressed.toString());
+
+  // Other clients still get gzip.
+  resetFilter();
+  doRequest({{":method", "get"}, {"accept-encoding", "gzip"}}, false);
+  Http::TestHeaderMapImpl gzip_headers{{"content-length", std::to_string(body.size())}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(gzip_headers, false));
+  EXPECT_EQ(Http::Headers::get().ContentEncodingValues.Gzip, gzip_headers.get_("content-encoding"));
+}
+
 } // namespace Gzip
 } // namespace HttpFilters
 } // namespace Extensions
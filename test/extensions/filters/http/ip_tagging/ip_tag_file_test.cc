@@ -0,0 +1,231 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/ip_tagging/ip_tag_file.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/filesystem/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace IpTagging {
+namespace {
+
+using TagData = std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>;
+
+TagData tagData(const std::vector<std::pair<std::string, std::vector<std::string>>>& tags) {
+  TagData data;
+  for (const auto& tag : tags) {
+    std::vector<Network::Address::CidrRange> ranges;
+    for (const std::string& range : tag.second) {
+      ranges.push_back(Network::Address::CidrRange::create(range));
+    }
+    data.emplace_back(tag.first, ranges);
+  }
+  return data;
+}
+
+std::string lookup(const IpTagFile& file, const std::string& address) {
+  const uint32_t tag_set = file.lookup(*Network::Utility::parseInternetAddress(address));
+  return std::string(file.tagSetValue(tag_set));
+}
+
+TEST(IpTagFileTest, Empty) {
+  IpTagFileConstSharedPtr file = IpTagFile::fromString(IpTagFile::build({}));
+  EXPECT_EQ(0, file->tagCount());
+  EXPECT_EQ(1, file->tagSetCount());
+  EXPECT_EQ(IpTagFile::NoTags, file->lookup(*Network::Utility::parseInternetAddress("1.2.3.4")));
+  EXPECT_EQ(IpTagFile::NoTags, file->lookup(*Network::Utility::parseInternetAddress("::1")));
+  EXPECT_EQ("", lookup(*file, "255.255.255.255"));
+}
+
+TEST(IpTagFileTest, NestedAndDuplicatePrefixes) {
+  IpTagFileConstSharedPtr file = IpTagFile::fromString(IpTagFile::build(tagData({
+      {"wide", {"10.0.0.0/8", "0.0.0.0/0"}},
+      {"narrow", {"10.1.0.0/16", "10.1.2.3/32"}},
+      {"host", {"10.1.2.3/32", "255.255.255.255/32"}},
+      {"other", {"192.168.0.0/16"}},
+  })));
+  EXPECT_EQ(4, file->tagCount());
+  EXPECT_EQ("wide", file->tag(0));
+  EXPECT_EQ("other", file->tag(3));
+
+  EXPECT_EQ("wide", lookup(*file, "0.0.0.0"));
+  EXPECT_EQ("wide", lookup(*file, "9.255.255.255"));
+  EXPECT_EQ("wide", lookup(*file, "10.0.255.255"));
+  EXPECT_EQ("wide,narrow", lookup(*file, "10.1.0.0"));
+  EXPECT_EQ("wide,narrow", lookup(*file, "10.1.2.2"));
+  EXPECT_EQ("wide,narrow,host", lookup(*file, "10.1.2.3"));
+  EXPECT_EQ("wide,narrow", lookup(*file, "10.1.2.4"));
+  EXPECT_EQ("wide,narrow", lookup(*file, "10.1.255.255"));
+  EXPECT_EQ("wide", lookup(*file, "10.2.0.0"));
+  EXPECT_EQ("wide,other", lookup(*file, "192.168.1.1"));
+  EXPECT_EQ("wide,host", lookup(*file, "255.255.255.255"));
+  EXPECT_EQ("wide", lookup(*file, "255.255.255.254"));
+  EXPECT_EQ("", lookup(*file, "::ffff:a01:203"));
+
+  const uint32_t tag_set = file->lookup(*Network::Utility::parseInternetAddress("10.1.2.3"));
+  const auto tags = file->tagSetTags(tag_set);
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2}), std::vector<uint32_t>(tags.first, tags.second));
+}
+
+TEST(IpTagFileTest, Ipv6) {
+  IpTagFileConstSharedPtr file = IpTagFile::fromString(IpTagFile::build(tagData({
+      {"doc", {"2001:db8::/32"}},
+      {"host", {"2001:db8::1/128", "1.2.3.4/32"}},
+      {"last", {"ffff::/16"}},
+  })));
+  EXPECT_EQ("", lookup(*file, "2001:db7:ffff:ffff:ffff:ffff:ffff:ffff"));
+  EXPECT_EQ("doc", lookup(*file, "2001:db8::"));
+  EXPECT_EQ("doc,host", lookup(*file, "2001:db8::1"));
+  EXPECT_EQ("doc", lookup(*file, "2001:db8::2"));
+  EXPECT_EQ("doc", lookup(*file, "2001:db8:ffff:ffff:ffff:ffff:ffff:ffff"));
+  EXPECT_EQ("", lookup(*file, "2001:db9::"));
+  EXPECT_EQ("last", lookup(*file, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"));
+  EXPECT_EQ("host", lookup(*file, "1.2.3.4"));
+}
+
+TEST(IpTagFileTest, ManyPrefixes) {
+  // Every /24 of 10.0.0.0/16 has its own tag, and every other one a shared tag as well.
+  TagData data;
+  std::vector<Network::Address::CidrRange> shared;
+  for (uint32_t i = 0; i < 256; i++) {
+    const std::string prefix = fmt::format("10.0.{}.0/24", i);
+    data.emplace_back(fmt::format("tag{}", i),
+                      std::vector<Network::Address::CidrRange>{
+                          Network::Address::CidrRange::create(prefix)});
+    if (i % 2 == 0) {
+      shared.push_back(Network::Address::CidrRange::create(prefix));
+    }
+  }
+  data.emplace_back("even", shared);
+  IpTagFileConstSharedPtr file = IpTagFile::fromString(IpTagFile::build(data));
+  EXPECT_EQ(257, file->tagCount());
+  for (uint32_t i = 0; i < 256; i++) {
+    EXPECT_EQ(i % 2 == 0 ? fmt::format("tag{},even", i) : fmt::format("tag{}", i),
+              lookup(*file, fmt::format("10.0.{}.7", i)));
+  }
+  EXPECT_EQ("", lookup(*file, "10.1.0.0"));
+}
+
+TEST(IpTagFileTest, Invalid) {
+  const std::string contents = IpTagFile::build(tagData({{"tag", {"10.0.0.0/8"}}}));
+  EXPECT_THROW_WITH_MESSAGE(IpTagFile::fromString("short"), EnvoyException,
+                            "invalid IP tag file");
+  EXPECT_THROW_WITH_MESSAGE(IpTagFile::fromString(contents.substr(0, contents.size() - 1)),
+                            EnvoyException, "bad header");
+
+  std::string bad_magic = contents;
+  bad_magic[0] ^= 1;
+  EXPECT_THROW_WITH_MESSAGE(IpTagFile::fromString(bad_magic), EnvoyException, "bad header");
+
+  // Corrupting any part of the last section, the IPv6 tag sets, is detected.
+  std::string bad_tag_set = contents;
+  bad_tag_set[bad_tag_set.size() - 1] = 0x7f;
+  EXPECT_THROW_WITH_MESSAGE(IpTagFile::fromString(bad_tag_set), EnvoyException, "bad ranges");
+}
+
+TEST(IpTagFileTest, Load) {
+  const std::string path = TestEnvironment::writeStringToFileForTest(
+      "ip_tags", IpTagFile::build(tagData({{"tag", {"10.0.0.0/8"}}})));
+  IpTagFileConstSharedPtr file = IpTagFile::load(path);
+  EXPECT_EQ("tag", lookup(*file, "10.1.2.3"));
+
+  EXPECT_THROW_WITH_REGEX(IpTagFile::load(path + ".missing"), EnvoyException,
+                          "cannot open IP tag file");
+  const std::string bad_path = TestEnvironment::writeStringToFileForTest(
+      "bad_ip_tags", std::string(1024, 'x'));
+  EXPECT_THROW_WITH_REGEX(IpTagFile::load(bad_path), EnvoyException,
+                          "invalid IP tag file .*: bad header");
+}
+
+class IpTagFileProviderTest : public testing::Test {
+public:
+  void writeFile(const std::string& contents) {
+    // Replace the file as a whole, as the provider expects, rather than truncating a mapped file.
+    const std::string temp_path =
+        TestEnvironment::writeStringToFileForTest("ip_tags.tmp", contents);
+    ASSERT_EQ(0, ::rename(temp_path.c_str(), path_.c_str()));
+  }
+
+  void writeTag(const std::string& tag) {
+    writeFile(IpTagFile::build(tagData({{tag, {"10.0.0.0/8"}}})));
+  }
+
+  void createProvider() {
+    EXPECT_CALL(dispatcher_, createFilesystemWatcher_()).WillOnce(Return(watcher_));
+    EXPECT_CALL(*watcher_, addWatch(path_, Filesystem::Watcher::Events::MovedTo, _))
+        .WillOnce(SaveArg<2>(&on_changed_));
+    provider_ = std::make_unique<IpTagFileProvider>(path_, "prefix.ip_tagging.", store_,
+                                                    dispatcher_, tls_);
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("prefix.ip_tagging." + name).value();
+  }
+
+  uint64_t gauge(const std::string& name) {
+    return store_.gauge("prefix.ip_tagging." + name, Stats::Gauge::ImportMode::NeverImport)
+        .value();
+  }
+
+  const std::string path_{TestEnvironment::temporaryPath("ip_tags")};
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Filesystem::MockWatcher* watcher_{new Filesystem::MockWatcher()};
+  Filesystem::Watcher::OnChangedCb on_changed_;
+  IpTagFileProviderPtr provider_;
+};
+
+TEST_F(IpTagFileProviderTest, Reload) {
+  writeTag("first");
+  createProvider();
+  IpTagFileConstSharedPtr first = provider_->file();
+  EXPECT_EQ("first", lookup(*first, "10.0.0.1"));
+  // 10.0.0.0/8 and the untagged ranges around it, and the untagged IPv6 address space.
+  EXPECT_EQ(4, gauge("ranges"));
+  EXPECT_EQ(2, gauge("tag_sets"));
+
+  writeTag("second");
+  on_changed_(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1, counter("reload_success"));
+  EXPECT_EQ("second", lookup(*provider_->file(), "10.0.0.1"));
+  // The previous file stays usable while it is referenced.
+  EXPECT_EQ("first", lookup(*first, "10.0.0.1"));
+
+  writeFile("invalid");
+  on_changed_(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1, counter("reload_failed"));
+  EXPECT_EQ("second", lookup(*provider_->file(), "10.0.0.1"));
+}
+
+TEST_F(IpTagFileProviderTest, InvalidInitialFile) {
+  writeFile("invalid");
+  EXPECT_CALL(dispatcher_, createFilesystemWatcher_()).WillOnce(Return(watcher_));
+  EXPECT_THROW_WITH_REGEX(
+      IpTagFileProvider(path_, "prefix.ip_tagging.", store_, dispatcher_, tls_), EnvoyException,
+      "invalid IP tag file");
+}
+
+} // namespace
+} // namespace IpTagging
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
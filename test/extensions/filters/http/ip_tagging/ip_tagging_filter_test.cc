@@ -8,14 +8,19 @@
 
 #include "extensions/filters/http/ip_tagging/ip_tagging_filter.h"
 
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/filesystem/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
 
@@ -280,6 +285,53 @@ TEST_F(IpTaggingFilterTest, ClearRouteCache) {
   EXPECT_FALSE(request_headers.has(Http::Headers::get().EnvoyIpTags));
 }
 
+TEST_F(IpTaggingFilterTest, TagsRequired) {
+  envoy::config::filter::http::ip_tagging::v2::IPTagging config;
+  EXPECT_THROW_WITH_MESSAGE(
+      IpTaggingFilterConfig(config, "prefix.", stats_, runtime_), EnvoyException,
+      "HTTP IP Tagging Filter requires either ip_tags or ip_tags_path to be specified.");
+}
+
+TEST_F(IpTaggingFilterTest, TagFile) {
+  const std::string path = TestEnvironment::writeStringToFileForTest(
+      "ip_tags", IpTagFile::build({{"internal_request",
+                                    {Network::Address::CidrRange::create("1.2.3.0/24")}},
+                                   {"host", {Network::Address::CidrRange::create("1.2.3.5/32")}}}));
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  EXPECT_CALL(dispatcher, createFilesystemWatcher_())
+      .WillOnce(Return(new NiceMock<Filesystem::MockWatcher>()));
+
+  envoy::config::filter::http::ip_tagging::v2::IPTagging config;
+  config.set_ip_tags_path(path);
+  config_ = std::make_shared<IpTaggingFilterConfig>(
+      config, "prefix.", stats_, runtime_,
+      std::make_unique<IpTagFileProvider>(path, "prefix.ip_tagging.", stats_, dispatcher, tls));
+  filter_ = std::make_unique<IpTaggingFilter>(config_);
+  filter_->setDecoderFilterCallbacks(filter_callbacks_);
+
+  Http::TestHeaderMapImpl request_headers{{"x-envoy-ip-tags", "test"}};
+  Network::Address::InstanceConstSharedPtr remote_address =
+      Network::Utility::parseInternetAddress("1.2.3.5");
+  EXPECT_CALL(filter_callbacks_.stream_info_, downstreamRemoteAddress())
+      .WillOnce(ReturnRef(remote_address));
+  EXPECT_CALL(filter_callbacks_, clearRouteCache());
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.hit"));
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.total"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ("test,internal_request,host", request_headers.get_(Http::Headers::get().EnvoyIpTags));
+
+  remote_address = Network::Utility::parseInternetAddress("1.2.4.5");
+  EXPECT_CALL(filter_callbacks_.stream_info_, downstreamRemoteAddress())
+      .WillOnce(ReturnRef(remote_address));
+  EXPECT_CALL(filter_callbacks_, clearRouteCache()).Times(0);
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.no_hit"));
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.total"));
+  request_headers = {};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_FALSE(request_headers.has(Http::Headers::get().EnvoyIpTags));
+}
+
 } // namespace
 } // namespace IpTagging
 } // namespace HttpFilters
@@ -0,0 +1,64 @@
+#include <memory>
+#include <string>
+
+#include "extensions/filters/http/jwt_authn/filter_config.h"
+
+#include "test/extensions/filters/http/jwt_authn/test_common.h"
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+using ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication;
+using ::google::jwt_verify::Status;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+// Authenticates requests which all carry the same RS256 token, as clients reuse a token until it
+// expires, with a local JWKS so that the requests complete inline. The Arg of the BENCHMARK(...)
+// macro call below is whether the verified tokens are cached.
+static void AuthenticateRequests(benchmark::State& state) {
+  JwtAuthentication proto_config;
+  TestUtility::loadFromYaml(ExampleConfig, proto_config);
+  auto& provider = (*proto_config.mutable_providers())[std::string(ProviderName)];
+  provider.clear_remote_jwks();
+  provider.mutable_local_jwks()->set_inline_string(PublicKey);
+  if (state.range(0) != 0) {
+    proto_config.mutable_token_cache();
+  }
+  testing::NiceMock<Server::Configuration::MockFactoryContext> context;
+  FilterConfig config(proto_config, "", context);
+
+  uint64_t failed = 0;
+  for (auto _ : state) {
+    Http::TestHeaderMapImpl headers{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    AuthenticatorPtr authenticator = config.create(nullptr, std::string(ProviderName), false);
+    authenticator->verify(headers, config.getExtractor().extract(headers), nullptr,
+                          [&failed](const Status& status) { failed += status != Status::Ok; });
+  }
+  if (failed > 0) {
+    state.SkipWithError("token verification failed");
+  }
+  const uint64_t hits = context.scope_.counter("jwt_authn.token_cache.hit").value();
+  const uint64_t misses = context.scope_.counter("jwt_authn.token_cache.miss").value();
+  state.counters["hit_ratio"] = hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0;
+}
+BENCHMARK(AuthenticateRequests)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
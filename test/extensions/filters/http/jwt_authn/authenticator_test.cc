@@ -44,7 +44,8 @@ public:
     fetcher_.reset(raw_fetcher_);
     auth_ = Authenticator::create(
         check_audience, provider, !provider, filter_config_->getCache().getJwksCache(),
-        filter_config_->cm(), [this](Upstream::ClusterManager&) { return std::move(fetcher_); },
+        filter_config_->getCache().getTokenCache(), filter_config_->cm(),
+        [this](Upstream::ClusterManager&) { return std::move(fetcher_); },
         filter_config_->timeSource());
     jwks_ = Jwks::createFrom(PublicKey, Jwks::JWKS);
     EXPECT_TRUE(jwks_->getStatus() == Status::Ok);
@@ -62,6 +63,10 @@ public:
     auth_->verify(headers, std::move(tokens), std::move(set_payload_cb), std::move(on_complete_cb));
   }
 
+  uint64_t tokenCacheCounter(const std::string& name) {
+    return mock_factory_ctx_.scope_.counter("jwt_authn.token_cache." + name).value();
+  }
+
   JwtAuthentication proto_config_;
   FilterConfigSharedPtr filter_config_;
   MockJwksFetcher* raw_fetcher_;
@@ -94,6 +99,72 @@ TEST_F(AuthenticatorTest, TestOkJWTandCache) {
   }
 }
 
+// This test verifies that a cached token is only verified once, and that its payload is still
+// forwarded and the token removed from the headers on every request.
+TEST_F(AuthenticatorTest, TestTokenCache) {
+  proto_config_.mutable_token_cache();
+  (*proto_config_.mutable_providers())[std::string(ProviderName)].set_payload_in_metadata(
+      "my_payload");
+  CreateAuthenticator();
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _))
+      .WillOnce(Invoke(
+          [this](const ::envoy::api::v2::core::HttpUri&, JwksFetcher::JwksReceiver& receiver) {
+            receiver.onJwksSuccess(std::move(jwks_));
+          }));
+
+  for (int i = 0; i < 10; i++) {
+    auto headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    out_name_.clear();
+    expectVerifyStatus(Status::Ok, headers);
+
+    EXPECT_EQ(headers.get_("sec-istio-auth-userinfo"), ExpectedPayloadValue);
+    EXPECT_FALSE(headers.Authorization());
+    EXPECT_EQ(out_name_, "my_payload");
+  }
+  EXPECT_EQ(1, tokenCacheCounter("miss"));
+  EXPECT_EQ(9, tokenCacheCounter("hit"));
+  EXPECT_EQ(1, filter_config_->getCache().getTokenCache()->size());
+
+  // The claims of a cached token are still checked, such as by an authenticator of the same worker
+  // which allows other audiences.
+  auto check_audience = std::make_unique<::google::jwt_verify::CheckAudience>(
+      std::vector<std::string>{"invalid_service"});
+  auth_ = filter_config_->create(check_audience.get(), std::string(ProviderName), false);
+  auto headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::JwtAudienceNotAllowed, headers);
+  EXPECT_EQ(9, tokenCacheCounter("hit"));
+}
+
+// This test verifies that a token is verified again once the JWKS of its provider changes.
+TEST_F(AuthenticatorTest, TestTokenCacheJwksChanged) {
+  proto_config_.mutable_token_cache();
+  CreateAuthenticator();
+  EXPECT_CALL(*raw_fetcher_, fetch(_, _))
+      .WillOnce(Invoke(
+          [this](const ::envoy::api::v2::core::HttpUri&, JwksFetcher::JwksReceiver& receiver) {
+            receiver.onJwksSuccess(std::move(jwks_));
+          }));
+
+  auto headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::Ok, headers);
+  headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  expectVerifyStatus(Status::Ok, headers);
+  EXPECT_EQ(1, tokenCacheCounter("miss"));
+  EXPECT_EQ(1, tokenCacheCounter("hit"));
+
+  // The JWKS is fetched again, as when it expires, which the cached token was not verified with.
+  filter_config_->getCache()
+      .getJwksCache()
+      .findByProvider(ProviderName)
+      ->setRemoteJwks(Jwks::createFrom(PublicKey, Jwks::JWKS));
+  for (int i = 0; i < 2; i++) {
+    headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    expectVerifyStatus(Status::Ok, headers);
+  }
+  EXPECT_EQ(2, tokenCacheCounter("miss"));
+  EXPECT_EQ(2, tokenCacheCounter("hit"));
+}
+
 // This test verifies the Jwt is forwarded if "forward" flag is set.
 TEST_F(AuthenticatorTest, TestForwardJwt) {
   // Config forward_jwt flag
@@ -0,0 +1,103 @@
+#include <limits>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+#include "test/extensions/filters/http/jwt_authn/test_common.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication;
+using ::google::jwt_verify::Jwt;
+using ::google::jwt_verify::Status;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+namespace {
+
+class TokenCacheTest : public testing::Test {
+protected:
+  TokenCacheTest()
+      : api_(Api::createApiForTest()),
+        stats_({ALL_JWT_AUTHN_TOKEN_CACHE_STATS(POOL_COUNTER_PREFIX(store_, "token_cache."))}) {
+    TestUtility::loadFromYaml(ExampleConfig, config_);
+    jwks_cache_ = JwksCache::create(config_, time_system_, *api_);
+    jwks_data_ = jwks_cache_->findByProvider(ProviderName);
+    jwks_data_->setRemoteJwks(
+        google::jwt_verify::Jwks::createFrom(PublicKey, google::jwt_verify::Jwks::JWKS));
+  }
+
+  JwtConstSharedPtr parse(const std::string& token) {
+    auto jwt = std::make_shared<Jwt>();
+    EXPECT_EQ(Status::Ok, jwt->parseFromString(token));
+    return jwt;
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Api::ApiPtr api_;
+  Stats::IsolatedStoreImpl store_;
+  TokenCacheStats stats_;
+  JwtAuthentication config_;
+  JwksCachePtr jwks_cache_;
+  JwksCache::JwksData* jwks_data_;
+};
+
+TEST_F(TokenCacheTest, LookupAndInsert) {
+  TokenCache cache(10, stats_);
+  EXPECT_EQ(nullptr, cache.lookup(GoodToken, 0));
+
+  JwtConstSharedPtr jwt = parse(GoodToken);
+  cache.insert(GoodToken, jwt, *jwks_data_);
+  const TokenCache::Entry* entry = cache.lookup(GoodToken, 0);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(jwt, entry->jwt_);
+  EXPECT_EQ(jwks_data_, entry->jwks_data_);
+  EXPECT_EQ(jwks_data_->version(), entry->jwks_version_);
+  EXPECT_EQ(nullptr, cache.lookup(OtherGoodToken, 0));
+
+  // Inserting the token again replaces its entry, with the current version of the JWKS.
+  jwks_data_->setRemoteJwks(
+      google::jwt_verify::Jwks::createFrom(PublicKey, google::jwt_verify::Jwks::JWKS));
+  EXPECT_NE(jwks_data_->version(), cache.lookup(GoodToken, 0)->jwks_version_);
+  cache.insert(GoodToken, jwt, *jwks_data_);
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(jwks_data_->version(), cache.lookup(GoodToken, 0)->jwks_version_);
+}
+
+TEST_F(TokenCacheTest, Expiration) {
+  TokenCache cache(10, stats_);
+  JwtConstSharedPtr jwt = parse(GoodToken);
+  cache.insert(GoodToken, jwt, *jwks_data_);
+  EXPECT_NE(nullptr, cache.lookup(GoodToken, jwt->exp_));
+  EXPECT_EQ(nullptr, cache.lookup(GoodToken, jwt->exp_ + 1));
+  EXPECT_EQ(0, cache.size());
+
+  // A token without an exp claim does not expire.
+  JwtConstSharedPtr non_expiring = parse(NonExpiringToken);
+  cache.insert(NonExpiringToken, non_expiring, *jwks_data_);
+  EXPECT_NE(nullptr, cache.lookup(NonExpiringToken, std::numeric_limits<uint64_t>::max()));
+}
+
+TEST_F(TokenCacheTest, LeastRecentlyUsedEviction) {
+  TokenCache cache(2, stats_);
+  cache.insert(GoodToken, parse(GoodToken), *jwks_data_);
+  cache.insert(OtherGoodToken, parse(OtherGoodToken), *jwks_data_);
+  EXPECT_NE(nullptr, cache.lookup(GoodToken, 0));
+
+  cache.insert(InvalidAudToken, parse(InvalidAudToken), *jwks_data_);
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.lookup(GoodToken, 0));
+  EXPECT_EQ(nullptr, cache.lookup(OtherGoodToken, 0));
+  EXPECT_NE(nullptr, cache.lookup(InvalidAudToken, 0));
+}
+
+} // namespace
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
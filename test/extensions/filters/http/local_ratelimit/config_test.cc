@@ -0,0 +1,70 @@
+#include "extensions/filters/http/local_ratelimit/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+TEST(LocalRateLimitFilterConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW(LocalRateLimitFilterConfig().createFilterFactoryFromProto(
+                   envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit(),
+                   "stats", context),
+               ProtoValidationException);
+}
+
+TEST(LocalRateLimitFilterConfigTest, CorrectProto) {
+  const std::string yaml = R"EOF(
+  stat_prefix: test
+  stage: 1
+  token_bucket:
+    max_tokens: 100
+    tokens_per_fill: 10
+    fill_interval: 0.5s
+  descriptors:
+  - entries:
+    - key: remote_address
+      value: 10.0.0.1
+    token_bucket:
+      max_tokens: 10
+      fill_interval: 1s
+  )EOF";
+
+  envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+  TestUtility::loadFromYamlAndValidate(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  LocalRateLimitFilterConfig factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(LocalRateLimitFilterConfigTest, DescriptorWithoutEntries) {
+  const std::string yaml = R"EOF(
+  stat_prefix: test
+  descriptors:
+  - token_bucket:
+      max_tokens: 10
+      fill_interval: 1s
+  )EOF";
+
+  envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+  EXPECT_THROW(TestUtility::loadFromYamlAndValidate(yaml, proto_config), EnvoyException);
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
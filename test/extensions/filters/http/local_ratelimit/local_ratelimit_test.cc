@@ -0,0 +1,225 @@
+#include <string>
+#include <vector>
+
+#include "common/http/headers.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/ratelimit/mocks.h"
+#include "test/mocks/router/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::SetArgReferee;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  LocalRateLimitFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enabled", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enforcing", 100))
+        .WillByDefault(Return(true));
+  }
+
+  void setUpTest(const std::string& yaml) {
+    envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+    TestUtility::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<FilterConfig>(proto_config, local_info_, runtime_, "test.",
+                                             stats_store_, time_system_);
+    filter_ = std::make_unique<Filter>(config_);
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    auto& route_entry = decoder_callbacks_.route_->route_entry_;
+    route_entry.rate_limit_policy_.rate_limit_policy_entry_.clear();
+    route_entry.rate_limit_policy_.rate_limit_policy_entry_.emplace_back(route_rate_limit_);
+    route_entry.virtual_host_.rate_limit_policy_.rate_limit_policy_entry_.clear();
+  }
+
+  Http::FilterHeadersStatus request() {
+    Http::TestHeaderMapImpl headers;
+    return filter_->decodeHeaders(headers, false);
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("test.local_rate_limit.local." + name).value();
+  }
+
+  const std::string global_config_ = R"EOF(
+  stat_prefix: local
+  token_bucket:
+    max_tokens: 2
+    tokens_per_fill: 1
+    fill_interval: 1s
+  )EOF";
+
+  const std::string descriptor_config_ = R"EOF(
+  stat_prefix: local
+  descriptors:
+  - entries:
+    - key: descriptor_key
+      value: descriptor_value
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  )EOF";
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Router::MockRateLimitPolicyEntry> route_rate_limit_;
+  std::vector<RateLimit::Descriptor> descriptor_{{{{"descriptor_key", "descriptor_value"}}}};
+  std::vector<RateLimit::Descriptor> other_descriptor_{{{{"descriptor_key", "other"}}}};
+  FilterConfigSharedPtr config_;
+  std::unique_ptr<Filter> filter_;
+};
+
+TEST_F(LocalRateLimitFilterTest, GlobalBucket) {
+  setUpTest(global_config_);
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+
+  Http::TestHeaderMapImpl expected_headers{{":status", "429"},
+                                           {"x-envoy-ratelimited", "true"}};
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(HeaderMapEqualRef(&expected_headers), true));
+  EXPECT_CALL(decoder_callbacks_.stream_info_,
+              setResponseFlag(StreamInfo::ResponseFlag::RateLimited));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, request());
+  EXPECT_EQ(2U, counter("ok"));
+  EXPECT_EQ(1U, counter("rate_limited"));
+
+  // A token is added back every second.
+  time_system_.sleep(std::chrono::seconds(1));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+}
+
+TEST_F(LocalRateLimitFilterTest, DescriptorBucket) {
+  setUpTest(descriptor_config_);
+
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillRepeatedly(SetArgReferee<1>(descriptor_));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, request());
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+// Requests without a descriptor which has a token bucket are not limited.
+TEST_F(LocalRateLimitFilterTest, OtherDescriptor) {
+  setUpTest(descriptor_config_);
+
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillRepeatedly(SetArgReferee<1>(other_descriptor_));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(0U, counter("rate_limited"));
+}
+
+// A request limited by one of its buckets gives back the tokens it took from the others.
+TEST_F(LocalRateLimitFilterTest, TokensGivenBackWhenLimited) {
+  setUpTest(R"EOF(
+  stat_prefix: local
+  descriptors:
+  - entries:
+    - key: descriptor_key
+      value: descriptor_value
+    token_bucket:
+      max_tokens: 2
+      fill_interval: 1s
+  - entries:
+    - key: descriptor_key
+      value: other
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  )EOF");
+
+  const std::vector<RateLimit::Descriptor> both{descriptor_[0], other_descriptor_[0]};
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillOnce(SetArgReferee<1>(both))
+      .WillOnce(SetArgReferee<1>(both))
+      .WillOnce(SetArgReferee<1>(descriptor_));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(2U, counter("ok"));
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, DisableKey) {
+  setUpTest(descriptor_config_);
+
+  route_rate_limit_.disable_key_ = "test_key";
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.test_key.http_filter_enabled",
+                                                 100))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+}
+
+TEST_F(LocalRateLimitFilterTest, NotEnforcing) {
+  setUpTest(global_config_);
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enforcing", 100))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  }
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, RuntimeDisabled) {
+  setUpTest(global_config_);
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enabled", 100))
+      .WillRepeatedly(Return(false));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, request());
+  }
+  EXPECT_EQ(0U, counter("ok"));
+}
+
+TEST_F(LocalRateLimitFilterTest, DuplicateDescriptor) {
+  const std::string yaml = R"EOF(
+  stat_prefix: local
+  descriptors:
+  - entries:
+    - key: a
+      value: b
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  - entries:
+    - key: a
+      value: b
+    token_bucket:
+      max_tokens: 2
+      fill_interval: 1s
+  )EOF";
+  EXPECT_THROW_WITH_MESSAGE(setUpTest(yaml), EnvoyException,
+                            "local rate limit: duplicate descriptor");
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -9,9 +9,11 @@
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -21,6 +23,7 @@ using testing::AtLeast;
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
+using testing::Property;
 using testing::Return;
 using testing::ReturnRef;
 using testing::StrEq;
@@ -68,7 +71,8 @@ public:
   ~LuaHttpFilterTest() override { filter_->onDestroy(); }
 
   void setup(const std::string& lua_code) {
-    config_.reset(new FilterConfig(lua_code, tls_, cluster_manager_));
+    config_.reset(
+        new FilterConfig(lua_code, tls_, cluster_manager_, "lua.", stats_store_, time_system_));
     setupFilter();
   }
 
@@ -92,6 +96,8 @@ public:
 
   NiceMock<ThreadLocal::MockInstance> tls_;
   Upstream::MockClusterManager cluster_manager_;
+  NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
+  Event::GlobalTimeSystem time_system_;
   std::shared_ptr<FilterConfig> config_;
   std::unique_ptr<TestFilter> filter_;
   Http::MockStreamDecoderFilterCallbacks decoder_callbacks_;
@@ -1297,6 +1303,36 @@ TEST_F(LuaHttpFilterTest, ImmediateResponse) {
   EXPECT_TRUE(config_->runtimeBytesUsed() < mem_use_at_start * 2);
 }
 
+// The time spent running each script is recorded when the stream is destroyed.
+TEST_F(LuaHttpFilterTest, ScriptTimeStats) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      request_handle:logTrace("request")
+    end
+
+    function envoy_on_response(response_handle)
+      response_handle:logTrace("response")
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+
+  Http::TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("request")));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("response")));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, true));
+
+  EXPECT_CALL(stats_store_, deliverHistogramToSinks(
+                                Property(&Stats::Metric::name, "lua.request_script_time_us"), _));
+  EXPECT_CALL(stats_store_, deliverHistogramToSinks(
+                                Property(&Stats::Metric::name, "lua.response_script_time_us"), _));
+  filter_->onDestroy();
+  setupFilter();
+}
+
 // Respond with bad status.
 TEST_F(LuaHttpFilterTest, ImmediateResponseBadStatus) {
   const std::string SCRIPT{R"EOF(
@@ -0,0 +1,49 @@
+#include "extensions/filters/network/local_ratelimit/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+TEST(LocalRateLimitConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW(LocalRateLimitConfigFactory().createFilterFactoryFromProto(
+                   envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit(),
+                   context),
+               ProtoValidationException);
+}
+
+TEST(LocalRateLimitConfigTest, CorrectProto) {
+  const std::string yaml = R"EOF(
+stat_prefix: test
+token_bucket:
+  max_tokens: 10
+  tokens_per_fill: 5
+  fill_interval: 1s
+)EOF";
+
+  envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+  TestUtility::loadFromYamlAndValidate(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  LocalRateLimitConfigFactory factory;
+  Network::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, context);
+  Network::MockConnection connection;
+  EXPECT_CALL(connection, addReadFilter(_));
+  cb(connection);
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/network/local_ratelimit/local_ratelimit.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+namespace {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  LocalRateLimitFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enabled", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enforcing", 100))
+        .WillByDefault(Return(true));
+
+    const std::string yaml = R"EOF(
+stat_prefix: local
+token_bucket:
+  max_tokens: 1
+  fill_interval: 0.2s
+)EOF";
+    envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+    TestUtility::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<Config>(proto_config, runtime_, stats_store_, time_system_);
+  }
+
+  // Creates the filter of a new connection, and returns whether the connection was allowed.
+  Network::FilterStatus newConnection(NiceMock<Network::MockReadFilterCallbacks>& callbacks) {
+    Filter filter(config_);
+    filter.initializeReadFilterCallbacks(callbacks);
+    return filter.onNewConnection();
+  }
+
+  uint64_t rateLimited() {
+    return stats_store_.counter("local_ratelimit.local.rate_limited").value();
+  }
+
+  Event::SimulatedTimeSystem time_system_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  ConfigSharedPtr config_;
+};
+
+TEST_F(LocalRateLimitFilterTest, CloseOverLimit) {
+  NiceMock<Network::MockReadFilterCallbacks> callbacks1;
+  EXPECT_CALL(callbacks1.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks1));
+
+  NiceMock<Network::MockReadFilterCallbacks> callbacks2;
+  EXPECT_CALL(callbacks2.connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_EQ(Network::FilterStatus::StopIteration, newConnection(callbacks2));
+  EXPECT_EQ(1U, rateLimited());
+
+  time_system_.sleep(std::chrono::milliseconds(200));
+  NiceMock<Network::MockReadFilterCallbacks> callbacks3;
+  EXPECT_CALL(callbacks3.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks3));
+}
+
+TEST_F(LocalRateLimitFilterTest, NotEnforcing) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enforcing", 100))
+      .WillRepeatedly(Return(false));
+  NiceMock<Network::MockReadFilterCallbacks> callbacks;
+  EXPECT_CALL(callbacks.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks));
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks));
+  EXPECT_EQ(1U, rateLimited());
+}
+
+TEST_F(LocalRateLimitFilterTest, RuntimeDisabled) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enabled", 100))
+      .WillRepeatedly(Return(false));
+  NiceMock<Network::MockReadFilterCallbacks> callbacks;
+  EXPECT_CALL(callbacks.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks));
+  EXPECT_EQ(Network::FilterStatus::Continue, newConnection(callbacks));
+  EXPECT_EQ(0U, rateLimited());
+}
+
+} // namespace
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
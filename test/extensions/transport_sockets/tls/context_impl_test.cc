@@ -802,6 +802,16 @@ TEST_F(ClientContextConfigImplTest, TlsCertificatesAndSdsConfig) {
       "Multiple TLS certificates are not supported for client contexts");
 }
 
+// Validate that kernel TLS offload can't be combined with renegotiation.
+TEST_F(ClientContextConfigImplTest, KernelTlsOffloadWithRenegotiation) {
+  envoy::api::v2::auth::UpstreamTlsContext tls_context;
+  tls_context.mutable_common_tls_context()->set_kernel_tls_offload(true);
+  tls_context.set_allow_renegotiation(true);
+  EXPECT_THROW_WITH_MESSAGE(
+      ClientContextConfigImpl client_context_config(tls_context, factory_context_), EnvoyException,
+      "Kernel TLS offload can't be used with renegotiation");
+}
+
 // Validate context config supports SDS, and is marked as not ready if secrets are not yet
 // downloaded.
 TEST_F(ClientContextConfigImplTest, SecretNotReady) {
@@ -0,0 +1,327 @@
+// Benchmarks client TLS handshakes with and without session resumption, server handshakes with
+// synchronous and offloaded private key operations, and lookups in the shared session cache from
+// concurrent threads. Handshakes are run over in-memory BIO pairs against plain BoringSSL peers,
+// so that only the TLS work is measured.
+
+#include <string>
+#include <vector>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/transport_sockets/tls/context_config_impl.h"
+#include "extensions/transport_sockets/tls/context_impl.h"
+#include "extensions/transport_sockets/tls/private_key/thread_pool_provider.h"
+#include "extensions/transport_sockets/tls/session_cache_impl.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+#include "openssl/pem.h"
+#include "openssl/rsa.h"
+#include "openssl/ssl.h"
+#include "openssl/x509.h"
+
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+bssl::UniquePtr<EVP_PKEY> createEcdsaKey() {
+  bssl::UniquePtr<EC_KEY> ec_key(EC_KEY_new_by_curve_name(NID_X9_62_prime256v1));
+  RELEASE_ASSERT(EC_KEY_generate_key(ec_key.get()) == 1, "");
+  bssl::UniquePtr<EVP_PKEY> key(EVP_PKEY_new());
+  RELEASE_ASSERT(EVP_PKEY_assign_EC_KEY(key.get(), ec_key.release()) == 1, "");
+  return key;
+}
+
+bssl::UniquePtr<EVP_PKEY> createRsaKey() {
+  bssl::UniquePtr<RSA> rsa(RSA_new());
+  bssl::UniquePtr<BIGNUM> e(BN_new());
+  RELEASE_ASSERT(BN_set_word(e.get(), RSA_F4) == 1, "");
+  RELEASE_ASSERT(RSA_generate_key_ex(rsa.get(), 2048, e.get(), nullptr) == 1, "");
+  bssl::UniquePtr<EVP_PKEY> key(EVP_PKEY_new());
+  RELEASE_ASSERT(EVP_PKEY_assign_RSA(key.get(), rsa.release()) == 1, "");
+  return key;
+}
+
+// Creates a self-signed certificate for the key, so that the benchmark doesn't depend on test
+// data.
+bssl::UniquePtr<X509> createCertificate(EVP_PKEY* key) {
+  bssl::UniquePtr<X509> cert(X509_new());
+  RELEASE_ASSERT(X509_set_version(cert.get(), 2) == 1, "");
+  RELEASE_ASSERT(ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1) == 1, "");
+  RELEASE_ASSERT(X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0) != nullptr, "");
+  RELEASE_ASSERT(X509_gmtime_adj(X509_getm_notAfter(cert.get()), 3600) != nullptr, "");
+  X509_NAME* name = X509_get_subject_name(cert.get());
+  RELEASE_ASSERT(X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                            reinterpret_cast<const uint8_t*>("benchmark"), -1,
+                                            -1, 0) == 1,
+                 "");
+  RELEASE_ASSERT(X509_set_issuer_name(cert.get(), name) == 1, "");
+  RELEASE_ASSERT(X509_set_pubkey(cert.get(), key) == 1, "");
+  RELEASE_ASSERT(X509_sign(cert.get(), key, EVP_sha256()) > 0, "");
+  return cert;
+}
+
+bssl::UniquePtr<SSL_CTX> createServerContext() {
+  bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_method()));
+  RELEASE_ASSERT(SSL_CTX_set_max_proto_version(ctx.get(), TLS1_3_VERSION) == 1, "");
+  bssl::UniquePtr<EVP_PKEY> key = createEcdsaKey();
+  bssl::UniquePtr<X509> cert = createCertificate(key.get());
+  RELEASE_ASSERT(SSL_CTX_use_certificate(ctx.get(), cert.get()) == 1, "");
+  RELEASE_ASSERT(SSL_CTX_use_PrivateKey(ctx.get(), key.get()) == 1, "");
+  return ctx;
+}
+
+// Advances one side of the handshake, returning true once it has completed.
+bool doHandshake(SSL* ssl) {
+  const int rc = SSL_do_handshake(ssl);
+  if (rc == 1) {
+    return true;
+  }
+  RELEASE_ASSERT(SSL_get_error(ssl, rc) == SSL_ERROR_WANT_READ, "");
+  return false;
+}
+
+void handshake(SSL* client, SSL* server) {
+  BIO* client_bio;
+  BIO* server_bio;
+  RELEASE_ASSERT(BIO_new_bio_pair(&client_bio, 0, &server_bio, 0) == 1, "");
+  SSL_set_bio(client, client_bio, client_bio);
+  SSL_set_bio(server, server_bio, server_bio);
+  SSL_set_connect_state(client);
+  SSL_set_accept_state(server);
+
+  bool client_done = false;
+  bool server_done = false;
+  while (!client_done || !server_done) {
+    client_done = client_done || doHandshake(client);
+    server_done = server_done || doHandshake(server);
+  }
+
+  // TLS 1.3 session tickets are sent after the handshake, read them so that they are stored.
+  uint8_t buffer;
+  const int rc = SSL_read(client, &buffer, sizeof(buffer));
+  RELEASE_ASSERT(rc < 0 && SSL_get_error(client, rc) == SSL_ERROR_WANT_READ, "");
+}
+
+// Arguments: session resumption enabled (0/1), TLS 1.3 (0/1).
+static void BM_ClientHandshake(benchmark::State& state) {
+  const bool session_resumption = state.range(0) != 0;
+  const bool tls13 = state.range(1) != 0;
+
+  Stats::IsolatedStoreImpl store;
+  Event::SimulatedTimeSystem time_system;
+  Api::ApiPtr api = Api::createApiForTest(store, time_system);
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context;
+  ON_CALL(factory_context, api()).WillByDefault(ReturnRef(*api));
+
+  envoy::api::v2::auth::UpstreamTlsContext tls_context;
+  tls_context.mutable_common_tls_context()->mutable_tls_params()->set_tls_maximum_protocol_version(
+      tls13 ? envoy::api::v2::auth::TlsParameters::TLSv1_3
+            : envoy::api::v2::auth::TlsParameters::TLSv1_2);
+  tls_context.mutable_max_session_keys()->set_value(session_resumption ? 1 : 0);
+  ClientContextConfigImpl config(tls_context, factory_context);
+  ClientContextImpl client_context(store, config, time_system);
+  bssl::UniquePtr<SSL_CTX> server_context = createServerContext();
+
+  uint64_t reused = 0;
+  for (auto _ : state) {
+    bssl::UniquePtr<SSL> client = client_context.newSsl(nullptr);
+    bssl::UniquePtr<SSL> server(SSL_new(server_context.get()));
+    handshake(client.get(), server.get());
+    reused += SSL_session_reused(client.get());
+  }
+  state.counters["reused"] = benchmark::Counter(reused, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ClientHandshake)
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+// A server handshake which may be waiting for an offloaded private key operation.
+class ServerHandshake : public Ssl::PrivateKeyConnectionCallbacks {
+public:
+  ServerHandshake(SSL_CTX* client_ctx, SSL_CTX* server_ctx, Event::Dispatcher& dispatcher)
+      : client_(SSL_new(client_ctx)), server_(SSL_new(server_ctx)), dispatcher_(dispatcher) {
+    BIO* client_bio;
+    BIO* server_bio;
+    RELEASE_ASSERT(BIO_new_bio_pair(&client_bio, 0, &server_bio, 0) == 1, "");
+    SSL_set_bio(client_.get(), client_bio, client_bio);
+    SSL_set_bio(server_.get(), server_bio, server_bio);
+    SSL_set_connect_state(client_.get());
+    SSL_set_accept_state(server_.get());
+  }
+
+  // Ssl::PrivateKeyConnectionCallbacks
+  void onPrivateKeyMethodComplete() override {
+    waiting_ = false;
+    dispatcher_.exit();
+  }
+
+  // Advances both sides of the handshake, returning true once it has completed.
+  bool advance() {
+    client_done_ = client_done_ || doHandshake(client_.get());
+    if (!server_done_) {
+      const int rc = SSL_do_handshake(server_.get());
+      if (rc == 1) {
+        server_done_ = true;
+      } else if (SSL_get_error(server_.get(), rc) == SSL_ERROR_WANT_PRIVATE_KEY_OPERATION) {
+        waiting_ = true;
+      } else {
+        RELEASE_ASSERT(SSL_get_error(server_.get(), rc) == SSL_ERROR_WANT_READ, "");
+      }
+    }
+    return done();
+  }
+
+  bool done() const { return client_done_ && server_done_; }
+  bool waiting() const { return waiting_; }
+  SSL* server() { return server_.get(); }
+
+private:
+  bssl::UniquePtr<SSL> client_;
+  bssl::UniquePtr<SSL> server_;
+  Event::Dispatcher& dispatcher_;
+  bool client_done_{};
+  bool server_done_{};
+  bool waiting_{};
+};
+
+// Server handshakes with an RSA 2048 key, a batch of handshakes being in flight on one event loop.
+// Argument: number of private key provider threads, 0 for signing synchronously on the event
+// loop.
+static void BM_ServerHandshakePrivateKey(benchmark::State& state) {
+  static constexpr uint32_t Concurrency = 32;
+  const uint32_t num_threads = state.range(0);
+
+  Stats::IsolatedStoreImpl store;
+  Api::ApiPtr api = Api::createApiForTest(store);
+  Event::DispatcherPtr dispatcher = api->allocateDispatcher();
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context;
+  ON_CALL(factory_context, api()).WillByDefault(ReturnRef(*api));
+  ON_CALL(factory_context, statsScope()).WillByDefault(ReturnRef(store));
+
+  bssl::UniquePtr<EVP_PKEY> key = createRsaKey();
+  bssl::UniquePtr<X509> cert = createCertificate(key.get());
+  bssl::UniquePtr<SSL_CTX> server_ctx(SSL_CTX_new(TLS_method()));
+  RELEASE_ASSERT(SSL_CTX_use_certificate(server_ctx.get(), cert.get()) == 1, "");
+  bssl::UniquePtr<SSL_CTX> client_ctx(SSL_CTX_new(TLS_method()));
+
+  std::unique_ptr<ThreadPoolPrivateKeyMethodProvider> provider;
+  Ssl::BoringSslPrivateKeyMethodSharedPtr method;
+  if (num_threads == 0) {
+    RELEASE_ASSERT(SSL_CTX_use_PrivateKey(server_ctx.get(), key.get()) == 1, "");
+  } else {
+    bssl::UniquePtr<BIO> bio(BIO_new(BIO_s_mem()));
+    RELEASE_ASSERT(
+        PEM_write_bio_PrivateKey(bio.get(), key.get(), nullptr, nullptr, 0, nullptr, nullptr) == 1,
+        "");
+    const uint8_t* pem;
+    size_t pem_len;
+    RELEASE_ASSERT(BIO_mem_contents(bio.get(), &pem, &pem_len) == 1, "");
+
+    envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool config;
+    config.mutable_private_key()->set_inline_string(reinterpret_cast<const char*>(pem), pem_len);
+    config.mutable_num_threads()->set_value(num_threads);
+    provider = std::make_unique<ThreadPoolPrivateKeyMethodProvider>(config, factory_context);
+    method = provider->getBoringSslPrivateKeyMethod();
+    SSL_CTX_set_private_key_method(server_ctx.get(), method.get());
+  }
+
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<ServerHandshake>> handshakes;
+    for (uint32_t i = 0; i < Concurrency; i++) {
+      handshakes.emplace_back(
+          std::make_unique<ServerHandshake>(client_ctx.get(), server_ctx.get(), *dispatcher));
+      if (provider != nullptr) {
+        provider->registerPrivateKeyMethod(handshakes.back()->server(), *handshakes.back(),
+                                           *dispatcher);
+      }
+    }
+
+    uint32_t remaining = Concurrency;
+    while (remaining > 0) {
+      bool all_waiting = true;
+      for (auto& handshake : handshakes) {
+        if (handshake->done() || handshake->waiting()) {
+          continue;
+        }
+        all_waiting = false;
+        if (handshake->advance()) {
+          remaining--;
+        }
+      }
+      if (remaining > 0) {
+        dispatcher->run(all_waiting ? Event::Dispatcher::RunType::Block
+                                    : Event::Dispatcher::RunType::NonBlock);
+      }
+    }
+
+    if (provider != nullptr) {
+      for (auto& handshake : handshakes) {
+        provider->unregisterPrivateKeyMethod(handshake->server());
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * Concurrency);
+}
+BENCHMARK(BM_ServerHandshakePrivateKey)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Multi-use (TLS 1.2) session lookups from concurrent threads for a number of distinct upstreams,
+// each thread looking up a different upstream on every iteration.
+static void BM_SessionCacheLookup(benchmark::State& state) {
+  static constexpr uint32_t NumKeys = 64;
+  static SessionCacheImpl* cache = []() {
+    auto* cache = new SessionCacheImpl();
+    bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_method()));
+    for (uint32_t i = 0; i < NumKeys; i++) {
+      bssl::UniquePtr<SSL_SESSION> session(SSL_SESSION_new(ctx.get()));
+      RELEASE_ASSERT(SSL_SESSION_set_protocol_version(session.get(), TLS1_2_VERSION) == 1, "");
+      cache->insert(absl::StrCat("upstream", i), std::move(session), 1);
+    }
+    return cache;
+  }();
+
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < NumKeys; i++) {
+    keys.push_back(absl::StrCat("upstream", (i + state.thread_index) % NumKeys));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache->lookup(keys[i++ % NumKeys]));
+  }
+}
+BENCHMARK(BM_SessionCacheLookup)->ThreadRange(1, 16);
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_context(spdlog::level::warn,
+                                         Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
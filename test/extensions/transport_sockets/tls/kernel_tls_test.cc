@@ -0,0 +1,286 @@
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include "common/api/os_sys_calls_impl.h"
+
+#include "extensions/transport_sockets/tls/kernel_tls.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/threadsafe_singleton_injector.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "openssl/ssl.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#endif
+#endif
+
+using testing::_;
+using testing::Invoke;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+class MockKernelTlsOsSysCalls : public Api::OsSysCallsImpl {
+public:
+  MOCK_METHOD5(setsockopt, Api::SysCallIntResult(int sockfd, int level, int optname,
+                                                 const void* optval, socklen_t optlen));
+  MOCK_METHOD3(sendmsg, Api::SysCallSizeResult(int fd, const msghdr* message, int flags));
+  MOCK_METHOD3(recvmsg, Api::SysCallSizeResult(int socket, msghdr* message, int flags));
+};
+
+class KernelTlsTest : public testing::Test {
+public:
+  static constexpr int ServerFd = 1;
+  static constexpr int ClientFd = 2;
+
+  // Establishes a connection between two BoringSSL peers over an in-memory BIO pair.
+  void handshake(uint16_t max_version, const char* cipher_list) {
+    server_ctx_.reset(SSL_CTX_new(TLS_method()));
+    ASSERT_EQ(1, SSL_CTX_use_certificate_chain_file(
+                     server_ctx_.get(),
+                     TestEnvironment::runfilesPath(
+                         "test/extensions/transport_sockets/tls/test_data/selfsigned_cert.pem")
+                         .c_str()));
+    ASSERT_EQ(1, SSL_CTX_use_PrivateKey_file(
+                     server_ctx_.get(),
+                     TestEnvironment::runfilesPath(
+                         "test/extensions/transport_sockets/tls/test_data/selfsigned_key.pem")
+                         .c_str(),
+                     SSL_FILETYPE_PEM));
+    client_ctx_.reset(SSL_CTX_new(TLS_method()));
+    ASSERT_EQ(1, SSL_CTX_set_max_proto_version(client_ctx_.get(), max_version));
+    if (cipher_list != nullptr) {
+      ASSERT_EQ(1, SSL_CTX_set_strict_cipher_list(client_ctx_.get(), cipher_list));
+    }
+
+    server_.reset(SSL_new(server_ctx_.get()));
+    client_.reset(SSL_new(client_ctx_.get()));
+    BIO* server_bio;
+    BIO* client_bio;
+    ASSERT_EQ(1, BIO_new_bio_pair(&server_bio, 0, &client_bio, 0));
+    SSL_set_bio(server_.get(), server_bio, server_bio);
+    SSL_set_bio(client_.get(), client_bio, client_bio);
+    SSL_set_accept_state(server_.get());
+    SSL_set_connect_state(client_.get());
+
+    bool server_done = false;
+    bool client_done = false;
+    while (!server_done || !client_done) {
+      client_done = client_done || doHandshake(client_.get());
+      server_done = server_done || doHandshake(server_.get());
+    }
+  }
+
+  bool doHandshake(SSL* ssl) {
+    const int rc = SSL_do_handshake(ssl);
+    if (rc == 1) {
+      return true;
+    }
+    EXPECT_EQ(SSL_ERROR_WANT_READ, SSL_get_error(ssl, rc));
+    return false;
+  }
+
+  MockKernelTlsOsSysCalls os_sys_calls_;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls_{&os_sys_calls_};
+  bssl::UniquePtr<SSL_CTX> server_ctx_;
+  bssl::UniquePtr<SSL_CTX> client_ctx_;
+  bssl::UniquePtr<SSL> server_;
+  bssl::UniquePtr<SSL> client_;
+};
+
+#if defined(TLS_RX) && defined(TLS_GET_RECORD_TYPE)
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+using CryptoInfo = tls12_crypto_info_aes_gcm_128;
+
+void expectSequence(uint64_t sequence, const unsigned char* rec_seq) {
+  for (size_t i = 0; i < TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE; i++) {
+    EXPECT_EQ(static_cast<uint8_t>(sequence >> (8 * (7 - i))), rec_seq[i]);
+  }
+}
+
+TEST_F(KernelTlsTest, Supported) { EXPECT_TRUE(KernelTls::supported()); }
+
+TEST_F(KernelTlsTest, Tls12AesGcm) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+
+  std::map<std::pair<int, int>, CryptoInfo> crypto_info;
+  EXPECT_CALL(os_sys_calls_, setsockopt(_, IPPROTO_TCP, TCP_ULP, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(os_sys_calls_, setsockopt(_, SOL_TLS, _, _, sizeof(CryptoInfo)))
+      .Times(4)
+      .WillRepeatedly(Invoke([&](int fd, int, int direction, const void* optval,
+                                 socklen_t) -> Api::SysCallIntResult {
+        memcpy(&crypto_info[{fd, direction}], optval, sizeof(CryptoInfo));
+        return {0, 0};
+      }));
+
+  const KernelTls::Offload server_offload = KernelTls::enable(server_.get(), ServerFd);
+  const KernelTls::Offload client_offload = KernelTls::enable(client_.get(), ClientFd);
+  EXPECT_TRUE(server_offload.tx_);
+  EXPECT_TRUE(server_offload.rx_);
+  EXPECT_TRUE(client_offload.tx_);
+  EXPECT_TRUE(client_offload.rx_);
+
+  const CryptoInfo& server_tx = crypto_info[{ServerFd, TLS_TX}];
+  const CryptoInfo& server_rx = crypto_info[{ServerFd, TLS_RX}];
+  const CryptoInfo& client_tx = crypto_info[{ClientFd, TLS_TX}];
+  const CryptoInfo& client_rx = crypto_info[{ClientFd, TLS_RX}];
+  EXPECT_EQ(TLS_1_2_VERSION, server_tx.info.version);
+  EXPECT_EQ(TLS_CIPHER_AES_GCM_128, server_tx.info.cipher_type);
+
+  // Each side receives with the keys and sequence numbers the other side sends with.
+  EXPECT_EQ(0, memcmp(&server_tx, &client_rx, sizeof(CryptoInfo)));
+  EXPECT_EQ(0, memcmp(&client_tx, &server_rx, sizeof(CryptoInfo)));
+  EXPECT_NE(0, memcmp(server_tx.key, client_tx.key, sizeof(server_tx.key)));
+
+  expectSequence(SSL_get_write_sequence(server_.get()), server_tx.rec_seq);
+  expectSequence(SSL_get_read_sequence(server_.get()), server_rx.rec_seq);
+  EXPECT_EQ(0, memcmp(server_tx.iv, server_tx.rec_seq, sizeof(server_tx.iv)));
+}
+
+// RX isn't offloaded if BoringSSL has already read data the kernel would need to decrypt.
+TEST_F(KernelTlsTest, PendingData) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  ASSERT_EQ(5, SSL_write(client_.get(), "hello", 5));
+  uint8_t buffer;
+  ASSERT_EQ(1, SSL_read(server_.get(), &buffer, 1));
+
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, IPPROTO_TCP, TCP_ULP, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, SOL_TLS, TLS_TX, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_TRUE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+}
+
+// Kernels without the TLS ULP leave the connection to BoringSSL.
+TEST_F(KernelTlsTest, UlpUnsupported) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, IPPROTO_TCP, TCP_ULP, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{-1, ENOENT}));
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_FALSE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+}
+
+TEST_F(KernelTlsTest, RxUnsupported) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, IPPROTO_TCP, TCP_ULP, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, SOL_TLS, TLS_TX, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{0, 0}));
+  EXPECT_CALL(os_sys_calls_, setsockopt(ServerFd, SOL_TLS, TLS_RX, _, _))
+      .WillOnce(Return(Api::SysCallIntResult{-1, ENOPROTOOPT}));
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_TRUE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+}
+
+TEST_F(KernelTlsTest, Tls13NotOffloaded) {
+  handshake(TLS1_3_VERSION, nullptr);
+  EXPECT_CALL(os_sys_calls_, setsockopt(_, _, _, _, _)).Times(0);
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_FALSE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+}
+
+TEST_F(KernelTlsTest, ChaCha20NotOffloaded) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-CHACHA20-POLY1305");
+  EXPECT_CALL(os_sys_calls_, setsockopt(_, _, _, _, _)).Times(0);
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_FALSE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+}
+
+TEST_F(KernelTlsTest, SendCloseNotify) {
+  EXPECT_CALL(os_sys_calls_, sendmsg(ServerFd, _, 0))
+      .WillOnce(Invoke([](int, const msghdr* message, int) -> Api::SysCallSizeResult {
+        const cmsghdr* cmsg = CMSG_FIRSTHDR(message);
+        EXPECT_NE(nullptr, cmsg);
+        EXPECT_EQ(SOL_TLS, cmsg->cmsg_level);
+        EXPECT_EQ(TLS_SET_RECORD_TYPE, cmsg->cmsg_type);
+        EXPECT_EQ(SSL3_RT_ALERT, *CMSG_DATA(cmsg));
+        EXPECT_EQ(1, message->msg_iovlen);
+        EXPECT_EQ(2, message->msg_iov[0].iov_len);
+        const uint8_t* alert = static_cast<const uint8_t*>(message->msg_iov[0].iov_base);
+        EXPECT_EQ(SSL3_AL_WARNING, alert[0]);
+        EXPECT_EQ(SSL_AD_CLOSE_NOTIFY, alert[1]);
+        return {2, 0};
+      }));
+  EXPECT_TRUE(KernelTls::sendCloseNotify(ServerFd));
+}
+
+// Fills a message with a record as received from a socket whose RX is offloaded.
+Api::SysCallSizeResult receiveRecord(msghdr* message, uint8_t type, uint8_t level,
+                                     uint8_t description) {
+  cmsghdr* cmsg = CMSG_FIRSTHDR(message);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_GET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = type;
+  uint8_t* record = static_cast<uint8_t*>(message->msg_iov[0].iov_base);
+  record[0] = level;
+  record[1] = description;
+  return {2, 0};
+}
+
+TEST_F(KernelTlsTest, ReadCloseNotify) {
+  EXPECT_CALL(os_sys_calls_, recvmsg(ServerFd, _, 0))
+      .WillOnce(Invoke([](int, msghdr* message, int) -> Api::SysCallSizeResult {
+        return receiveRecord(message, SSL3_RT_ALERT, SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY);
+      }))
+      .WillOnce(Invoke([](int, msghdr* message, int) -> Api::SysCallSizeResult {
+        return receiveRecord(message, SSL3_RT_ALERT, SSL3_AL_FATAL, SSL_AD_BAD_RECORD_MAC);
+      }))
+      .WillOnce(Invoke([](int, msghdr* message, int) -> Api::SysCallSizeResult {
+        return receiveRecord(message, SSL3_RT_HANDSHAKE, 0, 0);
+      }))
+      .WillOnce(Return(Api::SysCallSizeResult{-1, ECONNRESET}));
+  EXPECT_TRUE(KernelTls::readCloseNotify(ServerFd));
+  EXPECT_FALSE(KernelTls::readCloseNotify(ServerFd));
+  EXPECT_FALSE(KernelTls::readCloseNotify(ServerFd));
+  EXPECT_FALSE(KernelTls::readCloseNotify(ServerFd));
+}
+
+#else
+
+// Without kernel headers supporting TLS, connections are always left to BoringSSL.
+TEST_F(KernelTlsTest, Unsupported) {
+  EXPECT_FALSE(KernelTls::supported());
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  EXPECT_CALL(os_sys_calls_, setsockopt(_, _, _, _, _)).Times(0);
+  const KernelTls::Offload offload = KernelTls::enable(server_.get(), ServerFd);
+  EXPECT_FALSE(offload.tx_);
+  EXPECT_FALSE(offload.rx_);
+  EXPECT_FALSE(KernelTls::sendCloseNotify(ServerFd));
+}
+
+#endif
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,205 @@
+#include <string>
+#include <vector>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/transport_sockets/tls/private_key/thread_pool_provider.h"
+#include "extensions/transport_sockets/well_known_names.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+#include "openssl/ssl.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+class MockPrivateKeyConnectionCallbacks : public Ssl::PrivateKeyConnectionCallbacks {
+public:
+  MOCK_METHOD0(onPrivateKeyMethodComplete, void());
+};
+
+class ThreadPoolPrivateKeyProviderTest : public testing::Test {
+public:
+  ThreadPoolPrivateKeyProviderTest()
+      : api_(Api::createApiForTest(store_)), dispatcher_(api_->allocateDispatcher()),
+        ssl_ctx_(SSL_CTX_new(TLS_method())), ssl_(SSL_new(ssl_ctx_.get())) {
+    ON_CALL(factory_context_, api()).WillByDefault(ReturnRef(*api_));
+    ON_CALL(factory_context_, statsScope()).WillByDefault(ReturnRef(store_));
+  }
+
+  void createProvider(const std::string& key_file, uint32_t max_queued_operations = 1024) {
+    envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool config;
+    config.mutable_private_key()->set_filename(TestEnvironment::runfilesPath(
+        "test/extensions/transport_sockets/tls/test_data/" + key_file));
+    config.mutable_num_threads()->set_value(2);
+    config.mutable_max_queued_operations()->set_value(max_queued_operations);
+    provider_ = std::make_unique<ThreadPoolPrivateKeyMethodProvider>(config, factory_context_);
+    provider_->registerPrivateKeyMethod(ssl_.get(), callbacks_, *dispatcher_);
+  }
+
+  // Signs "hello" and returns the result of the operation, waiting for the thread pool if the
+  // operation is offloaded.
+  ssl_private_key_result_t sign(uint16_t signature_algorithm, std::vector<uint8_t>& signature) {
+    Ssl::BoringSslPrivateKeyMethodSharedPtr method = provider_->getBoringSslPrivateKeyMethod();
+    signature.resize(1024);
+    size_t signature_len;
+    ssl_private_key_result_t result =
+        method->sign(ssl_.get(), signature.data(), &signature_len, signature.size(),
+                     signature_algorithm, input_.data(), input_.size());
+    if (result == ssl_private_key_retry) {
+      EXPECT_EQ(ssl_private_key_retry,
+                method->complete(ssl_.get(), signature.data(), &signature_len, signature.size()));
+      EXPECT_CALL(callbacks_, onPrivateKeyMethodComplete()).WillOnce(Invoke([this]() -> void {
+        dispatcher_->exit();
+      }));
+      dispatcher_->run(Event::Dispatcher::RunType::Block);
+      result = method->complete(ssl_.get(), signature.data(), &signature_len, signature.size());
+    }
+    signature.resize(result == ssl_private_key_success ? signature_len : 0);
+    return result;
+  }
+
+  bool verify(const std::string& key_file, uint16_t signature_algorithm,
+              const std::vector<uint8_t>& signature) {
+    const std::string key = TestEnvironment::readFileToStringForTest(TestEnvironment::runfilesPath(
+        "test/extensions/transport_sockets/tls/test_data/" + key_file));
+    bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(key.data(), key.size()));
+    bssl::UniquePtr<EVP_PKEY> pkey(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+    bssl::ScopedEVP_MD_CTX ctx;
+    EVP_PKEY_CTX* pctx;
+    if (!EVP_DigestVerifyInit(ctx.get(), &pctx,
+                              SSL_get_signature_algorithm_digest(signature_algorithm), nullptr,
+                              pkey.get())) {
+      return false;
+    }
+    if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm) &&
+        (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) ||
+         !EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))) {
+      return false;
+    }
+    return EVP_DigestVerify(ctx.get(), signature.data(), signature.size(), input_.data(),
+                            input_.size()) == 1;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("private_key_provider.thread_pool." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context_;
+  bssl::UniquePtr<SSL_CTX> ssl_ctx_;
+  bssl::UniquePtr<SSL> ssl_;
+  MockPrivateKeyConnectionCallbacks callbacks_;
+  std::unique_ptr<ThreadPoolPrivateKeyMethodProvider> provider_;
+  const std::vector<uint8_t> input_{'h', 'e', 'l', 'l', 'o'};
+};
+
+TEST_F(ThreadPoolPrivateKeyProviderTest, RsaSign) {
+  createProvider("selfsigned_key.pem");
+  std::vector<uint8_t> signature;
+  EXPECT_EQ(ssl_private_key_success, sign(SSL_SIGN_RSA_PSS_RSAE_SHA256, signature));
+  EXPECT_TRUE(verify("selfsigned_key.pem", SSL_SIGN_RSA_PSS_RSAE_SHA256, signature));
+  EXPECT_EQ(ssl_private_key_success, sign(SSL_SIGN_RSA_PKCS1_SHA384, signature));
+  EXPECT_TRUE(verify("selfsigned_key.pem", SSL_SIGN_RSA_PKCS1_SHA384, signature));
+  EXPECT_EQ(2, counter("offloaded"));
+  EXPECT_EQ(0, counter("queue_overflow"));
+  EXPECT_EQ(0, counter("failed"));
+  EXPECT_EQ(0, store_.gauge("private_key_provider.thread_pool.queue_depth",
+                            Stats::Gauge::ImportMode::NeverImport)
+                   .value());
+  provider_->unregisterPrivateKeyMethod(ssl_.get());
+}
+
+TEST_F(ThreadPoolPrivateKeyProviderTest, EcdsaSign) {
+  createProvider("selfsigned_ecdsa_p256_key.pem");
+  std::vector<uint8_t> signature;
+  EXPECT_EQ(ssl_private_key_success, sign(SSL_SIGN_ECDSA_SECP256R1_SHA256, signature));
+  EXPECT_TRUE(verify("selfsigned_ecdsa_p256_key.pem", SSL_SIGN_ECDSA_SECP256R1_SHA256, signature));
+  EXPECT_EQ(1, counter("offloaded"));
+  provider_->unregisterPrivateKeyMethod(ssl_.get());
+}
+
+// An algorithm which doesn't match the key fails once the operation completes.
+TEST_F(ThreadPoolPrivateKeyProviderTest, SignAlgorithmMismatch) {
+  createProvider("selfsigned_ecdsa_p256_key.pem");
+  std::vector<uint8_t> signature;
+  EXPECT_EQ(ssl_private_key_failure, sign(SSL_SIGN_RSA_PSS_RSAE_SHA256, signature));
+  EXPECT_EQ(1, counter("failed"));
+  provider_->unregisterPrivateKeyMethod(ssl_.get());
+}
+
+// Operations are performed synchronously once the queue is full.
+TEST_F(ThreadPoolPrivateKeyProviderTest, QueueOverflow) {
+  createProvider("selfsigned_key.pem", 0);
+  std::vector<uint8_t> signature;
+  EXPECT_CALL(callbacks_, onPrivateKeyMethodComplete()).Times(0);
+  EXPECT_EQ(ssl_private_key_success, sign(SSL_SIGN_RSA_PSS_RSAE_SHA256, signature));
+  EXPECT_TRUE(verify("selfsigned_key.pem", SSL_SIGN_RSA_PSS_RSAE_SHA256, signature));
+  EXPECT_EQ(0, counter("offloaded"));
+  EXPECT_EQ(1, counter("queue_overflow"));
+  provider_->unregisterPrivateKeyMethod(ssl_.get());
+}
+
+// The connection going away while its operation is in flight doesn't call back into it.
+TEST_F(ThreadPoolPrivateKeyProviderTest, UnregisterWhileInFlight) {
+  createProvider("selfsigned_key.pem");
+  Ssl::BoringSslPrivateKeyMethodSharedPtr method = provider_->getBoringSslPrivateKeyMethod();
+  std::vector<uint8_t> signature(1024);
+  size_t signature_len;
+  EXPECT_EQ(ssl_private_key_retry,
+            method->sign(ssl_.get(), signature.data(), &signature_len, signature.size(),
+                         SSL_SIGN_RSA_PSS_RSAE_SHA256, input_.data(), input_.size()));
+  provider_->unregisterPrivateKeyMethod(ssl_.get());
+  // Destroying the provider waits for the pool threads.
+  provider_.reset();
+
+  EXPECT_CALL(callbacks_, onPrivateKeyMethodComplete()).Times(0);
+  dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+}
+
+TEST_F(ThreadPoolPrivateKeyProviderTest, InvalidKey) {
+  EXPECT_THROW_WITH_MESSAGE(createProvider("ca_cert.pem"), EnvoyException,
+                            "Failed to load private key for the thread pool private key provider");
+}
+
+TEST_F(ThreadPoolPrivateKeyProviderTest, Factory) {
+  const std::string yaml = R"EOF(
+  provider_name: envoy.tls.private_key_providers.thread_pool
+  typed_config:
+    "@type": type.googleapis.com/envoy.config.private_key_provider.thread_pool.v2alpha.ThreadPool
+    private_key:
+      filename: "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/selfsigned_key.pem"
+    num_threads: 1
+)EOF";
+  envoy::api::v2::auth::PrivateKeyProvider config;
+  TestUtility::loadFromYaml(TestEnvironment::substitute(yaml), config);
+
+  auto* factory =
+      Registry::FactoryRegistry<Ssl::PrivateKeyMethodProviderInstanceFactory>::getFactory(
+          PrivateKeyMethodProviderNames::get().ThreadPool);
+  ASSERT_NE(nullptr, factory);
+  Ssl::PrivateKeyMethodProviderSharedPtr provider =
+      factory->createPrivateKeyMethodProviderInstance(config, factory_context_);
+  EXPECT_NE(nullptr, provider->getBoringSslPrivateKeyMethod());
+}
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
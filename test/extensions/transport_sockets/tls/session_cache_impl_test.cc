@@ -0,0 +1,106 @@
+#include <string>
+
+#include "extensions/transport_sockets/tls/session_cache_impl.h"
+
+#include "gtest/gtest.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+class SessionCacheImplTest : public testing::Test {
+public:
+  SessionCacheImplTest() : ssl_ctx_(SSL_CTX_new(TLS_method())) {}
+
+  bssl::UniquePtr<SSL_SESSION> newSession(uint16_t version = TLS1_2_VERSION) {
+    bssl::UniquePtr<SSL_SESSION> session(SSL_SESSION_new(ssl_ctx_.get()));
+    EXPECT_EQ(1, SSL_SESSION_set_protocol_version(session.get(), version));
+    return session;
+  }
+
+  bssl::UniquePtr<SSL_CTX> ssl_ctx_;
+};
+
+TEST_F(SessionCacheImplTest, Miss) {
+  SessionCacheImpl cache;
+  EXPECT_EQ(nullptr, cache.lookup("foo"));
+  EXPECT_EQ(0, cache.size());
+}
+
+// Multi-use sessions stay in the cache, and the most recently stored session is returned.
+TEST_F(SessionCacheImplTest, MultiUse) {
+  SessionCacheImpl cache;
+  bssl::UniquePtr<SSL_SESSION> session1 = newSession();
+  bssl::UniquePtr<SSL_SESSION> session2 = newSession();
+  SSL_SESSION* raw_session2 = session2.get();
+  cache.insert("foo", std::move(session1), 2);
+  cache.insert("foo", std::move(session2), 2);
+  EXPECT_EQ(2, cache.size());
+
+  EXPECT_EQ(raw_session2, cache.lookup("foo").get());
+  EXPECT_EQ(raw_session2, cache.lookup("foo").get());
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(nullptr, cache.lookup("bar"));
+}
+
+// Single-use sessions (TLS 1.3) are removed when looked up.
+TEST_F(SessionCacheImplTest, SingleUse) {
+  SessionCacheImpl cache;
+  bssl::UniquePtr<SSL_SESSION> session1 = newSession(TLS1_3_VERSION);
+  bssl::UniquePtr<SSL_SESSION> session2 = newSession(TLS1_3_VERSION);
+  SSL_SESSION* raw_session1 = session1.get();
+  SSL_SESSION* raw_session2 = session2.get();
+  cache.insert("foo", std::move(session1), 2);
+  cache.insert("foo", std::move(session2), 2);
+
+  EXPECT_EQ(raw_session2, cache.lookup("foo").get());
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(raw_session1, cache.lookup("foo").get());
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.lookup("foo"));
+}
+
+// The oldest sessions of a key are evicted once max_sessions_per_key is reached.
+TEST_F(SessionCacheImplTest, MaxSessionsPerKey) {
+  SessionCacheImpl cache;
+  bssl::UniquePtr<SSL_SESSION> session1 = newSession(TLS1_3_VERSION);
+  bssl::UniquePtr<SSL_SESSION> session2 = newSession(TLS1_3_VERSION);
+  bssl::UniquePtr<SSL_SESSION> session3 = newSession(TLS1_3_VERSION);
+  SSL_SESSION* raw_session2 = session2.get();
+  SSL_SESSION* raw_session3 = session3.get();
+  cache.insert("foo", std::move(session1), 2);
+  cache.insert("foo", std::move(session2), 2);
+  cache.insert("foo", std::move(session3), 2);
+  EXPECT_EQ(2, cache.size());
+
+  EXPECT_EQ(raw_session3, cache.lookup("foo").get());
+  EXPECT_EQ(raw_session2, cache.lookup("foo").get());
+  EXPECT_EQ(nullptr, cache.lookup("foo"));
+
+  cache.insert("foo", newSession(), 0);
+  EXPECT_EQ(0, cache.size());
+}
+
+// The least recently inserted key is evicted once a shard is full.
+TEST_F(SessionCacheImplTest, MaxKeysPerShard) {
+  SessionCacheImpl cache(1, 2);
+  cache.insert("foo", newSession(), 2);
+  cache.insert("bar", newSession(), 2);
+  cache.insert("foo", newSession(), 2);
+  EXPECT_EQ(3, cache.size());
+
+  cache.insert("baz", newSession(), 2);
+  EXPECT_EQ(3, cache.size());
+  EXPECT_NE(nullptr, cache.lookup("foo"));
+  EXPECT_EQ(nullptr, cache.lookup("bar"));
+  EXPECT_NE(nullptr, cache.lookup("baz"));
+}
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -748,7 +748,9 @@ protected:
 
   void testClientSessionResumption(const std::string& server_ctx_yaml,
                                    const std::string& client_ctx_yaml, bool expect_reuse,
-                                   const Network::Address::IpVersion version);
+                                   const Network::Address::IpVersion version,
+                                   bool new_client_context = false);
+  void testHalfClose(const std::string& server_ctx_yaml, const std::string& client_ctx_yaml);
 
   Event::DispatcherPtr dispatcher_;
 };
@@ -2195,20 +2197,8 @@ TEST_P(SslSocketTest, FlushCloseDuringHandshake) {
   dispatcher_->run(Event::Dispatcher::RunType::Block);
 }
 
-// Test that half-close is sent and received correctly
-TEST_P(SslSocketTest, HalfClose) {
-  const std::string server_ctx_yaml = R"EOF(
-  common_tls_context:
-    tls_certificates:
-      certificate_chain:
-        filename: "{{ test_tmpdir }}/unittestcert.pem"
-      private_key:
-        filename: "{{ test_tmpdir }}/unittestkey.pem"
-    validation_context:
-      trusted_ca:
-        filename: "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/ca_certificates.pem"
-)EOF";
-
+void SslSocketTest::testHalfClose(const std::string& server_ctx_yaml,
+                                  const std::string& client_ctx_yaml) {
   envoy::api::v2::auth::DownstreamTlsContext server_tls_context;
   TestUtility::loadFromYaml(TestEnvironment::substitute(server_ctx_yaml), server_tls_context);
   auto server_cfg = std::make_unique<ServerContextConfigImpl>(server_tls_context, factory_context_);
@@ -2225,10 +2215,6 @@ TEST_P(SslSocketTest, HalfClose) {
   std::shared_ptr<Network::MockReadFilter> server_read_filter(new Network::MockReadFilter());
   std::shared_ptr<Network::MockReadFilter> client_read_filter(new Network::MockReadFilter());
 
-  const std::string client_ctx_yaml = R"EOF(
-    common_tls_context:
-  )EOF";
-
   envoy::api::v2::auth::UpstreamTlsContext tls_context;
   TestUtility::loadFromYaml(TestEnvironment::substitute(client_ctx_yaml), tls_context);
   auto client_cfg = std::make_unique<ClientContextConfigImpl>(tls_context, factory_context_);
@@ -2277,6 +2263,52 @@ TEST_P(SslSocketTest, HalfClose) {
   dispatcher_->run(Event::Dispatcher::RunType::Block);
 }
 
+// Test that half-close is sent and received correctly
+TEST_P(SslSocketTest, HalfClose) {
+  const std::string server_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_tmpdir }}/unittestcert.pem"
+      private_key:
+        filename: "{{ test_tmpdir }}/unittestkey.pem"
+    validation_context:
+      trusted_ca:
+        filename: "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/ca_certificates.pem"
+)EOF";
+
+  const std::string client_ctx_yaml = R"EOF(
+    common_tls_context:
+  )EOF";
+
+  testHalfClose(server_ctx_yaml, client_ctx_yaml);
+}
+
+// Connections fall back to BoringSSL if the kernel doesn't support TLS offload, so the half-close
+// works in either case.
+TEST_P(SslSocketTest, HalfCloseKernelTlsOffload) {
+  const std::string server_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_tmpdir }}/unittestcert.pem"
+      private_key:
+        filename: "{{ test_tmpdir }}/unittestkey.pem"
+    kernel_tls_offload: true
+)EOF";
+
+  const std::string client_ctx_yaml = R"EOF(
+    common_tls_context:
+      tls_params:
+        tls_maximum_protocol_version: TLSv1_2
+        cipher_suites:
+        - ECDHE-RSA-AES128-GCM-SHA256
+      kernel_tls_offload: true
+  )EOF";
+
+  testHalfClose(server_ctx_yaml, client_ctx_yaml);
+}
+
 TEST_P(SslSocketTest, ClientAuthMultipleCAs) {
   const std::string server_ctx_yaml = R"EOF(
   common_tls_context:
@@ -2906,7 +2938,8 @@ TEST_P(SslSocketTest, ClientAuthCrossListenerSessionResumption) {
 void SslSocketTest::testClientSessionResumption(const std::string& server_ctx_yaml,
                                                 const std::string& client_ctx_yaml,
                                                 bool expect_reuse,
-                                                const Network::Address::IpVersion version) {
+                                                const Network::Address::IpVersion version,
+                                                bool new_client_context) {
   InSequence s;
 
   ContextManagerImpl manager(time_system_);
@@ -3005,13 +3038,29 @@ void SslSocketTest::testClientSessionResumption(const std::string& server_ctx_ya
 
   EXPECT_EQ(0UL, server_stats_store.counter("ssl.session_reused").value());
   EXPECT_EQ(0UL, client_stats_store.counter("ssl.session_reused").value());
+  EXPECT_EQ(0UL, client_stats_store.counter("ssl.session_cache_hit").value());
+  const bool session_cache_enabled =
+      !client_ctx_proto.has_max_session_keys() || client_ctx_proto.max_session_keys().value() > 0;
+  EXPECT_EQ(session_cache_enabled ? 1UL : 0UL,
+            client_stats_store.counter("ssl.session_cache_miss").value());
 
   connect_count = 0;
   close_count = 0;
 
+  // Connecting via a new context with the same configuration (e.g. after an SDS update of an
+  // unrelated secret) resumes sessions established via the previous context.
+  std::unique_ptr<ClientSslSocketFactory> second_client_ssl_socket_factory;
+  if (new_client_context) {
+    auto second_client_cfg =
+        std::make_unique<ClientContextConfigImpl>(client_ctx_proto, client_factory_context);
+    second_client_ssl_socket_factory = std::make_unique<ClientSslSocketFactory>(
+        std::move(second_client_cfg), manager, client_stats_store);
+  }
   client_connection = dispatcher->createClientConnection(
       socket.localAddress(), Network::Address::InstanceConstSharedPtr(),
-      client_ssl_socket_factory.createTransportSocket(nullptr), nullptr);
+      new_client_context ? second_client_ssl_socket_factory->createTransportSocket(nullptr)
+                         : client_ssl_socket_factory.createTransportSocket(nullptr),
+      nullptr);
   client_connection->addConnectionCallbacks(client_connection_callbacks);
   client_connection->connect();
 
@@ -3045,6 +3094,7 @@ void SslSocketTest::testClientSessionResumption(const std::string& server_ctx_ya
 
   EXPECT_EQ(expect_reuse ? 1UL : 0UL, server_stats_store.counter("ssl.session_reused").value());
   EXPECT_EQ(expect_reuse ? 1UL : 0UL, client_stats_store.counter("ssl.session_reused").value());
+  EXPECT_EQ(expect_reuse ? 1UL : 0UL, client_stats_store.counter("ssl.session_cache_hit").value());
 }
 
 // Test client session resumption using default settings (should be enabled).
@@ -3162,6 +3212,54 @@ TEST_P(SslSocketTest, ClientSessionResumptionEnabledTls13) {
   testClientSessionResumption(server_ctx_yaml, client_ctx_yaml, true, GetParam());
 }
 
+// Test that sessions are resumed across client contexts with the same configuration.
+TEST_P(SslSocketTest, ClientSessionResumptionNewContextTls12) {
+  const std::string server_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_tmpdir }}/unittestcert.pem"
+      private_key:
+        filename: "{{ test_tmpdir }}/unittestkey.pem"
+)EOF";
+
+  const std::string client_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_params:
+      tls_minimum_protocol_version: TLSv1_0
+      tls_maximum_protocol_version: TLSv1_2
+  max_session_keys: 2
+)EOF";
+
+  testClientSessionResumption(server_ctx_yaml, client_ctx_yaml, true, GetParam(), true);
+}
+
+// Test that single-use TLS 1.3 sessions are resumed across client contexts with the same
+// configuration.
+TEST_P(SslSocketTest, ClientSessionResumptionNewContextTls13) {
+  const std::string server_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_params:
+      tls_minimum_protocol_version: TLSv1_3
+      tls_maximum_protocol_version: TLSv1_3
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_tmpdir }}/unittestcert.pem"
+      private_key:
+        filename: "{{ test_tmpdir }}/unittestkey.pem"
+)EOF";
+
+  const std::string client_ctx_yaml = R"EOF(
+  common_tls_context:
+    tls_params:
+      tls_minimum_protocol_version: TLSv1_3
+      tls_maximum_protocol_version: TLSv1_3
+  max_session_keys: 2
+)EOF";
+
+  testClientSessionResumption(server_ctx_yaml, client_ctx_yaml, true, GetParam(), true);
+}
+
 TEST_P(SslSocketTest, SslError) {
   const std::string server_ctx_yaml = R"EOF(
   common_tls_context:
@@ -90,6 +90,8 @@ MockRouteEntry::MockRouteEntry() {
   ON_CALL(*this, metadata()).WillByDefault(ReturnRef(metadata_));
   ON_CALL(*this, upgradeMap()).WillByDefault(ReturnRef(upgrade_map_));
   ON_CALL(*this, hedgePolicy()).WillByDefault(ReturnRef(hedge_policy_));
+  ON_CALL(*this, collapsedForwardingPolicy())
+      .WillByDefault(ReturnRef(collapsed_forwarding_policy_));
   ON_CALL(*this, routeName()).WillByDefault(ReturnRef(route_name_));
 }
 
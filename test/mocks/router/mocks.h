@@ -89,6 +89,18 @@ public:
   bool hedge_on_per_try_timeout_{};
 };
 
+class TestCollapsedForwardingPolicy : public CollapsedForwardingPolicy {
+public:
+  // Router::CollapsedForwardingPolicy
+  bool enabled() const override { return enabled_; }
+  const std::vector<Http::LowerCaseString>& keyHeaders() const override { return key_headers_; }
+  uint64_t maxBufferedBytes() const override { return max_buffered_bytes_; }
+
+  bool enabled_{};
+  std::vector<Http::LowerCaseString> key_headers_;
+  uint64_t max_buffered_bytes_{1024 * 1024};
+};
+
 class TestRetryPolicy : public RetryPolicy {
 public:
   // Router::RetryPolicy
@@ -303,6 +315,7 @@ public:
                      void(Http::HeaderMap& headers, const StreamInfo::StreamInfo& stream_info));
   MOCK_CONST_METHOD0(hashPolicy, const Http::HashPolicy*());
   MOCK_CONST_METHOD0(hedgePolicy, const HedgePolicy&());
+  MOCK_CONST_METHOD0(collapsedForwardingPolicy, const CollapsedForwardingPolicy&());
   MOCK_CONST_METHOD0(metadataMatchCriteria, const Router::MetadataMatchCriteria*());
   MOCK_CONST_METHOD0(tlsContextMatchCriteria, const Router::TlsContextMatchCriteria*());
   MOCK_CONST_METHOD0(priority, Upstream::ResourcePriority());
@@ -335,6 +348,7 @@ public:
   TestVirtualCluster virtual_cluster_;
   TestRetryPolicy retry_policy_;
   TestHedgePolicy hedge_policy_;
+  TestCollapsedForwardingPolicy collapsed_forwarding_policy_;
   testing::NiceMock<MockRateLimitPolicy> rate_limit_policy_;
   TestShadowPolicy shadow_policy_;
   testing::NiceMock<MockVirtualHost> virtual_host_;
@@ -0,0 +1,74 @@
+/**
+ * Utility to convert a list of IP tags to the binary format of the ip_tags_path option of the
+ * HTTP IP tagging filter.
+ *
+ * Usage:
+ *
+ * ip_tags2bin <input path> <output path>
+ *
+ * Each line of the input is a tag name and a CIDR range separated by whitespace, e.g.
+ * "AS15169 8.8.8.0/24". Empty lines and lines starting with '#' are ignored. The output should be
+ * written next to the configured path and then moved into place, so that Envoy swaps it in whole.
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "envoy/common/exception.h"
+
+#include "common/network/cidr_range.h"
+
+#include "extensions/filters/http/ip_tagging/ip_tag_file.h"
+
+// NOLINT(namespace-envoy)
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <input path> <output path>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream input(argv[1]);
+  if (!input) {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>> tag_data;
+  std::unordered_map<std::string, size_t> tag_indexes;
+  std::string line;
+  for (uint64_t line_number = 1; std::getline(input, line); line_number++) {
+    std::istringstream fields(line);
+    std::string tag;
+    std::string range;
+    if (!(fields >> tag) || tag[0] == '#') {
+      continue;
+    }
+    Envoy::Network::Address::CidrRange cidr_range;
+    try {
+      if (fields >> range) {
+        cidr_range = Envoy::Network::Address::CidrRange::create(range);
+      }
+    } catch (const Envoy::EnvoyException&) {
+    }
+    if (!cidr_range.isValid()) {
+      std::cerr << argv[1] << ":" << line_number << ": invalid CIDR range" << std::endl;
+      return EXIT_FAILURE;
+    }
+    auto index = tag_indexes.emplace(tag, tag_data.size());
+    if (index.second) {
+      tag_data.emplace_back(tag, std::vector<Envoy::Network::Address::CidrRange>());
+    }
+    tag_data[index.first->second].second.push_back(cidr_range);
+  }
+
+  const std::string contents =
+      Envoy::Extensions::HttpFilters::IpTagging::IpTagFile::build(tag_data);
+  std::ofstream output(argv[2], std::ios::binary);
+  output.write(contents.data(), contents.size());
+  if (!output.flush()) {
+    std::cerr << "Cannot write " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}